@@ -0,0 +1,232 @@
+/*-------------------------------------------------------------------------
+ *
+ * columnar.h
+ *	  Header for columnar table access method.
+ *
+ * Copyright (c) 2024, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  contrib/columnar/columnar.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef _COLUMNAR_H_
+#define _COLUMNAR_H_
+
+#include "access/htup_details.h"
+#include "access/relscan.h"
+#include "access/skey.h"
+#include "access/tableam.h"
+#include "nodes/bitmapset.h"
+#include "storage/block.h"
+#include "storage/bufmgr.h"
+#include "utils/rel.h"
+
+/*
+ * A columnar table is a stream of bytes laid over the data area of its
+ * pages, starting at block 1.  Block 0 is the metapage, which records where
+ * the stream ends.  The stream is a sequence of stripes, each holding the
+ * rows written by one flush of a backend's insert buffer:
+ *
+ *	  ColumnarStripeHeader
+ *	  chunk data, for each chunk group for each column
+ *	  chunk directory: ColumnarChunkDesc[nchunks * natts]
+ *	  min/max values referenced by the chunk directory
+ *
+ * Each stripe is padded to a MAXALIGN'd length, so that a stripe's xmin
+ * never straddles a page boundary and VACUUM can update it in place.
+ *
+ * Stripes are only ever appended, so the pages never move and a crash that
+ * interrupts an append leaves bytes past the metapage's end of stream, which
+ * the next append overwrites.
+ */
+#define COLUMNAR_METAPAGE_BLKNO		0
+#define COLUMNAR_MAGIC				0x436F6C6D
+#define COLUMNAR_VERSION			1
+#define COLUMNAR_STRIPE_MAGIC		0x53747270
+
+/* Number of stream bytes stored on each data page */
+#define COLUMNAR_BYTES_PER_PAGE		(BLCKSZ - SizeOfPageHeaderData)
+
+/*
+ * Rows are numbered sequentially, and a row number maps to a TID with this
+ * many offsets per block.  The value keeps the TIDs valid for tidbitmaps and
+ * other code that assumes heap-like offsets.
+ */
+#define COLUMNAR_ROWS_PER_BLOCK		MaxHeapTuplesPerPage
+#define COLUMNAR_MAX_ROW_NUMBER \
+	((uint64) MaxBlockNumber * COLUMNAR_ROWS_PER_BLOCK)
+
+/* Largest serialized value kept as chunk min/max */
+#define COLUMNAR_MAX_MINMAX_SIZE	256
+
+/* Compression methods for chunk data */
+#define COLUMNAR_COMPRESSION_NONE	0
+#define COLUMNAR_COMPRESSION_PGLZ	1
+
+/* Contents of the metapage */
+typedef struct ColumnarMetaPageData
+{
+	uint32		magic;			/* COLUMNAR_MAGIC */
+	uint32		version;		/* COLUMNAR_VERSION */
+	uint64		data_end;		/* logical end of the stripe stream */
+	uint64		next_row_number;	/* first row number not yet reserved */
+	uint64		row_count;		/* rows in all stripes, dead or alive */
+} ColumnarMetaPageData;
+
+#define ColumnarPageGetMeta(page) \
+	((ColumnarMetaPageData *) PageGetContents(page))
+
+typedef struct ColumnarStripeHeader
+{
+	uint32		magic;			/* COLUMNAR_STRIPE_MAGIC */
+	TransactionId xmin;			/* inserting transaction, frozen or invalid */
+	CommandId	cmin;			/* inserting command */
+	uint32		natts;			/* number of columns stored */
+	uint32		nchunks;		/* number of chunk groups */
+	uint32		chunk_rows;		/* rows per chunk group but the last one */
+	uint64		first_row;		/* row number of the first row */
+	uint64		nrows;			/* number of rows */
+	uint64		length;			/* length of the whole stripe */
+	uint64		meta_offset;	/* start of the chunk directory */
+} ColumnarStripeHeader;
+
+#define SizeOfColumnarStripeHeader	MAXALIGN(sizeof(ColumnarStripeHeader))
+
+/* Describes the values of one column in one chunk group */
+typedef struct ColumnarChunkDesc
+{
+	uint64		offset;			/* start of the chunk data in the stripe */
+	uint32		length;			/* stored length of the chunk data */
+	uint32		raw_length;		/* length before compression */
+	uint32		minmax_offset;	/* start of min/max past the directory */
+	uint16		min_length;		/* length of min, 0 if there is none */
+	uint16		max_length;		/* length of max */
+	uint8		compression;	/* COLUMNAR_COMPRESSION_xxx */
+	bool		has_nulls;		/* chunk data starts with a null bitmap */
+} ColumnarChunkDesc;
+
+/* A stripe, as listed by a scan */
+typedef struct ColumnarStripe
+{
+	uint64		offset;			/* start of the stripe in the stream */
+	ColumnarStripeHeader hdr;
+} ColumnarStripe;
+
+/* Chunk directory of a stripe, with the min/max values following it */
+typedef struct ColumnarStripeMeta
+{
+	ColumnarChunkDesc *chunks;	/* [chunk group * natts + column] */
+	char	   *minmax;
+} ColumnarStripeMeta;
+
+/* Decoded values of one chunk group */
+typedef struct ColumnarChunkGroup
+{
+	int			nrows;
+	Datum	  **values;			/* per column, NULL if not decoded */
+	bool	  **nulls;
+} ColumnarChunkGroup;
+
+/* columnar_storage.c */
+extern void columnar_storage_read_meta(Relation rel,
+									   ColumnarMetaPageData *meta);
+extern void columnar_storage_read(Relation rel, uint64 offset, char *data,
+								  Size len, BufferAccessStrategy strategy);
+extern void columnar_storage_write(Relation rel, uint64 offset,
+								   const char *data, Size len);
+extern uint64 columnar_storage_begin_append(Relation rel);
+extern void columnar_storage_end_append(Relation rel, uint64 data_end,
+										uint64 nrows);
+extern uint64 columnar_storage_reserve_rows(Relation rel, uint64 nrows);
+extern bool columnar_storage_resize_rows(Relation rel, uint64 end,
+										 uint64 new_end);
+
+/* columnar_writer.c */
+extern PGDLLIMPORT int columnar_stripe_row_limit;
+extern PGDLLIMPORT int columnar_chunk_group_row_limit;
+extern PGDLLIMPORT int columnar_compression;
+
+extern void columnar_insert_row(Relation rel, TupleTableSlot *slot,
+								CommandId cid);
+extern void columnar_rewrite_row(Relation rel, TupleTableSlot *slot,
+								 TransactionId xid);
+extern void columnar_flush_pending(Relation rel);
+extern void columnar_discard_pending(Relation rel);
+extern void columnar_write_init(void);
+
+/* columnar_reader.c */
+extern bool columnar_stripe_visible(const ColumnarStripeHeader *hdr,
+									Snapshot snapshot);
+extern ColumnarStripe *columnar_read_stripes(Relation rel, Snapshot snapshot,
+											 int *nstripes,
+											 BufferAccessStrategy strategy);
+extern void columnar_read_stripe_meta(Relation rel, ColumnarStripe *stripe,
+									  ColumnarStripeMeta *meta,
+									  BufferAccessStrategy strategy);
+extern void columnar_read_chunk_group(Relation rel, ColumnarStripe *stripe,
+									  ColumnarStripeMeta *meta, int group,
+									  bool *attr_needed,
+									  ColumnarChunkGroup *cg,
+									  BufferAccessStrategy strategy);
+extern void columnar_store_row(Relation rel, ColumnarStripe *stripe,
+							   ColumnarChunkGroup *cg, int row,
+							   uint64 rownum, bool *attr_needed,
+							   TupleTableSlot *slot);
+
+extern TableScanDesc columnar_beginscan(Relation rel, Snapshot snapshot,
+										int nkeys, ScanKey key,
+										ParallelTableScanDesc pscan,
+										uint32 flags);
+extern void columnar_endscan(TableScanDesc sscan);
+extern void columnar_rescan(TableScanDesc sscan, ScanKey key,
+							bool set_params, bool allow_strat,
+							bool allow_sync, bool allow_pagemode);
+extern bool columnar_getnextslot(TableScanDesc sscan,
+								 ScanDirection direction,
+								 TupleTableSlot *slot);
+extern Size columnar_parallelscan_estimate(Relation rel);
+extern Size columnar_parallelscan_initialize(Relation rel,
+											 ParallelTableScanDesc pscan);
+extern void columnar_parallelscan_reinitialize(Relation rel,
+											   ParallelTableScanDesc pscan);
+extern bool columnar_row_visible(Relation rel, uint64 rownum,
+								 Snapshot snapshot);
+extern bool columnar_fetch_row(Relation rel, ItemPointer tid,
+							   Snapshot snapshot, TupleTableSlot *slot);
+extern bool columnar_scan_analyze_next_block(TableScanDesc sscan,
+											 ReadStream *stream);
+extern bool columnar_scan_analyze_next_tuple(TableScanDesc sscan,
+											 TransactionId OldestXmin,
+											 double *liverows,
+											 double *deadrows,
+											 TupleTableSlot *slot);
+extern void columnar_scan_set_projection(TableScanDesc sscan,
+										 Bitmapset *attrs,
+										 int nkeys, ScanKey keys);
+extern uint64 columnar_scan_groups_skipped(TableScanDesc sscan);
+
+/* columnar_tableam.c */
+extern PGDLLIMPORT bool columnar_enable_custom_scan;
+
+extern bool RelationIsColumnar(Relation rel);
+
+/* columnar_customscan.c */
+extern void columnar_customscan_init(void);
+
+/* Conversion between row numbers and TIDs */
+static inline void
+columnar_row_to_tid(uint64 rownum, ItemPointer tid)
+{
+	ItemPointerSet(tid, (BlockNumber) (rownum / COLUMNAR_ROWS_PER_BLOCK),
+				   (OffsetNumber) (rownum % COLUMNAR_ROWS_PER_BLOCK) + 1);
+}
+
+static inline uint64
+columnar_tid_to_row(ItemPointer tid)
+{
+	return (uint64) ItemPointerGetBlockNumber(tid) * COLUMNAR_ROWS_PER_BLOCK +
+		ItemPointerGetOffsetNumber(tid) - 1;
+}
+
+#endif							/* _COLUMNAR_H_ */
@@ -0,0 +1,501 @@
+/*-------------------------------------------------------------------------
+ *
+ * columnar_customscan.c
+ *		Custom scan that reads only the columns a query needs.
+ *
+ * The table AM interface has no way to tell a scan which columns will be
+ * used, so a plain sequential scan of a columnar table has to decode all
+ * of them.  This module replaces the sequential scan paths of columnar
+ * tables with a CustomScan that computes the needed columns at plan time,
+ * along with simple "column op constant" quals usable to skip chunk groups
+ * by their min/max values, and passes them to the scan.
+ *
+ * Copyright (c) 2024, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  contrib/columnar/columnar_customscan.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/nbtree.h"
+#include "access/relation.h"
+#include "access/sysattr.h"
+#include "access/table.h"
+#include "columnar.h"
+#include "commands/explain.h"
+#include "executor/executor.h"
+#include "nodes/extensible.h"
+#include "nodes/makefuncs.h"
+#include "nodes/pathnodes.h"
+#include "optimizer/optimizer.h"
+#include "optimizer/pathnode.h"
+#include "optimizer/paths.h"
+#include "optimizer/restrictinfo.h"
+#include "utils/lsyscache.h"
+#include "utils/typcache.h"
+
+typedef struct ColumnarScanState
+{
+	CustomScanState css;
+
+	Bitmapset  *attrs;			/* columns to read */
+	int			nkeys;			/* keys to skip chunk groups with */
+	ScanKey		keys;
+} ColumnarScanState;
+
+static set_rel_pathlist_hook_type prev_set_rel_pathlist_hook = NULL;
+
+static void columnar_set_rel_pathlist(PlannerInfo *root, RelOptInfo *rel,
+									  Index rti, RangeTblEntry *rte);
+static Path *columnar_create_path(RelOptInfo *rel, Path *seqpath,
+								  List *attrs, List *skipkeys);
+static List *columnar_needed_attrs(RelOptInfo *rel, int natts);
+static List *columnar_skip_keys(RelOptInfo *rel);
+static Plan *columnar_plan_path(PlannerInfo *root, RelOptInfo *rel,
+								CustomPath *best_path, List *tlist,
+								List *clauses, List *custom_plans);
+static Node *columnar_create_scan_state(CustomScan *cscan);
+static void columnar_begin_scan(CustomScanState *node, EState *estate,
+								int eflags);
+static TupleTableSlot *columnar_exec_scan(CustomScanState *node);
+static TupleTableSlot *columnar_scan_next(ScanState *node);
+static bool columnar_scan_recheck(ScanState *node, TupleTableSlot *slot);
+static void columnar_end_scan(CustomScanState *node);
+static void columnar_rescan_scan(CustomScanState *node);
+static void columnar_set_scan_projection(ColumnarScanState *state,
+										 TableScanDesc scandesc);
+static Size columnar_estimate_dsm(CustomScanState *node,
+								  ParallelContext *pcxt);
+static void columnar_initialize_dsm(CustomScanState *node,
+									ParallelContext *pcxt,
+									void *coordinate);
+static void columnar_reinitialize_dsm(CustomScanState *node,
+									  ParallelContext *pcxt,
+									  void *coordinate);
+static void columnar_initialize_worker(CustomScanState *node,
+									   shm_toc *toc,
+									   void *coordinate);
+static void columnar_explain_scan(CustomScanState *node, List *ancestors,
+								  ExplainState *es);
+
+static const CustomPathMethods columnar_path_methods = {
+	.CustomName = "ColumnarScan",
+	.PlanCustomPath = columnar_plan_path,
+};
+
+static const CustomScanMethods columnar_scan_methods = {
+	.CustomName = "ColumnarScan",
+	.CreateCustomScanState = columnar_create_scan_state,
+};
+
+static const CustomExecMethods columnar_exec_methods = {
+	.CustomName = "ColumnarScan",
+	.BeginCustomScan = columnar_begin_scan,
+	.ExecCustomScan = columnar_exec_scan,
+	.EndCustomScan = columnar_end_scan,
+	.ReScanCustomScan = columnar_rescan_scan,
+	.EstimateDSMCustomScan = columnar_estimate_dsm,
+	.InitializeDSMCustomScan = columnar_initialize_dsm,
+	.ReInitializeDSMCustomScan = columnar_reinitialize_dsm,
+	.InitializeWorkerCustomScan = columnar_initialize_worker,
+	.ExplainCustomScan = columnar_explain_scan,
+};
+
+/* ----------------------------------------------------------------
+ *				 planning
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Replace the sequential scan paths of a columnar table with ColumnarScan
+ * paths of the same cost.
+ */
+static void
+columnar_set_rel_pathlist(PlannerInfo *root, RelOptInfo *rel, Index rti,
+						  RangeTblEntry *rte)
+{
+	Relation	relation;
+	bool		is_columnar;
+	int			natts;
+	List	   *attrs;
+	List	   *skipkeys;
+	List	   *paths = NIL;
+
+	if (prev_set_rel_pathlist_hook)
+		prev_set_rel_pathlist_hook(root, rel, rti, rte);
+
+	if (!columnar_enable_custom_scan ||
+		rte->rtekind != RTE_RELATION || rte->inh || rte->tablesample ||
+		rel->reloptkind == RELOPT_UPPER_REL)
+		return;
+
+	/* The table is locked already */
+	relation = table_open(rte->relid, NoLock);
+	is_columnar = RelationIsColumnar(relation);
+	natts = RelationGetDescr(relation)->natts;
+	table_close(relation, NoLock);
+	if (!is_columnar)
+		return;
+
+	attrs = columnar_needed_attrs(rel, natts);
+	skipkeys = columnar_skip_keys(rel);
+
+	foreach_node(Path, path, rel->pathlist)
+	{
+		if (path->pathtype != T_SeqScan)
+			continue;
+		paths = lappend(paths, columnar_create_path(rel, path, attrs,
+													skipkeys));
+		rel->pathlist = foreach_delete_current(rel->pathlist, path);
+	}
+	foreach_node(Path, path, paths)
+		add_path(rel, path);
+
+	paths = NIL;
+	foreach_node(Path, path, rel->partial_pathlist)
+	{
+		if (path->pathtype != T_SeqScan)
+			continue;
+		paths = lappend(paths, columnar_create_path(rel, path, attrs,
+													skipkeys));
+		rel->partial_pathlist = foreach_delete_current(rel->partial_pathlist,
+													   path);
+	}
+	foreach_node(Path, path, paths)
+		add_partial_path(rel, path);
+}
+
+static Path *
+columnar_create_path(RelOptInfo *rel, Path *seqpath, List *attrs,
+					 List *skipkeys)
+{
+	CustomPath *cpath = makeNode(CustomPath);
+
+	cpath->path.pathtype = T_CustomScan;
+	cpath->path.parent = rel;
+	cpath->path.pathtarget = seqpath->pathtarget;
+	cpath->path.param_info = seqpath->param_info;
+	cpath->path.parallel_aware = seqpath->parallel_aware;
+	cpath->path.parallel_safe = seqpath->parallel_safe;
+	cpath->path.parallel_workers = seqpath->parallel_workers;
+	cpath->path.rows = seqpath->rows;
+	cpath->path.startup_cost = seqpath->startup_cost;
+	cpath->path.total_cost = seqpath->total_cost;
+	cpath->path.pathkeys = NIL;
+	cpath->flags = CUSTOMPATH_SUPPORT_PROJECTION;
+	cpath->custom_private = list_make2(attrs, skipkeys);
+	cpath->methods = &columnar_path_methods;
+
+	return &cpath->path;
+}
+
+/*
+ * Collect the numbers of the columns that the query uses, in an integer
+ * list.
+ */
+static List *
+columnar_needed_attrs(RelOptInfo *rel, int natts)
+{
+	Bitmapset  *varattnos = NULL;
+	List	   *attrs = NIL;
+
+	pull_varattnos((Node *) rel->reltarget->exprs, rel->relid, &varattnos);
+	foreach_node(RestrictInfo, rinfo, rel->baserestrictinfo)
+		pull_varattnos((Node *) rinfo->clause, rel->relid, &varattnos);
+	foreach_node(RestrictInfo, rinfo, rel->joininfo)
+		pull_varattnos((Node *) rinfo->clause, rel->relid, &varattnos);
+
+	/* A whole-row reference needs all columns */
+	if (bms_is_member(InvalidAttrNumber - FirstLowInvalidHeapAttributeNumber,
+					  varattnos))
+	{
+		for (int attno = 1; attno <= natts; attno++)
+			attrs = lappend_int(attrs, attno);
+		return attrs;
+	}
+
+	for (int attno = 1; attno <= natts; attno++)
+	{
+		if (bms_is_member(attno - FirstLowInvalidHeapAttributeNumber,
+						  varattnos))
+			attrs = lappend_int(attrs, attno);
+	}
+
+	return attrs;
+}
+
+/*
+ * Find the quals of the form "column op constant", with an operator of the
+ * column type's default btree operator family, that can be used to skip
+ * chunk groups by their min/max values.  Each is represented by a list of
+ * the column number, the strategy number, the comparison function, the
+ * collation and the constant.
+ */
+static List *
+columnar_skip_keys(RelOptInfo *rel)
+{
+	List	   *skipkeys = NIL;
+
+	foreach_node(RestrictInfo, rinfo, rel->baserestrictinfo)
+	{
+		OpExpr	   *op = (OpExpr *) rinfo->clause;
+		Oid			opno;
+		Var		   *var;
+		Const	   *con;
+		TypeCacheEntry *typentry;
+		int			strategy;
+		Oid			lefttype;
+		Oid			righttype;
+		Oid			cmpproc;
+
+		if (!IsA(op, OpExpr) || list_length(op->args) != 2)
+			continue;
+
+		opno = op->opno;
+		if (IsA(linitial(op->args), Var) && IsA(lsecond(op->args), Const))
+		{
+			var = linitial_node(Var, op->args);
+			con = lsecond_node(Const, op->args);
+		}
+		else if (IsA(linitial(op->args), Const) &&
+				 IsA(lsecond(op->args), Var))
+		{
+			var = lsecond_node(Var, op->args);
+			con = linitial_node(Const, op->args);
+			opno = get_commutator(opno);
+			if (!OidIsValid(opno))
+				continue;
+		}
+		else
+			continue;
+
+		if (var->varno != rel->relid || var->varlevelsup != 0 ||
+			var->varattno <= 0 || con->constisnull)
+			continue;
+
+		/* Min/max are kept in the order of the column's collation */
+		if (OidIsValid(op->inputcollid) && op->inputcollid != var->varcollid)
+			continue;
+
+		typentry = lookup_type_cache(var->vartype,
+									 TYPECACHE_BTREE_OPFAMILY);
+		if (!OidIsValid(typentry->btree_opf) ||
+			!op_in_opfamily(opno, typentry->btree_opf))
+			continue;
+		get_op_opfamily_properties(opno, typentry->btree_opf, false,
+								   &strategy, &lefttype, &righttype);
+		if (lefttype != var->vartype || righttype != con->consttype)
+			continue;
+		cmpproc = get_opfamily_proc(typentry->btree_opf, lefttype,
+									righttype, BTORDER_PROC);
+		if (!OidIsValid(cmpproc))
+			continue;
+
+		skipkeys = lappend(skipkeys,
+						   list_make5(makeInteger(var->varattno),
+									  makeInteger(strategy),
+									  makeInteger((int) cmpproc),
+									  makeInteger((int) op->inputcollid),
+									  copyObject(con)));
+	}
+
+	return skipkeys;
+}
+
+static Plan *
+columnar_plan_path(PlannerInfo *root, RelOptInfo *rel,
+				   CustomPath *best_path, List *tlist, List *clauses,
+				   List *custom_plans)
+{
+	CustomScan *cscan = makeNode(CustomScan);
+
+	cscan->methods = &columnar_scan_methods;
+	cscan->scan.plan.targetlist = tlist;
+	cscan->scan.plan.qual = extract_actual_clauses(clauses, false);
+	cscan->scan.scanrelid = rel->relid;
+	cscan->flags = best_path->flags;
+	cscan->custom_private = best_path->custom_private;
+
+	return &cscan->scan.plan;
+}
+
+/* ----------------------------------------------------------------
+ *				 execution
+ * ----------------------------------------------------------------
+ */
+
+static Node *
+columnar_create_scan_state(CustomScan *cscan)
+{
+	ColumnarScanState *state;
+
+	state = (ColumnarScanState *) newNode(sizeof(ColumnarScanState),
+										  T_CustomScanState);
+	state->css.methods = &columnar_exec_methods;
+
+	return (Node *) state;
+}
+
+static void
+columnar_begin_scan(CustomScanState *node, EState *estate, int eflags)
+{
+	ColumnarScanState *state = (ColumnarScanState *) node;
+	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
+	List	   *attrs = linitial(cscan->custom_private);
+	List	   *skipkeys = lsecond(cscan->custom_private);
+	int			i = 0;
+
+	foreach_int(attno, attrs)
+		state->attrs = bms_add_member(state->attrs, attno);
+
+	state->nkeys = list_length(skipkeys);
+	state->keys = palloc(sizeof(ScanKeyData) * Max(state->nkeys, 1));
+	foreach_node(List, skipkey, skipkeys)
+	{
+		Const	   *con = list_nth_node(Const, skipkey, 4);
+
+		ScanKeyEntryInitialize(&state->keys[i++], 0,
+							   intVal(linitial(skipkey)),
+							   intVal(lsecond(skipkey)),
+							   InvalidOid,
+							   (Oid) intVal(lfourth(skipkey)),
+							   (RegProcedure) intVal(lthird(skipkey)),
+							   con->constvalue);
+	}
+}
+
+static void
+columnar_set_scan_projection(ColumnarScanState *state,
+							 TableScanDesc scandesc)
+{
+	columnar_scan_set_projection(scandesc, state->attrs, state->nkeys,
+								 state->keys);
+}
+
+static TupleTableSlot *
+columnar_scan_next(ScanState *node)
+{
+	ColumnarScanState *state = (ColumnarScanState *) node;
+	TableScanDesc scandesc = node->ss_currentScanDesc;
+	EState	   *estate = node->ps.state;
+
+	if (scandesc == NULL)
+	{
+		scandesc = table_beginscan(node->ss_currentRelation,
+								   estate->es_snapshot, 0, NULL);
+		columnar_set_scan_projection(state, scandesc);
+		node->ss_currentScanDesc = scandesc;
+	}
+
+	if (table_scan_getnextslot(scandesc, estate->es_direction,
+							   node->ss_ScanTupleSlot))
+		return node->ss_ScanTupleSlot;
+	return NULL;
+}
+
+static bool
+columnar_scan_recheck(ScanState *node, TupleTableSlot *slot)
+{
+	return true;
+}
+
+static TupleTableSlot *
+columnar_exec_scan(CustomScanState *node)
+{
+	return ExecScan(&node->ss,
+					(ExecScanAccessMtd) columnar_scan_next,
+					(ExecScanRecheckMtd) columnar_scan_recheck);
+}
+
+static void
+columnar_end_scan(CustomScanState *node)
+{
+	if (node->ss.ss_currentScanDesc)
+		table_endscan(node->ss.ss_currentScanDesc);
+}
+
+static void
+columnar_rescan_scan(CustomScanState *node)
+{
+	if (node->ss.ss_currentScanDesc)
+		table_rescan(node->ss.ss_currentScanDesc, NULL);
+
+	ExecScanReScan(&node->ss);
+}
+
+static Size
+columnar_estimate_dsm(CustomScanState *node, ParallelContext *pcxt)
+{
+	EState	   *estate = node->ss.ps.state;
+
+	return table_parallelscan_estimate(node->ss.ss_currentRelation,
+									   estate->es_snapshot);
+}
+
+static void
+columnar_initialize_dsm(CustomScanState *node, ParallelContext *pcxt,
+						void *coordinate)
+{
+	ColumnarScanState *state = (ColumnarScanState *) node;
+	EState	   *estate = node->ss.ps.state;
+	ParallelTableScanDesc pscan = coordinate;
+
+	table_parallelscan_initialize(node->ss.ss_currentRelation, pscan,
+								  estate->es_snapshot);
+	node->ss.ss_currentScanDesc =
+		table_beginscan_parallel(node->ss.ss_currentRelation, pscan);
+	columnar_set_scan_projection(state, node->ss.ss_currentScanDesc);
+}
+
+static void
+columnar_reinitialize_dsm(CustomScanState *node, ParallelContext *pcxt,
+						  void *coordinate)
+{
+	table_parallelscan_reinitialize(node->ss.ss_currentRelation, coordinate);
+}
+
+static void
+columnar_initialize_worker(CustomScanState *node, shm_toc *toc,
+						   void *coordinate)
+{
+	ColumnarScanState *state = (ColumnarScanState *) node;
+
+	node->ss.ss_currentScanDesc =
+		table_beginscan_parallel(node->ss.ss_currentRelation, coordinate);
+	columnar_set_scan_projection(state, node->ss.ss_currentScanDesc);
+}
+
+static void
+columnar_explain_scan(CustomScanState *node, List *ancestors,
+					  ExplainState *es)
+{
+	ColumnarScanState *state = (ColumnarScanState *) node;
+	TupleDesc	tupdesc = RelationGetDescr(node->ss.ss_currentRelation);
+	List	   *names = NIL;
+	int			attno = -1;
+
+	while ((attno = bms_next_member(state->attrs, attno)) >= 0)
+		names = lappend(names,
+						NameStr(TupleDescAttr(tupdesc, attno - 1)->attname));
+
+	if (names != NIL)
+		ExplainPropertyList("Columnar Projected Columns", names, es);
+	else
+		ExplainPropertyText("Columnar Projected Columns", "none", es);
+
+	if (es->analyze && node->ss.ss_currentScanDesc != NULL)
+		ExplainPropertyUInteger("Columnar Chunk Groups Skipped", NULL,
+								columnar_scan_groups_skipped(node->ss.ss_currentScanDesc),
+								es);
+}
+
+void
+columnar_customscan_init(void)
+{
+	prev_set_rel_pathlist_hook = set_rel_pathlist_hook;
+	set_rel_pathlist_hook = columnar_set_rel_pathlist;
+
+	RegisterCustomScanMethods(&columnar_scan_methods);
+}
@@ -0,0 +1,902 @@
+/*-------------------------------------------------------------------------
+ *
+ * columnar_reader.c
+ *		Scans of columnar tables.
+ *
+ * A scan first lists the stripes visible to its snapshot, by walking the
+ * stripe headers up to the end of stream.  It then reads the stripes one
+ * chunk group at a time, decoding only the columns the query needs, and
+ * skipping chunk groups whose min/max values show that no row can satisfy
+ * the scan's skip keys.  A parallel scan hands out whole stripes to the
+ * participants.
+ *
+ * Copyright (c) 2024, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  contrib/columnar/columnar_reader.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "access/nbtree.h"
+#include "access/transam.h"
+#include "access/tupmacs.h"
+#include "access/xact.h"
+#include "columnar.h"
+#include "common/pg_lzcompress.h"
+#include "executor/tuptable.h"
+#include "port/atomics.h"
+#include "storage/bufmgr.h"
+#include "storage/procarray.h"
+#include "storage/read_stream.h"
+#include "utils/memutils.h"
+#include "utils/snapmgr.h"
+
+typedef struct ColumnarScanDescData
+{
+	TableScanDescData rs_base;	/* AM independent part of the descriptor */
+
+	MemoryContext scan_context; /* lives as long as the scan */
+	MemoryContext stripe_context;	/* reset for each stripe */
+	MemoryContext group_context;	/* reset for each chunk group */
+	BufferAccessStrategy strategy;
+
+	bool	   *attr_needed;	/* columns to decode */
+	int			nskipkeys;		/* keys to skip chunk groups with */
+	ScanKey		skipkeys;
+
+	bool		stripes_loaded;
+	ColumnarStripe *stripes;	/* stripes visible to the snapshot */
+	int			nstripes;
+	int			next_stripe;	/* next stripe to scan, if not parallel */
+
+	int			cur_stripe;		/* index of current stripe, or -1 */
+	ColumnarStripeMeta meta;	/* and its chunk directory */
+	int			cur_group;		/* current chunk group, or -1 */
+	ColumnarChunkGroup group;	/* and its values */
+	int			cur_row;		/* next row of the chunk group */
+
+	uint64		groups_skipped; /* chunk groups skipped with min/max */
+
+	/* ANALYZE support */
+	uint64	   *row_ends;		/* rows in stripes [0, i] */
+	uint64		total_rows;
+	BlockNumber analyze_nblocks;
+	uint64		analyze_next;	/* next ordinal to return */
+	uint64		analyze_end;
+} ColumnarScanDescData;
+
+typedef struct ColumnarScanDescData *ColumnarScanDesc;
+
+typedef struct ColumnarParallelScanDescData
+{
+	ParallelTableScanDescData base;
+
+	pg_atomic_uint64 next_stripe;	/* next stripe to hand out */
+} ColumnarParallelScanDescData;
+
+typedef struct ColumnarParallelScanDescData *ColumnarParallelScanDesc;
+
+static void columnar_load_stripes(ColumnarScanDesc scan);
+static void columnar_reset_position(ColumnarScanDesc scan);
+static void columnar_set_stripe(ColumnarScanDesc scan, int stripeno);
+static void columnar_set_group(ColumnarScanDesc scan, int group);
+static bool columnar_next_group(ColumnarScanDesc scan);
+static bool columnar_group_excluded(ColumnarScanDesc scan, int group);
+static int	columnar_group_nrows(ColumnarStripe *stripe, int group);
+static int	columnar_find_stripe(ColumnarStripe *stripes, int nstripes,
+								 uint64 rownum);
+
+/*
+ * Is a stripe visible to a snapshot?
+ *
+ * All rows of a stripe were inserted by one command.  VACUUM replaces the
+ * xmin with FrozenTransactionId once all transactions see the stripe, and
+ * with InvalidTransactionId once its inserting transaction has aborted.
+ */
+bool
+columnar_stripe_visible(const ColumnarStripeHeader *hdr, Snapshot snapshot)
+{
+	TransactionId xmin = hdr->xmin;
+
+	if (snapshot->snapshot_type == SNAPSHOT_ANY)
+		return true;
+	if (!TransactionIdIsValid(xmin))
+		return false;
+	if (TransactionIdEquals(xmin, FrozenTransactionId))
+		return true;
+
+	if (snapshot->snapshot_type == SNAPSHOT_MVCC)
+	{
+		if (TransactionIdIsCurrentTransactionId(xmin))
+			return hdr->cmin < snapshot->curcid;
+		if (XidInMVCCSnapshot(xmin, snapshot))
+			return false;
+		return TransactionIdDidCommit(xmin);
+	}
+
+	/* Other snapshots see what is committed, or was inserted by us */
+	if (TransactionIdIsCurrentTransactionId(xmin))
+		return true;
+	if (TransactionIdIsInProgress(xmin))
+		return false;
+	return TransactionIdDidCommit(xmin);
+}
+
+/*
+ * List the stripes of a table visible to a snapshot.
+ */
+ColumnarStripe *
+columnar_read_stripes(Relation rel, Snapshot snapshot, int *nstripes,
+					  BufferAccessStrategy strategy)
+{
+	ColumnarMetaPageData meta;
+	ColumnarStripe *stripes;
+	int			n = 0;
+	int			maxn = 16;
+	uint64		offset = 0;
+
+	columnar_storage_read_meta(rel, &meta);
+
+	stripes = palloc(sizeof(ColumnarStripe) * maxn);
+	while (offset < meta.data_end)
+	{
+		ColumnarStripeHeader hdr;
+
+		columnar_storage_read(rel, offset, (char *) &hdr, sizeof(hdr),
+							  strategy);
+		if (hdr.magic != COLUMNAR_STRIPE_MAGIC ||
+			hdr.length < SizeOfColumnarStripeHeader ||
+			offset + hdr.length > meta.data_end)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("invalid stripe at offset " UINT64_FORMAT " in columnar table \"%s\"",
+							offset, RelationGetRelationName(rel))));
+
+		if (columnar_stripe_visible(&hdr, snapshot))
+		{
+			if (n == maxn)
+			{
+				maxn *= 2;
+				stripes = repalloc(stripes, sizeof(ColumnarStripe) * maxn);
+			}
+			stripes[n].offset = offset;
+			stripes[n].hdr = hdr;
+			n++;
+		}
+		offset += hdr.length;
+	}
+
+	*nstripes = n;
+	return stripes;
+}
+
+/*
+ * Read the chunk directory of a stripe, in the current memory context.
+ */
+void
+columnar_read_stripe_meta(Relation rel, ColumnarStripe *stripe,
+						  ColumnarStripeMeta *meta,
+						  BufferAccessStrategy strategy)
+{
+	Size		len = stripe->hdr.length - stripe->hdr.meta_offset;
+	Size		dirlen;
+	char	   *buf;
+
+	dirlen = MAXALIGN(sizeof(ColumnarChunkDesc) * stripe->hdr.natts *
+					  stripe->hdr.nchunks);
+	if (len < dirlen)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("invalid chunk directory at offset " UINT64_FORMAT " in columnar table \"%s\"",
+						stripe->offset, RelationGetRelationName(rel))));
+
+	buf = palloc(len);
+	columnar_storage_read(rel, stripe->offset + stripe->hdr.meta_offset,
+						  buf, len, strategy);
+	meta->chunks = (ColumnarChunkDesc *) buf;
+	meta->minmax = buf + dirlen;
+}
+
+/*
+ * Decode the needed columns of a chunk group, in the current memory
+ * context.
+ */
+void
+columnar_read_chunk_group(Relation rel, ColumnarStripe *stripe,
+						  ColumnarStripeMeta *meta, int group,
+						  bool *attr_needed, ColumnarChunkGroup *cg,
+						  BufferAccessStrategy strategy)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	int			natts = Min(tupdesc->natts, stripe->hdr.natts);
+	int			nrows = columnar_group_nrows(stripe, group);
+
+	cg->nrows = nrows;
+	cg->values = palloc0(sizeof(Datum *) * tupdesc->natts);
+	cg->nulls = palloc0(sizeof(bool *) * tupdesc->natts);
+
+	for (int i = 0; i < natts; i++)
+	{
+		Form_pg_attribute att = TupleDescAttr(tupdesc, i);
+		ColumnarChunkDesc *desc;
+		char	   *stored;
+		char	   *raw;
+		char	   *p;
+		bits8	   *bitmap = NULL;
+		Datum	   *values;
+		bool	   *nulls;
+
+		if (!attr_needed[i] || att->attisdropped)
+			continue;
+
+		desc = &meta->chunks[group * stripe->hdr.natts + i];
+		stored = palloc(desc->length);
+		columnar_storage_read(rel, stripe->offset + desc->offset, stored,
+							  desc->length, strategy);
+
+		if (desc->compression == COLUMNAR_COMPRESSION_PGLZ)
+		{
+			raw = palloc(desc->raw_length);
+			if (pglz_decompress(stored, desc->length, raw, desc->raw_length,
+								true) != desc->raw_length)
+				ereport(ERROR,
+						(errcode(ERRCODE_DATA_CORRUPTED),
+						 errmsg("compressed columnar data is corrupt")));
+			pfree(stored);
+		}
+		else
+			raw = stored;
+
+		p = raw;
+		if (desc->has_nulls)
+		{
+			bitmap = (bits8 *) raw;
+			p += MAXALIGN(BITMAPLEN(nrows));
+		}
+
+		values = palloc(sizeof(Datum) * nrows);
+		nulls = palloc(sizeof(bool) * nrows);
+		for (int row = 0; row < nrows; row++)
+		{
+			if (bitmap && att_isnull(row, bitmap))
+			{
+				values[row] = (Datum) 0;
+				nulls[row] = true;
+				continue;
+			}
+
+			p = (char *) att_align_nominal(p, att->attalign);
+			values[row] = fetch_att(p, att->attbyval, att->attlen);
+			nulls[row] = false;
+			p = att_addlength_pointer(p, att->attlen, p);
+		}
+
+		if (p > raw + desc->raw_length)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("invalid chunk data at offset " UINT64_FORMAT " in columnar table \"%s\"",
+							stripe->offset + desc->offset,
+							RelationGetRelationName(rel))));
+
+		cg->values[i] = values;
+		cg->nulls[i] = nulls;
+	}
+}
+
+/*
+ * Store row "row" of a decoded chunk group in a slot.  Columns that weren't
+ * decoded are set to null, and columns added after the stripe was written
+ * to their missing value.
+ */
+void
+columnar_store_row(Relation rel, ColumnarStripe *stripe,
+				   ColumnarChunkGroup *cg, int row, uint64 rownum,
+				   bool *attr_needed, TupleTableSlot *slot)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+
+	ExecClearTuple(slot);
+
+	for (int i = 0; i < tupdesc->natts; i++)
+	{
+		if (cg->values[i] != NULL)
+		{
+			slot->tts_values[i] = cg->values[i][row];
+			slot->tts_isnull[i] = cg->nulls[i][row];
+		}
+		else if (i >= stripe->hdr.natts && attr_needed[i] &&
+				 !TupleDescAttr(tupdesc, i)->attisdropped)
+			slot->tts_values[i] = getmissingattr(tupdesc, i + 1,
+												 &slot->tts_isnull[i]);
+		else
+		{
+			slot->tts_values[i] = (Datum) 0;
+			slot->tts_isnull[i] = true;
+		}
+	}
+
+	ExecStoreVirtualTuple(slot);
+	columnar_row_to_tid(rownum, &slot->tts_tid);
+	slot->tts_tableOid = RelationGetRelid(rel);
+}
+
+static int
+columnar_group_nrows(ColumnarStripe *stripe, int group)
+{
+	uint64		start = (uint64) group * stripe->hdr.chunk_rows;
+
+	return Min(stripe->hdr.chunk_rows, stripe->hdr.nrows - start);
+}
+
+/*
+ * Find the stripe holding a row, by binary search over stripes ordered by
+ * row number.  Returns -1 if there is none.
+ */
+static int
+columnar_find_stripe(ColumnarStripe *stripes, int nstripes, uint64 rownum)
+{
+	int			lo = 0;
+	int			hi = nstripes - 1;
+
+	while (lo <= hi)
+	{
+		int			mid = lo + (hi - lo) / 2;
+		ColumnarStripeHeader *hdr = &stripes[mid].hdr;
+
+		if (rownum < hdr->first_row)
+			hi = mid - 1;
+		else if (rownum >= hdr->first_row + hdr->nrows)
+			lo = mid + 1;
+		else
+			return mid;
+	}
+
+	return -1;
+}
+
+/* ----------------------------------------------------------------
+ *				 scan callbacks
+ * ----------------------------------------------------------------
+ */
+
+TableScanDesc
+columnar_beginscan(Relation rel, Snapshot snapshot, int nkeys, ScanKey key,
+				   ParallelTableScanDesc pscan, uint32 flags)
+{
+	ColumnarScanDesc scan;
+	int			natts = RelationGetDescr(rel)->natts;
+
+	/* Rows buffered by this backend must be visible to the scan */
+	columnar_flush_pending(rel);
+
+	scan = palloc0(sizeof(ColumnarScanDescData));
+	scan->rs_base.rs_rd = rel;
+	scan->rs_base.rs_snapshot = snapshot;
+	scan->rs_base.rs_nkeys = nkeys;
+	scan->rs_base.rs_key = key;
+	scan->rs_base.rs_flags = flags;
+	scan->rs_base.rs_parallel = pscan;
+
+	scan->scan_context = AllocSetContextCreate(CurrentMemoryContext,
+											   "columnar scan",
+											   ALLOCSET_DEFAULT_SIZES);
+	scan->stripe_context = AllocSetContextCreate(scan->scan_context,
+												 "columnar stripe",
+												 ALLOCSET_DEFAULT_SIZES);
+	scan->group_context = AllocSetContextCreate(scan->scan_context,
+												"columnar chunk group",
+												ALLOCSET_DEFAULT_SIZES);
+
+	if ((flags & SO_ALLOW_STRAT) &&
+		RelationGetNumberOfBlocks(rel) > NBuffers / 4)
+		scan->strategy = GetAccessStrategy(BAS_BULKREAD);
+
+	scan->attr_needed = MemoryContextAlloc(scan->scan_context,
+										   sizeof(bool) * Max(natts, 1));
+	memset(scan->attr_needed, true, sizeof(bool) * Max(natts, 1));
+
+	columnar_reset_position(scan);
+
+	return (TableScanDesc) scan;
+}
+
+void
+columnar_endscan(TableScanDesc sscan)
+{
+	ColumnarScanDesc scan = (ColumnarScanDesc) sscan;
+
+	if (scan->strategy)
+		FreeAccessStrategy(scan->strategy);
+
+	if (scan->rs_base.rs_flags & SO_TEMP_SNAPSHOT)
+		UnregisterSnapshot(scan->rs_base.rs_snapshot);
+
+	MemoryContextDelete(scan->scan_context);
+	pfree(scan);
+}
+
+void
+columnar_rescan(TableScanDesc sscan, ScanKey key, bool set_params,
+				bool allow_strat, bool allow_sync, bool allow_pagemode)
+{
+	ColumnarScanDesc scan = (ColumnarScanDesc) sscan;
+
+	if (set_params)
+	{
+		if (allow_strat)
+			scan->rs_base.rs_flags |= SO_ALLOW_STRAT;
+		else
+			scan->rs_base.rs_flags &= ~SO_ALLOW_STRAT;
+	}
+
+	columnar_reset_position(scan);
+}
+
+/*
+ * Restrict the scan to the columns in "attrs", and let it skip chunk groups
+ * that can't satisfy "keys".  Keys use the strategy numbers of btree, and a
+ * btree comparison function comparing a column value to the argument.
+ */
+void
+columnar_scan_set_projection(TableScanDesc sscan, Bitmapset *attrs,
+							 int nkeys, ScanKey keys)
+{
+	ColumnarScanDesc scan = (ColumnarScanDesc) sscan;
+	int			natts = RelationGetDescr(sscan->rs_rd)->natts;
+
+	for (int i = 0; i < natts; i++)
+		scan->attr_needed[i] = bms_is_member(i + 1, attrs);
+
+	scan->nskipkeys = nkeys;
+	if (nkeys > 0)
+	{
+		scan->skipkeys = MemoryContextAlloc(scan->scan_context,
+											sizeof(ScanKeyData) * nkeys);
+		memcpy(scan->skipkeys, keys, sizeof(ScanKeyData) * nkeys);
+	}
+}
+
+uint64
+columnar_scan_groups_skipped(TableScanDesc sscan)
+{
+	return ((ColumnarScanDesc) sscan)->groups_skipped;
+}
+
+static void
+columnar_reset_position(ColumnarScanDesc scan)
+{
+	scan->next_stripe = 0;
+	scan->cur_stripe = -1;
+	scan->cur_group = -1;
+	scan->cur_row = 0;
+	scan->group.nrows = 0;
+}
+
+/*
+ * List the visible stripes.  This is done on the first fetch rather than
+ * when the scan begins, as a CustomScan only sets the projection after
+ * that.
+ */
+static void
+columnar_load_stripes(ColumnarScanDesc scan)
+{
+	Relation	rel = scan->rs_base.rs_rd;
+	Snapshot	snapshot = scan->rs_base.rs_snapshot;
+	MemoryContext oldcxt;
+
+	/* ANALYZE doesn't pass a snapshot, and counts what has committed */
+	if (snapshot == NULL)
+		snapshot = SnapshotSelf;
+
+	oldcxt = MemoryContextSwitchTo(scan->scan_context);
+	scan->stripes = columnar_read_stripes(rel, snapshot, &scan->nstripes,
+										  scan->strategy);
+	if (scan->rs_base.rs_flags & SO_TYPE_ANALYZE)
+	{
+		scan->row_ends = palloc(sizeof(uint64) * Max(scan->nstripes, 1));
+		scan->total_rows = 0;
+		for (int i = 0; i < scan->nstripes; i++)
+		{
+			scan->total_rows += scan->stripes[i].hdr.nrows;
+			scan->row_ends[i] = scan->total_rows;
+		}
+		scan->analyze_nblocks = RelationGetNumberOfBlocks(rel);
+	}
+	MemoryContextSwitchTo(oldcxt);
+
+	scan->stripes_loaded = true;
+}
+
+static void
+columnar_set_stripe(ColumnarScanDesc scan, int stripeno)
+{
+	MemoryContext oldcxt;
+
+	MemoryContextReset(scan->group_context);
+	MemoryContextReset(scan->stripe_context);
+	scan->cur_group = -1;
+	scan->cur_row = 0;
+	scan->group.nrows = 0;
+
+	scan->cur_stripe = stripeno;
+	oldcxt = MemoryContextSwitchTo(scan->stripe_context);
+	columnar_read_stripe_meta(scan->rs_base.rs_rd, &scan->stripes[stripeno],
+							  &scan->meta, scan->strategy);
+	MemoryContextSwitchTo(oldcxt);
+}
+
+static void
+columnar_set_group(ColumnarScanDesc scan, int group)
+{
+	MemoryContext oldcxt;
+
+	MemoryContextReset(scan->group_context);
+	scan->cur_group = group;
+	scan->cur_row = 0;
+
+	oldcxt = MemoryContextSwitchTo(scan->group_context);
+	columnar_read_chunk_group(scan->rs_base.rs_rd,
+							  &scan->stripes[scan->cur_stripe], &scan->meta,
+							  group, scan->attr_needed, &scan->group,
+							  scan->strategy);
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * Advance to the next chunk group that might have matching rows, moving on
+ * to the next stripe as needed.  Returns false at the end of the scan.
+ */
+static bool
+columnar_next_group(ColumnarScanDesc scan)
+{
+	for (;;)
+	{
+		int			stripeno;
+
+		if (scan->cur_stripe >= 0)
+		{
+			ColumnarStripe *stripe = &scan->stripes[scan->cur_stripe];
+			int			group = scan->cur_group;
+
+			while (++group < stripe->hdr.nchunks)
+			{
+				if (columnar_group_excluded(scan, group))
+				{
+					scan->groups_skipped++;
+					continue;
+				}
+				columnar_set_group(scan, group);
+				return true;
+			}
+		}
+
+		if (scan->rs_base.rs_parallel != NULL)
+		{
+			ColumnarParallelScanDesc pscan =
+				(ColumnarParallelScanDesc) scan->rs_base.rs_parallel;
+
+			stripeno = pg_atomic_fetch_add_u64(&pscan->next_stripe, 1);
+		}
+		else
+			stripeno = scan->next_stripe++;
+
+		if (stripeno >= scan->nstripes)
+		{
+			scan->cur_stripe = -1;
+			return false;
+		}
+		columnar_set_stripe(scan, stripeno);
+	}
+}
+
+/*
+ * Can chunk group "group" of the current stripe be skipped, going by its
+ * min/max values?
+ */
+static bool
+columnar_group_excluded(ColumnarScanDesc scan, int group)
+{
+	ColumnarStripe *stripe = &scan->stripes[scan->cur_stripe];
+	TupleDesc	tupdesc = RelationGetDescr(scan->rs_base.rs_rd);
+
+	for (int i = 0; i < scan->nskipkeys; i++)
+	{
+		ScanKey		key = &scan->skipkeys[i];
+		Form_pg_attribute att = TupleDescAttr(tupdesc, key->sk_attno - 1);
+		ColumnarChunkDesc *desc;
+		Datum		min;
+		Datum		max;
+		int32		cmp;
+
+		if (key->sk_attno > stripe->hdr.natts)
+			continue;
+		desc = &scan->meta.chunks[group * stripe->hdr.natts +
+								  key->sk_attno - 1];
+		if (desc->min_length == 0)
+			continue;
+
+		min = fetch_att(scan->meta.minmax + desc->minmax_offset,
+						att->attbyval, att->attlen);
+		max = fetch_att(scan->meta.minmax + desc->minmax_offset +
+						MAXALIGN(desc->min_length),
+						att->attbyval, att->attlen);
+
+		switch (key->sk_strategy)
+		{
+			case BTLessStrategyNumber:
+			case BTLessEqualStrategyNumber:
+				cmp = DatumGetInt32(FunctionCall2Coll(&key->sk_func,
+													  key->sk_collation,
+													  min,
+													  key->sk_argument));
+				if (cmp > 0 ||
+					(cmp == 0 && key->sk_strategy == BTLessStrategyNumber))
+					return true;
+				break;
+			case BTEqualStrategyNumber:
+				cmp = DatumGetInt32(FunctionCall2Coll(&key->sk_func,
+													  key->sk_collation,
+													  min,
+													  key->sk_argument));
+				if (cmp > 0)
+					return true;
+				cmp = DatumGetInt32(FunctionCall2Coll(&key->sk_func,
+													  key->sk_collation,
+													  max,
+													  key->sk_argument));
+				if (cmp < 0)
+					return true;
+				break;
+			case BTGreaterEqualStrategyNumber:
+			case BTGreaterStrategyNumber:
+				cmp = DatumGetInt32(FunctionCall2Coll(&key->sk_func,
+													  key->sk_collation,
+													  max,
+													  key->sk_argument));
+				if (cmp < 0 ||
+					(cmp == 0 && key->sk_strategy == BTGreaterStrategyNumber))
+					return true;
+				break;
+		}
+	}
+
+	return false;
+}
+
+bool
+columnar_getnextslot(TableScanDesc sscan, ScanDirection direction,
+					 TupleTableSlot *slot)
+{
+	ColumnarScanDesc scan = (ColumnarScanDesc) sscan;
+
+	if (ScanDirectionIsBackward(direction))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("backward scans are not supported by columnar tables")));
+
+	if (!scan->stripes_loaded)
+		columnar_load_stripes(scan);
+
+	for (;;)
+	{
+		if (scan->cur_row < scan->group.nrows)
+		{
+			ColumnarStripe *stripe = &scan->stripes[scan->cur_stripe];
+			int			row = scan->cur_row++;
+			uint64		rownum;
+
+			rownum = stripe->hdr.first_row +
+				(uint64) scan->cur_group * stripe->hdr.chunk_rows + row;
+			columnar_store_row(sscan->rs_rd, stripe, &scan->group, row,
+							   rownum, scan->attr_needed, slot);
+			return true;
+		}
+
+		if (!columnar_next_group(scan))
+		{
+			ExecClearTuple(slot);
+			return false;
+		}
+	}
+}
+
+/* ----------------------------------------------------------------
+ *				 parallel scan support
+ * ----------------------------------------------------------------
+ */
+
+Size
+columnar_parallelscan_estimate(Relation rel)
+{
+	return sizeof(ColumnarParallelScanDescData);
+}
+
+Size
+columnar_parallelscan_initialize(Relation rel, ParallelTableScanDesc pscan)
+{
+	ColumnarParallelScanDesc cpscan = (ColumnarParallelScanDesc) pscan;
+
+	cpscan->base.phs_relid = RelationGetRelid(rel);
+	cpscan->base.phs_syncscan = false;
+	pg_atomic_init_u64(&cpscan->next_stripe, 0);
+
+	return sizeof(ColumnarParallelScanDescData);
+}
+
+void
+columnar_parallelscan_reinitialize(Relation rel, ParallelTableScanDesc pscan)
+{
+	ColumnarParallelScanDesc cpscan = (ColumnarParallelScanDesc) pscan;
+
+	pg_atomic_write_u64(&cpscan->next_stripe, 0);
+}
+
+/* ----------------------------------------------------------------
+ *				 fetching single rows
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Is row "rownum" visible to "snapshot"?
+ */
+bool
+columnar_row_visible(Relation rel, uint64 rownum, Snapshot snapshot)
+{
+	ColumnarStripe *stripes;
+	int			nstripes;
+	int			stripeno;
+	bool		visible;
+
+	columnar_flush_pending(rel);
+
+	stripes = columnar_read_stripes(rel, SnapshotAny, &nstripes, NULL);
+	stripeno = columnar_find_stripe(stripes, nstripes, rownum);
+	visible = stripeno >= 0 &&
+		columnar_stripe_visible(&stripes[stripeno].hdr, snapshot);
+	pfree(stripes);
+
+	return visible;
+}
+
+/*
+ * Fetch the row with TID "tid", if it's visible to "snapshot".
+ */
+bool
+columnar_fetch_row(Relation rel, ItemPointer tid, Snapshot snapshot,
+				   TupleTableSlot *slot)
+{
+	uint64		rownum = columnar_tid_to_row(tid);
+	MemoryContext context;
+	MemoryContext oldcxt;
+	ColumnarStripe *stripes;
+	int			nstripes;
+	int			stripeno;
+	bool		found = false;
+
+	columnar_flush_pending(rel);
+
+	context = AllocSetContextCreate(CurrentMemoryContext,
+									"columnar fetch",
+									ALLOCSET_DEFAULT_SIZES);
+	oldcxt = MemoryContextSwitchTo(context);
+
+	stripes = columnar_read_stripes(rel, SnapshotAny, &nstripes, NULL);
+	stripeno = columnar_find_stripe(stripes, nstripes, rownum);
+	if (stripeno >= 0 &&
+		columnar_stripe_visible(&stripes[stripeno].hdr, snapshot))
+	{
+		ColumnarStripe *stripe = &stripes[stripeno];
+		int			natts = RelationGetDescr(rel)->natts;
+		uint64		row = rownum - stripe->hdr.first_row;
+		int			group = row / stripe->hdr.chunk_rows;
+		ColumnarStripeMeta meta;
+		ColumnarChunkGroup cg;
+		bool	   *attr_needed;
+
+		attr_needed = palloc(sizeof(bool) * Max(natts, 1));
+		memset(attr_needed, true, sizeof(bool) * Max(natts, 1));
+
+		columnar_read_stripe_meta(rel, stripe, &meta, NULL);
+		columnar_read_chunk_group(rel, stripe, &meta, group, attr_needed,
+								  &cg, NULL);
+		columnar_store_row(rel, stripe, &cg,
+						   row - (uint64) group * stripe->hdr.chunk_rows,
+						   rownum, attr_needed, slot);
+
+		/* Copy the values out of the memory about to be freed */
+		ExecMaterializeSlot(slot);
+		found = true;
+	}
+
+	MemoryContextSwitchTo(oldcxt);
+	MemoryContextDelete(context);
+
+	return found;
+}
+
+/* ----------------------------------------------------------------
+ *				 ANALYZE support
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * ANALYZE samples blocks, but rows aren't stored in blocks.  Instead, each
+ * sampled block stands for an equal share of the visible rows, in row
+ * number order, so that sampling all blocks returns all rows.  The block
+ * itself is read only to consume it from the stream.
+ */
+bool
+columnar_scan_analyze_next_block(TableScanDesc sscan, ReadStream *stream)
+{
+	ColumnarScanDesc scan = (ColumnarScanDesc) sscan;
+	Buffer		buf;
+	BlockNumber blkno;
+
+	if (!scan->stripes_loaded)
+		columnar_load_stripes(scan);
+
+	buf = read_stream_next_buffer(stream, NULL);
+	if (!BufferIsValid(buf))
+		return false;
+	blkno = BufferGetBlockNumber(buf);
+	ReleaseBuffer(buf);
+
+	scan->analyze_next = (uint64) ((double) scan->total_rows * blkno /
+								   scan->analyze_nblocks);
+	scan->analyze_end = (uint64) ((double) scan->total_rows * (blkno + 1) /
+								  scan->analyze_nblocks);
+
+	return true;
+}
+
+bool
+columnar_scan_analyze_next_tuple(TableScanDesc sscan,
+								 TransactionId OldestXmin,
+								 double *liverows, double *deadrows,
+								 TupleTableSlot *slot)
+{
+	ColumnarScanDesc scan = (ColumnarScanDesc) sscan;
+	ColumnarStripe *stripe;
+	uint64		ordinal;
+	uint64		row;
+	int			stripeno;
+	int			group;
+	int			lo;
+	int			hi;
+
+	if (scan->analyze_next >= scan->analyze_end)
+		return false;
+	ordinal = scan->analyze_next++;
+
+	/* Find the stripe holding the ordinal'th visible row */
+	lo = 0;
+	hi = scan->nstripes - 1;
+	while (lo < hi)
+	{
+		int			mid = lo + (hi - lo) / 2;
+
+		if (scan->row_ends[mid] <= ordinal)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	stripeno = lo;
+	stripe = &scan->stripes[stripeno];
+	row = ordinal - (stripeno > 0 ? scan->row_ends[stripeno - 1] : 0);
+	group = row / stripe->hdr.chunk_rows;
+
+	if (scan->cur_stripe != stripeno)
+		columnar_set_stripe(scan, stripeno);
+	if (scan->cur_group != group)
+		columnar_set_group(scan, group);
+
+	columnar_store_row(sscan->rs_rd, stripe, &scan->group,
+					   row - (uint64) group * stripe->hdr.chunk_rows,
+					   stripe->hdr.first_row + row, scan->attr_needed, slot);
+	*liverows += 1;
+
+	return true;
+}
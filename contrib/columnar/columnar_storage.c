@@ -0,0 +1,335 @@
+/*-------------------------------------------------------------------------
+ *
+ * columnar_storage.c
+ *		Page-level storage of columnar tables.
+ *
+ * A columnar table stores a single stream of bytes in the data area of its
+ * pages, following the metapage at block 0.  The stream only ever grows, so
+ * a logical offset maps to a fixed page and position, and readers need no
+ * locks beyond the buffer content locks held while copying bytes out.
+ *
+ * Appends are serialized by a page lock on the metapage.  The appender
+ * writes its bytes past the end of stream recorded in the metapage and only
+ * then advances the end of stream, so concurrent readers never see a
+ * partially written stripe.  All changes are WAL-logged with generic WAL
+ * records.
+ *
+ * Copyright (c) 2024, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  contrib/columnar/columnar_storage.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/generic_xlog.h"
+#include "columnar.h"
+#include "storage/bufmgr.h"
+#include "storage/lmgr.h"
+
+static void columnar_init_metapage(Relation rel);
+
+/*
+ * Initialize the metapage of a table that doesn't have one yet.  The
+ * metapage is created lazily, so that an empty table, and the init fork of
+ * an unlogged one, is just an empty file.
+ *
+ * The caller must hold the metapage page lock.
+ */
+static void
+columnar_init_metapage(Relation rel)
+{
+	Buffer		buf;
+	Page		page;
+	GenericXLogState *state;
+	ColumnarMetaPageData *meta;
+
+	if (RelationGetNumberOfBlocks(rel) == 0)
+		buf = ExtendBufferedRel(BMR_REL(rel), MAIN_FORKNUM, NULL,
+								EB_LOCK_FIRST);
+	else
+	{
+		buf = ReadBuffer(rel, COLUMNAR_METAPAGE_BLKNO);
+		LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+
+		/* Someone else initialized it already? */
+		if (!PageIsNew(BufferGetPage(buf)))
+		{
+			UnlockReleaseBuffer(buf);
+			return;
+		}
+	}
+	Assert(BufferGetBlockNumber(buf) == COLUMNAR_METAPAGE_BLKNO);
+
+	state = GenericXLogStart(rel);
+	page = GenericXLogRegisterBuffer(state, buf, GENERIC_XLOG_FULL_IMAGE);
+	PageInit(page, BLCKSZ, 0);
+
+	meta = ColumnarPageGetMeta(page);
+	memset(meta, 0, sizeof(ColumnarMetaPageData));
+	meta->magic = COLUMNAR_MAGIC;
+	meta->version = COLUMNAR_VERSION;
+	((PageHeader) page)->pd_lower =
+		((char *) meta + sizeof(ColumnarMetaPageData)) - (char *) page;
+
+	GenericXLogFinish(state);
+	UnlockReleaseBuffer(buf);
+}
+
+/*
+ * Read the contents of the metapage.  A table without a metapage is
+ * reported as empty.
+ */
+void
+columnar_storage_read_meta(Relation rel, ColumnarMetaPageData *meta)
+{
+	Buffer		buf;
+	Page		page;
+
+	memset(meta, 0, sizeof(ColumnarMetaPageData));
+
+	if (RelationGetNumberOfBlocks(rel) == 0)
+		return;
+
+	buf = ReadBuffer(rel, COLUMNAR_METAPAGE_BLKNO);
+	LockBuffer(buf, BUFFER_LOCK_SHARE);
+	page = BufferGetPage(buf);
+
+	if (!PageIsNew(page))
+	{
+		*meta = *ColumnarPageGetMeta(page);
+
+		if (meta->magic != COLUMNAR_MAGIC)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("relation \"%s\" is not a columnar table",
+							RelationGetRelationName(rel))));
+		if (meta->version != COLUMNAR_VERSION)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("columnar table \"%s\" has unsupported version %u",
+							RelationGetRelationName(rel), meta->version)));
+	}
+
+	UnlockReleaseBuffer(buf);
+}
+
+/*
+ * Copy "len" bytes starting at stream offset "offset" into "data".
+ */
+void
+columnar_storage_read(Relation rel, uint64 offset, char *data, Size len,
+					  BufferAccessStrategy strategy)
+{
+	while (len > 0)
+	{
+		BlockNumber blkno = 1 + offset / COLUMNAR_BYTES_PER_PAGE;
+		uint32		pos = offset % COLUMNAR_BYTES_PER_PAGE;
+		Size		n = Min(len, COLUMNAR_BYTES_PER_PAGE - pos);
+		Buffer		buf;
+		Page		page;
+
+		buf = ReadBufferExtended(rel, MAIN_FORKNUM, blkno, RBM_NORMAL,
+								 strategy);
+		LockBuffer(buf, BUFFER_LOCK_SHARE);
+		page = BufferGetPage(buf);
+
+		if (PageIsNew(page) ||
+			((PageHeader) page)->pd_lower < SizeOfPageHeaderData + pos + n)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("unexpected end of data in block %u of columnar table \"%s\"",
+							blkno, RelationGetRelationName(rel))));
+
+		memcpy(data, (char *) page + SizeOfPageHeaderData + pos, n);
+		UnlockReleaseBuffer(buf);
+
+		offset += n;
+		data += n;
+		len -= n;
+	}
+}
+
+/*
+ * Write "len" bytes at stream offset "offset", extending the table as
+ * needed.
+ *
+ * When appending, the caller must hold the metapage page lock, see
+ * columnar_storage_begin_append().  Bytes before the end of stream may be
+ * overwritten without it, as long as a concurrent reader can't be confused
+ * by the change, which is the case for the in-place updates of stripe
+ * headers done by VACUUM.
+ */
+void
+columnar_storage_write(Relation rel, uint64 offset, const char *data,
+					   Size len)
+{
+	while (len > 0)
+	{
+		BlockNumber blkno = 1 + offset / COLUMNAR_BYTES_PER_PAGE;
+		uint32		pos = offset % COLUMNAR_BYTES_PER_PAGE;
+		Size		n = Min(len, COLUMNAR_BYTES_PER_PAGE - pos);
+		Buffer		buf;
+		Page		page;
+		GenericXLogState *state;
+
+		if (blkno < RelationGetNumberOfBlocks(rel))
+		{
+			buf = ReadBuffer(rel, blkno);
+			LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+		}
+		else
+		{
+			buf = ExtendBufferedRel(BMR_REL(rel), MAIN_FORKNUM, NULL,
+									EB_LOCK_FIRST);
+			Assert(BufferGetBlockNumber(buf) == blkno);
+		}
+
+		state = GenericXLogStart(rel);
+
+		/*
+		 * A page is new when it was just added, or when a crash interrupted
+		 * an earlier append before the page was written out.
+		 */
+		if (PageIsNew(BufferGetPage(buf)))
+		{
+			page = GenericXLogRegisterBuffer(state, buf,
+											 GENERIC_XLOG_FULL_IMAGE);
+			PageInit(page, BLCKSZ, 0);
+		}
+		else
+			page = GenericXLogRegisterBuffer(state, buf, 0);
+
+		memcpy((char *) page + SizeOfPageHeaderData + pos, data, n);
+		((PageHeader) page)->pd_lower =
+			Max(((PageHeader) page)->pd_lower,
+				SizeOfPageHeaderData + pos + n);
+
+		GenericXLogFinish(state);
+		UnlockReleaseBuffer(buf);
+
+		offset += n;
+		data += n;
+		len -= n;
+	}
+}
+
+/*
+ * Start appending to the stream, and return the offset to write at.  The
+ * metapage page lock is held until columnar_storage_end_append(), or until
+ * the end of the transaction on error.
+ */
+uint64
+columnar_storage_begin_append(Relation rel)
+{
+	ColumnarMetaPageData meta;
+
+	LockPage(rel, COLUMNAR_METAPAGE_BLKNO, ExclusiveLock);
+
+	columnar_storage_read_meta(rel, &meta);
+	if (meta.magic == 0)
+		columnar_init_metapage(rel);
+
+	return meta.data_end;
+}
+
+/*
+ * Finish an append by making the bytes up to "data_end", holding "nrows"
+ * new rows, visible to readers.
+ */
+void
+columnar_storage_end_append(Relation rel, uint64 data_end, uint64 nrows)
+{
+	Buffer		buf;
+	GenericXLogState *state;
+	ColumnarMetaPageData *meta;
+
+	buf = ReadBuffer(rel, COLUMNAR_METAPAGE_BLKNO);
+	LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+
+	state = GenericXLogStart(rel);
+	meta = ColumnarPageGetMeta(GenericXLogRegisterBuffer(state, buf, 0));
+	Assert(data_end >= meta->data_end);
+	meta->data_end = data_end;
+	meta->row_count += nrows;
+	GenericXLogFinish(state);
+
+	UnlockReleaseBuffer(buf);
+
+	UnlockPage(rel, COLUMNAR_METAPAGE_BLKNO, ExclusiveLock);
+}
+
+/*
+ * Reserve "nrows" consecutive row numbers, and return the first one.
+ */
+uint64
+columnar_storage_reserve_rows(Relation rel, uint64 nrows)
+{
+	ColumnarMetaPageData current;
+	ColumnarMetaPageData *meta;
+	Buffer		buf;
+	GenericXLogState *state;
+	uint64		first;
+
+	columnar_storage_read_meta(rel, &current);
+	if (current.magic == 0)
+	{
+		LockPage(rel, COLUMNAR_METAPAGE_BLKNO, ExclusiveLock);
+		columnar_init_metapage(rel);
+		UnlockPage(rel, COLUMNAR_METAPAGE_BLKNO, ExclusiveLock);
+	}
+
+	buf = ReadBuffer(rel, COLUMNAR_METAPAGE_BLKNO);
+	LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+
+	first = ColumnarPageGetMeta(BufferGetPage(buf))->next_row_number;
+	if (first + nrows > COLUMNAR_MAX_ROW_NUMBER)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("columnar table \"%s\" ran out of row numbers",
+						RelationGetRelationName(rel)),
+				 errhint("Rewrite the table with VACUUM FULL.")));
+
+	state = GenericXLogStart(rel);
+	meta = ColumnarPageGetMeta(GenericXLogRegisterBuffer(state, buf, 0));
+	meta->next_row_number = first + nrows;
+	GenericXLogFinish(state);
+
+	UnlockReleaseBuffer(buf);
+
+	return first;
+}
+
+/*
+ * Move the end of the most recent reservation of row numbers from "end" to
+ * "new_end", to extend it or to give back its unused part.  Returns false,
+ * leaving the reservation alone, if others have reserved row numbers since.
+ */
+bool
+columnar_storage_resize_rows(Relation rel, uint64 end, uint64 new_end)
+{
+	ColumnarMetaPageData *meta;
+	Buffer		buf;
+	GenericXLogState *state;
+	bool		result = false;
+
+	if (new_end > COLUMNAR_MAX_ROW_NUMBER)
+		return false;
+
+	buf = ReadBuffer(rel, COLUMNAR_METAPAGE_BLKNO);
+	LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+
+	if (ColumnarPageGetMeta(BufferGetPage(buf))->next_row_number == end)
+	{
+		state = GenericXLogStart(rel);
+		meta = ColumnarPageGetMeta(GenericXLogRegisterBuffer(state, buf, 0));
+		meta->next_row_number = new_end;
+		GenericXLogFinish(state);
+		result = true;
+	}
+
+	UnlockReleaseBuffer(buf);
+
+	return result;
+}
@@ -0,0 +1,730 @@
+/*-------------------------------------------------------------------------
+ *
+ * columnar_tableam.c
+ *		Table access method callbacks of columnar tables.
+ *
+ * Columnar tables are append-only: rows can be inserted, by INSERT or COPY,
+ * and read back, but not updated, deleted or locked.  Indexes are not
+ * supported either, as there is no way to fetch a row cheaply by TID.
+ *
+ * Copyright (c) 2024, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  contrib/columnar/columnar_tableam.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/heapam.h"
+#include "access/multixact.h"
+#include "access/tableam.h"
+#include "access/transam.h"
+#include "access/xact.h"
+#include "catalog/index.h"
+#include "catalog/storage.h"
+#include "catalog/storage_xlog.h"
+#include "columnar.h"
+#include "commands/vacuum.h"
+#include "executor/tuptable.h"
+#include "fmgr.h"
+#include "pgstat.h"
+#include "storage/bufmgr.h"
+#include "storage/smgr.h"
+#include "utils/guc.h"
+#include "utils/memutils.h"
+#include "utils/snapmgr.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(columnar_handler);
+
+/* GUC parameter */
+bool		columnar_enable_custom_scan = true;
+
+static const struct config_enum_entry compression_options[] = {
+	{"none", COLUMNAR_COMPRESSION_NONE, false},
+	{"pglz", COLUMNAR_COMPRESSION_PGLZ, false},
+	{NULL, 0, false}
+};
+
+static const TableAmRoutine columnar_methods;
+
+/* ------------------------------------------------------------------------
+ * Slot related callbacks
+ * ------------------------------------------------------------------------
+ */
+
+static const TupleTableSlotOps *
+columnar_slot_callbacks(Relation relation)
+{
+	return &TTSOpsVirtual;
+}
+
+/* ------------------------------------------------------------------------
+ * Unsupported operations
+ * ------------------------------------------------------------------------
+ */
+
+static void
+columnar_indexes_not_supported(void)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("indexes are not supported on columnar tables")));
+}
+
+static IndexFetchTableData *
+columnar_index_fetch_begin(Relation rel)
+{
+	columnar_indexes_not_supported();
+	return NULL;				/* keep compiler quiet */
+}
+
+static void
+columnar_index_fetch_reset(IndexFetchTableData *scan)
+{
+}
+
+static void
+columnar_index_fetch_end(IndexFetchTableData *scan)
+{
+}
+
+static bool
+columnar_index_fetch_tuple(struct IndexFetchTableData *scan,
+						   ItemPointer tid,
+						   Snapshot snapshot,
+						   TupleTableSlot *slot,
+						   bool *call_again, bool *all_dead)
+{
+	columnar_indexes_not_supported();
+	return false;				/* keep compiler quiet */
+}
+
+static TransactionId
+columnar_index_delete_tuples(Relation rel, TM_IndexDeleteOp *delstate)
+{
+	columnar_indexes_not_supported();
+	return InvalidTransactionId;	/* keep compiler quiet */
+}
+
+static double
+columnar_index_build_range_scan(Relation tableRelation,
+								Relation indexRelation,
+								IndexInfo *indexInfo,
+								bool allow_sync,
+								bool anyvisible,
+								bool progress,
+								BlockNumber start_blockno,
+								BlockNumber numblocks,
+								IndexBuildCallback callback,
+								void *callback_state,
+								TableScanDesc scan)
+{
+	columnar_indexes_not_supported();
+	return 0;					/* keep compiler quiet */
+}
+
+static void
+columnar_index_validate_scan(Relation tableRelation,
+							 Relation indexRelation,
+							 IndexInfo *indexInfo,
+							 Snapshot snapshot,
+							 ValidateIndexState *state)
+{
+	columnar_indexes_not_supported();
+}
+
+static void
+columnar_tuple_insert_speculative(Relation relation, TupleTableSlot *slot,
+								  CommandId cid, int options,
+								  BulkInsertState bistate, uint32 specToken)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("INSERT ... ON CONFLICT is not supported on columnar tables")));
+}
+
+static void
+columnar_tuple_complete_speculative(Relation relation, TupleTableSlot *slot,
+									uint32 specToken, bool succeeded)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("INSERT ... ON CONFLICT is not supported on columnar tables")));
+}
+
+static TM_Result
+columnar_tuple_delete(Relation relation, ItemPointer tid, CommandId cid,
+					  Snapshot snapshot, Snapshot crosscheck, bool wait,
+					  TM_FailureData *tmfd, bool changingPart)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("DELETE is not supported on columnar tables")));
+	return TM_Ok;				/* keep compiler quiet */
+}
+
+static TM_Result
+columnar_tuple_update(Relation relation, ItemPointer otid,
+					  TupleTableSlot *slot, CommandId cid,
+					  Snapshot snapshot, Snapshot crosscheck,
+					  bool wait, TM_FailureData *tmfd,
+					  LockTupleMode *lockmode,
+					  TU_UpdateIndexes *update_indexes)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("UPDATE is not supported on columnar tables")));
+	return TM_Ok;				/* keep compiler quiet */
+}
+
+static TM_Result
+columnar_tuple_lock(Relation relation, ItemPointer tid, Snapshot snapshot,
+					TupleTableSlot *slot, CommandId cid, LockTupleMode mode,
+					LockWaitPolicy wait_policy, uint8 flags,
+					TM_FailureData *tmfd)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("row-level locks are not supported on columnar tables")));
+	return TM_Ok;				/* keep compiler quiet */
+}
+
+static bool
+columnar_scan_sample_next_block(TableScanDesc scan,
+								SampleScanState *scanstate)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("TABLESAMPLE is not supported on columnar tables")));
+	return false;				/* keep compiler quiet */
+}
+
+static bool
+columnar_scan_sample_next_tuple(TableScanDesc scan,
+								SampleScanState *scanstate,
+								TupleTableSlot *slot)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("TABLESAMPLE is not supported on columnar tables")));
+	return false;				/* keep compiler quiet */
+}
+
+/* ------------------------------------------------------------------------
+ * Callbacks for non-modifying operations on individual rows
+ * ------------------------------------------------------------------------
+ */
+
+static bool
+columnar_fetch_row_version(Relation relation, ItemPointer tid,
+						   Snapshot snapshot, TupleTableSlot *slot)
+{
+	return columnar_fetch_row(relation, tid, snapshot, slot);
+}
+
+static bool
+columnar_tuple_tid_valid(TableScanDesc scan, ItemPointer tid)
+{
+	ColumnarMetaPageData meta;
+
+	columnar_storage_read_meta(scan->rs_rd, &meta);
+
+	return ItemPointerIsValid(tid) &&
+		columnar_tid_to_row(tid) < meta.next_row_number;
+}
+
+static void
+columnar_get_latest_tid(TableScanDesc sscan, ItemPointer tid)
+{
+	/* Rows are never updated, so the TID is always the latest one */
+}
+
+static bool
+columnar_tuple_satisfies_snapshot(Relation rel, TupleTableSlot *slot,
+								  Snapshot snapshot)
+{
+	return columnar_row_visible(rel, columnar_tid_to_row(&slot->tts_tid),
+								snapshot);
+}
+
+/* ------------------------------------------------------------------------
+ * Functions for manipulations of physical tuples
+ * ------------------------------------------------------------------------
+ */
+
+static void
+columnar_tuple_insert(Relation relation, TupleTableSlot *slot,
+					  CommandId cid, int options, BulkInsertState bistate)
+{
+	columnar_insert_row(relation, slot, cid);
+
+	pgstat_count_heap_insert(relation, 1);
+}
+
+static void
+columnar_multi_insert(Relation relation, TupleTableSlot **slots, int ntuples,
+					  CommandId cid, int options, BulkInsertState bistate)
+{
+	for (int i = 0; i < ntuples; i++)
+		columnar_insert_row(relation, slots[i], cid);
+
+	pgstat_count_heap_insert(relation, ntuples);
+}
+
+static void
+columnar_finish_bulk_insert(Relation relation, int options)
+{
+	/* Write out what's left of the rows buffered by COPY */
+	columnar_flush_pending(relation);
+}
+
+/* ------------------------------------------------------------------------
+ * DDL related callbacks
+ * ------------------------------------------------------------------------
+ */
+
+static void
+columnar_relation_set_new_filelocator(Relation rel,
+									  const RelFileLocator *newrlocator,
+									  char persistence,
+									  TransactionId *freezeXid,
+									  MultiXactId *minmulti)
+{
+	SMgrRelation srel;
+
+	/*
+	 * Write out the rows buffered for the old storage.  It is gone for good
+	 * only if the transaction commits; if a subtransaction that this
+	 * truncation belongs to is rolled back, the old storage is used again,
+	 * and the rows buffered before must be there.
+	 */
+	columnar_flush_pending(rel);
+
+	/*
+	 * Initialize to the minimum XID that could appear in the table, like
+	 * heapam does.  There are no multixacts in columnar tables, but the
+	 * same value will do.
+	 */
+	*freezeXid = RecentXmin;
+	*minmulti = GetOldestMultiXactId();
+
+	srel = RelationCreateStorage(*newrlocator, persistence, true);
+
+	/*
+	 * If required, set up an init fork for an unlogged table so that it can
+	 * be correctly reinitialized on restart.  An empty file is a valid empty
+	 * columnar table.
+	 */
+	if (persistence == RELPERSISTENCE_UNLOGGED)
+	{
+		Assert(rel->rd_rel->relkind == RELKIND_RELATION ||
+			   rel->rd_rel->relkind == RELKIND_MATVIEW);
+		smgrcreate(srel, INIT_FORKNUM, false);
+		log_smgrcreate(newrlocator, INIT_FORKNUM);
+	}
+
+	smgrclose(srel);
+}
+
+static void
+columnar_relation_nontransactional_truncate(Relation rel)
+{
+	columnar_discard_pending(rel);
+
+	RelationTruncate(rel, 0);
+}
+
+static void
+columnar_relation_copy_data(Relation rel, const RelFileLocator *newrlocator)
+{
+	SMgrRelation dstrel;
+
+	/* Rows buffered by this transaction must be copied as well */
+	columnar_flush_pending(rel);
+
+	/*
+	 * Since we copy the file directly without looking at the shared buffers,
+	 * we'd better first flush out any pages of the source relation that are
+	 * in shared buffers.
+	 */
+	FlushRelationBuffers(rel);
+
+	dstrel = RelationCreateStorage(*newrlocator, rel->rd_rel->relpersistence,
+								   true);
+
+	/* copy main fork */
+	RelationCopyStorage(RelationGetSmgr(rel), dstrel, MAIN_FORKNUM,
+						rel->rd_rel->relpersistence);
+
+	/* copy those extra forks that exist */
+	for (ForkNumber forkNum = MAIN_FORKNUM + 1;
+		 forkNum <= MAX_FORKNUM; forkNum++)
+	{
+		if (smgrexists(RelationGetSmgr(rel), forkNum))
+		{
+			smgrcreate(dstrel, forkNum, false);
+
+			/*
+			 * WAL log creation if the relation is persistent, or this is the
+			 * init fork of an unlogged relation.
+			 */
+			if (RelationIsPermanent(rel) ||
+				(rel->rd_rel->relpersistence == RELPERSISTENCE_UNLOGGED &&
+				 forkNum == INIT_FORKNUM))
+				log_smgrcreate(newrlocator, forkNum);
+			RelationCopyStorage(RelationGetSmgr(rel), dstrel, forkNum,
+								rel->rd_rel->relpersistence);
+		}
+	}
+
+	/* drop old relation, and close new one */
+	RelationDropStorage(rel);
+	smgrclose(dstrel);
+}
+
+/*
+ * Rewrite the table for VACUUM FULL and CLUSTER.  The rows of aborted
+ * stripes are left behind, and the rows of the others are packed into new
+ * stripes, renumbering them from zero.  Stripes inserted before OldestXmin
+ * are frozen, and others keep their xmin.
+ */
+static void
+columnar_relation_copy_for_cluster(Relation OldTable, Relation NewTable,
+								   Relation OldIndex, bool use_sort,
+								   TransactionId OldestXmin,
+								   TransactionId *xid_cutoff,
+								   MultiXactId *multi_cutoff,
+								   double *num_tuples,
+								   double *tups_vacuumed,
+								   double *tups_recently_dead)
+{
+	TupleDesc	tupdesc = RelationGetDescr(OldTable);
+	int			natts = tupdesc->natts;
+	ColumnarStripe *stripes;
+	int			nstripes;
+	MemoryContext stripe_cxt;
+	MemoryContext group_cxt;
+	MemoryContext oldcxt;
+	TupleTableSlot *slot;
+	bool	   *attr_needed;
+
+	Assert(OldIndex == NULL);
+
+	*num_tuples = 0;
+	*tups_vacuumed = 0;
+	*tups_recently_dead = 0;
+
+	stripes = columnar_read_stripes(OldTable, SnapshotAny, &nstripes, NULL);
+	slot = MakeSingleTupleTableSlot(tupdesc, &TTSOpsVirtual);
+	attr_needed = palloc(sizeof(bool) * Max(natts, 1));
+	memset(attr_needed, true, sizeof(bool) * Max(natts, 1));
+
+	stripe_cxt = AllocSetContextCreate(CurrentMemoryContext,
+									   "columnar rewrite stripe",
+									   ALLOCSET_DEFAULT_SIZES);
+	group_cxt = AllocSetContextCreate(CurrentMemoryContext,
+									  "columnar rewrite chunk group",
+									  ALLOCSET_DEFAULT_SIZES);
+
+	for (int i = 0; i < nstripes; i++)
+	{
+		ColumnarStripe *stripe = &stripes[i];
+		TransactionId xmin = stripe->hdr.xmin;
+		ColumnarStripeMeta meta;
+
+		CHECK_FOR_INTERRUPTS();
+
+		/*
+		 * With the table locked exclusively, no transaction that inserted
+		 * into it can still be running, except for this one.
+		 */
+		if (!TransactionIdIsValid(xmin) ||
+			(!TransactionIdEquals(xmin, FrozenTransactionId) &&
+			 !TransactionIdIsCurrentTransactionId(xmin) &&
+			 !TransactionIdDidCommit(xmin)))
+		{
+			*tups_vacuumed += stripe->hdr.nrows;
+			continue;
+		}
+		if (TransactionIdPrecedes(xmin, OldestXmin))
+			xmin = FrozenTransactionId;
+
+		MemoryContextReset(stripe_cxt);
+		oldcxt = MemoryContextSwitchTo(stripe_cxt);
+		columnar_read_stripe_meta(OldTable, stripe, &meta, NULL);
+		MemoryContextSwitchTo(oldcxt);
+
+		for (int group = 0; group < stripe->hdr.nchunks; group++)
+		{
+			ColumnarChunkGroup cg;
+
+			MemoryContextReset(group_cxt);
+			oldcxt = MemoryContextSwitchTo(group_cxt);
+			columnar_read_chunk_group(OldTable, stripe, &meta, group,
+									  attr_needed, &cg, NULL);
+			MemoryContextSwitchTo(oldcxt);
+
+			for (int row = 0; row < cg.nrows; row++)
+			{
+				uint64		rownum = stripe->hdr.first_row +
+					(uint64) group * stripe->hdr.chunk_rows + row;
+
+				columnar_store_row(OldTable, stripe, &cg, row, rownum,
+								   attr_needed, slot);
+				columnar_rewrite_row(NewTable, slot, xmin);
+				*num_tuples += 1;
+			}
+		}
+	}
+
+	/* The new table is about to get the old one's relfilenumber */
+	columnar_flush_pending(NewTable);
+
+	ExecDropSingleTupleTableSlot(slot);
+	MemoryContextDelete(stripe_cxt);
+	MemoryContextDelete(group_cxt);
+}
+
+/*
+ * VACUUM can't reclaim space, as stripes are never moved, but it freezes
+ * stripes visible to everyone and marks those of aborted transactions, so
+ * that their xmins needn't be looked up anymore.
+ */
+static void
+columnar_relation_vacuum(Relation rel, VacuumParams *params,
+						 BufferAccessStrategy bstrategy)
+{
+	struct VacuumCutoffs cutoffs;
+	ColumnarStripe *stripes;
+	int			nstripes;
+	TransactionId frozenxid;
+	double		live_rows = 0;
+	double		dead_rows = 0;
+	bool		frozenxid_updated;
+	bool		minmulti_updated;
+
+	vacuum_get_cutoffs(rel, params, &cutoffs);
+	frozenxid = cutoffs.OldestXmin;
+
+	stripes = columnar_read_stripes(rel, SnapshotAny, &nstripes, bstrategy);
+	for (int i = 0; i < nstripes; i++)
+	{
+		ColumnarStripe *stripe = &stripes[i];
+		TransactionId xmin = stripe->hdr.xmin;
+
+		if (!TransactionIdIsValid(xmin))
+		{
+			dead_rows += stripe->hdr.nrows;
+			continue;
+		}
+		if (TransactionIdEquals(xmin, FrozenTransactionId))
+		{
+			live_rows += stripe->hdr.nrows;
+			continue;
+		}
+
+		if (TransactionIdPrecedes(xmin, cutoffs.OldestXmin))
+		{
+			if (TransactionIdDidCommit(xmin))
+			{
+				xmin = FrozenTransactionId;
+				live_rows += stripe->hdr.nrows;
+			}
+			else
+			{
+				xmin = InvalidTransactionId;
+				dead_rows += stripe->hdr.nrows;
+			}
+			columnar_storage_write(rel,
+								   stripe->offset +
+								   offsetof(ColumnarStripeHeader, xmin),
+								   (char *) &xmin, sizeof(xmin));
+		}
+		else
+		{
+			if (TransactionIdPrecedes(xmin, frozenxid))
+				frozenxid = xmin;
+			live_rows += stripe->hdr.nrows;
+		}
+	}
+
+	vac_update_relstats(rel, RelationGetNumberOfBlocks(rel), live_rows,
+						0, false, frozenxid, cutoffs.OldestMxact,
+						&frozenxid_updated, &minmulti_updated, false);
+
+	pgstat_report_vacuum(RelationGetRelid(rel), rel->rd_rel->relisshared,
+						 live_rows, dead_rows);
+}
+
+/* ------------------------------------------------------------------------
+ * Planner related callbacks
+ * ------------------------------------------------------------------------
+ */
+
+static bool
+columnar_relation_needs_toast_table(Relation rel)
+{
+	/* Values are stored in chunks, never as part of a tuple */
+	return false;
+}
+
+static void
+columnar_estimate_rel_size(Relation rel, int32 *attr_widths,
+						   BlockNumber *pages, double *tuples,
+						   double *allvisfrac)
+{
+	BlockNumber curpages;
+	BlockNumber relpages = rel->rd_rel->relpages;
+	double		reltuples = rel->rd_rel->reltuples;
+
+	/* The plan should account for the rows this backend buffered */
+	columnar_flush_pending(rel);
+
+	curpages = RelationGetNumberOfBlocks(rel);
+	*pages = curpages;
+	*allvisfrac = 0;
+
+	/*
+	 * Scale the tuple density found by the last VACUUM or ANALYZE, like
+	 * heapam does, or else use the number of rows written, including dead
+	 * ones.
+	 */
+	if (curpages == 0)
+		*tuples = 0;
+	else if (reltuples >= 0 && relpages > 0)
+		*tuples = rint(reltuples / relpages * curpages);
+	else
+	{
+		ColumnarMetaPageData meta;
+
+		columnar_storage_read_meta(rel, &meta);
+		*tuples = meta.row_count;
+	}
+}
+
+/* ------------------------------------------------------------------------
+ * Definition of the columnar table access method
+ * ------------------------------------------------------------------------
+ */
+
+static const TableAmRoutine columnar_methods = {
+	.type = T_TableAmRoutine,
+
+	.slot_callbacks = columnar_slot_callbacks,
+
+	.scan_begin = columnar_beginscan,
+	.scan_end = columnar_endscan,
+	.scan_rescan = columnar_rescan,
+	.scan_getnextslot = columnar_getnextslot,
+
+	.parallelscan_estimate = columnar_parallelscan_estimate,
+	.parallelscan_initialize = columnar_parallelscan_initialize,
+	.parallelscan_reinitialize = columnar_parallelscan_reinitialize,
+
+	.index_fetch_begin = columnar_index_fetch_begin,
+	.index_fetch_reset = columnar_index_fetch_reset,
+	.index_fetch_end = columnar_index_fetch_end,
+	.index_fetch_tuple = columnar_index_fetch_tuple,
+
+	.tuple_insert = columnar_tuple_insert,
+	.tuple_insert_speculative = columnar_tuple_insert_speculative,
+	.tuple_complete_speculative = columnar_tuple_complete_speculative,
+	.multi_insert = columnar_multi_insert,
+	.tuple_delete = columnar_tuple_delete,
+	.tuple_update = columnar_tuple_update,
+	.tuple_lock = columnar_tuple_lock,
+	.finish_bulk_insert = columnar_finish_bulk_insert,
+
+	.tuple_fetch_row_version = columnar_fetch_row_version,
+	.tuple_get_latest_tid = columnar_get_latest_tid,
+	.tuple_tid_valid = columnar_tuple_tid_valid,
+	.tuple_satisfies_snapshot = columnar_tuple_satisfies_snapshot,
+	.index_delete_tuples = columnar_index_delete_tuples,
+
+	.relation_set_new_filelocator = columnar_relation_set_new_filelocator,
+	.relation_nontransactional_truncate = columnar_relation_nontransactional_truncate,
+	.relation_copy_data = columnar_relation_copy_data,
+	.relation_copy_for_cluster = columnar_relation_copy_for_cluster,
+	.relation_vacuum = columnar_relation_vacuum,
+	.scan_analyze_next_block = columnar_scan_analyze_next_block,
+	.scan_analyze_next_tuple = columnar_scan_analyze_next_tuple,
+	.index_build_range_scan = columnar_index_build_range_scan,
+	.index_validate_scan = columnar_index_validate_scan,
+
+	.relation_size = table_block_relation_size,
+	.relation_needs_toast_table = columnar_relation_needs_toast_table,
+
+	.relation_estimate_size = columnar_estimate_rel_size,
+
+	.scan_sample_next_block = columnar_scan_sample_next_block,
+	.scan_sample_next_tuple = columnar_scan_sample_next_tuple
+};
+
+Datum
+columnar_handler(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_POINTER(&columnar_methods);
+}
+
+/*
+ * Is "rel" a columnar table?
+ */
+bool
+RelationIsColumnar(Relation rel)
+{
+	return rel->rd_tableam == &columnar_methods;
+}
+
+/*
+ * Module load callback
+ */
+void
+_PG_init(void)
+{
+	DefineCustomIntVariable("columnar.stripe_row_limit",
+							"Maximum number of rows per stripe.",
+							NULL,
+							&columnar_stripe_row_limit,
+							150000, 1000, 10000000,
+							PGC_USERSET,
+							0,
+							NULL, NULL, NULL);
+
+	DefineCustomIntVariable("columnar.chunk_group_row_limit",
+							"Maximum number of rows per chunk group.",
+							NULL,
+							&columnar_chunk_group_row_limit,
+							10000, 1000, 100000,
+							PGC_USERSET,
+							0,
+							NULL, NULL, NULL);
+
+	DefineCustomEnumVariable("columnar.compression",
+							 "Compression method for columnar chunk data.",
+							 NULL,
+							 &columnar_compression,
+							 COLUMNAR_COMPRESSION_PGLZ,
+							 compression_options,
+							 PGC_USERSET,
+							 0,
+							 NULL, NULL, NULL);
+
+	DefineCustomBoolVariable("columnar.enable_custom_scan",
+							 "Enables the planner's use of columnar scans that read only the needed columns.",
+							 NULL,
+							 &columnar_enable_custom_scan,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL, NULL, NULL);
+
+	MarkGUCPrefixReserved("columnar");
+
+	columnar_write_init();
+	columnar_customscan_init();
+}
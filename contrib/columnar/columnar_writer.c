@@ -0,0 +1,730 @@
+/*-------------------------------------------------------------------------
+ *
+ * columnar_writer.c
+ *		Buffering inserted rows and writing them out as stripes.
+ *
+ * Rows inserted into a columnar table are collected in a backend-local
+ * buffer, one per table, and written out as a stripe when the buffer is
+ * full, when the transaction commits, or when something in the same backend
+ * is about to read the table.  A stripe is visible to others once its
+ * inserting transaction commits, so a buffer only ever holds rows of one
+ * (sub)transaction.
+ *
+ * Copyright (c) 2024, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  contrib/columnar/columnar_writer.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/detoast.h"
+#include "access/relation.h"
+#include "access/tupmacs.h"
+#include "access/xact.h"
+#include "columnar.h"
+#include "common/pg_lzcompress.h"
+#include "executor/tuptable.h"
+#include "pgstat.h"
+#include "utils/datum.h"
+#include "utils/memutils.h"
+#include "utils/typcache.h"
+
+/* GUC parameters */
+int			columnar_stripe_row_limit = 150000;
+int			columnar_chunk_group_row_limit = 10000;
+int			columnar_compression = COLUMNAR_COMPRESSION_PGLZ;
+
+/* Row numbers reserved at first for a stripe, see columnar_buffer_row() */
+#define COLUMNAR_INITIAL_ROW_RESERVE	64
+
+/* Buffered rows of one table */
+typedef struct ColumnarWriteState
+{
+	Oid			relid;
+	RelFileNumber relnumber;	/* relfilenumber the rows belong to */
+	SubTransactionId subxid;	/* subtransaction that inserted the rows */
+	TransactionId xid;			/* its transaction ID */
+	MemoryContext context;		/* holds this struct */
+	MemoryContext rows_context; /* holds the buffered values */
+	TupleDesc	tupdesc;
+	int			stripe_row_limit;
+	int			chunk_rows;
+	int			compression;
+	uint64		first_row;		/* first of the reserved row numbers */
+	int			reserved;		/* number of reserved row numbers */
+	int			next_reserve;	/* how many to reserve for the next stripe */
+	int			nrows;			/* number of buffered rows */
+	int			maxrows;		/* allocated length of the arrays */
+	int			cid_start;		/* first row inserted by last_cid */
+	CommandId	prev_cid;		/* command that inserted earlier rows */
+	CommandId	last_cid;		/* command that inserted the last row */
+	Datum	  **values;			/* [column][row] */
+	bool	  **nulls;
+} ColumnarWriteState;
+
+/* How to encode the values of a column */
+typedef struct ColumnarColumnInfo
+{
+	int16		typlen;
+	bool		typbyval;
+	char		typalign;
+	bool		dropped;
+	FmgrInfo   *cmp;			/* comparison function, if min/max are kept */
+	Oid			collation;
+} ColumnarColumnInfo;
+
+/* Write states of the current transaction, in TopTransactionContext */
+static List *write_states = NIL;
+
+static ColumnarWriteState *columnar_get_write_state(Relation rel);
+static void columnar_free_write_state(ColumnarWriteState *state);
+static void columnar_buffer_row(Relation rel, TupleTableSlot *slot,
+								CommandId cid, TransactionId xid);
+static bool columnar_reserve_more_rows(ColumnarWriteState *state,
+									   Relation rel);
+static void columnar_flush_write_state(ColumnarWriteState *state,
+									   Relation rel);
+static void columnar_write_stripe(ColumnarWriteState *state, Relation rel,
+								  int from, int to, CommandId cmin);
+static void columnar_encode_chunk(ColumnarWriteState *state,
+								  ColumnarColumnInfo *ci, int att,
+								  int from, int nrows, StringInfo data,
+								  ColumnarChunkDesc *desc,
+								  StringInfo minmax);
+static void columnar_xact_callback(XactEvent event, void *arg);
+static void columnar_subxact_callback(SubXactEvent event,
+									  SubTransactionId mySubid,
+									  SubTransactionId parentSubid,
+									  void *arg);
+
+/*
+ * Find the write state for a table, creating it if needed.
+ */
+static ColumnarWriteState *
+columnar_get_write_state(Relation rel)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	SubTransactionId subxid = GetCurrentSubTransactionId();
+	ColumnarWriteState *state;
+	MemoryContext context;
+	MemoryContext oldcxt;
+
+	foreach_ptr(ColumnarWriteState, st, write_states)
+	{
+		if (st->relid != RelationGetRelid(rel))
+			continue;
+
+		/*
+		 * Rows buffered for an older relfilenumber were thrown away with it,
+		 * and rows of a different subtransaction, or rows with a different
+		 * number of columns, must go into a stripe of their own.
+		 */
+		if (st->relnumber != rel->rd_locator.relNumber)
+		{
+			write_states = list_delete_ptr(write_states, st);
+			columnar_free_write_state(st);
+			break;
+		}
+		if (st->subxid != subxid || st->tupdesc->natts != tupdesc->natts)
+		{
+			columnar_flush_write_state(st, rel);
+			write_states = list_delete_ptr(write_states, st);
+			columnar_free_write_state(st);
+			break;
+		}
+		return st;
+	}
+
+	context = AllocSetContextCreate(TopTransactionContext,
+									"columnar insert buffer",
+									ALLOCSET_DEFAULT_SIZES);
+	oldcxt = MemoryContextSwitchTo(context);
+
+	state = palloc0(sizeof(ColumnarWriteState));
+	state->relid = RelationGetRelid(rel);
+	state->relnumber = rel->rd_locator.relNumber;
+	state->subxid = subxid;
+	state->context = context;
+	state->rows_context = AllocSetContextCreate(context,
+												"columnar buffered rows",
+												ALLOCSET_DEFAULT_SIZES);
+	state->tupdesc = CreateTupleDescCopy(tupdesc);
+	state->stripe_row_limit = columnar_stripe_row_limit;
+	state->chunk_rows = Min(columnar_chunk_group_row_limit,
+							columnar_stripe_row_limit);
+	state->compression = columnar_compression;
+	state->next_reserve = Min(state->stripe_row_limit,
+							  COLUMNAR_INITIAL_ROW_RESERVE);
+	state->maxrows = Min(state->stripe_row_limit, 1024);
+	state->values = palloc(sizeof(Datum *) * tupdesc->natts);
+	state->nulls = palloc(sizeof(bool *) * tupdesc->natts);
+	for (int i = 0; i < tupdesc->natts; i++)
+	{
+		state->values[i] = palloc(sizeof(Datum) * state->maxrows);
+		state->nulls[i] = palloc(sizeof(bool) * state->maxrows);
+	}
+
+	MemoryContextSwitchTo(TopTransactionContext);
+	write_states = lappend(write_states, state);
+	MemoryContextSwitchTo(oldcxt);
+
+	return state;
+}
+
+static void
+columnar_free_write_state(ColumnarWriteState *state)
+{
+	MemoryContextDelete(state->context);
+}
+
+/*
+ * Buffer a row inserted into a columnar table, and set the slot's TID.
+ */
+void
+columnar_insert_row(Relation rel, TupleTableSlot *slot, CommandId cid)
+{
+	columnar_buffer_row(rel, slot, cid, InvalidTransactionId);
+}
+
+/*
+ * Buffer a row copied by a table rewrite, which keeps the XID that inserted
+ * it, or FrozenTransactionId.
+ */
+void
+columnar_rewrite_row(Relation rel, TupleTableSlot *slot, TransactionId xid)
+{
+	columnar_buffer_row(rel, slot, FirstCommandId, xid);
+}
+
+/*
+ * Workhorse for columnar_insert_row() and columnar_rewrite_row().  "xid" is
+ * the XID to write the row with, or InvalidTransactionId for the current
+ * one.
+ */
+static void
+columnar_buffer_row(Relation rel, TupleTableSlot *slot, CommandId cid,
+					TransactionId xid)
+{
+	ColumnarWriteState *state = columnar_get_write_state(rel);
+	TupleDesc	tupdesc = state->tupdesc;
+	MemoryContext oldcxt;
+	int			row;
+
+	if (!TransactionIdIsValid(xid))
+		xid = GetCurrentTransactionId();
+
+	/* Rows written with different XIDs go into different stripes */
+	if (state->nrows > 0 && !TransactionIdEquals(xid, state->xid))
+		columnar_flush_write_state(state, rel);
+
+	/*
+	 * The rows of a stripe have consecutive row numbers, which are reserved
+	 * as the buffer fills up: a few at first, so that small transactions
+	 * don't use up the row numbers of a whole stripe each, and then twice
+	 * as many every time they run out.  If someone else has reserved row
+	 * numbers in the meantime, the buffered rows have to go into a stripe
+	 * of their own.
+	 */
+	if (state->nrows > 0 && state->nrows == state->reserved &&
+		!columnar_reserve_more_rows(state, rel))
+		columnar_flush_write_state(state, rel);
+
+	if (state->nrows == 0)
+	{
+		state->reserved = state->next_reserve;
+		state->first_row =
+			columnar_storage_reserve_rows(rel, state->reserved);
+		state->xid = xid;
+		state->cid_start = 0;
+		state->last_cid = cid;
+	}
+	else if (cid != state->last_cid)
+	{
+		state->prev_cid = state->last_cid;
+		state->cid_start = state->nrows;
+		state->last_cid = cid;
+	}
+
+	if (state->nrows == state->maxrows)
+	{
+		state->maxrows = Min(state->maxrows * 2, state->stripe_row_limit);
+		for (int i = 0; i < tupdesc->natts; i++)
+		{
+			state->values[i] = repalloc(state->values[i],
+										sizeof(Datum) * state->maxrows);
+			state->nulls[i] = repalloc(state->nulls[i],
+									   sizeof(bool) * state->maxrows);
+		}
+	}
+
+	slot_getallattrs(slot);
+
+	row = state->nrows;
+	oldcxt = MemoryContextSwitchTo(state->rows_context);
+	for (int i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute att = TupleDescAttr(tupdesc, i);
+		Datum		value = slot->tts_values[i];
+
+		if (att->attisdropped || slot->tts_isnull[i])
+		{
+			state->values[i][row] = (Datum) 0;
+			state->nulls[i][row] = true;
+			continue;
+		}
+
+		/* Chunks hold plain values, so toasted values are expanded here */
+		if (att->attlen == -1 &&
+			VARATT_IS_EXTENDED(DatumGetPointer(value)))
+			value = PointerGetDatum(detoast_attr((struct varlena *)
+												 DatumGetPointer(value)));
+		else
+			value = datumCopy(value, att->attbyval, att->attlen);
+
+		state->values[i][row] = value;
+		state->nulls[i][row] = false;
+	}
+	MemoryContextSwitchTo(oldcxt);
+
+	state->nrows++;
+
+	columnar_row_to_tid(state->first_row + row, &slot->tts_tid);
+	slot->tts_tableOid = RelationGetRelid(rel);
+
+	if (state->nrows >= state->stripe_row_limit)
+		columnar_flush_write_state(state, rel);
+}
+
+/*
+ * Double the row numbers reserved for the buffered rows, up to the stripe
+ * row limit.  Returns false if that's not possible because others have
+ * reserved row numbers since.
+ */
+static bool
+columnar_reserve_more_rows(ColumnarWriteState *state, Relation rel)
+{
+	int			more = Min(state->reserved,
+						   state->stripe_row_limit - state->reserved);
+	uint64		end = state->first_row + state->reserved;
+
+	Assert(more > 0);
+	if (!columnar_storage_resize_rows(rel, end, end + more))
+		return false;
+
+	state->reserved += more;
+	state->next_reserve = state->reserved;
+	return true;
+}
+
+/*
+ * Write out the rows buffered for a table by this backend, so that they
+ * can be read back.
+ */
+void
+columnar_flush_pending(Relation rel)
+{
+	foreach_ptr(ColumnarWriteState, state, write_states)
+	{
+		if (state->relid == RelationGetRelid(rel))
+		{
+			if (state->relnumber == rel->rd_locator.relNumber)
+				columnar_flush_write_state(state, rel);
+			break;
+		}
+	}
+}
+
+/*
+ * Forget the rows buffered for a table, which is being truncated.
+ */
+void
+columnar_discard_pending(Relation rel)
+{
+	foreach_ptr(ColumnarWriteState, state, write_states)
+	{
+		if (state->relid == RelationGetRelid(rel))
+		{
+			write_states = list_delete_ptr(write_states, state);
+			columnar_free_write_state(state);
+			break;
+		}
+	}
+}
+
+/*
+ * Write out the buffered rows of a write state.
+ */
+static void
+columnar_flush_write_state(ColumnarWriteState *state, Relation rel)
+{
+	if (state->nrows == 0)
+		return;
+
+	/*
+	 * A stripe is visible to the inserting transaction from the command
+	 * after the one recorded as its cmin.  If the buffer holds rows of the
+	 * current command as well as older ones, write the older ones in a
+	 * stripe of their own, so that they don't disappear from view until the
+	 * next command.
+	 */
+	if (state->cid_start > 0 &&
+		state->last_cid == GetCurrentCommandId(false))
+	{
+		columnar_write_stripe(state, rel, 0, state->cid_start,
+							  state->prev_cid);
+		columnar_write_stripe(state, rel, state->cid_start, state->nrows,
+							  state->last_cid);
+	}
+	else
+		columnar_write_stripe(state, rel, 0, state->nrows, state->last_cid);
+
+	/* Give back the row numbers that weren't used, if nobody came after */
+	if (state->nrows < state->reserved)
+		(void) columnar_storage_resize_rows(rel,
+											state->first_row + state->reserved,
+											state->first_row + state->nrows);
+
+	MemoryContextReset(state->rows_context);
+	state->nrows = 0;
+	state->cid_start = 0;
+}
+
+/*
+ * Write the buffered rows in [from, to) as a stripe.
+ */
+static void
+columnar_write_stripe(ColumnarWriteState *state, Relation rel,
+					  int from, int to, CommandId cmin)
+{
+	TupleDesc	tupdesc = state->tupdesc;
+	int			natts = tupdesc->natts;
+	int			nrows = to - from;
+	int			nchunks = (nrows + state->chunk_rows - 1) / state->chunk_rows;
+	ColumnarColumnInfo *columns;
+	ColumnarChunkDesc *chunks;
+	ColumnarStripeHeader hdr;
+	StringInfoData data;
+	StringInfoData minmax;
+	MemoryContext encode_cxt;
+	MemoryContext oldcxt;
+	Size		dirlen;
+	uint64		start;
+	uint64		pos;
+
+	/* Look up everything needed before taking the append lock */
+	columns = palloc(sizeof(ColumnarColumnInfo) * natts);
+	for (int i = 0; i < natts; i++)
+	{
+		Form_pg_attribute att = TupleDescAttr(tupdesc, i);
+		ColumnarColumnInfo *ci = &columns[i];
+
+		ci->typlen = att->attlen;
+		ci->typbyval = att->attbyval;
+		ci->typalign = att->attalign;
+		ci->dropped = att->attisdropped;
+		ci->cmp = NULL;
+		ci->collation = att->attcollation;
+
+		if (!att->attisdropped)
+		{
+			TypeCacheEntry *typentry;
+
+			typentry = lookup_type_cache(att->atttypid,
+										 TYPECACHE_CMP_PROC_FINFO);
+			if (OidIsValid(typentry->cmp_proc_finfo.fn_oid))
+				ci->cmp = &typentry->cmp_proc_finfo;
+		}
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	chunks = palloc0(sizeof(ColumnarChunkDesc) * natts * nchunks);
+	dirlen = MAXALIGN(sizeof(ColumnarChunkDesc) * natts * nchunks);
+	initStringInfo(&minmax);
+
+	encode_cxt = AllocSetContextCreate(CurrentMemoryContext,
+									   "columnar chunk encoding",
+									   ALLOCSET_DEFAULT_SIZES);
+
+	start = columnar_storage_begin_append(rel);
+	pos = SizeOfColumnarStripeHeader;
+
+	/* Write the chunk data, one chunk group at a time */
+	for (int g = 0; g < nchunks; g++)
+	{
+		int			gfrom = from + g * state->chunk_rows;
+		int			gnrows = Min(state->chunk_rows, to - gfrom);
+
+		oldcxt = MemoryContextSwitchTo(encode_cxt);
+		initStringInfo(&data);
+
+		for (int i = 0; i < natts; i++)
+		{
+			ColumnarChunkDesc *desc = &chunks[g * natts + i];
+
+			desc->offset = pos + data.len;
+			columnar_encode_chunk(state, &columns[i], i, gfrom, gnrows,
+								  &data, desc, &minmax);
+		}
+
+		MemoryContextSwitchTo(oldcxt);
+
+		columnar_storage_write(rel, start + pos, data.data, data.len);
+		pos += data.len;
+		MemoryContextReset(encode_cxt);
+	}
+
+	/* Then the chunk directory, followed by the min/max values */
+	columnar_storage_write(rel, start + pos, (char *) chunks, dirlen);
+	hdr.meta_offset = pos;
+	pos += dirlen;
+
+	/*
+	 * Pad the stripe so that the next one starts MAXALIGNed.  Headers then
+	 * never straddle page boundaries in the middle of a field, and VACUUM
+	 * can update the xmin of a stripe in place.
+	 */
+	appendStringInfoSpaces(&minmax,
+						   MAXALIGN(pos + minmax.len) - (pos + minmax.len));
+	columnar_storage_write(rel, start + pos, minmax.data, minmax.len);
+	pos += minmax.len;
+
+	/* And finally the header, now that the length is known */
+	hdr.magic = COLUMNAR_STRIPE_MAGIC;
+	hdr.xmin = state->xid;
+	hdr.cmin = cmin;
+	hdr.natts = natts;
+	hdr.nchunks = nchunks;
+	hdr.chunk_rows = state->chunk_rows;
+	hdr.first_row = state->first_row + from;
+	hdr.nrows = nrows;
+	hdr.length = pos;
+	columnar_storage_write(rel, start, (char *) &hdr, sizeof(hdr));
+
+	columnar_storage_end_append(rel, start + pos, nrows);
+
+	MemoryContextDelete(encode_cxt);
+	pfree(columns);
+	pfree(chunks);
+	pfree(minmax.data);
+}
+
+/*
+ * Encode the values of column "att" in buffered rows [from, from + nrows),
+ * appending them to "data".  Fills in "desc", except for the offset, and
+ * appends the min/max values, if any, to "minmax".
+ *
+ * The chunk data is a null bitmap, if there are nulls, followed by the
+ * non-null values laid out like the elements of an array.
+ */
+static void
+columnar_encode_chunk(ColumnarWriteState *state, ColumnarColumnInfo *ci,
+					  int att, int from, int nrows, StringInfo data,
+					  ColumnarChunkDesc *desc, StringInfo minmax)
+{
+	Datum	   *values = &state->values[att][from];
+	bool	   *nulls = &state->nulls[att][from];
+	StringInfoData raw;
+	bool		has_nulls = false;
+	bool		has_minmax = false;
+	Datum		min = (Datum) 0;
+	Datum		max = (Datum) 0;
+
+	initStringInfo(&raw);
+
+	for (int i = 0; i < nrows; i++)
+	{
+		if (nulls[i])
+		{
+			has_nulls = true;
+			break;
+		}
+	}
+
+	if (has_nulls)
+	{
+		int			bitmaplen = MAXALIGN(BITMAPLEN(nrows));
+		bits8	   *bitmap;
+
+		enlargeStringInfo(&raw, bitmaplen);
+		bitmap = (bits8 *) raw.data;
+		memset(bitmap, 0, bitmaplen);
+		for (int i = 0; i < nrows; i++)
+		{
+			if (!nulls[i])
+				bitmap[i / 8] |= 1 << (i % 8);
+		}
+		raw.len = bitmaplen;
+	}
+
+	for (int i = 0; i < nrows; i++)
+	{
+		Size		start;
+		Size		size;
+
+		if (nulls[i])
+			continue;
+
+		start = att_align_nominal(raw.len, ci->typalign);
+		size = att_addlength_datum(0, ci->typlen, values[i]);
+		enlargeStringInfo(&raw, start + size - raw.len);
+		memset(raw.data + raw.len, 0, start - raw.len);
+		if (ci->typbyval)
+			store_att_byval(raw.data + start, values[i], ci->typlen);
+		else
+			memcpy(raw.data + start, DatumGetPointer(values[i]), size);
+		raw.len = start + size;
+
+		if (ci->cmp == NULL)
+			continue;
+		if (!has_minmax)
+		{
+			min = max = values[i];
+			has_minmax = true;
+		}
+		else if (DatumGetInt32(FunctionCall2Coll(ci->cmp, ci->collation,
+												 values[i], min)) < 0)
+			min = values[i];
+		else if (DatumGetInt32(FunctionCall2Coll(ci->cmp, ci->collation,
+												 values[i], max)) > 0)
+			max = values[i];
+	}
+
+	desc->raw_length = raw.len;
+	desc->has_nulls = has_nulls;
+	desc->compression = COLUMNAR_COMPRESSION_NONE;
+	desc->length = raw.len;
+
+	if (state->compression == COLUMNAR_COMPRESSION_PGLZ && raw.len > 0)
+	{
+		char	   *compressed = palloc(PGLZ_MAX_OUTPUT(raw.len));
+		int32		len;
+
+		len = pglz_compress(raw.data, raw.len, compressed,
+							PGLZ_strategy_default);
+		if (len >= 0)
+		{
+			appendBinaryStringInfo(data, compressed, len);
+			desc->compression = COLUMNAR_COMPRESSION_PGLZ;
+			desc->length = len;
+		}
+		pfree(compressed);
+	}
+	if (desc->compression == COLUMNAR_COMPRESSION_NONE)
+		appendBinaryStringInfo(data, raw.data, raw.len);
+	pfree(raw.data);
+
+	/* Keep min/max, unless they are too large to be worth it */
+	if (has_minmax)
+	{
+		Size		minlen = att_addlength_datum(0, ci->typlen, min);
+		Size		maxlen = att_addlength_datum(0, ci->typlen, max);
+		Size		offset = MAXALIGN(minmax->len);
+
+		if (minlen <= COLUMNAR_MAX_MINMAX_SIZE &&
+			maxlen <= COLUMNAR_MAX_MINMAX_SIZE)
+		{
+			enlargeStringInfo(minmax,
+							  offset + MAXALIGN(minlen) + maxlen - minmax->len);
+			memset(minmax->data + minmax->len, 0,
+				   offset + MAXALIGN(minlen) + maxlen - minmax->len);
+			if (ci->typbyval)
+			{
+				store_att_byval(minmax->data + offset, min, ci->typlen);
+				store_att_byval(minmax->data + offset + MAXALIGN(minlen), max,
+								ci->typlen);
+			}
+			else
+			{
+				memcpy(minmax->data + offset, DatumGetPointer(min), minlen);
+				memcpy(minmax->data + offset + MAXALIGN(minlen),
+					   DatumGetPointer(max), maxlen);
+			}
+			minmax->len = offset + MAXALIGN(minlen) + maxlen;
+
+			desc->minmax_offset = offset;
+			desc->min_length = minlen;
+			desc->max_length = maxlen;
+		}
+	}
+}
+
+/*
+ * Transaction callbacks: buffered rows are written out before commit, and
+ * forgotten on abort.
+ */
+static void
+columnar_xact_callback(XactEvent event, void *arg)
+{
+	switch (event)
+	{
+		case XACT_EVENT_PRE_COMMIT:
+		case XACT_EVENT_PRE_PREPARE:
+			foreach_ptr(ColumnarWriteState, state, write_states)
+			{
+				Relation	rel;
+
+				/* The table may have been dropped since */
+				rel = try_relation_open(state->relid, NoLock);
+				if (rel == NULL)
+					continue;
+				if (state->relnumber == rel->rd_locator.relNumber)
+					columnar_flush_write_state(state, rel);
+				relation_close(rel, NoLock);
+			}
+			break;
+
+		case XACT_EVENT_COMMIT:
+		case XACT_EVENT_ABORT:
+		case XACT_EVENT_PREPARE:
+			/* The memory goes away with TopTransactionContext */
+			write_states = NIL;
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void
+columnar_subxact_callback(SubXactEvent event, SubTransactionId mySubid,
+						  SubTransactionId parentSubid, void *arg)
+{
+	switch (event)
+	{
+		case SUBXACT_EVENT_COMMIT_SUB:
+
+			/*
+			 * The rows now belong to the parent, and keep the XID of the
+			 * subtransaction, which commits or aborts along with it.
+			 */
+			foreach_ptr(ColumnarWriteState, state, write_states)
+			{
+				if (state->subxid == mySubid)
+					state->subxid = parentSubid;
+			}
+			break;
+
+		case SUBXACT_EVENT_ABORT_SUB:
+			foreach_ptr(ColumnarWriteState, state, write_states)
+			{
+				if (state->subxid == mySubid)
+				{
+					write_states = foreach_delete_current(write_states, state);
+					columnar_free_write_state(state);
+				}
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+void
+columnar_write_init(void)
+{
+	RegisterXactCallback(columnar_xact_callback, NULL);
+	RegisterSubXactCallback(columnar_subxact_callback, NULL);
+}
@@ -0,0 +1,102 @@
+CREATE EXTENSION columnar;
+
+SET columnar.stripe_row_limit = 10000;
+SET columnar.chunk_group_row_limit = 1000;
+
+CREATE TABLE columnar_test (a int, b text, c float8) USING columnar;
+INSERT INTO columnar_test
+  SELECT g, 'row ' || g, g / 2.0 FROM generate_series(1, 25000) g;
+
+SELECT count(*), sum(a), min(b), max(c) FROM columnar_test;
+
+-- rows get consecutive row numbers
+SELECT ctid, a FROM columnar_test WHERE a IN (1, 291, 292, 10001, 25000)
+  ORDER BY a;
+
+-- only the referenced columns are read, and chunk groups are skipped by
+-- their min/max values
+EXPLAIN (COSTS OFF) SELECT a FROM columnar_test WHERE a > 24000;
+EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF)
+  SELECT a FROM columnar_test WHERE a > 24000;
+SELECT count(*), min(a) FROM columnar_test WHERE a > 24000;
+SELECT b FROM columnar_test WHERE b = 'row 12345';
+
+SET columnar.enable_custom_scan = off;
+EXPLAIN (COSTS OFF) SELECT a FROM columnar_test WHERE a > 24000;
+SELECT count(*), min(a) FROM columnar_test WHERE a > 24000;
+RESET columnar.enable_custom_scan;
+
+-- columns added later
+ALTER TABLE columnar_test ADD COLUMN d int DEFAULT 7;
+INSERT INTO columnar_test VALUES (25001, NULL, NULL, NULL);
+SELECT * FROM columnar_test WHERE a <= 3 OR a >= 25000 ORDER BY a;
+
+-- rolled back rows are not visible
+BEGIN;
+INSERT INTO columnar_test (a) SELECT generate_series(30001, 30010);
+SELECT count(*) FROM columnar_test WHERE a > 30000;
+ROLLBACK;
+SELECT count(*) FROM columnar_test WHERE a > 30000;
+
+BEGIN;
+INSERT INTO columnar_test (a) VALUES (40001);
+SAVEPOINT s1;
+INSERT INTO columnar_test (a) VALUES (40002);
+ROLLBACK TO s1;
+INSERT INTO columnar_test (a) VALUES (40003);
+COMMIT;
+SELECT a FROM columnar_test WHERE a > 40000 ORDER BY a;
+
+-- rows buffered before a truncation that is rolled back survive, and small
+-- transactions only use up the row numbers they need
+CREATE TABLE columnar_trunc (a int) USING columnar;
+BEGIN;
+INSERT INTO columnar_trunc VALUES (1), (2);
+SAVEPOINT s1;
+TRUNCATE columnar_trunc;
+INSERT INTO columnar_trunc VALUES (3);
+ROLLBACK TO s1;
+INSERT INTO columnar_trunc VALUES (4);
+COMMIT;
+INSERT INTO columnar_trunc VALUES (5);
+INSERT INTO columnar_trunc VALUES (6);
+SELECT ctid, a FROM columnar_trunc ORDER BY a;
+DROP TABLE columnar_trunc;
+
+-- unsupported operations
+UPDATE columnar_test SET b = 'x' WHERE a = 1;
+DELETE FROM columnar_test WHERE a = 1;
+SELECT a FROM columnar_test WHERE a = 1 FOR UPDATE;
+CREATE INDEX ON columnar_test (a);
+
+-- parallel scan
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT count(*), sum(a) FROM columnar_test;
+SELECT count(*), sum(a) FROM columnar_test;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+
+-- VACUUM removes the rolled back rows from the statistics, VACUUM FULL
+-- from the table
+VACUUM columnar_test;
+SELECT reltuples FROM pg_class WHERE relname = 'columnar_test';
+VACUUM FULL columnar_test;
+SELECT count(*), sum(a) FROM columnar_test;
+ANALYZE columnar_test;
+SELECT reltuples FROM pg_class WHERE relname = 'columnar_test';
+
+TRUNCATE columnar_test;
+SELECT count(*) FROM columnar_test;
+
+COPY columnar_test (a, b) FROM stdin;
+1	one
+2	two
+\.
+SELECT * FROM columnar_test ORDER BY a;
+
+DROP TABLE columnar_test;
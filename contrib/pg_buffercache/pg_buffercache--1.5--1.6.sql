@@ -0,0 +1,19 @@
+/* contrib/pg_buffercache/pg_buffercache--1.5--1.6.sql */
+
+-- complain if script is sourced in psql, rather than via ALTER EXTENSION
+\echo Use "ALTER EXTENSION pg_buffercache UPDATE TO '1.6'" to load this file. \quit
+
+CREATE FUNCTION pg_buffercache_partitions(
+    OUT partition int4,
+    OUT first_buffer int4,
+    OUT last_buffer int4,
+    OUT next_victim_buffer int4,
+    OUT complete_passes int8,
+    OUT buffer_allocs int8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_buffercache_partitions'
+LANGUAGE C PARALLEL SAFE;
+
+-- Don't want this to be available to public.
+REVOKE ALL ON FUNCTION pg_buffercache_partitions() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_buffercache_partitions() TO pg_monitor;
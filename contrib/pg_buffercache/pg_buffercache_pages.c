@@ -19,6 +19,7 @@
 #define NUM_BUFFERCACHE_PAGES_ELEM	9
 #define NUM_BUFFERCACHE_SUMMARY_ELEM 5
 #define NUM_BUFFERCACHE_USAGE_COUNTS_ELEM 4
+#define NUM_BUFFERCACHE_PARTITIONS_ELEM 6
 
 PG_MODULE_MAGIC;
 
@@ -63,6 +64,7 @@ typedef struct
 PG_FUNCTION_INFO_V1(pg_buffercache_pages);
 PG_FUNCTION_INFO_V1(pg_buffercache_summary);
 PG_FUNCTION_INFO_V1(pg_buffercache_usage_counts);
+PG_FUNCTION_INFO_V1(pg_buffercache_partitions);
 PG_FUNCTION_INFO_V1(pg_buffercache_evict);
 
 Datum
@@ -349,6 +351,46 @@ pg_buffercache_usage_counts(PG_FUNCTION_ARGS)
 	return (Datum) 0;
 }
 
+/*
+ * Report the state of each clock sweep partition.
+ */
+Datum
+pg_buffercache_partitions(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	Datum		values[NUM_BUFFERCACHE_PARTITIONS_ELEM];
+	bool		nulls[NUM_BUFFERCACHE_PARTITIONS_ELEM] = {0};
+	int			nparts;
+
+	InitMaterializedSRF(fcinfo, 0);
+
+	nparts = StrategyNumPartitions();
+	for (int i = 0; i < nparts; i++)
+	{
+		int			first_buffer;
+		int			num_buffers;
+		uint32		complete_passes;
+		uint32		next_victim_buffer;
+		uint64		buffer_allocs;
+
+		StrategyGetPartitionStats(i, &first_buffer, &num_buffers,
+								  &complete_passes, &next_victim_buffer,
+								  &buffer_allocs);
+
+		/* report buffer IDs the same way as pg_buffercache_pages() */
+		values[0] = Int32GetDatum(i);
+		values[1] = Int32GetDatum(first_buffer + 1);
+		values[2] = Int32GetDatum(first_buffer + num_buffers);
+		values[3] = Int32GetDatum(next_victim_buffer + 1);
+		values[4] = Int64GetDatum((int64) complete_passes);
+		values[5] = Int64GetDatum((int64) buffer_allocs);
+
+		tuplestore_putvalues(rsinfo->setResult, rsinfo->setDesc, values, nulls);
+	}
+
+	return (Datum) 0;
+}
+
 /*
  * Try to evict a shared buffer.
  */
@@ -12,6 +12,14 @@ from pg_buffercache_summary();
 
 SELECT count(*) > 0 FROM pg_buffercache_usage_counts() WHERE buffers >= 0;
 
+-- The partitions cover all of shared_buffers.
+SELECT min(first_buffer) = 1,
+       sum(last_buffer - first_buffer + 1) = (select setting::bigint
+                                              from pg_settings
+                                              where name = 'shared_buffers'),
+       bool_and(next_victim_buffer between first_buffer and last_buffer)
+FROM pg_buffercache_partitions();
+
 -- Check that the functions / views can't be accessed by default. To avoid
 -- having to create a dedicated user, use the pg_database_owner pseudo-role.
 SET ROLE pg_database_owner;
@@ -19,6 +27,7 @@ SELECT * FROM pg_buffercache;
 SELECT * FROM pg_buffercache_pages() AS p (wrong int);
 SELECT * FROM pg_buffercache_summary();
 SELECT * FROM pg_buffercache_usage_counts();
+SELECT * FROM pg_buffercache_partitions();
 RESET role;
 
 -- Check that pg_monitor is allowed to query view / function
@@ -26,3 +35,4 @@ SET ROLE pg_monitor;
 SELECT count(*) > 0 FROM pg_buffercache;
 SELECT buffers_used + buffers_unused > 0 FROM pg_buffercache_summary();
 SELECT count(*) > 0 FROM pg_buffercache_usage_counts();
+SELECT count(*) > 0 FROM pg_buffercache_partitions();
@@ -0,0 +1,51 @@
+-- predictability
+SET synchronous_commit = on;
+
+SELECT 'init' FROM pg_create_logical_replication_slot('regression_slot', 'test_decoding');
+
+CREATE TABLE spill_compression_test(data text);
+
+-- spilling main xact and subxact
+BEGIN;
+INSERT INTO spill_compression_test SELECT 'serialize-compressed--1:'||g.i||':'||repeat('x', 100) FROM generate_series(1, 5000) g(i);
+SAVEPOINT s;
+INSERT INTO spill_compression_test SELECT 'serialize-compressed--2:'||g.i||':'||repeat('x', 100) FROM generate_series(1, 5000) g(i);
+RELEASE SAVEPOINT s;
+INSERT INTO spill_compression_test SELECT 'serialize-compressed--3:'||g.i||':'||repeat('x', 100) FROM generate_series(1, 5000) g(i);
+COMMIT;
+
+-- Decode the transaction with each compression method.  Methods the server
+-- was built without can't be set, and the changes are then spilled
+-- uncompressed, so only expect them to be compressed with the others.
+SELECT 'lz4' = ANY(enumvals) AS have_lz4, 'zstd' = ANY(enumvals) AS have_zstd
+FROM pg_settings WHERE name = 'logical_decoding_spill_compression' \gset
+
+\if :have_lz4
+SET logical_decoding_spill_compression = lz4;
+\endif
+SELECT (regexp_split_to_array(data, ':'))[4], COUNT(*), bool_and(data ~ ':x{100}''$') AS intact
+FROM pg_logical_slot_peek_changes('regression_slot', NULL,NULL) WHERE data ~ 'INSERT'
+GROUP BY 1 ORDER BY 1;
+SELECT pg_stat_force_next_flush();
+SELECT spill_txns > 0 AS spill_txns,
+    (spill_written_bytes < spill_bytes / 2) = :'have_lz4' AS compressed_if_available
+FROM pg_stat_replication_slots WHERE slot_name = 'regression_slot';
+RESET logical_decoding_spill_compression;
+
+SELECT pg_stat_reset_replication_slot('regression_slot');
+
+\if :have_zstd
+SET logical_decoding_spill_compression = zstd;
+\endif
+SELECT (regexp_split_to_array(data, ':'))[4], COUNT(*), bool_and(data ~ ':x{100}''$') AS intact
+FROM pg_logical_slot_get_changes('regression_slot', NULL,NULL) WHERE data ~ 'INSERT'
+GROUP BY 1 ORDER BY 1;
+SELECT pg_stat_force_next_flush();
+SELECT spill_txns > 0 AS spill_txns,
+    (spill_written_bytes < spill_bytes / 2) = :'have_zstd' AS compressed_if_available
+FROM pg_stat_replication_slots WHERE slot_name = 'regression_slot';
+RESET logical_decoding_spill_compression;
+
+DROP TABLE spill_compression_test;
+
+SELECT pg_drop_replication_slot('regression_slot');
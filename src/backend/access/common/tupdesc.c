@@ -96,6 +96,7 @@ CreateTemplateTupleDesc(int natts)
 	desc->tdtypeid = RECORDOID;
 	desc->tdtypmod = -1;
 	desc->tdrefcount = -1;		/* assume not reference-counted */
+	desc->tdfixedprefix = -1;
 
 	return desc;
 }
@@ -276,6 +277,7 @@ TupleDescCopy(TupleDesc dst, TupleDesc src)
 	 * source's refcount would be wrong in any case.)
 	 */
 	dst->tdrefcount = -1;
+	dst->tdfixedprefix = -1;
 }
 
 /*
@@ -315,6 +317,7 @@ TupleDescCopyEntry(TupleDesc dst, AttrNumber dstAttno,
 	 */
 	dstAtt->attnum = dstAttno;
 	dstAtt->attcacheoff = -1;
+	dst->tdfixedprefix = -1;
 
 	/* since we're not copying constraints or defaults, clear these */
 	dstAtt->attnotnull = false;
@@ -412,6 +415,40 @@ DecrTupleDescRefCount(TupleDesc tupdesc)
 		FreeTupleDesc(tupdesc);
 }
 
+/*
+ * TupleDescComputeFixedPrefix
+ *		Count the leading fixed-width attributes of a tupdesc, and fill in
+ *		their attcacheoff.
+ *
+ * Tuple deforming uses this to fetch those attributes directly from their
+ * cached offsets when none of them is null.  The offsets are the same as
+ * the ones the deforming code would cache as it walks the attributes, so
+ * it doesn't matter which gets there first.  The result is remembered in
+ * the tupdesc.
+ */
+int
+TupleDescComputeFixedPrefix(TupleDesc tupdesc)
+{
+	uint32		off = 0;
+	int			i;
+
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute att = TupleDescAttr(tupdesc, i);
+
+		if (att->attlen <= 0)
+			break;
+
+		off = att_align_nominal(off, att->attalign);
+		att->attcacheoff = off;
+		off += att->attlen;
+	}
+
+	tupdesc->tdfixedprefix = i;
+
+	return i;
+}
+
 /*
  * Compare two TupleDesc structures for logical equality
  */
@@ -686,6 +723,7 @@ TupleDescInitEntry(TupleDesc desc,
 		namestrcpy(&(att->attname), attributeName);
 
 	att->attcacheoff = -1;
+	desc->tdfixedprefix = -1;
 	att->atttypmod = typmod;
 
 	att->attnum = attributeNumber;
@@ -748,6 +786,7 @@ TupleDescInitBuiltinEntry(TupleDesc desc,
 	namestrcpy(&(att->attname), attributeName);
 
 	att->attcacheoff = -1;
+	desc->tdfixedprefix = -1;
 	att->atttypmod = typmod;
 
 	att->attnum = attributeNumber;
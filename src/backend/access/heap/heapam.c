@@ -55,6 +55,7 @@
 #include "catalog/pg_database_d.h"
 #include "commands/vacuum.h"
 #include "miscadmin.h"
+#include "nodes/tidbitmap.h"
 #include "pgstat.h"
 #include "port/atomics.h"
 #include "port/pg_bitutils.h"
@@ -297,6 +298,77 @@ heap_scan_stream_read_next_serial(ReadStream *stream,
 	return scan->rs_prefetch_block;
 }
 
+/*
+ * Streaming read API callback for bitmap heap scans.  Returns the next block
+ * in the bitmap that needs to be read, or InvalidBlockNumber when the bitmap
+ * is exhausted.  The iterator result for the block is copied into
+ * per_buffer_data, so that it is still available once the read stream hands
+ * out the corresponding buffer.
+ */
+static BlockNumber
+bitmapheap_stream_read_next(ReadStream *stream,
+							void *callback_private_data,
+							void *per_buffer_data)
+{
+	HeapScanDesc scan = (HeapScanDesc) callback_private_data;
+	TableScanDesc sscan = &scan->rs_base;
+	TBMIterateResult *result = (TBMIterateResult *) per_buffer_data;
+
+	for (;;)
+	{
+		TBMIterateResult *tbmres;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (sscan->rs_shared_tbmiterator)
+			tbmres = tbm_shared_iterate(sscan->rs_shared_tbmiterator);
+		else
+			tbmres = tbm_iterate(sscan->rs_tbmiterator);
+
+		/* no more entries in the bitmap */
+		if (tbmres == NULL)
+			return InvalidBlockNumber;
+
+		/*
+		 * Ignore any claimed entries past what we think is the end of the
+		 * relation. It may have been extended after the start of our scan (we
+		 * only hold an AccessShareLock, and it could be inserts from this
+		 * backend).  We don't take this optimization in SERIALIZABLE
+		 * isolation though, as we need to examine all invisible tuples
+		 * reachable by the index.
+		 */
+		if (!IsolationIsSerializable() && tbmres->blockno >= scan->rs_nblocks)
+			continue;
+
+		/*
+		 * We can skip fetching the heap page if we don't need any fields from
+		 * the heap, the bitmap entries don't need rechecking, and all tuples
+		 * on the page are visible to our transaction.
+		 */
+		if (!(sscan->rs_flags & SO_NEED_TUPLES) &&
+			!tbmres->recheck &&
+			VM_ALL_VISIBLE(sscan->rs_rd, tbmres->blockno, &scan->rs_vmbuffer))
+		{
+			/* can't be lossy in the skip_fetch case */
+			Assert(tbmres->ntuples >= 0);
+			Assert(scan->rs_empty_tuples_pending >= 0);
+
+			scan->rs_empty_tuples_pending += tbmres->ntuples;
+			continue;
+		}
+
+		/*
+		 * The iterator's result is overwritten by the next call, so save a
+		 * copy.  Lossy pages have no offsets.
+		 */
+		memcpy(result, tbmres,
+			   offsetof(TBMIterateResult, offsets) +
+			   sizeof(OffsetNumber) * Max(tbmres->ntuples, 0));
+
+		return tbmres->blockno;
+	}
+}
+
 /* ----------------
  *		initscan - scan code common to heap_beginscan and heap_rescan
  * ----------------
@@ -408,6 +480,10 @@ initscan(HeapScanDesc scan, ScanKey key, bool keep_startblock)
 
 	/* page-at-a-time fields are always invalid when not rs_inited */
 
+	/* ... but bitmap scans rely on them to notice the need for a new page */
+	scan->rs_cindex = 0;
+	scan->rs_ntuples = 0;
+
 	/*
 	 * copy the scan key, if appropriate
 	 */
@@ -1072,6 +1148,8 @@ heap_beginscan(Relation relation, Snapshot snapshot,
 	scan->rs_base.rs_nkeys = nkeys;
 	scan->rs_base.rs_flags = flags;
 	scan->rs_base.rs_parallel = parallel_scan;
+	scan->rs_base.rs_tbmiterator = NULL;
+	scan->rs_base.rs_shared_tbmiterator = NULL;
 	scan->rs_strategy = NULL;	/* set in initscan */
 	scan->rs_vmbuffer = InvalidBuffer;
 	scan->rs_empty_tuples_pending = 0;
@@ -1154,7 +1232,24 @@ heap_beginscan(Relation relation, Snapshot snapshot,
 														  scan,
 														  0);
 	}
-
+	else if (scan->rs_base.rs_flags & SO_TYPE_BITMAPSCAN)
+	{
+		/*
+		 * Bitmap heap scans read the blocks handed out by the bitmap
+		 * iterator, which the executor installs before fetching the first
+		 * tuple.  Each block carries a copy of its iterator result, which
+		 * needs room for the offsets of a full page.  Round that up so that
+		 * every element of the per-buffer data array stays aligned.
+		 */
+		scan->rs_read_stream = read_stream_begin_relation(READ_STREAM_DEFAULT,
+														  scan->rs_strategy,
+														  scan->rs_base.rs_rd,
+														  MAIN_FORKNUM,
+														  bitmapheap_stream_read_next,
+														  scan,
+														  MAXALIGN(offsetof(TBMIterateResult, offsets) +
+																   sizeof(OffsetNumber) * MaxHeapTuplesPerPage));
+	}
 
 	return (TableScanDesc) scan;
 }
@@ -2195,15 +2290,12 @@ heap_prepare_insert(Relation relation, HeapTuple tup, TransactionId xid,
 					CommandId cid, int options)
 {
 	/*
-	 * To allow parallel inserts, we need to ensure that they are safe to be
-	 * performed in workers. We have the infrastructure to allow parallel
-	 * inserts in general except for the cases where inserts generate a new
-	 * CommandId (eg. inserts into a table having a foreign key column).
+	 * Parallel workers may insert tuples, as in a parallel COPY FROM, as long
+	 * as the inserts don't generate a new CommandId (eg. inserts into a table
+	 * having a foreign key column).  The leader must have marked the command
+	 * ID as used before starting the workers, which GetCurrentCommandId()
+	 * checks for.
 	 */
-	if (IsParallelWorker())
-		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_TRANSACTION_STATE),
-				 errmsg("cannot insert tuples in a parallel worker")));
 
 	tup->t_data->t_infomask &= ~(HEAP_XACT_MASK);
 	tup->t_data->t_infomask2 &= ~(HEAP2_XACT_MASK);
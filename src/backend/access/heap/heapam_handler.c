@@ -83,6 +83,9 @@ heapam_index_fetch_begin(Relation rel)
 
 	hscan->xs_base.rel = rel;
 	hscan->xs_cbuf = InvalidBuffer;
+	hscan->xs_read_stream = NULL;
+	hscan->xs_nblocks = 0;
+	hscan->xs_prefetch_block = InvalidBlockNumber;
 
 	return &hscan->xs_base;
 }
@@ -97,6 +100,12 @@ heapam_index_fetch_reset(IndexFetchTableData *scan)
 		ReleaseBuffer(hscan->xs_cbuf);
 		hscan->xs_cbuf = InvalidBuffer;
 	}
+
+	/* The index AM forgets what it has reported when it's reset, too. */
+	if (hscan->xs_read_stream)
+		read_stream_reset(hscan->xs_read_stream);
+	hscan->xs_nblocks = 0;
+	hscan->xs_prefetch_block = InvalidBlockNumber;
 }
 
 static void
@@ -106,9 +115,91 @@ heapam_index_fetch_end(IndexFetchTableData *scan)
 
 	heapam_index_fetch_reset(scan);
 
+	if (hscan->xs_read_stream)
+		read_stream_end(hscan->xs_read_stream);
+
 	pfree(hscan);
 }
 
+/*
+ * Read stream callback for index fetches.  Returns the heap blocks of the
+ * TIDs that the index scan says it will return next, skipping consecutive
+ * repeats of the same block, which heapam_index_fetch_tuple() doesn't need
+ * a new buffer for.
+ *
+ * When the index AM doesn't know any more TIDs yet, typically because it
+ * hasn't read the next index page, the stream ends.  It is reset when the
+ * next block is needed, at which point the index AM can tell us more.
+ */
+static BlockNumber
+heapam_index_fetch_stream_read_next(ReadStream *stream,
+									void *callback_private_data,
+									void *per_buffer_data)
+{
+	IndexFetchHeapData *hscan = (IndexFetchHeapData *) callback_private_data;
+	ItemPointerData tid;
+
+	while (hscan->xs_base.prefetch_next(hscan->xs_base.prefetch_arg, &tid))
+	{
+		BlockNumber blkno = ItemPointerGetBlockNumber(&tid);
+
+		if (blkno != hscan->xs_prefetch_block)
+		{
+			hscan->xs_prefetch_block = blkno;
+			return blkno;
+		}
+	}
+
+	return InvalidBlockNumber;
+}
+
+/*
+ * Get a pinned buffer for heap block blkno, which an index scan needs next.
+ */
+static Buffer
+heapam_index_fetch_buffer(IndexFetchHeapData *hscan, BlockNumber blkno)
+{
+	Buffer		buf;
+
+	if (hscan->xs_base.prefetch_next == NULL || ++hscan->xs_nblocks < 2)
+		return ReadBuffer(hscan->xs_base.rel, blkno);
+
+	if (hscan->xs_read_stream == NULL)
+		hscan->xs_read_stream =
+			read_stream_begin_relation(READ_STREAM_DEFAULT,
+									   NULL,
+									   hscan->xs_base.rel,
+									   MAIN_FORKNUM,
+									   heapam_index_fetch_stream_read_next,
+									   hscan,
+									   0);
+
+	buf = read_stream_next_buffer(hscan->xs_read_stream, NULL);
+	if (!BufferIsValid(buf))
+	{
+		read_stream_reset(hscan->xs_read_stream);
+		buf = read_stream_next_buffer(hscan->xs_read_stream, NULL);
+	}
+
+	if (BufferIsValid(buf))
+	{
+		if (BufferGetBlockNumber(buf) == blkno)
+			return buf;
+		ReleaseBuffer(buf);
+	}
+
+	/*
+	 * We're out of step with the index AM, which can happen if the scan
+	 * changed direction or was restored to a marked position.  Give up on
+	 * reading ahead for the rest of this scan.
+	 */
+	read_stream_end(hscan->xs_read_stream);
+	hscan->xs_read_stream = NULL;
+	hscan->xs_base.prefetch_next = NULL;
+
+	return ReadBuffer(hscan->xs_base.rel, blkno);
+}
+
 static bool
 heapam_index_fetch_tuple(struct IndexFetchTableData *scan,
 						 ItemPointer tid,
@@ -126,17 +217,20 @@ heapam_index_fetch_tuple(struct IndexFetchTableData *scan,
 	if (!*call_again)
 	{
 		/* Switch to correct buffer if we don't have it already */
-		Buffer		prev_buf = hscan->xs_cbuf;
+		BlockNumber blkno = ItemPointerGetBlockNumber(tid);
 
-		hscan->xs_cbuf = ReleaseAndReadBuffer(hscan->xs_cbuf,
-											  hscan->xs_base.rel,
-											  ItemPointerGetBlockNumber(tid));
+		if (!BufferIsValid(hscan->xs_cbuf) ||
+			BufferGetBlockNumber(hscan->xs_cbuf) != blkno)
+		{
+			if (BufferIsValid(hscan->xs_cbuf))
+				ReleaseBuffer(hscan->xs_cbuf);
+			hscan->xs_cbuf = heapam_index_fetch_buffer(hscan, blkno);
 
-		/*
-		 * Prune page, but only if we weren't already on this page
-		 */
-		if (prev_buf != hscan->xs_cbuf)
+			/*
+			 * Prune page, but only if we weren't already on this page
+			 */
 			heap_page_prune_opt(hscan->xs_base.rel, hscan->xs_cbuf);
+		}
 	}
 
 	/* Obtain share-lock on the buffer so we can examine visibility */
@@ -2118,57 +2212,63 @@ heapam_estimate_rel_size(Relation rel, int32 *attr_widths,
  * ------------------------------------------------------------------------
  */
 
+/*
+ * Helper for heapam_scan_bitmap_next_tuple(): pull the next block of a bitmap
+ * heap scan out of the read stream and collect the offsets of its visible
+ * tuples.  Returns false once the stream is exhausted.
+ */
 static bool
 heapam_scan_bitmap_next_block(TableScanDesc scan,
-							  TBMIterateResult *tbmres)
+							  bool *recheck,
+							  uint64 *lossy_pages,
+							  uint64 *exact_pages)
 {
 	HeapScanDesc hscan = (HeapScanDesc) scan;
-	BlockNumber block = tbmres->blockno;
+	TBMIterateResult *tbmres;
+	void	   *per_buffer_data;
+	BlockNumber block;
 	Buffer		buffer;
 	Snapshot	snapshot;
 	int			ntup;
 
+	Assert(scan->rs_flags & SO_TYPE_BITMAPSCAN);
+	Assert(hscan->rs_read_stream);
+
 	hscan->rs_cindex = 0;
 	hscan->rs_ntuples = 0;
 
-	/*
-	 * We can skip fetching the heap page if we don't need any fields from the
-	 * heap, the bitmap entries don't need rechecking, and all tuples on the
-	 * page are visible to our transaction.
-	 */
-	if (!(scan->rs_flags & SO_NEED_TUPLES) &&
-		!tbmres->recheck &&
-		VM_ALL_VISIBLE(scan->rs_rd, tbmres->blockno, &hscan->rs_vmbuffer))
+	/* Release buffer containing previous block. */
+	if (BufferIsValid(hscan->rs_cbuf))
 	{
-		/* can't be lossy in the skip_fetch case */
-		Assert(tbmres->ntuples >= 0);
-		Assert(hscan->rs_empty_tuples_pending >= 0);
-
-		hscan->rs_empty_tuples_pending += tbmres->ntuples;
-
-		return true;
+		ReleaseBuffer(hscan->rs_cbuf);
+		hscan->rs_cbuf = InvalidBuffer;
 	}
 
 	/*
-	 * Ignore any claimed entries past what we think is the end of the
-	 * relation. It may have been extended after the start of our scan (we
-	 * only hold an AccessShareLock, and it could be inserts from this
-	 * backend).  We don't take this optimization in SERIALIZABLE isolation
-	 * though, as we need to examine all invisible tuples reachable by the
-	 * index.
+	 * The read stream's callback has already skipped blocks past the end of
+	 * the relation and blocks that need not be fetched at all.
 	 */
-	if (!IsolationIsSerializable() && block >= hscan->rs_nblocks)
+	hscan->rs_cbuf = read_stream_next_buffer(hscan->rs_read_stream,
+											 &per_buffer_data);
+	if (!BufferIsValid(hscan->rs_cbuf))
+	{
+		/* The bitmap is exhausted. */
+		if (BufferIsValid(hscan->rs_vmbuffer))
+		{
+			ReleaseBuffer(hscan->rs_vmbuffer);
+			hscan->rs_vmbuffer = InvalidBuffer;
+		}
 		return false;
+	}
+
+	tbmres = (TBMIterateResult *) per_buffer_data;
+	block = tbmres->blockno;
+	Assert(BufferGetBlockNumber(hscan->rs_cbuf) == block);
 
-	/*
-	 * Acquire pin on the target heap page, trading in any pin we held before.
-	 */
-	hscan->rs_cbuf = ReleaseAndReadBuffer(hscan->rs_cbuf,
-										  scan->rs_rd,
-										  block);
 	hscan->rs_cblock = block;
 	buffer = hscan->rs_cbuf;
 	snapshot = scan->rs_snapshot;
+	*recheck = tbmres->recheck;
 
 	ntup = 0;
 
@@ -2207,6 +2307,8 @@ heapam_scan_bitmap_next_block(TableScanDesc scan,
 									   &heapTuple, NULL, true))
 				hscan->rs_vistuples[ntup++] = ItemPointerGetOffsetNumber(&tid);
 		}
+
+		(*exact_pages)++;
 	}
 	else
 	{
@@ -2241,6 +2343,8 @@ heapam_scan_bitmap_next_block(TableScanDesc scan,
 			HeapCheckForSerializableConflictOut(valid, scan->rs_rd, &loctup,
 												buffer, snapshot);
 		}
+
+		(*lossy_pages)++;
 	}
 
 	LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
@@ -2248,34 +2352,50 @@ heapam_scan_bitmap_next_block(TableScanDesc scan,
 	Assert(ntup <= MaxHeapTuplesPerPage);
 	hscan->rs_ntuples = ntup;
 
-	return ntup > 0;
+	/*
+	 * Return true even if no tuple on this page is visible; the caller will
+	 * just move on to the next block.
+	 */
+	return true;
 }
 
 static bool
 heapam_scan_bitmap_next_tuple(TableScanDesc scan,
-							  TBMIterateResult *tbmres,
-							  TupleTableSlot *slot)
+							  TupleTableSlot *slot,
+							  bool *recheck,
+							  uint64 *lossy_pages,
+							  uint64 *exact_pages)
 {
 	HeapScanDesc hscan = (HeapScanDesc) scan;
 	OffsetNumber targoffset;
 	Page		page;
 	ItemId		lp;
 
-	if (hscan->rs_empty_tuples_pending > 0)
-	{
-		/*
-		 * If we don't have to fetch the tuple, just return nulls.
-		 */
-		ExecStoreAllNullTuple(slot);
-		hscan->rs_empty_tuples_pending--;
-		return true;
-	}
-
 	/*
-	 * Out of range?  If so, nothing more to look at on this page
+	 * Out of range?  If so, nothing more to look at on this page, advance to
+	 * the next one.
 	 */
-	if (hscan->rs_cindex < 0 || hscan->rs_cindex >= hscan->rs_ntuples)
-		return false;
+	while (hscan->rs_cindex >= hscan->rs_ntuples)
+	{
+		if (!heapam_scan_bitmap_next_block(scan, recheck,
+										   lossy_pages, exact_pages))
+		{
+			/*
+			 * All fetched blocks have been processed.  Return the
+			 * NULL-filled tuples for the blocks we skipped fetching, if any.
+			 * Those never need rechecking.
+			 */
+			if (hscan->rs_empty_tuples_pending > 0)
+			{
+				ExecStoreAllNullTuple(slot);
+				hscan->rs_empty_tuples_pending--;
+				*recheck = false;
+				return true;
+			}
+
+			return false;
+		}
+	}
 
 	targoffset = hscan->rs_vistuples[hscan->rs_cindex];
 	page = BufferGetPage(hscan->rs_cbuf);
@@ -2642,7 +2762,6 @@ static const TableAmRoutine heapam_methods = {
 
 	.relation_estimate_size = heapam_estimate_rel_size,
 
-	.scan_bitmap_next_block = heapam_scan_bitmap_next_block,
 	.scan_bitmap_next_tuple = heapam_scan_bitmap_next_tuple,
 	.scan_sample_next_block = heapam_scan_sample_next_block,
 	.scan_sample_next_tuple = heapam_scan_sample_next_tuple
@@ -38,6 +38,7 @@
 #include "access/heapam_xlog.h"
 #include "access/htup_details.h"
 #include "access/multixact.h"
+#include "access/parallel.h"
 #include "access/tidstore.h"
 #include "access/transam.h"
 #include "access/visibilitymap.h"
@@ -49,12 +50,15 @@
 #include "common/int.h"
 #include "executor/instrument.h"
 #include "miscadmin.h"
+#include "optimizer/paths.h"
 #include "pgstat.h"
 #include "portability/instr_time.h"
 #include "postmaster/autovacuum.h"
 #include "storage/bufmgr.h"
 #include "storage/freespace.h"
 #include "storage/lmgr.h"
+#include "storage/procarray.h"
+#include "storage/read_stream.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/pg_rusage.h"
@@ -116,12 +120,87 @@
  */
 #define PREFETCH_SIZE			((BlockNumber) 32)
 
+/*
+ * Size of the chunks of blocks that the participants of a parallel first heap
+ * pass claim at a time.  A chunk is skipped using the visibility map only as a
+ * whole, so this is the same as SKIP_PAGES_THRESHOLD.  It must not exceed 64,
+ * the number of bits in LVRelState.chunk_allvis.
+ */
+#define PARALLEL_SCAN_CHUNK_SIZE	SKIP_PAGES_THRESHOLD
+
 /*
  * Macro to check if we are in a parallel vacuum.  If true, we are in the
  * parallel mode and the DSM segment is initialized.
  */
 #define ParallelVacuumIsActive(vacrel) ((vacrel)->pvs != NULL)
 
+/*
+ * Macro to check if the first heap pass is performed with parallel workers.
+ * This implies ParallelVacuumIsActive().
+ */
+#define ParallelHeapScanIsActive(vacrel) ((vacrel)->pscan != NULL)
+
+/*
+ * Counters of the first heap pass that a parallel worker reports back to the
+ * leader.  See the fields of the same names in LVRelState.
+ */
+typedef struct LVScanStats
+{
+	BlockNumber scanned_pages;
+	BlockNumber frozen_pages;
+	BlockNumber lpdead_item_pages;
+	BlockNumber missed_dead_pages;
+	BlockNumber nonempty_pages;
+	int64		tuples_deleted;
+	int64		tuples_frozen;
+	int64		lpdead_items;
+	int64		live_tuples;
+	int64		recently_dead_tuples;
+	int64		missed_dead_tuples;
+	TransactionId NewRelfrozenXid;
+	MultiXactId NewRelminMxid;
+	bool		skippedallvis;
+} LVScanStats;
+
+/*
+ * Shared state of a parallel first heap pass, in the parallel vacuum DSM
+ * segment.  The leader and the workers claim chunks of
+ * PARALLEL_SCAN_CHUNK_SIZE blocks from next_block until the relation is
+ * exhausted, or dead_items fills up.  In the latter case the leader waits for
+ * the workers, vacuums the indexes and the heap, and launches the workers
+ * again to go on from where they stopped.
+ */
+typedef struct LVParallelScanShared
+{
+	/* Set up by the leader, fixed for the whole VACUUM */
+	struct VacuumCutoffs cutoffs;
+	BlockNumber rel_pages;
+	int			nindexes;
+	bool		aggressive;
+	bool		skipwithvm;
+
+	/* Set by the leader before each round of the scan */
+	bool		do_index_vacuuming;
+
+	/* First block of the next chunk to hand out */
+	pg_atomic_uint64 next_block;
+
+	/* Counters of each worker, for the current round */
+	LVScanStats worker_stats[FLEXIBLE_ARRAY_MEMBER];
+} LVParallelScanShared;
+
+/*
+ * Per-buffer data passed from vacuum_reap_lp_read_stream_next() to
+ * lazy_vacuum_heap_rel() along with each block of the second heap pass.  The
+ * TidStore iterator reuses its offsets array, so we need our own copy of the
+ * offsets for each block that the read stream has looked ahead to.
+ */
+typedef struct VacReapBlockData
+{
+	int			num_offsets;
+	OffsetNumber offsets[MaxHeapTuplesPerPage];
+} VacReapBlockData;
+
 /* Phases of vacuum during which we report error context. */
 typedef enum
 {
@@ -143,6 +222,7 @@ typedef struct LVRelState
 	/* Buffer access strategy and parallel vacuum state */
 	BufferAccessStrategy bstrategy;
 	ParallelVacuumState *pvs;
+	LVParallelScanShared *pscan;	/* NULL unless heap is scanned in parallel */
 
 	/* Aggressive VACUUM? (must set relfrozenxid >= FreezeLimit) */
 	bool		aggressive;
@@ -216,6 +296,11 @@ typedef struct LVRelState
 	BlockNumber next_unskippable_block; /* next unskippable block */
 	bool		next_unskippable_allvis;	/* its visibility status */
 	Buffer		next_unskippable_vmbuffer;	/* buffer containing its VM bit */
+
+	/* State maintained by heap_vac_scan_next_chunk_block() */
+	BlockNumber chunk_start;	/* first block of the claimed chunk */
+	BlockNumber chunk_end;		/* end (exclusive) of the claimed chunk */
+	uint64		chunk_allvis;	/* all-visible bit of each of its blocks */
 } LVRelState;
 
 /* Struct for saving and restoring vacuum error information. */
@@ -229,8 +314,20 @@ typedef struct LVSavedErrInfo
 
 /* non-export function prototypes */
 static void lazy_scan_heap(LVRelState *vacrel);
-static bool heap_vac_scan_next_block(LVRelState *vacrel, BlockNumber *blkno,
-									 bool *all_visible_according_to_vm);
+static bool lazy_scan_heap_page(LVRelState *vacrel, Buffer buf,
+								bool all_visible_according_to_vm,
+								Buffer *vmbuffer);
+static BlockNumber lazy_scan_heap_parallel(LVRelState *vacrel);
+static void lazy_scan_heap_participate(LVRelState *vacrel);
+static BlockNumber heap_vac_scan_next_chunk_block(ReadStream *stream,
+												  void *callback_private_data,
+												  void *per_buffer_data);
+static bool heap_vac_claim_chunk(LVRelState *vacrel);
+static void lazy_scan_report_stats(LVRelState *vacrel, LVScanStats *stats);
+static void lazy_scan_merge_stats(LVRelState *vacrel, LVScanStats *stats);
+static BlockNumber heap_vac_scan_next_block(ReadStream *stream,
+											void *callback_private_data,
+											void *per_buffer_data);
 static void find_next_unskippable_block(LVRelState *vacrel, bool *skipsallvis);
 static bool lazy_scan_new_or_empty(LVRelState *vacrel, Buffer buf,
 								   BlockNumber blkno, Page page,
@@ -245,6 +342,9 @@ static bool lazy_scan_noprune(LVRelState *vacrel, Buffer buf,
 static void lazy_vacuum(LVRelState *vacrel);
 static bool lazy_vacuum_all_indexes(LVRelState *vacrel);
 static void lazy_vacuum_heap_rel(LVRelState *vacrel);
+static BlockNumber vacuum_reap_lp_read_stream_next(ReadStream *stream,
+												   void *callback_private_data,
+												   void *per_buffer_data);
 static void lazy_vacuum_heap_page(LVRelState *vacrel, BlockNumber blkno,
 								  Buffer buffer, OffsetNumber *deadoffsets,
 								  int num_offsets, Buffer vmbuffer);
@@ -816,10 +916,9 @@ static void
 lazy_scan_heap(LVRelState *vacrel)
 {
 	BlockNumber rel_pages = vacrel->rel_pages,
-				blkno,
+				blkno = 0,
 				next_fsm_block_to_vacuum = 0;
-	bool		all_visible_according_to_vm;
-
+	ReadStream *stream;
 	Buffer		vmbuffer = InvalidBuffer;
 	const int	initprog_index[] = {
 		PROGRESS_VACUUM_PHASE,
@@ -834,181 +933,116 @@ lazy_scan_heap(LVRelState *vacrel)
 	initprog_val[2] = vacrel->dead_items_info->max_bytes;
 	pgstat_progress_update_multi_param(3, initprog_index, initprog_val);
 
-	/* Initialize for the first heap_vac_scan_next_block() call */
-	vacrel->current_block = InvalidBlockNumber;
-	vacrel->next_unskippable_block = InvalidBlockNumber;
-	vacrel->next_unskippable_allvis = false;
-	vacrel->next_unskippable_vmbuffer = InvalidBuffer;
-
-	while (heap_vac_scan_next_block(vacrel, &blkno, &all_visible_according_to_vm))
+	/* Scan the heap with parallel workers, if we have them */
+	if (ParallelHeapScanIsActive(vacrel))
+		next_fsm_block_to_vacuum = lazy_scan_heap_parallel(vacrel);
+	else
 	{
-		Buffer		buf;
-		Page		page;
-		bool		has_lpdead_items;
-		bool		got_cleanup_lock = false;
-
-		vacrel->scanned_pages++;
-
-		/* Report as block scanned, update error traceback information */
-		pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_SCANNED, blkno);
-		update_vacuum_error_info(vacrel, NULL, VACUUM_ERRCB_PHASE_SCAN_HEAP,
-								 blkno, InvalidOffsetNumber);
-
-		vacuum_delay_point();
+		/* Initialize for the first heap_vac_scan_next_block() call */
+		vacrel->current_block = InvalidBlockNumber;
+		vacrel->next_unskippable_block = InvalidBlockNumber;
+		vacrel->next_unskippable_allvis = false;
+		vacrel->next_unskippable_vmbuffer = InvalidBuffer;
 
 		/*
-		 * Regularly check if wraparound failsafe should trigger.
-		 *
-		 * There is a similar check inside lazy_vacuum_all_indexes(), but
-		 * relfrozenxid might start to look dangerously old before we reach
-		 * that point.  This check also provides failsafe coverage for the
-		 * one-pass strategy, and the two-pass strategy with the index_cleanup
-		 * param set to 'off'.
+		 * Set up the read stream for the first heap pass.  The callback
+		 * consults the visibility map to skip ranges of all-visible or
+		 * all-frozen blocks, so only the blocks we actually have to process
+		 * are read, in as large vectored reads as possible.
 		 */
-		if (vacrel->scanned_pages % FAILSAFE_EVERY_PAGES == 0)
-			lazy_check_wraparound_failsafe(vacrel);
+		stream = read_stream_begin_relation(READ_STREAM_MAINTENANCE,
+											vacrel->bstrategy,
+											vacrel->rel,
+											MAIN_FORKNUM,
+											heap_vac_scan_next_block,
+											vacrel,
+											sizeof(bool));
 
-		/*
-		 * Consider if we definitely have enough space to process TIDs on page
-		 * already.  If we are close to overrunning the available space for
-		 * dead_items TIDs, pause and do a cycle of vacuuming before we tackle
-		 * this page.
-		 */
-		if (TidStoreMemoryUsage(vacrel->dead_items) > vacrel->dead_items_info->max_bytes)
+		while (true)
 		{
+			Buffer		buf;
+			void	   *per_buffer_data;
+			bool		all_visible_according_to_vm;
+
 			/*
-			 * Before beginning index vacuuming, we release any pin we may
-			 * hold on the visibility map page.  This isn't necessary for
-			 * correctness, but we do it anyway to avoid holding the pin
-			 * across a lengthy, unrelated operation.
+			 * Consider if we definitely have enough space to process TIDs on
+			 * the next page.  If we are close to overrunning the available
+			 * space for dead_items TIDs, pause and do a cycle of vacuuming
+			 * before we tackle it.  Do this before pulling the next buffer out
+			 * of the stream, so that the block is processed only after the
+			 * round of vacuuming.
 			 */
-			if (BufferIsValid(vmbuffer))
+			if (vacrel->dead_items_info->num_items > 0 &&
+				TidStoreMemoryUsage(vacrel->dead_items) > vacrel->dead_items_info->max_bytes)
 			{
-				ReleaseBuffer(vmbuffer);
-				vmbuffer = InvalidBuffer;
-			}
+				/*
+				 * Before beginning index vacuuming, we release any pin we may
+				 * hold on the visibility map page.  This isn't necessary for
+				 * correctness, but we do it anyway to avoid holding the pin
+				 * across a lengthy, unrelated operation.
+				 */
+				if (BufferIsValid(vmbuffer))
+				{
+					ReleaseBuffer(vmbuffer);
+					vmbuffer = InvalidBuffer;
+				}
 
-			/* Perform a round of index and heap vacuuming */
-			vacrel->consider_bypass_optimization = false;
-			lazy_vacuum(vacrel);
+				/* Perform a round of index and heap vacuuming */
+				vacrel->consider_bypass_optimization = false;
+				lazy_vacuum(vacrel);
 
-			/*
-			 * Vacuum the Free Space Map to make newly-freed space visible on
-			 * upper-level FSM pages.  Note we have not yet processed blkno.
-			 */
-			FreeSpaceMapVacuumRange(vacrel->rel, next_fsm_block_to_vacuum,
-									blkno);
-			next_fsm_block_to_vacuum = blkno;
+				/*
+				 * Vacuum the Free Space Map to make newly-freed space visible
+				 * on upper-level FSM pages.  Note that blkno is the block we
+				 * processed last.
+				 */
+				FreeSpaceMapVacuumRange(vacrel->rel, next_fsm_block_to_vacuum,
+										blkno + 1);
+				next_fsm_block_to_vacuum = blkno + 1;
 
-			/* Report that we are once again scanning the heap */
-			pgstat_progress_update_param(PROGRESS_VACUUM_PHASE,
-										 PROGRESS_VACUUM_PHASE_SCAN_HEAP);
-		}
+				/* Report that we are once again scanning the heap */
+				pgstat_progress_update_param(PROGRESS_VACUUM_PHASE,
+											 PROGRESS_VACUUM_PHASE_SCAN_HEAP);
+			}
 
-		/*
-		 * Pin the visibility map page in case we need to mark the page
-		 * all-visible.  In most cases this will be very cheap, because we'll
-		 * already have the correct page pinned anyway.
-		 */
-		visibilitymap_pin(vacrel->rel, blkno, &vmbuffer);
+			buf = read_stream_next_buffer(stream, &per_buffer_data);
 
-		buf = ReadBufferExtended(vacrel->rel, MAIN_FORKNUM, blkno, RBM_NORMAL,
-								 vacrel->bstrategy);
-		page = BufferGetPage(buf);
+			/* The relation is exhausted. */
+			if (!BufferIsValid(buf))
+				break;
 
-		/*
-		 * We need a buffer cleanup lock to prune HOT chains and defragment
-		 * the page in lazy_scan_prune.  But when it's not possible to acquire
-		 * a cleanup lock right away, we may be able to settle for reduced
-		 * processing using lazy_scan_noprune.
-		 */
-		got_cleanup_lock = ConditionalLockBufferForCleanup(buf);
+			all_visible_according_to_vm = *((bool *) per_buffer_data);
+			blkno = BufferGetBlockNumber(buf);
 
-		if (!got_cleanup_lock)
-			LockBuffer(buf, BUFFER_LOCK_SHARE);
+			vacrel->scanned_pages++;
 
-		/* Check for new or empty pages before lazy_scan_[no]prune call */
-		if (lazy_scan_new_or_empty(vacrel, buf, blkno, page, !got_cleanup_lock,
-								   vmbuffer))
-		{
-			/* Processed as new/empty page (lock and pin released) */
-			continue;
-		}
+			/* Report as block scanned, update error traceback information */
+			pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_SCANNED, blkno);
+			update_vacuum_error_info(vacrel, NULL, VACUUM_ERRCB_PHASE_SCAN_HEAP,
+									 blkno, InvalidOffsetNumber);
+
+			vacuum_delay_point();
 
-		/*
-		 * If we didn't get the cleanup lock, we can still collect LP_DEAD
-		 * items in the dead_items area for later vacuuming, count live and
-		 * recently dead tuples for vacuum logging, and determine if this
-		 * block could later be truncated. If we encounter any xid/mxids that
-		 * require advancing the relfrozenxid/relminxid, we'll have to wait
-		 * for a cleanup lock and call lazy_scan_prune().
-		 */
-		if (!got_cleanup_lock &&
-			!lazy_scan_noprune(vacrel, buf, blkno, page, &has_lpdead_items))
-		{
 			/*
-			 * lazy_scan_noprune could not do all required processing.  Wait
-			 * for a cleanup lock, and call lazy_scan_prune in the usual way.
+			 * Regularly check if wraparound failsafe should trigger.
+			 *
+			 * There is a similar check inside lazy_vacuum_all_indexes(), but
+			 * relfrozenxid might start to look dangerously old before we reach
+			 * that point.  This check also provides failsafe coverage for the
+			 * one-pass strategy, and the two-pass strategy with the
+			 * index_cleanup param set to 'off'.
 			 */
-			Assert(vacrel->aggressive);
-			LockBuffer(buf, BUFFER_LOCK_UNLOCK);
-			LockBufferForCleanup(buf);
-			got_cleanup_lock = true;
-		}
-
-		/*
-		 * If we have a cleanup lock, we must now prune, freeze, and count
-		 * tuples. We may have acquired the cleanup lock originally, or we may
-		 * have gone back and acquired it after lazy_scan_noprune() returned
-		 * false. Either way, the page hasn't been processed yet.
-		 *
-		 * Like lazy_scan_noprune(), lazy_scan_prune() will count
-		 * recently_dead_tuples and live tuples for vacuum logging, determine
-		 * if the block can later be truncated, and accumulate the details of
-		 * remaining LP_DEAD line pointers on the page into dead_items. These
-		 * dead items include those pruned by lazy_scan_prune() as well as
-		 * line pointers previously marked LP_DEAD.
-		 */
-		if (got_cleanup_lock)
-			lazy_scan_prune(vacrel, buf, blkno, page,
-							vmbuffer, all_visible_according_to_vm,
-							&has_lpdead_items);
-
-		/*
-		 * Now drop the buffer lock and, potentially, update the FSM.
-		 *
-		 * Our goal is to update the freespace map the last time we touch the
-		 * page. If we'll process a block in the second pass, we may free up
-		 * additional space on the page, so it is better to update the FSM
-		 * after the second pass. If the relation has no indexes, or if index
-		 * vacuuming is disabled, there will be no second heap pass; if this
-		 * particular page has no dead items, the second heap pass will not
-		 * touch this page. So, in those cases, update the FSM now.
-		 *
-		 * Note: In corner cases, it's possible to miss updating the FSM
-		 * entirely. If index vacuuming is currently enabled, we'll skip the
-		 * FSM update now. But if failsafe mode is later activated, or there
-		 * are so few dead tuples that index vacuuming is bypassed, there will
-		 * also be no opportunity to update the FSM later, because we'll never
-		 * revisit this page. Since updating the FSM is desirable but not
-		 * absolutely required, that's OK.
-		 */
-		if (vacrel->nindexes == 0
-			|| !vacrel->do_index_vacuuming
-			|| !has_lpdead_items)
-		{
-			Size		freespace = PageGetHeapFreeSpace(page);
-
-			UnlockReleaseBuffer(buf);
-			RecordPageWithFreeSpace(vacrel->rel, blkno, freespace);
+			if (vacrel->scanned_pages % FAILSAFE_EVERY_PAGES == 0)
+				lazy_check_wraparound_failsafe(vacrel);
 
 			/*
-			 * Periodically perform FSM vacuuming to make newly-freed space
-			 * visible on upper FSM pages. This is done after vacuuming if the
-			 * table has indexes. There will only be newly-freed space if we
-			 * held the cleanup lock and lazy_scan_prune() was called.
+			 * Prune and freeze the page, and periodically perform FSM
+			 * vacuuming to make newly-freed space visible on upper FSM pages.
+			 * This is done after vacuuming if the table has indexes.
 			 */
-			if (got_cleanup_lock && vacrel->nindexes == 0 && has_lpdead_items &&
+			if (lazy_scan_heap_page(vacrel, buf, all_visible_according_to_vm,
+									&vmbuffer) &&
+				vacrel->nindexes == 0 &&
 				blkno - next_fsm_block_to_vacuum >= VACUUM_FSM_EVERY_PAGES)
 			{
 				FreeSpaceMapVacuumRange(vacrel->rel, next_fsm_block_to_vacuum,
@@ -1016,16 +1050,16 @@ lazy_scan_heap(LVRelState *vacrel)
 				next_fsm_block_to_vacuum = blkno;
 			}
 		}
-		else
-			UnlockReleaseBuffer(buf);
-	}
 
-	vacrel->blkno = InvalidBlockNumber;
-	if (BufferIsValid(vmbuffer))
-		ReleaseBuffer(vmbuffer);
+		vacrel->blkno = InvalidBlockNumber;
+		if (BufferIsValid(vmbuffer))
+			ReleaseBuffer(vmbuffer);
+
+		read_stream_end(stream);
+	}
 
 	/* report that everything is now scanned */
-	pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_SCANNED, blkno);
+	pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_SCANNED, rel_pages);
 
 	/* now we can compute the new value for pg_class.reltuples */
 	vacrel->new_live_tuples = vac_estimate_reltuples(vacrel->rel, rel_pages,
@@ -1051,39 +1085,533 @@ lazy_scan_heap(LVRelState *vacrel)
 	 * Vacuum the remainder of the Free Space Map.  We must do this whether or
 	 * not there were indexes, and whether or not we bypassed index vacuuming.
 	 */
-	if (blkno > next_fsm_block_to_vacuum)
-		FreeSpaceMapVacuumRange(vacrel->rel, next_fsm_block_to_vacuum, blkno);
+	if (rel_pages > next_fsm_block_to_vacuum)
+		FreeSpaceMapVacuumRange(vacrel->rel, next_fsm_block_to_vacuum,
+								rel_pages);
 
 	/* report all blocks vacuumed */
-	pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_VACUUMED, blkno);
+	pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_VACUUMED, rel_pages);
 
 	/* Do final index cleanup (call each index's amvacuumcleanup routine) */
 	if (vacrel->nindexes > 0 && vacrel->do_index_cleanup)
 		lazy_cleanup_all_indexes(vacrel);
 }
 
+
 /*
- *	heap_vac_scan_next_block() -- get next block for vacuum to process
+ *	lazy_scan_heap_page() -- process one page during the first heap pass
  *
- * lazy_scan_heap() calls here every time it needs to get the next block to
- * prune and vacuum.  The function uses the visibility map, vacuum options,
- * and various thresholds to skip blocks which do not need to be processed and
- * sets blkno to the next block to process.
+ * Prunes and freezes the page, or settles for reduced processing using
+ * lazy_scan_noprune, and updates the FSM and visibility map.  Caller has
+ * pinned buf, and we release it.  *vmbuffer is the visibility map buffer that
+ * caller keeps pinned across calls.
  *
- * The block number and visibility status of the next block to process are set
- * in *blkno and *all_visible_according_to_vm.  The return value is false if
- * there are no further blocks to process.
+ * Returns true if pruning may have freed space on the page that has been
+ * recorded in the FSM, so that caller can consider vacuuming the FSM.
+ */
+static bool
+lazy_scan_heap_page(LVRelState *vacrel, Buffer buf,
+					bool all_visible_according_to_vm, Buffer *vmbuffer)
+{
+	Page		page = BufferGetPage(buf);
+	BlockNumber blkno = BufferGetBlockNumber(buf);
+	bool		has_lpdead_items;
+	bool		got_cleanup_lock = false;
+
+	/*
+	 * Pin the visibility map page in case we need to mark the page
+	 * all-visible.  In most cases this will be very cheap, because we'll
+	 * already have the correct page pinned anyway.
+	 */
+	visibilitymap_pin(vacrel->rel, blkno, vmbuffer);
+
+	/*
+	 * We need a buffer cleanup lock to prune HOT chains and defragment the
+	 * page in lazy_scan_prune.  But when it's not possible to acquire a
+	 * cleanup lock right away, we may be able to settle for reduced
+	 * processing using lazy_scan_noprune.
+	 */
+	got_cleanup_lock = ConditionalLockBufferForCleanup(buf);
+
+	if (!got_cleanup_lock)
+		LockBuffer(buf, BUFFER_LOCK_SHARE);
+
+	/* Check for new or empty pages before lazy_scan_[no]prune call */
+	if (lazy_scan_new_or_empty(vacrel, buf, blkno, page, !got_cleanup_lock,
+							   *vmbuffer))
+	{
+		/* Processed as new/empty page (lock and pin released) */
+		return false;
+	}
+
+	/*
+	 * If we didn't get the cleanup lock, we can still collect LP_DEAD items
+	 * in the dead_items area for later vacuuming, count live and recently
+	 * dead tuples for vacuum logging, and determine if this block could later
+	 * be truncated. If we encounter any xid/mxids that require advancing the
+	 * relfrozenxid/relminxid, we'll have to wait for a cleanup lock and call
+	 * lazy_scan_prune().
+	 */
+	if (!got_cleanup_lock &&
+		!lazy_scan_noprune(vacrel, buf, blkno, page, &has_lpdead_items))
+	{
+		/*
+		 * lazy_scan_noprune could not do all required processing.  Wait for
+		 * a cleanup lock, and call lazy_scan_prune in the usual way.
+		 */
+		Assert(vacrel->aggressive);
+		LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+		LockBufferForCleanup(buf);
+		got_cleanup_lock = true;
+	}
+
+	/*
+	 * If we have a cleanup lock, we must now prune, freeze, and count tuples.
+	 * We may have acquired the cleanup lock originally, or we may have gone
+	 * back and acquired it after lazy_scan_noprune() returned false. Either
+	 * way, the page hasn't been processed yet.
+	 *
+	 * Like lazy_scan_noprune(), lazy_scan_prune() will count
+	 * recently_dead_tuples and live tuples for vacuum logging, determine if
+	 * the block can later be truncated, and accumulate the details of
+	 * remaining LP_DEAD line pointers on the page into dead_items. These dead
+	 * items include those pruned by lazy_scan_prune() as well as line
+	 * pointers previously marked LP_DEAD.
+	 */
+	if (got_cleanup_lock)
+		lazy_scan_prune(vacrel, buf, blkno, page,
+						*vmbuffer, all_visible_according_to_vm,
+						&has_lpdead_items);
+
+	/*
+	 * Now drop the buffer lock and, potentially, update the FSM.
+	 *
+	 * Our goal is to update the freespace map the last time we touch the
+	 * page. If we'll process a block in the second pass, we may free up
+	 * additional space on the page, so it is better to update the FSM after
+	 * the second pass. If the relation has no indexes, or if index vacuuming
+	 * is disabled, there will be no second heap pass; if this particular page
+	 * has no dead items, the second heap pass will not touch this page. So,
+	 * in those cases, update the FSM now.
+	 *
+	 * Note: In corner cases, it's possible to miss updating the FSM entirely.
+	 * If index vacuuming is currently enabled, we'll skip the FSM update now.
+	 * But if failsafe mode is later activated, or there are so few dead
+	 * tuples that index vacuuming is bypassed, there will also be no
+	 * opportunity to update the FSM later, because we'll never revisit this
+	 * page. Since updating the FSM is desirable but not absolutely required,
+	 * that's OK.
+	 */
+	if (vacrel->nindexes == 0
+		|| !vacrel->do_index_vacuuming
+		|| !has_lpdead_items)
+	{
+		Size		freespace = PageGetHeapFreeSpace(page);
+
+		UnlockReleaseBuffer(buf);
+		RecordPageWithFreeSpace(vacrel->rel, blkno, freespace);
+
+		/*
+		 * There will only be newly-freed space if we held the cleanup lock
+		 * and lazy_scan_prune() was called.
+		 */
+		return got_cleanup_lock && has_lpdead_items;
+	}
+
+	UnlockReleaseBuffer(buf);
+	return false;
+}
+
+/*
+ *	lazy_scan_heap_parallel() -- first heap pass with parallel workers
  *
- * vacrel is an in/out parameter here.  Vacuum options and information about
+ * The leader and the workers scan the heap in chunks handed out from the
+ * shared scan state.  When dead_items fills up, the participants stop
+ * claiming new chunks; once they are all done, we perform a round of index
+ * and heap vacuuming and launch the workers again to scan the rest of the
+ * heap.
+ *
+ * Returns the first block not yet covered by FSM vacuuming.
+ */
+static BlockNumber
+lazy_scan_heap_parallel(LVRelState *vacrel)
+{
+	LVParallelScanShared *pscan = vacrel->pscan;
+	BlockNumber next_fsm_block_to_vacuum = 0;
+
+	for (;;)
+	{
+		int			nworkers;
+		BlockNumber scanned_upto;
+
+		/* Index vacuuming might have been disabled by the failsafe */
+		pscan->do_index_vacuuming = vacrel->do_index_vacuuming;
+
+		nworkers = parallel_vacuum_table_scan_begin(vacrel->pvs);
+		lazy_scan_heap_participate(vacrel);
+		parallel_vacuum_table_scan_end(vacrel->pvs);
+
+		for (int i = 0; i < nworkers; i++)
+			lazy_scan_merge_stats(vacrel, &pscan->worker_stats[i]);
+
+		scanned_upto = Min(pg_atomic_read_u64(&pscan->next_block),
+						   vacrel->rel_pages);
+		if (scanned_upto >= vacrel->rel_pages)
+			break;
+
+		/*
+		 * dead_items filled up before the heap was exhausted.  Perform a
+		 * round of index and heap vacuuming, as lazy_scan_heap does, before
+		 * going on.
+		 */
+		vacrel->consider_bypass_optimization = false;
+		lazy_vacuum(vacrel);
+
+		FreeSpaceMapVacuumRange(vacrel->rel, next_fsm_block_to_vacuum,
+								scanned_upto);
+		next_fsm_block_to_vacuum = scanned_upto;
+
+		/* Report that we are once again scanning the heap */
+		pgstat_progress_update_param(PROGRESS_VACUUM_PHASE,
+									 PROGRESS_VACUUM_PHASE_SCAN_HEAP);
+	}
+
+	return next_fsm_block_to_vacuum;
+}
+
+/*
+ *	lazy_scan_heap_participate() -- scan chunks of the heap in a parallel
+ *	first heap pass
+ *
+ * Called by the leader and by each worker, until there are no more chunks to
+ * claim for this round.  Only the leader reports progress and checks the
+ * wraparound failsafe.
+ */
+static void
+lazy_scan_heap_participate(LVRelState *vacrel)
+{
+	ReadStream *stream;
+	Buffer		vmbuffer = InvalidBuffer;
+
+	/* Initialize for the first heap_vac_scan_next_chunk_block() call */
+	vacrel->current_block = InvalidBlockNumber;
+	vacrel->chunk_start = 0;
+	vacrel->chunk_end = 0;
+	vacrel->chunk_allvis = 0;
+	vacrel->next_unskippable_vmbuffer = InvalidBuffer;
+
+	stream = read_stream_begin_relation(READ_STREAM_MAINTENANCE,
+										vacrel->bstrategy,
+										vacrel->rel,
+										MAIN_FORKNUM,
+										heap_vac_scan_next_chunk_block,
+										vacrel,
+										sizeof(bool));
+
+	while (true)
+	{
+		Buffer		buf;
+		void	   *per_buffer_data;
+		bool		all_visible_according_to_vm;
+		BlockNumber blkno;
+
+		buf = read_stream_next_buffer(stream, &per_buffer_data);
+
+		/* No more chunks to claim */
+		if (!BufferIsValid(buf))
+			break;
+
+		all_visible_according_to_vm = *((bool *) per_buffer_data);
+		blkno = BufferGetBlockNumber(buf);
+
+		vacrel->scanned_pages++;
+
+		/*
+		 * Report the blocks handed out so far as scanned, since the chunks
+		 * are processed out of order.
+		 */
+		if (!IsParallelWorker())
+			pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_SCANNED,
+										 Min(pg_atomic_read_u64(&vacrel->pscan->next_block),
+											 vacrel->rel_pages));
+		update_vacuum_error_info(vacrel, NULL, VACUUM_ERRCB_PHASE_SCAN_HEAP,
+								 blkno, InvalidOffsetNumber);
+
+		vacuum_delay_point();
+
+		if (!IsParallelWorker() &&
+			vacrel->scanned_pages % FAILSAFE_EVERY_PAGES == 0)
+			lazy_check_wraparound_failsafe(vacrel);
+
+		(void) lazy_scan_heap_page(vacrel, buf, all_visible_according_to_vm,
+								   &vmbuffer);
+	}
+
+	vacrel->blkno = InvalidBlockNumber;
+	if (BufferIsValid(vmbuffer))
+		ReleaseBuffer(vmbuffer);
+	if (BufferIsValid(vacrel->next_unskippable_vmbuffer))
+	{
+		ReleaseBuffer(vacrel->next_unskippable_vmbuffer);
+		vacrel->next_unskippable_vmbuffer = InvalidBuffer;
+	}
+
+	read_stream_end(stream);
+}
+
+/*
+ *	heap_vac_scan_next_chunk_block() -- read stream callback of a parallel
+ *	first heap pass
+ *
+ * Returns the blocks of the chunk claimed last, claiming a new chunk when
+ * they run out.  Like heap_vac_scan_next_block(), sets per_buffer_data to
+ * whether the block was all-visible according to the visibility map.
+ */
+static BlockNumber
+heap_vac_scan_next_chunk_block(ReadStream *stream,
+							   void *callback_private_data,
+							   void *per_buffer_data)
+{
+	LVRelState *vacrel = callback_private_data;
+	bool	   *all_visible_according_to_vm = per_buffer_data;
+	BlockNumber next_block;
+
+	/* relies on InvalidBlockNumber + 1 overflowing to 0 on first call */
+	next_block = vacrel->current_block + 1;
+
+	if (next_block < vacrel->chunk_start || next_block >= vacrel->chunk_end)
+	{
+		if (!heap_vac_claim_chunk(vacrel))
+			return InvalidBlockNumber;
+		next_block = vacrel->chunk_start;
+	}
+
+	vacrel->current_block = next_block;
+	*all_visible_according_to_vm =
+		(vacrel->chunk_allvis & (UINT64CONST(1) << (next_block - vacrel->chunk_start))) != 0;
+	return next_block;
+}
+
+/*
+ * Claim the next chunk of blocks to process in a parallel first heap pass.
+ *
+ * Chunks whose blocks could all be skipped by the rules of
+ * find_next_unskippable_block() are skipped.  Returns false if the heap is
+ * exhausted, or if dead_items is full and the leader has to vacuum the
+ * indexes and the heap before the scan can go on.
+ */
+static bool
+heap_vac_claim_chunk(LVRelState *vacrel)
+{
+	LVParallelScanShared *pscan = vacrel->pscan;
+	BlockNumber rel_pages = vacrel->rel_pages;
+
+	StaticAssertStmt(PARALLEL_SCAN_CHUNK_SIZE <= 64,
+					 "chunk_allvis must have a bit for each block of a chunk");
+
+	/*
+	 * Stop if dead_items is full.  Our own chunk and those of the other
+	 * participants might add a few more TIDs before they notice, which is
+	 * fine.
+	 */
+	if (vacrel->dead_items_info->num_items > 0 &&
+		TidStoreMemoryUsage(vacrel->dead_items) > vacrel->dead_items_info->max_bytes)
+		return false;
+
+	for (;;)
+	{
+		uint64		start;
+		BlockNumber end;
+		uint64		allvis = 0;
+		bool		skippable = true;
+		bool		skipsallvis = false;
+
+		start = pg_atomic_fetch_add_u64(&pscan->next_block,
+										PARALLEL_SCAN_CHUNK_SIZE);
+		if (start >= rel_pages)
+			return false;
+		end = Min(start + PARALLEL_SCAN_CHUNK_SIZE, rel_pages);
+
+		for (BlockNumber blkno = start; blkno < end; blkno++)
+		{
+			uint8		mapbits = visibilitymap_get_status(vacrel->rel, blkno,
+														   &vacrel->next_unskippable_vmbuffer);
+
+			if ((mapbits & VISIBILITYMAP_ALL_VISIBLE) == 0)
+			{
+				skippable = false;
+				continue;
+			}
+
+			allvis |= UINT64CONST(1) << (blkno - start);
+
+			/* Always scan the last page, and obey DISABLE_PAGE_SKIPPING */
+			if (blkno == rel_pages - 1 || !vacrel->skipwithvm)
+				skippable = false;
+			else if ((mapbits & VISIBILITYMAP_ALL_FROZEN) == 0)
+			{
+				if (vacrel->aggressive)
+					skippable = false;
+				else
+					skipsallvis = true;
+			}
+		}
+
+		if (!skippable)
+		{
+			vacrel->chunk_start = start;
+			vacrel->chunk_end = end;
+			vacrel->chunk_allvis = allvis;
+			return true;
+		}
+
+		if (skipsallvis)
+			vacrel->skippedallvis = true;
+	}
+}
+
+/*
+ * Copy the counters of a parallel worker's part of the first heap pass to
+ * shared memory for the leader.
+ */
+static void
+lazy_scan_report_stats(LVRelState *vacrel, LVScanStats *stats)
+{
+	stats->scanned_pages = vacrel->scanned_pages;
+	stats->frozen_pages = vacrel->frozen_pages;
+	stats->lpdead_item_pages = vacrel->lpdead_item_pages;
+	stats->missed_dead_pages = vacrel->missed_dead_pages;
+	stats->nonempty_pages = vacrel->nonempty_pages;
+	stats->tuples_deleted = vacrel->tuples_deleted;
+	stats->tuples_frozen = vacrel->tuples_frozen;
+	stats->lpdead_items = vacrel->lpdead_items;
+	stats->live_tuples = vacrel->live_tuples;
+	stats->recently_dead_tuples = vacrel->recently_dead_tuples;
+	stats->missed_dead_tuples = vacrel->missed_dead_tuples;
+	stats->NewRelfrozenXid = vacrel->NewRelfrozenXid;
+	stats->NewRelminMxid = vacrel->NewRelminMxid;
+	stats->skippedallvis = vacrel->skippedallvis;
+}
+
+/*
+ * Add the counters reported by a parallel worker to the leader's.
+ */
+static void
+lazy_scan_merge_stats(LVRelState *vacrel, LVScanStats *stats)
+{
+	vacrel->scanned_pages += stats->scanned_pages;
+	vacrel->frozen_pages += stats->frozen_pages;
+	vacrel->lpdead_item_pages += stats->lpdead_item_pages;
+	vacrel->missed_dead_pages += stats->missed_dead_pages;
+	vacrel->nonempty_pages = Max(vacrel->nonempty_pages,
+								 stats->nonempty_pages);
+	vacrel->tuples_deleted += stats->tuples_deleted;
+	vacrel->tuples_frozen += stats->tuples_frozen;
+	vacrel->lpdead_items += stats->lpdead_items;
+	vacrel->live_tuples += stats->live_tuples;
+	vacrel->recently_dead_tuples += stats->recently_dead_tuples;
+	vacrel->missed_dead_tuples += stats->missed_dead_tuples;
+	if (TransactionIdPrecedes(stats->NewRelfrozenXid, vacrel->NewRelfrozenXid))
+		vacrel->NewRelfrozenXid = stats->NewRelfrozenXid;
+	if (MultiXactIdPrecedes(stats->NewRelminMxid, vacrel->NewRelminMxid))
+		vacrel->NewRelminMxid = stats->NewRelminMxid;
+	if (stats->skippedallvis)
+		vacrel->skippedallvis = true;
+}
+
+/*
+ * heap_vacuum_parallel_scan_worker() -- join the leader in a parallel first
+ * heap pass
+ *
+ * Called in a parallel vacuum worker launched by lazy_scan_heap_parallel().
+ */
+void
+heap_vacuum_parallel_scan_worker(Relation rel, ParallelVacuumState *pvs,
+								 BufferAccessStrategy bstrategy)
+{
+	LVParallelScanShared *pscan = parallel_vacuum_get_table_scan(pvs);
+	LVRelState *vacrel;
+	ErrorContextCallback errcallback;
+
+	Assert(IsParallelWorker());
+	Assert(pscan != NULL);
+
+	vacrel = (LVRelState *) palloc0(sizeof(LVRelState));
+	vacrel->rel = rel;
+	vacrel->nindexes = pscan->nindexes;
+	vacrel->bstrategy = bstrategy;
+	vacrel->pvs = pvs;
+	vacrel->pscan = pscan;
+	vacrel->aggressive = pscan->aggressive;
+	vacrel->skipwithvm = pscan->skipwithvm;
+	vacrel->do_index_vacuuming = pscan->do_index_vacuuming;
+	vacrel->rel_pages = pscan->rel_pages;
+	vacrel->dead_items = parallel_vacuum_get_dead_items(pvs,
+														&vacrel->dead_items_info);
+
+	/*
+	 * Use the leader's cutoffs for freezing.  We need our own vistest for
+	 * pruning; it is at least as aggressive as the leader's, and
+	 * heap_page_prune_and_freeze() removes tuples whose xmax is < OldestXmin
+	 * in any case.
+	 */
+	vacrel->cutoffs = pscan->cutoffs;
+	(void) GetOldestNonRemovableTransactionId(rel);
+	vacrel->vistest = GlobalVisTestFor(rel);
+	vacrel->NewRelfrozenXid = vacrel->cutoffs.OldestXmin;
+	vacrel->NewRelminMxid = vacrel->cutoffs.OldestMxact;
+
+	/* Setup error traceback support for ereport() */
+	vacrel->dbname = get_database_name(MyDatabaseId);
+	vacrel->relnamespace = get_namespace_name(RelationGetNamespace(rel));
+	vacrel->relname = pstrdup(RelationGetRelationName(rel));
+	vacrel->indname = NULL;
+	vacrel->phase = VACUUM_ERRCB_PHASE_UNKNOWN;
+	errcallback.callback = vacuum_error_callback;
+	errcallback.arg = vacrel;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	lazy_scan_heap_participate(vacrel);
+
+	/* Pop the error context stack */
+	error_context_stack = errcallback.previous;
+
+	lazy_scan_report_stats(vacrel, &pscan->worker_stats[ParallelWorkerNumber]);
+}
+
+/*
+ *	heap_vac_scan_next_block() -- read stream callback to get the next block
+ *	for vacuum to process
+ *
+ * Every time lazy_scan_heap() needs a new block to process during its first
+ * phase, it invokes read_stream_next_buffer() with a stream set up to call
+ * heap_vac_scan_next_block() to get the next block.
+ *
+ * heap_vac_scan_next_block() uses the visibility map, vacuum options, and
+ * various thresholds to skip blocks which do not need to be processed and
+ * returns the next block to process or InvalidBlockNumber if there are no
+ * remaining blocks.
+ *
+ * The visibility status of the next block to process is set in
+ * per_buffer_data, which is a bool: whether the block was all-visible
+ * according to the visibility map at the time we looked.
+ *
+ * callback_private_data contains a reference to the LVRelState, passed to
+ * the read stream API during stream setup.  The LVRelState is an in/out
+ * parameter here.  Vacuum options and information about
  * the relation are read.  vacrel->skippedallvis is set if we skip a block
  * that's all-visible but not all-frozen, to ensure that we don't update
  * relfrozenxid in that case.  vacrel also holds information about the next
  * unskippable block, as bookkeeping for this function.
  */
-static bool
-heap_vac_scan_next_block(LVRelState *vacrel, BlockNumber *blkno,
-						 bool *all_visible_according_to_vm)
+static BlockNumber
+heap_vac_scan_next_block(ReadStream *stream,
+						 void *callback_private_data,
+						 void *per_buffer_data)
 {
+	LVRelState *vacrel = callback_private_data;
+	bool	   *all_visible_according_to_vm = per_buffer_data;
 	BlockNumber next_block;
 
 	/* relies on InvalidBlockNumber + 1 overflowing to 0 on first call */
@@ -1097,8 +1625,7 @@ heap_vac_scan_next_block(LVRelState *vacrel, BlockNumber *blkno,
 			ReleaseBuffer(vacrel->next_unskippable_vmbuffer);
 			vacrel->next_unskippable_vmbuffer = InvalidBuffer;
 		}
-		*blkno = vacrel->rel_pages;
-		return false;
+		return InvalidBlockNumber;
 	}
 
 	/*
@@ -1147,9 +1674,9 @@ heap_vac_scan_next_block(LVRelState *vacrel, BlockNumber *blkno,
 		 * but chose not to.  We know that they are all-visible in the VM,
 		 * otherwise they would've been unskippable.
 		 */
-		*blkno = vacrel->current_block = next_block;
+		vacrel->current_block = next_block;
 		*all_visible_according_to_vm = true;
-		return true;
+		return vacrel->current_block;
 	}
 	else
 	{
@@ -1159,9 +1686,9 @@ heap_vac_scan_next_block(LVRelState *vacrel, BlockNumber *blkno,
 		 */
 		Assert(next_block == vacrel->next_unskippable_block);
 
-		*blkno = vacrel->current_block = next_block;
+		vacrel->current_block = next_block;
 		*all_visible_according_to_vm = vacrel->next_unskippable_allvis;
-		return true;
+		return vacrel->current_block;
 	}
 }
 
@@ -2098,11 +2625,11 @@ lazy_vacuum_all_indexes(LVRelState *vacrel)
 static void
 lazy_vacuum_heap_rel(LVRelState *vacrel)
 {
+	ReadStream *stream;
 	BlockNumber vacuumed_pages = 0;
 	Buffer		vmbuffer = InvalidBuffer;
 	LVSavedErrInfo saved_err_info;
 	TidStoreIter *iter;
-	TidStoreIterResult *iter_result;
 
 	Assert(vacrel->do_index_vacuuming);
 	Assert(vacrel->do_index_cleanup);
@@ -2118,16 +2645,37 @@ lazy_vacuum_heap_rel(LVRelState *vacrel)
 							 InvalidBlockNumber, InvalidOffsetNumber);
 
 	iter = TidStoreBeginIterate(vacrel->dead_items);
-	while ((iter_result = TidStoreIterateNext(iter)) != NULL)
+
+	/*
+	 * Set up the read stream for the second heap pass.  It visits the blocks
+	 * with dead items in the order the TidStore returns them, which is
+	 * ascending block number order.
+	 */
+	stream = read_stream_begin_relation(READ_STREAM_MAINTENANCE,
+										vacrel->bstrategy,
+										vacrel->rel,
+										MAIN_FORKNUM,
+										vacuum_reap_lp_read_stream_next,
+										iter,
+										sizeof(VacReapBlockData));
+
+	while (true)
 	{
 		BlockNumber blkno;
 		Buffer		buf;
 		Page		page;
 		Size		freespace;
+		VacReapBlockData *block_data;
 
 		vacuum_delay_point();
 
-		blkno = iter_result->blkno;
+		buf = read_stream_next_buffer(stream, (void **) &block_data);
+
+		/* The relation is exhausted */
+		if (!BufferIsValid(buf))
+			break;
+
+		blkno = BufferGetBlockNumber(buf);
 		vacrel->blkno = blkno;
 
 		/*
@@ -2138,11 +2686,9 @@ lazy_vacuum_heap_rel(LVRelState *vacrel)
 		visibilitymap_pin(vacrel->rel, blkno, &vmbuffer);
 
 		/* We need a non-cleanup exclusive lock to mark dead_items unused */
-		buf = ReadBufferExtended(vacrel->rel, MAIN_FORKNUM, blkno, RBM_NORMAL,
-								 vacrel->bstrategy);
 		LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
-		lazy_vacuum_heap_page(vacrel, blkno, buf, iter_result->offsets,
-							  iter_result->num_offsets, vmbuffer);
+		lazy_vacuum_heap_page(vacrel, blkno, buf, block_data->offsets,
+							  block_data->num_offsets, vmbuffer);
 
 		/* Now that we've vacuumed the page, record its available space */
 		page = BufferGetPage(buf);
@@ -2152,6 +2698,8 @@ lazy_vacuum_heap_rel(LVRelState *vacrel)
 		RecordPageWithFreeSpace(vacrel->rel, blkno, freespace);
 		vacuumed_pages++;
 	}
+
+	read_stream_end(stream);
 	TidStoreEndIterate(iter);
 
 	vacrel->blkno = InvalidBlockNumber;
@@ -2175,6 +2723,34 @@ lazy_vacuum_heap_rel(LVRelState *vacrel)
 	restore_vacuum_error_info(vacrel, &saved_err_info);
 }
 
+/*
+ * Read stream callback for the second heap pass.  Returns the next block with
+ * dead items in the TidStore, copying its offsets into per_buffer_data, or
+ * InvalidBlockNumber when there are no more such blocks.
+ */
+static BlockNumber
+vacuum_reap_lp_read_stream_next(ReadStream *stream,
+								void *callback_private_data,
+								void *per_buffer_data)
+{
+	TidStoreIter *iter = callback_private_data;
+	VacReapBlockData *block_data = per_buffer_data;
+	TidStoreIterResult *iter_result;
+
+	iter_result = TidStoreIterateNext(iter);
+	if (iter_result == NULL)
+		return InvalidBlockNumber;
+
+	/* Dead items only ever come from heap pages */
+	Assert(iter_result->num_offsets <= MaxHeapTuplesPerPage);
+
+	block_data->num_offsets = iter_result->num_offsets;
+	memcpy(block_data->offsets, iter_result->offsets,
+		   sizeof(OffsetNumber) * iter_result->num_offsets);
+
+	return iter_result->blkno;
+}
+
 /*
  *	lazy_vacuum_heap_page() -- free page's LP_DEAD items listed in the
  *						  vacrel->dead_items store.
@@ -2821,10 +3397,14 @@ dead_items_alloc(LVRelState *vacrel, int nworkers)
 
 	/*
 	 * Initialize state for a parallel vacuum.  As of now, only one worker can
-	 * be used for an index, so we invoke parallelism only if there are at
-	 * least two indexes on a table.
+	 * be used for an index, so we invoke parallel index vacuuming only if
+	 * there are at least two indexes on a table.  The first heap pass can be
+	 * performed in parallel if the table is at least
+	 * min_parallel_table_scan_size.
 	 */
-	if (nworkers >= 0 && vacrel->nindexes > 1 && vacrel->do_index_vacuuming)
+	if (nworkers >= 0 &&
+		((vacrel->nindexes > 1 && vacrel->do_index_vacuuming) ||
+		 vacrel->rel_pages >= (BlockNumber) min_parallel_table_scan_size))
 	{
 		/*
 		 * Since parallel workers cannot access data in temporary tables, we
@@ -2846,7 +3426,10 @@ dead_items_alloc(LVRelState *vacrel, int nworkers)
 											   vacrel->nindexes, nworkers,
 											   vac_work_mem,
 											   vacrel->verbose ? INFO : DEBUG2,
-											   vacrel->bstrategy);
+											   vacrel->bstrategy,
+											   add_size(offsetof(LVParallelScanShared, worker_stats),
+														mul_size(sizeof(LVScanStats),
+																 max_parallel_maintenance_workers)));
 
 		/*
 		 * If parallel mode started, dead_items and dead_items_info spaces are
@@ -2854,8 +3437,23 @@ dead_items_alloc(LVRelState *vacrel, int nworkers)
 		 */
 		if (ParallelVacuumIsActive(vacrel))
 		{
+			LVParallelScanShared *pscan;
+
 			vacrel->dead_items = parallel_vacuum_get_dead_items(vacrel->pvs,
 																&vacrel->dead_items_info);
+
+			/* Set up the shared state of the first heap pass, if parallel */
+			pscan = parallel_vacuum_get_table_scan(vacrel->pvs);
+			if (pscan != NULL)
+			{
+				pscan->cutoffs = vacrel->cutoffs;
+				pscan->rel_pages = vacrel->rel_pages;
+				pscan->nindexes = vacrel->nindexes;
+				pscan->aggressive = vacrel->aggressive;
+				pscan->skipwithvm = vacrel->skipwithvm;
+				pg_atomic_init_u64(&pscan->next_block, 0);
+				vacrel->pscan = pscan;
+			}
 			return;
 		}
 	}
@@ -2886,11 +3484,20 @@ dead_items_add(LVRelState *vacrel, BlockNumber blkno, OffsetNumber *offsets,
 	};
 	int64		prog_val[2];
 
+	/* Other participants of a parallel heap scan add items concurrently */
+	if (ParallelHeapScanIsActive(vacrel))
+		TidStoreLockExclusive(vacrel->dead_items);
+
 	TidStoreSetBlockOffsets(vacrel->dead_items, blkno, offsets, num_offsets);
 	vacrel->dead_items_info->num_items += num_offsets;
-
-	/* update the progress information */
 	prog_val[0] = vacrel->dead_items_info->num_items;
+
+	if (ParallelHeapScanIsActive(vacrel))
+		TidStoreUnlock(vacrel->dead_items);
+
+	/* update the progress information, which only the leader reports */
+	if (IsParallelWorker())
+		return;
 	prog_val[1] = TidStoreMemoryUsage(vacrel->dead_items);
 	pgstat_progress_update_multi_param(2, prog_index, prog_val);
 }
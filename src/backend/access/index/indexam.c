@@ -563,6 +563,41 @@ index_beginscan_parallel(Relation heaprel, Relation indexrel, int nkeys,
 	return scan;
 }
 
+/*
+ * Callback for the table AM, passing on the index AM's knowledge of upcoming
+ * TIDs.
+ */
+static bool
+index_prefetch_next(void *arg, ItemPointer tid)
+{
+	IndexScanDesc scan = (IndexScanDesc) arg;
+
+	return scan->indexRelation->rd_indam->amgetprefetchtid(scan, tid);
+}
+
+/* ----------------
+ * index_enable_prefetch - let the table AM read ahead for a scan
+ *
+ * Callers that fetch the table tuple for every TID returned, in the order
+ * returned, can call this after beginning the scan.  If the index AM can tell
+ * which TIDs are coming up, the table AM may then start reading the blocks
+ * holding them early.  Index-only scans should not use this, since they
+ * usually don't need to visit the table at all.
+ * ----------------
+ */
+void
+index_enable_prefetch(IndexScanDesc scan)
+{
+	SCAN_CHECKS;
+
+	if (scan->indexRelation->rd_indam->amgetprefetchtid == NULL ||
+		scan->xs_heapfetch == NULL)
+		return;
+
+	scan->xs_heapfetch->prefetch_next = index_prefetch_next;
+	scan->xs_heapfetch->prefetch_arg = scan;
+}
+
 /* ----------------
  * index_getnext_tid - get the next TID from a scan
  *
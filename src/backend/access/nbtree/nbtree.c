@@ -145,6 +145,7 @@ bthandler(PG_FUNCTION_ARGS)
 	amroutine->amendscan = btendscan;
 	amroutine->ammarkpos = btmarkpos;
 	amroutine->amrestrpos = btrestrpos;
+	amroutine->amgetprefetchtid = btgetprefetchtid;
 	amroutine->amestimateparallelscan = btestimateparallelscan;
 	amroutine->aminitparallelscan = btinitparallelscan;
 	amroutine->amparallelrescan = btparallelrescan;
@@ -211,6 +212,13 @@ btgettuple(IndexScanDesc scan, ScanDirection dir)
 	/* btree indexes are never lossy */
 	scan->xs_recheck = false;
 
+	/* Reporting of upcoming TIDs starts over if the direction changes */
+	if (dir != so->prefetchDir)
+	{
+		so->prefetchDir = dir;
+		so->prefetchValid = false;
+	}
+
 	/* Each loop iteration performs another primitive index scan */
 	do
 	{
@@ -338,6 +346,9 @@ btbeginscan(Relation rel, int nkeys, int norderbys)
 	so->killedItems = NULL;		/* until needed */
 	so->numKilled = 0;
 
+	so->prefetchValid = false;
+	so->prefetchDir = NoMovementScanDirection;
+
 	/*
 	 * We don't know yet whether the scan will be index-only, so we do not
 	 * allocate the tuple workspace arrays until btrescan.  However, we set up
@@ -374,6 +385,8 @@ btrescan(IndexScanDesc scan, ScanKey scankey, int nscankeys,
 	so->markItemIndex = -1;
 	so->needPrimScan = false;
 	so->scanBehind = false;
+	so->prefetchValid = false;
+	so->prefetchDir = NoMovementScanDirection;
 	BTScanPosUnpinIfPinned(so->markPos);
 	BTScanPosInvalidate(so->markPos);
 
@@ -480,6 +493,8 @@ btrestrpos(IndexScanDesc scan)
 {
 	BTScanOpaque so = (BTScanOpaque) scan->opaque;
 
+	so->prefetchValid = false;
+
 	if (so->markItemIndex >= 0)
 	{
 		/*
@@ -530,6 +545,45 @@ btrestrpos(IndexScanDesc scan)
 	}
 }
 
+/*
+ *	btgetprefetchtid() -- report a TID that btgettuple will return later
+ *
+ * Successive calls report the items of the current leaf page in the order
+ * that btgettuple returns them, starting with the one it returned last.  We
+ * don't look beyond the current page: once its items have all been reported
+ * we return false, and calls made after btgettuple has moved to another page
+ * continue from there.
+ */
+bool
+btgetprefetchtid(IndexScanDesc scan, ItemPointer tid)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+
+	if (!BTScanPosIsValid(so->currPos))
+		return false;
+
+	if (!so->prefetchValid)
+	{
+		so->prefetchItem = so->currPos.itemIndex;
+		so->prefetchValid = true;
+	}
+
+	if (ScanDirectionIsForward(so->prefetchDir))
+	{
+		if (so->prefetchItem > so->currPos.lastItem)
+			return false;
+		*tid = so->currPos.items[so->prefetchItem++].heapTid;
+	}
+	else
+	{
+		if (so->prefetchItem < so->currPos.firstItem)
+			return false;
+		*tid = so->currPos.items[so->prefetchItem--].heapTid;
+	}
+
+	return true;
+}
+
 /*
  * btestimateparallelscan -- estimate storage for BTParallelScanDescData
  */
@@ -1576,6 +1576,9 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum,
 	 */
 	Assert(BufferIsValid(so->currPos.buf));
 
+	/* Whatever we've reported about upcoming TIDs is now out of date */
+	so->prefetchValid = false;
+
 	page = BufferGetPage(so->currPos.buf);
 	opaque = BTPageGetOpaque(page);
 
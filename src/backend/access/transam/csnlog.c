@@ -0,0 +1,523 @@
+/*-------------------------------------------------------------------------
+ *
+ * csnlog.c
+ *		Commit sequence number log, for csn_snapshots
+ *
+ * With csn_snapshots enabled, each transaction is assigned a commit sequence
+ * number (CSN) from a shared 64-bit counter as it commits, and pg_csn records
+ * the CSN of every committed XID, subtransactions included.  An MVCC snapshot
+ * then only needs to remember the next CSN to be assigned: an XID between
+ * the snapshot's xmin and xmax is visible to it if the XID has a CSN smaller
+ * than that.  Taking a snapshot is therefore O(1), and doesn't need
+ * ProcArrayLock at all.
+ *
+ * To keep it that way, snapshot xmins are not computed from the ProcArray
+ * either.  Instead we maintain a lower bound on the XIDs that are still
+ * running, and only recompute it after enough new XIDs have been assigned.
+ * A stale value is always safe to use, since no XID that has finished can
+ * ever be running again; it just means that more XIDs have to be looked up
+ * here, and that VACUUM's horizon lags behind a little.  pg_subtrans and
+ * pg_csn are never truncated past that bound, see CSNLogGetSnapshotXmin().
+ *
+ * Like pg_subtrans, the contents don't need to survive a crash, so there
+ * are no XLOG interactions.  At startup, the active range is reset, and the
+ * transactions in it that already committed are marked with
+ * FrozenCommitSeqNo, which every snapshot considers visible.  The log is
+ * not maintained during recovery: hot standby uses regular snapshots, and
+ * the log is started up at the end of recovery.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/backend/access/transam/csnlog.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/csnlog.h"
+#include "access/slru.h"
+#include "access/transam.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/procarray.h"
+#include "storage/s_lock.h"
+#include "storage/shmem.h"
+
+
+/*
+ * Defines for CSN log page sizes.  A page is the same BLCKSZ as is used
+ * everywhere else in Postgres.
+ *
+ * As in subtrans.c, page numbering wraps around at
+ * 0xFFFFFFFF/CSNLOG_XACTS_PER_PAGE, which we only need to take notice of
+ * when comparing and zeroing pages.
+ */
+
+/* We need eight bytes per xact */
+#define CSNLOG_XACTS_PER_PAGE (BLCKSZ / sizeof(CommitSeqNo))
+
+static inline int64
+TransactionIdToPage(TransactionId xid)
+{
+	return xid / (int64) CSNLOG_XACTS_PER_PAGE;
+}
+
+#define TransactionIdToEntry(xid) ((xid) % (TransactionId) CSNLOG_XACTS_PER_PAGE)
+
+/*
+ * How many XIDs may be assigned before the snapshot xmin bound is
+ * recomputed.
+ */
+#define CSNLOG_XMIN_REFRESH_INTERVAL	256
+
+/* GUC */
+bool		csn_snapshots = false;
+
+/*
+ * Shared state, besides the SLRU itself.
+ */
+typedef struct CSNLogSharedData
+{
+	bool		active;			/* set up by StartupCSNLog()? */
+	pg_atomic_uint64 nextCSN;	/* next CSN to assign */
+	pg_atomic_uint64 nextXid;	/* copy of TransamVariables->nextXid */
+	pg_atomic_uint32 snapshotXmin;	/* lower bound on running XIDs */
+	pg_atomic_flag xminRefreshing;	/* is snapshotXmin being recomputed? */
+} CSNLogSharedData;
+
+static CSNLogSharedData *CSNLogShared;
+
+/*
+ * Link to shared-memory data structures for CSN log control
+ */
+static SlruCtlData CSNLogCtlData;
+
+#define CSNLogCtl	(&CSNLogCtlData)
+
+
+static void CSNLogSetCSN(TransactionId xid, CommitSeqNo csn);
+static CommitSeqNo CSNLogGetCSN(TransactionId xid);
+static bool CSNLogPagePrecedes(int64 page1, int64 page2);
+
+
+/*
+ * Record the commit of a transaction tree.
+ *
+ * This must be called after the commit has been recorded in pg_xact, right
+ * before the transaction is removed from the ProcArray, so that CSN snapshots
+ * start to see it at the same time as regular ones.  All XIDs are first
+ * marked as committing, then the CSN is assigned.  Readers that find an XID
+ * marked as committing wait for its final CSN, so that a snapshot can never
+ * miss a commit whose CSN precedes the snapshot's.
+ */
+void
+CSNLogSetCommitTree(TransactionId xid, int nsubxids, TransactionId *subxids)
+{
+	CommitSeqNo csn;
+	int			i;
+
+	if (!CSNLogIsActive())
+		return;
+
+	/* the transaction has committed already, so failure here is fatal */
+	START_CRIT_SECTION();
+
+	CSNLogSetCSN(xid, CommittingCommitSeqNo);
+	for (i = 0; i < nsubxids; i++)
+		CSNLogSetCSN(subxids[i], CommittingCommitSeqNo);
+
+	csn = pg_atomic_fetch_add_u64(&CSNLogShared->nextCSN, 1);
+
+	for (i = 0; i < nsubxids; i++)
+		CSNLogSetCSN(subxids[i], csn);
+	CSNLogSetCSN(xid, csn);
+
+	END_CRIT_SECTION();
+}
+
+/*
+ * Is the given XID still in progress according to a snapshot that was taken
+ * when snapshotCsn was the next CSN to be assigned?
+ *
+ * The caller has checked the XID against the snapshot's xmin and xmax.
+ */
+bool
+CSNLogXidInSnapshot(TransactionId xid, CommitSeqNo snapshotCsn)
+{
+	CommitSeqNo csn;
+
+	csn = CSNLogGetCSN(xid);
+	if (unlikely(csn == CommittingCommitSeqNo))
+	{
+		SpinDelayStatus delay;
+
+		/* the committing backend is in a critical section, won't be long */
+		init_local_spin_delay(&delay);
+		while ((csn = CSNLogGetCSN(xid)) == CommittingCommitSeqNo)
+			perform_spin_delay(&delay);
+		finish_spin_delay(&delay);
+	}
+
+	/* running or aborted transactions have no CSN */
+	if (csn == InvalidCommitSeqNo)
+		return true;
+
+	return csn >= snapshotCsn;
+}
+
+/*
+ * Set the CSN of a single XID.
+ */
+static void
+CSNLogSetCSN(TransactionId xid, CommitSeqNo csn)
+{
+	int64		pageno = TransactionIdToPage(xid);
+	int			entryno = TransactionIdToEntry(xid);
+	int			slotno;
+	LWLock	   *lock;
+	CommitSeqNo *ptr;
+
+	lock = SimpleLruGetBankLock(CSNLogCtl, pageno);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
+
+	slotno = SimpleLruReadPage(CSNLogCtl, pageno, true, xid);
+	ptr = (CommitSeqNo *) CSNLogCtl->shared->page_buffer[slotno];
+	ptr[entryno] = csn;
+	CSNLogCtl->shared->page_dirty[slotno] = true;
+
+	LWLockRelease(lock);
+}
+
+/*
+ * Interrogate the CSN of an XID.
+ */
+static CommitSeqNo
+CSNLogGetCSN(TransactionId xid)
+{
+	int64		pageno = TransactionIdToPage(xid);
+	int			entryno = TransactionIdToEntry(xid);
+	int			slotno;
+	CommitSeqNo *ptr;
+	CommitSeqNo csn;
+
+	/* lock is acquired by SimpleLruReadPage_ReadOnly */
+
+	slotno = SimpleLruReadPage_ReadOnly(CSNLogCtl, pageno, xid);
+	ptr = (CommitSeqNo *) CSNLogCtl->shared->page_buffer[slotno];
+	csn = ptr[entryno];
+
+	LWLockRelease(SimpleLruGetBankLock(CSNLogCtl, pageno));
+
+	return csn;
+}
+
+/*
+ * Are CSN snapshots in use?  They are once the log has been started up at
+ * the end of recovery, if csn_snapshots is enabled.
+ */
+bool
+CSNLogIsActive(void)
+{
+	return CSNLogShared->active;
+}
+
+/*
+ * The CSN that the next committing transaction will get.
+ */
+CommitSeqNo
+CSNLogGetNextCSN(void)
+{
+	return pg_atomic_read_u64(&CSNLogShared->nextCSN);
+}
+
+/*
+ * Read nextXid without acquiring XidGenLock.
+ */
+FullTransactionId
+CSNLogGetNextXid(void)
+{
+	return FullTransactionIdFromU64(pg_atomic_read_u64(&CSNLogShared->nextXid));
+}
+
+/*
+ * Publish a new value of nextXid.  Called with XidGenLock held, after
+ * nextXid has been advanced.
+ */
+void
+CSNLogSetNextXid(FullTransactionId nextXid)
+{
+	if (!CSNLogIsActive())
+		return;
+
+	pg_atomic_write_u64(&CSNLogShared->nextXid, U64FromFullTransactionId(nextXid));
+}
+
+/*
+ * Return a lower bound on the XIDs that are still running, to be used as the
+ * xmin of a CSN snapshot.  If refresh is true, and the current bound lags
+ * far enough behind nextXid, it is recomputed first.
+ *
+ * The bound only ever moves forward.  Backends taking a snapshot advertise
+ * it as their xmin, and then check that it hasn't moved; truncation of
+ * pg_subtrans and pg_csn reads it before computing the oldest xmin of any
+ * backend.  That way, truncation can't remove data for an XID that a
+ * snapshot's xmin covers, even though the snapshot's xmin may be older than
+ * any XID running at the time the truncation horizon is computed.
+ *
+ * Returns InvalidTransactionId if CSN snapshots are not in use.
+ */
+TransactionId
+CSNLogGetSnapshotXmin(bool refresh)
+{
+	TransactionId xmin;
+	TransactionId nextXid;
+
+	if (!CSNLogIsActive())
+		return InvalidTransactionId;
+
+	xmin = pg_atomic_read_u32(&CSNLogShared->snapshotXmin);
+	if (!refresh)
+		return xmin;
+
+	nextXid = XidFromFullTransactionId(CSNLogGetNextXid());
+	if ((uint32) (nextXid - xmin) > CSNLOG_XMIN_REFRESH_INTERVAL &&
+		pg_atomic_test_set_flag(&CSNLogShared->xminRefreshing))
+	{
+		TransactionId newxmin;
+
+		newxmin = GetOldestActiveTransactionId();
+
+		/* somebody else may have advanced it in the meantime */
+		xmin = pg_atomic_read_u32(&CSNLogShared->snapshotXmin);
+		if (TransactionIdFollows(newxmin, xmin))
+		{
+			pg_atomic_write_u32(&CSNLogShared->snapshotXmin, newxmin);
+			xmin = newxmin;
+		}
+
+		pg_atomic_clear_flag(&CSNLogShared->xminRefreshing);
+	}
+
+	return xmin;
+}
+
+/*
+ * Number of shared CSN log buffers.
+ *
+ * The log is only used with csn_snapshots, otherwise just reserve the
+ * minimum.
+ */
+static int
+CSNLogShmemBuffers(void)
+{
+	if (!csn_snapshots)
+		return 16;
+
+	return SimpleLruAutotuneBuffers(512, 1024);
+}
+
+/*
+ * Initialization of shared memory for the CSN log
+ */
+Size
+CSNLogShmemSize(void)
+{
+	return add_size(SimpleLruShmemSize(CSNLogShmemBuffers(), 0),
+					sizeof(CSNLogSharedData));
+}
+
+void
+CSNLogShmemInit(void)
+{
+	bool		found;
+
+	CSNLogCtl->PagePrecedes = CSNLogPagePrecedes;
+	SimpleLruInit(CSNLogCtl, "csn", CSNLogShmemBuffers(), 0,
+				  "pg_csn", LWTRANCHE_CSN_BUFFER,
+				  LWTRANCHE_CSN_SLRU, SYNC_HANDLER_NONE, true);
+	SlruPagePrecedesUnitTests(CSNLogCtl, CSNLOG_XACTS_PER_PAGE);
+
+	CSNLogShared = (CSNLogSharedData *)
+		ShmemInitStruct("CSN log shared state", sizeof(CSNLogSharedData),
+						&found);
+	if (!found)
+	{
+		CSNLogShared->active = false;
+		pg_atomic_init_u64(&CSNLogShared->nextCSN, FirstNormalCommitSeqNo);
+		pg_atomic_init_u64(&CSNLogShared->nextXid, 0);
+		pg_atomic_init_u32(&CSNLogShared->snapshotXmin, InvalidTransactionId);
+		pg_atomic_init_flag(&CSNLogShared->xminRefreshing);
+	}
+}
+
+/*
+ * This must be called ONCE at the end of recovery, or during startup of a
+ * standalone backend, after TransamVariables->nextXid has been initialized
+ * and CLOG has been started up.  Does nothing unless csn_snapshots is
+ * enabled.
+ *
+ * oldestActiveXID is the oldest XID of any prepared transaction, or nextXid
+ * if there are none.
+ */
+void
+StartupCSNLog(TransactionId oldestActiveXID)
+{
+	TransactionId nextXid;
+	TransactionId xid;
+	int64		startPage;
+	int64		endPage;
+	LWLock	   *prevlock = NULL;
+	LWLock	   *lock;
+
+	if (!csn_snapshots)
+		return;
+
+	/*
+	 * Initialize the currently-active page(s) to zeroes, the same as
+	 * StartupSUBTRANS().  ExtendCSNLog will likewise zero new pages as XIDs
+	 * are assigned.
+	 */
+	nextXid = XidFromFullTransactionId(TransamVariables->nextXid);
+	startPage = TransactionIdToPage(oldestActiveXID);
+	endPage = TransactionIdToPage(nextXid);
+
+	for (;;)
+	{
+		lock = SimpleLruGetBankLock(CSNLogCtl, startPage);
+		if (prevlock != lock)
+		{
+			if (prevlock)
+				LWLockRelease(prevlock);
+			LWLockAcquire(lock, LW_EXCLUSIVE);
+			prevlock = lock;
+		}
+
+		(void) SimpleLruZeroPage(CSNLogCtl, startPage);
+		if (startPage == endPage)
+			break;
+
+		startPage++;
+		/* must account for wraparound */
+		if (startPage > TransactionIdToPage(MaxTransactionId))
+			startPage = 0;
+	}
+
+	LWLockRelease(lock);
+
+	/*
+	 * Transactions in that range that have committed are visible to every
+	 * snapshot.  The rest are prepared transactions, which are still
+	 * running, or aborted; they have no CSN.
+	 */
+	xid = oldestActiveXID;
+	while (TransactionIdPrecedes(xid, nextXid))
+	{
+		if (TransactionIdDidCommit(xid))
+			CSNLogSetCSN(xid, FrozenCommitSeqNo);
+		TransactionIdAdvance(xid);
+	}
+
+	pg_atomic_write_u64(&CSNLogShared->nextCSN, FirstNormalCommitSeqNo);
+	pg_atomic_write_u64(&CSNLogShared->nextXid,
+						U64FromFullTransactionId(TransamVariables->nextXid));
+	pg_atomic_write_u32(&CSNLogShared->snapshotXmin, oldestActiveXID);
+
+	pg_write_barrier();
+	CSNLogShared->active = true;
+}
+
+/*
+ * Perform a checkpoint --- either during shutdown, or on-the-fly
+ */
+void
+CheckPointCSNLog(void)
+{
+	if (!CSNLogIsActive())
+		return;
+
+	/*
+	 * Write dirty CSN log pages to disk.  As with pg_subtrans, this is only
+	 * done so that the checkpointer, rather than backends, does the writing.
+	 */
+	SimpleLruWriteAll(CSNLogCtl, true);
+}
+
+/*
+ * Make sure that the CSN log has room for a newly-allocated XID.
+ *
+ * NB: this is called while holding XidGenLock.  We want it to be very fast
+ * most of the time; even when it's not so fast, no actual I/O need happen
+ * unless we're forced to write out a dirty page to make room in shared
+ * memory.
+ */
+void
+ExtendCSNLog(TransactionId newestXact)
+{
+	int64		pageno;
+	LWLock	   *lock;
+
+	if (!CSNLogIsActive())
+		return;
+
+	/*
+	 * No work except at first XID of a page.  But beware: just after
+	 * wraparound, the first XID of page zero is FirstNormalTransactionId.
+	 */
+	if (TransactionIdToEntry(newestXact) != 0 &&
+		!TransactionIdEquals(newestXact, FirstNormalTransactionId))
+		return;
+
+	pageno = TransactionIdToPage(newestXact);
+
+	lock = SimpleLruGetBankLock(CSNLogCtl, pageno);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
+
+	/* Zero the page */
+	SimpleLruZeroPage(CSNLogCtl, pageno);
+
+	LWLockRelease(lock);
+}
+
+/*
+ * Remove all CSN log segments before the one holding the passed transaction
+ * ID.
+ *
+ * oldestXact must not be newer than CSNLogGetSnapshotXmin(), read before
+ * computing the oldest xmin of any running transaction.  This is called only
+ * during checkpoint.
+ */
+void
+TruncateCSNLog(TransactionId oldestXact)
+{
+	int64		cutoffPage;
+
+	if (!CSNLogIsActive())
+		return;
+
+	/* step back one transaction, see TruncateSUBTRANS() */
+	TransactionIdRetreat(oldestXact);
+	cutoffPage = TransactionIdToPage(oldestXact);
+
+	SimpleLruTruncate(CSNLogCtl, cutoffPage);
+}
+
+
+/*
+ * Decide whether a CSN log page number is "older" for truncation purposes.
+ * Analogous to CLOGPagePrecedes().
+ */
+static bool
+CSNLogPagePrecedes(int64 page1, int64 page2)
+{
+	TransactionId xid1;
+	TransactionId xid2;
+
+	xid1 = ((TransactionId) page1) * CSNLOG_XACTS_PER_PAGE;
+	xid1 += FirstNormalTransactionId + 1;
+	xid2 = ((TransactionId) page2) * CSNLOG_XACTS_PER_PAGE;
+	xid2 += FirstNormalTransactionId + 1;
+
+	return (TransactionIdPrecedes(xid1, xid2) &&
+			TransactionIdPrecedes(xid1, xid2 + CSNLOG_XACTS_PER_PAGE - 1));
+}
@@ -15,6 +15,7 @@
 
 #include "access/clog.h"
 #include "access/commit_ts.h"
+#include "access/csnlog.h"
 #include "access/subtrans.h"
 #include "access/transam.h"
 #include "access/xact.h"
@@ -199,11 +200,12 @@ GetNewTransactionId(bool isSubXact)
 	 * XID before we zero the page.  Fortunately, a page of the commit log
 	 * holds 32K or more transactions, so we don't have to do this very often.
 	 *
-	 * Extend pg_subtrans and pg_commit_ts too.
+	 * Extend pg_subtrans, pg_commit_ts and pg_csn too.
 	 */
 	ExtendCLOG(xid);
 	ExtendCommitTs(xid);
 	ExtendSUBTRANS(xid);
+	ExtendCSNLog(xid);
 
 	/*
 	 * Now advance the nextXid counter.  This must not happen until after we
@@ -212,6 +214,7 @@ GetNewTransactionId(bool isSubXact)
 	 * more XIDs until there is CLOG space for them.
 	 */
 	FullTransactionIdAdvance(&TransamVariables->nextXid);
+	CSNLogSetNextXid(TransamVariables->nextXid);
 
 	/*
 	 * We must store the new XID into the shared ProcArray before releasing
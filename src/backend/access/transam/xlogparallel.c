@@ -0,0 +1,703 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogparallel.c
+ *		Apply WAL records in parallel during recovery.
+ *
+ * Normally the startup process applies every WAL record itself, which limits
+ * replay to what one CPU can do.  With recovery_parallel_workers > 0, the
+ * startup process instead hands suitable records over to a set of background
+ * workers, which apply them concurrently while the startup process carries on
+ * decoding.
+ *
+ * A record is handed to a worker only if it modifies a single block, and the
+ * redo routine touches nothing else than that block and the free space map
+ * of the same relation.  All records of one relation go to the same worker,
+ * and each worker applies its records in the order it receives them, so the
+ * changes to any one page are still applied in WAL order.  Partitioning by
+ * relation rather than by block keeps the workers from racing each other to
+ * extend a relation, which redo does without the relation extension lock.
+ *
+ * Any other record acts as a barrier: before applying it, the startup
+ * process waits for the workers to apply everything that was handed to them
+ * so far.  That covers records touching several blocks, records that aren't
+ * about blocks at all (commits, DDL, checkpoints, and so on) and records that
+ * need to resolve conflicts with hot standby queries.  Since commit records
+ * are barriers, all changes of a transaction have been applied by the time it
+ * becomes visible to queries on a hot standby.  Records that change the
+ * visibility map are barriers too, so that an index-only scan can't see an
+ * index entry whose heap page still claims to be all-visible.
+ *
+ * Records are only handed out once recovery has reached a consistent state,
+ * which is when a standby spends its time keeping up with the primary.
+ * Before that, a reference to a missing page has to be remembered and checked
+ * later, which only the startup process can do.
+ *
+ * A record that has been handed to a worker counts as replayed as far as the
+ * startup process is concerned.  That's safe for the minimum recovery point,
+ * because replayEndRecPtr has already been advanced past the record before it
+ * is handed out, and restartpoints are only made at checkpoint records, which
+ * are barriers.
+ *
+ * During recovery, smgr caches relation sizes on the assumption that only
+ * the startup process changes them.  Workers extend relations too, so the
+ * startup process forgets the cached sizes of the relations it handed out
+ * after waiting for the workers, and a worker forgets the size of the
+ * relation before applying each record.  Workers don't receive relcache
+ * invalidations, so the startup process also tells them to close their files
+ * whenever it drops relations.  Dropping a database or a tablespace is
+ * covered by the PROCSIGNAL_BARRIER_SMGRRELEASE barrier, which the workers
+ * absorb like any other process.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *		src/backend/access/transam/xlogparallel.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/heapam_xlog.h"
+#include "access/nbtxlog.h"
+#include "access/xlog.h"
+#include "access/xlog_internal.h"
+#include "access/xlogparallel.h"
+#include "access/xlogrecovery.h"
+#include "access/xlogutils.h"
+#include "common/hashfn.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/startup.h"
+#include "storage/dsm.h"
+#include "storage/latch.h"
+#include "storage/proc.h"
+#include "storage/procsignal.h"
+#include "storage/shm_mq.h"
+#include "storage/shm_toc.h"
+#include "storage/smgr.h"
+#include "tcop/tcopprot.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/resowner.h"
+#include "utils/wait_event.h"
+
+#define PARALLEL_REDO_MAGIC			0x52454444
+
+#define PARALLEL_REDO_KEY_SHARED	1
+#define PARALLEL_REDO_KEY_QUEUES	2
+
+/* Size of each worker's queue */
+#define PARALLEL_REDO_QUEUE_SIZE	(256 * 1024)
+
+/* GUCs */
+int			recovery_parallel_workers = 0;
+
+/* Per-worker state in shared memory. */
+typedef struct ParallelRedoWorkerShared
+{
+	/* number of records applied so far */
+	pg_atomic_uint64 applied;
+} ParallelRedoWorkerShared;
+
+/* Shared state in the dynamic shared memory segment. */
+typedef struct ParallelRedoShared
+{
+	/* startup process, to be woken up when a worker has made progress */
+	ProcNumber	startup_procno;
+
+	/* set while the startup process waits for the workers */
+	pg_atomic_uint32 startup_waiting;
+
+	int			nworkers;
+	ParallelRedoWorkerShared workers[FLEXIBLE_ARRAY_MEMBER];
+} ParallelRedoShared;
+
+/*
+ * Header of the message that carries a record to a worker.  It's followed by
+ * a copy of the DecodedXLogRecord.  A message without a record, with base set
+ * to NULL, asks the worker to close all its files.
+ */
+typedef struct ParallelRedoMessage
+{
+	XLogRecPtr	ReadRecPtr;
+	XLogRecPtr	EndRecPtr;
+
+	/* address of the decoded record in the startup process */
+	char	   *base;
+} ParallelRedoMessage;
+
+/* State of parallel redo in the startup process. */
+typedef struct ParallelRedoState
+{
+	dsm_segment *seg;
+	ParallelRedoShared *shared;
+	int			nworkers;
+	BackgroundWorkerHandle **handles;
+	shm_mq_handle **queues;
+
+	/* number of records sent to each worker */
+	uint64	   *dispatched;
+
+	/* relations with records that may not have been applied yet */
+	HTAB	   *pending_rels;
+	bool		pending;
+} ParallelRedoState;
+
+static ParallelRedoState *redo_state = NULL;
+static bool redo_launch_failed = false;
+
+static bool ParallelRedoRecordIsEligible(XLogReaderState *record);
+static bool ParallelRedoLaunch(void);
+static void ParallelRedoCheckWorker(int i);
+static void parallel_redo_error_callback(void *arg);
+
+/*
+ * Can this record be applied by a worker, concurrently with records of other
+ * relations?  See the header comment for the rules.
+ */
+static bool
+ParallelRedoRecordIsEligible(XLogReaderState *record)
+{
+	uint8		info = XLogRecGetInfo(record) & ~XLR_INFO_MASK;
+	char	   *data = XLogRecGetData(record);
+
+	if (XLogRecMaxBlockId(record) != 0)
+		return false;
+	if ((XLogRecGetInfo(record) & XLR_CHECK_CONSISTENCY) != 0)
+		return false;
+
+	switch (XLogRecGetRmid(record))
+	{
+		case RM_HEAP_ID:
+			switch (info & XLOG_HEAP_OPMASK)
+			{
+				case XLOG_HEAP_INSERT:
+					return (((xl_heap_insert *) data)->flags &
+							(XLH_INSERT_ALL_VISIBLE_CLEARED |
+							 XLH_INSERT_ALL_FROZEN_SET)) == 0;
+				case XLOG_HEAP_DELETE:
+					return (((xl_heap_delete *) data)->flags &
+							XLH_DELETE_ALL_VISIBLE_CLEARED) == 0;
+				case XLOG_HEAP_HOT_UPDATE:
+					return (((xl_heap_update *) data)->flags &
+							(XLH_UPDATE_OLD_ALL_VISIBLE_CLEARED |
+							 XLH_UPDATE_NEW_ALL_VISIBLE_CLEARED)) == 0;
+				case XLOG_HEAP_LOCK:
+					return (((xl_heap_lock *) data)->flags &
+							XLH_LOCK_ALL_FROZEN_CLEARED) == 0;
+				case XLOG_HEAP_CONFIRM:
+					return true;
+			}
+			break;
+		case RM_HEAP2_ID:
+			switch (info & XLOG_HEAP_OPMASK)
+			{
+				case XLOG_HEAP2_MULTI_INSERT:
+					return (((xl_heap_multi_insert *) data)->flags &
+							(XLH_INSERT_ALL_VISIBLE_CLEARED |
+							 XLH_INSERT_ALL_FROZEN_SET)) == 0;
+				case XLOG_HEAP2_LOCK_UPDATED:
+					return (((xl_heap_lock_updated *) data)->flags &
+							XLH_LOCK_ALL_FROZEN_CLEARED) == 0;
+			}
+			break;
+		case RM_BTREE_ID:
+			switch (info)
+			{
+				case XLOG_BTREE_INSERT_LEAF:
+				case XLOG_BTREE_INSERT_POST:
+					return true;
+			}
+			break;
+	}
+
+	return false;
+}
+
+/*
+ * Start the workers, on first use.  Returns false if parallel redo isn't
+ * possible, in which case it won't be tried again.
+ */
+static bool
+ParallelRedoLaunch(void)
+{
+	ParallelRedoState *state;
+	shm_toc_estimator e;
+	shm_toc    *toc;
+	Size		shared_size;
+	Size		segsize;
+	char	   *queues;
+	BackgroundWorker worker;
+	HASHCTL		ctl;
+	int			nworkers = 0;
+	MemoryContext oldcontext;
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	shared_size = add_size(offsetof(ParallelRedoShared, workers),
+						   mul_size(sizeof(ParallelRedoWorkerShared),
+									recovery_parallel_workers));
+
+	shm_toc_initialize_estimator(&e);
+	shm_toc_estimate_chunk(&e, shared_size);
+	shm_toc_estimate_chunk(&e, mul_size(PARALLEL_REDO_QUEUE_SIZE,
+										recovery_parallel_workers));
+	shm_toc_estimate_keys(&e, 2);
+	segsize = shm_toc_estimate(&e);
+
+	state = palloc0(sizeof(ParallelRedoState));
+	state->seg = dsm_create(segsize, DSM_CREATE_NULL_IF_MAXSEGMENTS);
+	if (state->seg == NULL)
+	{
+		pfree(state);
+		MemoryContextSwitchTo(oldcontext);
+		return false;
+	}
+	/* keep the segment until the end of recovery */
+	dsm_pin_mapping(state->seg);
+
+	toc = shm_toc_create(PARALLEL_REDO_MAGIC, dsm_segment_address(state->seg),
+						 segsize);
+
+	state->shared = shm_toc_allocate(toc, shared_size);
+	state->shared->startup_procno = MyProcNumber;
+	pg_atomic_init_u32(&state->shared->startup_waiting, 0);
+	state->shared->nworkers = recovery_parallel_workers;
+	for (int i = 0; i < recovery_parallel_workers; i++)
+		pg_atomic_init_u64(&state->shared->workers[i].applied, 0);
+	shm_toc_insert(toc, PARALLEL_REDO_KEY_SHARED, state->shared);
+
+	queues = shm_toc_allocate(toc, mul_size(PARALLEL_REDO_QUEUE_SIZE,
+											recovery_parallel_workers));
+	shm_toc_insert(toc, PARALLEL_REDO_KEY_QUEUES, queues);
+
+	state->handles = palloc0(sizeof(BackgroundWorkerHandle *) *
+							 recovery_parallel_workers);
+	state->queues = palloc0(sizeof(shm_mq_handle *) *
+							recovery_parallel_workers);
+	state->dispatched = palloc0(sizeof(uint64) * recovery_parallel_workers);
+
+	memset(&worker, 0, sizeof(worker));
+	snprintf(worker.bgw_type, BGW_MAXLEN, "parallel redo worker");
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+	worker.bgw_start_time = BgWorkerStart_PostmasterStart;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	sprintf(worker.bgw_library_name, "postgres");
+	sprintf(worker.bgw_function_name, "ParallelRedoWorkerMain");
+	worker.bgw_main_arg = UInt32GetDatum(dsm_segment_handle(state->seg));
+	worker.bgw_notify_pid = MyProcPid;
+
+	for (int i = 0; i < recovery_parallel_workers; i++)
+	{
+		shm_mq	   *mq;
+
+		snprintf(worker.bgw_name, BGW_MAXLEN, "parallel redo worker %d", i);
+		memcpy(worker.bgw_extra, &i, sizeof(int));
+		if (!RegisterDynamicBackgroundWorker(&worker, &state->handles[i]))
+			break;
+
+		mq = shm_mq_create(queues + (Size) i * PARALLEL_REDO_QUEUE_SIZE,
+						   PARALLEL_REDO_QUEUE_SIZE);
+		shm_mq_set_sender(mq, MyProc);
+		state->queues[i] = shm_mq_attach(mq, state->seg, state->handles[i]);
+		nworkers++;
+	}
+
+	if (nworkers == 0)
+	{
+		ereport(LOG,
+				(errmsg("could not start parallel redo workers, applying WAL serially"),
+				 errhint("You might need to increase \"%s\".", "max_worker_processes")));
+		dsm_detach(state->seg);
+		pfree(state->handles);
+		pfree(state->queues);
+		pfree(state->dispatched);
+		pfree(state);
+		MemoryContextSwitchTo(oldcontext);
+		return false;
+	}
+	if (nworkers < recovery_parallel_workers)
+		ereport(LOG,
+				(errmsg("started only %d of %d parallel redo workers",
+						nworkers, recovery_parallel_workers),
+				 errhint("You might need to increase \"%s\".", "max_worker_processes")));
+	state->nworkers = nworkers;
+
+	ctl.keysize = sizeof(RelFileLocator);
+	ctl.entrysize = sizeof(RelFileLocator);
+	state->pending_rels = hash_create("parallel redo relations", 64, &ctl,
+									  HASH_ELEM | HASH_BLOBS);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	redo_state = state;
+
+	return true;
+}
+
+/*
+ * Raise an error if worker i has gone away.
+ */
+static void
+ParallelRedoCheckWorker(int i)
+{
+	pid_t		pid;
+
+	if (GetBackgroundWorkerPid(redo_state->handles[i], &pid) == BGWH_STOPPED)
+		ereport(FATAL,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("parallel redo worker %d exited unexpectedly", i)));
+}
+
+/*
+ * Try to hand the record over to a worker.
+ *
+ * Returns true if a worker will apply the record.  Otherwise, returns false
+ * after making sure that all records handed out earlier have been applied,
+ * so that the caller can apply the record itself.
+ */
+bool
+ParallelRedoDispatch(XLogReaderState *record)
+{
+	RelFileLocator rlocator;
+	ParallelRedoMessage msg;
+	shm_mq_iovec iov[2];
+	shm_mq_result res;
+	int			i;
+
+	if (recovery_parallel_workers == 0)
+		return false;
+
+	if (!reachedConsistency || !ParallelRedoRecordIsEligible(record))
+	{
+		ParallelRedoWaitForWorkers();
+		return false;
+	}
+
+	if (redo_state == NULL)
+	{
+		if (redo_launch_failed)
+			return false;
+		if (!ParallelRedoLaunch())
+		{
+			redo_launch_failed = true;
+			return false;
+		}
+	}
+
+	XLogRecGetBlockTag(record, 0, &rlocator, NULL, NULL);
+	i = hash_bytes((const unsigned char *) &rlocator,
+				   sizeof(RelFileLocator)) % redo_state->nworkers;
+
+	msg.ReadRecPtr = record->ReadRecPtr;
+	msg.EndRecPtr = record->EndRecPtr;
+	msg.base = (char *) record->record;
+	iov[0].data = (const char *) &msg;
+	iov[0].len = sizeof(msg);
+	iov[1].data = (const char *) record->record;
+	iov[1].len = record->record->size;
+
+	res = shm_mq_sendv(redo_state->queues[i], iov, 2, false, true);
+	if (res != SHM_MQ_SUCCESS)
+		ereport(FATAL,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("parallel redo worker %d exited unexpectedly", i)));
+
+	redo_state->dispatched[i]++;
+	redo_state->pending = true;
+	(void) hash_search(redo_state->pending_rels, &rlocator, HASH_ENTER, NULL);
+
+	return true;
+}
+
+/*
+ * Wait until the workers have applied all the records handed to them.
+ */
+void
+ParallelRedoWaitForWorkers(void)
+{
+	ParallelRedoShared *shared;
+	HASH_SEQ_STATUS status;
+	RelFileLocator *rlocator;
+
+	if (redo_state == NULL || !redo_state->pending)
+		return;
+
+	shared = redo_state->shared;
+
+	pg_atomic_write_u32(&shared->startup_waiting, 1);
+	pg_memory_barrier();
+
+	for (int i = 0; i < redo_state->nworkers; i++)
+	{
+		while (pg_atomic_read_u64(&shared->workers[i].applied) <
+			   redo_state->dispatched[i])
+		{
+			HandleStartupProcInterrupts();
+			ParallelRedoCheckWorker(i);
+
+			(void) WaitLatch(MyLatch,
+							 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+							 1000L,
+							 WAIT_EVENT_RECOVERY_PARALLEL_APPLY);
+			ResetLatch(MyLatch);
+		}
+	}
+
+	pg_atomic_write_u32(&shared->startup_waiting, 0);
+
+	/* The workers may have extended these relations. */
+	hash_seq_init(&status, redo_state->pending_rels);
+	while ((rlocator = hash_seq_search(&status)) != NULL)
+	{
+		smgrresetnblocks(smgropen(*rlocator, INVALID_PROC_NUMBER));
+		(void) hash_search(redo_state->pending_rels, rlocator, HASH_REMOVE,
+						   NULL);
+	}
+
+	redo_state->pending = false;
+}
+
+/*
+ * Tell the workers to close their files.  Called in the startup process when
+ * it has dropped relations, to release the disk space held by open files.
+ */
+void
+ParallelRedoReleaseFiles(void)
+{
+	ParallelRedoMessage msg;
+
+	if (redo_state == NULL)
+		return;
+
+	memset(&msg, 0, sizeof(msg));
+	for (int i = 0; i < redo_state->nworkers; i++)
+	{
+		if (shm_mq_send(redo_state->queues[i], sizeof(msg), &msg, false,
+						true) != SHM_MQ_SUCCESS)
+			ereport(FATAL,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("parallel redo worker %d exited unexpectedly", i)));
+		redo_state->dispatched[i]++;
+	}
+	redo_state->pending = true;
+}
+
+/*
+ * Wait for the workers to apply everything, and shut them down.  Called at
+ * the end of redo.
+ */
+void
+ParallelRedoShutdown(void)
+{
+	if (redo_state == NULL)
+		return;
+
+	ParallelRedoWaitForWorkers();
+
+	/* Detaching from the queues tells the workers to exit. */
+	for (int i = 0; i < redo_state->nworkers; i++)
+		shm_mq_detach(redo_state->queues[i]);
+	for (int i = 0; i < redo_state->nworkers; i++)
+		(void) WaitForBackgroundWorkerShutdown(redo_state->handles[i]);
+
+	dsm_detach(redo_state->seg);
+	hash_destroy(redo_state->pending_rels);
+	pfree(redo_state->handles);
+	pfree(redo_state->queues);
+	pfree(redo_state->dispatched);
+	pfree(redo_state);
+	redo_state = NULL;
+}
+
+/*
+ * Error context callback for errors in a worker.
+ */
+static void
+parallel_redo_error_callback(void *arg)
+{
+	XLogReaderState *record = (XLogReaderState *) arg;
+	RmgrData	rmgr;
+	const char *id;
+
+	/* not while waiting for the next record */
+	if (record->record == NULL)
+		return;
+
+	rmgr = GetRmgr(XLogRecGetRmid(record));
+	id = rmgr.rm_identify(XLogRecGetInfo(record));
+	errcontext("WAL redo at %X/%X for %s/%s in parallel redo worker",
+			   LSN_FORMAT_ARGS(record->ReadRecPtr), rmgr.rm_name,
+			   id ? id : "UNKNOWN");
+}
+
+/*
+ * Adjust a pointer into the startup process's copy of a decoded record to
+ * point into our copy.
+ */
+static inline char *
+relocate(char *ptr, char *oldbase, Size size, char *newbase)
+{
+	if (ptr >= oldbase && ptr < oldbase + size)
+		return newbase + (ptr - oldbase);
+	return ptr;
+}
+
+/*
+ * Main entry point for a parallel redo worker.
+ */
+void
+ParallelRedoWorkerMain(Datum main_arg)
+{
+	int			workerno;
+	dsm_segment *seg;
+	shm_toc    *toc;
+	ParallelRedoShared *shared;
+	char	   *queues;
+	shm_mq	   *mq;
+	shm_mq_handle *mqh;
+	XLogReaderState *reader;
+	MemoryContext redo_context;
+	DecodedXLogRecord *decoded = NULL;
+	Size		decoded_size = 0;
+	uint64		applied = 0;
+	ErrorContextCallback errcallback;
+
+	pqsignal(SIGTERM, die);
+
+	/*
+	 * Take part in ProcSignal barriers.  Dropping a database or a tablespace
+	 * relies on PROCSIGNAL_BARRIER_SMGRRELEASE to make everyone close their
+	 * files before they are unlinked.  This must happen before we open any.
+	 */
+	pqsignal(SIGUSR1, procsignal_sigusr1_handler);
+	ProcSignalInit();
+
+	BackgroundWorkerUnblockSignals();
+
+	memcpy(&workerno, MyBgworkerEntry->bgw_extra, sizeof(int));
+
+	seg = dsm_attach(DatumGetUInt32(main_arg));
+	if (seg == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not map dynamic shared memory segment")));
+	toc = shm_toc_attach(PARALLEL_REDO_MAGIC, dsm_segment_address(seg));
+	if (toc == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("invalid magic number in dynamic shared memory segment")));
+	shared = shm_toc_lookup(toc, PARALLEL_REDO_KEY_SHARED, false);
+	queues = shm_toc_lookup(toc, PARALLEL_REDO_KEY_QUEUES, false);
+
+	/* Buffer pins need a resource owner. */
+	CurrentResourceOwner = ResourceOwnerCreate(NULL, "parallel redo worker");
+
+	mq = (shm_mq *) (queues + (Size) workerno * PARALLEL_REDO_QUEUE_SIZE);
+	shm_mq_set_receiver(mq, MyProc);
+	mqh = shm_mq_attach(mq, seg, NULL);
+
+	/*
+	 * Behave like the startup process as far as the redo routines are
+	 * concerned.  Records are only handed out after reaching consistency.
+	 */
+	InRecovery = true;
+	reachedConsistency = true;
+
+	reader = XLogReaderAllocate(wal_segment_size, NULL, XL_ROUTINE(), NULL);
+	if (reader == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory"),
+				 errdetail("Failed while allocating a WAL reading processor.")));
+
+	redo_context = AllocSetContextCreate(TopMemoryContext,
+										 "parallel redo",
+										 ALLOCSET_DEFAULT_SIZES);
+
+	RmgrStartup();
+
+	errcallback.callback = parallel_redo_error_callback;
+	errcallback.arg = (void *) reader;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	for (;;)
+	{
+		shm_mq_result res;
+		Size		nbytes;
+		void	   *data;
+		ParallelRedoMessage msg;
+		Size		size;
+		RelFileLocator rlocator;
+		MemoryContext oldcontext;
+
+		CHECK_FOR_INTERRUPTS();
+
+		res = shm_mq_receive(mqh, &nbytes, &data, false);
+		if (res == SHM_MQ_DETACHED)
+			break;
+		Assert(nbytes >= sizeof(msg));
+
+		memcpy(&msg, data, sizeof(msg));
+		if (msg.base == NULL)
+		{
+			/* Relations have been dropped, see ParallelRedoReleaseFiles() */
+			smgrdestroyall();
+			goto done;
+		}
+
+		size = nbytes - sizeof(msg);
+		if (size > decoded_size)
+		{
+			if (decoded)
+				pfree(decoded);
+			decoded_size = Max(size, BLCKSZ * 2);
+			decoded = MemoryContextAlloc(TopMemoryContext, decoded_size);
+		}
+		memcpy(decoded, (char *) data + sizeof(msg), size);
+
+		/* Make the internal pointers of the record point into our copy. */
+		decoded->next = NULL;
+		decoded->oversized = false;
+		decoded->main_data = relocate(decoded->main_data, msg.base, size,
+									  (char *) decoded);
+		for (int block_id = 0; block_id <= decoded->max_block_id; block_id++)
+		{
+			DecodedBkpBlock *blk = &decoded->blocks[block_id];
+
+			blk->bkp_image = relocate(blk->bkp_image, msg.base, size,
+									  (char *) decoded);
+			blk->data = relocate(blk->data, msg.base, size, (char *) decoded);
+		}
+
+		reader->record = decoded;
+		reader->ReadRecPtr = msg.ReadRecPtr;
+		reader->EndRecPtr = msg.EndRecPtr;
+
+		/* The startup process may have changed the size of the relation. */
+		XLogRecGetBlockTag(reader, 0, &rlocator, NULL, NULL);
+		smgrresetnblocks(smgropen(rlocator, INVALID_PROC_NUMBER));
+
+		oldcontext = MemoryContextSwitchTo(redo_context);
+		GetRmgr(XLogRecGetRmid(reader)).rm_redo(reader);
+		MemoryContextSwitchTo(oldcontext);
+		MemoryContextReset(redo_context);
+
+		reader->record = NULL;
+
+done:
+		/* Report progress, and wake up the startup process if it's waiting. */
+		pg_atomic_write_membarrier_u64(&shared->workers[workerno].applied,
+									   ++applied);
+		if (pg_atomic_read_u32(&shared->startup_waiting) != 0)
+			SetLatch(&GetPGProcByNumber(shared->startup_procno)->procLatch);
+	}
+
+	error_context_stack = errcallback.previous;
+
+	RmgrCleanup();
+}
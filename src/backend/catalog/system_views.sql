@@ -868,6 +868,7 @@ CREATE VIEW pg_stat_activity AS
             D.datname AS datname,
             S.pid,
             S.leader_pid,
+            S.session_pid,
             S.usesysid,
             U.rolname AS usename,
             S.application_name,
@@ -916,6 +917,15 @@ CREATE VIEW pg_stat_replication AS
         JOIN pg_stat_get_wal_senders() AS W ON (S.pid = W.pid)
         LEFT JOIN pg_authid AS U ON (S.usesysid = U.oid);
 
+CREATE VIEW pg_stat_shared_catcache AS
+    SELECT
+            s.cache_id,
+            s.relid,
+            s.indexrelid,
+            s.hits,
+            s.misses
+    FROM pg_stat_get_shared_catcache() s;
+
 CREATE VIEW pg_stat_slru AS
     SELECT
             s.name,
@@ -1034,6 +1044,7 @@ CREATE VIEW pg_stat_replication_slots AS
             s.spill_txns,
             s.spill_count,
             s.spill_bytes,
+            s.spill_written_bytes,
             s.stream_txns,
             s.stream_count,
             s.stream_bytes,
@@ -1359,7 +1370,7 @@ REVOKE ALL ON pg_replication_origin_status FROM public;
 REVOKE ALL ON pg_subscription FROM public;
 GRANT SELECT (oid, subdbid, subskiplsn, subname, subowner, subenabled,
               subbinary, substream, subtwophasestate, subdisableonerr,
-			  subpasswordrequired, subrunasowner, subfailover,
+			  subpasswordrequired, subrunasowner, subfailover, subparallelapply,
               subslotname, subsynccommit, subpublications, suborigin)
     ON pg_subscription TO public;
 
@@ -761,6 +761,17 @@ Async_Unlisten(const char *channel)
 	queue_listen(LISTEN_UNLISTEN, channel);
 }
 
+/*
+ * Async_IsListening
+ *
+ *		Is this backend listening on any channel?
+ */
+bool
+Async_IsListening(void)
+{
+	return listenChannels != NIL;
+}
+
 /*
  * Async_UnlistenAll
  *
@@ -0,0 +1,2001 @@
+/*-------------------------------------------------------------------------
+ *
+ * copyarrow.c
+ *		Arrow IPC format for COPY TO and COPY FROM.
+ *
+ * COPY ... (FORMAT arrow) writes and reads the Arrow IPC streaming format:
+ * a Schema message describing the columns, followed by RecordBatch messages
+ * holding the values of a batch of rows column by column, and an
+ * end-of-stream marker.  Each message consists of a flatbuffer with the
+ * message's metadata, followed by a body with the buffers of the columns.
+ * We build and parse the few flatbuffer tables we need by hand, following
+ * the layouts of Schema.fbs and Message.fbs of the Arrow format, rather
+ * than depend on a flatbuffers library.
+ *
+ * Columns of the types with an Arrow counterpart (bool, the integer and
+ * floating point types, date, time, timestamp and timestamptz) are stored
+ * in the fixed-width Arrow layout, and converted to and from Datums without
+ * calling the type's output or input function.  COPY FROM converts them a
+ * chunk of rows at a time.  bytea is stored as Binary, and all other types
+ * as Utf8 strings in their text representation.
+ *
+ * On input we also accept the Arrow IPC file format, which frames the
+ * stream with a magic string and ends it with a footer that we ignore.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/commands/copyarrow.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "catalog/pg_type.h"
+#include "commands/copyarrow.h"
+#include "commands/copyfrom_internal.h"
+#include "common/int.h"
+#include "datatype/timestamp.h"
+#include "mb/pg_wchar.h"
+#include "port/pg_bswap.h"
+#include "utils/builtins.h"
+#include "utils/date.h"
+#include "utils/datetime.h"
+#include "utils/float.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+
+/* Message framing */
+#define ARROW_CONTINUATION		0xFFFFFFFF
+#define ARROW_FILE_MAGIC		"ARROW1\0\0"
+
+/* MetadataVersion */
+#define ARROW_METADATA_V4		3
+#define ARROW_METADATA_V5		4
+
+/* MessageHeader union */
+#define ARROW_HEADER_SCHEMA				1
+#define ARROW_HEADER_DICTIONARY_BATCH	2
+#define ARROW_HEADER_RECORD_BATCH		3
+
+/* Type union */
+#define ARROW_TYPE_NULL				1
+#define ARROW_TYPE_INT				2
+#define ARROW_TYPE_FLOATING_POINT	3
+#define ARROW_TYPE_BINARY			4
+#define ARROW_TYPE_UTF8				5
+#define ARROW_TYPE_BOOL				6
+#define ARROW_TYPE_DATE				8
+#define ARROW_TYPE_TIME				9
+#define ARROW_TYPE_TIMESTAMP		10
+#define ARROW_TYPE_LARGE_BINARY		19
+#define ARROW_TYPE_LARGE_UTF8		20
+
+/* Precision, DateUnit and TimeUnit enums */
+#define ARROW_PRECISION_HALF		0
+#define ARROW_PRECISION_SINGLE		1
+#define ARROW_PRECISION_DOUBLE		2
+#define ARROW_DATE_DAY				0
+#define ARROW_DATE_MILLISECOND		1
+#define ARROW_TIME_SECOND			0
+#define ARROW_TIME_MILLISECOND		1
+#define ARROW_TIME_MICROSECOND		2
+#define ARROW_TIME_NANOSECOND		3
+
+/* Field ids in the flatbuffer tables we use */
+#define MESSAGE_VERSION				0
+#define MESSAGE_HEADER_TYPE			1
+#define MESSAGE_HEADER				2
+#define MESSAGE_BODY_LENGTH			3
+#define SCHEMA_ENDIANNESS			0
+#define SCHEMA_FIELDS				1
+#define FIELD_NAME					0
+#define FIELD_NULLABLE				1
+#define FIELD_TYPE_TYPE				2
+#define FIELD_TYPE					3
+#define FIELD_DICTIONARY			4
+#define FIELD_CHILDREN				5
+#define INT_BIT_WIDTH				0
+#define INT_IS_SIGNED				1
+#define FLOATING_POINT_PRECISION	0
+#define DATE_UNIT					0
+#define TIME_UNIT					0
+#define TIME_BIT_WIDTH				1
+#define TIMESTAMP_UNIT				0
+#define TIMESTAMP_TIMEZONE			1
+#define RECORD_BATCH_LENGTH			0
+#define RECORD_BATCH_NODES			1
+#define RECORD_BATCH_BUFFERS		2
+#define RECORD_BATCH_COMPRESSION	3
+
+/* Size of the FieldNode and Buffer structs */
+#define ARROW_FIELD_NODE_SIZE		16
+#define ARROW_BUFFER_SIZE			16
+
+/* The Unix epoch, which Arrow dates and times count from */
+#define ARROW_EPOCH_DAYS	(POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE)
+#define ARROW_EPOCH_USECS	((int64) ARROW_EPOCH_DAYS * USECS_PER_DAY)
+
+/* COPY TO sends a record batch when either limit is reached */
+#define ARROW_BATCH_ROWS	65536
+#define ARROW_BATCH_BYTES	(16 * 1024 * 1024)
+
+/* COPY FROM converts fixed-width values this many rows at a time */
+#define ARROW_CHUNK_ROWS	1024
+
+/*
+ * How the values of a column are converted between Datums and Arrow.
+ */
+typedef enum ArrowConversion
+{
+	ARROW_CONV_NULL,			/* Null to any type; input only */
+	ARROW_CONV_BOOL,			/* bool and Bool */
+	ARROW_CONV_INT,				/* int2, int4, int8 and Int */
+	ARROW_CONV_FLOAT,			/* float4, float8 and FloatingPoint */
+	ARROW_CONV_DATE,			/* date and Date */
+	ARROW_CONV_TIME,			/* time and Time */
+	ARROW_CONV_TIMESTAMP,		/* timestamp[tz] and Timestamp */
+	ARROW_CONV_BYTEA,			/* bytea and Binary */
+	ARROW_CONV_TEXT,			/* string types and Utf8, directly */
+	ARROW_CONV_STRING,			/* any type and Utf8, by output/input func */
+} ArrowConversion;
+
+#define ARROW_CONV_IS_FIXED(conv) \
+	((conv) >= ARROW_CONV_BOOL && (conv) <= ARROW_CONV_TIMESTAMP)
+
+/* State of one column during COPY TO */
+typedef struct ArrowWriteColumn
+{
+	int			attnum;
+	ArrowConversion conv;
+	Oid			typid;			/* base type of the column */
+	bool		nullable;
+	FmgrInfo   *out_function;	/* for ARROW_CONV_STRING */
+	int64		null_count;		/* NULLs in the current batch */
+	StringInfoData validity;	/* validity bitmap */
+	StringInfoData values;		/* fixed-width values, or Utf8 offsets */
+	StringInfoData data;		/* Utf8 and Binary data */
+} ArrowWriteColumn;
+
+struct ArrowWriteState
+{
+	TupleDesc	tupdesc;
+	int			ncolumns;
+	ArrowWriteColumn *columns;
+	int64		nrows;			/* rows in the current batch */
+	int64		data_bytes;		/* Utf8 and Binary data in the batch */
+};
+
+/* State of one column during COPY FROM */
+typedef struct ArrowReadColumn
+{
+	int			attnum;
+	const char *attname;
+	ArrowConversion conv;
+	Oid			typid;			/* base type of the column */
+	int32		typmod;			/* typmod of the base type */
+	Oid			domain_typid;	/* type of the column, if a domain */
+	void	   *domain_extra;	/* cache for domain_check() */
+
+	/* Arrow type of the field */
+	int			type;			/* ARROW_TYPE_xxx */
+	int			bit_width;		/* of Int, FloatingPoint and Time */
+	bool		is_signed;		/* of Int */
+	int			unit;			/* of Date, Time and Timestamp */
+	int			width;			/* bytes per fixed-width value */
+	bool		large;			/* LargeUtf8 or LargeBinary? */
+
+	/* Buffers in the current record batch */
+	const char *validity;		/* validity bitmap, NULL if no NULLs */
+	const char *values;			/* fixed-width values, or offsets */
+	const char *data;			/* Utf8 and Binary data */
+	int64		data_len;
+
+	/* Fixed-width values of the current chunk, converted to Datums */
+	Datum	   *datums;
+	bool	   *isnull;
+} ArrowReadColumn;
+
+struct ArrowReadState
+{
+	bool		file_format;	/* reading the IPC file format? */
+	bool		have_word;		/* is first_word still to be consumed? */
+	uint32		first_word;		/* first word of the input, if not magic */
+	bool		done;			/* reached the end of the stream? */
+	int			ncolumns;
+	ArrowReadColumn *columns;
+	MemoryContext batchcxt;		/* holds the current record batch */
+	int64		nrows;			/* rows in the current record batch */
+	int64		row;			/* next row of the batch to return */
+	int64		chunk_start;	/* first row of the converted chunk */
+	int			chunk_rows;		/* rows in the converted chunk */
+};
+
+static const char *const arrow_type_names[] = {
+	"NONE", "Null", "Int", "FloatingPoint", "Binary", "Utf8", "Bool",
+	"Decimal", "Date", "Time", "Timestamp", "Interval", "List", "Struct",
+	"Union", "FixedSizeBinary", "FixedSizeList", "Map", "Duration",
+	"LargeBinary", "LargeUtf8", "LargeList", "RunEndEncoded", "BinaryView",
+	"Utf8View", "ListView", "LargeListView",
+};
+
+
+/*
+ * Arrow data is little-endian.  These load and store integers of the given
+ * size, without any alignment requirement.
+ */
+static inline uint16
+arrow_get16(const char *p)
+{
+	uint16		val;
+
+	memcpy(&val, p, sizeof(val));
+#ifdef WORDS_BIGENDIAN
+	val = pg_bswap16(val);
+#endif
+	return val;
+}
+
+static inline uint32
+arrow_get32(const char *p)
+{
+	uint32		val;
+
+	memcpy(&val, p, sizeof(val));
+#ifdef WORDS_BIGENDIAN
+	val = pg_bswap32(val);
+#endif
+	return val;
+}
+
+static inline uint64
+arrow_get64(const char *p)
+{
+	uint64		val;
+
+	memcpy(&val, p, sizeof(val));
+#ifdef WORDS_BIGENDIAN
+	val = pg_bswap64(val);
+#endif
+	return val;
+}
+
+static inline void
+arrow_put16(StringInfo buf, uint16 val)
+{
+#ifdef WORDS_BIGENDIAN
+	val = pg_bswap16(val);
+#endif
+	appendBinaryStringInfo(buf, &val, sizeof(val));
+}
+
+static inline void
+arrow_put32(StringInfo buf, uint32 val)
+{
+#ifdef WORDS_BIGENDIAN
+	val = pg_bswap32(val);
+#endif
+	appendBinaryStringInfo(buf, &val, sizeof(val));
+}
+
+static inline void
+arrow_put64(StringInfo buf, uint64 val)
+{
+#ifdef WORDS_BIGENDIAN
+	val = pg_bswap64(val);
+#endif
+	appendBinaryStringInfo(buf, &val, sizeof(val));
+}
+
+static void
+arrow_pad(StringInfo buf, int align)
+{
+	while (buf->len % align != 0)
+		appendStringInfoChar(buf, '\0');
+}
+
+/* Division rounding towards minus infinity, for a positive divisor */
+static inline int64
+arrow_floor_div(int64 a, int64 b)
+{
+	int64		q = a / b;
+
+	if (a % b != 0 && a < 0)
+		q--;
+	return q;
+}
+
+
+/*
+ * Flatbuffer builder.
+ *
+ * Flatbuffers are normally built back to front, so that all offsets point
+ * forward.  We build ours front to back instead: a table is written with
+ * placeholders for the offsets of its strings, vectors and subtables, which
+ * are patched after those have been appended.  Each table is preceded by
+ * its own vtable.  Scalars are aligned to their size relative to the start
+ * of the flatbuffer, which is 8-byte aligned in the stream.
+ */
+#define FB_MAX_FIELDS	8
+
+typedef struct FbField
+{
+	int			id;				/* field id in the table's schema */
+	int			size;			/* 1, 2, 4 or 8 bytes */
+	uint64		value;			/* scalar value, 0 for offsets */
+	int			pos;			/* set to the field's position */
+} FbField;
+
+static int
+fb_add_table(StringInfo buf, FbField *fields, int nfields)
+{
+	uint16		voffsets[FB_MAX_FIELDS] = {0};
+	int			nvoffsets = 0;
+	int			tblsize = 4;
+	int			vtpos;
+	int			tblpos;
+
+	/*
+	 * Lay out the fields by decreasing size.  The table starts 4 bytes before
+	 * an 8-byte boundary, which puts every field at a multiple of its size.
+	 */
+	for (int size = 8; size >= 1; size /= 2)
+	{
+		for (int i = 0; i < nfields; i++)
+		{
+			if (fields[i].size != size)
+				continue;
+			Assert(fields[i].id < FB_MAX_FIELDS);
+			voffsets[fields[i].id] = tblsize;
+			nvoffsets = Max(nvoffsets, fields[i].id + 1);
+			tblsize += size;
+		}
+	}
+
+	arrow_pad(buf, 2);
+	vtpos = buf->len;
+	arrow_put16(buf, 4 + 2 * nvoffsets);
+	arrow_put16(buf, tblsize);
+	for (int i = 0; i < nvoffsets; i++)
+		arrow_put16(buf, voffsets[i]);
+
+	while (buf->len % 8 != 4)
+		appendStringInfoChar(buf, '\0');
+	tblpos = buf->len;
+	arrow_put32(buf, tblpos - vtpos);
+	for (int size = 8; size >= 1; size /= 2)
+	{
+		for (int i = 0; i < nfields; i++)
+		{
+			if (fields[i].size != size)
+				continue;
+			fields[i].pos = buf->len;
+			if (size == 8)
+				arrow_put64(buf, fields[i].value);
+			else if (size == 4)
+				arrow_put32(buf, (uint32) fields[i].value);
+			else if (size == 2)
+				arrow_put16(buf, (uint16) fields[i].value);
+			else
+				appendStringInfoChar(buf, (char) fields[i].value);
+		}
+	}
+
+	return tblpos;
+}
+
+/*
+ * Start a vector of 'nelems' elements, whose elements are aligned to
+ * 'align' bytes.  The caller appends the elements.
+ */
+static int
+fb_start_vector(StringInfo buf, uint32 nelems, int align)
+{
+	int			pos;
+
+	while ((buf->len + 4) % align != 0)
+		appendStringInfoChar(buf, '\0');
+	pos = buf->len;
+	arrow_put32(buf, nelems);
+	return pos;
+}
+
+static int
+fb_add_string(StringInfo buf, const char *str, int len)
+{
+	int			pos = fb_start_vector(buf, len, 4);
+
+	appendBinaryStringInfo(buf, str, len);
+	appendStringInfoChar(buf, '\0');
+	return pos;
+}
+
+/* Point the offset at 'pos' to the object at 'target' */
+static void
+fb_patch(StringInfo buf, int pos, int target)
+{
+	uint32		offset = target - pos;
+
+	Assert(target > pos);
+#ifdef WORDS_BIGENDIAN
+	offset = pg_bswap32(offset);
+#endif
+	memcpy(buf->data + pos, &offset, sizeof(offset));
+}
+
+
+/*
+ * Flatbuffer parser.
+ *
+ * The input is untrusted, so every position is checked against the length
+ * of the flatbuffer before it is dereferenced.  Positions of fields and
+ * objects are always at least 4, so 0 means that a field is absent.
+ */
+typedef struct FbBuf
+{
+	const char *data;
+	uint32		len;
+} FbBuf;
+
+static void fb_error(void) pg_attribute_noreturn();
+
+static void
+fb_error(void)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+			 errmsg("invalid Arrow message metadata")));
+}
+
+/* Follow the offset at 'pos' */
+static uint32
+fb_deref(const FbBuf *fb, uint32 pos)
+{
+	uint32		offset = arrow_get32(fb->data + pos);
+
+	if (offset == 0 || (uint64) pos + offset > fb->len - 4)
+		fb_error();
+	return pos + offset;
+}
+
+/* Find field 'id' of 'size' bytes in the table at 'tpos' */
+static uint32
+fb_field(const FbBuf *fb, uint32 tpos, int id, int size)
+{
+	int64		vtpos;
+	uint16		vtsize;
+	uint16		tblsize;
+	uint16		voffset;
+
+	if (tpos == 0 || tpos > fb->len - 4)
+		fb_error();
+	vtpos = (int64) tpos - (int32) arrow_get32(fb->data + tpos);
+	if (vtpos < 0 || vtpos > fb->len - 4 || vtpos % 2 != 0)
+		fb_error();
+	vtsize = arrow_get16(fb->data + vtpos);
+	tblsize = arrow_get16(fb->data + vtpos + 2);
+	if (vtsize < 4 || vtsize % 2 != 0 || vtpos + vtsize > fb->len ||
+		tblsize < 4 || (uint64) tpos + tblsize > fb->len)
+		fb_error();
+
+	if (4 + 2 * id >= vtsize)
+		return 0;
+	voffset = arrow_get16(fb->data + vtpos + 4 + 2 * id);
+	if (voffset == 0)
+		return 0;
+	if (voffset < 4 || voffset + size > tblsize)
+		fb_error();
+	return tpos + voffset;
+}
+
+static int64
+fb_get_int(const FbBuf *fb, uint32 tpos, int id, int size, int64 defval)
+{
+	uint32		pos = fb_field(fb, tpos, id, size);
+
+	if (pos == 0)
+		return defval;
+	switch (size)
+	{
+		case 1:
+			return (uint8) fb->data[pos];
+		case 2:
+			return (int16) arrow_get16(fb->data + pos);
+		case 4:
+			return (int32) arrow_get32(fb->data + pos);
+		default:
+			return (int64) arrow_get64(fb->data + pos);
+	}
+}
+
+/* Position of the table, vector or string field 'id' points to, or 0 */
+static uint32
+fb_get_offset(const FbBuf *fb, uint32 tpos, int id)
+{
+	uint32		pos = fb_field(fb, tpos, id, 4);
+
+	if (pos == 0)
+		return 0;
+	return fb_deref(fb, pos);
+}
+
+/* Position of the first element of vector field 'id', or 0 */
+static uint32
+fb_get_vector(const FbBuf *fb, uint32 tpos, int id, int elemsize,
+			  uint32 *nelems)
+{
+	uint32		pos = fb_get_offset(fb, tpos, id);
+
+	*nelems = 0;
+	if (pos == 0)
+		return 0;
+	*nelems = arrow_get32(fb->data + pos);
+	if ((uint64) *nelems * elemsize > fb->len - pos - 4)
+		fb_error();
+	return pos + 4;
+}
+
+
+/*
+ * Start a Message flatbuffer with the given header type.  Returns the
+ * position of the header offset, to be patched by the caller.
+ */
+static int
+ArrowBeginMessage(StringInfo meta, int header_type, int64 body_length)
+{
+	FbField		message[] = {
+		{MESSAGE_VERSION, 2, ARROW_METADATA_V5},
+		{MESSAGE_HEADER_TYPE, 1, header_type},
+		{MESSAGE_HEADER, 4, 0},
+		{MESSAGE_BODY_LENGTH, 8, body_length},
+	};
+	int			tblpos;
+
+	/* root offset */
+	arrow_put32(meta, 0);
+	tblpos = fb_add_table(meta, message, lengthof(message));
+	fb_patch(meta, 0, tblpos);
+
+	return message[2].pos;
+}
+
+/*
+ * Append an encapsulated message, consisting of a continuation marker, the
+ * length of the metadata, and the metadata padded to 8 bytes.  The caller
+ * appends the body.
+ */
+static void
+ArrowAppendMessage(StringInfo buf, StringInfo meta)
+{
+	arrow_pad(meta, 8);
+	arrow_put32(buf, ARROW_CONTINUATION);
+	arrow_put32(buf, meta->len);
+	appendBinaryStringInfo(buf, meta->data, meta->len);
+}
+
+/* Append the Type table of a column */
+static int
+ArrowAddType(StringInfo meta, ArrowWriteColumn *col)
+{
+	FbField		fields[2];
+	int			nfields = 0;
+	int			tblpos;
+
+	switch (col->conv)
+	{
+		case ARROW_CONV_INT:
+			fields[0] = (FbField) {INT_BIT_WIDTH, 4, get_typlen(col->typid) * 8};
+			fields[1] = (FbField) {INT_IS_SIGNED, 1, 1};
+			nfields = 2;
+			break;
+		case ARROW_CONV_FLOAT:
+			fields[0] = (FbField) {FLOATING_POINT_PRECISION, 2,
+				col->typid == FLOAT4OID ? ARROW_PRECISION_SINGLE : ARROW_PRECISION_DOUBLE};
+			nfields = 1;
+			break;
+		case ARROW_CONV_DATE:
+			fields[0] = (FbField) {DATE_UNIT, 2, ARROW_DATE_DAY};
+			nfields = 1;
+			break;
+		case ARROW_CONV_TIME:
+			fields[0] = (FbField) {TIME_UNIT, 2, ARROW_TIME_MICROSECOND};
+			fields[1] = (FbField) {TIME_BIT_WIDTH, 4, 64};
+			nfields = 2;
+			break;
+		case ARROW_CONV_TIMESTAMP:
+			fields[0] = (FbField) {TIMESTAMP_UNIT, 2, ARROW_TIME_MICROSECOND};
+			fields[1] = (FbField) {TIMESTAMP_TIMEZONE, 4, 0};
+			nfields = col->typid == TIMESTAMPTZOID ? 2 : 1;
+			break;
+		default:
+			/* Bool, Binary and Utf8 have no fields */
+			break;
+	}
+
+	tblpos = fb_add_table(meta, fields, nfields);
+	if (col->conv == ARROW_CONV_TIMESTAMP && col->typid == TIMESTAMPTZOID)
+		fb_patch(meta, fields[1].pos, fb_add_string(meta, "UTC", 3));
+
+	return tblpos;
+}
+
+static int
+ArrowTypeOf(ArrowConversion conv)
+{
+	switch (conv)
+	{
+		case ARROW_CONV_NULL:
+			return ARROW_TYPE_NULL;
+		case ARROW_CONV_BOOL:
+			return ARROW_TYPE_BOOL;
+		case ARROW_CONV_INT:
+			return ARROW_TYPE_INT;
+		case ARROW_CONV_FLOAT:
+			return ARROW_TYPE_FLOATING_POINT;
+		case ARROW_CONV_DATE:
+			return ARROW_TYPE_DATE;
+		case ARROW_CONV_TIME:
+			return ARROW_TYPE_TIME;
+		case ARROW_CONV_TIMESTAMP:
+			return ARROW_TYPE_TIMESTAMP;
+		case ARROW_CONV_BYTEA:
+			return ARROW_TYPE_BINARY;
+		case ARROW_CONV_TEXT:
+		case ARROW_CONV_STRING:
+			return ARROW_TYPE_UTF8;
+	}
+	return ARROW_TYPE_NULL;		/* keep compiler quiet */
+}
+
+/* Start the buffers of a new record batch */
+static void
+ArrowResetColumn(ArrowWriteColumn *col)
+{
+	resetStringInfo(&col->validity);
+	resetStringInfo(&col->values);
+	resetStringInfo(&col->data);
+	col->null_count = 0;
+
+	/* The offsets of Utf8 and Binary values start with a 0 */
+	if (col->conv == ARROW_CONV_BYTEA || col->conv == ARROW_CONV_TEXT ||
+		col->conv == ARROW_CONV_STRING)
+		arrow_put32(&col->values, 0);
+}
+
+/*
+ * Set up the conversion of the columns for COPY TO.  out_functions must
+ * hold the text output functions, which are used for the columns of types
+ * with no Arrow counterpart.
+ */
+ArrowWriteState *
+ArrowWriteBegin(TupleDesc tupDesc, List *attnumlist, FmgrInfo *out_functions)
+{
+	ArrowWriteState *state = palloc0(sizeof(ArrowWriteState));
+	ListCell   *cur;
+	int			i = 0;
+
+	state->tupdesc = tupDesc;
+	state->ncolumns = list_length(attnumlist);
+	state->columns = palloc0(state->ncolumns * sizeof(ArrowWriteColumn));
+
+	foreach(cur, attnumlist)
+	{
+		int			attnum = lfirst_int(cur);
+		Form_pg_attribute attr = TupleDescAttr(tupDesc, attnum - 1);
+		ArrowWriteColumn *col = &state->columns[i++];
+
+		col->attnum = attnum;
+		col->typid = getBaseType(attr->atttypid);
+		col->nullable = !attr->attnotnull;
+		col->out_function = &out_functions[attnum - 1];
+
+		switch (col->typid)
+		{
+			case BOOLOID:
+				col->conv = ARROW_CONV_BOOL;
+				break;
+			case INT2OID:
+			case INT4OID:
+			case INT8OID:
+				col->conv = ARROW_CONV_INT;
+				break;
+			case FLOAT4OID:
+			case FLOAT8OID:
+				col->conv = ARROW_CONV_FLOAT;
+				break;
+			case DATEOID:
+				col->conv = ARROW_CONV_DATE;
+				break;
+			case TIMEOID:
+				col->conv = ARROW_CONV_TIME;
+				break;
+			case TIMESTAMPOID:
+			case TIMESTAMPTZOID:
+				col->conv = ARROW_CONV_TIMESTAMP;
+				break;
+			case BYTEAOID:
+				col->conv = ARROW_CONV_BYTEA;
+				break;
+			case TEXTOID:
+			case VARCHAROID:
+			case BPCHAROID:
+				col->conv = ARROW_CONV_TEXT;
+				break;
+			default:
+				col->conv = ARROW_CONV_STRING;
+				break;
+		}
+
+		initStringInfo(&col->validity);
+		initStringInfo(&col->values);
+		initStringInfo(&col->data);
+		ArrowResetColumn(col);
+	}
+
+	return state;
+}
+
+/*
+ * Append the Schema message to 'buf'.
+ */
+void
+ArrowWriteSchema(ArrowWriteState *state, StringInfo buf)
+{
+	StringInfoData meta;
+	FbField		schema[] = {
+		{SCHEMA_ENDIANNESS, 2, 0},
+		{SCHEMA_FIELDS, 4, 0},
+	};
+	int			header;
+	int			fields;
+
+	initStringInfo(&meta);
+	header = ArrowBeginMessage(&meta, ARROW_HEADER_SCHEMA, 0);
+	fb_patch(&meta, header, fb_add_table(&meta, schema, lengthof(schema)));
+
+	fields = fb_start_vector(&meta, state->ncolumns, 4);
+	fb_patch(&meta, schema[1].pos, fields);
+	for (int i = 0; i < state->ncolumns; i++)
+		arrow_put32(&meta, 0);
+
+	for (int i = 0; i < state->ncolumns; i++)
+	{
+		ArrowWriteColumn *col = &state->columns[i];
+		Form_pg_attribute attr = TupleDescAttr(state->tupdesc, col->attnum - 1);
+		FbField		field[] = {
+			{FIELD_NAME, 4, 0},
+			{FIELD_NULLABLE, 1, col->nullable},
+			{FIELD_TYPE_TYPE, 1, ArrowTypeOf(col->conv)},
+			{FIELD_TYPE, 4, 0},
+			{FIELD_CHILDREN, 4, 0},
+		};
+		const char *name = NameStr(attr->attname);
+		const char *utf8name;
+
+		fb_patch(&meta, fields + 4 + 4 * i,
+				 fb_add_table(&meta, field, lengthof(field)));
+
+		utf8name = pg_server_to_any(name, strlen(name), PG_UTF8);
+		fb_patch(&meta, field[0].pos,
+				 fb_add_string(&meta, utf8name, strlen(utf8name)));
+		fb_patch(&meta, field[3].pos, ArrowAddType(&meta, col));
+		fb_patch(&meta, field[4].pos, fb_start_vector(&meta, 0, 4));
+	}
+
+	ArrowAppendMessage(buf, &meta);
+	pfree(meta.data);
+}
+
+/* Append a string in server encoding to a Utf8 column */
+static void
+ArrowAppendUtf8(ArrowWriteState *state, ArrowWriteColumn *col,
+				const char *str, int len)
+{
+	const char *utf8 = pg_server_to_any(str, len, PG_UTF8);
+
+	if (utf8 != str)
+		len = strlen(utf8);
+	appendBinaryStringInfo(&col->data, utf8, len);
+	state->data_bytes += len;
+}
+
+/*
+ * Add a row to the current record batch.  Returns true if the batch is full
+ * and should be sent with ArrowWriteBatch().
+ *
+ * The caller should be in a short-lived memory context, which is used for
+ * detoasting and output function calls.
+ */
+bool
+ArrowWriteRow(ArrowWriteState *state, TupleTableSlot *slot)
+{
+	int64		row = state->nrows;
+	uint8		bit = 1 << (row % 8);
+
+	slot_getallattrs(slot);
+
+	for (int i = 0; i < state->ncolumns; i++)
+	{
+		ArrowWriteColumn *col = &state->columns[i];
+		Datum		value = slot->tts_values[col->attnum - 1];
+		bool		isnull = slot->tts_isnull[col->attnum - 1];
+
+		if (row % 8 == 0)
+		{
+			appendStringInfoChar(&col->validity, '\0');
+			if (col->conv == ARROW_CONV_BOOL)
+				appendStringInfoChar(&col->values, '\0');
+		}
+
+		if (isnull)
+			col->null_count++;
+		else
+			col->validity.data[row / 8] |= bit;
+
+		switch (col->conv)
+		{
+			case ARROW_CONV_NULL:
+				Assert(false);
+				break;
+			case ARROW_CONV_BOOL:
+				if (!isnull && DatumGetBool(value))
+					col->values.data[row / 8] |= bit;
+				break;
+			case ARROW_CONV_INT:
+				if (col->typid == INT2OID)
+					arrow_put16(&col->values, isnull ? 0 : DatumGetInt16(value));
+				else if (col->typid == INT4OID)
+					arrow_put32(&col->values, isnull ? 0 : DatumGetInt32(value));
+				else
+					arrow_put64(&col->values, isnull ? 0 : DatumGetInt64(value));
+				break;
+			case ARROW_CONV_FLOAT:
+				if (col->typid == FLOAT4OID)
+				{
+					float4		f = isnull ? 0 : DatumGetFloat4(value);
+					uint32		bits;
+
+					memcpy(&bits, &f, sizeof(bits));
+					arrow_put32(&col->values, bits);
+				}
+				else
+				{
+					float8		f = isnull ? 0 : DatumGetFloat8(value);
+					uint64		bits;
+
+					memcpy(&bits, &f, sizeof(bits));
+					arrow_put64(&col->values, bits);
+				}
+				break;
+			case ARROW_CONV_DATE:
+				{
+					DateADT		date = isnull ? 0 : DatumGetDateADT(value);
+
+					if (DATE_NOT_FINITE(date))
+						ereport(ERROR,
+								(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+								 errmsg("date out of range for Arrow format")));
+					arrow_put32(&col->values, date + ARROW_EPOCH_DAYS);
+				}
+				break;
+			case ARROW_CONV_TIME:
+				arrow_put64(&col->values, isnull ? 0 : DatumGetTimeADT(value));
+				break;
+			case ARROW_CONV_TIMESTAMP:
+				{
+					Timestamp	ts = isnull ? 0 : DatumGetTimestamp(value);
+
+					if (TIMESTAMP_NOT_FINITE(ts) ||
+						pg_add_s64_overflow(ts, ARROW_EPOCH_USECS, &ts))
+						ereport(ERROR,
+								(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+								 errmsg("timestamp out of range for Arrow format")));
+					arrow_put64(&col->values, ts);
+				}
+				break;
+			case ARROW_CONV_BYTEA:
+				if (!isnull)
+				{
+					bytea	   *b = DatumGetByteaPP(value);
+
+					appendBinaryStringInfo(&col->data, VARDATA_ANY(b),
+										   VARSIZE_ANY_EXHDR(b));
+					state->data_bytes += VARSIZE_ANY_EXHDR(b);
+				}
+				arrow_put32(&col->values, col->data.len);
+				break;
+			case ARROW_CONV_TEXT:
+				if (!isnull)
+				{
+					text	   *t = DatumGetTextPP(value);
+
+					ArrowAppendUtf8(state, col, VARDATA_ANY(t),
+									VARSIZE_ANY_EXHDR(t));
+				}
+				arrow_put32(&col->values, col->data.len);
+				break;
+			case ARROW_CONV_STRING:
+				if (!isnull)
+				{
+					char	   *str = OutputFunctionCall(col->out_function,
+														 value);
+
+					ArrowAppendUtf8(state, col, str, strlen(str));
+				}
+				arrow_put32(&col->values, col->data.len);
+				break;
+		}
+	}
+
+	state->nrows++;
+
+	return state->nrows >= ARROW_BATCH_ROWS ||
+		state->data_bytes >= ARROW_BATCH_BYTES;
+}
+
+/*
+ * Append a RecordBatch message with the rows added since the last one to
+ * 'buf', if there are any.
+ */
+void
+ArrowWriteBatch(ArrowWriteState *state, StringInfo buf)
+{
+	StringInfoData meta;
+	FbField		batch[] = {
+		{RECORD_BATCH_LENGTH, 8, state->nrows},
+		{RECORD_BATCH_NODES, 4, 0},
+		{RECORD_BATCH_BUFFERS, 4, 0},
+	};
+	int			nbuffers = 0;
+	int64		body_length = 0;
+	int64		offset = 0;
+	int			header;
+
+	if (state->nrows == 0)
+		return;
+
+	/* Validity bitmaps are left out if there are no NULLs */
+	for (int i = 0; i < state->ncolumns; i++)
+	{
+		ArrowWriteColumn *col = &state->columns[i];
+
+		if (col->null_count > 0)
+			body_length += TYPEALIGN(8, col->validity.len);
+		body_length += TYPEALIGN(8, col->values.len);
+		body_length += TYPEALIGN(8, col->data.len);
+		nbuffers += ARROW_CONV_IS_FIXED(col->conv) ? 2 : 3;
+	}
+
+	initStringInfo(&meta);
+	header = ArrowBeginMessage(&meta, ARROW_HEADER_RECORD_BATCH, body_length);
+	fb_patch(&meta, header, fb_add_table(&meta, batch, lengthof(batch)));
+
+	fb_patch(&meta, batch[1].pos,
+			 fb_start_vector(&meta, state->ncolumns, 8));
+	for (int i = 0; i < state->ncolumns; i++)
+	{
+		arrow_put64(&meta, state->nrows);
+		arrow_put64(&meta, state->columns[i].null_count);
+	}
+
+	fb_patch(&meta, batch[2].pos, fb_start_vector(&meta, nbuffers, 8));
+	for (int i = 0; i < state->ncolumns; i++)
+	{
+		ArrowWriteColumn *col = &state->columns[i];
+		int			validity_len = col->null_count > 0 ? col->validity.len : 0;
+
+		arrow_put64(&meta, offset);
+		arrow_put64(&meta, validity_len);
+		offset += TYPEALIGN(8, validity_len);
+		arrow_put64(&meta, offset);
+		arrow_put64(&meta, col->values.len);
+		offset += TYPEALIGN(8, col->values.len);
+		if (!ARROW_CONV_IS_FIXED(col->conv))
+		{
+			arrow_put64(&meta, offset);
+			arrow_put64(&meta, col->data.len);
+			offset += TYPEALIGN(8, col->data.len);
+		}
+	}
+	Assert(offset == body_length);
+
+	ArrowAppendMessage(buf, &meta);
+	pfree(meta.data);
+
+	/* Body */
+	for (int i = 0; i < state->ncolumns; i++)
+	{
+		ArrowWriteColumn *col = &state->columns[i];
+
+		if (col->null_count > 0)
+		{
+			appendBinaryStringInfo(buf, col->validity.data, col->validity.len);
+			arrow_pad(buf, 8);
+		}
+		appendBinaryStringInfo(buf, col->values.data, col->values.len);
+		arrow_pad(buf, 8);
+		appendBinaryStringInfo(buf, col->data.data, col->data.len);
+		arrow_pad(buf, 8);
+
+		ArrowResetColumn(col);
+	}
+
+	state->nrows = 0;
+	state->data_bytes = 0;
+}
+
+/*
+ * Append the last record batch and the end-of-stream marker to 'buf'.
+ */
+void
+ArrowWriteEnd(ArrowWriteState *state, StringInfo buf)
+{
+	ArrowWriteBatch(state, buf);
+	arrow_put32(buf, ARROW_CONTINUATION);
+	arrow_put32(buf, 0);
+}
+
+
+static void
+ArrowReadExactly(CopyFromState cstate, char *dest, int64 nbytes)
+{
+	while (nbytes > 0)
+	{
+		int			chunk = Min(nbytes, MaxAllocSize);
+
+		if (CopyReadBinaryData(cstate, dest, chunk) != chunk)
+			ereport(ERROR,
+					(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+					 errmsg("unexpected EOF in COPY data")));
+		dest += chunk;
+		nbytes -= chunk;
+	}
+}
+
+/*
+ * Read the next message.  Returns false at the end of the stream, else
+ * returns the message's metadata in *fb and its body in *body.  Both are
+ * allocated in the batch context, which is reset first.
+ */
+static bool
+ArrowReadMessage(CopyFromState cstate, ArrowReadState *state, FbBuf *fb,
+				 int *header_type, uint32 *header, char **body,
+				 int64 *body_length)
+{
+	char		word[4];
+	uint32		len;
+	char	   *meta;
+	uint32		msg;
+	int			version;
+
+	MemoryContextReset(state->batchcxt);
+
+	if (state->have_word)
+	{
+		len = state->first_word;
+		state->have_word = false;
+	}
+	else
+	{
+		int			nread = CopyReadBinaryData(cstate, word, 4);
+
+		/* Tolerate a stream that ends without end-of-stream marker */
+		if (nread == 0)
+			return false;
+		if (nread != 4)
+			ereport(ERROR,
+					(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+					 errmsg("unexpected EOF in COPY data")));
+		len = arrow_get32(word);
+	}
+
+	/* Streams written before Arrow 0.15 lack the continuation marker */
+	if (len == ARROW_CONTINUATION)
+	{
+		ArrowReadExactly(cstate, word, 4);
+		len = arrow_get32(word);
+	}
+
+	if (len == 0)
+	{
+		/*
+		 * End-of-stream marker.  Ignore the footer of the file format, but
+		 * otherwise insist that the input ends here, as binary COPY does.
+		 */
+		if (state->file_format)
+		{
+			while (CopyReadBinaryData(cstate, word, sizeof(word)) > 0)
+				 /* skip */ ;
+		}
+		else if (CopyReadBinaryData(cstate, word, 1) > 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+					 errmsg("received copy data after EOF marker")));
+		return false;
+	}
+
+	if (len < 8 || len > MaxAllocSize)
+		ereport(ERROR,
+				(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+				 errmsg("invalid Arrow message length %u", len)));
+	meta = MemoryContextAlloc(state->batchcxt, len);
+	ArrowReadExactly(cstate, meta, len);
+	fb->data = meta;
+	fb->len = len;
+
+	msg = fb_deref(fb, 0);
+	version = fb_get_int(fb, msg, MESSAGE_VERSION, 2, 0);
+	if (version < ARROW_METADATA_V4)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("Arrow metadata version %d is not supported",
+						version + 1)));
+	*header_type = fb_get_int(fb, msg, MESSAGE_HEADER_TYPE, 1, 0);
+	*header = fb_get_offset(fb, msg, MESSAGE_HEADER);
+	*body_length = fb_get_int(fb, msg, MESSAGE_BODY_LENGTH, 8, 0);
+	if (*header == 0 || *body_length < 0 ||
+		*body_length > MaxAllocHugeSize)
+		fb_error();
+
+	*body = NULL;
+	if (*body_length > 0)
+	{
+		*body = MemoryContextAllocHuge(state->batchcxt, *body_length);
+		ArrowReadExactly(cstate, *body, *body_length);
+	}
+
+	return true;
+}
+
+static const char *
+ArrowTypeName(int type)
+{
+	if (type >= 0 && type < lengthof(arrow_type_names))
+		return arrow_type_names[type];
+	return "unknown";
+}
+
+/*
+ * Read the Arrow type of a field of the schema, and decide how to convert
+ * it to the type of the column.
+ */
+static void
+ArrowReadField(const FbBuf *fb, uint32 field, ArrowReadColumn *col,
+			   Form_pg_attribute att)
+{
+	uint32		typetbl;
+	bool		has_tz = false;
+	bool		ok;
+
+	col->type = fb_get_int(fb, field, FIELD_TYPE_TYPE, 1, 0);
+	typetbl = fb_get_offset(fb, field, FIELD_TYPE);
+	if (typetbl == 0)
+		fb_error();
+	if (fb_get_offset(fb, field, FIELD_DICTIONARY) != 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("dictionary-encoded Arrow fields are not supported")));
+
+	switch (col->type)
+	{
+		case ARROW_TYPE_INT:
+			col->bit_width = fb_get_int(fb, typetbl, INT_BIT_WIDTH, 4, 0);
+			col->is_signed = fb_get_int(fb, typetbl, INT_IS_SIGNED, 1, 0) != 0;
+			if (col->bit_width != 8 && col->bit_width != 16 &&
+				col->bit_width != 32 && col->bit_width != 64)
+				fb_error();
+			col->width = col->bit_width / 8;
+			break;
+		case ARROW_TYPE_FLOATING_POINT:
+			switch (fb_get_int(fb, typetbl, FLOATING_POINT_PRECISION, 2, 0))
+			{
+				case ARROW_PRECISION_HALF:
+					col->bit_width = 16;
+					break;
+				case ARROW_PRECISION_SINGLE:
+					col->bit_width = 32;
+					break;
+				case ARROW_PRECISION_DOUBLE:
+					col->bit_width = 64;
+					break;
+				default:
+					fb_error();
+			}
+			col->width = col->bit_width / 8;
+			break;
+		case ARROW_TYPE_DATE:
+			col->unit = fb_get_int(fb, typetbl, DATE_UNIT, 2,
+								   ARROW_DATE_MILLISECOND);
+			if (col->unit == ARROW_DATE_DAY)
+				col->width = 4;
+			else if (col->unit == ARROW_DATE_MILLISECOND)
+				col->width = 8;
+			else
+				fb_error();
+			break;
+		case ARROW_TYPE_TIME:
+			col->unit = fb_get_int(fb, typetbl, TIME_UNIT, 2,
+								   ARROW_TIME_MILLISECOND);
+			col->bit_width = fb_get_int(fb, typetbl, TIME_BIT_WIDTH, 4, 32);
+			if (col->unit < ARROW_TIME_SECOND ||
+				col->unit > ARROW_TIME_NANOSECOND ||
+				col->bit_width != (col->unit <= ARROW_TIME_MILLISECOND ? 32 : 64))
+				fb_error();
+			col->width = col->bit_width / 8;
+			break;
+		case ARROW_TYPE_TIMESTAMP:
+			{
+				uint32		tz;
+
+				col->unit = fb_get_int(fb, typetbl, TIMESTAMP_UNIT, 2,
+									   ARROW_TIME_SECOND);
+				if (col->unit < ARROW_TIME_SECOND ||
+					col->unit > ARROW_TIME_NANOSECOND)
+					fb_error();
+				col->width = 8;
+
+				/* An absent or empty time zone means local time */
+				tz = fb_get_offset(fb, typetbl, TIMESTAMP_TIMEZONE);
+				has_tz = tz != 0 && arrow_get32(fb->data + tz) > 0;
+			}
+			break;
+		case ARROW_TYPE_LARGE_BINARY:
+		case ARROW_TYPE_LARGE_UTF8:
+			col->large = true;
+			break;
+		default:
+			break;
+	}
+
+	switch (col->type)
+	{
+		case ARROW_TYPE_NULL:
+			col->conv = ARROW_CONV_NULL;
+			ok = true;
+			break;
+		case ARROW_TYPE_BOOL:
+			col->conv = ARROW_CONV_BOOL;
+			ok = col->typid == BOOLOID;
+			break;
+		case ARROW_TYPE_INT:
+			col->conv = ARROW_CONV_INT;
+			ok = col->typid == INT2OID || col->typid == INT4OID ||
+				col->typid == INT8OID;
+			break;
+		case ARROW_TYPE_FLOATING_POINT:
+			col->conv = ARROW_CONV_FLOAT;
+			ok = (col->typid == FLOAT4OID || col->typid == FLOAT8OID) &&
+				col->bit_width != 16;
+			break;
+		case ARROW_TYPE_DATE:
+			col->conv = ARROW_CONV_DATE;
+			ok = col->typid == DATEOID;
+			break;
+		case ARROW_TYPE_TIME:
+			col->conv = ARROW_CONV_TIME;
+			ok = col->typid == TIMEOID;
+			break;
+		case ARROW_TYPE_TIMESTAMP:
+			/* Instants only go into timestamptz, local times into timestamp */
+			col->conv = ARROW_CONV_TIMESTAMP;
+			ok = col->typid == (has_tz ? TIMESTAMPTZOID : TIMESTAMPOID);
+			break;
+		case ARROW_TYPE_BINARY:
+		case ARROW_TYPE_LARGE_BINARY:
+			col->conv = ARROW_CONV_BYTEA;
+			ok = col->typid == BYTEAOID;
+			break;
+		case ARROW_TYPE_UTF8:
+		case ARROW_TYPE_LARGE_UTF8:
+			/* text is built directly, other types use the input function */
+			col->conv = att->atttypid == TEXTOID ? ARROW_CONV_TEXT : ARROW_CONV_STRING;
+			ok = true;
+			break;
+		default:
+			ok = false;
+			break;
+	}
+
+	if (!ok)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATATYPE_MISMATCH),
+				 errmsg("cannot load Arrow %s data into column \"%s\" of type %s",
+						ArrowTypeName(col->type), col->attname,
+						format_type_be(att->atttypid))));
+
+	/*
+	 * Input functions are called for the column's own type, and those of
+	 * domains check the constraints themselves.
+	 */
+	if (col->conv == ARROW_CONV_STRING)
+	{
+		col->typmod = att->atttypmod;
+		col->domain_typid = InvalidOid;
+	}
+}
+
+/*
+ * Read the Schema message at the start of the input, and set up the
+ * conversion of its fields to the columns of the table.
+ */
+void
+ArrowReadBegin(CopyFromState cstate)
+{
+	TupleDesc	tupDesc = RelationGetDescr(cstate->rel);
+	ArrowReadState *state = palloc0(sizeof(ArrowReadState));
+	char		word[4];
+	FbBuf		fb;
+	int			header_type;
+	uint32		schema;
+	char	   *body;
+	int64		body_length;
+	uint32		fields;
+	uint32		nfields;
+	ListCell   *cur;
+	int			i = 0;
+
+	state->batchcxt = AllocSetContextCreate(CurrentMemoryContext,
+											"COPY FROM Arrow batch",
+											ALLOCSET_DEFAULT_SIZES);
+	state->ncolumns = list_length(cstate->attnumlist);
+	state->columns = palloc0(state->ncolumns * sizeof(ArrowReadColumn));
+	cstate->arrow_state = state;
+
+	foreach(cur, cstate->attnumlist)
+	{
+		int			attnum = lfirst_int(cur);
+		Form_pg_attribute att = TupleDescAttr(tupDesc, attnum - 1);
+		ArrowReadColumn *col = &state->columns[i++];
+
+		col->attnum = attnum;
+		col->attname = NameStr(att->attname);
+		col->typmod = att->atttypmod;
+		col->typid = getBaseTypeAndTypmod(att->atttypid, &col->typmod);
+		if (col->typid != att->atttypid)
+			col->domain_typid = att->atttypid;
+		col->datums = palloc(ARROW_CHUNK_ROWS * sizeof(Datum));
+		col->isnull = palloc(ARROW_CHUNK_ROWS * sizeof(bool));
+	}
+
+	/* The file format starts with a magic string, the stream doesn't */
+	if (CopyReadBinaryData(cstate, word, 4) != 4)
+		ereport(ERROR,
+				(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+				 errmsg("COPY file signature not recognized")));
+	if (memcmp(word, ARROW_FILE_MAGIC, 4) == 0)
+	{
+		if (CopyReadBinaryData(cstate, word, 4) != 4 ||
+			memcmp(word, ARROW_FILE_MAGIC + 4, 4) != 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+					 errmsg("COPY file signature not recognized")));
+		state->file_format = true;
+	}
+	else
+	{
+		state->first_word = arrow_get32(word);
+		state->have_word = true;
+	}
+
+	if (!ArrowReadMessage(cstate, state, &fb, &header_type, &schema,
+						  &body, &body_length) ||
+		header_type != ARROW_HEADER_SCHEMA)
+		ereport(ERROR,
+				(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+				 errmsg("Arrow stream does not start with a schema")));
+
+	if (fb_get_int(&fb, schema, SCHEMA_ENDIANNESS, 2, 0) != 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("big-endian Arrow data is not supported")));
+
+	fields = fb_get_vector(&fb, schema, SCHEMA_FIELDS, 4, &nfields);
+	if (nfields != state->ncolumns)
+		ereport(ERROR,
+				(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+				 errmsg("Arrow schema has %u fields, expected %d",
+						nfields, state->ncolumns)));
+
+	for (i = 0; i < state->ncolumns; i++)
+	{
+		ArrowReadColumn *col = &state->columns[i];
+
+		ArrowReadField(&fb, fb_deref(&fb, fields + 4 * i), col,
+					   TupleDescAttr(tupDesc, col->attnum - 1));
+	}
+
+	MemoryContextReset(state->batchcxt);
+}
+
+static void ArrowBatchError(void) pg_attribute_noreturn();
+
+static void
+ArrowBatchError(void)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+			 errmsg("invalid Arrow record batch")));
+}
+
+/*
+ * Set up the buffers of the columns for a record batch.
+ */
+static void
+ArrowReadRecordBatch(ArrowReadState *state, const FbBuf *fb, uint32 batch,
+					 char *body, int64 body_length)
+{
+	int64		length;
+	int64		bitmap_len;
+	uint32		nodes;
+	uint32		nnodes;
+	uint32		buffers;
+	uint32		nbuffers;
+	uint32		b = 0;
+
+	if (fb_get_offset(fb, batch, RECORD_BATCH_COMPRESSION) != 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("compressed Arrow record batches are not supported")));
+
+	length = fb_get_int(fb, batch, RECORD_BATCH_LENGTH, 8, 0);
+	nodes = fb_get_vector(fb, batch, RECORD_BATCH_NODES,
+						  ARROW_FIELD_NODE_SIZE, &nnodes);
+	buffers = fb_get_vector(fb, batch, RECORD_BATCH_BUFFERS,
+							ARROW_BUFFER_SIZE, &nbuffers);
+	if (length < 0 || nnodes != state->ncolumns)
+		ArrowBatchError();
+	bitmap_len = length / 8 + (length % 8 != 0);
+
+	for (int i = 0; i < state->ncolumns; i++)
+	{
+		ArrowReadColumn *col = &state->columns[i];
+		const char *node = fb->data + nodes + i * ARROW_FIELD_NODE_SIZE;
+		int64		null_count = arrow_get64(node + 8);
+		int			nbufs;
+		const char *bufs[3] = {NULL, NULL, NULL};
+		int64		lens[3] = {0, 0, 0};
+		int64		needed;
+
+		if ((int64) arrow_get64(node) != length ||
+			null_count < 0 || null_count > length)
+			ArrowBatchError();
+
+		if (col->conv == ARROW_CONV_NULL)
+			nbufs = 0;
+		else if (ARROW_CONV_IS_FIXED(col->conv))
+			nbufs = 2;
+		else
+			nbufs = 3;
+		if (b + nbufs > nbuffers)
+			ArrowBatchError();
+
+		for (int k = 0; k < nbufs; k++, b++)
+		{
+			const char *buffer = fb->data + buffers + b * ARROW_BUFFER_SIZE;
+			int64		offset = arrow_get64(buffer);
+			int64		len = arrow_get64(buffer + 8);
+
+			if (offset < 0 || len < 0 || offset > body_length ||
+				len > body_length - offset)
+				ArrowBatchError();
+			bufs[k] = len > 0 ? body + offset : NULL;
+			lens[k] = len;
+		}
+
+		/* The validity bitmap may be left out if there are no NULLs */
+		col->validity = null_count > 0 ? bufs[0] : NULL;
+		if (null_count > 0 && lens[0] < bitmap_len)
+			ArrowBatchError();
+
+		/*
+		 * The batch length comes straight from the input, so compute the
+		 * size of the values buffer with overflow checks; a wrapped result
+		 * would let an empty buffer pass for any number of rows.
+		 */
+		col->values = bufs[1];
+		if (col->conv == ARROW_CONV_NULL)
+			needed = 0;
+		else if (col->conv == ARROW_CONV_BOOL)
+			needed = bitmap_len;
+		else if (ARROW_CONV_IS_FIXED(col->conv))
+		{
+			if (pg_mul_s64_overflow(length, col->width, &needed))
+				ArrowBatchError();
+		}
+		else if (length == 0)
+			needed = 0;
+		else if (pg_add_s64_overflow(length, 1, &needed) ||
+				 pg_mul_s64_overflow(needed, col->large ? 8 : 4, &needed))
+			ArrowBatchError();
+		if (lens[1] < needed)
+			ArrowBatchError();
+
+		col->data = bufs[2];
+		col->data_len = lens[2];
+	}
+
+	state->nrows = length;
+	state->row = 0;
+	state->chunk_start = 0;
+	state->chunk_rows = 0;
+}
+
+/*
+ * Read messages up to the next record batch with any rows.  Returns false
+ * at the end of the stream.
+ */
+static bool
+ArrowNextBatch(CopyFromState cstate, ArrowReadState *state)
+{
+	FbBuf		fb;
+	int			header_type;
+	uint32		header;
+	char	   *body;
+	int64		body_length;
+
+	while (!state->done)
+	{
+		if (!ArrowReadMessage(cstate, state, &fb, &header_type, &header,
+							  &body, &body_length))
+		{
+			state->done = true;
+			break;
+		}
+
+		switch (header_type)
+		{
+			case ARROW_HEADER_RECORD_BATCH:
+				ArrowReadRecordBatch(state, &fb, header, body, body_length);
+				if (state->nrows > 0)
+					return true;
+				break;
+			case ARROW_HEADER_DICTIONARY_BATCH:
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("Arrow dictionary batches are not supported")));
+				break;
+			default:
+				ereport(ERROR,
+						(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+						 errmsg("unexpected Arrow message type %d",
+								header_type)));
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Point the error context at row 'i' of the chunk being converted, which
+ * the caller is about to report an error for.
+ */
+static void
+ArrowSetErrorRow(CopyFromState cstate, ArrowReadColumn *col, int i)
+{
+	cstate->cur_lineno += i + 1;
+	cstate->cur_attname = col->attname;
+}
+
+static inline bool
+ArrowGetInt(ArrowReadColumn *col, const char *p, int64 *result)
+{
+	switch (col->bit_width)
+	{
+		case 8:
+			*result = col->is_signed ? (int8) *p : (uint8) *p;
+			break;
+		case 16:
+			*result = col->is_signed ? (int16) arrow_get16(p) : arrow_get16(p);
+			break;
+		case 32:
+			*result = col->is_signed ? (int32) arrow_get32(p) : arrow_get32(p);
+			break;
+		default:
+			{
+				uint64		val = arrow_get64(p);
+
+				if (!col->is_signed && val > PG_INT64_MAX)
+					return false;
+				*result = (int64) val;
+			}
+			break;
+	}
+	return true;
+}
+
+static void
+ArrowConvertInt(CopyFromState cstate, ArrowReadColumn *col,
+				const char *p, int nrows)
+{
+	int			typlen = col->typid == INT2OID ? 2 :
+		col->typid == INT4OID ? 4 : 8;
+
+	/* Fast paths for values that need no range check */
+	if (col->is_signed && col->width == typlen)
+	{
+		if (typlen == 2)
+			for (int i = 0; i < nrows; i++)
+				col->datums[i] = Int16GetDatum(arrow_get16(p + 2 * i));
+		else if (typlen == 4)
+			for (int i = 0; i < nrows; i++)
+				col->datums[i] = Int32GetDatum(arrow_get32(p + 4 * i));
+		else
+			for (int i = 0; i < nrows; i++)
+				col->datums[i] = Int64GetDatum(arrow_get64(p + 8 * i));
+		return;
+	}
+
+	for (int i = 0; i < nrows; i++)
+	{
+		int64		val;
+
+		if (col->isnull[i])
+			continue;
+		if (!ArrowGetInt(col, p + i * col->width, &val) ||
+			(typlen == 2 && (val < PG_INT16_MIN || val > PG_INT16_MAX)) ||
+			(typlen == 4 && (val < PG_INT32_MIN || val > PG_INT32_MAX)))
+		{
+			ArrowSetErrorRow(cstate, col, i);
+			ereport(ERROR,
+					(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+					 typlen == 2 ? errmsg("smallint out of range") :
+					 typlen == 4 ? errmsg("integer out of range") :
+					 errmsg("bigint out of range")));
+		}
+		if (typlen == 2)
+			col->datums[i] = Int16GetDatum((int16) val);
+		else if (typlen == 4)
+			col->datums[i] = Int32GetDatum((int32) val);
+		else
+			col->datums[i] = Int64GetDatum(val);
+	}
+}
+
+static void
+ArrowConvertFloat(CopyFromState cstate, ArrowReadColumn *col,
+				  const char *p, int nrows)
+{
+	for (int i = 0; i < nrows; i++)
+	{
+		float8		val;
+
+		if (col->bit_width == 32)
+		{
+			uint32		bits = arrow_get32(p + 4 * i);
+			float4		f;
+
+			memcpy(&f, &bits, sizeof(f));
+			if (col->typid == FLOAT4OID)
+			{
+				col->datums[i] = Float4GetDatum(f);
+				continue;
+			}
+			val = f;
+		}
+		else
+		{
+			uint64		bits = arrow_get64(p + 8 * i);
+
+			memcpy(&val, &bits, sizeof(val));
+		}
+
+		if (col->typid == FLOAT8OID)
+			col->datums[i] = Float8GetDatum(val);
+		else if (!col->isnull[i])
+		{
+			float4		f = (float4) val;
+
+			if (unlikely(isinf(f) && !isinf(val)))
+			{
+				ArrowSetErrorRow(cstate, col, i);
+				float_overflow_error();
+			}
+			if (unlikely(f == 0.0f && val != 0.0))
+			{
+				ArrowSetErrorRow(cstate, col, i);
+				float_underflow_error();
+			}
+			col->datums[i] = Float4GetDatum(f);
+		}
+	}
+}
+
+static void
+ArrowConvertDate(CopyFromState cstate, ArrowReadColumn *col,
+				 const char *p, int nrows)
+{
+	for (int i = 0; i < nrows; i++)
+	{
+		int64		days;
+
+		if (col->isnull[i])
+			continue;
+		if (col->unit == ARROW_DATE_DAY)
+			days = (int32) arrow_get32(p + 4 * i);
+		else
+			days = arrow_floor_div((int64) arrow_get64(p + 8 * i),
+								   (int64) SECS_PER_DAY * 1000);
+		days -= ARROW_EPOCH_DAYS;
+		if (!IS_VALID_DATE(days))
+		{
+			ArrowSetErrorRow(cstate, col, i);
+			ereport(ERROR,
+					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+					 errmsg("date out of range")));
+		}
+		col->datums[i] = DateADTGetDatum((DateADT) days);
+	}
+}
+
+/* Convert a time or timestamp in the column's unit to microseconds */
+static inline bool
+ArrowGetMicroseconds(ArrowReadColumn *col, int64 val, int64 *result)
+{
+	switch (col->unit)
+	{
+		case ARROW_TIME_SECOND:
+			return !pg_mul_s64_overflow(val, USECS_PER_SEC, result);
+		case ARROW_TIME_MILLISECOND:
+			return !pg_mul_s64_overflow(val, 1000, result);
+		case ARROW_TIME_MICROSECOND:
+			*result = val;
+			return true;
+		default:
+			*result = arrow_floor_div(val, 1000);
+			return true;
+	}
+}
+
+static void
+ArrowConvertTime(CopyFromState cstate, ArrowReadColumn *col,
+				 const char *p, int nrows)
+{
+	for (int i = 0; i < nrows; i++)
+	{
+		int64		val;
+		TimeADT		time;
+
+		if (col->isnull[i])
+			continue;
+		if (col->bit_width == 32)
+			val = (int32) arrow_get32(p + 4 * i);
+		else
+			val = (int64) arrow_get64(p + 8 * i);
+		if (!ArrowGetMicroseconds(col, val, &time) ||
+			time < 0 || time > USECS_PER_DAY)
+		{
+			ArrowSetErrorRow(cstate, col, i);
+			ereport(ERROR,
+					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+					 errmsg("time out of range")));
+		}
+		if (col->typmod >= 0)
+			AdjustTimeForTypmod(&time, col->typmod);
+		col->datums[i] = TimeADTGetDatum(time);
+	}
+}
+
+static void
+ArrowConvertTimestamp(CopyFromState cstate, ArrowReadColumn *col,
+					  const char *p, int nrows)
+{
+	for (int i = 0; i < nrows; i++)
+	{
+		Timestamp	ts;
+
+		if (col->isnull[i])
+			continue;
+		if (!ArrowGetMicroseconds(col, arrow_get64(p + 8 * i), &ts) ||
+			pg_sub_s64_overflow(ts, ARROW_EPOCH_USECS, &ts) ||
+			!IS_VALID_TIMESTAMP(ts) ||
+			(col->typmod >= 0 && !AdjustTimestampForTypmod(&ts, col->typmod,
+														   NULL)))
+		{
+			ArrowSetErrorRow(cstate, col, i);
+			ereport(ERROR,
+					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+					 errmsg("timestamp out of range")));
+		}
+		col->datums[i] = TimestampGetDatum(ts);
+	}
+}
+
+/*
+ * Convert the fixed-width values of the next chunk of rows of the current
+ * record batch to Datums.
+ */
+static void
+ArrowConvertChunk(CopyFromState cstate, ArrowReadState *state)
+{
+	int64		start = state->row;
+	int			nrows = Min(state->nrows - start, ARROW_CHUNK_ROWS);
+
+	for (int c = 0; c < state->ncolumns; c++)
+	{
+		ArrowReadColumn *col = &state->columns[c];
+		const char *p;
+
+		if (!ARROW_CONV_IS_FIXED(col->conv))
+			continue;
+		if (cstate->convert_select_flags &&
+			!cstate->convert_select_flags[col->attnum - 1])
+			continue;
+
+		if (col->validity)
+		{
+			for (int i = 0; i < nrows; i++)
+			{
+				int64		row = start + i;
+
+				col->isnull[i] = (col->validity[row / 8] & (1 << (row % 8))) == 0;
+			}
+		}
+		else
+			memset(col->isnull, false, nrows * sizeof(bool));
+
+		p = col->values + start * col->width;
+		switch (col->conv)
+		{
+			case ARROW_CONV_BOOL:
+				for (int i = 0; i < nrows; i++)
+				{
+					int64		row = start + i;
+
+					col->datums[i] = BoolGetDatum((col->values[row / 8] &
+												   (1 << (row % 8))) != 0);
+				}
+				break;
+			case ARROW_CONV_INT:
+				ArrowConvertInt(cstate, col, p, nrows);
+				break;
+			case ARROW_CONV_FLOAT:
+				ArrowConvertFloat(cstate, col, p, nrows);
+				break;
+			case ARROW_CONV_DATE:
+				ArrowConvertDate(cstate, col, p, nrows);
+				break;
+			case ARROW_CONV_TIME:
+				ArrowConvertTime(cstate, col, p, nrows);
+				break;
+			case ARROW_CONV_TIMESTAMP:
+				ArrowConvertTimestamp(cstate, col, p, nrows);
+				break;
+			default:
+				Assert(false);
+		}
+	}
+
+	state->chunk_start = start;
+	state->chunk_rows = nrows;
+}
+
+/*
+ * Get the Utf8 or Binary value of the current row of a column.
+ */
+static void
+ArrowGetBytes(ArrowReadState *state, ArrowReadColumn *col,
+			  const char **str, int *len)
+{
+	int64		row = state->row;
+	int64		start;
+	int64		end;
+
+	if (col->large)
+	{
+		start = (int64) arrow_get64(col->values + 8 * row);
+		end = (int64) arrow_get64(col->values + 8 * (row + 1));
+	}
+	else
+	{
+		start = (int32) arrow_get32(col->values + 4 * row);
+		end = (int32) arrow_get32(col->values + 4 * (row + 1));
+	}
+	if (start < 0 || end < start || end > col->data_len)
+		ArrowBatchError();
+	if (end - start > MaxAllocSize - VARHDRSZ - 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("Arrow value is too long")));
+
+	*str = col->data ? col->data + start : "";
+	*len = end - start;
+}
+
+/*
+ * Return the next row as Datums, like NextCopyFrom().  Returns false at the
+ * end of the input.
+ */
+bool
+ArrowReadRow(CopyFromState cstate, Datum *values, bool *nulls)
+{
+	ArrowReadState *state = cstate->arrow_state;
+	int			i;
+
+	if (state->row >= state->nrows && !ArrowNextBatch(cstate, state))
+		return false;
+	if (state->row >= state->chunk_start + state->chunk_rows)
+		ArrowConvertChunk(cstate, state);
+	i = state->row - state->chunk_start;
+
+	cstate->cur_lineno++;
+
+	for (int c = 0; c < state->ncolumns; c++)
+	{
+		ArrowReadColumn *col = &state->columns[c];
+		int			m = col->attnum - 1;
+		const char *str;
+		int			len;
+
+		if (cstate->convert_select_flags && !cstate->convert_select_flags[m])
+			continue;
+
+		cstate->cur_attname = col->attname;
+
+		if (ARROW_CONV_IS_FIXED(col->conv))
+		{
+			values[m] = col->datums[i];
+			nulls[m] = col->isnull[i];
+		}
+		else if (col->conv == ARROW_CONV_NULL ||
+				 (col->validity &&
+				  (col->validity[state->row / 8] & (1 << (state->row % 8))) == 0))
+		{
+			nulls[m] = true;
+			if (col->conv == ARROW_CONV_STRING)
+				values[m] = InputFunctionCall(&cstate->in_functions[m], NULL,
+											  cstate->typioparams[m],
+											  col->typmod);
+		}
+		else
+		{
+			nulls[m] = false;
+			ArrowGetBytes(state, col, &str, &len);
+			if (col->conv == ARROW_CONV_BYTEA)
+			{
+				bytea	   *result = palloc(len + VARHDRSZ);
+
+				SET_VARSIZE(result, len + VARHDRSZ);
+				memcpy(VARDATA(result), str, len);
+				values[m] = PointerGetDatum(result);
+			}
+			else
+			{
+				char	   *cvt = pg_any_to_server(str, len, PG_UTF8);
+
+				if (cvt != str)
+					len = strlen(cvt);
+				if (col->conv == ARROW_CONV_TEXT)
+					values[m] = PointerGetDatum(cstring_to_text_with_len(cvt,
+																		 len));
+				else
+				{
+					/* The input function needs a terminated string */
+					if (cvt == str)
+					{
+						resetStringInfo(&cstate->attribute_buf);
+						appendBinaryStringInfo(&cstate->attribute_buf, str, len);
+						cvt = cstate->attribute_buf.data;
+					}
+					values[m] = InputFunctionCall(&cstate->in_functions[m], cvt,
+												  cstate->typioparams[m],
+												  col->typmod);
+				}
+			}
+		}
+
+		if (OidIsValid(col->domain_typid))
+			domain_check(values[m], nulls[m], col->domain_typid,
+						 &col->domain_extra, cstate->copycontext);
+
+		cstate->cur_attname = NULL;
+	}
+
+	state->row++;
+
+	return true;
+}
@@ -29,6 +29,7 @@
 #include "access/xact.h"
 #include "catalog/namespace.h"
 #include "commands/copy.h"
+#include "commands/copyarrow.h"
 #include "commands/copyfrom_internal.h"
 #include "commands/progress.h"
 #include "commands/trigger.h"
@@ -1307,8 +1308,9 @@ CopyFrom(CopyFromState cstate)
 	/* Done, clean up */
 	error_context_stack = errcallback.previous;
 
+	/* In a parallel COPY, the leader reports the total instead */
 	if (cstate->opts.on_error != COPY_ON_ERROR_STOP &&
-		cstate->num_errors > 0)
+		cstate->num_errors > 0 && !IsParallelWorker())
 		ereport(NOTICE,
 				errmsg_plural("%llu row was skipped due to data type incompatibility",
 							  "%llu rows were skipped due to data type incompatibility",
@@ -1603,7 +1605,8 @@ BeginCopyFrom(ParseState *pstate,
 	 * Pick up the required catalog information for each attribute in the
 	 * relation, including the input function, the element type (to pass to
 	 * the input function), and info about defaults and constraints. (Which
-	 * input function we use depends on text/binary format choice.)
+	 * input function we use depends on text/binary format choice.  Arrow
+	 * format uses the text input functions for values sent as strings.)
 	 */
 	in_functions = (FmgrInfo *) palloc(num_phys_attrs * sizeof(FmgrInfo));
 	typioparams = (Oid *) palloc(num_phys_attrs * sizeof(Oid));
@@ -1619,7 +1622,7 @@ BeginCopyFrom(ParseState *pstate,
 			continue;
 
 		/* Fetch the input function and typioparam info */
-		if (cstate->opts.binary)
+		if (cstate->opts.binary && !cstate->opts.arrow)
 			getTypeBinaryInputInfo(att->atttypid,
 								   &in_func_oid, &typioparams[attnum - 1]);
 		else
@@ -1760,7 +1763,12 @@ BeginCopyFrom(ParseState *pstate,
 
 	pgstat_progress_update_multi_param(3, progress_cols, progress_vals);
 
-	if (cstate->opts.binary)
+	if (cstate->opts.arrow)
+	{
+		/* Read the Arrow schema, and match it with the columns */
+		ArrowReadBegin(cstate);
+	}
+	else if (cstate->opts.binary)
 	{
 		/* Read and verify binary header */
 		ReceiveCopyBinaryHeader(cstate);
@@ -0,0 +1,839 @@
+/*-------------------------------------------------------------------------
+ *
+ * copyfromparallel.c
+ *		Parallel COPY FROM.
+ *
+ * In a parallel COPY FROM, the leader reads the input and cuts it into
+ * chunks of whole lines, which it hands out to the parallel workers in turn
+ * through one shared memory queue per worker.  Each worker runs an ordinary
+ * CopyFrom() over the concatenation of the chunks it receives, so that the
+ * workers parse the lines, call the input functions, evaluate defaults and
+ * constraints, and insert the tuples and their index entries concurrently.
+ * Unique indexes stay correct, since all participants insert under the same
+ * transaction ID and the index AM checks for conflicts with the entries of
+ * the other participants as it does for any concurrent insertion.
+ *
+ * To find the line boundaries, the leader has to track quotes in CSV mode
+ * and backslash escapes in text mode the same way CopyReadLineText() does.
+ * It also consumes the header line and stops at the end-of-copy marker, and
+ * sends along the number of the first line of each chunk, so that errors
+ * reported by the workers point at the right line.
+ *
+ * Workers can't assign a transaction ID or mark the command ID as used, so
+ * the leader does both before starting them.  Anything that requires work
+ * in between the insertions of the rows makes us fall back to a serial COPY:
+ * insert triggers, including the ones enforcing foreign keys, partitioned
+ * tables, and expressions that are not parallel safe, including generated
+ * columns and index expressions and predicates, among others; see
+ * ParallelCopyFromWorkers().
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/commands/copyfromparallel.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/table.h"
+#include "access/xact.h"
+#include "catalog/pg_proc.h"
+#include "commands/copy.h"
+#include "commands/copyfrom_internal.h"
+#include "commands/progress.h"
+#include "executor/instrument.h"
+#include "mb/pg_wchar.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "pgstat.h"
+#include "port/atomics.h"
+#include "rewrite/rewriteHandler.h"
+#include "storage/shm_mq.h"
+#include "tcop/tcopprot.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+#include "utils/typcache.h"
+
+/*
+ * DSM keys for parallel COPY.  Like parallel vacuum, we don't need to worry
+ * about DSM keys conflicting with plan_node_id, so we can use small integers.
+ */
+#define PARALLEL_COPY_KEY_SHARED			1
+#define PARALLEL_COPY_KEY_STATEMENT			2
+#define PARALLEL_COPY_KEY_QUERY_TEXT		3
+#define PARALLEL_COPY_KEY_BUFFER_USAGE		4
+#define PARALLEL_COPY_KEY_WAL_USAGE			5
+#define PARALLEL_COPY_KEY_QUEUES			6
+
+/* Size of each worker's queue */
+#define PARALLEL_COPY_QUEUE_SIZE		((Size) 1024 * 1024)
+
+/* The leader sends a chunk once it has collected this many bytes of lines */
+#define PARALLEL_COPY_CHUNK_SIZE		65536
+
+/*
+ * Shared information among the leader and the workers.
+ */
+typedef struct ParallelCopyShared
+{
+	Oid			relid;			/* target table */
+	pg_atomic_uint64 processed; /* number of rows inserted */
+	pg_atomic_uint64 num_errors;	/* number of rows skipped by ON_ERROR */
+} ParallelCopyShared;
+
+/*
+ * Each chunk sent to a worker starts with this header, followed by the raw
+ * input data of one or more whole lines.
+ */
+typedef struct ParallelCopyChunkHeader
+{
+	uint64		first_lineno;	/* line number of the first line */
+	EolType		eol_type;		/* end-of-line type, if known yet */
+} ParallelCopyChunkHeader;
+
+/*
+ * Working state of the leader.
+ */
+typedef struct ParallelCopyLeader
+{
+	CopyFromState cstate;		/* reads the input, with our eol_type */
+	ParallelContext *pcxt;
+	shm_mq_handle **mqh;		/* queues to the launched workers */
+	int			next_worker;	/* worker receiving the next chunk */
+
+	/*
+	 * Input read but not sent yet.  The bytes before 'scan' have been
+	 * scanned for line boundaries.
+	 */
+	StringInfoData buf;
+	int			scan;
+	bool		eof;			/* reached the end of the input? */
+} ParallelCopyLeader;
+
+/*
+ * Working state of a worker, for ParallelCopyReadData().
+ */
+typedef struct ParallelCopyWorker
+{
+	CopyFromState cstate;
+	shm_mq_handle *mqh;			/* queue from the leader */
+	char	   *chunk;			/* current chunk, in the queue */
+	Size		chunk_len;
+	Size		chunk_pos;		/* bytes of the chunk already returned */
+	bool		done;			/* leader detached, no more chunks */
+} ParallelCopyWorker;
+
+static ParallelCopyWorker *MyCopyWorker = NULL;
+
+static int	ParallelCopyFromWorkers(CopyFromState cstate);
+static bool parallel_copy_unsafe(Node *node);
+static bool parallel_copy_unsafe_indexes(Relation rel);
+static bool parallel_copy_unsafe_checker(Oid func_id, void *context);
+static bool parallel_copy_unsafe_walker(Node *node, void *context);
+static void ParallelCopyDistribute(ParallelCopyLeader *pcl);
+static bool ParallelCopyFillBuf(ParallelCopyLeader *pcl, int nbytes);
+static void ParallelCopySendChunk(ParallelCopyLeader *pcl,
+								  uint64 first_lineno);
+static void ParallelCopyDetachQueues(ParallelCopyLeader *pcl);
+static int	ParallelCopyReadData(void *outbuf, int minread, int maxread);
+
+/*
+ * Decide the number of workers to load the table of 'cstate' with.
+ *
+ * Returns 0 if the COPY must be done serially.
+ */
+static int
+ParallelCopyFromWorkers(CopyFromState cstate)
+{
+	Relation	rel = cstate->rel;
+	TupleDesc	tupDesc = RelationGetDescr(rel);
+	TriggerDesc *trigdesc = rel->trigdesc;
+	TupleConstr *constr = tupDesc->constr;
+
+	if (max_parallel_maintenance_workers == 0 || IsInParallelMode())
+		return 0;
+
+	/*
+	 * Partitioned and foreign tables, and views with INSTEAD OF triggers,
+	 * are not supported.  Neither are temporary tables, whose buffers the
+	 * workers can't access.
+	 */
+	if (rel->rd_rel->relkind != RELKIND_RELATION ||
+		RelationUsesLocalBuffers(rel))
+		return 0;
+
+	/*
+	 * If WAL can be skipped for the table, the table was created in this
+	 * transaction, which workers can't tell.
+	 */
+	if (rel->rd_rel->relpersistence == RELPERSISTENCE_PERMANENT &&
+		!RelationNeedsWAL(rel))
+		return 0;
+
+	/*
+	 * Triggers run arbitrary code, and the ones enforcing foreign keys need
+	 * a new command ID, which workers can't assign.
+	 */
+	if (trigdesc != NULL &&
+		(trigdesc->trig_insert_before_row ||
+		 trigdesc->trig_insert_after_row ||
+		 trigdesc->trig_insert_before_statement ||
+		 trigdesc->trig_insert_after_statement))
+		return 0;
+
+	/* FREEZE and HEADER MATCH need checks that the leader doesn't do */
+	if (cstate->opts.freeze || cstate->opts.header_line == COPY_HEADER_MATCH)
+		return 0;
+
+	/*
+	 * The leader finds line boundaries in the raw input, which requires an
+	 * encoding where a multibyte character can't contain ASCII bytes.
+	 */
+	if (PG_ENCODING_IS_CLIENT_ONLY(cstate->file_encoding))
+		return 0;
+
+	/* Workers don't support predicate locks */
+	if (IsolationIsSerializable())
+		return 0;
+
+	/*
+	 * The workers evaluate the WHERE clause, defaults, generated columns,
+	 * constraints, and the expressions and predicates of the indexes.
+	 */
+	if (parallel_copy_unsafe(cstate->whereClause))
+		return 0;
+	for (int i = 0; i < tupDesc->natts; i++)
+	{
+		Form_pg_attribute att = TupleDescAttr(tupDesc, i);
+
+		if (att->attisdropped)
+			continue;
+		if (DomainHasConstraints(att->atttypid))
+			return 0;
+		if ((cstate->defexprs[i] != NULL ||
+			 att->attgenerated == ATTRIBUTE_GENERATED_STORED) &&
+			parallel_copy_unsafe(build_column_default(rel, i + 1)))
+			return 0;
+	}
+	if (constr != NULL)
+	{
+		for (int i = 0; i < constr->num_check; i++)
+		{
+			if (parallel_copy_unsafe(stringToNode(constr->check[i].ccbin)))
+				return 0;
+		}
+	}
+	if (parallel_copy_unsafe_indexes(rel))
+		return 0;
+
+	return Min(cstate->opts.nworkers, max_parallel_maintenance_workers);
+}
+
+/*
+ * Does the expression contain anything a worker can't evaluate?
+ */
+static bool
+parallel_copy_unsafe(Node *node)
+{
+	return parallel_copy_unsafe_walker(node, NULL);
+}
+
+/*
+ * Does any index of the relation have an expression or a predicate that a
+ * worker can't evaluate?
+ */
+static bool
+parallel_copy_unsafe_indexes(Relation rel)
+{
+	List	   *indexoidlist = RelationGetIndexList(rel);
+	ListCell   *lc;
+	bool		unsafe = false;
+
+	foreach(lc, indexoidlist)
+	{
+		Relation	indexRel = index_open(lfirst_oid(lc), RowExclusiveLock);
+		List	   *exprs = RelationGetIndexExpressions(indexRel);
+		List	   *pred = RelationGetIndexPredicate(indexRel);
+
+		unsafe = parallel_copy_unsafe((Node *) exprs) ||
+			parallel_copy_unsafe((Node *) pred);
+		index_close(indexRel, NoLock);
+
+		if (unsafe)
+			break;
+	}
+	list_free(indexoidlist);
+
+	return unsafe;
+}
+
+static bool
+parallel_copy_unsafe_checker(Oid func_id, void *context)
+{
+	return func_parallel(func_id) != PROPARALLEL_SAFE;
+}
+
+static bool
+parallel_copy_unsafe_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (check_functions_in_node(node, parallel_copy_unsafe_checker, context))
+		return true;
+
+	/* Sequences can't be advanced in a worker */
+	if (IsA(node, NextValueExpr) ||
+		IsA(node, CoerceToDomain) ||
+		IsA(node, SubLink) ||
+		IsA(node, Param))
+		return true;
+
+	return expression_tree_walker(node, parallel_copy_unsafe_walker, context);
+}
+
+/*
+ * Copy from the input of 'cstate' with parallel workers.
+ *
+ * 'attnamelist' and 'options' are those of the COPY statement, for the
+ * workers to build their own CopyFromState with.  Falls back to CopyFrom()
+ * if the table can't be loaded in parallel or no workers can be launched.
+ *
+ * Returns the number of rows inserted.
+ */
+uint64
+ParallelCopyFrom(CopyFromState cstate, List *attnamelist, List *options)
+{
+	ParallelCopyLeader pcl;
+	ParallelContext *pcxt;
+	ParallelCopyShared *shared;
+	BufferUsage *buffer_usage;
+	WalUsage   *wal_usage;
+	char	   *statement;
+	char	   *sharedstatement;
+	char	   *mqspace;
+	Size		statementlen;
+	int			querylen;
+	int			nworkers;
+	uint64		processed;
+
+	nworkers = ParallelCopyFromWorkers(cstate);
+	if (nworkers == 0)
+		return CopyFrom(cstate);
+
+	/*
+	 * The workers insert under our transaction and command IDs, and can't
+	 * assign them themselves.
+	 */
+	(void) GetCurrentTransactionId();
+	(void) GetCurrentCommandId(true);
+
+	statement = nodeToString(list_make5(options, attnamelist,
+										cstate->whereClause,
+										cstate->range_table,
+										cstate->rteperminfos));
+	statementlen = strlen(statement) + 1;
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext("postgres", "ParallelCopyMain", nworkers);
+
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(ParallelCopyShared));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+	shm_toc_estimate_chunk(&pcxt->estimator, statementlen);
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(sizeof(BufferUsage), pcxt->nworkers));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(sizeof(WalUsage), pcxt->nworkers));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(PARALLEL_COPY_QUEUE_SIZE, pcxt->nworkers));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+	if (debug_query_string)
+	{
+		querylen = strlen(debug_query_string);
+		shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+	else
+		querylen = 0;			/* keep compiler quiet */
+
+	InitializeParallelDSM(pcxt);
+
+	/* If no DSM segment was available, load the data ourselves */
+	if (pcxt->nworkers == 0)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		return CopyFrom(cstate);
+	}
+
+	shared = (ParallelCopyShared *) shm_toc_allocate(pcxt->toc,
+													 sizeof(ParallelCopyShared));
+	shared->relid = RelationGetRelid(cstate->rel);
+	pg_atomic_init_u64(&shared->processed, 0);
+	pg_atomic_init_u64(&shared->num_errors, 0);
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_SHARED, shared);
+
+	sharedstatement = (char *) shm_toc_allocate(pcxt->toc, statementlen);
+	memcpy(sharedstatement, statement, statementlen);
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_STATEMENT, sharedstatement);
+
+	buffer_usage = shm_toc_allocate(pcxt->toc,
+									mul_size(sizeof(BufferUsage), pcxt->nworkers));
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_BUFFER_USAGE, buffer_usage);
+	wal_usage = shm_toc_allocate(pcxt->toc,
+								 mul_size(sizeof(WalUsage), pcxt->nworkers));
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_WAL_USAGE, wal_usage);
+
+	if (debug_query_string)
+	{
+		char	   *sharedquery;
+
+		sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+		memcpy(sharedquery, debug_query_string, querylen + 1);
+		shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_QUERY_TEXT, sharedquery);
+	}
+
+	/* Set up a queue to each worker, with us as the sender */
+	pcl.mqh = palloc0(sizeof(shm_mq_handle *) * pcxt->nworkers);
+	mqspace = shm_toc_allocate(pcxt->toc,
+							   mul_size(PARALLEL_COPY_QUEUE_SIZE,
+										pcxt->nworkers));
+	for (int i = 0; i < pcxt->nworkers; i++)
+	{
+		shm_mq	   *mq;
+
+		mq = shm_mq_create(mqspace + i * PARALLEL_COPY_QUEUE_SIZE,
+						   PARALLEL_COPY_QUEUE_SIZE);
+		shm_mq_set_sender(mq, MyProc);
+		pcl.mqh[i] = shm_mq_attach(mq, pcxt->seg, NULL);
+	}
+	shm_toc_insert(pcxt->toc, PARALLEL_COPY_KEY_QUEUES, mqspace);
+
+	LaunchParallelWorkers(pcxt);
+
+	if (pcxt->nworkers_launched == 0)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		return CopyFrom(cstate);
+	}
+
+	for (int i = 0; i < pcxt->nworkers_launched; i++)
+		shm_mq_set_handle(pcl.mqh[i], pcxt->worker[i].bgwhandle);
+
+	pcl.cstate = cstate;
+	pcl.pcxt = pcxt;
+	pcl.next_worker = 0;
+	initStringInfo(&pcl.buf);
+	pcl.scan = 0;
+	pcl.eof = false;
+
+	ParallelCopyDistribute(&pcl);
+
+	/* Detaching tells the workers that there is no more input */
+	ParallelCopyDetachQueues(&pcl);
+	WaitForParallelWorkersToFinish(pcxt);
+
+	for (int i = 0; i < pcxt->nworkers_launched; i++)
+		InstrAccumParallelQuery(&buffer_usage[i], &wal_usage[i]);
+
+	processed = pg_atomic_read_u64(&shared->processed);
+	cstate->num_errors = pg_atomic_read_u64(&shared->num_errors);
+
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+
+	pgstat_progress_update_param(PROGRESS_COPY_TUPLES_PROCESSED, processed);
+	if (cstate->num_errors > 0)
+		pgstat_progress_update_param(PROGRESS_COPY_TUPLES_SKIPPED,
+									 cstate->num_errors);
+
+	if (cstate->opts.on_error != COPY_ON_ERROR_STOP &&
+		cstate->num_errors > 0)
+		ereport(NOTICE,
+				errmsg_plural("%llu row was skipped due to data type incompatibility",
+							  "%llu rows were skipped due to data type incompatibility",
+							  (unsigned long long) cstate->num_errors,
+							  (unsigned long long) cstate->num_errors));
+
+	return processed;
+}
+
+/*
+ * Read the input, cut it into chunks of whole lines, and send the chunks to
+ * the workers in turn.
+ *
+ * Finding the end of a line follows CopyReadLineText(): in CSV mode a
+ * newline within quotes doesn't end the line, and in text mode a backslash
+ * escapes the next character.  We don't otherwise check the input, and
+ * where it's malformed the worker that receives it reports the error.
+ */
+static void
+ParallelCopyDistribute(ParallelCopyLeader *pcl)
+{
+	CopyFromState cstate = pcl->cstate;
+	char	   *data;
+	bool		csv_mode = cstate->opts.csv_mode;
+	bool		skip_header = cstate->opts.header_line != COPY_HEADER_FALSE;
+	bool		end_marker = false;
+	bool		at_eof = false;
+	char		quotec = '\0';
+	char		escapec = '\0';
+	uint64		lineno = 1;		/* number of the line being scanned */
+	uint64		chunk_lineno = 1;	/* number of the first line in buf */
+
+	if (csv_mode)
+	{
+		quotec = cstate->opts.quote[0];
+		escapec = cstate->opts.escape[0];
+		/* ignore special escape processing if it's the same as quotec */
+		if (quotec == escapec)
+			escapec = '\0';
+	}
+
+	while (!end_marker && !at_eof)
+	{
+		bool		in_quote = false;
+		bool		last_was_esc = false;
+		bool		first_char_in_line = true;
+
+		/* Find the end of the line */
+		for (;;)
+		{
+			char		c;
+
+			if (!ParallelCopyFillBuf(pcl, 1))
+			{
+				at_eof = true;
+				break;
+			}
+			/* the buffer may move while filling it, so look it up each time */
+			data = pcl->buf.data;
+			c = data[pcl->scan++];
+
+			if (csv_mode)
+			{
+				if (in_quote && c == escapec)
+					last_was_esc = !last_was_esc;
+				if (c == quotec && !last_was_esc)
+					in_quote = !in_quote;
+				if (c != escapec)
+					last_was_esc = false;
+
+				/* count the lines in quoted fields, as the parser does */
+				if (in_quote &&
+					c == (cstate->eol_type == EOL_NL ? '\n' : '\r'))
+					lineno++;
+			}
+
+			if (c == '\r' && !in_quote)
+			{
+				if (cstate->eol_type == EOL_UNKNOWN ||
+					cstate->eol_type == EOL_CRNL)
+				{
+					if (ParallelCopyFillBuf(pcl, 1) &&
+						pcl->buf.data[pcl->scan] == '\n')
+					{
+						pcl->scan++;
+						cstate->eol_type = EOL_CRNL;
+						break;
+					}
+					if (cstate->eol_type == EOL_UNKNOWN)
+					{
+						cstate->eol_type = EOL_CR;
+						break;
+					}
+				}
+				else if (cstate->eol_type == EOL_CR)
+					break;
+			}
+			else if (c == '\n' && !in_quote)
+			{
+				if (cstate->eol_type == EOL_UNKNOWN)
+					cstate->eol_type = EOL_NL;
+				if (cstate->eol_type == EOL_NL)
+					break;
+			}
+			else if (c == '\\' && (!csv_mode || first_char_in_line) &&
+					 ParallelCopyFillBuf(pcl, 1))
+			{
+				data = pcl->buf.data;
+				if (data[pcl->scan] == '.')
+				{
+					/*
+					 * In CSV mode, \. is the end-of-copy marker only if it
+					 * makes up the whole line.
+					 */
+					if (!csv_mode)
+						end_marker = true;
+					else if (ParallelCopyFillBuf(pcl, 2))
+					{
+						data = pcl->buf.data;
+						end_marker = (data[pcl->scan + 1] == '\r' ||
+									  data[pcl->scan + 1] == '\n');
+					}
+				}
+				else if (!csv_mode)
+					pcl->scan++;	/* skip the escaped character */
+			}
+
+			first_char_in_line = false;
+		}
+
+		lineno++;
+
+		if (skip_header)
+		{
+			/* The workers don't expect a header line, so drop it */
+			pcl->buf.len -= pcl->scan;
+			memmove(pcl->buf.data, pcl->buf.data + pcl->scan, pcl->buf.len);
+			pcl->scan = 0;
+			chunk_lineno = lineno;
+			skip_header = false;
+		}
+		else if (pcl->scan >= PARALLEL_COPY_CHUNK_SIZE ||
+				 ((end_marker || at_eof) && pcl->scan > 0))
+		{
+			ParallelCopySendChunk(pcl, chunk_lineno);
+			chunk_lineno = lineno;
+		}
+	}
+
+	/* Like CopyReadLine(), discard whatever follows the end-of-copy marker */
+	if (end_marker && cstate->copy_src == COPY_FRONTEND)
+	{
+		while (CopyGetData(cstate, pcl->buf.data, 1, pcl->buf.maxlen - 1) > 0)
+			;
+	}
+}
+
+/*
+ * Make sure that at least 'nbytes' bytes past the scan position are in the
+ * buffer, reading more input if needed.
+ *
+ * Returns false if the input ends first.
+ */
+static bool
+ParallelCopyFillBuf(ParallelCopyLeader *pcl, int nbytes)
+{
+	CopyFromState cstate = pcl->cstate;
+	StringInfo	buf = &pcl->buf;
+
+	while (buf->len - pcl->scan < nbytes)
+	{
+		int			nread;
+
+		if (pcl->eof)
+			return false;
+
+		enlargeStringInfo(buf, RAW_BUF_SIZE);
+		nread = CopyGetData(cstate, buf->data + buf->len, 1, RAW_BUF_SIZE);
+		if (nread == 0)
+		{
+			pcl->eof = true;
+			return false;
+		}
+		buf->len += nread;
+		buf->data[buf->len] = '\0';
+
+		cstate->bytes_processed += nread;
+		pgstat_progress_update_param(PROGRESS_COPY_BYTES_PROCESSED,
+									 cstate->bytes_processed);
+	}
+
+	return true;
+}
+
+/*
+ * Send the lines before the scan position to the next worker, and remove
+ * them from the buffer.
+ */
+static void
+ParallelCopySendChunk(ParallelCopyLeader *pcl, uint64 first_lineno)
+{
+	ParallelCopyChunkHeader hdr;
+	shm_mq_iovec iov[2];
+	shm_mq_result res;
+
+	hdr.first_lineno = first_lineno;
+	hdr.eol_type = pcl->cstate->eol_type;
+	iov[0].data = (char *) &hdr;
+	iov[0].len = sizeof(hdr);
+	iov[1].data = pcl->buf.data;
+	iov[1].len = pcl->scan;
+
+	res = shm_mq_sendv(pcl->mqh[pcl->next_worker], iov, 2, false, true);
+	if (res != SHM_MQ_SUCCESS)
+	{
+		/*
+		 * The worker has exited, normally because of an error.  Let the
+		 * others finish, to report the error.
+		 */
+		ParallelCopyDetachQueues(pcl);
+		WaitForParallelWorkersToFinish(pcl->pcxt);
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("parallel worker for COPY exited unexpectedly")));
+	}
+
+	pcl->next_worker = (pcl->next_worker + 1) % pcl->pcxt->nworkers_launched;
+
+	pcl->buf.len -= pcl->scan;
+	memmove(pcl->buf.data, pcl->buf.data + pcl->scan, pcl->buf.len);
+	pcl->scan = 0;
+}
+
+/*
+ * Detach from all the workers' queues.
+ */
+static void
+ParallelCopyDetachQueues(ParallelCopyLeader *pcl)
+{
+	for (int i = 0; i < pcl->pcxt->nworkers; i++)
+	{
+		if (pcl->mqh[i] != NULL)
+		{
+			shm_mq_detach(pcl->mqh[i]);
+			pcl->mqh[i] = NULL;
+		}
+	}
+}
+
+/*
+ * Perform work within a launched parallel process.
+ */
+void
+ParallelCopyMain(dsm_segment *seg, shm_toc *toc)
+{
+	ParallelCopyShared *shared;
+	ParallelCopyWorker pcw;
+	CopyFromState cstate;
+	Relation	rel;
+	List	   *statement;
+	char	   *sharedquery;
+	char	   *mqspace;
+	shm_mq	   *mq;
+	BufferUsage *buffer_usage;
+	WalUsage   *wal_usage;
+	uint64		processed;
+
+	shared = (ParallelCopyShared *) shm_toc_lookup(toc, PARALLEL_COPY_KEY_SHARED,
+												   false);
+
+	/* Set debug_query_string for individual workers */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_COPY_KEY_QUERY_TEXT, true);
+	debug_query_string = sharedquery;
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	statement = (List *) stringToNode(shm_toc_lookup(toc,
+													 PARALLEL_COPY_KEY_STATEMENT,
+													 false));
+
+	/* The leader holds the same lock */
+	rel = table_open(shared->relid, RowExclusiveLock);
+
+	mqspace = shm_toc_lookup(toc, PARALLEL_COPY_KEY_QUEUES, false);
+	mq = (shm_mq *) (mqspace + ParallelWorkerNumber * PARALLEL_COPY_QUEUE_SIZE);
+	shm_mq_set_receiver(mq, MyProc);
+
+	memset(&pcw, 0, sizeof(pcw));
+	pcw.mqh = shm_mq_attach(mq, seg, NULL);
+	MyCopyWorker = &pcw;
+
+	/* Prepare to track buffer usage during the load */
+	InstrStartParallelQuery();
+
+	cstate = BeginCopyFrom(NULL, rel, list_nth(statement, 2), NULL, false,
+						   ParallelCopyReadData, list_nth(statement, 1),
+						   linitial(statement));
+	cstate->range_table = list_nth(statement, 3);
+	cstate->rteperminfos = list_nth(statement, 4);
+	/* The leader has consumed the header line */
+	cstate->opts.header_line = COPY_HEADER_FALSE;
+	pcw.cstate = cstate;
+
+	processed = CopyFrom(cstate);
+
+	pg_atomic_fetch_add_u64(&shared->processed, processed);
+	pg_atomic_fetch_add_u64(&shared->num_errors, cstate->num_errors);
+
+	EndCopyFrom(cstate);
+
+	/* Report buffer/WAL usage during the load */
+	buffer_usage = shm_toc_lookup(toc, PARALLEL_COPY_KEY_BUFFER_USAGE, false);
+	wal_usage = shm_toc_lookup(toc, PARALLEL_COPY_KEY_WAL_USAGE, false);
+	InstrEndParallelQuery(&buffer_usage[ParallelWorkerNumber],
+						  &wal_usage[ParallelWorkerNumber]);
+
+	shm_mq_detach(pcw.mqh);
+	MyCopyWorker = NULL;
+
+	table_close(rel, RowExclusiveLock);
+}
+
+/*
+ * Data source callback of a worker's CopyFromState: return the chunks
+ * received from the leader, one after another.
+ */
+static int
+ParallelCopyReadData(void *outbuf, int minread, int maxread)
+{
+	ParallelCopyWorker *pcw = MyCopyWorker;
+	int			nbytes;
+
+	while (pcw->chunk_pos >= pcw->chunk_len)
+	{
+		ParallelCopyChunkHeader hdr;
+		shm_mq_result res;
+		Size		len;
+		void	   *data;
+
+		if (pcw->done)
+			return 0;
+
+		res = shm_mq_receive(pcw->mqh, &len, &data, false);
+		if (res != SHM_MQ_SUCCESS)
+		{
+			/* the leader has sent all the input */
+			pcw->done = true;
+			return 0;
+		}
+		if (len < sizeof(hdr))
+			elog(ERROR, "invalid chunk of COPY data");
+
+		memcpy(&hdr, data, sizeof(hdr));
+		pcw->chunk = (char *) data + sizeof(hdr);
+		pcw->chunk_len = len - sizeof(hdr);
+		pcw->chunk_pos = 0;
+
+		if (pcw->cstate->eol_type == EOL_UNKNOWN)
+			pcw->cstate->eol_type = hdr.eol_type;
+
+		/*
+		 * Since chunks hold whole lines, the parser asks for more data when
+		 * it starts on the first line of the chunk, after incrementing
+		 * cur_lineno.  With CR line endings in CSV mode though, it asks
+		 * while looking past the CR that ends the last line of the previous
+		 * chunk, and increments cur_lineno once more before it starts on the
+		 * new line.  An error in the fields of that last line then reports
+		 * one line number too few, which we don't bother to avoid.
+		 */
+		if (pcw->chunk != NULL && pcw->cstate->opts.csv_mode &&
+			pcw->cstate->eol_type == EOL_CR)
+			pcw->cstate->cur_lineno = hdr.first_lineno - 1;
+		else
+			pcw->cstate->cur_lineno = hdr.first_lineno;
+	}
+
+	nbytes = Min(maxread, pcw->chunk_len - pcw->chunk_pos);
+	memcpy(outbuf, pcw->chunk + pcw->chunk_pos, nbytes);
+	pcw->chunk_pos += nbytes;
+
+	return nbytes;
+}
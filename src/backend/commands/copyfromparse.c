@@ -63,6 +63,7 @@
 #include <sys/stat.h>
 
 #include "commands/copy.h"
+#include "commands/copyarrow.h"
 #include "commands/copyfrom_internal.h"
 #include "commands/progress.h"
 #include "executor/executor.h"
@@ -72,7 +73,9 @@
 #include "miscadmin.h"
 #include "nodes/miscnodes.h"
 #include "pgstat.h"
+#include "port/pg_bitutils.h"
 #include "port/pg_bswap.h"
+#include "port/simd.h"
 #include "utils/builtins.h"
 #include "utils/rel.h"
 
@@ -153,18 +156,17 @@ static bool CopyReadLine(CopyFromState cstate);
 static bool CopyReadLineText(CopyFromState cstate);
 static int	CopyReadAttributesText(CopyFromState cstate);
 static int	CopyReadAttributesCSV(CopyFromState cstate);
+static inline int CopySkipPlainBytes(const char *s, int len, char c1,
+									 char c2, char c3, char c4);
 static Datum CopyReadBinaryAttribute(CopyFromState cstate, FmgrInfo *flinfo,
 									 Oid typioparam, int32 typmod,
 									 bool *isnull);
 
 
 /* Low-level communications functions */
-static int	CopyGetData(CopyFromState cstate, void *databuf,
-						int minread, int maxread);
 static inline bool CopyGetInt32(CopyFromState cstate, int32 *val);
 static inline bool CopyGetInt16(CopyFromState cstate, int16 *val);
 static void CopyLoadInputBuf(CopyFromState cstate);
-static int	CopyReadBinaryData(CopyFromState cstate, char *dest, int nbytes);
 
 void
 ReceiveCopyBegin(CopyFromState cstate)
@@ -241,7 +243,7 @@ ReceiveCopyBinaryHeader(CopyFromState cstate)
  *
  * NB: no data conversion is applied here.
  */
-static int
+int
 CopyGetData(CopyFromState cstate, void *databuf, int minread, int maxread)
 {
 	int			bytesread = 0;
@@ -697,7 +699,7 @@ CopyLoadInputBuf(CopyFromState cstate)
  * and writes them to 'dest'.  Returns the number of bytes read (which
  * would be less than 'nbytes' only if we reach EOF).
  */
-static int
+int
 CopyReadBinaryData(CopyFromState cstate, char *dest, int nbytes)
 {
 	int			copied_bytes = 0;
@@ -1012,6 +1014,11 @@ NextCopyFrom(CopyFromState cstate, ExprContext *econtext,
 
 		Assert(fieldno == attr_count);
 	}
+	else if (cstate->opts.arrow)
+	{
+		if (!ArrowReadRow(cstate, values, nulls))
+			return false;
+	}
 	else
 	{
 		/* binary */
@@ -1261,6 +1268,33 @@ CopyReadLineText(CopyFromState cstate)
 			need_data = false;
 		}
 
+		/*
+		 * Skip over the bytes that need no special handling, a vector at a
+		 * time.  They are transferred to line_buf with the rest of the line.
+		 * In CSV mode, a backslash is special only as the first character
+		 * of a line.
+		 */
+		if (!cstate->opts.csv_mode)
+			input_buf_ptr += CopySkipPlainBytes(copy_input_buf + input_buf_ptr,
+												copy_buf_len - input_buf_ptr,
+												'\n', '\r', '\\', '\\');
+		else if (!first_char_in_line)
+		{
+			int			nplain;
+
+			nplain = CopySkipPlainBytes(copy_input_buf + input_buf_ptr,
+										copy_buf_len - input_buf_ptr,
+										'\n', '\r', quotec,
+										escapec != '\0' ? escapec : quotec);
+			if (nplain > 0)
+			{
+				input_buf_ptr += nplain;
+				last_was_esc = false;
+			}
+		}
+		if (input_buf_ptr >= copy_buf_len)
+			continue;
+
 		/* OK to fetch a character */
 		prev_raw_ptr = input_buf_ptr;
 		c = copy_input_buf[input_buf_ptr++];
@@ -1502,6 +1536,50 @@ not_end_of_copy:
 	return result;
 }
 
+/*
+ * Return the number of bytes at the start of 's', at most 'len', that come
+ * before the first of the characters c1 .. c4, scanning a vector at a time.
+ * The bytes at the end that don't fill a whole vector are not scanned, so
+ * the result can be smaller; the caller scans those one at a time anyway.
+ * The same character may be passed more than once.
+ */
+static inline int
+CopySkipPlainBytes(const char *s, int len, char c1, char c2, char c3, char c4)
+{
+	int			i = 0;
+#ifndef USE_NO_SIMD
+	const Vector8 v1 = vector8_broadcast((uint8) c1);
+	const Vector8 v2 = vector8_broadcast((uint8) c2);
+	const Vector8 v3 = vector8_broadcast((uint8) c3);
+	const Vector8 v4 = vector8_broadcast((uint8) c4);
+#endif
+
+	for (; i + (int) sizeof(Vector8) <= len; i += sizeof(Vector8))
+	{
+		Vector8		chunk;
+
+		vector8_load(&chunk, (const uint8 *) s + i);
+#ifndef USE_NO_SIMD
+		{
+			uint32		mask;
+
+			mask = vector8_highbit_mask(vector8_or(vector8_or(vector8_eq(chunk, v1),
+															  vector8_eq(chunk, v2)),
+												   vector8_or(vector8_eq(chunk, v3),
+															  vector8_eq(chunk, v4))));
+			if (mask != 0)
+				return i + pg_rightmost_one_pos32(mask);
+		}
+#else
+		if (vector8_has(chunk, (uint8) c1) || vector8_has(chunk, (uint8) c2) ||
+			vector8_has(chunk, (uint8) c3) || vector8_has(chunk, (uint8) c4))
+			break;
+#endif
+	}
+
+	return i;
+}
+
 /*
  *	Return decimal value for a hexadecimal digit
  */
@@ -1608,6 +1686,17 @@ CopyReadAttributesText(CopyFromState cstate)
 		for (;;)
 		{
 			char		c;
+			int			nplain;
+
+			/* Copy the bytes that need no de-escaping in one go */
+			nplain = CopySkipPlainBytes(cur_ptr, line_end_ptr - cur_ptr,
+										delimc, '\\', delimc, '\\');
+			if (nplain > 0)
+			{
+				memcpy(output_ptr, cur_ptr, nplain);
+				output_ptr += nplain;
+				cur_ptr += nplain;
+			}
 
 			end_ptr = cur_ptr;
 			if (cur_ptr >= line_end_ptr)
@@ -1864,6 +1953,17 @@ CopyReadAttributesCSV(CopyFromState cstate)
 			/* Not in quote */
 			for (;;)
 			{
+				int			nplain;
+
+				nplain = CopySkipPlainBytes(cur_ptr, line_end_ptr - cur_ptr,
+											delimc, quotec, delimc, quotec);
+				if (nplain > 0)
+				{
+					memcpy(output_ptr, cur_ptr, nplain);
+					output_ptr += nplain;
+					cur_ptr += nplain;
+				}
+
 				end_ptr = cur_ptr;
 				if (cur_ptr >= line_end_ptr)
 					goto endfield;
@@ -1887,6 +1987,17 @@ CopyReadAttributesCSV(CopyFromState cstate)
 			/* In quote */
 			for (;;)
 			{
+				int			nplain;
+
+				nplain = CopySkipPlainBytes(cur_ptr, line_end_ptr - cur_ptr,
+											escapec, quotec, escapec, quotec);
+				if (nplain > 0)
+				{
+					memcpy(output_ptr, cur_ptr, nplain);
+					output_ptr += nplain;
+					cur_ptr += nplain;
+				}
+
 				end_ptr = cur_ptr;
 				if (cur_ptr >= line_end_ptr)
 					ereport(ERROR,
@@ -20,6 +20,7 @@
 
 #include "access/tableam.h"
 #include "commands/copy.h"
+#include "commands/copyarrow.h"
 #include "commands/progress.h"
 #include "executor/execdesc.h"
 #include "executor/executor.h"
@@ -92,6 +93,8 @@ typedef struct CopyToStateData
 	FmgrInfo   *out_functions;	/* lookup info for output functions */
 	MemoryContext rowcontext;	/* per-row evaluation context */
 	uint64		bytes_processed;	/* number of bytes processed so far */
+
+	ArrowWriteState *arrow_state;	/* columns of the Arrow record batch */
 } CopyToStateData;
 
 /* DestReceiver for COPY (query) TO */
@@ -775,7 +778,7 @@ DoCopyTo(CopyToState cstate)
 		bool		isvarlena;
 		Form_pg_attribute attr = TupleDescAttr(tupDesc, attnum - 1);
 
-		if (cstate->opts.binary)
+		if (cstate->opts.binary && !cstate->opts.arrow)
 			getTypeBinaryOutputInfo(attr->atttypid,
 									&out_func_oid,
 									&isvarlena);
@@ -796,7 +799,15 @@ DoCopyTo(CopyToState cstate)
 											   "COPY TO",
 											   ALLOCSET_DEFAULT_SIZES);
 
-	if (cstate->opts.binary)
+	if (cstate->opts.arrow)
+	{
+		/* Send the Arrow schema */
+		cstate->arrow_state = ArrowWriteBegin(tupDesc, cstate->attnumlist,
+											  cstate->out_functions);
+		ArrowWriteSchema(cstate->arrow_state, cstate->fe_msgbuf);
+		CopySendEndOfRow(cstate);
+	}
+	else if (cstate->opts.binary)
 	{
 		/* Generate header for a binary copy */
 		int32		tmp;
@@ -884,7 +895,13 @@ DoCopyTo(CopyToState cstate)
 		processed = ((DR_copy *) cstate->queryDesc->dest)->processed;
 	}
 
-	if (cstate->opts.binary)
+	if (cstate->opts.arrow)
+	{
+		/* Send the last record batch and the end-of-stream marker */
+		ArrowWriteEnd(cstate->arrow_state, cstate->fe_msgbuf);
+		CopySendEndOfRow(cstate);
+	}
+	else if (cstate->opts.binary)
 	{
 		/* Generate trailer for a binary copy */
 		CopySendInt16(cstate, -1);
@@ -915,6 +932,18 @@ CopyOneRowTo(CopyToState cstate, TupleTableSlot *slot)
 	MemoryContextReset(cstate->rowcontext);
 	oldcontext = MemoryContextSwitchTo(cstate->rowcontext);
 
+	if (cstate->opts.arrow)
+	{
+		/* Add the row to the record batch, and send the batch when full */
+		if (ArrowWriteRow(cstate->arrow_state, slot))
+		{
+			ArrowWriteBatch(cstate->arrow_state, cstate->fe_msgbuf);
+			CopySendEndOfRow(cstate);
+		}
+		MemoryContextSwitchTo(oldcontext);
+		return;
+	}
+
 	if (cstate->opts.binary)
 	{
 		/* Binary per-tuple header */
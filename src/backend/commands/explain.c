@@ -3605,9 +3605,11 @@ show_tidbitmap_info(BitmapHeapScanState *planstate, ExplainState *es)
 			ExplainIndentText(es);
 			appendStringInfoString(es->str, "Heap Blocks:");
 			if (planstate->exact_pages > 0)
-				appendStringInfo(es->str, " exact=%ld", planstate->exact_pages);
+				appendStringInfo(es->str, " exact=" UINT64_FORMAT,
+								 planstate->exact_pages);
 			if (planstate->lossy_pages > 0)
-				appendStringInfo(es->str, " lossy=%ld", planstate->lossy_pages);
+				appendStringInfo(es->str, " lossy=" UINT64_FORMAT,
+								 planstate->lossy_pages);
 			appendStringInfoChar(es->str, '\n');
 		}
 	}
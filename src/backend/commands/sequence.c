@@ -1895,6 +1895,33 @@ ResetSequenceCaches(void)
 	last_used_seq = NULL;
 }
 
+/*
+ * Does the session have a value for currval() or lastval() to return?
+ */
+bool
+SequenceValuesExist(void)
+{
+	HASH_SEQ_STATUS seq;
+	SeqTable	elm;
+
+	if (last_used_seq != NULL)
+		return true;
+	if (seqhashtab == NULL)
+		return false;
+
+	hash_seq_init(&seq, seqhashtab);
+	while ((elm = (SeqTable) hash_seq_search(&seq)) != NULL)
+	{
+		if (elm->last_valid)
+		{
+			hash_seq_term(&seq);
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /*
  * Mask a Sequence page before performing consistency checks on it.
  */
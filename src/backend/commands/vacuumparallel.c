@@ -16,6 +16,11 @@
  * the parallel context is re-initialized so that the same DSM can be used for
  * multiple passes of index bulk-deletion and index cleanup.
  *
+ * The workers can also join the leader in the first pass over the heap, if the
+ * table is large enough.  The table AM decides how the heap is divided among
+ * the participants; we only provide a chunk of DSM for its shared state, and
+ * launch and wait for the workers.
+ *
  * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
  *
@@ -27,6 +32,7 @@
 #include "postgres.h"
 
 #include "access/amapi.h"
+#include "access/heapam.h"
 #include "access/table.h"
 #include "access/xact.h"
 #include "commands/progress.h"
@@ -49,6 +55,7 @@
 #define PARALLEL_VACUUM_KEY_BUFFER_USAGE	3
 #define PARALLEL_VACUUM_KEY_WAL_USAGE		4
 #define PARALLEL_VACUUM_KEY_INDEX_STATS		5
+#define PARALLEL_VACUUM_KEY_TABLE_SCAN		6
 
 /*
  * Shared information among parallel workers.  So this is allocated in the DSM
@@ -64,6 +71,12 @@ typedef struct PVShared
 	Oid			relid;
 	int			elevel;
 
+	/*
+	 * True while workers are launched to scan the table rather than to
+	 * vacuum or clean up indexes.
+	 */
+	bool		table_scan;
+
 	/*
 	 * Fields for both index vacuum and cleanup.
 	 *
@@ -186,6 +199,17 @@ struct ParallelVacuumState
 	/* Shared dead items space among parallel vacuum workers */
 	TidStore   *dead_items;
 
+	/*
+	 * Table AM's shared state for the parallel table scan, or NULL if the
+	 * table is not scanned in parallel.  nworkers_table_scan is the number of
+	 * workers to request for it.
+	 */
+	void	   *table_scan;
+	int			nworkers_table_scan;
+
+	/* Have we launched workers before, so that the DSM must be reinitialized? */
+	bool		workers_launched;
+
 	/* Points to buffer usage area in DSM */
 	BufferUsage *buffer_usage;
 
@@ -220,8 +244,9 @@ struct ParallelVacuumState
 	PVIndVacStatus status;
 };
 
-static int	parallel_vacuum_compute_workers(Relation *indrels, int nindexes, int nrequested,
-											bool *will_parallel_vacuum);
+static int	parallel_vacuum_compute_workers(Relation rel, Relation *indrels, int nindexes,
+											int nrequested, bool *will_parallel_vacuum,
+											bool table_scan, int *nworkers_table_scan);
 static void parallel_vacuum_process_all_indexes(ParallelVacuumState *pvs, int num_index_scans,
 												bool vacuum);
 static void parallel_vacuum_process_safe_indexes(ParallelVacuumState *pvs);
@@ -236,12 +261,17 @@ static void parallel_vacuum_error_callback(void *arg);
  * Try to enter parallel mode and create a parallel context.  Then initialize
  * shared memory state.
  *
+ * If table_scan_len is not 0, the table is also considered for a parallel
+ * scan, and that much space is reserved for the table AM's shared state of
+ * the scan.  See parallel_vacuum_get_table_scan().
+ *
  * On success, return parallel vacuum state.  Otherwise return NULL.
  */
 ParallelVacuumState *
 parallel_vacuum_init(Relation rel, Relation *indrels, int nindexes,
 					 int nrequested_workers, int vac_work_mem,
-					 int elevel, BufferAccessStrategy bstrategy)
+					 int elevel, BufferAccessStrategy bstrategy,
+					 Size table_scan_len)
 {
 	ParallelVacuumState *pvs;
 	ParallelContext *pcxt;
@@ -255,22 +285,25 @@ parallel_vacuum_init(Relation rel, Relation *indrels, int nindexes,
 	Size		est_shared_len;
 	int			nindexes_mwm = 0;
 	int			parallel_workers = 0;
+	int			nworkers_table_scan;
 	int			querylen;
 
 	/*
 	 * A parallel vacuum must be requested and there must be indexes on the
-	 * relation
+	 * relation, or the table itself must be considered for a parallel scan
 	 */
 	Assert(nrequested_workers >= 0);
-	Assert(nindexes > 0);
+	Assert(nindexes > 0 || table_scan_len > 0);
 
 	/*
 	 * Compute the number of parallel vacuum workers to launch
 	 */
-	will_parallel_vacuum = (bool *) palloc0(sizeof(bool) * nindexes);
-	parallel_workers = parallel_vacuum_compute_workers(indrels, nindexes,
+	will_parallel_vacuum = (bool *) palloc0(sizeof(bool) * Max(nindexes, 1));
+	parallel_workers = parallel_vacuum_compute_workers(rel, indrels, nindexes,
 													   nrequested_workers,
-													   will_parallel_vacuum);
+													   will_parallel_vacuum,
+													   table_scan_len > 0,
+													   &nworkers_table_scan);
 	if (parallel_workers <= 0)
 	{
 		/* Can't perform vacuum in parallel -- return NULL */
@@ -284,6 +317,7 @@ parallel_vacuum_init(Relation rel, Relation *indrels, int nindexes,
 	pvs->will_parallel_vacuum = will_parallel_vacuum;
 	pvs->bstrategy = bstrategy;
 	pvs->heaprel = rel;
+	pvs->nworkers_table_scan = nworkers_table_scan;
 
 	EnterParallelMode();
 	pcxt = CreateParallelContext("postgres", "parallel_vacuum_main",
@@ -301,6 +335,13 @@ parallel_vacuum_init(Relation rel, Relation *indrels, int nindexes,
 	shm_toc_estimate_chunk(&pcxt->estimator, est_shared_len);
 	shm_toc_estimate_keys(&pcxt->estimator, 1);
 
+	/* Estimate size for the table scan -- PARALLEL_VACUUM_KEY_TABLE_SCAN */
+	if (nworkers_table_scan > 0)
+	{
+		shm_toc_estimate_chunk(&pcxt->estimator, table_scan_len);
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+
 	/*
 	 * Estimate space for BufferUsage and WalUsage --
 	 * PARALLEL_VACUUM_KEY_BUFFER_USAGE and PARALLEL_VACUUM_KEY_WAL_USAGE.
@@ -392,6 +433,15 @@ parallel_vacuum_init(Relation rel, Relation *indrels, int nindexes,
 	shm_toc_insert(pcxt->toc, PARALLEL_VACUUM_KEY_SHARED, shared);
 	pvs->shared = shared;
 
+	/* Prepare space for the table scan; the table AM initializes it */
+	if (nworkers_table_scan > 0)
+	{
+		pvs->table_scan = shm_toc_allocate(pcxt->toc, table_scan_len);
+		MemSet(pvs->table_scan, 0, table_scan_len);
+		shm_toc_insert(pcxt->toc, PARALLEL_VACUUM_KEY_TABLE_SCAN,
+					   pvs->table_scan);
+	}
+
 	/*
 	 * Allocate space for each worker's BufferUsage and WalUsage; no need to
 	 * initialize
@@ -491,6 +541,96 @@ parallel_vacuum_reset_dead_items(ParallelVacuumState *pvs)
 	dead_items_info->num_items = 0;
 }
 
+/*
+ * Returns the shared state of the parallel table scan, or NULL if the table
+ * is not to be scanned in parallel.
+ */
+void *
+parallel_vacuum_get_table_scan(ParallelVacuumState *pvs)
+{
+	return pvs->table_scan;
+}
+
+/*
+ * Launch parallel workers to join the leader in scanning the table.
+ *
+ * The leader scans the table too, and then calls
+ * parallel_vacuum_table_scan_end() to wait for the workers.  The workers call
+ * heap_vacuum_parallel_scan_worker().  Returns the number of workers launched.
+ */
+int
+parallel_vacuum_table_scan_begin(ParallelVacuumState *pvs)
+{
+	int			nworkers;
+
+	Assert(!IsParallelWorker());
+	Assert(pvs->table_scan != NULL);
+
+	nworkers = Min(pvs->nworkers_table_scan, pvs->pcxt->nworkers);
+
+	/* Reinitialize parallel context to relaunch parallel workers */
+	if (pvs->workers_launched)
+		ReinitializeParallelDSM(pvs->pcxt);
+
+	pvs->shared->table_scan = true;
+
+	/* Setup the shared cost-based vacuum delay; see the index case */
+	pg_atomic_write_u32(&(pvs->shared->cost_balance), VacuumCostBalance);
+	pg_atomic_write_u32(&(pvs->shared->active_nworkers), 0);
+
+	ReinitializeParallelWorkers(pvs->pcxt, nworkers);
+	LaunchParallelWorkers(pvs->pcxt);
+	pvs->workers_launched = true;
+
+	if (pvs->pcxt->nworkers_launched > 0)
+	{
+		VacuumCostBalance = 0;
+		VacuumCostBalanceLocal = 0;
+		VacuumSharedCostBalance = &(pvs->shared->cost_balance);
+		VacuumActiveNWorkers = &(pvs->shared->active_nworkers);
+
+		/* The leader participates in the scan */
+		pg_atomic_add_fetch_u32(VacuumActiveNWorkers, 1);
+	}
+
+	ereport(pvs->shared->elevel,
+			(errmsg(ngettext("launched %d parallel vacuum worker for table scanning (planned: %d)",
+							 "launched %d parallel vacuum workers for table scanning (planned: %d)",
+							 pvs->pcxt->nworkers_launched),
+					pvs->pcxt->nworkers_launched, nworkers)));
+
+	return pvs->pcxt->nworkers_launched;
+}
+
+/*
+ * Wait for the workers launched by parallel_vacuum_table_scan_begin() to
+ * finish.
+ */
+void
+parallel_vacuum_table_scan_end(ParallelVacuumState *pvs)
+{
+	Assert(!IsParallelWorker());
+	Assert(pvs->shared->table_scan);
+
+	if (VacuumActiveNWorkers)
+		pg_atomic_sub_fetch_u32(VacuumActiveNWorkers, 1);
+
+	WaitForParallelWorkersToFinish(pvs->pcxt);
+
+	for (int i = 0; i < pvs->pcxt->nworkers_launched; i++)
+		InstrAccumParallelQuery(&pvs->buffer_usage[i], &pvs->wal_usage[i]);
+
+	/* Carry the shared balance value back and disable shared costing */
+	if (VacuumSharedCostBalance)
+	{
+		VacuumCostBalance = pg_atomic_read_u32(VacuumSharedCostBalance);
+		VacuumSharedCostBalance = NULL;
+		VacuumActiveNWorkers = NULL;
+	}
+
+	pvs->shared->table_scan = false;
+}
+
 /*
  * Do parallel index bulk-deletion with parallel workers.
  */
@@ -542,16 +682,24 @@ parallel_vacuum_cleanup_all_indexes(ParallelVacuumState *pvs, long num_table_tup
  * the number of indexes that support parallel vacuum.  This function also
  * sets will_parallel_vacuum to remember indexes that participate in parallel
  * vacuum.
+ *
+ * If table_scan is true, *nworkers_table_scan is set to the number of workers
+ * to use for scanning the table, which is computed from the size of the table
+ * the same way as for a parallel sequential scan, unless nrequested is given.
+ * The returned number of workers covers both.
  */
 static int
-parallel_vacuum_compute_workers(Relation *indrels, int nindexes, int nrequested,
-								bool *will_parallel_vacuum)
+parallel_vacuum_compute_workers(Relation rel, Relation *indrels, int nindexes,
+								int nrequested, bool *will_parallel_vacuum,
+								bool table_scan, int *nworkers_table_scan)
 {
 	int			nindexes_parallel = 0;
 	int			nindexes_parallel_bulkdel = 0;
 	int			nindexes_parallel_cleanup = 0;
 	int			parallel_workers;
 
+	*nworkers_table_scan = 0;
+
 	/*
 	 * We don't allow performing parallel operation in standalone backend or
 	 * when parallelism is disabled.
@@ -587,18 +735,48 @@ parallel_vacuum_compute_workers(Relation *indrels, int nindexes, int nrequested,
 	/* The leader process takes one index */
 	nindexes_parallel--;
 
-	/* No index supports parallel vacuum */
-	if (nindexes_parallel <= 0)
-		return 0;
-
-	/* Compute the parallel degree */
-	parallel_workers = (nrequested > 0) ?
-		Min(nrequested, nindexes_parallel) : nindexes_parallel;
+	/* Compute the parallel degree, unless no index supports parallel vacuum */
+	if (nindexes_parallel > 0)
+		parallel_workers = (nrequested > 0) ?
+			Min(nrequested, nindexes_parallel) : nindexes_parallel;
+	else
+		parallel_workers = 0;
 
 	/* Cap by max_parallel_maintenance_workers */
 	parallel_workers = Min(parallel_workers, max_parallel_maintenance_workers);
 
-	return parallel_workers;
+	if (table_scan)
+	{
+		BlockNumber heap_pages = RelationGetNumberOfBlocks(rel);
+
+		/*
+		 * As for a parallel sequential scan, a table of
+		 * min_parallel_table_scan_size gets one worker, and one more each time
+		 * the table triples in size.
+		 */
+		if (heap_pages >= (BlockNumber) min_parallel_table_scan_size)
+		{
+			int			heap_parallel_threshold;
+			int			heap_parallel_workers = 1;
+
+			heap_parallel_threshold = Max(min_parallel_table_scan_size, 1);
+			while (heap_pages >= (BlockNumber) (heap_parallel_threshold * 3))
+			{
+				heap_parallel_workers++;
+				heap_parallel_threshold *= 3;
+				if (heap_parallel_threshold > INT_MAX / 3)
+					break;		/* avoid overflow */
+			}
+
+			if (nrequested > 0)
+				heap_parallel_workers = nrequested;
+
+			*nworkers_table_scan = Min(heap_parallel_workers,
+									   max_parallel_maintenance_workers);
+		}
+	}
+
+	return Max(parallel_workers, *nworkers_table_scan);
 }
 
 /*
@@ -668,7 +846,7 @@ parallel_vacuum_process_all_indexes(ParallelVacuumState *pvs, int num_index_scan
 	if (nworkers > 0)
 	{
 		/* Reinitialize parallel context to relaunch parallel workers */
-		if (num_index_scans > 0)
+		if (pvs->workers_launched)
 			ReinitializeParallelDSM(pvs->pcxt);
 
 		/*
@@ -687,6 +865,7 @@ parallel_vacuum_process_all_indexes(ParallelVacuumState *pvs, int num_index_scan
 		ReinitializeParallelWorkers(pvs->pcxt, nworkers);
 
 		LaunchParallelWorkers(pvs->pcxt);
+		pvs->workers_launched = true;
 
 		if (pvs->pcxt->nworkers_launched > 0)
 		{
@@ -980,8 +1159,8 @@ parallel_vacuum_index_is_parallel_safe(Relation indrel, int num_index_scans,
 /*
  * Perform work within a launched parallel process.
  *
- * Since parallel vacuum workers perform only index vacuum or index cleanup,
- * we don't need to report progress information.
+ * Parallel vacuum workers perform index vacuum or index cleanup, or scan the
+ * table.  Progress information is reported by the leader alone.
  */
 void
 parallel_vacuum_main(dsm_segment *seg, shm_toc *toc)
@@ -1025,7 +1204,6 @@ parallel_vacuum_main(dsm_segment *seg, shm_toc *toc)
 	 * matched to the leader's one.
 	 */
 	vac_open_indexes(rel, RowExclusiveLock, &nindexes, &indrels);
-	Assert(nindexes > 0);
 
 	if (shared->maintenance_work_mem_worker > 0)
 		maintenance_work_mem = shared->maintenance_work_mem_worker;
@@ -1055,6 +1233,7 @@ parallel_vacuum_main(dsm_segment *seg, shm_toc *toc)
 	pvs.indstats = indstats;
 	pvs.shared = shared;
 	pvs.dead_items = dead_items;
+	pvs.table_scan = shm_toc_lookup(toc, PARALLEL_VACUUM_KEY_TABLE_SCAN, true);
 	pvs.relnamespace = get_namespace_name(RelationGetNamespace(rel));
 	pvs.relname = pstrdup(RelationGetRelationName(rel));
 	pvs.heaprel = rel;
@@ -1076,8 +1255,22 @@ parallel_vacuum_main(dsm_segment *seg, shm_toc *toc)
 	/* Prepare to track buffer usage during parallel execution */
 	InstrStartParallelQuery();
 
-	/* Process indexes to perform vacuum/cleanup */
-	parallel_vacuum_process_safe_indexes(&pvs);
+	if (shared->table_scan)
+	{
+		/* Join the leader in scanning the table */
+		if (VacuumActiveNWorkers)
+			pg_atomic_add_fetch_u32(VacuumActiveNWorkers, 1);
+
+		heap_vacuum_parallel_scan_worker(rel, &pvs, pvs.bstrategy);
+
+		if (VacuumActiveNWorkers)
+			pg_atomic_sub_fetch_u32(VacuumActiveNWorkers, 1);
+	}
+	else
+	{
+		/* Process indexes to perform vacuum/cleanup */
+		parallel_vacuum_process_safe_indexes(&pvs);
+	}
 
 	/* Report buffer/WAL usage during parallel execution */
 	buffer_usage = shm_toc_lookup(toc, PARALLEL_VACUUM_KEY_BUFFER_USAGE, false);
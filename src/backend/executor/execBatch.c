@@ -0,0 +1,444 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatch.c
+ *	  Support for processing tuples a batch at a time
+ *
+ * Some executor nodes can pass tuples to their parent in batches of up to
+ * executor_batch_size rows, stored column-wise, instead of one slot at a
+ * time.  Currently a SeqScan does that for a plain Agg directly above it,
+ * which avoids the per-tuple overhead of ExecProcNode(), ExecScan() and the
+ * expression interpreter for simple aggregate queries over large tables.
+ *
+ * Only scan quals made up of "Var op Const" clauses are supported.  Each
+ * clause is applied to all the rows still selected before the next clause is
+ * considered.  Comparisons on the common integer and datetime types are done
+ * inline, any other operator is called through its function.  Since the
+ * clauses are evaluated in their original order on the rows that passed the
+ * previous clauses, the result is the same as evaluating the qual row by row.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/execBatch.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "catalog/pg_proc.h"
+#include "executor/execBatch.h"
+#include "nodes/nodeFuncs.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+
+/* GUC */
+int			executor_batch_size = 1024;
+
+static bool batch_qual_clause(TupleBatch *batch, TupleDesc tupdesc,
+							  Expr *clause, Index scanrelid,
+							  BatchQualClause *bqc);
+static bool batch_cmp_for_func(Oid funcid, BatchCmpType *cmptype,
+							   BatchCmpOp *cmpop);
+static BatchCmpOp batch_cmp_commute(BatchCmpOp cmpop);
+static int	batch_qual_inline(BatchQualClause *bqc, TupleBatch *batch,
+							  int nselected);
+static int	batch_qual_func(BatchQualClause *bqc, TupleBatch *batch,
+							int nselected);
+
+/*
+ * Create an empty batch for tuples of the given descriptor.
+ */
+TupleBatch *
+ExecBatchCreate(TupleDesc tupdesc, int maxrows)
+{
+	TupleBatch *batch = palloc0(sizeof(TupleBatch));
+	int			natts = Max(tupdesc->natts, 1);
+
+	Assert(maxrows > 0);
+
+	batch->maxrows = maxrows;
+	batch->attnums = palloc(sizeof(AttrNumber) * natts);
+	batch->values = palloc(sizeof(Datum *) * natts);
+	batch->isnull = palloc(sizeof(bool *) * natts);
+	batch->selection = palloc(sizeof(int) * maxrows);
+	batch->clauses = NULL;
+
+	return batch;
+}
+
+/*
+ * Make sure the batch stores the given attribute, and return its column
+ * number within the batch.  Returns -1 if the attribute can't be stored.
+ */
+int
+ExecBatchAddColumn(TupleBatch *batch, TupleDesc tupdesc, AttrNumber attnum)
+{
+	Form_pg_attribute attr;
+	int			col;
+
+	if (attnum <= 0 || attnum > tupdesc->natts)
+		return -1;
+	attr = TupleDescAttr(tupdesc, attnum - 1);
+	if (attr->attisdropped || !attr->attbyval)
+		return -1;
+
+	for (col = 0; col < batch->ncols; col++)
+	{
+		if (batch->attnums[col] == attnum)
+			return col;
+	}
+
+	col = batch->ncols++;
+	batch->attnums[col] = attnum;
+	batch->values[col] = palloc(sizeof(Datum) * batch->maxrows);
+	batch->isnull[col] = palloc(sizeof(bool) * batch->maxrows);
+	batch->maxattnum = Max(batch->maxattnum, attnum);
+
+	return col;
+}
+
+/*
+ * Set up the batch to evaluate a scan qual (an implicitly-ANDed list).
+ *
+ * Returns false if some clause can't be evaluated a batch at a time, in
+ * which case the caller must not use the batch.
+ */
+bool
+ExecBatchBuildQual(TupleBatch *batch, TupleDesc tupdesc, List *qual,
+				   Index scanrelid)
+{
+	ListCell   *lc;
+	int			i = 0;
+
+	batch->nclauses = 0;
+	if (qual == NIL)
+		return true;
+
+	batch->clauses = palloc0(sizeof(BatchQualClause) * list_length(qual));
+	foreach(lc, qual)
+	{
+		if (!batch_qual_clause(batch, tupdesc, (Expr *) lfirst(lc), scanrelid,
+							   &batch->clauses[i++]))
+			return false;
+	}
+	batch->nclauses = i;
+
+	return true;
+}
+
+/*
+ * Check that a qual clause has the form "Var op Const" or "Const op Var",
+ * and fill in *bqc for it if so.
+ */
+static bool
+batch_qual_clause(TupleBatch *batch, TupleDesc tupdesc, Expr *clause,
+				  Index scanrelid, BatchQualClause *bqc)
+{
+	OpExpr	   *opexpr;
+	Node	   *leftop;
+	Node	   *rightop;
+	Var		   *var;
+	Const	   *con;
+	FmgrInfo   *finfo;
+
+	if (!IsA(clause, OpExpr))
+		return false;
+	opexpr = (OpExpr *) clause;
+	if (opexpr->opretset || list_length(opexpr->args) != 2)
+		return false;
+
+	leftop = linitial(opexpr->args);
+	rightop = lsecond(opexpr->args);
+	if (IsA(leftop, Var) && IsA(rightop, Const))
+	{
+		var = (Var *) leftop;
+		con = (Const *) rightop;
+		bqc->vararg = 0;
+	}
+	else if (IsA(leftop, Const) && IsA(rightop, Var))
+	{
+		var = (Var *) rightop;
+		con = (Const *) leftop;
+		bqc->vararg = 1;
+	}
+	else
+		return false;
+
+	if (var->varno != scanrelid || var->varlevelsup != 0 ||
+		con->constisnull || !con->constbyval)
+		return false;
+
+	/*
+	 * Evaluating the clauses one after the other over the whole batch changes
+	 * the order of the function calls, which only matters to volatile
+	 * functions.  Non-strict functions might want to see the NULLs.
+	 */
+	set_opfuncid(opexpr);
+	if (!func_strict(opexpr->opfuncid) ||
+		func_volatile(opexpr->opfuncid) == PROVOLATILE_VOLATILE)
+		return false;
+
+	bqc->col = ExecBatchAddColumn(batch, tupdesc, var->varattno);
+	if (bqc->col < 0)
+		return false;
+
+	if (batch_cmp_for_func(opexpr->opfuncid, &bqc->cmptype, &bqc->cmpop))
+	{
+		bqc->constval = con->constvalue;
+		if (bqc->vararg == 1)
+			bqc->cmpop = batch_cmp_commute(bqc->cmpop);
+		bqc->fcinfo = NULL;
+		return true;
+	}
+
+	bqc->cmptype = BATCH_CMP_NONE;
+	finfo = palloc0(sizeof(FmgrInfo));
+	fmgr_info(opexpr->opfuncid, finfo);
+	fmgr_info_set_expr((Node *) opexpr, finfo);
+	bqc->fcinfo = palloc0(SizeForFunctionCallInfo(2));
+	InitFunctionCallInfoData(*bqc->fcinfo, finfo, 2, opexpr->inputcollid,
+							 NULL, NULL);
+	bqc->fcinfo->args[1 - bqc->vararg].value = con->constvalue;
+	bqc->fcinfo->args[1 - bqc->vararg].isnull = false;
+	bqc->fcinfo->args[bqc->vararg].isnull = false;
+
+	return true;
+}
+
+/*
+ * Is funcid a comparison function we know how to evaluate inline?
+ */
+static bool
+batch_cmp_for_func(Oid funcid, BatchCmpType *cmptype, BatchCmpOp *cmpop)
+{
+	switch (funcid)
+	{
+		case F_INT2LT:
+		case F_INT4LT:
+		case F_INT8LT:
+		case F_DATE_LT:
+		case F_TIMESTAMP_LT:
+			*cmpop = BATCH_CMP_LT;
+			break;
+		case F_INT2LE:
+		case F_INT4LE:
+		case F_INT8LE:
+		case F_DATE_LE:
+		case F_TIMESTAMP_LE:
+			*cmpop = BATCH_CMP_LE;
+			break;
+		case F_INT2EQ:
+		case F_INT4EQ:
+		case F_INT8EQ:
+		case F_DATE_EQ:
+		case F_TIMESTAMP_EQ:
+			*cmpop = BATCH_CMP_EQ;
+			break;
+		case F_INT2NE:
+		case F_INT4NE:
+		case F_INT8NE:
+		case F_DATE_NE:
+		case F_TIMESTAMP_NE:
+			*cmpop = BATCH_CMP_NE;
+			break;
+		case F_INT2GE:
+		case F_INT4GE:
+		case F_INT8GE:
+		case F_DATE_GE:
+		case F_TIMESTAMP_GE:
+			*cmpop = BATCH_CMP_GE;
+			break;
+		case F_INT2GT:
+		case F_INT4GT:
+		case F_INT8GT:
+		case F_DATE_GT:
+		case F_TIMESTAMP_GT:
+			*cmpop = BATCH_CMP_GT;
+			break;
+		default:
+			return false;
+	}
+
+	switch (funcid)
+	{
+		case F_INT2LT:
+		case F_INT2LE:
+		case F_INT2EQ:
+		case F_INT2NE:
+		case F_INT2GE:
+		case F_INT2GT:
+			*cmptype = BATCH_CMP_INT16;
+			break;
+		case F_INT4LT:
+		case F_INT4LE:
+		case F_INT4EQ:
+		case F_INT4NE:
+		case F_INT4GE:
+		case F_INT4GT:
+		case F_DATE_LT:
+		case F_DATE_LE:
+		case F_DATE_EQ:
+		case F_DATE_NE:
+		case F_DATE_GE:
+		case F_DATE_GT:
+			*cmptype = BATCH_CMP_INT32;
+			break;
+		default:
+			/* int8 and timestamp */
+			*cmptype = BATCH_CMP_INT64;
+			break;
+	}
+
+	return true;
+}
+
+/*
+ * Return the comparison that gives the same result with the arguments
+ * swapped.
+ */
+static BatchCmpOp
+batch_cmp_commute(BatchCmpOp cmpop)
+{
+	switch (cmpop)
+	{
+		case BATCH_CMP_LT:
+			return BATCH_CMP_GT;
+		case BATCH_CMP_LE:
+			return BATCH_CMP_GE;
+		case BATCH_CMP_GE:
+			return BATCH_CMP_LE;
+		case BATCH_CMP_GT:
+			return BATCH_CMP_LT;
+		default:
+			return cmpop;
+	}
+}
+
+/*
+ * Apply the batch's qual to the rows in the vectors, leaving the rows that
+ * pass in the selection vector.
+ */
+void
+ExecBatchQual(TupleBatch *batch)
+{
+	int			nselected = batch->nrows;
+
+	for (int i = 0; i < nselected; i++)
+		batch->selection[i] = i;
+
+	for (int i = 0; i < batch->nclauses && nselected > 0; i++)
+	{
+		BatchQualClause *bqc = &batch->clauses[i];
+
+		if (bqc->cmptype != BATCH_CMP_NONE)
+			nselected = batch_qual_inline(bqc, batch, nselected);
+		else
+			nselected = batch_qual_func(bqc, batch, nselected);
+	}
+
+	batch->nselected = nselected;
+}
+
+/*
+ * Filter the first nselected entries of the selection vector with an inline
+ * comparison, returning the number of entries left.
+ *
+ * The loops are spelled out for each type and operator so that the compiler
+ * can make a tight loop of each.
+ */
+#define BATCH_CMP_LOOP(type, getdatum, op) \
+	do { \
+		type		c = getdatum(bqc->constval); \
+		for (int i = 0; i < nselected; i++) \
+		{ \
+			int			row = selection[i]; \
+			selection[nout] = row; \
+			nout += (!isnull[row] && getdatum(values[row]) op c); \
+		} \
+	} while (0)
+
+#define BATCH_CMP_SWITCH(type, getdatum) \
+	do { \
+		switch (bqc->cmpop) \
+		{ \
+			case BATCH_CMP_LT: \
+				BATCH_CMP_LOOP(type, getdatum, <); \
+				break; \
+			case BATCH_CMP_LE: \
+				BATCH_CMP_LOOP(type, getdatum, <=); \
+				break; \
+			case BATCH_CMP_EQ: \
+				BATCH_CMP_LOOP(type, getdatum, ==); \
+				break; \
+			case BATCH_CMP_NE: \
+				BATCH_CMP_LOOP(type, getdatum, !=); \
+				break; \
+			case BATCH_CMP_GE: \
+				BATCH_CMP_LOOP(type, getdatum, >=); \
+				break; \
+			case BATCH_CMP_GT: \
+				BATCH_CMP_LOOP(type, getdatum, >); \
+				break; \
+		} \
+	} while (0)
+
+static int
+batch_qual_inline(BatchQualClause *bqc, TupleBatch *batch, int nselected)
+{
+	Datum	   *values = batch->values[bqc->col];
+	bool	   *isnull = batch->isnull[bqc->col];
+	int		   *selection = batch->selection;
+	int			nout = 0;
+
+	switch (bqc->cmptype)
+	{
+		case BATCH_CMP_INT16:
+			BATCH_CMP_SWITCH(int16, DatumGetInt16);
+			break;
+		case BATCH_CMP_INT32:
+			BATCH_CMP_SWITCH(int32, DatumGetInt32);
+			break;
+		case BATCH_CMP_INT64:
+			BATCH_CMP_SWITCH(int64, DatumGetInt64);
+			break;
+		case BATCH_CMP_NONE:
+			Assert(false);
+			break;
+	}
+
+	return nout;
+}
+
+/*
+ * Filter the first nselected entries of the selection vector by calling the
+ * operator's function, returning the number of entries left.
+ */
+static int
+batch_qual_func(BatchQualClause *bqc, TupleBatch *batch, int nselected)
+{
+	FunctionCallInfo fcinfo = bqc->fcinfo;
+	Datum	   *values = batch->values[bqc->col];
+	bool	   *isnull = batch->isnull[bqc->col];
+	int		   *selection = batch->selection;
+	int			nout = 0;
+
+	for (int i = 0; i < nselected; i++)
+	{
+		int			row = selection[i];
+		Datum		result;
+
+		/* the function is strict, so a NULL input fails the clause */
+		if (isnull[row])
+			continue;
+
+		fcinfo->args[bqc->vararg].value = values[row];
+		fcinfo->isnull = false;
+		result = FunctionCallInvoke(fcinfo);
+		if (!fcinfo->isnull && DatumGetBool(result))
+			selection[nout++] = row;
+	}
+
+	return nout;
+}
@@ -64,6 +64,7 @@
 #include "catalog/pg_type.h"
 #include "funcapi.h"
 #include "nodes/nodeFuncs.h"
+#include "port/pg_lfind.h"
 #include "storage/bufmgr.h"
 #include "utils/builtins.h"
 #include "utils/expandeddatum.h"
@@ -1042,11 +1043,41 @@ slot_deform_heap_tuple(TupleTableSlot *slot, HeapTuple tuple, uint32 *offp,
 
 	tp = (char *) tup + tup->t_hoff;
 
+	/* Expand the null bitmap for the attributes we're going to extract */
+	if (hasnulls)
+		populate_isnull_array(bp, attnum, natts, isnull);
+
+	/*
+	 * When starting from the first attribute, the leading fixed-width
+	 * attributes are at known offsets, unless one of them is null.  Fetch
+	 * them in a tight loop that doesn't need to track the offset.
+	 */
+	if (attnum == 0)
+	{
+		int			nfixed = Min(natts, TupleDescFixedPrefix(tupleDesc));
+
+		if (nfixed > 0 &&
+			(!hasnulls || !pg_lfind8(true, (uint8 *) isnull, nfixed)))
+		{
+			Form_pg_attribute thisatt = NULL;
+
+			for (; attnum < nfixed; attnum++)
+			{
+				thisatt = TupleDescAttr(tupleDesc, attnum);
+
+				Assert(thisatt->attlen > 0 && thisatt->attcacheoff >= 0);
+				values[attnum] = fetchatt(thisatt, tp + thisatt->attcacheoff);
+				isnull[attnum] = false;
+			}
+			off = thisatt->attcacheoff + thisatt->attlen;
+		}
+	}
+
 	for (; attnum < natts; attnum++)
 	{
 		Form_pg_attribute thisatt = TupleDescAttr(tupleDesc, attnum);
 
-		if (hasnulls && att_isnull(attnum, bp))
+		if (hasnulls && isnull[attnum])
 		{
 			values[attnum] = (Datum) 0;
 			isnull[attnum] = true;
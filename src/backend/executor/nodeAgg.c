@@ -226,6 +226,19 @@
  *	  imposing a limit on the number of groups separately from the amount of
  *	  memory consumed.
  *
+ *	  Parallel Hash Aggregation
+ *
+ *	  A parallel-aware AGG_HASHED node finalizes groups below a Gather, so
+ *	  that the final aggregation is spread across all participants instead of
+ *	  being done by the leader alone.  Each participant first routes the
+ *	  (partially aggregated) tuples of its own share of the input into shared
+ *	  partitions, which are SharedTuplestores, by the high bits of their hash
+ *	  value.  After all participants have done so, they claim partitions one at
+ *	  a time and aggregate each claimed partition like a batch of spilled
+ *	  tuples, spilling it in turn if it doesn't fit in hash_mem.  Since each
+ *	  group falls into exactly one partition, the participants emit disjoint
+ *	  sets of groups.
+ *
  *    Transition / Combine function invocation:
  *
  *    For performance reasons transition functions, including combine
@@ -255,25 +268,33 @@
 #include "catalog/pg_proc.h"
 #include "catalog/pg_type.h"
 #include "common/hashfn.h"
+#include "common/int.h"
 #include "executor/execExpr.h"
 #include "executor/executor.h"
 #include "executor/nodeAgg.h"
+#include "executor/nodeSeqscan.h"
 #include "lib/hyperloglog.h"
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/optimizer.h"
 #include "parser/parse_agg.h"
 #include "parser/parse_coerce.h"
+#include "port/pg_bitutils.h"
+#include "storage/barrier.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
 #include "utils/dynahash.h"
 #include "utils/expandeddatum.h"
+#include "utils/fmgroids.h"
 #include "utils/logtape.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/sharedtuplestore.h"
 #include "utils/syscache.h"
 #include "utils/tuplesort.h"
+#include "utils/wait_event.h"
 
 /*
  * Control how many partitions are created when spilling HashAgg to
@@ -319,6 +340,46 @@
  */
 #define CHUNKHDRSZ 16
 
+/*
+ * Number of shared partitions per participant of a parallel-aware hashed Agg.
+ * Using several lets the participants balance their work when the groups are
+ * unevenly spread over the partitions.
+ */
+#define HASHAGG_SHARED_PARTITIONS_PER_PARTICIPANT 4
+
+/*
+ * Phases of a parallel-aware hashed Agg, tracked by its barrier.
+ */
+#define PHA_PHASE_PARTITION			0
+#define PHA_PHASE_AGGREGATE			1
+
+/*
+ * Shared state of a parallel-aware hashed Agg.  It is followed in memory by
+ * the SharedTuplestore of each partition.
+ */
+typedef struct ParallelHashAggState
+{
+	Barrier		barrier;		/* synchronizes PHA_PHASE_xxx */
+	int			nparticipants;	/* leader and planned workers */
+	int			npartitions;	/* number of partitions, a power of two */
+	int			partition_bits; /* log2(npartitions) */
+	pg_atomic_uint32 next_partition;	/* next partition to aggregate */
+	SharedFileSet fileset;		/* space for the partitions' files */
+} ParallelHashAggState;
+
+#define ParallelHashAggPartition(pstate, i) \
+	((SharedTuplestore *) ((char *) (pstate) + \
+						   MAXALIGN(sizeof(ParallelHashAggState)) + \
+						   (i) * MAXALIGN(sts_estimate((pstate)->nparticipants))))
+
+/*
+ * The plan node ID keys a node's instrumentation in the DSM table of
+ * contents, so the shared state of a parallel-aware hashed Agg gets a key of
+ * its own.
+ */
+#define PARALLEL_KEY_AGG_HASH(plan_node_id) \
+	(UINT64CONST(0xE100000000000000) | (uint64) (plan_node_id))
+
 /*
  * Represents partitioned spill data for a single hashtable. Contains the
  * necessary information to route tuples to the correct partition, and to
@@ -352,6 +413,7 @@ typedef struct HashAggBatch
 	int			setno;			/* grouping set */
 	int			used_bits;		/* number of bits of hash already used */
 	LogicalTape *input_tape;	/* input partition tape */
+	SharedTuplestoreAccessor *input_sts;	/* or shared input partition */
 	int64		input_tuples;	/* number of tuples in this batch */
 	double		input_card;		/* estimated group cardinality */
 } HashAggBatch;
@@ -374,6 +436,12 @@ static void advance_transition_function(AggState *aggstate,
 										AggStatePerTrans pertrans,
 										AggStatePerGroup pergroupstate);
 static void advance_aggregates(AggState *aggstate);
+static void advance_transition_batch(AggState *aggstate,
+									 AggStatePerTrans pertrans,
+									 AggStatePerGroup pergroupstate,
+									 TupleBatch *batch);
+static void advance_aggregates_batched(AggState *aggstate,
+									   AggStatePerGroup pergroup);
 static void process_ordered_aggregate_single(AggState *aggstate,
 											 AggStatePerTrans pertrans,
 											 AggStatePerGroup pergroupstate);
@@ -417,6 +485,8 @@ static void initialize_hash_entry(AggState *aggstate,
 static void lookup_hash_entries(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static void agg_fill_hash_table(AggState *aggstate);
+static void agg_fill_hash_table_shared(AggState *aggstate);
+static bool agg_claim_shared_partition(AggState *aggstate);
 static bool agg_refill_hash_table(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table_in_memory(AggState *aggstate);
@@ -438,6 +508,8 @@ static Size hashagg_spill_tuple(AggState *aggstate, HashAggSpill *spill,
 static void hashagg_spill_finish(AggState *aggstate, HashAggSpill *spill,
 								 int setno);
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
+static void agg_batch_setup(AggState *aggstate);
+static AggBatchTrans agg_batch_trans_for(AggStatePerTrans pertrans);
 static void build_pertrans_for_aggref(AggStatePerTrans pertrans,
 									  AggState *aggstate, EState *estate,
 									  Aggref *aggref, Oid transfn_oid,
@@ -822,6 +894,186 @@ advance_aggregates(AggState *aggstate)
 							  &dummynull);
 }
 
+/*
+ * Advance one aggregate transition state over the selected rows of a batch.
+ *
+ * This must give the same result as calling advance_transition_function()
+ * for each row, which is what we do unless the transition function is one
+ * of the few simple ones that are open-coded here.
+ */
+static void
+advance_transition_batch(AggState *aggstate,
+						 AggStatePerTrans pertrans,
+						 AggStatePerGroup pergroupstate,
+						 TupleBatch *batch)
+{
+	Datum	   *values = NULL;
+	bool	   *isnull = NULL;
+	int		   *selection = batch->selection;
+	int			nselected = batch->nselected;
+	int64		count;
+
+	if (pertrans->batchcol >= 0)
+	{
+		values = batch->values[pertrans->batchcol];
+		isnull = batch->isnull[pertrans->batchcol];
+	}
+
+/* sum a column of the given type into an int64 transition value */
+#define AGG_BATCH_SUM(getdatum) \
+	do { \
+		int64		sum = 0; \
+		count = 0; \
+		for (int i = 0; i < nselected; i++) \
+		{ \
+			int			row = selection[i]; \
+			if (!isnull[row]) \
+			{ \
+				sum += getdatum(values[row]); \
+				count++; \
+			} \
+		} \
+		if (count == 0) \
+			break; \
+		if (pergroupstate->transValueIsNull) \
+			pergroupstate->transValue = Int64GetDatum(sum); \
+		else \
+			pergroupstate->transValue = \
+				Int64GetDatum(DatumGetInt64(pergroupstate->transValue) + sum); \
+		pergroupstate->transValueIsNull = false; \
+	} while (0)
+
+/* keep the smallest or largest value of a column in the transition value */
+#define AGG_BATCH_MINMAX(type, getdatum, makedatum, op) \
+	do { \
+		type		result = 0; \
+		bool		found = false; \
+		if (!pergroupstate->noTransValue) \
+		{ \
+			/* a strict transfn never returns NULL for non-NULL input */ \
+			Assert(!pergroupstate->transValueIsNull); \
+			result = getdatum(pergroupstate->transValue); \
+			found = true; \
+		} \
+		for (int i = 0; i < nselected; i++) \
+		{ \
+			int			row = selection[i]; \
+			type		val; \
+			if (isnull[row]) \
+				continue; \
+			val = getdatum(values[row]); \
+			if (!found || val op result) \
+				result = val; \
+			found = true; \
+		} \
+		if (found) \
+		{ \
+			pergroupstate->transValue = makedatum(result); \
+			pergroupstate->transValueIsNull = false; \
+			pergroupstate->noTransValue = false; \
+		} \
+	} while (0)
+
+	switch (pertrans->batchtrans)
+	{
+		case AGG_BATCH_COUNT_STAR:
+		case AGG_BATCH_COUNT:
+			if (pertrans->batchtrans == AGG_BATCH_COUNT_STAR)
+				count = nselected;
+			else
+			{
+				count = 0;
+				for (int i = 0; i < nselected; i++)
+					count += !isnull[selection[i]];
+			}
+			Assert(!pergroupstate->transValueIsNull);
+			if (unlikely(pg_add_s64_overflow(DatumGetInt64(pergroupstate->transValue),
+											 count, &count)))
+				ereport(ERROR,
+						(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+						 errmsg("bigint out of range")));
+			pergroupstate->transValue = Int64GetDatum(count);
+			break;
+
+		case AGG_BATCH_SUM_INT16:
+			AGG_BATCH_SUM(DatumGetInt16);
+			break;
+		case AGG_BATCH_SUM_INT32:
+			AGG_BATCH_SUM(DatumGetInt32);
+			break;
+
+		case AGG_BATCH_MIN_INT16:
+			AGG_BATCH_MINMAX(int16, DatumGetInt16, Int16GetDatum, <);
+			break;
+		case AGG_BATCH_MAX_INT16:
+			AGG_BATCH_MINMAX(int16, DatumGetInt16, Int16GetDatum, >);
+			break;
+		case AGG_BATCH_MIN_INT32:
+			AGG_BATCH_MINMAX(int32, DatumGetInt32, Int32GetDatum, <);
+			break;
+		case AGG_BATCH_MAX_INT32:
+			AGG_BATCH_MINMAX(int32, DatumGetInt32, Int32GetDatum, >);
+			break;
+		case AGG_BATCH_MIN_INT64:
+			AGG_BATCH_MINMAX(int64, DatumGetInt64, Int64GetDatum, <);
+			break;
+		case AGG_BATCH_MAX_INT64:
+			AGG_BATCH_MINMAX(int64, DatumGetInt64, Int64GetDatum, >);
+			break;
+
+		case AGG_BATCH_CALL:
+			{
+				FunctionCallInfo fcinfo = pertrans->transfn_fcinfo;
+
+				for (int i = 0; i < nselected; i++)
+				{
+					if (values != NULL)
+					{
+						int			row = selection[i];
+
+						fcinfo->args[1].value = values[row];
+						fcinfo->args[1].isnull = isnull[row];
+					}
+					advance_transition_function(aggstate, pertrans,
+												pergroupstate);
+				}
+			}
+			break;
+	}
+
+#undef AGG_BATCH_SUM
+#undef AGG_BATCH_MINMAX
+}
+
+/*
+ * Read all the input from the outer SeqScan in batches, advancing the
+ * transition states of the single group of a plain aggregation.
+ *
+ * When called, CurrentMemoryContext should be the per-query context.
+ */
+static void
+advance_aggregates_batched(AggState *aggstate, AggStatePerGroup pergroup)
+{
+	SeqScanState *scanstate = (SeqScanState *) outerPlanState(aggstate);
+	TupleBatch *batch = aggstate->batch;
+	int			numTrans = aggstate->numtrans;
+
+	select_current_set(aggstate, 0, false);
+
+	/* the scan has been (re)started */
+	batch->done = false;
+
+	while (ExecSeqScanNextBatch(scanstate, batch) > 0)
+	{
+		for (int transno = 0; transno < numTrans; transno++)
+			advance_transition_batch(aggstate, &aggstate->pertrans[transno],
+									 &pergroup[transno], batch);
+
+		/* Reset per-input-tuple context after each batch */
+		ResetExprContext(aggstate->tmpcontext);
+	}
+}
+
 /*
  * Run the transition function for a DISTINCT or ORDER BY aggregate
  * with only one input.  This is called after we have completed
@@ -1893,6 +2145,13 @@ hash_agg_enter_spill_mode(AggState *aggstate)
 
 		aggstate->hash_tapeset = LogicalTapeSetCreate(true, NULL, -1);
 
+		/*
+		 * A parallel-aware node first spills while aggregating a shared
+		 * partition, and agg_refill_hash_table() sets up that spill itself.
+		 */
+		if (aggstate->table_filled)
+			return;
+
 		aggstate->hash_spills = palloc(sizeof(HashAggSpill) * aggstate->num_hashes);
 
 		for (int setno = 0; setno < aggstate->num_hashes; setno++)
@@ -2169,7 +2428,12 @@ ExecAgg(PlanState *pstate)
 		{
 			case AGG_HASHED:
 				if (!node->table_filled)
-					agg_fill_hash_table(node);
+				{
+					if (node->hash_pstate != NULL)
+						agg_fill_hash_table_shared(node);
+					else
+						agg_fill_hash_table(node);
+				}
 				/* FALLTHROUGH */
 			case AGG_MIXED:
 				result = agg_retrieve_hash_table(node);
@@ -2357,9 +2621,13 @@ agg_retrieve_direct(AggState *aggstate)
 
 			/*
 			 * If we don't already have the first tuple of the new group,
-			 * fetch it from the outer plan.
+			 * fetch it from the outer plan.  When reading the input in
+			 * batches, we don't need it: there's only one group, and no
+			 * ungrouped columns to project.
 			 */
-			if (aggstate->grp_firstTuple == NULL)
+			if (aggstate->batch != NULL)
+				aggstate->agg_done = true;
+			else if (aggstate->grp_firstTuple == NULL)
 			{
 				outerslot = fetch_input_tuple(aggstate);
 				if (!TupIsNull(outerslot))
@@ -2420,7 +2688,9 @@ agg_retrieve_direct(AggState *aggstate)
 			 */
 			initialize_aggregates(aggstate, pergroups, numReset);
 
-			if (aggstate->grp_firstTuple != NULL)
+			if (aggstate->batch != NULL)
+				advance_aggregates_batched(aggstate, pergroups[0]);
+			else if (aggstate->grp_firstTuple != NULL)
 			{
 				/*
 				 * Store the copied first input tuple in the tuple table slot
@@ -2578,12 +2848,121 @@ agg_fill_hash_table(AggState *aggstate)
 						   &aggstate->perhash[0].hashiter);
 }
 
+/*
+ * ExecAgg for parallel-aware hashed case: partition input
+ *
+ * Route the tuples of this participant's input into the shared partitions,
+ * and wait for the other participants to do the same.  The hash table stays
+ * empty; agg_refill_hash_table() then aggregates the partitions that this
+ * participant claims.
+ */
+static void
+agg_fill_hash_table_shared(AggState *aggstate)
+{
+	ParallelHashAggState *pstate = aggstate->hash_pstate;
+	AggStatePerHash perhash = &aggstate->perhash[0];
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	int			shift = 32 - pstate->partition_bits;
+
+	Assert(aggstate->num_hashes == 1);
+
+	/*
+	 * If the partitions are already being aggregated, we arrived too late to
+	 * contribute.  Then the other participants have exhausted the parallel
+	 * input plan, and ours would return nothing.
+	 */
+	if (BarrierAttach(&pstate->barrier) == PHA_PHASE_PARTITION)
+	{
+		for (;;)
+		{
+			TupleTableSlot *outerslot;
+			MinimalTuple tuple;
+			bool		shouldFree;
+			uint32		hash;
+
+			outerslot = fetch_input_tuple(aggstate);
+			if (TupIsNull(outerslot))
+				break;
+
+			/*
+			 * The hash value doesn't depend on the participant, as the hash
+			 * tables of a finalizing Agg use no per-worker initial value.
+			 */
+			prepare_hash_slot(perhash, outerslot, perhash->hashslot);
+			hash = TupleHashTableHash(perhash->hashtable, perhash->hashslot);
+
+			tuple = ExecFetchSlotMinimalTuple(outerslot, &shouldFree);
+			sts_puttuple(aggstate->hash_sts[hash >> shift], &hash, tuple);
+			if (shouldFree)
+				heap_free_minimal_tuple(tuple);
+
+			ResetExprContext(tmpcontext);
+		}
+
+		for (int i = 0; i < pstate->npartitions; i++)
+			sts_end_write(aggstate->hash_sts[i]);
+
+		BarrierArriveAndWait(&pstate->barrier,
+							 WAIT_EVENT_HASH_AGG_PARTITION);
+	}
+	Assert(BarrierPhase(&pstate->barrier) == PHA_PHASE_AGGREGATE);
+
+	aggstate->table_filled = true;
+	/* Initialize to walk the (empty) hash table */
+	select_current_set(aggstate, 0, true);
+	ResetTupleHashIterator(perhash->hashtable, &perhash->hashiter);
+}
+
+/*
+ * Claim the next shared partition that no participant has aggregated yet, and
+ * push it as a batch for agg_refill_hash_table().
+ *
+ * Return false if there are no partitions left, or if this isn't a
+ * parallel-aware node.
+ */
+static bool
+agg_claim_shared_partition(AggState *aggstate)
+{
+	ParallelHashAggState *pstate = aggstate->hash_pstate;
+	HashAggBatch *batch;
+	uint32		partno;
+	double		input_card;
+
+	if (pstate == NULL || aggstate->hash_shared_done)
+		return false;
+
+	partno = pg_atomic_fetch_add_u32(&pstate->next_partition, 1);
+	if (partno >= pstate->npartitions)
+	{
+		/* Nobody waits on the barrier anymore; just leave it. */
+		BarrierDetach(&pstate->barrier);
+		aggstate->hash_shared_done = true;
+		return false;
+	}
+
+	/* The plan estimates the number of groups per participant */
+	input_card = aggstate->perhash[0].aggnode->numGroups *
+		pstate->nparticipants / pstate->npartitions;
+
+	batch = hashagg_batch_new(NULL, 0, 0, Max(input_card, 1),
+							  pstate->partition_bits);
+	batch->input_sts = aggstate->hash_sts[partno];
+	sts_begin_parallel_scan(batch->input_sts);
+
+	aggstate->hash_batches = lappend(aggstate->hash_batches, batch);
+
+	return true;
+}
+
 /*
  * If any data was spilled during hash aggregation, reset the hash table and
  * reprocess one batch of spilled data. After reprocessing a batch, the hash
  * table will again contain data, ready to be consumed by
  * agg_retrieve_hash_table_in_memory().
  *
+ * A parallel-aware node also reprocesses the shared partitions it claims as
+ * batches, once it runs out of batches of its own.
+ *
  * Should only be called after all in memory hash table entries have been
  * finalized and emitted.
  *
@@ -2596,10 +2975,10 @@ agg_refill_hash_table(AggState *aggstate)
 	HashAggBatch *batch;
 	AggStatePerHash perhash;
 	HashAggSpill spill;
-	LogicalTapeSet *tapeset = aggstate->hash_tapeset;
 	bool		spill_initialized = false;
 
-	if (aggstate->hash_batches == NIL)
+	if (aggstate->hash_batches == NIL &&
+		!agg_claim_shared_partition(aggstate))
 		return false;
 
 	/* hash_batches is a stack, with the top item at the end of the list */
@@ -2693,8 +3072,9 @@ agg_refill_hash_table(AggState *aggstate)
 				 * that we don't assign tapes that will never be used.
 				 */
 				spill_initialized = true;
-				hashagg_spill_init(&spill, tapeset, batch->used_bits,
-								   batch->input_card, aggstate->hashentrysize);
+				hashagg_spill_init(&spill, aggstate->hash_tapeset,
+								   batch->used_bits, batch->input_card,
+								   aggstate->hashentrysize);
 			}
 			/* no memory for a new group, spill */
 			hashagg_spill_tuple(aggstate, &spill, spillslot, hash);
@@ -2709,7 +3089,10 @@ agg_refill_hash_table(AggState *aggstate)
 		ResetExprContext(aggstate->tmpcontext);
 	}
 
-	LogicalTapeClose(batch->input_tape);
+	if (batch->input_sts != NULL)
+		sts_end_parallel_scan(batch->input_sts);
+	else
+		LogicalTapeClose(batch->input_tape);
 
 	/* change back to phase 0 */
 	aggstate->current_phase = 0;
@@ -3004,7 +3387,8 @@ hashagg_batch_new(LogicalTape *input_tape, int setno,
 
 /*
  * hashagg_batch_read
- * 		read the next tuple from a batch's tape.  Return NULL if no more.
+ * 		read the next tuple from a batch's tape or shared partition.  Return
+ * 		NULL if no more.
  */
 static MinimalTuple
 hashagg_batch_read(HashAggBatch *batch, uint32 *hashp)
@@ -3015,6 +3399,17 @@ hashagg_batch_read(HashAggBatch *batch, uint32 *hashp)
 	size_t		nread;
 	uint32		hash;
 
+	if (batch->input_sts != NULL)
+	{
+		tuple = sts_parallel_scan_next(batch->input_sts, &hash);
+		if (tuple == NULL)
+			return NULL;
+		if (hashp != NULL)
+			*hashp = hash;
+		/* the caller frees the tuple */
+		return heap_copy_minimal_tuple(tuple);
+	}
+
 	nread = LogicalTapeRead(tape, &hash, sizeof(uint32));
 	if (nread == 0)
 		return NULL;
@@ -4021,6 +4416,9 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		phase->evaltrans_cache[0][0] = phase->evaltrans;
 	}
 
+	/* Read the input in batches, if possible */
+	agg_batch_setup(aggstate);
+
 	return aggstate;
 }
 
@@ -4300,6 +4698,123 @@ GetAggInitVal(Datum textInitVal, Oid transtype)
 	return initVal;
 }
 
+/*
+ * Decide whether the input can be read from the outer SeqScan in batches,
+ * and if so set up aggstate->batch.
+ *
+ * That's only done for plain aggregation without grouping sets, where all
+ * the input goes into one group, and only if every aggregate takes at most
+ * one argument that is a pass-by-value column of the scanned table, with no
+ * FILTER, DISTINCT or ORDER BY.
+ */
+static void
+agg_batch_setup(AggState *aggstate)
+{
+	Agg		   *node = (Agg *) aggstate->ss.ps.plan;
+	PlanState  *outerstate = outerPlanState(aggstate);
+	SeqScanState *scanstate;
+	List	   *scantlist;
+	TupleDesc	tupdesc;
+	TupleBatch *batch;
+	ListCell   *lc;
+
+	if (node->aggstrategy != AGG_PLAIN || node->groupingSets != NIL ||
+		DO_AGGSPLIT_COMBINE(aggstate->aggsplit) ||
+		!IsA(outerstate, SeqScanState))
+		return;
+	scanstate = (SeqScanState *) outerstate;
+
+	/* the scan's projection is bypassed, so it must not compute anything */
+	scantlist = outerstate->plan->targetlist;
+	foreach(lc, scantlist)
+	{
+		TargetEntry *tle = lfirst_node(TargetEntry, lc);
+
+		if (!IsA(tle->expr, Var))
+			return;
+	}
+
+	batch = ExecSeqScanBeginBatch(scanstate);
+	if (batch == NULL)
+		return;
+	tupdesc = RelationGetDescr(scanstate->ss.ss_currentRelation);
+
+	for (int transno = 0; transno < aggstate->numtrans; transno++)
+	{
+		AggStatePerTrans pertrans = &aggstate->pertrans[transno];
+		Aggref	   *aggref = pertrans->aggref;
+
+		if (aggref->aggfilter != NULL || aggref->aggdistinct != NIL ||
+			aggref->aggorder != NIL || aggref->aggkind != AGGKIND_NORMAL ||
+			pertrans->numTransInputs > 1)
+			return;
+
+		pertrans->batchcol = -1;
+		if (pertrans->numTransInputs == 1)
+		{
+			TargetEntry *tle = linitial_node(TargetEntry, aggref->args);
+			Var		   *var = (Var *) tle->expr;
+			Var		   *scanvar;
+
+			if (!IsA(var, Var) || var->varno != OUTER_VAR ||
+				var->varattno <= 0 || var->varattno > list_length(scantlist))
+				return;
+			scanvar = (Var *) list_nth_node(TargetEntry, scantlist,
+											var->varattno - 1)->expr;
+
+			pertrans->batchcol = ExecBatchAddColumn(batch, tupdesc,
+													scanvar->varattno);
+			if (pertrans->batchcol < 0)
+				return;
+		}
+
+		pertrans->batchtrans = agg_batch_trans_for(pertrans);
+	}
+
+	aggstate->batch = batch;
+}
+
+/*
+ * Choose how to advance a transition state over a batch.
+ */
+static AggBatchTrans
+agg_batch_trans_for(AggStatePerTrans pertrans)
+{
+	/* the open-coded transitions keep the state as a by-value Datum */
+	if (!pertrans->transtypeByVal)
+		return AGG_BATCH_CALL;
+
+	switch (pertrans->transfn_oid)
+	{
+		case F_INT8INC:
+			if (pertrans->numTransInputs == 0 && !pertrans->initValueIsNull)
+				return AGG_BATCH_COUNT_STAR;
+			break;
+		case F_INT8INC_ANY:
+			if (pertrans->numTransInputs == 1 && !pertrans->initValueIsNull)
+				return AGG_BATCH_COUNT;
+			break;
+		case F_INT2_SUM:
+			return AGG_BATCH_SUM_INT16;
+		case F_INT4_SUM:
+			return AGG_BATCH_SUM_INT32;
+		case F_INT2SMALLER:
+			return AGG_BATCH_MIN_INT16;
+		case F_INT2LARGER:
+			return AGG_BATCH_MAX_INT16;
+		case F_INT4SMALLER:
+			return AGG_BATCH_MIN_INT32;
+		case F_INT4LARGER:
+			return AGG_BATCH_MAX_INT32;
+		case F_INT8SMALLER:
+			return AGG_BATCH_MIN_INT64;
+		case F_INT8LARGER:
+			return AGG_BATCH_MAX_INT64;
+	}
+
+	return AGG_BATCH_CALL;
+}
+
 void
 ExecEndAgg(AggState *node)
 {
@@ -4384,13 +4899,15 @@ ExecReScanAgg(AggState *node)
 			return;
 
 		/*
-		 * If we do have the hash table, and it never spilled, and the subplan
-		 * does not have any parameter changes, and none of our own parameter
-		 * changes affect input expressions of the aggregated functions, then
-		 * we can just rescan the existing hash table; no need to build it
-		 * again.
+		 * If we do have the hash table, and it never spilled, and it holds
+		 * all groups rather than those of one shared partition, and the
+		 * subplan does not have any parameter changes, and none of our own
+		 * parameter changes affect input expressions of the aggregated
+		 * functions, then we can just rescan the existing hash table; no need
+		 * to build it again.
 		 */
 		if (outerPlan->chgParam == NULL && !node->hash_ever_spilled &&
+			node->hash_pstate == NULL &&
 			!bms_overlap(node->ss.ps.chgParam, aggnode->aggParams))
 		{
 			ResetTupleHashIterator(node->perhash[0].hashtable,
@@ -4452,6 +4969,7 @@ ExecReScanAgg(AggState *node)
 		node->hash_ever_spilled = false;
 		node->hash_spill_mode = false;
 		node->hash_ngroups_current = 0;
+		node->hash_shared_done = false;
 
 		ReScanExprContext(node->hashcontext);
 		/* Rebuild an empty hash table */
@@ -4673,10 +5191,34 @@ AggRegisterCallback(FunctionCallInfo fcinfo,
  * ----------------------------------------------------------------
  */
 
+/*
+ * Size of the shared state of a parallel-aware hashed Agg, including the
+ * SharedTuplestores of its partitions.
+ */
+static Size
+hashagg_shared_size(int nparticipants, int npartitions)
+{
+	return add_size(MAXALIGN(sizeof(ParallelHashAggState)),
+					mul_size(npartitions,
+							 MAXALIGN(sts_estimate(nparticipants))));
+}
+
+static int
+hashagg_shared_npartitions(int nparticipants)
+{
+	int			npartitions;
+
+	npartitions = nparticipants * HASHAGG_SHARED_PARTITIONS_PER_PARTICIPANT;
+	npartitions = Min(npartitions, HASHAGG_MAX_PARTITIONS);
+
+	return pg_nextpower2_32(npartitions);
+}
+
  /* ----------------------------------------------------------------
   *		ExecAggEstimate
   *
-  *		Estimate space required to propagate aggregate statistics.
+  *		Estimate space required for the shared partitions of a
+  *		parallel-aware hashed Agg, and to propagate aggregate statistics.
   * ----------------------------------------------------------------
   */
 void
@@ -4684,6 +5226,16 @@ ExecAggEstimate(AggState *node, ParallelContext *pcxt)
 {
 	Size		size;
 
+	if (node->ss.ps.plan->parallel_aware)
+	{
+		int			nparticipants = pcxt->nworkers + 1;
+
+		size = hashagg_shared_size(nparticipants,
+								   hashagg_shared_npartitions(nparticipants));
+		shm_toc_estimate_chunk(&pcxt->estimator, size);
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+
 	/* don't need this if not instrumenting or no workers */
 	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
 		return;
@@ -4694,10 +5246,36 @@ ExecAggEstimate(AggState *node, ParallelContext *pcxt)
 	shm_toc_estimate_keys(&pcxt->estimator, 1);
 }
 
+/*
+ * Set up the SharedTuplestores of the partitions, and the leader's accessors
+ * for them.  The leader is participant 0.
+ */
+static void
+hashagg_shared_init_partitions(AggState *node)
+{
+	ParallelHashAggState *pstate = node->hash_pstate;
+
+	for (int i = 0; i < pstate->npartitions; i++)
+	{
+		char		name[NAMEDATALEN];
+
+		snprintf(name, sizeof(name), "hashagg.%d", i);
+		node->hash_sts[i] =
+			sts_initialize(ParallelHashAggPartition(pstate, i),
+						   pstate->nparticipants,
+						   0,
+						   sizeof(uint32),
+						   SHARED_TUPLESTORE_SINGLE_PASS,
+						   &pstate->fileset,
+						   name);
+	}
+}
+
 /* ----------------------------------------------------------------
  *		ExecAggInitializeDSM
  *
- *		Initialize DSM space for aggregate statistics.
+ *		Initialize DSM space for the shared partitions of a parallel-aware
+ *		hashed Agg, and for aggregate statistics.
  * ----------------------------------------------------------------
  */
 void
@@ -4705,6 +5283,38 @@ ExecAggInitializeDSM(AggState *node, ParallelContext *pcxt)
 {
 	Size		size;
 
+	/*
+	 * Without a real DSM segment there are no workers, and the node just
+	 * aggregates the whole input itself.
+	 */
+	if (node->ss.ps.plan->parallel_aware && pcxt->seg != NULL)
+	{
+		ParallelHashAggState *pstate;
+		int			nparticipants = pcxt->nworkers + 1;
+		int			npartitions = hashagg_shared_npartitions(nparticipants);
+
+		Assert(node->aggstrategy == AGG_HASHED && node->num_hashes == 1);
+
+		pstate = shm_toc_allocate(pcxt->toc,
+								  hashagg_shared_size(nparticipants,
+													  npartitions));
+		shm_toc_insert(pcxt->toc,
+					   PARALLEL_KEY_AGG_HASH(node->ss.ps.plan->plan_node_id),
+					   pstate);
+
+		BarrierInit(&pstate->barrier, PHA_PHASE_PARTITION);
+		pstate->nparticipants = nparticipants;
+		pstate->npartitions = npartitions;
+		pstate->partition_bits = pg_leftmost_one_pos32(npartitions);
+		pg_atomic_init_u32(&pstate->next_partition, 0);
+		SharedFileSetInit(&pstate->fileset, pcxt->seg);
+
+		node->hash_pstate = pstate;
+		node->hash_sts = palloc(sizeof(SharedTuplestoreAccessor *) *
+								npartitions);
+		hashagg_shared_init_partitions(node);
+	}
+
 	/* don't need this if not instrumenting or no workers */
 	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
 		return;
@@ -4719,15 +5329,57 @@ ExecAggInitializeDSM(AggState *node, ParallelContext *pcxt)
 				   node->shared_info);
 }
 
+/* ----------------------------------------------------------------
+ *		ExecAggReInitializeDSM
+ *
+ *		Reset the shared partitions before beginning a fresh scan.
+ * ----------------------------------------------------------------
+ */
+void
+ExecAggReInitializeDSM(AggState *node, ParallelContext *pcxt)
+{
+	ParallelHashAggState *pstate = node->hash_pstate;
+
+	/* Nothing to do if we failed to create a DSM segment. */
+	if (pstate == NULL)
+		return;
+
+	/* Clear any partition files, and start over with empty partitions. */
+	SharedFileSetDeleteAll(&pstate->fileset);
+	BarrierInit(&pstate->barrier, PHA_PHASE_PARTITION);
+	pg_atomic_write_u32(&pstate->next_partition, 0);
+	hashagg_shared_init_partitions(node);
+}
+
 /* ----------------------------------------------------------------
  *		ExecAggInitializeWorker
  *
- *		Attach worker to DSM space for aggregate statistics.
+ *		Attach worker to DSM space for the shared partitions and for
+ *		aggregate statistics.
  * ----------------------------------------------------------------
  */
 void
 ExecAggInitializeWorker(AggState *node, ParallelWorkerContext *pwcxt)
 {
+	if (node->ss.ps.plan->parallel_aware)
+	{
+		ParallelHashAggState *pstate;
+
+		pstate = shm_toc_lookup(pwcxt->toc,
+								PARALLEL_KEY_AGG_HASH(node->ss.ps.plan->plan_node_id),
+								false);
+		SharedFileSetAttach(&pstate->fileset, pwcxt->seg);
+
+		node->hash_pstate = pstate;
+		node->hash_sts = palloc(sizeof(SharedTuplestoreAccessor *) *
+								pstate->npartitions);
+		for (int i = 0; i < pstate->npartitions; i++)
+			node->hash_sts[i] =
+				sts_attach(ParallelHashAggPartition(pstate, i),
+						   ParallelWorkerNumber + 1,
+						   &pstate->fileset);
+	}
+
 	node->shared_info =
 		shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, true);
 }
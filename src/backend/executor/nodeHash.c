@@ -30,6 +30,7 @@
 #include "access/parallel.h"
 #include "catalog/pg_statistic.h"
 #include "commands/tablespace.h"
+#include "common/hashfn.h"
 #include "executor/executor.h"
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
@@ -37,14 +38,31 @@
 #include "miscadmin.h"
 #include "port/atomics.h"
 #include "port/pg_bitutils.h"
+#include "port/simd.h"
 #include "utils/dynahash.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/syscache.h"
 #include "utils/wait_event.h"
 
+/*
+ * Parameters of the open-addressing layout of private hash tables, see
+ * ExecHashTableBuildSlots.  Tags are compared a vector at a time, so the tag
+ * array is followed by copies of its first HJ_SLOT_GROUP - 1 entries, which
+ * lets a probe load a whole group starting at any slot.
+ */
+#define HJ_SLOT_GROUP			((int) sizeof(Vector8))
+#define HJ_SLOT_TAG(hash)		((uint8) (((hash) >> 25) | 0x80))
+#define HJ_MAX_PROBE_LENGTH		512
+#define HJ_SLOTS_SIZE(nslots) \
+	((Size) (nslots) * (sizeof(HashJoinTuple) + 1) + HJ_SLOT_GROUP - 1)
+
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
 static void ExecHashIncreaseNumBuckets(HashJoinTable hashtable);
+static void ExecHashLinkBuckets(HashJoinTable hashtable);
+static inline int ExecHashFindSlot(HashJoinTable hashtable, uint32 slotno,
+								   uint8 tag);
+static bool ExecScanHashSlots(HashJoinState *hjstate, ExprContext *econtext);
 static void ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable);
 static void ExecParallelHashIncreaseNumBuckets(HashJoinTable hashtable);
 static void ExecHashBuildSkewHash(HashJoinTable hashtable, Hash *node,
@@ -194,8 +212,14 @@ MultiExecPrivateHash(HashState *node)
 	if (hashtable->nbuckets != hashtable->nbuckets_optimal)
 		ExecHashIncreaseNumBuckets(hashtable);
 
+	/* switch to open addressing, if possible */
+	ExecHashTableBuildSlots(hashtable);
+
 	/* Account for the buckets in spaceUsed (reported in EXPLAIN ANALYZE) */
-	hashtable->spaceUsed += hashtable->nbuckets * sizeof(HashJoinTuple);
+	if (hashtable->nslots > 0)
+		hashtable->spaceUsed += HJ_SLOTS_SIZE(hashtable->nslots);
+	else
+		hashtable->spaceUsed += hashtable->nbuckets * sizeof(HashJoinTuple);
 	if (hashtable->spaceUsed > hashtable->spacePeak)
 		hashtable->spacePeak = hashtable->spaceUsed;
 
@@ -487,6 +511,9 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 	hashtable->log2_nbuckets = log2_nbuckets;
 	hashtable->log2_nbuckets_optimal = log2_nbuckets;
 	hashtable->buckets.unshared = NULL;
+	hashtable->nslots = 0;
+	hashtable->slot_tags = NULL;
+	hashtable->slots = NULL;
 	hashtable->keepNulls = keepNulls;
 	hashtable->skewEnabled = false;
 	hashtable->skewBucket = NULL;
@@ -1468,8 +1495,6 @@ ExecParallelHashMergeCounters(HashJoinTable hashtable)
 static void
 ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 {
-	HashMemoryChunk chunk;
-
 	/* do nothing if not an increase (it's called increase for a reason) */
 	if (hashtable->nbuckets >= hashtable->nbuckets_optimal)
 		return;
@@ -1496,6 +1521,19 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 		repalloc_array(hashtable->buckets.unshared,
 					   HashJoinTuple, hashtable->nbuckets);
 
+	ExecHashLinkBuckets(hashtable);
+}
+
+/*
+ * ExecHashLinkBuckets
+ *		rebuild the bucket chains of a private hash table from the tuples
+ *		in its dense-allocated chunks
+ */
+static void
+ExecHashLinkBuckets(HashJoinTable hashtable)
+{
+	HashMemoryChunk chunk;
+
 	memset(hashtable->buckets.unshared, 0,
 		   hashtable->nbuckets * sizeof(HashJoinTuple));
 
@@ -1957,6 +1995,231 @@ ExecHashGetBucketAndBatch(HashJoinTable hashtable,
 	}
 }
 
+/*
+ * ExecHashTableBuildSlots
+ *		replace the bucket chains of a loaded private hash table by an
+ *		open-addressing table, if possible
+ *
+ * Following a bucket chain costs a dependent cache miss for each tuple in
+ * it, matching or not.  In the open-addressing table, each tuple occupies a
+ * slot, found by linear probing from a position given by its hash value,
+ * and a one-byte tag next to the slot holds 7 more bits of the hash value.
+ * A probe compares the tags of a whole group of consecutive slots at once,
+ * using SIMD instructions where available, and only visits the tuples whose
+ * tag matches, which are usually just the matching tuples.  The tags of
+ * occupied slots have their high bit set, so that they differ from the zero
+ * tag of an empty slot.  The position and tag are taken from a remix of the
+ * hash value, because in a multi-batch join the bits that select the batch
+ * are the same for all tuples in the table.  The table is at most half full,
+ * keeping the probe sequences short.
+ *
+ * The tuples stay in the dense-allocated chunks, and the bucket array is
+ * freed.  We give up and keep the bucket chains if the slot arrays would
+ * exceed the memory budget, or if a probe sequence gets too long, as happens
+ * when many inner tuples have the same hash value.
+ *
+ * This must be called only once all tuples of the batch are inserted, as
+ * ExecHashTableInsert and the batch and bucket growth code work only on
+ * bucket chains.  ExecHashTableReset returns to bucket chains.
+ */
+void
+ExecHashTableBuildSlots(HashJoinTable hashtable)
+{
+	HashMemoryChunk chunk;
+	double		ntuples = 0;
+	int			nslots;
+	uint32		mask;
+	uint8	   *tags;
+	HashJoinTuple *slots;
+	bool		too_long = false;
+
+	Assert(hashtable->parallel_state == NULL);
+	Assert(hashtable->nslots == 0);
+
+	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
+		ntuples += chunk->ntuples;
+	if (ntuples == 0)
+		return;
+
+	/* Guard against integer overflow and alloc size overflow */
+	if (ntuples * 2 > MaxAllocSize / sizeof(HashJoinTuple))
+		return;
+	nslots = pg_nextpower2_32(Max((uint32) ntuples * 2, HJ_SLOT_GROUP));
+	if ((Size) nslots * sizeof(HashJoinTuple) > MaxAllocSize ||
+		hashtable->spaceUsed + HJ_SLOTS_SIZE(nslots) > hashtable->spaceAllowed)
+		return;
+
+	tags = MemoryContextAllocZero(hashtable->batchCxt,
+								  nslots + HJ_SLOT_GROUP - 1);
+	slots = MemoryContextAllocZero(hashtable->batchCxt,
+								   nslots * sizeof(HashJoinTuple));
+	mask = nslots - 1;
+
+	for (chunk = hashtable->chunks;
+		 chunk != NULL && !too_long;
+		 chunk = chunk->next.unshared)
+	{
+		size_t		idx = 0;
+
+		while (idx < chunk->used)
+		{
+			HashJoinTuple hashTuple = (HashJoinTuple) (HASH_CHUNK_DATA(chunk) + idx);
+			uint32		hash = murmurhash32(hashTuple->hashvalue);
+			uint32		slotno = hash & mask;
+			int			probes = 0;
+
+			while (tags[slotno] != 0)
+			{
+				slotno = (slotno + 1) & mask;
+				if (++probes > HJ_MAX_PROBE_LENGTH)
+					break;
+			}
+			if (probes > HJ_MAX_PROBE_LENGTH)
+			{
+				too_long = true;
+				break;
+			}
+
+			tags[slotno] = HJ_SLOT_TAG(hash);
+			slots[slotno] = hashTuple;
+
+			/* there is only one tuple in each slot, so terminate its chain */
+			hashTuple->next.unshared = NULL;
+
+			idx += MAXALIGN(HJTUPLE_OVERHEAD +
+							HJTUPLE_MINTUPLE(hashTuple)->t_len);
+		}
+
+		/* allow this loop to be cancellable */
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	if (too_long)
+	{
+		/* Relink the tuples whose chain we already terminated */
+		pfree(tags);
+		pfree(slots);
+		ExecHashLinkBuckets(hashtable);
+		return;
+	}
+
+	/* Copy the leading tags past the end, for group loads that wrap */
+	memcpy(tags + nslots, tags, HJ_SLOT_GROUP - 1);
+
+#ifdef HJDEBUG
+	printf("Hashjoin %p: switching from %d buckets to %d slots\n",
+		   hashtable, hashtable->nbuckets, nslots);
+#endif
+
+	pfree(hashtable->buckets.unshared);
+	hashtable->buckets.unshared = NULL;
+	hashtable->nslots = nslots;
+	hashtable->slot_tags = tags;
+	hashtable->slots = slots;
+}
+
+/*
+ * ExecHashFindSlot
+ *		find the next slot of an open-addressing hash table with the given
+ *		tag, starting at slotno
+ *
+ * Returns -1 if an empty slot is reached first, which ends the probe.
+ */
+static inline int
+ExecHashFindSlot(HashJoinTable hashtable, uint32 slotno, uint8 tag)
+{
+	const uint8 *tags = hashtable->slot_tags;
+	uint32		mask = hashtable->nslots - 1;
+
+#ifndef USE_NO_SIMD
+	const Vector8 tagvec = vector8_broadcast(tag);
+	const Vector8 zerovec = vector8_broadcast(0);
+
+	for (;;)
+	{
+		Vector8		group;
+		uint32		matches;
+		uint32		empties;
+
+		vector8_load(&group, &tags[slotno]);
+		matches = vector8_highbit_mask(vector8_eq(group, tagvec));
+		empties = vector8_highbit_mask(vector8_eq(group, zerovec));
+
+		/* ignore the slots past the first empty one */
+		if (empties != 0)
+			matches &= (UINT32_C(1) << pg_rightmost_one_pos32(empties)) - 1;
+
+		if (matches != 0)
+			return (slotno + pg_rightmost_one_pos32(matches)) & mask;
+		if (empties != 0)
+			return -1;
+		slotno = (slotno + HJ_SLOT_GROUP) & mask;
+	}
+#else
+	for (;;)
+	{
+		if (tags[slotno] == tag)
+			return slotno;
+		if (tags[slotno] == 0)
+			return -1;
+		slotno = (slotno + 1) & mask;
+	}
+#endif
+}
+
+/*
+ * ExecHashPrefetchSlots
+ *		prefetch the slots that a probe for the given hash value starts with
+ *
+ * This and ExecHashPrefetchTuple let a caller that has several outer tuples
+ * at hand overlap the cache misses of their probes: it should call this for
+ * each of them, then ExecHashPrefetchTuple for each of them, before probing.
+ * Both do nothing unless the table uses open addressing, and the hash value
+ * belongs to the current batch.
+ */
+void
+ExecHashPrefetchSlots(HashJoinTable hashtable, uint32 hashvalue)
+{
+	int			bucketno;
+	int			batchno;
+	uint32		slotno;
+
+	if (hashtable->nslots == 0)
+		return;
+	ExecHashGetBucketAndBatch(hashtable, hashvalue, &bucketno, &batchno);
+	if (batchno != hashtable->curbatch)
+		return;
+
+	slotno = murmurhash32(hashvalue) & (hashtable->nslots - 1);
+	pg_prefetch_mem(&hashtable->slot_tags[slotno]);
+	pg_prefetch_mem(&hashtable->slots[slotno]);
+}
+
+/*
+ * ExecHashPrefetchTuple
+ *		prefetch the first tuple that a probe for the given hash value visits
+ */
+void
+ExecHashPrefetchTuple(HashJoinTable hashtable, uint32 hashvalue)
+{
+	int			bucketno;
+	int			batchno;
+	uint32		hash;
+	int			slotno;
+
+	if (hashtable->nslots == 0)
+		return;
+	ExecHashGetBucketAndBatch(hashtable, hashvalue, &bucketno, &batchno);
+	if (batchno != hashtable->curbatch)
+		return;
+
+	hash = murmurhash32(hashvalue);
+	slotno = ExecHashFindSlot(hashtable, hash & (hashtable->nslots - 1),
+							  HJ_SLOT_TAG(hash));
+	if (slotno >= 0)
+		pg_prefetch_mem(hashtable->slots[slotno]);
+}
+
 /*
  * ExecScanHashBucket
  *		scan a hash bucket for matches to the current outer tuple
@@ -1976,6 +2239,11 @@ ExecScanHashBucket(HashJoinState *hjstate,
 	HashJoinTuple hashTuple = hjstate->hj_CurTuple;
 	uint32		hashvalue = hjstate->hj_CurHashValue;
 
+	/* In an open-addressing table, walk the probe sequence instead */
+	if (hashtable->nslots > 0 &&
+		hjstate->hj_CurSkewBucketNo == INVALID_SKEW_BUCKET_NO)
+		return ExecScanHashSlots(hjstate, econtext);
+
 	/*
 	 * hj_CurTuple is the address of the tuple last returned from the current
 	 * bucket, or NULL if it's time to start scanning a new bucket.
@@ -2018,6 +2286,59 @@ ExecScanHashBucket(HashJoinState *hjstate,
 	return false;
 }
 
+/*
+ * ExecScanHashSlots
+ *		ExecScanHashBucket for a hash table that uses open addressing
+ *
+ * hj_CurBucketNo holds the slot of the tuple last returned.
+ */
+static bool
+ExecScanHashSlots(HashJoinState *hjstate, ExprContext *econtext)
+{
+	ExprState  *hjclauses = hjstate->hashclauses;
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	uint32		hashvalue = hjstate->hj_CurHashValue;
+	uint32		hash = murmurhash32(hashvalue);
+	uint8		tag = HJ_SLOT_TAG(hash);
+	uint32		mask = hashtable->nslots - 1;
+	int			slotno;
+
+	if (hjstate->hj_CurTuple != NULL)
+		slotno = (hjstate->hj_CurBucketNo + 1) & mask;
+	else
+		slotno = hash & mask;
+
+	while ((slotno = ExecHashFindSlot(hashtable, slotno, tag)) >= 0)
+	{
+		HashJoinTuple hashTuple = hashtable->slots[slotno];
+
+		if (hashTuple->hashvalue == hashvalue)
+		{
+			TupleTableSlot *inntuple;
+
+			/* insert hashtable's tuple into exec slot so ExecQual sees it */
+			inntuple = ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(hashTuple),
+											 hjstate->hj_HashTupleSlot,
+											 false);	/* do not pfree */
+			econtext->ecxt_innertuple = inntuple;
+
+			if (ExecQualAndReset(hjclauses, econtext))
+			{
+				hjstate->hj_CurTuple = hashTuple;
+				hjstate->hj_CurBucketNo = slotno;
+				return true;
+			}
+		}
+
+		slotno = (slotno + 1) & mask;
+	}
+
+	/*
+	 * no match
+	 */
+	return false;
+}
+
 /*
  * ExecParallelScanHashBucket
  *		scan a hash bucket for matches to the current outer tuple
@@ -2180,7 +2501,15 @@ ExecScanHashTableForUnmatched(HashJoinState *hjstate, ExprContext *econtext)
 		 */
 		if (hashTuple != NULL)
 			hashTuple = hashTuple->next.unshared;
-		else if (hjstate->hj_CurBucketNo < hashtable->nbuckets)
+		else if (hashtable->nslots > 0 &&
+				 hjstate->hj_CurBucketNo < hashtable->nslots)
+		{
+			/* each slot is a bucket of at most one tuple */
+			hashTuple = hashtable->slots[hjstate->hj_CurBucketNo];
+			hjstate->hj_CurBucketNo++;
+		}
+		else if (hashtable->nslots == 0 &&
+				 hjstate->hj_CurBucketNo < hashtable->nbuckets)
 		{
 			hashTuple = hashtable->buckets.unshared[hjstate->hj_CurBucketNo];
 			hjstate->hj_CurBucketNo++;
@@ -2318,6 +2647,11 @@ ExecHashTableReset(HashJoinTable hashtable)
 	/* Reallocate and reinitialize the hash bucket headers. */
 	hashtable->buckets.unshared = palloc0_array(HashJoinTuple, nbuckets);
 
+	/* Go back to bucket chains until the new batch is loaded */
+	hashtable->nslots = 0;
+	hashtable->slot_tags = NULL;
+	hashtable->slots = NULL;
+
 	hashtable->spaceUsed = 0;
 
 	MemoryContextSwitchTo(oldcxt);
@@ -2337,11 +2671,23 @@ ExecHashTableResetMatchFlags(HashJoinTable hashtable)
 	int			i;
 
 	/* Reset all flags in the main table ... */
-	for (i = 0; i < hashtable->nbuckets; i++)
+	if (hashtable->nslots > 0)
 	{
-		for (tuple = hashtable->buckets.unshared[i]; tuple != NULL;
-			 tuple = tuple->next.unshared)
-			HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(tuple));
+		for (i = 0; i < hashtable->nslots; i++)
+		{
+			tuple = hashtable->slots[i];
+			if (tuple != NULL)
+				HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(tuple));
+		}
+	}
+	else
+	{
+		for (i = 0; i < hashtable->nbuckets; i++)
+		{
+			for (tuple = hashtable->buckets.unshared[i]; tuple != NULL;
+				 tuple = tuple->next.unshared)
+				HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(tuple));
+		}
 	}
 
 	/* ... and the same for the skew buckets, if any */
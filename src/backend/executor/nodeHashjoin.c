@@ -188,9 +188,26 @@
 /* Returns true if doing null-fill on inner relation */
 #define HJ_FILL_INNER(hjstate)	((hjstate)->hj_NullOuterTupleSlot != NULL)
 
+/*
+ * When the hash table uses open addressing and is big enough that probes
+ * will mostly miss the CPU caches, outer tuples are fetched and hashed
+ * HJ_OUTER_BUFFER_SIZE at a time, and the hash table memory that their
+ * probes will visit is prefetched before the first of them is probed.
+ */
+#define HJ_OUTER_BUFFER_SIZE		16
+#define HJ_OUTER_BUFFER_MIN_SLOTS	(64 * 1024)
+
 static TupleTableSlot *ExecHashJoinOuterGetTuple(PlanState *outerNode,
 												 HashJoinState *hjstate,
 												 uint32 *hashvalue);
+static TupleTableSlot *ExecHashJoinOuterFillBuffer(PlanState *outerNode,
+												   HashJoinState *hjstate,
+												   uint32 *hashvalue);
+static TupleTableSlot *ExecHashJoinOuterFetchTuple(PlanState *outerNode,
+												   HashJoinState *hjstate,
+												   uint32 *hashvalue,
+												   TupleTableSlot *fileSlot);
+static void ExecHashJoinResetOuterBuffer(HashJoinState *hjstate);
 static TupleTableSlot *ExecParallelHashJoinOuterGetTuple(PlanState *outerNode,
 														 HashJoinState *hjstate,
 														 uint32 *hashvalue);
@@ -846,6 +863,12 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	hjstate->hj_MatchedOuter = false;
 	hjstate->hj_OuterNotEmpty = false;
 
+	hjstate->hj_OuterBufSlots = NULL;
+	hjstate->hj_OuterBufHashValues = NULL;
+	hjstate->hj_OuterBufCount = 0;
+	hjstate->hj_OuterBufNext = 0;
+	hjstate->hj_OuterBufDone = false;
+
 	return hjstate;
 }
 
@@ -892,6 +915,132 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 						  uint32 *hashvalue)
 {
 	HashJoinTable hashtable = hjstate->hj_HashTable;
+
+	/* Return a buffered tuple, if we have one */
+	if (hjstate->hj_OuterBufNext < hjstate->hj_OuterBufCount)
+	{
+		int			i = hjstate->hj_OuterBufNext++;
+
+		*hashvalue = hjstate->hj_OuterBufHashValues[i];
+		return hjstate->hj_OuterBufSlots[i];
+	}
+
+	if (hashtable->nslots >= HJ_OUTER_BUFFER_MIN_SLOTS)
+		return ExecHashJoinOuterFillBuffer(outerNode, hjstate, hashvalue);
+
+	return ExecHashJoinOuterFetchTuple(outerNode, hjstate, hashvalue,
+									   hjstate->hj_OuterTupleSlot);
+}
+
+/*
+ * ExecHashJoinOuterFillBuffer
+ *
+ *		fetch the next HJ_OUTER_BUFFER_SIZE outer tuples into the outer
+ *		tuple buffer, prefetch the hash table memory that their probes will
+ *		visit, and return the first of them
+ *
+ * Probing for a tuple costs a few dependent cache misses in a large hash
+ * table: first the slots where the probe starts, then the tuple in the
+ * first matching slot.  Prefetching both for a whole buffer of tuples, one
+ * step at a time, lets these misses overlap instead.
+ */
+static TupleTableSlot *
+ExecHashJoinOuterFillBuffer(PlanState *outerNode,
+							HashJoinState *hjstate,
+							uint32 *hashvalue)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	uint32	   *hashvalues;
+	int			count = 0;
+
+	if (hjstate->hj_OuterBufSlots == NULL)
+	{
+		EState	   *estate = hjstate->js.ps.state;
+		TupleTableSlot *slot = hjstate->hj_OuterTupleSlot;
+		MemoryContext oldcontext;
+
+		oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+		hjstate->hj_OuterBufSlots =
+			palloc_array(TupleTableSlot *, HJ_OUTER_BUFFER_SIZE);
+		for (int i = 0; i < HJ_OUTER_BUFFER_SIZE; i++)
+			hjstate->hj_OuterBufSlots[i] =
+				ExecInitExtraTupleSlot(estate, slot->tts_tupleDescriptor,
+									   slot->tts_ops);
+		hjstate->hj_OuterBufHashValues =
+			palloc_array(uint32, HJ_OUTER_BUFFER_SIZE);
+		MemoryContextSwitchTo(oldcontext);
+	}
+	hashvalues = hjstate->hj_OuterBufHashValues;
+
+	while (!hjstate->hj_OuterBufDone && count < HJ_OUTER_BUFFER_SIZE)
+	{
+		TupleTableSlot *bufslot = hjstate->hj_OuterBufSlots[count];
+		TupleTableSlot *slot;
+
+		slot = ExecHashJoinOuterFetchTuple(outerNode, hjstate,
+										   &hashvalues[count], bufslot);
+		if (TupIsNull(slot))
+		{
+			/* don't fetch again, the outer plan may not support that */
+			hjstate->hj_OuterBufDone = true;
+			break;
+		}
+
+		/*
+		 * Tuples from the outer plan are only valid until it's called again,
+		 * so copy them.  Those from batch files are read into the buffer.
+		 */
+		if (slot != bufslot)
+			ExecCopySlot(bufslot, slot);
+
+		ExecHashPrefetchSlots(hashtable, hashvalues[count]);
+		count++;
+	}
+
+	for (int i = 0; i < count; i++)
+		ExecHashPrefetchTuple(hashtable, hashvalues[i]);
+
+	hjstate->hj_OuterBufCount = count;
+	hjstate->hj_OuterBufNext = 0;
+	if (count == 0)
+		return NULL;
+
+	hjstate->hj_OuterBufNext = 1;
+	*hashvalue = hashvalues[0];
+	return hjstate->hj_OuterBufSlots[0];
+}
+
+/*
+ * ExecHashJoinResetOuterBuffer
+ *
+ *		empty the outer tuple buffer, at the start of a batch or scan
+ */
+static void
+ExecHashJoinResetOuterBuffer(HashJoinState *hjstate)
+{
+	if (hjstate->hj_OuterBufSlots != NULL)
+	{
+		for (int i = 0; i < hjstate->hj_OuterBufCount; i++)
+			ExecClearTuple(hjstate->hj_OuterBufSlots[i]);
+	}
+	hjstate->hj_OuterBufCount = 0;
+	hjstate->hj_OuterBufNext = 0;
+	hjstate->hj_OuterBufDone = false;
+}
+
+/*
+ * ExecHashJoinOuterFetchTuple
+ *
+ *		workhorse of ExecHashJoinOuterGetTuple; tuples read from a batch
+ *		file are stored in fileSlot
+ */
+static TupleTableSlot *
+ExecHashJoinOuterFetchTuple(PlanState *outerNode,
+							HashJoinState *hjstate,
+							uint32 *hashvalue,
+							TupleTableSlot *fileSlot)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
 	int			curbatch = hashtable->curbatch;
 	TupleTableSlot *slot;
 
@@ -948,7 +1097,7 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 		slot = ExecHashJoinGetSavedTuple(hjstate,
 										 file,
 										 hashvalue,
-										 hjstate->hj_OuterTupleSlot);
+										 fileSlot);
 		if (!TupIsNull(slot))
 			return slot;
 	}
@@ -1150,6 +1299,9 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 		hashtable->innerBatchFile[curbatch] = NULL;
 	}
 
+	/* switch the hash table to open addressing, if possible */
+	ExecHashTableBuildSlots(hashtable);
+
 	/*
 	 * Rewind outer batch file (if present), so that we can start reading it.
 	 */
@@ -1160,6 +1312,7 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 					(errcode_for_file_access(),
 					 errmsg("could not rewind hash-join temporary file")));
 	}
+	ExecHashJoinResetOuterBuffer(hjstate);
 
 	return true;
 }
@@ -1470,6 +1623,7 @@ ExecReScanHashJoin(HashJoinState *node)
 
 	node->hj_MatchedOuter = false;
 	node->hj_FirstOuterTupleSlot = NULL;
+	ExecHashJoinResetOuterBuffer(node);
 
 	/*
 	 * if chgParam of subnode is not null then plan will be re-scanned by
@@ -111,6 +111,7 @@ IndexNext(IndexScanState *node)
 								   estate->es_snapshot,
 								   node->iss_NumScanKeys,
 								   node->iss_NumOrderByKeys);
+		index_enable_prefetch(scandesc);
 
 		node->iss_ScanDesc = scandesc;
 
@@ -1676,6 +1677,7 @@ ExecIndexScanInitializeDSM(IndexScanState *node,
 								 node->iss_NumScanKeys,
 								 node->iss_NumOrderByKeys,
 								 piscan);
+	index_enable_prefetch(node->iss_ScanDesc);
 
 	/*
 	 * If no run-time keys to calculate or they are ready, go ahead and pass
@@ -1719,6 +1721,7 @@ ExecIndexScanInitializeWorker(IndexScanState *node,
 								 node->iss_NumScanKeys,
 								 node->iss_NumOrderByKeys,
 								 piscan);
+	index_enable_prefetch(node->iss_ScanDesc);
 
 	/*
 	 * If no run-time keys to calculate or they are ready, go ahead and pass
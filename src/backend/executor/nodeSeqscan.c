@@ -20,6 +20,9 @@
  *		ExecEndSeqScan			releases any storage allocated.
  *		ExecReScanSeqScan		rescans the relation
  *
+ *		ExecSeqScanBeginBatch	prepares to return tuples in batches
+ *		ExecSeqScanNextBatch	retrieve next batch of qualifying tuples
+ *
  *		ExecSeqScanEstimate		estimates DSM space needed for parallel scan
  *		ExecSeqScanInitializeDSM initialize DSM for parallel scan
  *		ExecSeqScanReInitializeDSM reinitialize DSM for fresh parallel scan
@@ -29,8 +32,10 @@
 
 #include "access/relscan.h"
 #include "access/tableam.h"
+#include "executor/execBatch.h"
 #include "executor/executor.h"
 #include "executor/nodeSeqscan.h"
+#include "miscadmin.h"
 #include "utils/rel.h"
 
 static TupleTableSlot *SeqNext(SeqScanState *node);
@@ -115,6 +120,105 @@ ExecSeqScan(PlanState *pstate)
 }
 
 
+/* ----------------------------------------------------------------
+ *		ExecSeqScanBeginBatch
+ *
+ *		Prepare to return the scan's tuples a batch at a time through
+ *		ExecSeqScanNextBatch, for a parent node that consumes them
+ *		directly.  The caller adds the columns it needs to the batch.
+ *
+ *		Returns NULL if the scan's qual can't be evaluated over batches,
+ *		or if batches are disabled.  The scan's projection is bypassed, so
+ *		the caller must check that it only picks out table columns.
+ * ----------------------------------------------------------------
+ */
+TupleBatch *
+ExecSeqScanBeginBatch(SeqScanState *node)
+{
+	EState	   *estate = node->ss.ps.state;
+	SeqScan    *plan = (SeqScan *) node->ss.ps.plan;
+	TupleDesc	tupdesc = RelationGetDescr(node->ss.ss_currentRelation);
+	TupleBatch *batch;
+
+	if (executor_batch_size <= 0)
+		return NULL;
+
+	/*
+	 * Per-tuple instrumentation and EvalPlanQual rechecks happen in
+	 * ExecProcNode and ExecScan, which batches bypass.
+	 */
+	if (node->ss.ps.instrument != NULL || estate->es_epq_active != NULL)
+		return NULL;
+
+	batch = ExecBatchCreate(tupdesc, executor_batch_size);
+	if (!ExecBatchBuildQual(batch, tupdesc, plan->scan.plan.qual,
+							plan->scan.scanrelid))
+		return NULL;
+
+	return batch;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecSeqScanNextBatch
+ *
+ *		Fill the batch with the next tuples that satisfy the scan's qual.
+ *		Returns the number of selected rows, which is zero only when the
+ *		scan is complete.
+ * ----------------------------------------------------------------
+ */
+int
+ExecSeqScanNextBatch(SeqScanState *node, TupleBatch *batch)
+{
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+	MemoryContext oldContext;
+
+	if (node->ss.ps.chgParam != NULL)
+		ExecReScan((PlanState *) node);
+
+	while (!batch->done)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		ResetExprContext(econtext);
+
+		batch->nrows = 0;
+		while (batch->nrows < batch->maxrows)
+		{
+			int			row = batch->nrows;
+
+			if (SeqNext(node) == NULL)
+			{
+				batch->done = true;
+				break;
+			}
+
+			slot_getsomeattrs(slot, batch->maxattnum);
+			for (int col = 0; col < batch->ncols; col++)
+			{
+				int			attoff = batch->attnums[col] - 1;
+
+				batch->values[col][row] = slot->tts_values[attoff];
+				batch->isnull[col][row] = slot->tts_isnull[attoff];
+			}
+			batch->nrows++;
+		}
+
+		/* any garbage from operator functions goes away with the batch */
+		oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+		ExecBatchQual(batch);
+		MemoryContextSwitchTo(oldContext);
+
+		if (batch->nselected > 0)
+			return batch->nselected;
+	}
+
+	batch->nrows = 0;
+	batch->nselected = 0;
+	return 0;
+}
+
+
 /* ----------------------------------------------------------------
  *		ExecInitSeqScan
  * ----------------------------------------------------------------
@@ -22,9 +22,44 @@
 
 #include "access/htup_details.h"
 #include "access/tupdesc_details.h"
+#include "common/hashfn.h"
 #include "executor/tuptable.h"
 #include "jit/llvmjit.h"
 #include "jit/llvmjit_emit.h"
+#include "lib/stringinfo.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+
+
+/*
+ * Cache of emitted deforming functions, kept for the lifetime of the backend.
+ *
+ * A deforming function only depends on the shape of the tuple descriptor, the
+ * slot type and the number of columns to deform, and unlike expressions it
+ * doesn't embed pointers to any per-query state.  So once one has been
+ * emitted, expressions in later queries can just call it, instead of
+ * generating, optimizing and emitting their own copy.
+ *
+ * The cached functions are emitted by contexts that are never released, into
+ * the same LLJIT instance as expressions compiled with the same optimization
+ * level.  A declaration in the expression's module is therefore all that is
+ * needed for the symbol to be resolved when that module is emitted.  Entries
+ * are never removed, as code of live expressions might still refer to them;
+ * once jit_deform_cache_size entries exist, further deforming functions are
+ * compiled into the expression's module as usual.
+ */
+typedef struct DeformCacheEntry
+{
+	uint64		hash;			/* hash of the shape, the hash key */
+	char	   *shape;			/* the shape, to detect hash collisions */
+	int			shapelen;
+	char	   *funcname;		/* name of the emitted function */
+} DeformCacheEntry;
+
+static HTAB *deform_cache = NULL;
+
+/* contexts emitting the cached functions, without and with PGJIT_OPT3 */
+static LLVMJitContext *deform_cache_context[2];
 
 
 /*
@@ -775,3 +810,153 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 
 	return v_deform_fn;
 }
+
+/*
+ * Serialize everything slot_compile_deform()'s output depends on.
+ */
+static void
+deform_cache_shape(StringInfo buf, TupleDesc desc,
+				   const TupleTableSlotOps *ops, int natts, int optflags)
+{
+	appendBinaryStringInfo(buf, &ops, sizeof(ops));
+	appendBinaryStringInfo(buf, &natts, sizeof(natts));
+	appendBinaryStringInfo(buf, &optflags, sizeof(optflags));
+	appendBinaryStringInfo(buf, &desc->natts, sizeof(desc->natts));
+
+	for (int attnum = 0; attnum < desc->natts; attnum++)
+	{
+		Form_pg_attribute att = TupleDescAttr(desc, attnum);
+
+		appendBinaryStringInfo(buf, &att->attlen, sizeof(att->attlen));
+		appendStringInfoChar(buf, att->attalign);
+		appendStringInfoChar(buf, att->attbyval);
+		appendStringInfoChar(buf, att->attnotnull);
+		appendStringInfoChar(buf, att->atthasmissing);
+		appendStringInfoChar(buf, att->attisdropped);
+	}
+}
+
+/*
+ * Like slot_compile_deform(), but reuse a deforming function emitted for an
+ * earlier query if there is one, and otherwise emit the new function so that
+ * later queries can reuse it.  In both cases the returned function is only a
+ * declaration in the context's module.
+ */
+LLVMValueRef
+slot_compile_deform_cached(LLVMJitContext *context, TupleDesc desc,
+						   const TupleTableSlotOps *ops, int natts)
+{
+#if LLVM_VERSION_MAJOR > 11
+	int			optflags = context->base.flags & PGJIT_OPT3;
+	StringInfoData shape;
+	uint64		hash;
+	DeformCacheEntry *entry;
+	LLVMModuleRef mod;
+	LLVMValueRef v_deform_fn;
+
+	if (jit_deform_cache_size <= 0)
+		return slot_compile_deform(context, desc, ops, natts);
+
+	if (deform_cache == NULL)
+	{
+		HASHCTL		ctl;
+
+		ctl.keysize = sizeof(uint64);
+		ctl.entrysize = sizeof(DeformCacheEntry);
+		ctl.hcxt = TopMemoryContext;
+		deform_cache = hash_create("LLVM JIT deform cache", 64, &ctl,
+								   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	initStringInfo(&shape);
+	deform_cache_shape(&shape, desc, ops, natts, optflags);
+	hash = hash_bytes_extended((const unsigned char *) shape.data,
+							   shape.len, 0);
+
+	entry = (DeformCacheEntry *) hash_search(deform_cache, &hash,
+											 HASH_FIND, NULL);
+	if (entry == NULL)
+	{
+		LLVMJitContext *cachecxt;
+		const char *name;
+		size_t		namelen;
+		char	   *funcname;
+
+		if (hash_get_num_entries(deform_cache) >= jit_deform_cache_size)
+		{
+			pfree(shape.data);
+			return slot_compile_deform(context, desc, ops, natts);
+		}
+
+		cachecxt = deform_cache_context[optflags ? 1 : 0];
+		if (cachecxt == NULL)
+		{
+			cachecxt = MemoryContextAllocZero(TopMemoryContext,
+											  sizeof(LLVMJitContext));
+			cachecxt->base.flags = optflags;
+			deform_cache_context[optflags ? 1 : 0] = cachecxt;
+		}
+
+		/* discard anything left behind by an error in an earlier attempt */
+		if (cachecxt->module)
+		{
+			LLVMDisposeModule(cachecxt->module);
+			cachecxt->module = NULL;
+		}
+
+		v_deform_fn = slot_compile_deform(cachecxt, desc, ops, natts);
+		if (v_deform_fn == NULL)
+		{
+			pfree(shape.data);
+			return NULL;
+		}
+
+		/* must be visible outside its module, and survive optimization */
+		LLVMSetLinkage(v_deform_fn, LLVMExternalLinkage);
+		name = LLVMGetValueName2(v_deform_fn, &namelen);
+		funcname = MemoryContextStrdup(TopMemoryContext, name);
+
+		/* emit the function now, so that later modules can link to it */
+		llvm_get_function(cachecxt, funcname);
+
+		entry = (DeformCacheEntry *) hash_search(deform_cache, &hash,
+												 HASH_ENTER, NULL);
+		entry->shape = MemoryContextAlloc(TopMemoryContext, shape.len);
+		memcpy(entry->shape, shape.data, shape.len);
+		entry->shapelen = shape.len;
+		entry->funcname = funcname;
+	}
+	else if (entry->shapelen != shape.len ||
+			 memcmp(entry->shape, shape.data, shape.len) != 0)
+	{
+		/* hash collision, don't bother */
+		pfree(shape.data);
+		return slot_compile_deform(context, desc, ops, natts);
+	}
+
+	pfree(shape.data);
+
+	/* declare the cached function in the caller's module */
+	mod = llvm_mutable_module(context);
+	v_deform_fn = LLVMGetNamedFunction(mod, entry->funcname);
+	if (v_deform_fn == NULL)
+	{
+		LLVMTypeRef param_types[1];
+		LLVMTypeRef deform_sig;
+
+		param_types[0] = l_ptr(StructTupleTableSlot);
+		deform_sig = LLVMFunctionType(LLVMVoidTypeInContext(LLVMGetModuleContext(mod)),
+									  param_types, lengthof(param_types), 0);
+		v_deform_fn = LLVMAddFunction(mod, entry->funcname, deform_sig);
+	}
+
+	return v_deform_fn;
+#else
+
+	/*
+	 * Before LLJIT, symbols are resolved through llvm_resolve_symbol(), which
+	 * doesn't know about JITed code.
+	 */
+	return slot_compile_deform(context, desc, ops, natts);
+#endif
+}
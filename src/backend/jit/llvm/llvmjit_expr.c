@@ -357,9 +357,9 @@ llvm_compile_expr(ExprState *state)
 					{
 						INSTR_TIME_SET_CURRENT(deform_starttime);
 						l_jit_deform =
-							slot_compile_deform(context, desc,
-												tts_ops,
-												op->d.fetch.last_var);
+							slot_compile_deform_cached(context, desc,
+													   tts_ops,
+													   op->d.fetch.last_var);
 						INSTR_TIME_SET_CURRENT(deform_endtime);
 						INSTR_TIME_ACCUM_DIFF(context->base.instr.deform_counter,
 											  deform_endtime, deform_starttime);
@@ -33,6 +33,8 @@
  *		AcceptConnection	- Accept new connection with client
  *		TouchSocketFiles	- Protect socket files against /tmp cleaners
  *		pq_init				- initialize libpq at backend startup
+ *		pq_detach_client	- hand the client socket back, in pooled backends
+ *		pq_attach_client	- take over another client socket
  *		socket_comm_reset	- reset libpq during error recovery
  *		socket_close		- shutdown libpq at backend exit
  *
@@ -137,6 +139,8 @@ static bool PqCommReadingMsg;	/* in the middle of reading a message */
 /* Internal functions */
 static void socket_comm_reset(void);
 static void socket_close(int code, Datum arg);
+static void socket_set_options(Port *port);
+static void socket_init_wait_set(Port *port);
 static void socket_set_nonblocking(bool nonblocking);
 static int	socket_flush(void);
 static int	socket_flush_if_writable(void);
@@ -173,8 +177,6 @@ Port *
 pq_init(ClientSocket *client_sock)
 {
 	Port	   *port;
-	int			socket_pos PG_USED_FOR_ASSERTS_ONLY;
-	int			latch_pos PG_USED_FOR_ASSERTS_ONLY;
 
 	/* allocate the Port struct and copy the ClientSocket contents to it */
 	port = palloc0(sizeof(Port));
@@ -182,6 +184,33 @@ pq_init(ClientSocket *client_sock)
 	memcpy(&port->raddr.addr, &client_sock->raddr.addr, client_sock->raddr.salen);
 	port->raddr.salen = client_sock->raddr.salen;
 
+	socket_set_options(port);
+
+	/* initialize state variables */
+	PqSendBufferSize = PQ_SEND_BUFFER_SIZE;
+	PqSendBuffer = MemoryContextAlloc(TopMemoryContext, PqSendBufferSize);
+	PqSendPointer = PqSendStart = PqRecvPointer = PqRecvLength = 0;
+	PqCommBusy = false;
+	PqCommReadingMsg = false;
+
+	/* set up process-exit hook to close the socket */
+	on_proc_exit(socket_close, 0);
+
+	socket_init_wait_set(port);
+
+	return port;
+}
+
+/* --------------------------------
+ *		socket_set_options - set up a newly accepted client socket
+ *
+ * Fills in the server address of the Port, and puts the socket into the
+ * mode backends operate it in.
+ * --------------------------------
+ */
+static void
+socket_set_options(Port *port)
+{
 	/* fill in the server (local) address */
 	port->laddr.salen = sizeof(port->laddr.addr);
 	if (getsockname(port->sock,
@@ -274,16 +303,6 @@ pq_init(ClientSocket *client_sock)
 		(void) pq_settcpusertimeout(tcp_user_timeout, port);
 	}
 
-	/* initialize state variables */
-	PqSendBufferSize = PQ_SEND_BUFFER_SIZE;
-	PqSendBuffer = MemoryContextAlloc(TopMemoryContext, PqSendBufferSize);
-	PqSendPointer = PqSendStart = PqRecvPointer = PqRecvLength = 0;
-	PqCommBusy = false;
-	PqCommReadingMsg = false;
-
-	/* set up process-exit hook to close the socket */
-	on_proc_exit(socket_close, 0);
-
 	/*
 	 * In backends (as soon as forked) we operate the underlying socket in
 	 * nonblocking mode and use latches to implement blocking semantics if
@@ -302,6 +321,17 @@ pq_init(ClientSocket *client_sock)
 	if (fcntl(port->sock, F_SETFD, FD_CLOEXEC) < 0)
 		elog(FATAL, "fcntl(F_SETFD) failed on socket: %m");
 #endif
+}
+
+/* --------------------------------
+ *		socket_init_wait_set - create FeBeWaitSet for the client socket
+ * --------------------------------
+ */
+static void
+socket_init_wait_set(Port *port)
+{
+	int			socket_pos PG_USED_FOR_ASSERTS_ONLY;
+	int			latch_pos PG_USED_FOR_ASSERTS_ONLY;
 
 	FeBeWaitSet = CreateWaitEventSet(NULL, FeBeWaitSetNEvents);
 	socket_pos = AddWaitEventToSet(FeBeWaitSet, WL_SOCKET_WRITEABLE,
@@ -317,8 +347,64 @@ pq_init(ClientSocket *client_sock)
 	 */
 	Assert(socket_pos == FeBeWaitSetSocketPos);
 	Assert(latch_pos == FeBeWaitSetLatchPos);
+}
 
-	return port;
+/* --------------------------------
+ *		pq_detach_client - disconnect from the client socket
+ *
+ * Used by pooled backends to hand an idle session back to the postmaster;
+ * see postmaster/sessionpool.c.  The socket is returned still open, and
+ * MyProcPort is left without one until pq_attach_client() is called.  Any
+ * data still buffered in either direction is discarded, so when the session
+ * is to be continued elsewhere, the caller must have made sure there is none.
+ * --------------------------------
+ */
+pgsocket
+pq_detach_client(void)
+{
+	pgsocket	sock = MyProcPort->sock;
+
+	Assert(sock != PGINVALID_SOCKET);
+
+	FreeWaitEventSet(FeBeWaitSet);
+	FeBeWaitSet = NULL;
+	MyProcPort->sock = PGINVALID_SOCKET;
+	PqSendPointer = PqSendStart = PqRecvPointer = PqRecvLength = 0;
+
+	return sock;
+}
+
+/* --------------------------------
+ *		pq_attach_client - take over another client socket
+ *
+ * The counterpart of pq_detach_client(): MyProcPort is switched over to the
+ * given socket, whose client has already been authenticated by another
+ * backend.  The caller is responsible for the remote host fields.
+ * --------------------------------
+ */
+void
+pq_attach_client(ClientSocket *client_sock)
+{
+	Port	   *port = MyProcPort;
+
+	Assert(port->sock == PGINVALID_SOCKET);
+
+	port->sock = client_sock->sock;
+	memcpy(&port->raddr.addr, &client_sock->raddr.addr, client_sock->raddr.salen);
+	port->raddr.salen = client_sock->raddr.salen;
+
+	/* the keepalive settings of the previous socket don't apply anymore */
+	port->default_keepalives_idle = 0;
+	port->default_keepalives_interval = 0;
+	port->default_keepalives_count = 0;
+	port->default_tcp_user_timeout = 0;
+	port->keepalives_idle = 0;
+	port->keepalives_interval = 0;
+	port->keepalives_count = 0;
+	port->tcp_user_timeout = 0;
+
+	socket_set_options(port);
+	socket_init_wait_set(port);
 }
 
 /* --------------------------------
@@ -234,6 +234,12 @@ static RelOptInfo *create_partial_grouping_paths(PlannerInfo *root,
 												 GroupPathExtraData *extra,
 												 bool force_rel_creation);
 static void gather_grouping_paths(PlannerInfo *root, RelOptInfo *rel);
+static void add_parallel_hashagg_path(PlannerInfo *root,
+									  RelOptInfo *grouped_rel,
+									  RelOptInfo *partially_grouped_rel,
+									  List *havingQual,
+									  const AggClauseCosts *agg_final_costs,
+									  double dNumGroups);
 static bool can_partial_agg(PlannerInfo *root);
 static void apply_scanjoin_target_to_paths(PlannerInfo *root,
 										   RelOptInfo *rel,
@@ -7171,6 +7177,17 @@ add_paths_to_grouping_rel(PlannerInfo *root, RelOptInfo *input_rel,
 									 agg_final_costs,
 									 dNumGroups));
 		}
+
+		/*
+		 * Also consider finalizing the cheapest partially grouped partial
+		 * path in parallel, below a Gather.
+		 */
+		if (enable_parallel_hashagg && grouped_rel->consider_parallel &&
+			partially_grouped_rel &&
+			partially_grouped_rel->partial_pathlist != NIL)
+			add_parallel_hashagg_path(root, grouped_rel, partially_grouped_rel,
+									  havingQual, agg_final_costs,
+									  dNumGroups);
 	}
 
 	/*
@@ -7577,6 +7594,59 @@ gather_grouping_paths(PlannerInfo *root, RelOptInfo *rel)
 	}
 }
 
+/*
+ * add_parallel_hashagg_path
+ *
+ * Add a Gather path atop a parallel-aware Finalize HashAgg over the cheapest
+ * partial path of the partially grouped relation.  The participants of the
+ * HashAgg exchange the partially aggregated tuples so that each of them
+ * finalizes a disjoint subset of the groups.  Compared to finalizing atop a
+ * Gather, the final aggregation is spread across the participants, and only
+ * the final groups pass through the Gather.
+ */
+static void
+add_parallel_hashagg_path(PlannerInfo *root, RelOptInfo *grouped_rel,
+						  RelOptInfo *partially_grouped_rel,
+						  List *havingQual,
+						  const AggClauseCosts *agg_final_costs,
+						  double dNumGroups)
+{
+	Path	   *path = (Path *) linitial(partially_grouped_rel->partial_pathlist);
+	AggPath    *aggpath;
+	double		numGroups;
+
+	Assert(path->parallel_workers > 0);
+
+	/* Each participant emits its share of the groups. */
+	numGroups = clamp_row_est(dNumGroups / path->parallel_workers);
+
+	aggpath = create_agg_path(root,
+							  grouped_rel,
+							  path,
+							  grouped_rel->reltarget,
+							  AGG_HASHED,
+							  AGGSPLIT_FINAL_DESERIAL,
+							  root->processed_groupClause,
+							  havingQual,
+							  agg_final_costs,
+							  numGroups);
+	if (!aggpath->path.parallel_safe)
+		return;
+	aggpath->path.parallel_aware = true;
+
+	/*
+	 * Charge for writing each partially aggregated tuple to a shared
+	 * partition and reading it back, which is done before the first group
+	 * can be emitted.
+	 */
+	aggpath->path.startup_cost += cpu_tuple_cost * path->rows;
+	aggpath->path.total_cost += cpu_tuple_cost * path->rows;
+
+	add_path(grouped_rel, (Path *)
+			 create_gather_path(root, grouped_rel, &aggpath->path,
+								grouped_rel->reltarget, NULL, &dNumGroups));
+}
+
 /*
  * can_partial_agg
  *
@@ -106,6 +106,7 @@
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/pgarch.h"
 #include "postmaster/postmaster.h"
+#include "postmaster/sessionpool.h"
 #include "postmaster/syslogger.h"
 #include "postmaster/walsummarizer.h"
 #include "replication/logicallauncher.h"
@@ -410,7 +411,9 @@ static void PostmasterStateMachine(void);
 
 static void ExitPostmaster(int status) pg_attribute_noreturn();
 static int	ServerLoop(void);
-static int	BackendStartup(ClientSocket *client_sock);
+static int	BackendStartup(ClientSocket *client_sock, char *pooled_session,
+						   size_t pooled_session_len);
+static void ServeSessionPool(void);
 static void report_fork_failure_to_client(ClientSocket *client_sock, int errnum);
 static CAC_state canAcceptConnections(int backend_type);
 static bool RandomCancelKey(int32 *cancel_key);
@@ -993,6 +996,12 @@ PostmasterMain(int argc, char *argv[])
 	 */
 	InitPostmasterDeathWatchHandle();
 
+	/*
+	 * Set up the session pool, if enabled.  This must happen before any
+	 * children are started.
+	 */
+	SessionPoolPostmasterInit();
+
 #ifdef WIN32
 
 	/*
@@ -1607,7 +1616,8 @@ ConfigurePostmasterWaitSet(bool accept_connections)
 	pm_wait_set = NULL;
 
 	pm_wait_set = CreateWaitEventSet(NULL,
-									 accept_connections ? (1 + NumListenSockets) : 1);
+									 (accept_connections ? (1 + NumListenSockets) : 1) +
+									 SessionPoolNumWaitEvents());
 	AddWaitEventToSet(pm_wait_set, WL_LATCH_SET, PGINVALID_SOCKET, MyLatch,
 					  NULL);
 
@@ -1617,6 +1627,9 @@ ConfigurePostmasterWaitSet(bool accept_connections)
 			AddWaitEventToSet(pm_wait_set, WL_SOCKET_ACCEPT, ListenSockets[i],
 							  NULL, NULL);
 	}
+
+	/* The session pool's events must come last; see RemoveWaitEvent() */
+	SessionPoolAddWaitEvents(pm_wait_set);
 }
 
 /*
@@ -1668,12 +1681,26 @@ ServerLoop(void)
 			if (pending_pm_pmsignal)
 				process_pm_pmsignal();
 
+			/* Only the session pool's events carry user data */
+			if (events[i].user_data != NULL)
+			{
+				SessionPoolHandleEvent(&events[i]);
+				continue;
+			}
+
 			if (events[i].events & WL_SOCKET_ACCEPT)
 			{
 				ClientSocket s;
 
-				if (AcceptConnection(events[i].fd, &s) == STATUS_OK)
-					BackendStartup(&s);
+				/*
+				 * If all backend slots are taken, but some by idle pooled
+				 * backends, the connection can wait for one of them to exit.
+				 */
+				if (AcceptConnection(events[i].fd, &s) == STATUS_OK &&
+					!(max_pooled_sessions > 0 &&
+					  canAcceptConnections(BACKEND_TYPE_NORMAL) == CAC_TOOMANY &&
+					  SessionPoolDeferConnection(&s)))
+					BackendStartup(&s, NULL, 0);
 
 				/* We no longer need the open socket in this process */
 				if (s.sock != PGINVALID_SOCKET)
@@ -1684,6 +1711,9 @@ ServerLoop(void)
 			}
 		}
 
+		/* Start backends for pooled sessions that need one */
+		ServeSessionPool();
+
 		/* If we have lost the log collector, try to start a new one */
 		if (SysLoggerPID == 0 && Logging_collector)
 			SysLoggerPID = SysLogger_Start();
@@ -1837,6 +1867,7 @@ void
 processCancelRequest(int backendPID, int32 cancelAuthCode)
 {
 	Backend    *bp;
+	pid_t		pooled_pid;
 
 #ifndef EXEC_BACKEND
 	dlist_iter	iter;
@@ -1844,6 +1875,22 @@ processCancelRequest(int backendPID, int32 cancelAuthCode)
 	int			i;
 #endif
 
+	/*
+	 * A pooled session keeps the PID of the backend that started it, but may
+	 * be served by a different backend now, or by none.
+	 */
+	if (SessionPoolLookupCancel(backendPID, cancelAuthCode, &pooled_pid))
+	{
+		if (pooled_pid != 0)
+		{
+			ereport(DEBUG2,
+					(errmsg_internal("processing cancel request: sending SIGINT to process %d",
+									 (int) pooled_pid)));
+			signal_child(pooled_pid, SIGINT);
+		}
+		return;
+	}
+
 	/*
 	 * See if we have a matching backend.  In the EXEC_BACKEND case, we can no
 	 * longer access the postmaster's own backend list, and must rely on the
@@ -1963,6 +2010,9 @@ ClosePostmasterPorts(bool am_syslogger)
 		pm_wait_set = NULL;
 	}
 
+	/* Likewise for the session pool's sockets */
+	SessionPoolCloseAfterFork();
+
 #ifndef WIN32
 
 	/*
@@ -2795,6 +2845,8 @@ CleanupBackend(int pid,
 
 	LogChildExit(DEBUG2, _("server process"), pid, exitstatus);
 
+	SessionPoolBackendExited(pid);
+
 	/*
 	 * If a backend dies in an ugly way then we must signal all other backends
 	 * to quickdie.  If exit status is zero (normal) or one (FATAL exit), we
@@ -3537,16 +3589,21 @@ TerminateChildren(int signal)
 /*
  * BackendStartup -- start backend process
  *
+ * If pooled_session is not NULL, the backend takes over that session of the
+ * session pool, instead of starting a new one.
+ *
  * returns: STATUS_ERROR if the fork failed, STATUS_OK otherwise.
  *
  * Note: if you change this code, also consider StartAutovacuumWorker.
  */
 static int
-BackendStartup(ClientSocket *client_sock)
+BackendStartup(ClientSocket *client_sock, char *pooled_session,
+			   size_t pooled_session_len)
 {
 	Backend    *bn;				/* for backend cleanup */
 	pid_t		pid;
-	BackendStartupData startup_data;
+	BackendStartupData *startup_data;
+	size_t		startup_data_len;
 
 	/*
 	 * Create backend data structure.  Better before the fork() so we can
@@ -3575,9 +3632,24 @@ BackendStartup(ClientSocket *client_sock)
 		return STATUS_ERROR;
 	}
 
-	/* Pass down canAcceptConnections state */
-	startup_data.canAcceptConnections = canAcceptConnections(BACKEND_TYPE_NORMAL);
-	bn->dead_end = (startup_data.canAcceptConnections != CAC_OK);
+	startup_data_len = offsetof(BackendStartupData, pooled_session) +
+		pooled_session_len;
+	startup_data = palloc_extended(startup_data_len, MCXT_ALLOC_NO_OOM);
+	if (!startup_data)
+	{
+		pfree(bn);
+		ereport(LOG,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory")));
+		return STATUS_ERROR;
+	}
+
+	/* Pass down canAcceptConnections state, and the pooled session if any */
+	startup_data->canAcceptConnections = canAcceptConnections(BACKEND_TYPE_NORMAL);
+	startup_data->pooled_session_len = pooled_session_len;
+	if (pooled_session_len > 0)
+		memcpy(startup_data->pooled_session, pooled_session, pooled_session_len);
+	bn->dead_end = (startup_data->canAcceptConnections != CAC_OK);
 	bn->cancel_key = MyCancelKey;
 
 	/*
@@ -3591,9 +3663,15 @@ BackendStartup(ClientSocket *client_sock)
 	/* Hasn't asked to be notified about any bgworkers yet */
 	bn->bgworker_notify = false;
 
+	/* Give it a channel to the session pool, if it may join one */
+	if (!bn->dead_end)
+		SessionPoolPrepareBackend();
+
 	pid = postmaster_child_launch(B_BACKEND,
-								  (char *) &startup_data, sizeof(startup_data),
+								  (char *) startup_data, startup_data_len,
 								  client_sock);
+	pfree(startup_data);
+	SessionPoolBackendForked(pid);
 	if (pid < 0)
 	{
 		/* in parent, fork failed */
@@ -3630,6 +3708,49 @@ BackendStartup(ClientSocket *client_sock)
 	return STATUS_OK;
 }
 
+/*
+ * ServeSessionPool -- start backends for the session pool
+ *
+ * Starts backends for connections that were deferred because all backend
+ * slots were taken, and for parked sessions whose pools have room for
+ * another backend.  If we run out of slots, idle pooled backends are told to
+ * exit to make room.
+ */
+static void
+ServeSessionPool(void)
+{
+	SessionPoolSetOpen(connsAllowed && !FatalError && Shutdown == NoShutdown &&
+					   (pmState == PM_RUN || pmState == PM_HOT_STANDBY));
+
+	while (SessionPoolStartupPending())
+	{
+		ClientSocket cs;
+		char	   *session;
+		size_t		session_len;
+		int			status;
+
+		if (canAcceptConnections(BACKEND_TYPE_NORMAL) != CAC_OK)
+		{
+			SessionPoolRetireIdleBackends();
+			break;
+		}
+
+		if (!SessionPoolNextStartup(&cs, &session, &session_len))
+			break;
+
+		status = BackendStartup(&cs, session, session_len);
+		SessionPoolStartupDone();
+
+		if (closesocket(cs.sock) != 0)
+			elog(LOG, "could not close client socket: %m");
+		if (session)
+			pfree(session);
+
+		if (status != STATUS_OK)
+			break;
+	}
+}
+
 /*
  * Try to report backend fork() failure to client before we close the
  * connection.  Since we do not care to risk blocking the postmaster on
@@ -0,0 +1,1834 @@
+/*-------------------------------------------------------------------------
+ *
+ * sessionpool.c
+ *	  Multiplexing client sessions over a pool of backends.
+ *
+ * Normally every client connection gets a backend of its own, which stays
+ * around until the client disconnects, idle or not.  With session pooling
+ * (max_pooled_sessions > 0), a backend whose client is idle between
+ * transactions hands the client socket back to the postmaster, and goes on
+ * to serve another client session that has work to do.  This lets a large
+ * number of mostly idle connections be served by a much smaller number of
+ * backends.
+ *
+ * A backend can only give up a session that holds no state that a different
+ * backend couldn't reproduce.  Sessions that have created temporary tables,
+ * prepared statements or holdable cursors, changed settings with SET, taken
+ * session-level advisory locks, or are listening for notifications stay with
+ * their backend until they disconnect; such a session is "pinned".  The
+ * state a new backend gets from the startup packet and the authentication
+ * is passed along with the socket, in a "session descriptor".  Sessions are
+ * only handed between backends whose startup state is identical, so all
+ * backends serving the same database and role with the same startup options
+ * form a pool.  Each pool has at most session_pool_size backends, which can
+ * be set per database or role with ALTER DATABASE/ROLE SET.
+ *
+ * The postmaster keeps the "parked" sessions in its wait set.  When one of
+ * them becomes readable, it is passed to an idle backend of its pool, or a
+ * new backend is started for it if the pool isn't full yet; otherwise it
+ * waits for a backend of the pool to become free.  A new backend started
+ * for a parked session doesn't read a startup packet or authenticate the
+ * client, but takes over the session described by the descriptor.
+ *
+ * Backends talk to the postmaster over a datagram socket pair shared by all
+ * of them, and the postmaster talks to each backend over a socket pair of
+ * its own; client sockets are passed along with SCM_RIGHTS.  The postmaster
+ * never blocks on these: if a message can't be delivered, the backend is
+ * presumed dead.
+ *
+ * A client keeps the process ID and cancel key that its first backend
+ * reported, so cancel requests for sessions that have moved are routed
+ * through a table in shared memory that maps them to the backend currently
+ * serving the session, if any.
+ *
+ * Session pooling relies on fork() semantics and on passing sockets between
+ * processes, so it is not supported in EXEC_BACKEND builds.  Sessions using
+ * SSL or GSSAPI encryption are never pooled, since their encryption state
+ * can't be passed on.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/postmaster/sessionpool.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+
+#include "access/xact.h"
+#include "catalog/namespace.h"
+#include "commands/async.h"
+#include "commands/prepare.h"
+#include "commands/sequence.h"
+#include "common/hashfn.h"
+#include "common/ip.h"
+#include "common/string.h"
+#include "lib/ilist.h"
+#include "libpq/libpq.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "postmaster/interrupt.h"
+#include "postmaster/sessionpool.h"
+#include "replication/origin.h"
+#include "replication/slot.h"
+#include "replication/walsender.h"
+#include "storage/fd.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lock.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"
+#include "utils/guc.h"
+#include "utils/guc_hooks.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/portal.h"
+#include "utils/ps_status.h"
+
+/* GUC parameters */
+int			max_pooled_sessions = 0;
+int			session_pool_size = 10;
+
+/*
+ * Set in a backend that was started to take over a parked session, until it
+ * is ready for queries.
+ */
+bool		SessionPoolAdopting = false;
+
+/* Largest message passed over the session pool channels */
+#define SESSION_POOL_MAX_MSG	8192
+
+typedef enum SessionPoolMsgType
+{
+	SP_MSG_PARK,				/* backend: here's my idle session */
+	SP_MSG_IDLE,				/* backend: I have no session */
+	SP_MSG_DETACH,				/* backend: my session is pinned */
+	SP_MSG_ASSIGN,				/* postmaster: serve this session */
+	SP_MSG_EXIT,				/* postmaster: exit */
+} SessionPoolMsgType;
+
+/*
+ * Header of all messages.  PARK and ASSIGN messages carry a client socket,
+ * and are followed by a session descriptor.
+ */
+typedef struct SessionPoolMsg
+{
+	SessionPoolMsgType type;
+	pid_t		pid;			/* sending backend */
+	uint64		pool_key;		/* pool of the sending backend */
+	int			pool_size;		/* its session_pool_size */
+} SessionPoolMsg;
+
+/*
+ * Header of a session descriptor.  It's followed by the "startup data": the
+ * protocol version, database and user name, command-line options and GUC
+ * options from the startup packet, and the serialized ClientConnectionInfo.
+ * The pool key is a hash of the startup data.
+ */
+typedef struct SessionDescriptor
+{
+	int32		session_pid;	/* PID the client knows the session by */
+	int32		cancel_key;		/* and its cancel key */
+	int			cancel_slot;	/* index in SessionCancelKeys, or -1 */
+	uint32		startup_len;	/* length of the startup data */
+} SessionDescriptor;
+
+/*
+ * Entry of the cancel key table in shared memory.  An entry is claimed by
+ * the first backend that releases a session, and freed when the session
+ * ends.  backend_pid is 0 while the session is parked.
+ */
+typedef struct SessionCancelKey
+{
+	slock_t		mutex;
+	int32		session_pid;	/* 0 if the entry is unused */
+	int32		cancel_key;
+	pid_t		backend_pid;
+} SessionCancelKey;
+
+static SessionCancelKey *SessionCancelKeys = NULL;
+
+/* Number of entries in SessionCancelKeys */
+#define NumSessionCancelKeys()	(max_pooled_sessions + MaxBackends)
+
+/*
+ * Shared channel from backends to the postmaster.  The postmaster reads from
+ * the first socket, backends write to the second.
+ */
+static pgsocket pool_inbox[2] = {PGINVALID_SOCKET, PGINVALID_SOCKET};
+
+/*
+ * Channel for the backend being started, created by SessionPoolPrepareBackend()
+ * and handed over by SessionPoolBackendForked().  The postmaster keeps the
+ * first socket, the backend the second.
+ */
+static pgsocket pending_channel[2] = {PGINVALID_SOCKET, PGINVALID_SOCKET};
+
+/* In a backend, its end of its channel from the postmaster */
+static pgsocket MyPoolChannel = PGINVALID_SOCKET;
+
+/*
+ * Postmaster's state.
+ */
+typedef struct SessionPool
+{
+	uint64		key;			/* hash key; must be first */
+	int			size;			/* latest session_pool_size reported */
+	int			nmembers;		/* backends serving the pool */
+	int			nsessions;		/* parked sessions of the pool */
+	dlist_head	idle_members;	/* backends waiting for a session */
+	dlist_head	waiting;		/* parked sessions waiting for a backend */
+	bool		starved;		/* in starved_pools? */
+	dlist_node	starved_node;
+} SessionPool;
+
+typedef struct PoolMember
+{
+	pid_t		pid;			/* hash key; must be first */
+	pgsocket	channel;		/* postmaster's end of the backend's channel */
+	SessionPool *pool;			/* pool the backend serves, or NULL */
+	bool		idle;			/* in pool->idle_members? */
+	bool		exiting;		/* told to exit? */
+	dlist_node	idle_node;
+} PoolMember;
+
+typedef struct ParkedSession
+{
+	pgsocket	sock;			/* client socket */
+	SessionPool *pool;
+	int			wait_pos;		/* position in the wait set, or -1 */
+	dlist_node	node;			/* in parked_sessions or pool->waiting */
+	size_t		len;			/* length of the descriptor */
+	char		data[FLEXIBLE_ARRAY_MEMBER];	/* session descriptor */
+} ParkedSession;
+
+static HTAB *pool_hash = NULL;
+static HTAB *member_hash = NULL;
+
+/* Sessions in the wait set, waiting for input */
+static dlist_head parked_sessions = DLIST_STATIC_INIT(parked_sessions);
+
+/* Pools with sessions waiting for a backend, that may start another one */
+static dlist_head starved_pools = DLIST_STATIC_INIT(starved_pools);
+static int	n_starved = 0;
+
+/* Connections waiting for a backend slot; list of ClientSocket pointers */
+static List *deferred_connections = NIL;
+
+static int	n_parked = 0;		/* parked sessions, in all pools */
+static int	n_idle = 0;			/* idle members, in all pools */
+static int	n_exiting = 0;		/* members told to exit, not gone yet */
+
+/* Pool of the backend being started for a parked session */
+static SessionPool *starting_pool = NULL;
+
+/* Are we handing out parked sessions, or closing them? */
+static bool pool_open = true;
+
+static WaitEventSet *pool_wait_set = NULL;
+
+/* user_data of the inbox in the wait set */
+static char inbox_marker;
+
+/*
+ * Backend's state.
+ */
+static bool session_poolable = false;	/* can our sessions be pooled? */
+static bool pool_member = false;	/* does the postmaster count us? */
+static char *my_startup_data = NULL;
+static uint32 my_startup_len = 0;
+static uint64 my_pool_key = 0;
+static SessionDescriptor cur_session;	/* session we're serving */
+
+static bool send_with_socket(pgsocket channel, const void *data, size_t len,
+							 pgsocket sock, int flags);
+static ssize_t receive_with_socket(pgsocket channel, void *buf, size_t len,
+								   pgsocket *sock);
+static void set_cloexec(pgsocket sock);
+
+static void read_inbox(void);
+static void handle_park(PoolMember *member, SessionPoolMsg *msg,
+						pgsocket sock, char *data, size_t len);
+static void session_readable(ParkedSession *session);
+static SessionPool *get_pool(uint64 key, int size);
+static void maybe_free_pool(SessionPool *pool);
+static void update_starved(SessionPool *pool);
+static void member_join(PoolMember *member, SessionPool *pool);
+static void member_leave(PoolMember *member);
+static void member_become_idle(PoolMember *member);
+static bool member_send(PoolMember *member, SessionPoolMsgType type,
+						pgsocket sock, const char *data, size_t len);
+static void member_exit(PoolMember *member);
+static bool assign_session(PoolMember *member, ParkedSession *session);
+static void free_session(ParkedSession *session);
+static void close_all_sessions(void);
+
+static void build_startup_data(void);
+static void restore_startup_data(Port *port, const char *data, uint32 len);
+static bool session_is_pinned(void);
+static bool client_data_pending(void);
+static void send_to_postmaster(SessionPoolMsgType type, pgsocket sock);
+static void wait_for_session(void);
+static bool take_session(pgsocket sock, char *data, size_t len);
+static bool claim_cancel_slot(void);
+static void set_cancel_backend(pid_t backend_pid);
+static void free_cancel_slot(void);
+static void session_pool_shmem_exit(int code, Datum arg);
+
+
+/*
+ * GUC check hook for max_pooled_sessions
+ */
+bool
+check_max_pooled_sessions(int *newval, void **extra, GucSource source)
+{
+#ifdef EXEC_BACKEND
+	if (*newval > 0)
+	{
+		GUC_check_errdetail("Session pooling is not supported by this build.");
+		return false;
+	}
+#endif
+	return true;
+}
+
+/*
+ * Report shared-memory space needed by the cancel key table
+ */
+Size
+SessionPoolShmemSize(void)
+{
+	if (max_pooled_sessions == 0)
+		return 0;
+
+	return mul_size(NumSessionCancelKeys(), sizeof(SessionCancelKey));
+}
+
+/*
+ * Allocate and initialize the cancel key table
+ */
+void
+SessionPoolShmemInit(void)
+{
+	bool		found;
+
+	if (max_pooled_sessions == 0)
+		return;
+
+	SessionCancelKeys = (SessionCancelKey *)
+		ShmemInitStruct("Session Pool Cancel Keys", SessionPoolShmemSize(),
+						&found);
+
+	if (!found)
+	{
+		for (int i = 0; i < NumSessionCancelKeys(); i++)
+		{
+			SpinLockInit(&SessionCancelKeys[i].mutex);
+			SessionCancelKeys[i].session_pid = 0;
+			SessionCancelKeys[i].cancel_key = 0;
+			SessionCancelKeys[i].backend_pid = 0;
+		}
+	}
+}
+
+/*
+ * Look up a cancel request in the table of pooled sessions.
+ *
+ * Returns true if the request is for a session that has been passed around,
+ * and sets *backend_pid to the backend currently serving it, or 0 if it's
+ * parked.  Called in the child process handling the cancel request.
+ */
+bool
+SessionPoolLookupCancel(int session_pid, int32 cancel_key, pid_t *backend_pid)
+{
+	if (SessionCancelKeys == NULL)
+		return false;
+
+	for (int i = 0; i < NumSessionCancelKeys(); i++)
+	{
+		SessionCancelKey *entry = &SessionCancelKeys[i];
+		bool		match;
+
+		/* unlocked precheck, to keep the scan cheap */
+		if (entry->session_pid != session_pid)
+			continue;
+
+		SpinLockAcquire(&entry->mutex);
+		match = (entry->session_pid == session_pid &&
+				 entry->cancel_key == cancel_key);
+		*backend_pid = entry->backend_pid;
+		SpinLockRelease(&entry->mutex);
+
+		if (match)
+			return true;
+	}
+
+	return false;
+}
+
+
+/* ----------------------------------------------------------------
+ *	Communication
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Send a message, along with a socket unless 'sock' is PGINVALID_SOCKET.
+ */
+static bool
+send_with_socket(pgsocket channel, const void *data, size_t len,
+				 pgsocket sock, int flags)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	union
+	{
+		struct cmsghdr hdr;
+		char		buf[CMSG_SPACE(sizeof(int))];
+	}			cmsgbuf;
+	ssize_t		rc;
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = unconstify(void *, data);
+	iov.iov_len = len;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	if (sock != PGINVALID_SOCKET)
+	{
+		struct cmsghdr *cmsg;
+
+		memset(&cmsgbuf, 0, sizeof(cmsgbuf));
+		msg.msg_control = cmsgbuf.buf;
+		msg.msg_controllen = sizeof(cmsgbuf.buf);
+		cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(cmsg), &sock, sizeof(int));
+	}
+
+	do
+	{
+		rc = sendmsg(channel, &msg, flags);
+	} while (rc < 0 && errno == EINTR);
+
+	return rc == len;
+}
+
+/*
+ * Receive a message without blocking.  Returns its length, 0 if there's
+ * none, or -1 on error.  A socket that came with it is returned in *sock,
+ * else it's set to PGINVALID_SOCKET.
+ */
+static ssize_t
+receive_with_socket(pgsocket channel, void *buf, size_t len, pgsocket *sock)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	union
+	{
+		struct cmsghdr hdr;
+		char		buf[CMSG_SPACE(sizeof(int))];
+	}			cmsgbuf;
+	struct cmsghdr *cmsg;
+	ssize_t		rc;
+
+	*sock = PGINVALID_SOCKET;
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = buf;
+	iov.iov_len = len;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cmsgbuf.buf;
+	msg.msg_controllen = sizeof(cmsgbuf.buf);
+
+	do
+	{
+		rc = recvmsg(channel, &msg, MSG_DONTWAIT);
+	} while (rc < 0 && errno == EINTR);
+
+	if (rc < 0)
+		return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+	{
+		if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+			cmsg->cmsg_len == CMSG_LEN(sizeof(int)))
+		{
+			memcpy(sock, CMSG_DATA(cmsg), sizeof(int));
+			set_cloexec(*sock);
+		}
+	}
+
+	/* a message that didn't fit can't be valid; drop it */
+	if ((msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0 ||
+		rc < sizeof(SessionPoolMsg))
+	{
+		if (*sock != PGINVALID_SOCKET)
+			closesocket(*sock);
+		*sock = PGINVALID_SOCKET;
+		elog(LOG, "invalid message on session pool channel");
+		return -1;
+	}
+
+	return rc;
+}
+
+static void
+set_cloexec(pgsocket sock)
+{
+#ifndef WIN32
+	if (fcntl(sock, F_SETFD, FD_CLOEXEC) < 0)
+		elog(LOG, "fcntl(F_SETFD) failed on socket: %m");
+#endif
+}
+
+
+/* ----------------------------------------------------------------
+ *	Postmaster side
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Set up the postmaster's state, if session pooling is enabled.
+ */
+void
+SessionPoolPostmasterInit(void)
+{
+	HASHCTL		ctl;
+
+	if (max_pooled_sessions == 0)
+		return;
+
+	if (socketpair(AF_UNIX, SOCK_DGRAM, 0, pool_inbox) < 0)
+		ereport(FATAL,
+				(errcode_for_socket_access(),
+				 errmsg("could not create session pool channel: %m")));
+	if (!pg_set_noblock(pool_inbox[0]))
+		ereport(FATAL,
+				(errcode_for_socket_access(),
+				 errmsg("could not set session pool channel to nonblocking mode: %m")));
+	set_cloexec(pool_inbox[0]);
+	set_cloexec(pool_inbox[1]);
+
+	ctl.keysize = sizeof(uint64);
+	ctl.entrysize = sizeof(SessionPool);
+	ctl.hcxt = PostmasterContext;
+	pool_hash = hash_create("Session pools", 64, &ctl,
+							HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	ctl.keysize = sizeof(pid_t);
+	ctl.entrysize = sizeof(PoolMember);
+	ctl.hcxt = PostmasterContext;
+	member_hash = hash_create("Session pool members", 256, &ctl,
+							  HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+}
+
+/*
+ * Number of wait events the session pool may add to the postmaster's wait
+ * set: the inbox, and the parked sessions.
+ */
+int
+SessionPoolNumWaitEvents(void)
+{
+	if (max_pooled_sessions == 0)
+		return 0;
+
+	return 1 + max_pooled_sessions;
+}
+
+/*
+ * Add our events to a newly created postmaster wait set.
+ */
+void
+SessionPoolAddWaitEvents(WaitEventSet *set)
+{
+	dlist_iter	iter;
+
+	if (max_pooled_sessions == 0)
+		return;
+
+	pool_wait_set = set;
+	AddWaitEventToSet(set, WL_SOCKET_READABLE, pool_inbox[0], NULL,
+					  &inbox_marker);
+
+	dlist_foreach(iter, &parked_sessions)
+	{
+		ParkedSession *session = dlist_container(ParkedSession, node, iter.cur);
+
+		session->wait_pos = AddWaitEventToSet(set, WL_SOCKET_READABLE,
+											  session->sock, NULL, session);
+	}
+}
+
+/*
+ * Handle an event that the session pool added to the wait set.
+ */
+void
+SessionPoolHandleEvent(WaitEvent *event)
+{
+	if (event->user_data == &inbox_marker)
+		read_inbox();
+	else
+		session_readable((ParkedSession *) event->user_data);
+}
+
+/*
+ * Start or stop handing out parked sessions.  When the server stops
+ * accepting connections, all parked sessions are closed, and the idle
+ * backends are told to exit.
+ */
+void
+SessionPoolSetOpen(bool open)
+{
+	if (max_pooled_sessions == 0 || open == pool_open)
+		return;
+
+	pool_open = open;
+	if (!open)
+		close_all_sessions();
+}
+
+/*
+ * Hold on to a new connection that can't get a backend now, because all
+ * backend slots are in use.  We do that only if some slots are taken by idle
+ * pooled backends that can be told to exit.
+ */
+bool
+SessionPoolDeferConnection(ClientSocket *client_sock)
+{
+	ClientSocket *copy;
+
+	if (max_pooled_sessions == 0 || !pool_open)
+		return false;
+
+	if (list_length(deferred_connections) >= n_idle + n_exiting)
+		return false;
+
+	copy = MemoryContextAlloc(PostmasterContext, sizeof(ClientSocket));
+	memcpy(copy, client_sock, sizeof(ClientSocket));
+	deferred_connections = lappend(deferred_connections, copy);
+	client_sock->sock = PGINVALID_SOCKET;
+
+	return true;
+}
+
+/*
+ * Are there connections or parked sessions that need a new backend?
+ */
+bool
+SessionPoolStartupPending(void)
+{
+	return deferred_connections != NIL || n_starved > 0;
+}
+
+/*
+ * Get the next connection or parked session to start a backend for.
+ *
+ * For a parked session, *session is set to a palloc'd copy of its
+ * descriptor, to pass to the new backend.  After starting the backend, the
+ * caller must call SessionPoolStartupDone().
+ */
+bool
+SessionPoolNextStartup(ClientSocket *client_sock, char **session,
+					   size_t *session_len)
+{
+	*session = NULL;
+	*session_len = 0;
+
+	if (deferred_connections != NIL)
+	{
+		ClientSocket *cs = linitial(deferred_connections);
+
+		deferred_connections = list_delete_first(deferred_connections);
+		memcpy(client_sock, cs, sizeof(ClientSocket));
+		pfree(cs);
+		return true;
+	}
+
+	while (!dlist_is_empty(&starved_pools))
+	{
+		SessionPool *pool = dlist_head_element(SessionPool, starved_node,
+											   &starved_pools);
+		ParkedSession *ps;
+
+		ps = dlist_container(ParkedSession, node,
+							 dlist_pop_head_node(&pool->waiting));
+
+		client_sock->sock = ps->sock;
+		client_sock->raddr.salen = sizeof(client_sock->raddr.addr);
+		if (getpeername(ps->sock, (struct sockaddr *) &client_sock->raddr.addr,
+						&client_sock->raddr.salen) < 0)
+		{
+			/* the client is gone already */
+			ps->sock = PGINVALID_SOCKET;
+			closesocket(client_sock->sock);
+			free_session(ps);
+			update_starved(pool);
+			maybe_free_pool(pool);
+			continue;
+		}
+
+		*session = palloc(ps->len);
+		memcpy(*session, ps->data, ps->len);
+		*session_len = ps->len;
+
+		/* count the new backend as a member right away */
+		pool->nmembers++;
+		starting_pool = pool;
+
+		ps->sock = PGINVALID_SOCKET;
+		free_session(ps);
+		update_starved(pool);
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Clean up after starting a backend for SessionPoolNextStartup().
+ */
+void
+SessionPoolStartupDone(void)
+{
+	if (starting_pool != NULL)
+	{
+		/* the backend didn't get started */
+		SessionPool *pool = starting_pool;
+
+		starting_pool = NULL;
+		pool->nmembers--;
+		update_starved(pool);
+		maybe_free_pool(pool);
+	}
+}
+
+/*
+ * Make room for pending startups when all backend slots are in use, by
+ * telling idle pooled backends to exit.
+ */
+void
+SessionPoolRetireIdleBackends(void)
+{
+	int			needed;
+	HASH_SEQ_STATUS status;
+	SessionPool *pool;
+
+	needed = list_length(deferred_connections) + n_starved - n_exiting;
+	if (needed <= 0 || n_idle == 0)
+		return;
+
+	hash_seq_init(&status, pool_hash);
+	while ((pool = (SessionPool *) hash_seq_search(&status)) != NULL)
+	{
+		while (needed > 0 && !dlist_is_empty(&pool->idle_members))
+		{
+			PoolMember *member = dlist_head_element(PoolMember, idle_node,
+													&pool->idle_members);
+
+			member_exit(member);
+			needed--;
+		}
+		if (needed <= 0)
+		{
+			hash_seq_term(&status);
+			break;
+		}
+	}
+}
+
+/*
+ * Create the channel for a backend about to be started.
+ */
+void
+SessionPoolPrepareBackend(void)
+{
+	if (max_pooled_sessions == 0)
+		return;
+
+	Assert(pending_channel[0] == PGINVALID_SOCKET);
+
+	if (socketpair(AF_UNIX, SOCK_DGRAM, 0, pending_channel) < 0)
+	{
+		ereport(LOG,
+				(errcode_for_socket_access(),
+				 errmsg("could not create session pool channel: %m")));
+		pending_channel[0] = pending_channel[1] = PGINVALID_SOCKET;
+		return;
+	}
+	if (!pg_set_noblock(pending_channel[0]))
+	{
+		ereport(LOG,
+				(errcode_for_socket_access(),
+				 errmsg("could not set session pool channel to nonblocking mode: %m")));
+		closesocket(pending_channel[0]);
+		closesocket(pending_channel[1]);
+		pending_channel[0] = pending_channel[1] = PGINVALID_SOCKET;
+		return;
+	}
+	set_cloexec(pending_channel[0]);
+	set_cloexec(pending_channel[1]);
+}
+
+/*
+ * In the postmaster, after forking a backend ('pid' is negative if the fork
+ * failed): register it as a potential pool member.
+ */
+void
+SessionPoolBackendForked(pid_t pid)
+{
+	PoolMember *member;
+	bool		found;
+
+	if (pending_channel[0] == PGINVALID_SOCKET)
+		return;
+
+	closesocket(pending_channel[1]);
+	pending_channel[1] = PGINVALID_SOCKET;
+
+	if (pid <= 0)
+	{
+		closesocket(pending_channel[0]);
+		pending_channel[0] = PGINVALID_SOCKET;
+		return;
+	}
+
+	member = hash_search(member_hash, &pid, HASH_ENTER, &found);
+	Assert(!found);
+	member->channel = pending_channel[0];
+	member->pool = NULL;
+	member->idle = false;
+	member->exiting = false;
+	pending_channel[0] = PGINVALID_SOCKET;
+
+	/* a backend started for a parked session is a member from the start */
+	if (starting_pool != NULL)
+	{
+		member->pool = starting_pool;
+		starting_pool = NULL;
+	}
+}
+
+/*
+ * In the postmaster, after a backend has exited.
+ */
+void
+SessionPoolBackendExited(pid_t pid)
+{
+	PoolMember *member;
+
+	if (member_hash == NULL)
+		return;
+
+	member = hash_search(member_hash, &pid, HASH_FIND, NULL);
+	if (member == NULL)
+		return;
+
+	if (member->exiting)
+		n_exiting--;
+	member_leave(member);
+	closesocket(member->channel);
+	hash_search(member_hash, &pid, HASH_REMOVE, NULL);
+}
+
+/*
+ * In a new child process, close the postmaster's session pool sockets.
+ */
+void
+SessionPoolCloseAfterFork(void)
+{
+	HASH_SEQ_STATUS status;
+	PoolMember *member;
+	SessionPool *pool;
+	dlist_iter	iter;
+	ListCell   *lc;
+
+	if (member_hash == NULL)
+		return;
+
+	closesocket(pool_inbox[0]);
+	pool_inbox[0] = PGINVALID_SOCKET;
+
+	if (pending_channel[0] != PGINVALID_SOCKET)
+	{
+		/* this is the backend that the channel was created for */
+		closesocket(pending_channel[0]);
+		MyPoolChannel = pending_channel[1];
+		pending_channel[0] = pending_channel[1] = PGINVALID_SOCKET;
+	}
+	else
+	{
+		/* not a backend; it has no business with the session pool */
+		closesocket(pool_inbox[1]);
+		pool_inbox[1] = PGINVALID_SOCKET;
+	}
+
+	hash_seq_init(&status, member_hash);
+	while ((member = (PoolMember *) hash_seq_search(&status)) != NULL)
+		closesocket(member->channel);
+
+	dlist_foreach(iter, &parked_sessions)
+		closesocket(dlist_container(ParkedSession, node, iter.cur)->sock);
+
+	hash_seq_init(&status, pool_hash);
+	while ((pool = (SessionPool *) hash_seq_search(&status)) != NULL)
+	{
+		dlist_foreach(iter, &pool->waiting)
+			closesocket(dlist_container(ParkedSession, node, iter.cur)->sock);
+	}
+
+	foreach(lc, deferred_connections)
+		closesocket(((ClientSocket *) lfirst(lc))->sock);
+}
+
+/*
+ * Read all messages from the inbox.
+ */
+static void
+read_inbox(void)
+{
+	char		buf[SESSION_POOL_MAX_MSG];
+
+	for (;;)
+	{
+		SessionPoolMsg msg;
+		PoolMember *member;
+		pgsocket	sock;
+		ssize_t		len;
+
+		len = receive_with_socket(pool_inbox[0], buf, sizeof(buf), &sock);
+		if (len == 0)
+			break;
+		if (len < 0)
+			continue;
+
+		memcpy(&msg, buf, sizeof(msg));
+		member = hash_search(member_hash, &msg.pid, HASH_FIND, NULL);
+		if (member != NULL && member->exiting)
+			member = NULL;
+
+		switch (msg.type)
+		{
+			case SP_MSG_PARK:
+				if (sock == PGINVALID_SOCKET)
+				{
+					elog(LOG, "session pool message without client socket");
+					break;
+				}
+				handle_park(member, &msg, sock,
+							buf + sizeof(msg), len - sizeof(msg));
+				break;
+
+			case SP_MSG_IDLE:
+				if (member == NULL)
+					break;
+				if (!pool_open)
+				{
+					member_exit(member);
+					break;
+				}
+				member_join(member, get_pool(msg.pool_key, msg.pool_size));
+				member_become_idle(member);
+				break;
+
+			case SP_MSG_DETACH:
+				if (member != NULL)
+					member_leave(member);
+				break;
+
+			default:
+				elog(LOG, "unexpected message type %d on session pool channel",
+					 (int) msg.type);
+				if (sock != PGINVALID_SOCKET)
+					closesocket(sock);
+				break;
+		}
+	}
+}
+
+/*
+ * A backend has handed back an idle session.
+ */
+static void
+handle_park(PoolMember *member, SessionPoolMsg *msg, pgsocket sock,
+			char *data, size_t len)
+{
+	SessionPool *pool;
+	ParkedSession *session;
+
+	if (!pool_open)
+	{
+		closesocket(sock);
+		if (member != NULL)
+			member_exit(member);
+		return;
+	}
+
+	pool = get_pool(msg->pool_key, msg->pool_size);
+
+	/*
+	 * If we're holding as many sessions as we may, give the session right
+	 * back.  That works as long as the backend is alive.
+	 */
+	if (n_parked >= max_pooled_sessions && member != NULL)
+	{
+		member_join(member, pool);
+		if (member_send(member, SP_MSG_ASSIGN, sock, data, len))
+		{
+			closesocket(sock);
+			return;
+		}
+		member_exit(member);
+		member = NULL;
+	}
+
+	session = MemoryContextAlloc(PostmasterContext,
+								 offsetof(ParkedSession, data) + len);
+	session->sock = sock;
+	session->pool = pool;
+	session->len = len;
+	memcpy(session->data, data, len);
+	n_parked++;
+	pool->nsessions++;
+
+	if (n_parked <= max_pooled_sessions && pool_wait_set != NULL)
+	{
+		session->wait_pos = AddWaitEventToSet(pool_wait_set,
+											  WL_SOCKET_READABLE, sock,
+											  NULL, session);
+		dlist_push_tail(&parked_sessions, &session->node);
+	}
+	else
+	{
+		/* no room in the wait set; treat it as ready */
+		session->wait_pos = -1;
+		dlist_push_tail(&pool->waiting, &session->node);
+		update_starved(pool);
+	}
+
+	if (member != NULL)
+	{
+		member_join(member, pool);
+		member_become_idle(member);
+	}
+}
+
+/*
+ * A parked session has input, or was closed by the client.  Pass it on to a
+ * backend of its pool.
+ */
+static void
+session_readable(ParkedSession *session)
+{
+	SessionPool *pool = session->pool;
+	ParkedSession *moved;
+
+	Assert(session->wait_pos >= 0);
+
+	moved = RemoveWaitEvent(pool_wait_set, session->wait_pos);
+	if (moved != NULL)
+		moved->wait_pos = session->wait_pos;
+	session->wait_pos = -1;
+	dlist_delete(&session->node);
+
+	while (!dlist_is_empty(&pool->idle_members))
+	{
+		PoolMember *member = dlist_head_element(PoolMember, idle_node,
+												&pool->idle_members);
+
+		if (assign_session(member, session))
+			return;
+	}
+
+	/* wait for a backend to become free, or start one */
+	dlist_push_tail(&pool->waiting, &session->node);
+	update_starved(pool);
+}
+
+static SessionPool *
+get_pool(uint64 key, int size)
+{
+	SessionPool *pool;
+	bool		found;
+
+	pool = hash_search(pool_hash, &key, HASH_ENTER, &found);
+	if (!found)
+	{
+		pool->nmembers = 0;
+		pool->nsessions = 0;
+		dlist_init(&pool->idle_members);
+		dlist_init(&pool->waiting);
+		pool->starved = false;
+	}
+	pool->size = Max(size, 1);
+
+	return pool;
+}
+
+static void
+maybe_free_pool(SessionPool *pool)
+{
+	if (pool->nmembers == 0 && pool->nsessions == 0)
+	{
+		Assert(!pool->starved);
+		hash_search(pool_hash, &pool->key, HASH_REMOVE, NULL);
+	}
+}
+
+/*
+ * Keep track of whether the pool needs a new backend.
+ */
+static void
+update_starved(SessionPool *pool)
+{
+	bool		starved;
+
+	starved = pool_open &&
+		!dlist_is_empty(&pool->waiting) &&
+		pool->nmembers < pool->size;
+
+	if (starved && !pool->starved)
+	{
+		dlist_push_tail(&starved_pools, &pool->starved_node);
+		n_starved++;
+	}
+	else if (!starved && pool->starved)
+	{
+		dlist_delete(&pool->starved_node);
+		n_starved--;
+	}
+	pool->starved = starved;
+}
+
+static void
+member_join(PoolMember *member, SessionPool *pool)
+{
+	if (member->pool == pool)
+		return;
+
+	/* a backend's startup state doesn't change, so neither does its pool */
+	Assert(member->pool == NULL);
+	member->pool = pool;
+	pool->nmembers++;
+}
+
+static void
+member_leave(PoolMember *member)
+{
+	SessionPool *pool = member->pool;
+
+	if (pool == NULL)
+		return;
+
+	if (member->idle)
+	{
+		dlist_delete(&member->idle_node);
+		member->idle = false;
+		n_idle--;
+	}
+	member->pool = NULL;
+	pool->nmembers--;
+	update_starved(pool);
+	maybe_free_pool(pool);
+}
+
+/*
+ * A member is ready for another session.
+ */
+static void
+member_become_idle(PoolMember *member)
+{
+	SessionPool *pool = member->pool;
+
+	Assert(!member->idle);
+
+	while (!dlist_is_empty(&pool->waiting))
+	{
+		ParkedSession *session;
+
+		session = dlist_container(ParkedSession, node,
+								  dlist_pop_head_node(&pool->waiting));
+		if (assign_session(member, session))
+		{
+			update_starved(pool);
+			return;
+		}
+
+		/* the member is gone; the session goes back to the front */
+		dlist_push_head(&pool->waiting, &session->node);
+		update_starved(pool);
+		return;
+	}
+
+	if (pool->nmembers > pool->size)
+	{
+		/* the pool has shrunk */
+		member_exit(member);
+		return;
+	}
+
+	/* prefer recently used backends, their caches are warm */
+	dlist_push_head(&pool->idle_members, &member->idle_node);
+	member->idle = true;
+	n_idle++;
+}
+
+static bool
+member_send(PoolMember *member, SessionPoolMsgType type, pgsocket sock,
+			const char *data, size_t len)
+{
+	char		buf[SESSION_POOL_MAX_MSG];
+	SessionPoolMsg msg;
+
+	Assert(sizeof(msg) + len <= sizeof(buf));
+
+	msg.type = type;
+	msg.pid = PostmasterPid;
+	msg.pool_key = 0;
+	msg.pool_size = 0;
+	memcpy(buf, &msg, sizeof(msg));
+	if (len > 0)
+		memcpy(buf + sizeof(msg), data, len);
+
+	return send_with_socket(member->channel, buf, sizeof(msg) + len, sock,
+							MSG_DONTWAIT);
+}
+
+/*
+ * Tell a member to exit.  It doesn't count as a member of its pool anymore,
+ * but keeps its backend slot until it's gone.
+ */
+static void
+member_exit(PoolMember *member)
+{
+	if (member->exiting)
+		return;
+
+	member_leave(member);
+	member->exiting = true;
+	n_exiting++;
+
+	/* if this fails, the backend is gone already */
+	(void) member_send(member, SP_MSG_EXIT, PGINVALID_SOCKET, NULL, 0);
+}
+
+/*
+ * Pass a session to a member.  If that fails, the member is presumed dead,
+ * and leaves the pool; the caller still owns the session then.
+ */
+static bool
+assign_session(PoolMember *member, ParkedSession *session)
+{
+	if (member->idle)
+	{
+		dlist_delete(&member->idle_node);
+		member->idle = false;
+		n_idle--;
+	}
+
+	if (!member_send(member, SP_MSG_ASSIGN, session->sock, session->data,
+					 session->len))
+	{
+		ereport(LOG,
+				(errmsg("could not pass session to pooled backend %d: %m",
+						(int) member->pid)));
+		member_exit(member);
+		return false;
+	}
+
+	closesocket(session->sock);
+	session->sock = PGINVALID_SOCKET;
+	free_session(session);
+	return true;
+}
+
+/*
+ * Forget about a session that is not in any list anymore.
+ */
+static void
+free_session(ParkedSession *session)
+{
+	Assert(session->wait_pos < 0);
+
+	if (session->sock != PGINVALID_SOCKET)
+		closesocket(session->sock);
+	n_parked--;
+	session->pool->nsessions--;
+	pfree(session);
+}
+
+/*
+ * Close all parked sessions and deferred connections, and tell all idle
+ * members to exit.
+ */
+static void
+close_all_sessions(void)
+{
+	HASH_SEQ_STATUS status;
+	SessionPool *pool;
+	ListCell   *lc;
+
+	while (!dlist_is_empty(&parked_sessions))
+	{
+		ParkedSession *session = dlist_head_element(ParkedSession, node,
+													&parked_sessions);
+		ParkedSession *moved;
+
+		moved = RemoveWaitEvent(pool_wait_set, session->wait_pos);
+		if (moved != NULL)
+			moved->wait_pos = session->wait_pos;
+		session->wait_pos = -1;
+		dlist_delete(&session->node);
+		free_session(session);
+	}
+
+	hash_seq_init(&status, pool_hash);
+	while ((pool = (SessionPool *) hash_seq_search(&status)) != NULL)
+	{
+		while (!dlist_is_empty(&pool->waiting))
+			free_session(dlist_container(ParkedSession, node,
+										 dlist_pop_head_node(&pool->waiting)));
+		update_starved(pool);
+
+		while (!dlist_is_empty(&pool->idle_members))
+			member_exit(dlist_head_element(PoolMember, idle_node,
+										   &pool->idle_members));
+	}
+
+	foreach(lc, deferred_connections)
+	{
+		ClientSocket *cs = lfirst(lc);
+
+		closesocket(cs->sock);
+		pfree(cs);
+	}
+	list_free(deferred_connections);
+	deferred_connections = NIL;
+
+	/* now get rid of the pools that are left empty */
+	hash_seq_init(&status, pool_hash);
+	while ((pool = (SessionPool *) hash_seq_search(&status)) != NULL)
+		maybe_free_pool(pool);
+}
+
+
+/* ----------------------------------------------------------------
+ *	Backend side
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Called by BackendInitialize() in a backend started for a parked session,
+ * instead of reading the startup packet.  Sets up the Port as the backend
+ * that started the session left it.
+ */
+void
+SessionPoolAdoptSession(Port *port, char *data, size_t len)
+{
+	SessionDescriptor desc;
+	MemoryContext oldcontext;
+
+	Assert(len >= sizeof(desc));
+	memcpy(&desc, data, sizeof(desc));
+	Assert(len == sizeof(desc) + desc.startup_len);
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+	my_startup_len = desc.startup_len;
+	my_startup_data = palloc(my_startup_len);
+	memcpy(my_startup_data, data + sizeof(desc), my_startup_len);
+	restore_startup_data(port, my_startup_data, my_startup_len);
+	MemoryContextSwitchTo(oldcontext);
+
+	cur_session = desc;
+	SessionPoolAdopting = true;
+}
+
+/*
+ * Set up session pooling in a backend, once the session is established.
+ */
+void
+SessionPoolInitBackend(void)
+{
+	if (SessionPoolAdopting)
+	{
+		/* we serve the session now; the cancel key table must say so */
+		on_shmem_exit(session_pool_shmem_exit, 0);
+		set_cancel_backend(MyProcPid);
+		pgstat_report_client_session(cur_session.session_pid);
+		pool_member = true;
+	}
+
+	if (MyPoolChannel == PGINVALID_SOCKET)
+		return;
+
+	/* Tell fd.c about the channel */
+	ReserveExternalFD();
+
+	if (am_walsender || MyProcPort == NULL || MyProcPort->ssl_in_use)
+		return;
+#ifdef ENABLE_GSS
+	if (be_gssapi_get_enc(MyProcPort))
+		return;
+#endif
+
+	if (!SessionPoolAdopting)
+	{
+		build_startup_data();
+		cur_session.session_pid = MyProcPid;
+		cur_session.cancel_key = MyCancelKey;
+		cur_session.cancel_slot = -1;
+		cur_session.startup_len = my_startup_len;
+	}
+
+	/* oversized startup data can't be passed on */
+	if (sizeof(SessionPoolMsg) + sizeof(SessionDescriptor) + my_startup_len >
+		SESSION_POOL_MAX_MSG)
+		return;
+
+	my_pool_key = hash_bytes_extended((const unsigned char *) my_startup_data,
+									  my_startup_len, 0);
+	session_poolable = true;
+
+	if (!SessionPoolAdopting)
+		on_shmem_exit(session_pool_shmem_exit, 0);
+}
+
+/*
+ * Can the idle session be handed back to the postmaster?  The caller has
+ * checked that we're not in a transaction.
+ */
+bool
+SessionPoolCanReleaseSession(void)
+{
+	if (!session_poolable)
+		return false;
+
+	/* don't bother if the client has sent its next command already */
+	if (pq_buffer_remaining_data() > 0 || pq_is_send_pending() ||
+		client_data_pending())
+		return false;
+
+	if (session_is_pinned())
+	{
+		/* let the postmaster know that we're not available anymore */
+		if (pool_member)
+		{
+			send_to_postmaster(SP_MSG_DETACH, PGINVALID_SOCKET);
+			pool_member = false;
+		}
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Hand the idle session back to the postmaster, and wait for a session to
+ * serve.  That may well be the same one.
+ */
+void
+SessionPoolReleaseSession(void)
+{
+	pgsocket	sock;
+
+	/* the session must remain cancelable while it's parked */
+	if (cur_session.cancel_slot < 0 && !claim_cancel_slot())
+		return;
+	set_cancel_backend(0);
+
+	sock = pq_detach_client();
+	send_to_postmaster(SP_MSG_PARK, sock);
+	closesocket(sock);
+	pool_member = true;
+
+	pgstat_report_client_session(0);
+	wait_for_session();
+}
+
+/*
+ * Can this backend go on to serve other sessions after the client has
+ * disconnected?
+ */
+bool
+SessionPoolCanEndSession(void)
+{
+	return session_poolable &&
+		!IsTransactionOrTransactionBlock() &&
+		!session_is_pinned();
+}
+
+/*
+ * The client has disconnected.  Close the socket, and wait for a session
+ * to serve.
+ */
+void
+SessionPoolEndSession(void)
+{
+	pgsocket	sock;
+
+	free_cancel_slot();
+
+	sock = pq_detach_client();
+	closesocket(sock);
+
+	send_to_postmaster(SP_MSG_IDLE, PGINVALID_SOCKET);
+	pool_member = true;
+
+	pgstat_report_client_session(0);
+	wait_for_session();
+}
+
+/*
+ * Build the startup data of the current session.
+ */
+static void
+build_startup_data(void)
+{
+	StringInfoData buf;
+	MemoryContext oldcontext;
+	Size		conninfo_len;
+	ListCell   *lc;
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	initStringInfo(&buf);
+	appendBinaryStringInfo(&buf, &MyProcPort->proto, sizeof(ProtocolVersion));
+	appendBinaryStringInfo(&buf, MyProcPort->database_name,
+						   strlen(MyProcPort->database_name) + 1);
+	appendBinaryStringInfo(&buf, MyProcPort->user_name,
+						   strlen(MyProcPort->user_name) + 1);
+	if (MyProcPort->cmdline_options)
+		appendBinaryStringInfo(&buf, MyProcPort->cmdline_options,
+							   strlen(MyProcPort->cmdline_options) + 1);
+	else
+		appendBinaryStringInfo(&buf, "", 1);
+	foreach(lc, MyProcPort->guc_options)
+	{
+		char	   *str = lfirst(lc);
+
+		appendBinaryStringInfo(&buf, str, strlen(str) + 1);
+	}
+	/* option names are never empty, so this terminates the list */
+	appendBinaryStringInfo(&buf, "", 1);
+
+	conninfo_len = EstimateClientConnectionInfoSpace();
+	enlargeStringInfo(&buf, conninfo_len);
+	SerializeClientConnectionInfo(conninfo_len, buf.data + buf.len);
+	buf.len += conninfo_len;
+
+	my_startup_data = buf.data;
+	my_startup_len = buf.len;
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Inverse of build_startup_data().  The caller has switched to
+ * TopMemoryContext.
+ */
+static void
+restore_startup_data(Port *port, const char *data, uint32 len)
+{
+	const char *p = data;
+
+	memcpy(&port->proto, p, sizeof(ProtocolVersion));
+	p += sizeof(ProtocolVersion);
+	FrontendProtocol = port->proto;
+
+	port->database_name = pstrdup(p);
+	p += strlen(p) + 1;
+	port->user_name = pstrdup(p);
+	p += strlen(p) + 1;
+	port->cmdline_options = (*p != '\0') ? pstrdup(p) : NULL;
+	p += strlen(p) + 1;
+
+	port->guc_options = NIL;
+	while (*p != '\0')
+	{
+		const char *name = p;
+		const char *value = p + strlen(name) + 1;
+
+		port->guc_options = lappend(port->guc_options, pstrdup(name));
+		port->guc_options = lappend(port->guc_options, pstrdup(value));
+		if (strcmp(name, "application_name") == 0)
+			port->application_name = pg_clean_ascii(value, 0);
+
+		p = value + strlen(value) + 1;
+	}
+	p++;
+
+	Assert(p < data + len);
+	RestoreClientConnectionInfo(unconstify(char *, p));
+}
+
+/*
+ * Does the session hold state that would be lost if another backend took
+ * it over?  Only called between transactions.
+ */
+static bool
+session_is_pinned(void)
+{
+	Oid			tempNamespaceId;
+	Oid			tempToastNamespaceId;
+
+	GetTempNamespaceState(&tempNamespaceId, &tempToastNamespaceId);
+	if (OidIsValid(tempNamespaceId))
+		return true;
+
+	return PreparedStatementsExist() ||
+		UnnamedStatementExists() ||
+		!ThereAreNoPortals() ||
+		SequenceValuesExist() ||
+		GUCSessionSettingsExist() ||
+		LockHeldBySession() ||
+		Async_IsListening() ||
+		replorigin_session_origin != InvalidRepOriginId ||
+		MyReplicationSlot != NULL;
+}
+
+/*
+ * Is there input from the client that we haven't read yet?
+ */
+static bool
+client_data_pending(void)
+{
+	char		c;
+	ssize_t		rc;
+
+	rc = recv(MyProcPort->sock, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+
+	/* treat EOF and errors like input; reading it will report them */
+	return rc != -1 || (errno != EAGAIN && errno != EWOULDBLOCK);
+}
+
+static void
+send_to_postmaster(SessionPoolMsgType type, pgsocket sock)
+{
+	char		buf[SESSION_POOL_MAX_MSG];
+	SessionPoolMsg msg;
+	size_t		len = sizeof(msg);
+
+	msg.type = type;
+	msg.pid = MyProcPid;
+	msg.pool_key = my_pool_key;
+	msg.pool_size = session_pool_size;
+	memcpy(buf, &msg, sizeof(msg));
+
+	if (type == SP_MSG_PARK)
+	{
+		cur_session.startup_len = my_startup_len;
+		memcpy(buf + len, &cur_session, sizeof(cur_session));
+		len += sizeof(cur_session);
+		memcpy(buf + len, my_startup_data, my_startup_len);
+		len += my_startup_len;
+	}
+
+	if (!send_with_socket(pool_inbox[1], buf, len, sock, 0))
+		ereport(FATAL,
+				(errcode_for_socket_access(),
+				 errmsg("could not send message to session pool: %m")));
+}
+
+/*
+ * Wait for the postmaster to give us a session.  We've no client meanwhile,
+ * so we must not try to send anything to one.
+ */
+static void
+wait_for_session(void)
+{
+	char		buf[SESSION_POOL_MAX_MSG];
+
+	whereToSendOutput = DestNone;
+	set_ps_display("idle in session pool");
+
+	for (;;)
+	{
+		SessionPoolMsg msg;
+		pgsocket	sock;
+		ssize_t		len;
+
+		len = receive_with_socket(MyPoolChannel, buf, sizeof(buf), &sock);
+		if (len < 0)
+			ereport(FATAL,
+					(errcode_for_socket_access(),
+					 errmsg("could not receive message from session pool: %m")));
+
+		if (len > 0)
+		{
+			memcpy(&msg, buf, sizeof(msg));
+			if (msg.type == SP_MSG_EXIT)
+			{
+				if (sock != PGINVALID_SOCKET)
+					closesocket(sock);
+				proc_exit(0);
+			}
+			if (msg.type != SP_MSG_ASSIGN || sock == PGINVALID_SOCKET)
+				elog(FATAL, "unexpected message from session pool");
+
+			if (take_session(sock, buf + sizeof(msg), len - sizeof(msg)))
+				break;
+
+			/* the client was gone already; we're idle again */
+			send_to_postmaster(SP_MSG_IDLE, PGINVALID_SOCKET);
+			continue;
+		}
+
+		(void) WaitLatchOrSocket(MyLatch,
+								 WL_LATCH_SET | WL_SOCKET_READABLE |
+								 WL_EXIT_ON_PM_DEATH,
+								 MyPoolChannel, -1L,
+								 WAIT_EVENT_SESSION_POOL_IDLE);
+		ResetLatch(MyLatch);
+
+		/* handles die and sinval catchup, like waiting for client input */
+		ProcessClientReadInterrupt(true);
+
+		if (ConfigReloadPending)
+		{
+			ConfigReloadPending = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+	}
+
+	whereToSendOutput = DestRemote;
+	set_ps_display("idle");
+}
+
+/*
+ * Attach to a session that the postmaster passed to us.  Returns false if
+ * its client has disconnected in the meantime.
+ */
+static bool
+take_session(pgsocket sock, char *data, size_t len)
+{
+	SessionDescriptor desc;
+	ClientSocket client_sock;
+	char		remote_host[NI_MAXHOST];
+	char		remote_port[NI_MAXSERV];
+	Port	   *port = MyProcPort;
+
+	if (len < sizeof(desc))
+		elog(FATAL, "invalid session descriptor from session pool");
+	memcpy(&desc, data, sizeof(desc));
+
+	/* sessions only go to backends of their own pool */
+	if (len != sizeof(desc) + desc.startup_len ||
+		desc.startup_len != my_startup_len ||
+		memcmp(data + sizeof(desc), my_startup_data, my_startup_len) != 0)
+		elog(FATAL, "session from session pool does not match this backend");
+
+	cur_session = desc;
+
+	client_sock.sock = sock;
+	client_sock.raddr.salen = sizeof(client_sock.raddr.addr);
+	if (getpeername(sock, (struct sockaddr *) &client_sock.raddr.addr,
+					&client_sock.raddr.salen) < 0)
+	{
+		closesocket(sock);
+		free_cancel_slot();
+		return false;
+	}
+
+	pq_attach_client(&client_sock);
+
+	remote_host[0] = '\0';
+	remote_port[0] = '\0';
+	(void) pg_getnameinfo_all(&port->raddr.addr, port->raddr.salen,
+							  remote_host, sizeof(remote_host),
+							  remote_port, sizeof(remote_port),
+							  NI_NUMERICHOST | NI_NUMERICSERV);
+	port->remote_host = MemoryContextStrdup(TopMemoryContext, remote_host);
+	port->remote_port = MemoryContextStrdup(TopMemoryContext, remote_port);
+	port->remote_hostname = NULL;
+
+	set_cancel_backend(MyProcPid);
+	pgstat_report_client_session(cur_session.session_pid);
+
+	return true;
+}
+
+/*
+ * Claim an entry in the cancel key table for the current session.
+ */
+static bool
+claim_cancel_slot(void)
+{
+	for (int i = 0; i < NumSessionCancelKeys(); i++)
+	{
+		SessionCancelKey *entry = &SessionCancelKeys[i];
+		bool		claimed = false;
+
+		if (entry->session_pid != 0)
+			continue;
+
+		SpinLockAcquire(&entry->mutex);
+		if (entry->session_pid == 0)
+		{
+			entry->session_pid = cur_session.session_pid;
+			entry->cancel_key = cur_session.cancel_key;
+			entry->backend_pid = MyProcPid;
+			claimed = true;
+		}
+		SpinLockRelease(&entry->mutex);
+
+		if (claimed)
+		{
+			cur_session.cancel_slot = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void
+set_cancel_backend(pid_t backend_pid)
+{
+	SessionCancelKey *entry;
+
+	if (cur_session.cancel_slot < 0)
+		return;
+
+	entry = &SessionCancelKeys[cur_session.cancel_slot];
+	SpinLockAcquire(&entry->mutex);
+	Assert(entry->session_pid == cur_session.session_pid);
+	entry->backend_pid = backend_pid;
+	SpinLockRelease(&entry->mutex);
+}
+
+static void
+free_cancel_slot(void)
+{
+	SessionCancelKey *entry;
+
+	if (cur_session.cancel_slot < 0)
+		return;
+
+	entry = &SessionCancelKeys[cur_session.cancel_slot];
+	SpinLockAcquire(&entry->mutex);
+	entry->session_pid = 0;
+	entry->cancel_key = 0;
+	entry->backend_pid = 0;
+	SpinLockRelease(&entry->mutex);
+
+	cur_session.cancel_slot = -1;
+}
+
+/*
+ * When a pooled backend exits, the session it serves ends with it.
+ */
+static void
+session_pool_shmem_exit(int code, Datum arg)
+{
+	free_cancel_slot();
+}
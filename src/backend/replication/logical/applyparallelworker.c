@@ -43,6 +43,40 @@
  * XXX This worker pool threshold is arbitrary and we can provide a GUC
  * variable for this in the future if required.
  *
+ * Committed transactions
+ * ----------------------
+ * For subscriptions that have set their 'parallel_apply' option, the leader
+ * apply worker also hands over non-streamed transactions to the workers of
+ * the pool, as soon as their BEGIN is received (see pa_dispatch_begin()).
+ * The whole pool is kept in that case, and up to
+ * max_parallel_apply_workers_per_subscription such transactions are applied
+ * at a time.
+ *
+ * To avoid the failures and deadlocks described above, the leader tracks
+ * which rows each transaction changes, identified by the relation and the
+ * values of its replica identity key, in a fixed-size table of the most
+ * recent transaction that changed each (hashed) key. When a change touches a
+ * key that an earlier transaction still in progress has changed, the leader
+ * asks the worker to wait for that transaction to commit before applying the
+ * change (see pa_dispatch_wait_for()). Hash collisions only add spurious
+ * waits. Changes that cannot be tied to a key (REPLICA IDENTITY FULL, or an
+ * unchanged toasted key column) wait for all earlier changes of the relation,
+ * and TRUNCATE waits for all earlier transactions.
+ *
+ * Commit order is always preserved: each worker waits for the transaction
+ * handed over just before its own to commit before committing. This is what
+ * lets the leader report progress to the publisher as a single LSN, and the
+ * replication origin of each worker is only ever advanced forwards. Streamed
+ * and two-phase transactions, and transactions that are skipped or cannot
+ * be handed over, are applied only after all earlier ones have committed.
+ *
+ * A worker waiting for another one goes through the lmgr transaction lock
+ * described below, so that deadlocks that are not caused by the dependencies
+ * known to the leader (e.g. due to a unique index that only exists on the
+ * subscriber) are detected. Since the leader never waits for a worker while
+ * holding a lock, it uses a blocking write to send the changes of these
+ * transactions.
+ *
  * The leader apply worker will create a separate dynamic shared memory segment
  * when each parallel apply worker starts. The reason for this design is that
  * we cannot predict how many workers will be needed. It may be possible to
@@ -157,6 +191,8 @@
 
 #include "postgres.h"
 
+#include "catalog/pg_class.h"
+#include "common/hashfn.h"
 #include "libpq/pqformat.h"
 #include "libpq/pqmq.h"
 #include "pgstat.h"
@@ -209,6 +245,19 @@
 #define PARALLEL_APPLY_LOCK_STREAM	0
 #define PARALLEL_APPLY_LOCK_XACT	1
 
+/*
+ * Message sent by the leader apply worker to make a parallel apply worker
+ * wait for an earlier committed transaction; see pa_dispatch_wait_for().
+ */
+#define PARALLEL_APPLY_MSG_WAIT		'D'
+
+/*
+ * Number of entries in the table of replica identity keys changed by the
+ * committed transactions handed over to parallel apply workers.  Must be a
+ * power of 2.
+ */
+#define PA_KEY_TABLE_SIZE	(1 << 18)
+
 /*
  * Hash table entry to map xid to the parallel apply worker state.
  */
@@ -224,6 +273,65 @@ typedef struct ParallelApplyWorkerEntry
  */
 static HTAB *ParallelApplyTxnHash = NULL;
 
+/*
+ * Hash table entry to track the changes to a remote relation made by the
+ * committed transactions handed over to parallel apply workers.
+ *
+ * Transactions are identified by their dispatch sequence number (see
+ * ParallelApplyWorkerInfo).
+ */
+typedef struct ParallelApplyRelEntry
+{
+	LogicalRepRelId relid;		/* Hash key -- must be first */
+	uint32		version;		/* bumped on each RELATION message */
+	uint64		last_seq;		/* last transaction that changed the relation */
+	uint64		whole_seq;		/* last transaction that changed rows not
+								 * identified by a key */
+} ParallelApplyRelEntry;
+
+/*
+ * Hash table entry to remember which version of a remote relation has been
+ * sent to a parallel apply worker.
+ */
+typedef struct ParallelApplyRelVersion
+{
+	LogicalRepRelId relid;		/* Hash key -- must be first */
+	uint32		version;
+} ParallelApplyRelVersion;
+
+static HTAB *ParallelApplyRelHash = NULL;
+
+/*
+ * For each (hashed) replica identity key, the last committed transaction
+ * handed over to a parallel apply worker that changed it.
+ */
+static uint64 *ParallelApplyKeyTable = NULL;
+
+/*
+ * The committed transactions handed over to parallel apply workers that have
+ * not been released yet, in commit order.
+ */
+static List *DispatchedXacts = NIL;
+
+/* The worker the changes of the current remote transaction are sent to. */
+static ParallelApplyWorkerInfo *dispatch_worker = NULL;
+
+/* Dispatch sequence number of the last transaction handed over. */
+static uint64 last_dispatch_seq = 0;
+
+/*
+ * The last transaction that the current one has been made to wait for, and
+ * the last one that all later transactions must wait for.
+ */
+static uint64 dispatch_waited_seq = 0;
+static uint64 dispatch_barrier_seq = 0;
+
+/*
+ * In a parallel apply worker, the slot of the leader apply worker, which
+ * holds the end LSN of the last committed transaction applied in parallel.
+ */
+static LogicalRepWorker *MyLeaderWorker = NULL;
+
 /*
 * A list (pool) of active parallel apply workers. The information for
 * the new worker is added to the list after successfully launching it. The
@@ -254,6 +362,16 @@ static ParallelApplyWorkerInfo *stream_apply_worker = NULL;
 /* A list to maintain subtransactions, if any. */
 static List *subxactlist = NIL;
 
+static void pa_assign_worker(ParallelApplyWorkerInfo *winfo, TransactionId xid);
+static void pa_release_dispatched_xact(ParallelApplyWorkerInfo *winfo);
+static void pa_send_dispatch_data(ParallelApplyWorkerInfo *winfo, Size nbytes,
+								  const void *data);
+static ParallelApplyRelEntry *pa_get_rel_entry(LogicalRepRelId relid);
+static ParallelApplyRelEntry *pa_dispatch_relation(LogicalRepRelId relid);
+static void pa_dispatch_wait_for(uint64 seq);
+static void pa_dispatch_tuple(ParallelApplyRelEntry *rentry,
+							  LogicalRepTupleData *tuple);
+static void pa_wait_for_dispatched_xact(TransactionId xid, XLogRecPtr end_lsn);
 static void pa_free_worker_info(ParallelApplyWorkerInfo *winfo);
 static ParallelTransState pa_get_xact_state(ParallelApplyWorkerShared *wshared);
 static PartialFileSetState pa_get_fileset_state(void);
@@ -469,9 +587,7 @@ pa_launch_parallel_worker(void)
 void
 pa_allocate_worker(TransactionId xid)
 {
-	bool		found;
 	ParallelApplyWorkerInfo *winfo = NULL;
-	ParallelApplyWorkerEntry *entry;
 
 	if (!pa_can_start())
 		return;
@@ -480,6 +596,18 @@ pa_allocate_worker(TransactionId xid)
 	if (!winfo)
 		return;
 
+	pa_assign_worker(winfo, xid);
+}
+
+/*
+ * Assign the given available worker to the specified xid.
+ */
+static void
+pa_assign_worker(ParallelApplyWorkerInfo *winfo, TransactionId xid)
+{
+	bool		found;
+	ParallelApplyWorkerEntry *entry;
+
 	/* First time through, initialize parallel apply worker state hashtable. */
 	if (!ParallelApplyTxnHash)
 	{
@@ -504,10 +632,14 @@ pa_allocate_worker(TransactionId xid)
 	SpinLockAcquire(&winfo->shared->mutex);
 	winfo->shared->xact_state = PARALLEL_TRANS_UNKNOWN;
 	winfo->shared->xid = xid;
+	winfo->shared->prev_xid = InvalidTransactionId;
+	winfo->shared->prev_end_lsn = InvalidXLogRecPtr;
 	SpinLockRelease(&winfo->shared->mutex);
 
 	winfo->in_use = true;
 	winfo->serialize_changes = false;
+	winfo->dispatch_seq = 0;
+	winfo->dispatch_end_lsn = InvalidXLogRecPtr;
 	entry->winfo = winfo;
 }
 
@@ -563,7 +695,9 @@ pa_free_worker(ParallelApplyWorkerInfo *winfo)
 		elog(ERROR, "hash table corrupted");
 
 	/*
-	 * Stop the worker if there are enough workers in the pool.
+	 * Stop the worker if there are enough workers in the pool. All the
+	 * workers are kept when committed transactions are applied in parallel
+	 * too, as they are then needed all the time.
 	 *
 	 * XXX Additionally, we also stop the worker if the leader apply worker
 	 * serialize part of the transaction data due to a send timeout. This is
@@ -575,7 +709,9 @@ pa_free_worker(ParallelApplyWorkerInfo *winfo)
 	 */
 	if (winfo->serialize_changes ||
 		list_length(ParallelApplyWorkerPool) >
-		(max_parallel_apply_workers_per_subscription / 2))
+		(MySubscription->parallelapply ?
+		 max_parallel_apply_workers_per_subscription :
+		 max_parallel_apply_workers_per_subscription / 2))
 	{
 		logicalrep_pa_worker_stop(winfo);
 		pa_free_worker_info(winfo);
@@ -609,6 +745,9 @@ pa_free_worker_info(ParallelApplyWorkerInfo *winfo)
 	if (winfo->dsm_seg)
 		dsm_detach(winfo->dsm_seg);
 
+	if (winfo->relversions)
+		hash_destroy(winfo->relversions);
+
 	/* Remove from the worker pool. */
 	ParallelApplyWorkerPool = list_delete_ptr(ParallelApplyWorkerPool, winfo);
 
@@ -777,10 +916,23 @@ LogicalParallelApplyLoop(shm_mq_handle *mqh)
 
 			/*
 			 * The first byte of messages sent from leader apply worker to
-			 * parallel apply workers can only be 'w'.
+			 * parallel apply workers can only be 'w', or 'D' to wait for an
+			 * earlier committed transaction.
 			 */
 			c = pq_getmsgbyte(&s);
-			if (c != 'w')
+			if (c == PARALLEL_APPLY_MSG_WAIT)
+			{
+				TransactionId xid = pq_getmsgint(&s, 4);
+				XLogRecPtr	end_lsn = pq_getmsgint64(&s);
+
+				pq_getmsgend(&s);
+				pa_wait_for_dispatched_xact(xid, end_lsn);
+
+				MemoryContextReset(ApplyMessageContext);
+				MemoryContextSwitchTo(oldcxt);
+				continue;
+			}
+			else if (c != 'w')
 				elog(ERROR, "unexpected message \"%c\"", c);
 
 			/*
@@ -943,6 +1095,12 @@ ParallelApplyWorkerMain(Datum main_arg)
 
 	InitializingApplyWorker = false;
 
+	/* Remember the slot of the leader, see pa_finish_dispatched_xact(). */
+	LWLockAcquire(LogicalRepWorkerLock, LW_SHARED);
+	MyLeaderWorker = logicalrep_worker_find(MyLogicalRepWorker->subid,
+											InvalidOid, false);
+	LWLockRelease(LogicalRepWorkerLock);
+
 	/* Setup replication origin tracking. */
 	StartTransactionCommand();
 	ReplicationOriginNameForLogicalRep(MySubscription->oid, InvalidOid,
@@ -1637,3 +1795,675 @@ pa_xact_finish(ParallelApplyWorkerInfo *winfo, XLogRecPtr remote_lsn)
 
 	pa_free_worker(winfo);
 }
+
+/*
+ * Returns true if the committed transaction that is about to be received can
+ * be handed over to a parallel apply worker, false otherwise.
+ */
+static bool
+pa_can_dispatch(void)
+{
+	ListCell   *lc;
+
+	/* Only leader apply workers can start parallel apply workers. */
+	if (!am_leader_apply_worker())
+		return false;
+
+	/* See pa_can_start(). */
+	maybe_reread_subscription();
+
+	if (!MySubscription->parallelapply)
+		return false;
+
+	/*
+	 * We need to receive the whole transaction to know whether it has to be
+	 * skipped, see pa_can_start().
+	 */
+	if (!XLogRecPtrIsInvalid(MySubscription->skiplsn))
+		return false;
+
+	/*
+	 * Whether to apply the changes for a relation that is not in the READY
+	 * state depends on the commit LSN of the transaction, which is not known
+	 * yet.
+	 */
+	if (!AllTablesyncsReady())
+		return false;
+
+	/*
+	 * Don't hand over committed transactions while a streaming transaction is
+	 * being applied in parallel. Its worker may wait for the leader apply
+	 * worker for the next stream of changes, which the leader would not send
+	 * while blocked on sending changes to a worker that waits for the
+	 * streaming transaction in turn; lmgr cannot detect that.
+	 */
+	foreach(lc, ParallelApplyWorkerPool)
+	{
+		ParallelApplyWorkerInfo *winfo = (ParallelApplyWorkerInfo *) lfirst(lc);
+
+		if (winfo->in_use && winfo->dispatch_seq == 0)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Get a worker to hand over a committed transaction to.
+ *
+ * If all the workers are busy and no more can be started, wait for the
+ * oldest transaction handed over to be applied and reuse its worker.
+ * Returns NULL if no worker can be had.
+ */
+static ParallelApplyWorkerInfo *
+pa_get_dispatch_worker(void)
+{
+	for (;;)
+	{
+		ParallelApplyWorkerInfo *winfo;
+		ListCell   *lc;
+
+		foreach(lc, ParallelApplyWorkerPool)
+		{
+			winfo = (ParallelApplyWorkerInfo *) lfirst(lc);
+
+			if (!winfo->in_use)
+				return winfo;
+		}
+
+		if (list_length(ParallelApplyWorkerPool) <
+			max_parallel_apply_workers_per_subscription)
+		{
+			winfo = pa_launch_parallel_worker();
+			if (winfo)
+				return winfo;
+		}
+
+		if (DispatchedXacts == NIL)
+			return NULL;
+
+		winfo = (ParallelApplyWorkerInfo *) linitial(DispatchedXacts);
+		pa_wait_for_xact_finish(winfo);
+		pa_release_dispatched_xact(winfo);
+	}
+}
+
+/*
+ * Hand over the committed transaction whose BEGIN message is given to a
+ * parallel apply worker, if possible.
+ *
+ * Returns true if the transaction has been handed over, in which case the
+ * rest of its messages must be passed to pa_dispatch_change() and
+ * pa_dispatch_commit().
+ */
+bool
+pa_dispatch_begin(LogicalRepBeginData *begin_data, StringInfo s)
+{
+	ParallelApplyWorkerInfo *winfo;
+	ParallelApplyWorkerInfo *prev = NULL;
+	MemoryContext oldctx;
+
+	Assert(dispatch_worker == NULL);
+
+	/* Take the opportunity to release the workers that are done. */
+	pa_reap_dispatched_xacts();
+
+	if (!pa_can_dispatch())
+		return false;
+
+	winfo = pa_get_dispatch_worker();
+	if (!winfo)
+		return false;
+
+	pa_assign_worker(winfo, begin_data->xid);
+
+	/*
+	 * The worker will wait for the previous transaction to commit before
+	 * committing. Make sure that worker holds its transaction lock first, see
+	 * pa_wait_for_xact_finish().
+	 */
+	if (DispatchedXacts != NIL)
+	{
+		prev = (ParallelApplyWorkerInfo *) llast(DispatchedXacts);
+		pa_wait_for_xact_state(prev, PARALLEL_TRANS_STARTED);
+
+		SpinLockAcquire(&winfo->shared->mutex);
+		winfo->shared->prev_xid = prev->shared->xid;
+		winfo->shared->prev_end_lsn = prev->dispatch_end_lsn;
+		SpinLockRelease(&winfo->shared->mutex);
+	}
+
+	if (ParallelApplyKeyTable == NULL)
+		ParallelApplyKeyTable = (uint64 *)
+			MemoryContextAllocZero(ApplyContext,
+								   PA_KEY_TABLE_SIZE * sizeof(uint64));
+
+	winfo->dispatch_seq = ++last_dispatch_seq;
+	dispatch_waited_seq = 0;
+
+	oldctx = MemoryContextSwitchTo(ApplyContext);
+	DispatchedXacts = lappend(DispatchedXacts, winfo);
+	MemoryContextSwitchTo(oldctx);
+
+	dispatch_worker = winfo;
+
+	pa_send_dispatch_data(winfo, s->len, s->data);
+
+	return true;
+}
+
+/*
+ * Pass on a message of the committed transaction being handed over.
+ *
+ * For the changes, find out which earlier transactions the worker must wait
+ * for first, and make sure it knows the relations involved.
+ */
+void
+pa_dispatch_change(LogicalRepMsgType action, StringInfo s)
+{
+	ParallelApplyWorkerInfo *winfo = dispatch_worker;
+	StringInfoData msg;
+	ParallelApplyRelEntry *rentry;
+	LogicalRepTupleData oldtup;
+	LogicalRepTupleData newtup;
+	LogicalRepRelId relid;
+	bool		has_oldtuple;
+
+	Assert(winfo);
+
+	/* Parse a copy, the message is passed on as is. */
+	msg = *s;
+
+	switch (action)
+	{
+		case LOGICAL_REP_MSG_INSERT:
+			relid = logicalrep_read_insert(&msg, &newtup);
+			rentry = pa_dispatch_relation(relid);
+			pa_dispatch_wait_for(dispatch_barrier_seq);
+			pa_dispatch_tuple(rentry, &newtup);
+			break;
+
+		case LOGICAL_REP_MSG_UPDATE:
+			relid = logicalrep_read_update(&msg, &has_oldtuple, &oldtup,
+										   &newtup);
+			rentry = pa_dispatch_relation(relid);
+			pa_dispatch_wait_for(dispatch_barrier_seq);
+
+			/* The key may have changed, in which case both rows matter. */
+			if (has_oldtuple)
+				pa_dispatch_tuple(rentry, &oldtup);
+			pa_dispatch_tuple(rentry, &newtup);
+			break;
+
+		case LOGICAL_REP_MSG_DELETE:
+			relid = logicalrep_read_delete(&msg, &oldtup);
+			rentry = pa_dispatch_relation(relid);
+			pa_dispatch_wait_for(dispatch_barrier_seq);
+			pa_dispatch_tuple(rentry, &oldtup);
+			break;
+
+		case LOGICAL_REP_MSG_TRUNCATE:
+			{
+				bool		cascade;
+				bool		restart_seqs;
+				List	   *relids;
+				ListCell   *lc;
+
+				relids = logicalrep_read_truncate(&msg, &cascade,
+												  &restart_seqs);
+				foreach(lc, relids)
+					(void) pa_dispatch_relation(lfirst_oid(lc));
+
+				/*
+				 * TRUNCATE can affect other tables on the subscriber, e.g.
+				 * through foreign keys or sequences, so order it against all
+				 * the other transactions.
+				 */
+				if (list_length(DispatchedXacts) > 1)
+				{
+					ParallelApplyWorkerInfo *prev;
+
+					prev = (ParallelApplyWorkerInfo *)
+						list_nth(DispatchedXacts,
+								 list_length(DispatchedXacts) - 2);
+					pa_dispatch_wait_for(prev->dispatch_seq);
+				}
+				dispatch_barrier_seq = winfo->dispatch_seq;
+				break;
+			}
+
+		case LOGICAL_REP_MSG_TYPE:
+		case LOGICAL_REP_MSG_ORIGIN:
+			break;
+
+		default:
+			elog(ERROR, "unexpected logical replication message type %d",
+				 action);
+			break;
+	}
+
+	pa_send_dispatch_data(winfo, s->len, s->data);
+}
+
+/*
+ * Pass on the COMMIT message of the committed transaction being handed over.
+ */
+void
+pa_dispatch_commit(LogicalRepCommitData *commit_data, StringInfo s)
+{
+	ParallelApplyWorkerInfo *winfo = dispatch_worker;
+
+	Assert(winfo);
+
+	winfo->dispatch_end_lsn = commit_data->end_lsn;
+	pa_send_dispatch_data(winfo, s->len, s->data);
+
+	dispatch_worker = NULL;
+}
+
+/*
+ * Is a committed transaction being handed over to a parallel apply worker?
+ */
+bool
+pa_dispatching_xact(void)
+{
+	return dispatch_worker != NULL;
+}
+
+/*
+ * Are there committed transactions handed over to parallel apply workers
+ * that have not been released yet?
+ */
+bool
+pa_have_dispatched_xacts(void)
+{
+	return DispatchedXacts != NIL;
+}
+
+/*
+ * Wait for all the committed transactions handed over to parallel apply
+ * workers to be applied, and release their workers.
+ */
+void
+pa_wait_for_dispatched_xacts(void)
+{
+	Assert(dispatch_worker == NULL);
+
+	while (DispatchedXacts != NIL)
+	{
+		ParallelApplyWorkerInfo *winfo;
+
+		winfo = (ParallelApplyWorkerInfo *) linitial(DispatchedXacts);
+		pa_wait_for_xact_finish(winfo);
+		pa_release_dispatched_xact(winfo);
+	}
+}
+
+/*
+ * Release the workers of the committed transactions that have been applied,
+ * in commit order, without waiting.
+ */
+void
+pa_reap_dispatched_xacts(void)
+{
+	while (DispatchedXacts != NIL)
+	{
+		ParallelApplyWorkerInfo *winfo;
+
+		winfo = (ParallelApplyWorkerInfo *) linitial(DispatchedXacts);
+		if (winfo == dispatch_worker ||
+			pa_get_xact_state(winfo->shared) != PARALLEL_TRANS_FINISHED)
+			break;
+
+		pa_release_dispatched_xact(winfo);
+	}
+}
+
+/*
+ * Note that the description of a remote relation has changed, so that it is
+ * sent again to the parallel apply workers.
+ */
+void
+pa_relation_changed(LogicalRepRelId relid)
+{
+	ParallelApplyRelEntry *rentry = pa_get_rel_entry(relid);
+
+	rentry->version++;
+}
+
+/*
+ * Release the worker of the oldest committed transaction handed over, which
+ * has been applied, and report its progress.
+ */
+static void
+pa_release_dispatched_xact(ParallelApplyWorkerInfo *winfo)
+{
+	MemoryContext oldctx = CurrentMemoryContext;
+
+	Assert(winfo == linitial(DispatchedXacts));
+
+	DispatchedXacts = list_delete_first(DispatchedXacts);
+
+	store_flush_position(winfo->dispatch_end_lsn,
+						 winfo->shared->last_commit_end);
+
+	/* store_flush_position() switches to ApplyMessageContext. */
+	MemoryContextSwitchTo(oldctx);
+
+	pa_free_worker(winfo);
+}
+
+/*
+ * Send data of a committed transaction to a parallel apply worker.
+ *
+ * Unlike pa_send_data(), wait as long as needed for the queue to have room.
+ * The leader apply worker doesn't hold any lock a worker could be waiting
+ * for here, see the comments atop this file.
+ */
+static void
+pa_send_dispatch_data(ParallelApplyWorkerInfo *winfo, Size nbytes,
+					  const void *data)
+{
+	shm_mq_result result;
+
+	result = shm_mq_send(winfo->mq_handle, nbytes, data, false, true);
+
+	if (result != SHM_MQ_SUCCESS)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not send data to shared-memory queue")));
+}
+
+/*
+ * Get the entry of a remote relation, creating it if needed.
+ */
+static ParallelApplyRelEntry *
+pa_get_rel_entry(LogicalRepRelId relid)
+{
+	ParallelApplyRelEntry *rentry;
+	bool		found;
+
+	if (ParallelApplyRelHash == NULL)
+	{
+		HASHCTL		ctl;
+
+		ctl.keysize = sizeof(LogicalRepRelId);
+		ctl.entrysize = sizeof(ParallelApplyRelEntry);
+		ctl.hcxt = ApplyContext;
+
+		ParallelApplyRelHash = hash_create("logical replication parallel apply relations",
+										   128, &ctl,
+										   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	rentry = hash_search(ParallelApplyRelHash, &relid, HASH_ENTER, &found);
+	if (!found)
+	{
+		rentry->version = 0;
+		rentry->last_seq = 0;
+		rentry->whole_seq = 0;
+	}
+
+	return rentry;
+}
+
+/*
+ * Make sure the worker the current transaction is handed over to knows the
+ * latest description of the given remote relation, and return its entry.
+ */
+static ParallelApplyRelEntry *
+pa_dispatch_relation(LogicalRepRelId relid)
+{
+	ParallelApplyWorkerInfo *winfo = dispatch_worker;
+	ParallelApplyRelEntry *rentry = pa_get_rel_entry(relid);
+	ParallelApplyRelVersion *sent;
+	bool		found;
+
+	if (winfo->relversions == NULL)
+	{
+		HASHCTL		ctl;
+
+		ctl.keysize = sizeof(LogicalRepRelId);
+		ctl.entrysize = sizeof(ParallelApplyRelVersion);
+		ctl.hcxt = ApplyContext;
+
+		winfo->relversions = hash_create("logical replication parallel apply relation versions",
+										 128, &ctl,
+										 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	sent = hash_search(winfo->relversions, &relid, HASH_ENTER, &found);
+	if (!found || sent->version != rentry->version)
+	{
+		LogicalRepRelation *remoterel = logicalrep_relmap_get_remoterel(relid);
+
+		/*
+		 * Send the relation as a RELATION message of its own. The statistics
+		 * fields are ignored by the worker.
+		 */
+		if (remoterel)
+		{
+			StringInfoData msg;
+
+			initStringInfo(&msg);
+			pq_sendbyte(&msg, 'w');
+			pq_sendint64(&msg, InvalidXLogRecPtr);
+			pq_sendint64(&msg, InvalidXLogRecPtr);
+			pq_sendint64(&msg, 0);
+			logicalrep_write_remote_rel(&msg, remoterel);
+
+			pa_send_dispatch_data(winfo, msg.len, msg.data);
+			pfree(msg.data);
+		}
+
+		sent->version = rentry->version;
+	}
+
+	return rentry;
+}
+
+/*
+ * Make the worker the current transaction is handed over to wait for the
+ * given earlier transaction to commit before going on.
+ */
+static void
+pa_dispatch_wait_for(uint64 seq)
+{
+	ParallelApplyWorkerInfo *winfo = dispatch_worker;
+	ParallelApplyWorkerInfo *target = NULL;
+	ListCell   *lc;
+	StringInfoData msg;
+
+	/*
+	 * Transactions commit in order, so there is no need to wait for a
+	 * transaction older than one already waited for.
+	 */
+	if (seq <= dispatch_waited_seq || seq >= winfo->dispatch_seq)
+		return;
+
+	dispatch_waited_seq = seq;
+
+	foreach(lc, DispatchedXacts)
+	{
+		ParallelApplyWorkerInfo *w = (ParallelApplyWorkerInfo *) lfirst(lc);
+
+		if (w->dispatch_seq >= seq)
+		{
+			if (w->dispatch_seq == seq)
+				target = w;
+			break;
+		}
+	}
+
+	/* Nothing to do if the transaction has been released already. */
+	if (target == NULL)
+		return;
+
+	initStringInfo(&msg);
+	pq_sendbyte(&msg, PARALLEL_APPLY_MSG_WAIT);
+	pq_sendint32(&msg, target->shared->xid);
+	pq_sendint64(&msg, target->dispatch_end_lsn);
+
+	pa_send_dispatch_data(winfo, msg.len, msg.data);
+	pfree(msg.data);
+}
+
+/*
+ * Record that the current transaction changes the given row of a relation,
+ * waiting for the earlier transactions that changed it first.
+ */
+static void
+pa_dispatch_tuple(ParallelApplyRelEntry *rentry, LogicalRepTupleData *tuple)
+{
+	uint64		seq = dispatch_worker->dispatch_seq;
+	LogicalRepRelation *remoterel;
+	uint64		hash;
+	uint64	   *slot;
+	int			attnum;
+
+	remoterel = logicalrep_relmap_get_remoterel(rentry->relid);
+
+	/* Without a key, rows can only be matched by comparing all columns. */
+	if (remoterel == NULL || remoterel->replident == REPLICA_IDENTITY_FULL)
+	{
+		pa_dispatch_wait_for(rentry->last_seq);
+		rentry->last_seq = rentry->whole_seq = seq;
+		return;
+	}
+
+	/*
+	 * Rows of a relation without replica identity can only be inserted, so
+	 * they don't depend on each other.
+	 */
+	if (bms_is_empty(remoterel->attkeys))
+	{
+		pa_dispatch_wait_for(rentry->whole_seq);
+		rentry->last_seq = seq;
+		return;
+	}
+
+	hash = (uint64) rentry->relid;
+	attnum = -1;
+	while ((attnum = bms_next_member(remoterel->attkeys, attnum)) >= 0)
+	{
+		StringInfo	value;
+
+		/* The value of an unchanged toasted key column is not known. */
+		if (attnum >= tuple->ncols ||
+			tuple->colstatus[attnum] == LOGICALREP_COLUMN_UNCHANGED)
+		{
+			pa_dispatch_wait_for(rentry->last_seq);
+			rentry->last_seq = rentry->whole_seq = seq;
+			return;
+		}
+
+		if (tuple->colstatus[attnum] == LOGICALREP_COLUMN_NULL)
+		{
+			hash = hash_combine64(hash, 0);
+			continue;
+		}
+
+		value = &tuple->colvalues[attnum];
+		hash = hash_combine64(hash,
+							  hash_bytes_extended((unsigned char *) value->data,
+												  value->len, 0));
+	}
+
+	pa_dispatch_wait_for(rentry->whole_seq);
+
+	slot = &ParallelApplyKeyTable[hash & (PA_KEY_TABLE_SIZE - 1)];
+	pa_dispatch_wait_for(*slot);
+	*slot = seq;
+
+	rentry->last_seq = seq;
+}
+
+/*
+ * Start applying a committed transaction handed over by the leader apply
+ * worker.
+ */
+void
+pa_begin_dispatched_xact(void)
+{
+	Assert(am_parallel_apply_worker());
+
+	/*
+	 * Hold the transaction lock until the transaction is committed, so that
+	 * the leader and the workers applying later transactions can wait for
+	 * it.
+	 */
+	pa_lock_transaction(MyParallelShared->xid, AccessExclusiveLock);
+	pa_set_xact_state(MyParallelShared, PARALLEL_TRANS_STARTED);
+
+	logicalrep_worker_wakeup(MyLogicalRepWorker->subid, InvalidOid);
+}
+
+/*
+ * Wait for the committed transaction handed over just before the one being
+ * applied to commit, to preserve commit order.
+ */
+void
+pa_wait_for_preceding_xact(void)
+{
+	TransactionId xid;
+	XLogRecPtr	end_lsn;
+
+	Assert(am_parallel_apply_worker());
+
+	SpinLockAcquire(&MyParallelShared->mutex);
+	xid = MyParallelShared->prev_xid;
+	end_lsn = MyParallelShared->prev_end_lsn;
+	SpinLockRelease(&MyParallelShared->mutex);
+
+	if (TransactionIdIsValid(xid))
+		pa_wait_for_dispatched_xact(xid, end_lsn);
+}
+
+/*
+ * Finish applying a committed transaction handed over by the leader apply
+ * worker.
+ */
+void
+pa_finish_dispatched_xact(XLogRecPtr end_lsn)
+{
+	Assert(am_parallel_apply_worker());
+
+	MyParallelShared->last_commit_end = XactLastCommitEnd;
+
+	/* Let the workers waiting for this transaction check it was committed. */
+	if (MyLeaderWorker)
+		pg_atomic_write_u64(&MyLeaderWorker->parallel_commit_lsn, end_lsn);
+
+	pa_set_xact_state(MyParallelShared, PARALLEL_TRANS_FINISHED);
+	pa_unlock_transaction(MyParallelShared->xid, AccessExclusiveLock);
+
+	logicalrep_worker_wakeup(MyLogicalRepWorker->subid, InvalidOid);
+}
+
+/*
+ * Wait for an earlier committed transaction handed over to another parallel
+ * apply worker to commit.
+ */
+static void
+pa_wait_for_dispatched_xact(TransactionId xid, XLogRecPtr end_lsn)
+{
+	/*
+	 * The leader apply worker made sure the other worker holds the
+	 * transaction lock. Waiting on it lets lmgr detect deadlocks, see the
+	 * comments atop this file.
+	 */
+	pa_lock_transaction(xid, AccessShareLock);
+	pa_unlock_transaction(xid, AccessShareLock);
+
+	/*
+	 * The lock is released too if the other worker failed, in which case we
+	 * must not go on.
+	 */
+	if (MyLeaderWorker == NULL ||
+		pg_atomic_read_u64(&MyLeaderWorker->parallel_commit_lsn) < end_lsn)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("logical replication parallel apply worker for subscription \"%s\" cannot wait for remote transaction %u",
+						MySubscription->name, xid),
+				 errdetail("The parallel apply worker applying that transaction exited.")));
+}
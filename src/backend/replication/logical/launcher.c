@@ -444,6 +444,7 @@ retry:
 	worker->stream_fileset = NULL;
 	worker->leader_pid = is_parallel_apply_worker ? MyProcPid : InvalidPid;
 	worker->parallel_apply = is_parallel_apply_worker;
+	pg_atomic_write_u64(&worker->parallel_commit_lsn, InvalidXLogRecPtr);
 	worker->last_lsn = InvalidXLogRecPtr;
 	TIMESTAMP_NOBEGIN(worker->last_send_time);
 	TIMESTAMP_NOBEGIN(worker->last_recv_time);
@@ -976,6 +977,8 @@ ApplyLauncherShmemInit(void)
 
 			memset(worker, 0, sizeof(LogicalRepWorker));
 			SpinLockInit(&worker->relmutex);
+			pg_atomic_init_u64(&worker->parallel_commit_lsn,
+							   InvalidXLogRecPtr);
 		}
 	}
 }
@@ -716,6 +716,40 @@ logicalrep_read_rel(StringInfo in)
 	return rel;
 }
 
+/*
+ * Write a RELATION message for a relation description received earlier.
+ *
+ * This is used by the leader apply worker to pass on the relation
+ * descriptions to parallel apply workers.  The attribute type modifiers are
+ * not kept by the subscriber, so -1 is sent for them.
+ */
+void
+logicalrep_write_remote_rel(StringInfo out, LogicalRepRelation *rel)
+{
+	int			i;
+
+	pq_sendbyte(out, LOGICAL_REP_MSG_RELATION);
+
+	pq_sendint32(out, rel->remoteid);
+	pq_sendstring(out, rel->nspname);
+	pq_sendstring(out, rel->relname);
+	pq_sendbyte(out, rel->replident);
+
+	pq_sendint16(out, rel->natts);
+	for (i = 0; i < rel->natts; i++)
+	{
+		uint8		flags = 0;
+
+		if (bms_is_member(i, rel->attkeys))
+			flags |= LOGICALREP_IS_REPLICA_IDENTITY;
+
+		pq_sendbyte(out, flags);
+		pq_sendstring(out, rel->attnames[i]);
+		pq_sendint32(out, (int) rel->atttyps[i]);
+		pq_sendint32(out, -1);
+	}
+}
+
 /*
  * Write type info to the output stream.
  *
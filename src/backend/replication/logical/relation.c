@@ -200,6 +200,23 @@ logicalrep_relmap_update(LogicalRepRelation *remoterel)
 	MemoryContextSwitchTo(oldctx);
 }
 
+/*
+ * Return the cached description of the given remote relation, or NULL if the
+ * publisher has not sent one yet.
+ */
+LogicalRepRelation *
+logicalrep_relmap_get_remoterel(LogicalRepRelId remoteid)
+{
+	LogicalRepRelMapEntry *entry;
+
+	if (LogicalRepRelMap == NULL)
+		return NULL;
+
+	entry = hash_search(LogicalRepRelMap, &remoteid, HASH_FIND, NULL);
+
+	return entry ? &entry->remoterel : NULL;
+}
+
 /*
  * Find attribute index in TupleDesc struct by attribute name.
  *
@@ -82,12 +82,26 @@
  *	  a bit more memory to the oldest subtransactions, because it's likely
  *	  they are the source for the next sequence of changes.
  *
+ *	  If logical_decoding_spill_compression is set, the changes spilled to
+ *	  disk are gathered in blocks of about SPILL_BLOCK_SIZE bytes that are
+ *	  compressed as a whole, as individual changes are usually too small to
+ *	  compress well. A block is written in place of its changes, preceded by
+ *	  a ReorderBufferDiskBlock header that cannot be mistaken for that of a
+ *	  change, so blocks and uncompressed changes can be mixed in a file.
+ *	  Blocks are decompressed one at a time as the changes are restored.
+ *
  * -------------------------------------------------------------------------
  */
 #include "postgres.h"
 
 #include <unistd.h>
 #include <sys/stat.h>
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 
 #include "access/detoast.h"
 #include "access/heapam.h"
@@ -96,6 +110,7 @@
 #include "access/xact.h"
 #include "access/xlog_internal.h"
 #include "catalog/catalog.h"
+#include "common/compression.h"
 #include "common/int.h"
 #include "lib/binaryheap.h"
 #include "miscadmin.h"
@@ -140,6 +155,10 @@ typedef struct TXNEntryFile
 	File		vfd;			/* -1 when the file is closed */
 	off_t		curOffset;		/* offset for next write or read. Reset to 0
 								 * when vfd is opened. */
+	char	   *block;			/* decompressed block of changes, if any */
+	Size		blocksize;		/* allocated size of block */
+	Size		blocklen;		/* length of the decompressed block */
+	Size		blockpos;		/* offset of next read in block */
 } TXNEntryFile;
 
 /* k-way in-order change iteration support structures */
@@ -181,6 +200,21 @@ typedef struct ReorderBufferDiskChange
 	/* data follows */
 } ReorderBufferDiskChange;
 
+/*
+ * Header of a compressed block of changes. The marker overlays the size of a
+ * ReorderBufferDiskChange, which is never zero.
+ */
+typedef struct ReorderBufferDiskBlock
+{
+	Size		marker;			/* always 0 */
+	uint32		method;			/* pg_compress_algorithm */
+	uint32		rawsize;		/* size of the changes in the block */
+	uint32		compsize;		/* size of the compressed data that follows */
+} ReorderBufferDiskBlock;
+
+/* Size of the blocks of spilled changes to compress */
+#define SPILL_BLOCK_SIZE	(8 * BLCKSZ)
+
 #define IsSpecInsert(action) \
 ( \
 	((action) == REORDER_BUFFER_CHANGE_INTERNAL_SPEC_INSERT) \
@@ -212,6 +246,9 @@ typedef struct ReorderBufferDiskChange
 int			logical_decoding_work_mem;
 static const Size max_changes_in_memory = 4096; /* XXX for restore only */
 
+/* GUC variable */
+int			logical_decoding_spill_compression = PG_COMPRESSION_NONE;
+
 /* GUC variable */
 int			debug_logical_replication_streaming = DEBUG_LOGICAL_REP_STREAMING_BUFFERED;
 
@@ -253,6 +290,14 @@ static void ReorderBufferCheckMemoryLimit(ReorderBuffer *rb);
 static void ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
 static void ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 										 int fd, ReorderBufferChange *change);
+static void ReorderBufferSpillWrite(ReorderBuffer *rb, ReorderBufferTXN *txn,
+									int fd, char *data, Size len);
+static void ReorderBufferSpillFlush(ReorderBuffer *rb, ReorderBufferTXN *txn,
+									int fd);
+static void ReorderBufferWriteSpillFile(ReorderBuffer *rb, ReorderBufferTXN *txn,
+										int fd, char *data, Size len);
+static int	ReorderBufferSpillRead(ReorderBuffer *rb, TXNEntryFile *file,
+								   char *buf, Size len, bool start);
 static Size ReorderBufferRestoreChanges(ReorderBuffer *rb, ReorderBufferTXN *txn,
 										TXNEntryFile *file, XLogSegNo *segno);
 static void ReorderBufferRestoreChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
@@ -364,6 +409,12 @@ ReorderBufferAllocate(void)
 
 	buffer->outbuf = NULL;
 	buffer->outbufsize = 0;
+	buffer->spillbuf = NULL;
+	buffer->spillbufsize = 0;
+	buffer->spillbuflen = 0;
+	buffer->compressbuf = NULL;
+	buffer->compressbufsize = 0;
+	buffer->spill_compression = PG_COMPRESSION_NONE;
 	buffer->size = 0;
 
 	/* txn_heap is ordered by transaction size */
@@ -372,6 +423,7 @@ ReorderBufferAllocate(void)
 	buffer->spillTxns = 0;
 	buffer->spillCount = 0;
 	buffer->spillBytes = 0;
+	buffer->spillWrittenBytes = 0;
 	buffer->streamTxns = 0;
 	buffer->streamCount = 0;
 	buffer->streamBytes = 0;
@@ -1488,6 +1540,8 @@ ReorderBufferIterTXNFinish(ReorderBuffer *rb,
 	{
 		if (state->entries[off].file.vfd != -1)
 			FileClose(state->entries[off].file.vfd);
+		if (state->entries[off].file.block)
+			pfree(state->entries[off].file.block);
 	}
 
 	/* free memory we might have "leaked" in the last *Next call */
@@ -3728,6 +3782,10 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 		ReorderBufferSerializeTXN(rb, subtxn);
 	}
 
+	/* Stick to one compression method for the whole spill */
+	rb->spill_compression = logical_decoding_spill_compression;
+	rb->spillbuflen = 0;
+
 	/* serialize changestream */
 	dlist_foreach_modify(change_i, &txn->changes)
 	{
@@ -3744,8 +3802,12 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 		{
 			char		path[MAXPGPATH];
 
+			/* blocks don't span files */
 			if (fd != -1)
+			{
+				ReorderBufferSpillFlush(rb, txn, fd);
 				CloseTransientFile(fd);
+			}
 
 			XLByteToSeg(change->lsn, curOpenSegNo, wal_segment_size);
 
@@ -3773,6 +3835,9 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 		spilled++;
 	}
 
+	if (fd != -1)
+		ReorderBufferSpillFlush(rb, txn, fd);
+
 	/* Update the memory counter */
 	ReorderBufferChangeMemoryUpdate(rb, NULL, txn, false, size);
 
@@ -3984,9 +4049,148 @@ ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 
 	ondisk->size = sz;
 
+	ReorderBufferSpillWrite(rb, txn, fd, rb->outbuf, ondisk->size);
+
+	/*
+	 * Keep the transaction's final_lsn up to date with each change we send to
+	 * disk, so that ReorderBufferRestoreCleanup works correctly.  (We used to
+	 * only do this on commit and abort records, but that doesn't work if a
+	 * system crash leaves a transaction without its abort record).
+	 *
+	 * Make sure not to move it backwards.
+	 */
+	if (txn->final_lsn < change->lsn)
+		txn->final_lsn = change->lsn;
+
+	Assert(ondisk->change.action == change->action);
+}
+
+/*
+ * Write a serialized change to a spill file, or add it to the block of
+ * changes to compress.
+ */
+static void
+ReorderBufferSpillWrite(ReorderBuffer *rb, ReorderBufferTXN *txn, int fd,
+						char *data, Size len)
+{
+	if (rb->spill_compression == PG_COMPRESSION_NONE)
+	{
+		ReorderBufferWriteSpillFile(rb, txn, fd, data, len);
+		return;
+	}
+
+	/* Changes are never split across blocks */
+	if (rb->spillbuflen > 0 && rb->spillbuflen + len > SPILL_BLOCK_SIZE)
+		ReorderBufferSpillFlush(rb, txn, fd);
+
+	if (rb->spillbufsize < rb->spillbuflen + len)
+	{
+		Size		newsize = Max(SPILL_BLOCK_SIZE, rb->spillbuflen + len);
+
+		if (rb->spillbuf == NULL)
+			rb->spillbuf = MemoryContextAlloc(rb->context, newsize);
+		else
+			rb->spillbuf = repalloc(rb->spillbuf, newsize);
+		rb->spillbufsize = newsize;
+	}
+
+	memcpy(rb->spillbuf + rb->spillbuflen, data, len);
+	rb->spillbuflen += len;
+}
+
+/*
+ * Compress the block of changes gathered by ReorderBufferSpillWrite() and
+ * write it to the spill file.
+ *
+ * If the block doesn't compress, its changes are written as they are.
+ */
+static void
+ReorderBufferSpillFlush(ReorderBuffer *rb, ReorderBufferTXN *txn, int fd)
+{
+	ReorderBufferDiskBlock *block;
+	Size		rawsize = rb->spillbuflen;
+	Size		bufsize = sizeof(ReorderBufferDiskBlock) + rawsize;
+	int			compsize = -1;
+
+	if (rawsize == 0)
+		return;
+
+	if (rb->compressbufsize < bufsize)
+	{
+		if (rb->compressbuf == NULL)
+			rb->compressbuf = MemoryContextAlloc(rb->context, bufsize);
+		else
+			rb->compressbuf = repalloc(rb->compressbuf, bufsize);
+		rb->compressbufsize = bufsize;
+	}
+
+	block = (ReorderBufferDiskBlock *) rb->compressbuf;
+
+	/*
+	 * Only allow the compressed data to be as large as the changes, in which
+	 * case compression fails and the changes are written uncompressed.
+	 */
+	switch (rb->spill_compression)
+	{
+		case PG_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			compsize = LZ4_compress_default(rb->spillbuf,
+											(char *) (block + 1),
+											rawsize, rawsize);
+			if (compsize <= 0)
+				compsize = -1;
+#else
+			elog(ERROR, "LZ4 is not supported by this build");
+#endif
+			break;
+
+		case PG_COMPRESSION_ZSTD:
+#ifdef USE_ZSTD
+			{
+				size_t		len;
+
+				len = ZSTD_compress((char *) (block + 1), rawsize,
+									rb->spillbuf, rawsize,
+									ZSTD_CLEVEL_DEFAULT);
+				if (!ZSTD_isError(len))
+					compsize = len;
+			}
+#else
+			elog(ERROR, "zstd is not supported by this build");
+#endif
+			break;
+
+		default:
+			elog(ERROR, "unrecognized compression algorithm %d",
+				 rb->spill_compression);
+	}
+
+	if (compsize < 0 || (Size) compsize >= rawsize)
+		ReorderBufferWriteSpillFile(rb, txn, fd, rb->spillbuf, rawsize);
+	else
+	{
+		memset(block, 0, sizeof(ReorderBufferDiskBlock));
+		block->method = rb->spill_compression;
+		block->rawsize = rawsize;
+		block->compsize = compsize;
+
+		ReorderBufferWriteSpillFile(rb, txn, fd, rb->compressbuf,
+									sizeof(ReorderBufferDiskBlock) + compsize);
+	}
+
+	rb->spillbuflen = 0;
+}
+
+/*
+ * Write data to a spill file.
+ */
+static void
+ReorderBufferWriteSpillFile(ReorderBuffer *rb, ReorderBufferTXN *txn, int fd,
+							char *data, Size len)
+{
 	errno = 0;
 	pgstat_report_wait_start(WAIT_EVENT_REORDER_BUFFER_WRITE);
-	if (write(fd, rb->outbuf, ondisk->size) != ondisk->size)
+	if (write(fd, data, len) != len)
 	{
 		int			save_errno = errno;
 
@@ -4001,18 +4205,7 @@ ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 	}
 	pgstat_report_wait_end();
 
-	/*
-	 * Keep the transaction's final_lsn up to date with each change we send to
-	 * disk, so that ReorderBufferRestoreCleanup works correctly.  (We used to
-	 * only do this on commit and abort records, but that doesn't work if a
-	 * system crash leaves a transaction without its abort record).
-	 *
-	 * Make sure not to move it backwards.
-	 */
-	if (txn->final_lsn < change->lsn)
-		txn->final_lsn = change->lsn;
-
-	Assert(ondisk->change.action == change->action);
+	rb->spillWrittenBytes += len;
 }
 
 /* Returns true, if the output plugin supports streaming, false, otherwise. */
@@ -4307,6 +4500,7 @@ ReorderBufferRestoreChanges(ReorderBuffer *rb, ReorderBufferTXN *txn,
 
 			/* No harm in resetting the offset even in case of failure */
 			file->curOffset = 0;
+			file->blocklen = file->blockpos = 0;
 
 			if (*fd < 0 && errno == ENOENT)
 			{
@@ -4327,9 +4521,9 @@ ReorderBufferRestoreChanges(ReorderBuffer *rb, ReorderBufferTXN *txn,
 		 * end of this file.
 		 */
 		ReorderBufferSerializeReserve(rb, sizeof(ReorderBufferDiskChange));
-		readBytes = FileRead(file->vfd, rb->outbuf,
-							 sizeof(ReorderBufferDiskChange),
-							 file->curOffset, WAIT_EVENT_REORDER_BUFFER_READ);
+		readBytes = ReorderBufferSpillRead(rb, file, rb->outbuf,
+										   sizeof(ReorderBufferDiskChange),
+										   true);
 
 		/* eof */
 		if (readBytes == 0)
@@ -4350,19 +4544,16 @@ ReorderBufferRestoreChanges(ReorderBuffer *rb, ReorderBufferTXN *txn,
 							readBytes,
 							(uint32) sizeof(ReorderBufferDiskChange))));
 
-		file->curOffset += readBytes;
-
 		ondisk = (ReorderBufferDiskChange *) rb->outbuf;
 
 		ReorderBufferSerializeReserve(rb,
 									  sizeof(ReorderBufferDiskChange) + ondisk->size);
 		ondisk = (ReorderBufferDiskChange *) rb->outbuf;
 
-		readBytes = FileRead(file->vfd,
-							 rb->outbuf + sizeof(ReorderBufferDiskChange),
-							 ondisk->size - sizeof(ReorderBufferDiskChange),
-							 file->curOffset,
-							 WAIT_EVENT_REORDER_BUFFER_READ);
+		readBytes = ReorderBufferSpillRead(rb, file,
+										   rb->outbuf + sizeof(ReorderBufferDiskChange),
+										   ondisk->size - sizeof(ReorderBufferDiskChange),
+										   false);
 
 		if (readBytes < 0)
 			ereport(ERROR,
@@ -4375,8 +4566,6 @@ ReorderBufferRestoreChanges(ReorderBuffer *rb, ReorderBufferTXN *txn,
 							readBytes,
 							(uint32) (ondisk->size - sizeof(ReorderBufferDiskChange)))));
 
-		file->curOffset += readBytes;
-
 		/*
 		 * ok, read a full change from disk, now restore it into proper
 		 * in-memory format
@@ -4388,6 +4577,139 @@ ReorderBufferRestoreChanges(ReorderBuffer *rb, ReorderBufferTXN *txn,
 	return restored;
 }
 
+/*
+ * Read data of a change spilled to disk, like FileRead() at the current offset
+ * of the file, which is advanced.
+ *
+ * "start" is true when reading the start of a change, where a compressed
+ * block of changes may be found instead. Such a block is then decompressed,
+ * and the following reads are served from it until it is used up.
+ */
+static int
+ReorderBufferSpillRead(ReorderBuffer *rb, TXNEntryFile *file, char *buf,
+					   Size len, bool start)
+{
+	ReorderBufferDiskBlock block;
+	Size		marker;
+	int			readBytes;
+
+	if (file->blockpos < file->blocklen)
+	{
+		/* Changes are never split across blocks */
+		if (len > file->blocklen - file->blockpos)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("could not read from reorderbuffer spill file: change crosses compressed block boundary")));
+
+		memcpy(buf, file->block + file->blockpos, len);
+		file->blockpos += len;
+		return len;
+	}
+
+	readBytes = FileRead(file->vfd, buf, len, file->curOffset,
+						 WAIT_EVENT_REORDER_BUFFER_READ);
+	if (readBytes >= (int) sizeof(Size))
+		memcpy(&marker, buf, sizeof(Size));
+
+	if (!start || readBytes < (int) sizeof(Size) || marker != 0)
+	{
+		if (readBytes > 0)
+			file->curOffset += readBytes;
+		return readBytes;
+	}
+
+	/* We have found a compressed block, read it whole */
+	readBytes = FileRead(file->vfd, (char *) &block,
+						 sizeof(ReorderBufferDiskBlock), file->curOffset,
+						 WAIT_EVENT_REORDER_BUFFER_READ);
+	if (readBytes < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from reorderbuffer spill file: %m")));
+	else if (readBytes != sizeof(ReorderBufferDiskBlock))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from reorderbuffer spill file: read %d instead of %u bytes",
+						readBytes,
+						(uint32) sizeof(ReorderBufferDiskBlock))));
+	file->curOffset += readBytes;
+
+	if (rb->compressbufsize < block.compsize)
+	{
+		if (rb->compressbuf == NULL)
+			rb->compressbuf = MemoryContextAlloc(rb->context, block.compsize);
+		else
+			rb->compressbuf = repalloc(rb->compressbuf, block.compsize);
+		rb->compressbufsize = block.compsize;
+	}
+
+	readBytes = FileRead(file->vfd, rb->compressbuf, block.compsize,
+						 file->curOffset, WAIT_EVENT_REORDER_BUFFER_READ);
+	if (readBytes < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from reorderbuffer spill file: %m")));
+	else if (readBytes != block.compsize)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from reorderbuffer spill file: read %d instead of %u bytes",
+						readBytes, block.compsize)));
+	file->curOffset += readBytes;
+
+	if (file->blocksize < block.rawsize)
+	{
+		if (file->block == NULL)
+			file->block = MemoryContextAlloc(rb->context, block.rawsize);
+		else
+			file->block = repalloc(file->block, block.rawsize);
+		file->blocksize = block.rawsize;
+	}
+
+	switch (block.method)
+	{
+		case PG_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			if (LZ4_decompress_safe(rb->compressbuf, file->block,
+									block.compsize, block.rawsize) !=
+				block.rawsize)
+				ereport(ERROR,
+						(errcode(ERRCODE_DATA_CORRUPTED),
+						 errmsg("could not decompress reorderbuffer spill file block")));
+#else
+			elog(ERROR, "LZ4 is not supported by this build");
+#endif
+			break;
+
+		case PG_COMPRESSION_ZSTD:
+#ifdef USE_ZSTD
+			{
+				size_t		decompsize;
+
+				decompsize = ZSTD_decompress(file->block, block.rawsize,
+											 rb->compressbuf, block.compsize);
+				if (ZSTD_isError(decompsize) || decompsize != block.rawsize)
+					ereport(ERROR,
+							(errcode(ERRCODE_DATA_CORRUPTED),
+							 errmsg("could not decompress reorderbuffer spill file block")));
+			}
+#else
+			elog(ERROR, "zstd is not supported by this build");
+#endif
+			break;
+
+		default:
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("invalid compression method %u in reorderbuffer spill file",
+							block.method)));
+	}
+
+	file->blocklen = block.rawsize;
+	file->blockpos = 0;
+
+	return ReorderBufferSpillRead(rb, file, buf, len, false);
+}
+
 /*
  * Convert change from its on-disk format to in-memory format and queue it onto
  * the TXN's ->changes list.
@@ -473,6 +473,16 @@ should_apply_changes_for_rel(LogicalRepRelMapEntry *rel)
 			return MyLogicalRepWorker->relid == rel->localreloid;
 
 		case WORKERTYPE_PARALLEL_APPLY:
+
+			/*
+			 * A committed transaction is handed over with its final LSN, so
+			 * we can decide the same way as the leader apply worker.
+			 */
+			if (!in_streamed_transaction)
+				return (rel->state == SUBREL_STATE_READY ||
+						(rel->state == SUBREL_STATE_SYNCDONE &&
+						 rel->statelsn <= remote_final_lsn));
+
 			/* We don't synchronize rel's that are in unknown state. */
 			if (rel->state != SUBREL_STATE_READY &&
 				rel->state != SUBREL_STATE_UNKNOWN)
@@ -563,6 +573,10 @@ handle_streamed_transaction(LogicalRepMsgType action, StringInfo s)
 	TransApplyAction apply_action;
 	StringInfoData original_msg;
 
+	/* Committed transactions handed over by the leader are applied as is. */
+	if (am_parallel_apply_worker() && !in_streamed_transaction)
+		return false;
+
 	apply_action = get_transaction_apply_action(stream_xid, &winfo);
 
 	/* not in streaming mode */
@@ -1004,6 +1018,17 @@ apply_handle_begin(StringInfo s)
 
 	in_remote_transaction = true;
 
+	/*
+	 * Hand over the transaction to a parallel apply worker if we can.
+	 * Otherwise, it is applied here once the transactions handed over before
+	 * it have been applied, to preserve commit order.
+	 */
+	if (am_parallel_apply_worker())
+		pa_begin_dispatched_xact();
+	else if (am_leader_apply_worker() &&
+			 (is_skipping_changes() || !pa_dispatch_begin(&begin_data, s)))
+		pa_wait_for_dispatched_xacts();
+
 	pgstat_report_activity(STATE_RUNNING, NULL);
 }
 
@@ -1026,10 +1051,26 @@ apply_handle_commit(StringInfo s)
 								 LSN_FORMAT_ARGS(commit_data.commit_lsn),
 								 LSN_FORMAT_ARGS(remote_final_lsn))));
 
-	apply_handle_commit_internal(&commit_data);
+	if (pa_dispatching_xact())
+	{
+		/* The parallel apply worker takes care of the rest. */
+		pa_dispatch_commit(&commit_data, s);
+		in_remote_transaction = false;
+	}
+	else if (am_parallel_apply_worker())
+	{
+		/* Commit in the same order as the leader apply worker would. */
+		pa_wait_for_preceding_xact();
+		apply_handle_commit_internal(&commit_data);
+		pa_finish_dispatched_xact(commit_data.end_lsn);
+	}
+	else
+	{
+		apply_handle_commit_internal(&commit_data);
 
-	/* Process any tables that are being synchronized in parallel. */
-	process_syncing_tables(commit_data.end_lsn);
+		/* Process any tables that are being synchronized in parallel. */
+		process_syncing_tables(commit_data.end_lsn);
+	}
 
 	pgstat_report_activity(STATE_IDLE, NULL);
 	reset_apply_error_context_info();
@@ -2308,6 +2349,10 @@ apply_handle_relation(StringInfo s)
 	rel = logicalrep_read_rel(s);
 	logicalrep_relmap_update(rel);
 
+	/* Parallel apply workers get the new description when they need it. */
+	if (am_leader_apply_worker())
+		pa_relation_changed(rel->remoteid);
+
 	/* Also reset all entries in the partition map that refer to remoterel. */
 	logicalrep_partmap_reset_relmap(rel);
 }
@@ -3264,6 +3309,47 @@ apply_handle_truncate(StringInfo s)
 	end_replication_step();
 }
 
+/*
+ * Handle a message of a committed transaction being handed over to a
+ * parallel apply worker.
+ */
+static void
+apply_dispatched_message(LogicalRepMsgType action, StringInfo s)
+{
+	switch (action)
+	{
+		case LOGICAL_REP_MSG_COMMIT:
+			apply_handle_commit(s);
+			break;
+
+		case LOGICAL_REP_MSG_RELATION:
+			/* The worker is sent the relation when needed. */
+			apply_handle_relation(s);
+			break;
+
+		case LOGICAL_REP_MSG_TYPE:
+			pa_dispatch_change(action, s);
+			apply_handle_type(s);
+			break;
+
+		case LOGICAL_REP_MSG_INSERT:
+		case LOGICAL_REP_MSG_UPDATE:
+		case LOGICAL_REP_MSG_DELETE:
+		case LOGICAL_REP_MSG_TRUNCATE:
+		case LOGICAL_REP_MSG_ORIGIN:
+			pa_dispatch_change(action, s);
+			break;
+
+		case LOGICAL_REP_MSG_MESSAGE:
+			/* Logical replication does not use generic logical messages. */
+			break;
+
+		default:
+			ereport(ERROR,
+					(errcode(ERRCODE_PROTOCOL_VIOLATION),
+					 errmsg("invalid logical replication message type \"??? (%d)\"", action)));
+	}
+}
 
 /*
  * Logical replication protocol message dispatcher.
@@ -3282,6 +3368,24 @@ apply_dispatch(StringInfo s)
 	saved_command = apply_error_callback_arg.command;
 	apply_error_callback_arg.command = action;
 
+	/*
+	 * The messages of a committed transaction handed over to a parallel apply
+	 * worker are passed on to it. Any other transaction waits for the ones
+	 * handed over to be applied first, see apply_handle_begin().
+	 */
+	if (pa_dispatching_xact())
+	{
+		apply_dispatched_message(action, s);
+		apply_error_callback_arg.command = saved_command;
+		return;
+	}
+	else if (pa_have_dispatched_xacts() &&
+			 action != LOGICAL_REP_MSG_BEGIN &&
+			 action != LOGICAL_REP_MSG_RELATION &&
+			 action != LOGICAL_REP_MSG_TYPE &&
+			 action != LOGICAL_REP_MSG_MESSAGE)
+		pa_wait_for_dispatched_xacts();
+
 	switch (action)
 	{
 		case LOGICAL_REP_MSG_BEGIN:
@@ -3611,10 +3715,14 @@ LogicalRepApplyLoop(XLogRecPtr last_received)
 			}
 		}
 
+		/* Release the parallel apply workers that are done, if any. */
+		pa_reap_dispatched_xacts();
+
 		/* confirm all writes so far */
 		send_feedback(last_received, false, false);
 
-		if (!in_remote_transaction && !in_streamed_transaction)
+		if (!in_remote_transaction && !in_streamed_transaction &&
+			!pa_have_dispatched_xacts())
 		{
 			/*
 			 * If we didn't get any transactions for a while there might be
@@ -3643,7 +3751,7 @@ LogicalRepApplyLoop(XLogRecPtr last_received)
 		 * no particular urgency about waking up unless we get data or a
 		 * signal.
 		 */
-		if (!dlist_is_empty(&lsn_mapping))
+		if (!dlist_is_empty(&lsn_mapping) || pa_have_dispatched_xacts())
 			wait_time = WalWriterDelay;
 		else
 			wait_time = NAPTIME_PER_CYCLE;
@@ -3768,9 +3876,11 @@ send_feedback(XLogRecPtr recvpos, bool force, bool requestReply)
 
 	/*
 	 * No outstanding transactions to flush, we can report the latest received
-	 * position. This is important for synchronous replication.
+	 * position. This is important for synchronous replication. Transactions
+	 * handed over to parallel apply workers may not have been committed yet
+	 * though.
 	 */
-	if (!have_pending_txes)
+	if (!have_pending_txes && !pa_have_dispatched_xacts())
 		flushpos = writepos = recvpos;
 
 	if (writepos < last_writepos)
@@ -0,0 +1,303 @@
+/*-------------------------------------------------------------------------
+ *
+ * aio.c
+ *	  Backend-local asynchronous I/O
+ *
+ * This module lets a backend start a read from a file and collect the
+ * result later, so that the buffer manager can overlap the wait for storage
+ * with other work.  StartReadBuffers() starts the read, and
+ * WaitReadBuffers() waits for it and copies the data into the buffer pool.
+ *
+ * Reads are performed into backend-private memory that belongs to the I/O
+ * handle, never directly into shared buffers.  That's deliberate: marking a
+ * shared buffer BM_IO_IN_PROGRESS at the time the read is started would make
+ * other backends wait for an I/O that this backend might not get around to
+ * completing for a long time, for example because it is suspended in a
+ * cursor or is itself waiting for a lock.  Instead, buffers are claimed in
+ * WaitReadBuffers() just as for synchronous reads, and if another backend
+ * has read a block in the meantime our copy is simply discarded.  The cost is
+ * one extra memcpy per block, which is small compared to the I/O itself.
+ *
+ * Handles are registered with the current resource owner, so that an error
+ * that throws away the read stream that owned them waits for the kernel to
+ * finish writing into their memory before the memory can be reused.
+ *
+ * The implementation of the I/O itself is selected by the io_method GUC.
+ * With io_method=sync, no handles are ever handed out and all reads are
+ * synchronous, as before.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/aio/aio.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "port/pg_bitutils.h"
+#include "storage/aio_internal.h"
+#include "utils/memutils.h"
+#include "utils/resowner.h"
+
+/* GUCs */
+int			io_method = DEFAULT_IO_METHOD;
+int			io_max_concurrency = DEFAULT_IO_MAX_CONCURRENCY;
+
+/* Method in use in this backend, or NULL if I/O is synchronous */
+static const IoMethodOps *pgaio_method_ops = NULL;
+static bool pgaio_initialized = false;
+
+/*
+ * Set if the method reported a failure that leaves in-flight I/Os in an
+ * unknown state.  Their memory can't be reused after that.
+ */
+static bool pgaio_broken = false;
+
+static PgAioHandle *pgaio_handles = NULL;
+static int *pgaio_free_handles = NULL;
+static int	pgaio_num_free = 0;
+
+static void ResOwnerReleaseAioHandle(Datum res);
+
+static const ResourceOwnerDesc aio_handle_resowner_desc =
+{
+	.name = "AIO handle",
+	.release_phase = RESOURCE_RELEASE_BEFORE_LOCKS,
+	.release_priority = RELEASE_PRIO_FIRST,
+	.ReleaseResource = ResOwnerReleaseAioHandle,
+	.DebugPrint = NULL			/* the default message is fine */
+};
+
+/*
+ * Set up the I/O method for this backend on first use.  Returns false if
+ * I/O is to be performed synchronously.
+ */
+static bool
+pgaio_init_backend(void)
+{
+	const IoMethodOps *ops = NULL;
+
+	if (pgaio_initialized)
+		return pgaio_method_ops != NULL;
+	pgaio_initialized = true;
+
+	switch ((IoMethod) io_method)
+	{
+		case IOMETHOD_SYNC:
+			break;
+		case IOMETHOD_IO_URING:
+#ifdef USE_IOMETHOD_IO_URING
+			ops = &pgaio_uring_ops;
+#endif
+			break;
+	}
+
+	if (ops == NULL || !ops->init_backend(io_max_concurrency))
+		return false;
+
+	pgaio_handles = (PgAioHandle *)
+		MemoryContextAllocZero(TopMemoryContext,
+							   sizeof(PgAioHandle) * io_max_concurrency);
+	pgaio_free_handles = (int *)
+		MemoryContextAlloc(TopMemoryContext,
+						   sizeof(int) * io_max_concurrency);
+	for (int i = 0; i < io_max_concurrency; i++)
+	{
+		pgaio_handles[i].index = i;
+		pgaio_handles[i].state = PGAIO_HS_IDLE;
+		pgaio_free_handles[pgaio_num_free++] = io_max_concurrency - i - 1;
+	}
+
+	pgaio_method_ops = ops;
+
+	return true;
+}
+
+/*
+ * Acquire a handle with space to read nbytes.
+ *
+ * Returns NULL if I/O should be performed synchronously instead, either
+ * because asynchronous I/O isn't in use or because io_max_concurrency I/Os
+ * are already in progress in this backend.  The handle is owned by the
+ * current resource owner until pgaio_io_release() is called.
+ */
+PgAioHandle *
+pgaio_io_acquire(size_t nbytes)
+{
+	PgAioHandle *ioh;
+
+	if (io_method == IOMETHOD_SYNC || pgaio_broken)
+		return NULL;
+	if (CurrentResourceOwner == NULL)
+		return NULL;
+	if (!pgaio_init_backend())
+		return NULL;
+	if (pgaio_num_free == 0)
+		return NULL;
+
+	ResourceOwnerEnlarge(CurrentResourceOwner);
+
+	ioh = &pgaio_handles[pgaio_free_handles[pgaio_num_free - 1]];
+	Assert(ioh->state == PGAIO_HS_IDLE);
+
+	if (ioh->buffer_size < nbytes)
+	{
+		size_t		size = pg_nextpower2_size_t(nbytes);
+
+		if (ioh->buffer)
+			pfree(ioh->buffer);
+		ioh->buffer = NULL;
+		ioh->buffer_size = 0;
+		ioh->buffer = MemoryContextAllocAligned(TopMemoryContext, size,
+												PG_IO_ALIGN_SIZE, 0);
+		ioh->buffer_size = size;
+	}
+
+	pgaio_num_free--;
+	ioh->state = PGAIO_HS_ACQUIRED;
+	ioh->nbytes = 0;
+	ioh->result = 0;
+	ioh->resowner = CurrentResourceOwner;
+	ResourceOwnerRemember(ioh->resowner, PointerGetDatum(ioh),
+						  &aio_handle_resowner_desc);
+
+	return ioh;
+}
+
+/*
+ * Return the memory that a read performed with this handle is placed in.
+ */
+void *
+pgaio_io_get_buffer(PgAioHandle *ioh)
+{
+	Assert(ioh->state != PGAIO_HS_IDLE);
+
+	return ioh->buffer;
+}
+
+/*
+ * Start reading nbytes from fd at offset into the handle's buffer.  Returns
+ * false if the read couldn't be started, in which case the handle can be
+ * released or reused.
+ *
+ * This is normally called through FileStartRead(), which knows how to turn
+ * a virtual file descriptor into a kernel one.
+ */
+bool
+pgaio_io_start_read(PgAioHandle *ioh, int fd, off_t offset, size_t nbytes,
+					uint32 wait_event_info)
+{
+	Assert(ioh->state == PGAIO_HS_ACQUIRED);
+	Assert(nbytes <= ioh->buffer_size);
+	Assert(pgaio_method_ops != NULL);
+
+	ioh->nbytes = nbytes;
+	ioh->wait_event_info = wait_event_info;
+	ioh->state = PGAIO_HS_INFLIGHT;
+
+	if (!pgaio_method_ops->submit_read(ioh, fd, offset))
+	{
+		ioh->state = PGAIO_HS_ACQUIRED;
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Wait for a started read to complete.  Returns the number of bytes read, or
+ * -errno if the read failed.  The caller is responsible for dealing with
+ * short reads, typically by falling back to a synchronous read that reports
+ * errors in the usual way.
+ */
+ssize_t
+pgaio_io_wait(PgAioHandle *ioh)
+{
+	Assert(ioh->state == PGAIO_HS_INFLIGHT ||
+		   ioh->state == PGAIO_HS_COMPLETED);
+
+	if (ioh->state == PGAIO_HS_INFLIGHT)
+		pgaio_method_ops->wait_one(ioh);
+
+	Assert(ioh->state == PGAIO_HS_COMPLETED);
+
+	return ioh->result;
+}
+
+/*
+ * Return a handle to the free list, waiting for any I/O still in flight.
+ */
+static void
+pgaio_io_reclaim(PgAioHandle *ioh)
+{
+	if (ioh->state == PGAIO_HS_INFLIGHT)
+	{
+		/*
+		 * If the method has failed we can't know when the kernel will be
+		 * done with the memory, so leak the handle rather than reuse it.
+		 */
+		if (pgaio_broken)
+			return;
+		pgaio_method_ops->wait_one(ioh);
+	}
+
+	ioh->state = PGAIO_HS_IDLE;
+	ioh->resowner = NULL;
+	pgaio_free_handles[pgaio_num_free++] = ioh->index;
+}
+
+/*
+ * Release a handle acquired with pgaio_io_acquire().
+ */
+void
+pgaio_io_release(PgAioHandle *ioh)
+{
+	Assert(ioh->state != PGAIO_HS_IDLE);
+
+	ResourceOwnerForget(ioh->resowner, PointerGetDatum(ioh),
+						&aio_handle_resowner_desc);
+	pgaio_io_reclaim(ioh);
+}
+
+/*
+ * Functions for use by I/O methods.
+ */
+
+PgAioHandle *
+pgaio_io_from_index(int index)
+{
+	Assert(index >= 0 && index < io_max_concurrency);
+
+	return &pgaio_handles[index];
+}
+
+void
+pgaio_io_complete(PgAioHandle *ioh, ssize_t result)
+{
+	Assert(ioh->state == PGAIO_HS_INFLIGHT);
+
+	ioh->result = result;
+	ioh->state = PGAIO_HS_COMPLETED;
+}
+
+/*
+ * Called by a method that has hit an unrecoverable error, before it raises
+ * it.  No further asynchronous I/O is attempted in this backend.
+ */
+void
+pgaio_method_failed(void)
+{
+	pgaio_broken = true;
+}
+
+/*
+ * ResourceOwner callbacks
+ */
+
+static void
+ResOwnerReleaseAioHandle(Datum res)
+{
+	pgaio_io_reclaim((PgAioHandle *) DatumGetPointer(res));
+}
@@ -0,0 +1,282 @@
+/*-------------------------------------------------------------------------
+ *
+ * method_io_uring.c
+ *	  Asynchronous I/O using Linux io_uring
+ *
+ * Each backend that performs asynchronous I/O creates its own ring on first
+ * use, sized for io_max_concurrency I/Os, so no state is shared between
+ * processes.  The ring is driven with the raw system calls rather than
+ * through liburing, since only a tiny subset of the interface is needed:
+ * submitting reads and reaping their completions.
+ *
+ * If the ring can't be created, for example because the kernel is too old or
+ * io_uring has been disabled by the system administrator or a seccomp
+ * policy, a message is logged and the backend falls back to synchronous I/O.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/aio/method_io_uring.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "storage/aio_internal.h"
+
+#ifdef USE_IOMETHOD_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "port/atomics.h"
+#include "utils/wait_event.h"
+
+static bool pgaio_uring_init_backend(int max_inflight);
+static bool pgaio_uring_submit_read(PgAioHandle *ioh, int fd, off_t offset);
+static void pgaio_uring_wait_one(PgAioHandle *ioh);
+
+const IoMethodOps pgaio_uring_ops = {
+	.init_backend = pgaio_uring_init_backend,
+	.submit_read = pgaio_uring_submit_read,
+	.wait_one = pgaio_uring_wait_one,
+};
+
+/* The memory-mapped rings shared with the kernel. */
+typedef struct PgAioUring
+{
+	int			fd;
+
+	/* submission queue */
+	volatile unsigned *sq_head;
+	volatile unsigned *sq_tail;
+	unsigned	sq_mask;
+	unsigned   *sq_array;
+	struct io_uring_sqe *sqes;
+
+	/* completion queue */
+	volatile unsigned *cq_head;
+	volatile unsigned *cq_tail;
+	unsigned	cq_mask;
+	struct io_uring_cqe *cqes;
+
+	/* SQEs that are in the ring but haven't been consumed by the kernel */
+	unsigned	unsubmitted;
+} PgAioUring;
+
+static PgAioUring pgaio_uring;
+
+static int
+sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+	return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int
+sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+				   unsigned flags)
+{
+	return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+						 flags, NULL, 0);
+}
+
+static bool
+pgaio_uring_init_backend(int max_inflight)
+{
+	PgAioUring *ring = &pgaio_uring;
+	struct io_uring_params p;
+	size_t		sq_size;
+	size_t		cq_size;
+	char	   *sq_ptr;
+	char	   *cq_ptr;
+	void	   *sqes;
+	int			fd;
+
+	memset(&p, 0, sizeof(p));
+	fd = sys_io_uring_setup(max_inflight, &p);
+	if (fd < 0)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not set up io_uring, falling back to synchronous I/O: %m")));
+		return false;
+	}
+
+	sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		sq_size = cq_size = Max(sq_size, cq_size);
+
+	sq_ptr = mmap(NULL, sq_size, PROT_READ | PROT_WRITE,
+				  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (sq_ptr == MAP_FAILED)
+		goto fail;
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		cq_ptr = sq_ptr;
+	else
+	{
+		cq_ptr = mmap(NULL, cq_size, PROT_READ | PROT_WRITE,
+					  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (cq_ptr == MAP_FAILED)
+			goto fail;
+	}
+
+	sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+				PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+				IORING_OFF_SQES);
+	if (sqes == MAP_FAILED)
+		goto fail;
+
+	ring->fd = fd;
+	ring->sq_head = (unsigned *) (sq_ptr + p.sq_off.head);
+	ring->sq_tail = (unsigned *) (sq_ptr + p.sq_off.tail);
+	ring->sq_mask = *(unsigned *) (sq_ptr + p.sq_off.ring_mask);
+	ring->sq_array = (unsigned *) (sq_ptr + p.sq_off.array);
+	ring->sqes = (struct io_uring_sqe *) sqes;
+	ring->cq_head = (unsigned *) (cq_ptr + p.cq_off.head);
+	ring->cq_tail = (unsigned *) (cq_ptr + p.cq_off.tail);
+	ring->cq_mask = *(unsigned *) (cq_ptr + p.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *) (cq_ptr + p.cq_off.cqes);
+	ring->unsubmitted = 0;
+
+	return true;
+
+fail:
+	ereport(LOG,
+			(errcode_for_file_access(),
+			 errmsg("could not map io_uring queues, falling back to synchronous I/O: %m")));
+	close(fd);					/* the kernel drops any mappings with it */
+	return false;
+}
+
+/*
+ * Tell the kernel about queued SQEs, and optionally wait for at least one
+ * completion.
+ */
+static void
+pgaio_uring_enter(bool wait, uint32 wait_event_info)
+{
+	PgAioUring *ring = &pgaio_uring;
+	int			rc;
+
+	for (;;)
+	{
+		if (wait)
+			pgstat_report_wait_start(wait_event_info);
+		rc = sys_io_uring_enter(ring->fd, ring->unsubmitted, wait ? 1 : 0,
+								wait ? IORING_ENTER_GETEVENTS : 0);
+		if (wait)
+			pgstat_report_wait_end();
+
+		if (rc >= 0)
+		{
+			Assert(rc <= ring->unsubmitted);
+			ring->unsubmitted -= rc;
+			return;
+		}
+
+		if (errno == EINTR)
+			continue;
+
+		/*
+		 * The kernel is temporarily short of resources.  The SQEs stay in the
+		 * ring and will be submitted by the next call, so there's nothing to
+		 * do unless we need a completion.
+		 */
+		if ((errno == EAGAIN || errno == EBUSY) && !wait)
+			return;
+		if (errno == EAGAIN || errno == EBUSY)
+		{
+			pg_usleep(1000L);
+			continue;
+		}
+
+		pgaio_method_failed();
+		ereport(FATAL,
+				(errcode_for_file_access(),
+				 errmsg("could not submit or wait for io_uring I/O: %m")));
+	}
+}
+
+static bool
+pgaio_uring_submit_read(PgAioHandle *ioh, int fd, off_t offset)
+{
+	PgAioUring *ring = &pgaio_uring;
+	unsigned	tail;
+	unsigned	index;
+	struct io_uring_sqe *sqe;
+
+	/*
+	 * aio.c never has more than io_max_concurrency handles in flight, and the
+	 * ring has at least that many entries, so there is always space.
+	 */
+	tail = *ring->sq_tail;
+	index = tail & ring->sq_mask;
+	Assert(tail - *ring->sq_head <= ring->sq_mask);
+
+	sqe = &ring->sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->off = offset;
+	sqe->addr = (uint64) (uintptr_t) ioh->buffer;
+	sqe->len = ioh->nbytes;
+	sqe->user_data = ioh->index;
+	ring->sq_array[index] = index;
+
+	/* The SQE must be visible before the tail moves. */
+	pg_write_barrier();
+	*ring->sq_tail = tail + 1;
+	ring->unsubmitted++;
+
+	pgaio_uring_enter(false, 0);
+
+	return true;
+}
+
+/*
+ * Consume all available completions.
+ */
+static void
+pgaio_uring_reap(void)
+{
+	PgAioUring *ring = &pgaio_uring;
+	unsigned	head = *ring->cq_head;
+
+	for (;;)
+	{
+		struct io_uring_cqe *cqe;
+
+		/* Read the tail before the entries it covers. */
+		if (head == *ring->cq_tail)
+			break;
+		pg_read_barrier();
+
+		cqe = &ring->cqes[head & ring->cq_mask];
+		pgaio_io_complete(pgaio_io_from_index((int) cqe->user_data),
+						  cqe->res);
+		head++;
+	}
+
+	/* We must be done reading the entries before giving them back. */
+	pg_memory_barrier();
+	*ring->cq_head = head;
+}
+
+static void
+pgaio_uring_wait_one(PgAioHandle *ioh)
+{
+	for (;;)
+	{
+		pgaio_uring_reap();
+		if (ioh->state == PGAIO_HS_COMPLETED)
+			break;
+		pgaio_uring_enter(true, ioh->wait_event_info);
+	}
+}
+
+#endif							/* USE_IOMETHOD_IO_URING */
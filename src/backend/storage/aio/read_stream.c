@@ -33,7 +33,9 @@
  *
  * C) I/O is necessary, it appears random, and this system supports fadvise.
  * We'll look further ahead in order to reach the configured level of I/O
- * concurrency.
+ * concurrency.  When io_method allows reads to be started asynchronously,
+ * all I/O is treated this way, since even sequential reads then benefit from
+ * being in progress concurrently.
  *
  * The distance increases rapidly and decays slowly, so that it moves towards
  * those levels as different I/O patterns are discovered.  For example, a
@@ -90,6 +92,7 @@
 
 #include "catalog/pg_tablespace.h"
 #include "miscadmin.h"
+#include "storage/aio.h"
 #include "storage/fd.h"
 #include "storage/smgr.h"
 #include "storage/read_stream.h"
@@ -115,6 +118,7 @@ struct ReadStream
 	int16		pinned_buffers;
 	int16		distance;
 	bool		advice_enabled;
+	bool		async_enabled;
 
 	/*
 	 * One-block buffer to support 'ungetting' a block number, to resolve flow
@@ -231,6 +235,10 @@ read_stream_start_pending_read(ReadStream *stream, bool suppress_advice)
 	else
 		flags = 0;
 
+	/* Start the read for real, if possible. */
+	if (stream->async_enabled)
+		flags |= READ_BUFFERS_ASYNC;
+
 	/* We say how many blocks we want to read, but may be smaller on return. */
 	buffer_index = stream->next_buffer_index;
 	io_index = stream->next_io_index;
@@ -485,9 +493,15 @@ read_stream_begin_relation(int flags,
 #endif
 
 	/*
-	 * For now, max_ios = 0 is interpreted as max_ios = 1 with advice disabled
-	 * above.  If we had real asynchronous I/O we might need a slightly
-	 * different definition.
+	 * Asynchronous reads can be used for any pattern of access, if
+	 * io_method supports them.  max_ios = 0 disables them, as it does advice.
+	 */
+	if (io_method != IOMETHOD_SYNC && max_ios > 0)
+		stream->async_enabled = true;
+
+	/*
+	 * For now, max_ios = 0 is interpreted as max_ios = 1 with advice and
+	 * asynchronous reads disabled above.
 	 */
 	if (max_ios == 0)
 		max_ios = 1;
@@ -582,8 +596,10 @@ read_stream_next_buffer(ReadStream *stream, void **per_buffer_data)
 			if (likely(!StartReadBuffer(&stream->ios[0].op,
 										&stream->buffers[oldest_buffer_index],
 										next_blocknum,
-										stream->advice_enabled ?
-										READ_BUFFERS_ISSUE_ADVICE : 0)))
+										(stream->advice_enabled ?
+										 READ_BUFFERS_ISSUE_ADVICE : 0) |
+										(stream->async_enabled ?
+										 READ_BUFFERS_ASYNC : 0))))
 			{
 				/* Fast return. */
 				return buffer;
@@ -662,7 +678,8 @@ read_stream_next_buffer(ReadStream *stream, void **per_buffer_data)
 		if (++stream->oldest_io_index == stream->max_ios)
 			stream->oldest_io_index = 0;
 
-		if (stream->ios[io_index].op.flags & READ_BUFFERS_ISSUE_ADVICE)
+		if (stream->ios[io_index].op.flags &
+			(READ_BUFFERS_ISSUE_ADVICE | READ_BUFFERS_ASYNC))
 		{
 			/* Distance ramps up fast (behavior C). */
 			distance = stream->distance * 2;
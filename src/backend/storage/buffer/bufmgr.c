@@ -48,6 +48,7 @@
 #include "pg_trace.h"
 #include "pgstat.h"
 #include "postmaster/bgwriter.h"
+#include "storage/aio.h"
 #include "storage/buf_internals.h"
 #include "storage/bufmgr.h"
 #include "storage/fd.h"
@@ -1253,6 +1254,72 @@ ReadBuffer_common(Relation rel, SMgrRelation smgr, char smgr_persistence,
 	return buffer;
 }
 
+/*
+ * Try to start reading the blocks that StartReadBuffers() found to be
+ * missing, into the memory of an asynchronous I/O handle.  If that isn't
+ * possible, nothing happens and WaitReadBuffers() reads them synchronously.
+ *
+ * The buffers are already pinned at this point, so the mapping of these
+ * blocks to buffers can't change until we're done.  Any other backend that
+ * reads one of them in the meantime will have to make it BM_VALID before it
+ * can be modified and written out again, and WaitReadBuffers() discards our
+ * copy of any block that has become valid, so the data we read can't be
+ * stale when it's used.
+ */
+static void
+StartReadBuffersAsync(ReadBuffersOperation *operation)
+{
+	PgAioHandle *ioh;
+	int			nblocks;
+
+	ioh = pgaio_io_acquire((size_t) BLCKSZ * operation->io_buffers_len);
+	if (ioh == NULL)
+		return;
+
+	nblocks = smgrstartreadv(operation->smgr,
+							 operation->forknum,
+							 operation->blocknum,
+							 operation->io_buffers_len,
+							 ioh);
+	if (nblocks == 0)
+	{
+		pgaio_io_release(ioh);
+		return;
+	}
+
+	operation->io_handle = ioh;
+	operation->io_handle_nblocks = nblocks;
+}
+
+/*
+ * If the asynchronous read started by StartReadBuffersAsync() covers the
+ * given range of blocks, wait for it to complete and copy the data into the
+ * given pages.  Returns false if the caller must read the range itself, which
+ * also takes care of reporting errors and short reads in the usual way.
+ */
+static bool
+WaitReadBuffersAsync(ReadBuffersOperation *operation,
+					 BlockNumber first_block, void **pages, int npages)
+{
+	int			offset = first_block - operation->blocknum;
+	ssize_t		nbytes;
+	char	   *data;
+
+	if (operation->io_handle == NULL ||
+		offset + npages > operation->io_handle_nblocks)
+		return false;
+
+	nbytes = pgaio_io_wait(operation->io_handle);
+	if (nbytes < (ssize_t) BLCKSZ * (offset + npages))
+		return false;
+
+	data = pgaio_io_get_buffer(operation->io_handle);
+	for (int i = 0; i < npages; i++)
+		memcpy(pages[i], data + (size_t) BLCKSZ * (offset + i), BLCKSZ);
+
+	return true;
+}
+
 static pg_attribute_always_inline bool
 StartReadBuffersImpl(ReadBuffersOperation *operation,
 					 Buffer *buffers,
@@ -1306,8 +1373,13 @@ StartReadBuffersImpl(ReadBuffersOperation *operation,
 	operation->flags = flags;
 	operation->nblocks = actual_nblocks;
 	operation->io_buffers_len = io_buffers_len;
+	operation->io_handle = NULL;
+	operation->io_handle_nblocks = 0;
 
-	if (flags & READ_BUFFERS_ISSUE_ADVICE)
+	if (flags & READ_BUFFERS_ASYNC)
+		StartReadBuffersAsync(operation);
+
+	if ((flags & READ_BUFFERS_ISSUE_ADVICE) && operation->io_handle == NULL)
 	{
 		/*
 		 * In theory we should only do this if PinBufferForBlock() had to
@@ -1343,10 +1415,12 @@ StartReadBuffersImpl(ReadBuffersOperation *operation,
  * object, the caller-supplied array of buffers must remain valid until
  * WaitReadBuffers() is called.
  *
- * Currently the I/O is only started with optional operating system advice if
- * requested by the caller with READ_BUFFERS_ISSUE_ADVICE, and the real I/O
- * happens synchronously in WaitReadBuffers().  In future work, true I/O could
- * be initiated here.
+ * If requested by the caller with READ_BUFFERS_ASYNC and io_method allows
+ * it, the read is started here and WaitReadBuffers() only has to wait for it
+ * and copy the data into the buffers.  Otherwise the I/O is only started with
+ * optional operating system advice if requested by the caller with
+ * READ_BUFFERS_ISSUE_ADVICE, and the real I/O happens synchronously in
+ * WaitReadBuffers().
  */
 bool
 StartReadBuffers(ReadBuffersOperation *operation,
@@ -1500,7 +1574,10 @@ WaitReadBuffers(ReadBuffersOperation *operation)
 		}
 
 		io_start = pgstat_prepare_io_time(track_io_timing);
-		smgrreadv(operation->smgr, forknum, io_first_block, io_pages, io_buffers_len);
+		if (!WaitReadBuffersAsync(operation, io_first_block, io_pages,
+								  io_buffers_len))
+			smgrreadv(operation->smgr, forknum, io_first_block, io_pages,
+					  io_buffers_len);
 		pgstat_count_io_op_time(io_object, io_context, IOOP_READ, io_start,
 								io_buffers_len);
 
@@ -1569,6 +1646,13 @@ WaitReadBuffers(ReadBuffersOperation *operation)
 		if (VacuumCostActive)
 			VacuumCostBalance += VacuumCostPageMiss * io_buffers_len;
 	}
+
+	/* Done with the asynchronous read's memory, if we had one. */
+	if (operation->io_handle)
+	{
+		pgaio_io_release(operation->io_handle);
+		operation->io_handle = NULL;
+	}
 }
 
 /*
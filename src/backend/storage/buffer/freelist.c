@@ -23,19 +23,35 @@
 
 #define INT_ACCESS_ONCE(var)	((int)(*((volatile int *)&(var))))
 
+/*
+ * Don't split the buffer pool into partitions smaller than this; it would
+ * make the clock sweep too coarse to approximate LRU.
+ */
+#define MIN_BUFFERS_PER_PARTITION	1024
+
+/* GUC variable */
+int			clock_sweep_partitions = 1;
 
 /*
- * The shared freelist control information.
+ * The buffer pool is divided into one or more partitions of consecutive
+ * buffers, each with its own clock sweep hand and freelist, so that
+ * backends allocating buffers concurrently don't all hammer the same cache
+ * lines.  Each backend runs the clock sweep in its "home" partition, and
+ * only moves on to others if every buffer there is pinned.
  */
 typedef struct
 {
 	/* Spinlock: protects the values below */
 	slock_t		buffer_strategy_lock;
 
+	int			firstBuffer;	/* first buffer in the partition */
+	int			numBuffers;		/* number of buffers in the partition */
+
 	/*
-	 * Clock sweep hand: index of next buffer to consider grabbing. Note that
-	 * this isn't a concrete buffer - we only ever increase the value. So, to
-	 * get an actual buffer, it needs to be used modulo NBuffers.
+	 * Clock sweep hand: index of next buffer to consider grabbing, relative
+	 * to firstBuffer. Note that this isn't a concrete buffer - we only ever
+	 * increase the value. So, to get an actual buffer, it needs to be used
+	 * modulo numBuffers.
 	 */
 	pg_atomic_uint32 nextVictimBuffer;
 
@@ -48,22 +64,50 @@ typedef struct
 	 */
 
 	/*
-	 * Statistics.  These counters should be wide enough that they can't
+	 * Statistics.  completePasses should be wide enough that it can't
 	 * overflow during a single bgwriter cycle.
 	 */
 	uint32		completePasses; /* Complete cycles of the clock sweep */
-	pg_atomic_uint32 numBufferAllocs;	/* Buffers allocated since last reset */
+	pg_atomic_uint64 numBufferAllocs;	/* Buffers allocated, ever */
+	uint64		syncBufferAllocs;	/* numBufferAllocs at last
+									 * StrategySyncStart() */
+} ClockSweepPartition;
+
+typedef union ClockSweepPartitionPadded
+{
+	ClockSweepPartition partition;
+	char		pad[PG_CACHE_LINE_SIZE];
+} ClockSweepPartitionPadded;
+
+StaticAssertDecl(sizeof(ClockSweepPartition) <= PG_CACHE_LINE_SIZE,
+				 "ClockSweepPartition doesn't fit in a cache line");
+
+/*
+ * The shared freelist control information.
+ */
+typedef struct
+{
+	int			numPartitions;	/* number of clock sweep partitions */
+	int			partitionSize;	/* buffers per partition, except the last */
 
 	/*
 	 * Bgworker process to be notified upon activity or -1 if none. See
 	 * StrategyNotifyBgWriter.
 	 */
 	int			bgwprocno;
+
+	ClockSweepPartitionPadded partitions[FLEXIBLE_ARRAY_MEMBER];
 } BufferStrategyControl;
 
 /* Pointers to shared state */
 static BufferStrategyControl *StrategyControl = NULL;
 
+/* This backend's home partition, or -1 if not chosen yet */
+static int	MyClockSweepPartition = -1;
+
+#define GetClockSweepPartition(i) \
+	(&StrategyControl->partitions[(i)].partition)
+
 /*
  * Private (non-shared) state for managing a ring of shared buffers to re-use.
  * This is currently the only kind of BufferAccessStrategy object, but someday
@@ -93,6 +137,11 @@ typedef struct BufferAccessStrategyData
 
 
 /* Prototypes for internal functions */
+static int	StrategyNumPartitionsForNBuffers(void);
+static int	ChooseClockSweepPartition(void);
+static BufferDesc *GetBufferFromFreelist(ClockSweepPartition *partition,
+										 BufferAccessStrategy strategy,
+										 uint32 *buf_state);
 static BufferDesc *GetBufferFromRing(BufferAccessStrategy strategy,
 									 uint32 *buf_state);
 static void AddBufferToRing(BufferAccessStrategy strategy,
@@ -101,11 +150,11 @@ static void AddBufferToRing(BufferAccessStrategy strategy,
 /*
  * ClockSweepTick - Helper routine for StrategyGetBuffer()
  *
- * Move the clock hand one buffer ahead of its current position and return the
- * id of the buffer now under the hand.
+ * Move the clock hand of the given partition one buffer ahead of its current
+ * position and return the id of the buffer now under the hand.
  */
 static inline uint32
-ClockSweepTick(void)
+ClockSweepTick(ClockSweepPartition *partition)
 {
 	uint32		victim;
 
@@ -115,14 +164,14 @@ ClockSweepTick(void)
 	 * apparent order.
 	 */
 	victim =
-		pg_atomic_fetch_add_u32(&StrategyControl->nextVictimBuffer, 1);
+		pg_atomic_fetch_add_u32(&partition->nextVictimBuffer, 1);
 
-	if (victim >= NBuffers)
+	if (victim >= partition->numBuffers)
 	{
 		uint32		originalVictim = victim;
 
 		/* always wrap what we look up in BufferDescriptors */
-		victim = victim % NBuffers;
+		victim = victim % partition->numBuffers;
 
 		/*
 		 * If we're the one that just caused a wraparound, force
@@ -148,19 +197,41 @@ ClockSweepTick(void)
 				 * could lead to an overflow of nextVictimBuffers, but that's
 				 * highly unlikely and wouldn't be particularly harmful.
 				 */
-				SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+				SpinLockAcquire(&partition->buffer_strategy_lock);
 
-				wrapped = expected % NBuffers;
+				wrapped = expected % partition->numBuffers;
 
-				success = pg_atomic_compare_exchange_u32(&StrategyControl->nextVictimBuffer,
+				success = pg_atomic_compare_exchange_u32(&partition->nextVictimBuffer,
 														 &expected, wrapped);
 				if (success)
-					StrategyControl->completePasses++;
-				SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+					partition->completePasses++;
+				SpinLockRelease(&partition->buffer_strategy_lock);
 			}
 		}
 	}
-	return victim;
+	return partition->firstBuffer + victim;
+}
+
+/*
+ * ChooseClockSweepPartition -- pick this backend's home partition
+ *
+ * Backends are spread over the partitions by their proc number, so that
+ * concurrently active backends mostly use different partitions.
+ */
+static int
+ChooseClockSweepPartition(void)
+{
+	if (MyClockSweepPartition < 0 ||
+		MyClockSweepPartition >= StrategyControl->numPartitions)
+	{
+		if (MyProcNumber == INVALID_PROC_NUMBER)
+			MyClockSweepPartition = 0;
+		else
+			MyClockSweepPartition =
+				MyProcNumber % StrategyControl->numPartitions;
+	}
+
+	return MyClockSweepPartition;
 }
 
 /*
@@ -174,10 +245,13 @@ ClockSweepTick(void)
 bool
 have_free_buffer(void)
 {
-	if (StrategyControl->firstFreeBuffer >= 0)
-		return true;
-	else
-		return false;
+	for (int i = 0; i < StrategyControl->numPartitions; i++)
+	{
+		if (GetClockSweepPartition(i)->firstFreeBuffer >= 0)
+			return true;
+	}
+
+	return false;
 }
 
 /*
@@ -196,8 +270,12 @@ BufferDesc *
 StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state, bool *from_ring)
 {
 	BufferDesc *buf;
+	ClockSweepPartition *partition;
+	int			home;
+	int			part;
 	int			bgwprocno;
 	int			trycounter;
+	int			partsleft;
 	uint32		local_buf_state;	/* to avoid repeated (de-)referencing */
 
 	*from_ring = false;
@@ -242,80 +320,45 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state, bool *from_r
 		SetLatch(&ProcGlobal->allProcs[bgwprocno].procLatch);
 	}
 
+	home = ChooseClockSweepPartition();
+
 	/*
 	 * We count buffer allocation requests so that the bgwriter can estimate
 	 * the rate of buffer consumption.  Note that buffers recycled by a
 	 * strategy object are intentionally not counted here.
 	 */
-	pg_atomic_fetch_add_u32(&StrategyControl->numBufferAllocs, 1);
+	pg_atomic_fetch_add_u64(&GetClockSweepPartition(home)->numBufferAllocs, 1);
 
 	/*
-	 * First check, without acquiring the lock, whether there's buffers in the
-	 * freelist. Since we otherwise don't require the spinlock in every
-	 * StrategyGetBuffer() invocation, it'd be sad to acquire it here -
-	 * uselessly in most cases. That obviously leaves a race where a buffer is
-	 * put on the freelist but we don't see the store yet - but that's pretty
-	 * harmless, it'll just get used during the next buffer acquisition.
-	 *
-	 * If there's buffers on the freelist, acquire the spinlock to pop one
-	 * buffer of the freelist. Then check whether that buffer is usable and
-	 * repeat if not.
-	 *
-	 * Note that the freeNext fields are considered to be protected by the
-	 * buffer_strategy_lock not the individual buffer spinlocks, so it's OK to
-	 * manipulate them without holding the spinlock.
+	 * Take a buffer from the freelists if there are any, starting with the
+	 * home partition.  Until the buffer pool has filled up, that's where
+	 * most allocations come from, so don't let one partition run out of
+	 * free buffers while others still have some.
 	 */
-	if (StrategyControl->firstFreeBuffer >= 0)
+	part = home;
+	for (partsleft = StrategyControl->numPartitions; partsleft > 0; partsleft--)
 	{
-		while (true)
-		{
-			/* Acquire the spinlock to remove element from the freelist */
-			SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
-
-			if (StrategyControl->firstFreeBuffer < 0)
-			{
-				SpinLockRelease(&StrategyControl->buffer_strategy_lock);
-				break;
-			}
-
-			buf = GetBufferDescriptor(StrategyControl->firstFreeBuffer);
-			Assert(buf->freeNext != FREENEXT_NOT_IN_LIST);
-
-			/* Unconditionally remove buffer from freelist */
-			StrategyControl->firstFreeBuffer = buf->freeNext;
-			buf->freeNext = FREENEXT_NOT_IN_LIST;
-
-			/*
-			 * Release the lock so someone else can access the freelist while
-			 * we check out this buffer.
-			 */
-			SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+		buf = GetBufferFromFreelist(GetClockSweepPartition(part), strategy,
+									buf_state);
+		if (buf != NULL)
+			return buf;
 
-			/*
-			 * If the buffer is pinned or has a nonzero usage_count, we cannot
-			 * use it; discard it and retry.  (This can only happen if VACUUM
-			 * put a valid buffer in the freelist and then someone else used
-			 * it before we got to it.  It's probably impossible altogether as
-			 * of 8.3, but we'd better check anyway.)
-			 */
-			local_buf_state = LockBufHdr(buf);
-			if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0
-				&& BUF_STATE_GET_USAGECOUNT(local_buf_state) == 0)
-			{
-				if (strategy != NULL)
-					AddBufferToRing(strategy, buf);
-				*buf_state = local_buf_state;
-				return buf;
-			}
-			UnlockBufHdr(buf, local_buf_state);
-		}
+		if (++part >= StrategyControl->numPartitions)
+			part = 0;
 	}
 
-	/* Nothing on the freelist, so run the "clock sweep" algorithm */
-	trycounter = NBuffers;
+	/*
+	 * Nothing on the freelists, so run the "clock sweep" algorithm in the
+	 * home partition.  Only if all of its buffers are pinned, move on to the
+	 * next one.
+	 */
+	part = home;
+	partsleft = StrategyControl->numPartitions;
+	partition = GetClockSweepPartition(part);
+	trycounter = partition->numBuffers;
 	for (;;)
 	{
-		buf = GetBufferDescriptor(ClockSweepTick());
+		buf = GetBufferDescriptor(ClockSweepTick(partition));
 
 		/*
 		 * If the buffer is pinned or has a nonzero usage_count, we cannot use
@@ -329,7 +372,7 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state, bool *from_r
 			{
 				local_buf_state -= BUF_USAGECOUNT_ONE;
 
-				trycounter = NBuffers;
+				trycounter = partition->numBuffers;
 			}
 			else
 			{
@@ -343,14 +386,101 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state, bool *from_r
 		else if (--trycounter == 0)
 		{
 			/*
-			 * We've scanned all the buffers without making any state changes,
-			 * so all the buffers are pinned (or were when we looked at them).
-			 * We could hope that someone will free one eventually, but it's
-			 * probably better to fail than to risk getting stuck in an
-			 * infinite loop.
+			 * We've scanned all the buffers of this partition without making
+			 * any state changes, so all of them are pinned (or were when we
+			 * looked at them).  Try the next partition.
 			 */
-			UnlockBufHdr(buf, local_buf_state);
-			elog(ERROR, "no unpinned buffers available");
+			if (--partsleft == 0)
+			{
+				/*
+				 * All the buffers are pinned.  We could hope that someone will
+				 * free one eventually, but it's probably better to fail than
+				 * to risk getting stuck in an infinite loop.
+				 */
+				UnlockBufHdr(buf, local_buf_state);
+				elog(ERROR, "no unpinned buffers available");
+			}
+
+			if (++part >= StrategyControl->numPartitions)
+				part = 0;
+			partition = GetClockSweepPartition(part);
+			trycounter = partition->numBuffers;
+		}
+		UnlockBufHdr(buf, local_buf_state);
+	}
+}
+
+/*
+ * GetBufferFromFreelist -- pop a usable buffer from a partition's freelist
+ *
+ * Returns NULL if the freelist is empty.  Otherwise the buffer is returned
+ * with its header spinlock held, like StrategyGetBuffer().
+ */
+static BufferDesc *
+GetBufferFromFreelist(ClockSweepPartition *partition,
+					  BufferAccessStrategy strategy, uint32 *buf_state)
+{
+	BufferDesc *buf;
+	uint32		local_buf_state;
+
+	/*
+	 * First check, without acquiring the lock, whether there's buffers in the
+	 * freelist. Since we otherwise don't require the spinlock in every
+	 * StrategyGetBuffer() invocation, it'd be sad to acquire it here -
+	 * uselessly in most cases. That obviously leaves a race where a buffer is
+	 * put on the freelist but we don't see the store yet - but that's pretty
+	 * harmless, it'll just get used during the next buffer acquisition.
+	 *
+	 * If there's buffers on the freelist, acquire the spinlock to pop one
+	 * buffer of the freelist. Then check whether that buffer is usable and
+	 * repeat if not.
+	 *
+	 * Note that the freeNext fields are considered to be protected by the
+	 * buffer_strategy_lock not the individual buffer spinlocks, so it's OK to
+	 * manipulate them without holding the spinlock.
+	 */
+	if (partition->firstFreeBuffer < 0)
+		return NULL;
+
+	while (true)
+	{
+		/* Acquire the spinlock to remove element from the freelist */
+		SpinLockAcquire(&partition->buffer_strategy_lock);
+
+		if (partition->firstFreeBuffer < 0)
+		{
+			SpinLockRelease(&partition->buffer_strategy_lock);
+			return NULL;
+		}
+
+		buf = GetBufferDescriptor(partition->firstFreeBuffer);
+		Assert(buf->freeNext != FREENEXT_NOT_IN_LIST);
+
+		/* Unconditionally remove buffer from freelist */
+		partition->firstFreeBuffer = buf->freeNext;
+		buf->freeNext = FREENEXT_NOT_IN_LIST;
+
+		/*
+		 * Release the lock so someone else can access the freelist while we
+		 * check out this buffer.
+		 */
+		SpinLockRelease(&partition->buffer_strategy_lock);
+
+		/*
+		 * If the buffer is pinned or has a nonzero usage_count, we cannot use
+		 * it; discard it and retry.  (This can only happen if VACUUM put a
+		 * valid buffer in the freelist and then someone else used it before
+		 * we got to it.  It's probably impossible altogether as of 8.3, but
+		 * we'd better check anyway.)
+		 */
+		local_buf_state = LockBufHdr(buf);
+		if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0
+			&& BUF_STATE_GET_USAGECOUNT(local_buf_state) == 0)
+		{
+			if (strategy != NULL)
+				AddBufferToRing(strategy, buf);
+			*buf_state = local_buf_state;
+			return buf;
 		}
 		UnlockBufHdr(buf, local_buf_state);
 	}
@@ -362,7 +492,13 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state, bool *from_r
 void
 StrategyFreeBuffer(BufferDesc *buf)
 {
-	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+	ClockSweepPartition *partition;
+
+	/* the buffer goes back to the freelist of the partition it belongs to */
+	partition = GetClockSweepPartition(buf->buf_id /
+									   StrategyControl->partitionSize);
+
+	SpinLockAcquire(&partition->buffer_strategy_lock);
 
 	/*
 	 * It is possible that we are told to put something in the freelist that
@@ -370,13 +506,13 @@ StrategyFreeBuffer(BufferDesc *buf)
 	 */
 	if (buf->freeNext == FREENEXT_NOT_IN_LIST)
 	{
-		buf->freeNext = StrategyControl->firstFreeBuffer;
+		buf->freeNext = partition->firstFreeBuffer;
 		if (buf->freeNext < 0)
-			StrategyControl->lastFreeBuffer = buf->buf_id;
-		StrategyControl->firstFreeBuffer = buf->buf_id;
+			partition->lastFreeBuffer = buf->buf_id;
+		partition->firstFreeBuffer = buf->buf_id;
 	}
 
-	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+	SpinLockRelease(&partition->buffer_strategy_lock);
 }
 
 /*
@@ -389,34 +525,92 @@ StrategyFreeBuffer(BufferDesc *buf)
  * the higher-order bits of nextVictimBuffer) and the count of recent buffer
  * allocs if non-NULL pointers are passed.  The alloc count is reset after
  * being read.
+ *
+ * With several clock sweep partitions, there is no single clock hand to
+ * report.  We add up how far all the hands have advanced instead, and
+ * report that as if it was a single hand sweeping the whole buffer pool.
+ * That keeps the bgwriter's estimate of how fast buffers are being consumed
+ * accurate, even though its scan doesn't follow any particular hand.
  */
 int
 StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc)
 {
-	uint32		nextVictimBuffer;
-	int			result;
-
-	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
-	nextVictimBuffer = pg_atomic_read_u32(&StrategyControl->nextVictimBuffer);
-	result = nextVictimBuffer % NBuffers;
+	uint64		ticks = 0;
+	uint64		allocs = 0;
 
-	if (complete_passes)
+	for (int i = 0; i < StrategyControl->numPartitions; i++)
 	{
-		*complete_passes = StrategyControl->completePasses;
+		ClockSweepPartition *partition = GetClockSweepPartition(i);
+		uint32		nextVictimBuffer;
+
+		SpinLockAcquire(&partition->buffer_strategy_lock);
+		nextVictimBuffer = pg_atomic_read_u32(&partition->nextVictimBuffer);
 
 		/*
-		 * Additionally add the number of wraparounds that happened before
-		 * completePasses could be incremented. C.f. ClockSweepTick().
+		 * nextVictimBuffer may exceed numBuffers if a wraparound happened
+		 * before completePasses could be incremented, c.f.
+		 * ClockSweepTick().  That's accounted for correctly here too.
 		 */
-		*complete_passes += nextVictimBuffer / NBuffers;
+		ticks += (uint64) partition->completePasses * partition->numBuffers +
+			nextVictimBuffer;
+
+		if (num_buf_alloc)
+		{
+			uint64		total;
+
+			total = pg_atomic_read_u64(&partition->numBufferAllocs);
+			allocs += total - partition->syncBufferAllocs;
+			partition->syncBufferAllocs = total;
+		}
+		SpinLockRelease(&partition->buffer_strategy_lock);
 	}
 
+	if (complete_passes)
+		*complete_passes = (uint32) (ticks / NBuffers);
+
 	if (num_buf_alloc)
-	{
-		*num_buf_alloc = pg_atomic_exchange_u32(&StrategyControl->numBufferAllocs, 0);
-	}
-	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
-	return result;
+		*num_buf_alloc = (uint32) Min(allocs, PG_UINT32_MAX);
+
+	return (int) (ticks % NBuffers);
+}
+
+/*
+ * StrategyNumPartitions -- number of clock sweep partitions
+ */
+int
+StrategyNumPartitions(void)
+{
+	return StrategyControl->numPartitions;
+}
+
+/*
+ * StrategyGetPartitionStats -- report the state of a clock sweep partition
+ *
+ * This is for monitoring only, the values are not read consistently.
+ */
+void
+StrategyGetPartitionStats(int partno, int *first_buffer, int *num_buffers,
+						  uint32 *complete_passes, uint32 *next_victim_buffer,
+						  uint64 *buffer_allocs)
+{
+	ClockSweepPartition *partition;
+	uint32		nextVictimBuffer;
+
+	Assert(partno >= 0 && partno < StrategyControl->numPartitions);
+	partition = GetClockSweepPartition(partno);
+
+	*first_buffer = partition->firstBuffer;
+	*num_buffers = partition->numBuffers;
+
+	SpinLockAcquire(&partition->buffer_strategy_lock);
+	nextVictimBuffer = pg_atomic_read_u32(&partition->nextVictimBuffer);
+	*complete_passes = partition->completePasses +
+		nextVictimBuffer / partition->numBuffers;
+	*next_victim_buffer = partition->firstBuffer +
+		nextVictimBuffer % partition->numBuffers;
+	SpinLockRelease(&partition->buffer_strategy_lock);
+
+	*buffer_allocs = pg_atomic_read_u64(&partition->numBufferAllocs);
 }
 
 /*
@@ -431,13 +625,14 @@ void
 StrategyNotifyBgWriter(int bgwprocno)
 {
 	/*
-	 * We acquire buffer_strategy_lock just to ensure that the store appears
-	 * atomic to StrategyGetBuffer.  The bgwriter should call this rather
-	 * infrequently, so there's no performance penalty from being safe.
+	 * We acquire the first partition's buffer_strategy_lock just to ensure
+	 * that the store appears atomic to StrategyGetBuffer.  The bgwriter
+	 * should call this rather infrequently, so there's no performance
+	 * penalty from being safe.
 	 */
-	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+	SpinLockAcquire(&GetClockSweepPartition(0)->buffer_strategy_lock);
 	StrategyControl->bgwprocno = bgwprocno;
-	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+	SpinLockRelease(&GetClockSweepPartition(0)->buffer_strategy_lock);
 }
 
 
@@ -458,11 +653,28 @@ StrategyShmemSize(void)
 	size = add_size(size, BufTableShmemSize(NBuffers + NUM_BUFFER_PARTITIONS));
 
 	/* size of the shared replacement strategy control block */
-	size = add_size(size, MAXALIGN(sizeof(BufferStrategyControl)));
+	size = add_size(size, MAXALIGN(offsetof(BufferStrategyControl, partitions)));
+	size = add_size(size, mul_size(StrategyNumPartitionsForNBuffers(),
+								   sizeof(ClockSweepPartitionPadded)));
 
 	return size;
 }
 
+/*
+ * StrategyNumPartitionsForNBuffers -- how many partitions to create
+ *
+ * That's clock_sweep_partitions, unless the partitions would get too small.
+ */
+static int
+StrategyNumPartitionsForNBuffers(void)
+{
+	int			nparts;
+
+	nparts = Min(clock_sweep_partitions, NBuffers / MIN_BUFFERS_PER_PARTITION);
+
+	return Max(nparts, 1);
+}
+
 /*
  * StrategyInitialize -- initialize the buffer cache replacement
  *		strategy.
@@ -474,6 +686,7 @@ void
 StrategyInitialize(bool init)
 {
 	bool		found;
+	int			nparts = StrategyNumPartitionsForNBuffers();
 
 	/*
 	 * Initialize the shared buffer lookup hashtable.
@@ -492,31 +705,58 @@ StrategyInitialize(bool init)
 	 */
 	StrategyControl = (BufferStrategyControl *)
 		ShmemInitStruct("Buffer Strategy Status",
-						sizeof(BufferStrategyControl),
+						add_size(offsetof(BufferStrategyControl, partitions),
+								 mul_size(nparts,
+										  sizeof(ClockSweepPartitionPadded))),
 						&found);
 
 	if (!found)
 	{
+		int			partsize;
+
 		/*
 		 * Only done once, usually in postmaster
 		 */
 		Assert(init);
 
-		SpinLockInit(&StrategyControl->buffer_strategy_lock);
-
 		/*
-		 * Grab the whole linked list of free buffers for our strategy. We
-		 * assume it was previously set up by InitBufferPool().
+		 * Divide the buffers into partitions of equal size, except that the
+		 * last one may be smaller.
 		 */
-		StrategyControl->firstFreeBuffer = 0;
-		StrategyControl->lastFreeBuffer = NBuffers - 1;
+		partsize = (NBuffers + nparts - 1) / nparts;
+		nparts = (NBuffers + partsize - 1) / partsize;
+		StrategyControl->numPartitions = nparts;
+		StrategyControl->partitionSize = partsize;
+
+		for (int i = 0; i < nparts; i++)
+		{
+			ClockSweepPartition *partition = GetClockSweepPartition(i);
+
+			SpinLockInit(&partition->buffer_strategy_lock);
 
-		/* Initialize the clock sweep pointer */
-		pg_atomic_init_u32(&StrategyControl->nextVictimBuffer, 0);
+			partition->firstBuffer = i * partsize;
+			partition->numBuffers = Min(partsize, NBuffers - i * partsize);
 
-		/* Clear statistics */
-		StrategyControl->completePasses = 0;
-		pg_atomic_init_u32(&StrategyControl->numBufferAllocs, 0);
+			/*
+			 * Grab the partition's part of the linked list of free buffers.
+			 * We assume the whole list was previously set up by
+			 * InitBufferPool(), so it just needs to be cut at the end of the
+			 * partition.
+			 */
+			partition->firstFreeBuffer = partition->firstBuffer;
+			partition->lastFreeBuffer =
+				partition->firstBuffer + partition->numBuffers - 1;
+			GetBufferDescriptor(partition->lastFreeBuffer)->freeNext =
+				FREENEXT_END_OF_LIST;
+
+			/* Initialize the clock sweep pointer */
+			pg_atomic_init_u32(&partition->nextVictimBuffer, 0);
+
+			/* Clear statistics */
+			partition->completePasses = 0;
+			pg_atomic_init_u64(&partition->numBufferAllocs, 0);
+			partition->syncBufferAllocs = 0;
+		}
 
 		/* No pending notification */
 		StrategyControl->bgwprocno = -1;
@@ -95,6 +95,7 @@
 #include "pgstat.h"
 #include "portability/mem.h"
 #include "postmaster/startup.h"
+#include "storage/aio.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
 #include "utils/guc.h"
@@ -2106,6 +2107,44 @@ retry:
 #endif
 }
 
+/*
+ * FileStartRead - start an asynchronous read of a given range of the file
+ * into the memory of an I/O handle obtained from pgaio_io_acquire().
+ *
+ * Returns 0 if the read was started, or -1 with errno set if the file
+ * couldn't be accessed or the read couldn't be submitted.  The caller must
+ * wait for the result with pgaio_io_wait() and deal with short reads.
+ */
+int
+FileStartRead(struct PgAioHandle *ioh, File file, off_t offset, size_t amount,
+			  uint32 wait_event_info)
+{
+	int			returnCode;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileStartRead: %d (%s) " INT64_FORMAT " %zu",
+			   file, VfdCache[file].fileName,
+			   (int64) offset, amount));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+	/*
+	 * The kernel holds its own reference to the file while the read is in
+	 * flight, so it doesn't matter if the VFD is closed before it completes.
+	 */
+	if (!pgaio_io_start_read(ioh, VfdCache[file].fd, offset, amount,
+							 wait_event_info))
+	{
+		errno = EIO;
+		return -1;
+	}
+
+	return 0;
+}
+
 void
 FileWriteback(File file, off_t offset, off_t nbytes, uint32 wait_event_info)
 {
@@ -1116,6 +1116,80 @@ ModifyWaitEvent(WaitEventSet *set, int pos, uint32 events, Latch *latch)
 #endif
 }
 
+/*
+ * Remove a socket event from the set.
+ *
+ * To keep the events array dense, the last event in the set is moved into
+ * the freed position.  Its user_data pointer is returned, so that the caller
+ * can update the position it remembered for it; NULL is returned if no event
+ * was moved.  Only socket events can be removed, and the last event must be
+ * a socket event too.
+ *
+ * 'pos' is the id returned by AddWaitEventToSet.
+ */
+void *
+RemoveWaitEvent(WaitEventSet *set, int pos)
+{
+	WaitEvent  *event;
+	WaitEvent  *last;
+
+	Assert(pos < set->nevents);
+
+	event = &set->events[pos];
+	last = &set->events[set->nevents - 1];
+
+	if (!(event->events & WL_SOCKET_MASK) || !(last->events & WL_SOCKET_MASK))
+		elog(ERROR, "cannot remove non-socket wait event");
+
+#if defined(WAIT_USE_EPOLL)
+	WaitEventAdjustEpoll(set, event, EPOLL_CTL_DEL);
+#elif defined(WAIT_USE_KQUEUE)
+	{
+		struct kevent k_ev[2];
+		int			count = 0;
+
+		if (event->events & (WL_SOCKET_READABLE | WL_SOCKET_CLOSED))
+			WaitEventAdjustKqueueAdd(&k_ev[count++], EVFILT_READ, EV_DELETE,
+									 event);
+		if (event->events & WL_SOCKET_WRITEABLE)
+			WaitEventAdjustKqueueAdd(&k_ev[count++], EVFILT_WRITE, EV_DELETE,
+									 event);
+		if (count > 0 &&
+			kevent(set->kqueue_fd, &k_ev[0], count, NULL, 0, NULL) < 0)
+			ereport(ERROR,
+					(errcode_for_socket_access(),
+					 errmsg("%s() failed: %m",
+							"kevent")));
+	}
+#elif defined(WAIT_USE_WIN32)
+	WSAEventSelect(event->fd, NULL, 0);
+	WSACloseEvent(set->handles[pos + 1]);
+	set->handles[pos + 1] = WSA_INVALID_EVENT;
+#endif
+
+	set->nevents--;
+	if (event == last)
+		return NULL;
+
+	/* Move the last event into the hole, and re-register it at its new place */
+	*event = *last;
+	event->pos = pos;
+
+#if defined(WAIT_USE_EPOLL)
+	WaitEventAdjustEpoll(set, event, EPOLL_CTL_MOD);
+#elif defined(WAIT_USE_KQUEUE)
+	/* EV_ADD of an existing filter just updates its udata */
+	WaitEventAdjustKqueue(set, event, 0);
+#elif defined(WAIT_USE_POLL)
+	WaitEventAdjustPoll(set, event);
+#elif defined(WAIT_USE_WIN32)
+	set->handles[pos + 1] = set->handles[set->nevents + 1];
+	set->handles[set->nevents + 1] = WSA_INVALID_EVENT;
+#endif
+
+	return event->user_data;
+}
+
 #if defined(WAIT_USE_EPOLL)
 /*
  * action can be one of EPOLL_CTL_ADD | EPOLL_CTL_MOD | EPOLL_CTL_DEL
@@ -47,6 +47,7 @@
 
 #include <signal.h>
 
+#include "access/csnlog.h"
 #include "access/subtrans.h"
 #include "access/transam.h"
 #include "access/twophase.h"
@@ -368,6 +369,12 @@ static void MaintainLatestCompletedXidRecovery(TransactionId latestXid);
 static inline FullTransactionId FullXidRelativeTo(FullTransactionId rel,
 												  TransactionId xid);
 static void GlobalVisUpdateApply(ComputeXidHorizonsResult *horizons);
+static void GlobalVisUpdateFromSnapshot(TransactionId xmin, TransactionId myxid,
+										FullTransactionId latest_completed,
+										TransactionId oldestxid,
+										TransactionId replication_slot_xmin,
+										TransactionId replication_slot_catalog_xmin);
+static void GetCSNSnapshotData(Snapshot snapshot);
 
 /*
  * Report shared-memory space needed by CreateSharedProcArray.
@@ -2226,6 +2233,16 @@ GetSnapshotData(Snapshot snapshot)
 					 errmsg("out of memory")));
 	}
 
+	/*
+	 * With csn_snapshots, no lock is needed.  Snapshots taken during recovery
+	 * use KnownAssignedXids as usual.
+	 */
+	if (CSNLogIsActive() && !RecoveryInProgress())
+	{
+		GetCSNSnapshotData(snapshot);
+		return snapshot;
+	}
+
 	/*
 	 * It is sufficient to get shared lock on ProcArrayLock, even if we are
 	 * going to set MyProc->xmin.
@@ -2418,108 +2435,281 @@ GetSnapshotData(Snapshot snapshot)
 	LWLockRelease(ProcArrayLock);
 
 	/* maintain state for GlobalVis* */
-	{
-		TransactionId def_vis_xid;
-		TransactionId def_vis_xid_data;
-		FullTransactionId def_vis_fxid;
-		FullTransactionId def_vis_fxid_data;
-		FullTransactionId oldestfxid;
+	GlobalVisUpdateFromSnapshot(xmin, myxid, latest_completed, oldestxid,
+								replication_slot_xmin,
+								replication_slot_catalog_xmin);
 
-		/*
-		 * Converting oldestXid is only safe when xid horizon cannot advance,
-		 * i.e. holding locks. While we don't hold the lock anymore, all the
-		 * necessary data has been gathered with lock held.
-		 */
-		oldestfxid = FullXidRelativeTo(latest_completed, oldestxid);
+	RecentXmin = xmin;
+	Assert(TransactionIdPrecedesOrEquals(TransactionXmin, RecentXmin));
 
-		/* Check whether there's a replication slot requiring an older xmin. */
-		def_vis_xid_data =
-			TransactionIdOlder(xmin, replication_slot_xmin);
+	snapshot->xmin = xmin;
+	snapshot->xmax = xmax;
+	snapshot->xcnt = count;
+	snapshot->subxcnt = subcount;
+	snapshot->suboverflowed = suboverflowed;
+	snapshot->snapshotCsn = InvalidCommitSeqNo;
+	snapshot->snapXactCompletionCount = curXactCompletionCount;
 
-		/*
-		 * Rows in non-shared, non-catalog tables possibly could be vacuumed
-		 * if older than this xid.
-		 */
-		def_vis_xid = def_vis_xid_data;
+	snapshot->curcid = GetCurrentCommandId(false);
 
-		/*
-		 * Check whether there's a replication slot requiring an older catalog
-		 * xmin.
-		 */
-		def_vis_xid =
-			TransactionIdOlder(replication_slot_catalog_xmin, def_vis_xid);
+	/*
+	 * This is a new snapshot, so set both refcounts are zero, and mark it as
+	 * not copied in persistent memory.
+	 */
+	snapshot->active_count = 0;
+	snapshot->regd_count = 0;
+	snapshot->copied = false;
+	snapshot->lsn = InvalidXLogRecPtr;
+	snapshot->whenTaken = 0;
 
-		def_vis_fxid = FullXidRelativeTo(latest_completed, def_vis_xid);
-		def_vis_fxid_data = FullXidRelativeTo(latest_completed, def_vis_xid_data);
+	return snapshot;
+}
 
-		/*
-		 * Check if we can increase upper bound. As a previous
-		 * GlobalVisUpdate() might have computed more aggressive values, don't
-		 * overwrite them if so.
-		 */
-		GlobalVisSharedRels.definitely_needed =
-			FullTransactionIdNewer(def_vis_fxid,
-								   GlobalVisSharedRels.definitely_needed);
-		GlobalVisCatalogRels.definitely_needed =
-			FullTransactionIdNewer(def_vis_fxid,
-								   GlobalVisCatalogRels.definitely_needed);
-		GlobalVisDataRels.definitely_needed =
-			FullTransactionIdNewer(def_vis_fxid_data,
-								   GlobalVisDataRels.definitely_needed);
-		/* See temp_oldest_nonremovable computation in ComputeXidHorizons() */
-		if (TransactionIdIsNormal(myxid))
-			GlobalVisTempRels.definitely_needed =
-				FullXidRelativeTo(latest_completed, myxid);
-		else
+/*
+ * Advance the bounds of GlobalVis{Shared,Catalog,Data,Temp}Rels after
+ * taking a snapshot, see GetSnapshotData().
+ */
+static void
+GlobalVisUpdateFromSnapshot(TransactionId xmin, TransactionId myxid,
+							FullTransactionId latest_completed,
+							TransactionId oldestxid,
+							TransactionId replication_slot_xmin,
+							TransactionId replication_slot_catalog_xmin)
+{
+	TransactionId def_vis_xid;
+	TransactionId def_vis_xid_data;
+	FullTransactionId def_vis_fxid;
+	FullTransactionId def_vis_fxid_data;
+	FullTransactionId oldestfxid;
+
+	/*
+	 * Converting oldestXid is only safe when xid horizon cannot advance,
+	 * i.e. holding locks. While we don't hold the lock anymore, all the
+	 * necessary data has been gathered with lock held (or, for CSN
+	 * snapshots, read in an order that makes it safe, see
+	 * GetCSNSnapshotData()).
+	 */
+	oldestfxid = FullXidRelativeTo(latest_completed, oldestxid);
+
+	/* Check whether there's a replication slot requiring an older xmin. */
+	def_vis_xid_data =
+		TransactionIdOlder(xmin, replication_slot_xmin);
+
+	/*
+	 * Rows in non-shared, non-catalog tables possibly could be vacuumed
+	 * if older than this xid.
+	 */
+	def_vis_xid = def_vis_xid_data;
+
+	/*
+	 * Check whether there's a replication slot requiring an older catalog
+	 * xmin.
+	 */
+	def_vis_xid =
+		TransactionIdOlder(replication_slot_catalog_xmin, def_vis_xid);
+
+	def_vis_fxid = FullXidRelativeTo(latest_completed, def_vis_xid);
+	def_vis_fxid_data = FullXidRelativeTo(latest_completed, def_vis_xid_data);
+
+	/*
+	 * Check if we can increase upper bound. As a previous
+	 * GlobalVisUpdate() might have computed more aggressive values, don't
+	 * overwrite them if so.
+	 */
+	GlobalVisSharedRels.definitely_needed =
+		FullTransactionIdNewer(def_vis_fxid,
+							   GlobalVisSharedRels.definitely_needed);
+	GlobalVisCatalogRels.definitely_needed =
+		FullTransactionIdNewer(def_vis_fxid,
+							   GlobalVisCatalogRels.definitely_needed);
+	GlobalVisDataRels.definitely_needed =
+		FullTransactionIdNewer(def_vis_fxid_data,
+							   GlobalVisDataRels.definitely_needed);
+	/* See temp_oldest_nonremovable computation in ComputeXidHorizons() */
+	if (TransactionIdIsNormal(myxid))
+		GlobalVisTempRels.definitely_needed =
+			FullXidRelativeTo(latest_completed, myxid);
+	else
+	{
+		GlobalVisTempRels.definitely_needed = latest_completed;
+		FullTransactionIdAdvance(&GlobalVisTempRels.definitely_needed);
+	}
+
+	/*
+	 * Check if we know that we can initialize or increase the lower
+	 * bound. Currently the only cheap way to do so is to use
+	 * TransamVariables->oldestXid as input.
+	 *
+	 * We should definitely be able to do better. We could e.g. put a
+	 * global lower bound value into TransamVariables.
+	 */
+	GlobalVisSharedRels.maybe_needed =
+		FullTransactionIdNewer(GlobalVisSharedRels.maybe_needed,
+							   oldestfxid);
+	GlobalVisCatalogRels.maybe_needed =
+		FullTransactionIdNewer(GlobalVisCatalogRels.maybe_needed,
+							   oldestfxid);
+	GlobalVisDataRels.maybe_needed =
+		FullTransactionIdNewer(GlobalVisDataRels.maybe_needed,
+							   oldestfxid);
+	/* accurate value known */
+	GlobalVisTempRels.maybe_needed = GlobalVisTempRels.definitely_needed;
+}
+
+/*
+ * GetCSNSnapshotData -- GetSnapshotData() for csn_snapshots
+ *
+ * Instead of a list of running XIDs, the snapshot records the next commit
+ * sequence number to be assigned; XIDs between xmin and xmax are looked up
+ * in pg_csn.  xmin is the conservative lower bound on running XIDs kept by
+ * csnlog.c, so no ProcArray scan and no ProcArrayLock is needed.
+ */
+static void
+GetCSNSnapshotData(Snapshot snapshot)
+{
+	TransactionId xmin;
+	TransactionId xmax;
+	TransactionId myxid = MyProc->xid;
+	FullTransactionId next_fxid;
+	FullTransactionId latest_completed;
+	TransactionId oldestxid;
+	CommitSeqNo csn;
+
+	/*
+	 * Advertise the xmin before reading the CSN.  Anyone computing a horizon
+	 * after that sees our xmin, and anyone who computed it earlier saw every
+	 * transaction that could commit after our snapshot as still running.
+	 *
+	 * If this is our first snapshot, the bound must not have advanced past
+	 * the xmin we advertise in the meantime, otherwise a concurrent
+	 * checkpoint might truncate pg_csn data we still need.
+	 */
+	for (;;)
+	{
+		xmin = CSNLogGetSnapshotXmin(true);
+
+		if (TransactionIdIsValid(MyProc->xmin))
 		{
-			GlobalVisTempRels.definitely_needed = latest_completed;
-			FullTransactionIdAdvance(&GlobalVisTempRels.definitely_needed);
+			if (TransactionIdPrecedes(xmin, TransactionXmin))
+				xmin = TransactionXmin;
+			break;
 		}
 
-		/*
-		 * Check if we know that we can initialize or increase the lower
-		 * bound. Currently the only cheap way to do so is to use
-		 * TransamVariables->oldestXid as input.
-		 *
-		 * We should definitely be able to do better. We could e.g. put a
-		 * global lower bound value into TransamVariables.
-		 */
-		GlobalVisSharedRels.maybe_needed =
-			FullTransactionIdNewer(GlobalVisSharedRels.maybe_needed,
-								   oldestfxid);
-		GlobalVisCatalogRels.maybe_needed =
-			FullTransactionIdNewer(GlobalVisCatalogRels.maybe_needed,
-								   oldestfxid);
-		GlobalVisDataRels.maybe_needed =
-			FullTransactionIdNewer(GlobalVisDataRels.maybe_needed,
-								   oldestfxid);
-		/* accurate value known */
-		GlobalVisTempRels.maybe_needed = GlobalVisTempRels.definitely_needed;
+		MyProc->xmin = TransactionXmin = xmin;
+		pg_memory_barrier();
+		if (CSNLogGetSnapshotXmin(false) == xmin)
+			break;
+
+		MyProc->xmin = TransactionXmin = InvalidTransactionId;
 	}
+	pg_memory_barrier();
+
+	/*
+	 * Read the CSN before nextXid.  Every transaction with a smaller CSN got
+	 * its XID before it committed, so it precedes xmax.
+	 */
+	csn = CSNLogGetNextCSN();
+	pg_read_barrier();
+	next_fxid = CSNLogGetNextXid();
+	xmax = XidFromFullTransactionId(next_fxid);
+	Assert(TransactionIdIsNormal(xmax));
+
+	/*
+	 * Nothing at or after nextXid can have completed.  That's good enough as
+	 * a reference point for GlobalVis, which only needs conservative values
+	 * here; the GlobalVisTest* functions fall back to computing accurate
+	 * horizons if needed.
+	 */
+	latest_completed = next_fxid;
+	FullTransactionIdRetreat(&latest_completed);
+	oldestxid = TransamVariables->oldestXid;
+
+	GlobalVisUpdateFromSnapshot(xmin, myxid, latest_completed, oldestxid,
+								procArray->replication_slot_xmin,
+								procArray->replication_slot_catalog_xmin);
 
 	RecentXmin = xmin;
 	Assert(TransactionIdPrecedesOrEquals(TransactionXmin, RecentXmin));
 
 	snapshot->xmin = xmin;
 	snapshot->xmax = xmax;
-	snapshot->xcnt = count;
-	snapshot->subxcnt = subcount;
-	snapshot->suboverflowed = suboverflowed;
-	snapshot->snapXactCompletionCount = curXactCompletionCount;
+	snapshot->xcnt = 0;
+	snapshot->subxcnt = 0;
+	snapshot->suboverflowed = false;
+	snapshot->takenDuringRecovery = false;
+	snapshot->snapshotCsn = csn;
+
+	/* never reused, see GetSnapshotDataReuse() */
+	snapshot->snapXactCompletionCount = 0;
 
 	snapshot->curcid = GetCurrentCommandId(false);
 
-	/*
-	 * This is a new snapshot, so set both refcounts are zero, and mark it as
-	 * not copied in persistent memory.
-	 */
 	snapshot->active_count = 0;
 	snapshot->regd_count = 0;
 	snapshot->copied = false;
 	snapshot->lsn = InvalidXLogRecPtr;
 	snapshot->whenTaken = 0;
+}
 
-	return snapshot;
+/*
+ * GetCSNSnapshotRunningXids -- list the XIDs a CSN snapshot considers running
+ *
+ * CSN snapshots have no xip array, so for pg_current_snapshot() we collect
+ * the top-level XIDs from the ProcArray, as GetSnapshotData() does.  A
+ * transaction that has finished since the snapshot was taken is no longer
+ * there, so it is missing from the result even if the snapshot still sees
+ * it as running.
+ *
+ * The result is palloc'd; *nxids is set to the number of entries.
+ */
+TransactionId *
+GetCSNSnapshotRunningXids(Snapshot snapshot, int *nxids)
+{
+	ProcArrayStruct *arrayP = procArray;
+	TransactionId *other_xids = ProcGlobal->xids;
+	TransactionId *xids;
+	int			count = 0;
+	int			nrunning = 0;
+
+	Assert(snapshot->snapshotCsn != InvalidCommitSeqNo);
+
+	/* allocate what's certainly enough result space */
+	xids = (TransactionId *) palloc(sizeof(TransactionId) * arrayP->maxProcs);
+
+	LWLockAcquire(ProcArrayLock, LW_SHARED);
+
+	for (int pgxactoff = 0; pgxactoff < arrayP->numProcs; pgxactoff++)
+	{
+		/* Fetch xid just once - see GetNewTransactionId */
+		TransactionId xid = UINT32_ACCESS_ONCE(other_xids[pgxactoff]);
+
+		/* Like GetSnapshotData(), leave out our own XID */
+		if (pgxactoff == MyProc->pgxactoff)
+			continue;
+
+		/* Skip XIDs assigned after the snapshot was taken */
+		if (!TransactionIdIsNormal(xid) ||
+			!TransactionIdPrecedes(xid, snapshot->xmax))
+			continue;
+
+		xids[count++] = xid;
+	}
+
+	LWLockRelease(ProcArrayLock);
+
+	/*
+	 * A transaction that committed just before the snapshot was taken might
+	 * not have cleared its XID yet.  Leave out those the snapshot sees as
+	 * committed, looking them up after releasing the lock.
+	 */
+	for (int i = 0; i < count; i++)
+	{
+		if (XidInMVCCSnapshot(xids[i], snapshot))
+			xids[nrunning++] = xids[i];
+	}
+
+	*nxids = nrunning;
+	return xids;
 }
 
 /*
@@ -169,6 +169,12 @@ static const char *const BuiltinTrancheNames[] = {
 	[LWTRANCHE_SUBTRANS_SLRU] = "SubtransSLRU",
 	[LWTRANCHE_XACT_SLRU] = "XactSLRU",
 	[LWTRANCHE_PARALLEL_VACUUM_DSA] = "ParallelVacuumDSA",
+	[LWTRANCHE_CSN_BUFFER] = "CSNBuffer",
+	[LWTRANCHE_CSN_SLRU] = "CSNSLRU",
+	[LWTRANCHE_SHARED_PLAN_CACHE_DSA] = "SharedPlanCacheDSA",
+	[LWTRANCHE_SHARED_PLAN_CACHE_HASH] = "SharedPlanCacheHash",
+	[LWTRANCHE_SHARED_CATCACHE_DSA] = "SharedCatCacheDSA",
+	[LWTRANCHE_SHARED_CATCACHE_HASH] = "SharedCatCacheHash",
 };
 
 StaticAssertDecl(lengthof(BuiltinTrancheNames) ==
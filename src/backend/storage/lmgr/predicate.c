@@ -198,6 +198,7 @@
 #include "postgres.h"
 
 #include "access/parallel.h"
+#include "access/csnlog.h"
 #include "access/slru.h"
 #include "access/transam.h"
 #include "access/twophase.h"
@@ -3974,6 +3975,10 @@ XidIsConcurrent(TransactionId xid)
 	if (TransactionIdFollowsOrEquals(xid, snap->xmax))
 		return true;
 
+	/* CSN snapshots have no xip array, so use the regular visibility test */
+	if (snap->snapshotCsn != InvalidCommitSeqNo)
+		return XidInMVCCSnapshot(xid, snap);
+
 	return pg_lfind32(xid, snap->xip, snap->xcnt);
 }
 
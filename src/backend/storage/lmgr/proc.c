@@ -91,6 +91,7 @@ static void RemoveProcFromArray(int code, Datum arg);
 static void ProcKill(int code, Datum arg);
 static void AuxiliaryProcKill(int code, Datum arg);
 static void CheckDeadLock(void);
+static Size FastPathLockShmemSizePerProc(void);
 
 
 /*
@@ -112,6 +113,25 @@ ProcGlobalShmemSize(void)
 	size = add_size(size, mul_size(TotalProcs, sizeof(*ProcGlobal->subxidStates)));
 	size = add_size(size, mul_size(TotalProcs, sizeof(*ProcGlobal->statusFlags)));
 
+	/* fast-path lock arrays, sized by fast_path_locks_per_backend */
+	size = add_size(size, mul_size(TotalProcs, FastPathLockShmemSizePerProc()));
+
+	return size;
+}
+
+/*
+ * Report the space needed for the fast-path lock arrays of one PGPROC.
+ */
+static Size
+FastPathLockShmemSizePerProc(void)
+{
+	Size		size = 0;
+
+	size = add_size(size, MAXALIGN(mul_size(FastPathLockGroupsPerBackend,
+											sizeof(uint64))));
+	size = add_size(size, MAXALIGN(mul_size(FastPathLockSlotsPerBackend(),
+											sizeof(Oid))));
+
 	return size;
 }
 
@@ -161,6 +181,8 @@ InitProcGlobal(void)
 				j;
 	bool		found;
 	uint32		TotalProcs = MaxBackends + NUM_AUXILIARY_PROCS + max_prepared_xacts;
+	char	   *fpPtr,
+			   *fpEndPtr PG_USED_FOR_ASSERTS_ONLY;
 
 	/* Create the ProcGlobal shared structure */
 	ProcGlobal = (PROC_HDR *)
@@ -211,12 +233,28 @@ InitProcGlobal(void)
 	ProcGlobal->statusFlags = (uint8 *) ShmemAlloc(TotalProcs * sizeof(*ProcGlobal->statusFlags));
 	MemSet(ProcGlobal->statusFlags, 0, TotalProcs * sizeof(*ProcGlobal->statusFlags));
 
+	/*
+	 * Allocate the fast-path lock arrays of all PGPROCs in one chunk.  Their
+	 * size depends on fast_path_locks_per_backend, so they can't be embedded
+	 * in PGPROC itself.
+	 */
+	fpPtr = ShmemAlloc(TotalProcs * FastPathLockShmemSizePerProc());
+	MemSet(fpPtr, 0, TotalProcs * FastPathLockShmemSizePerProc());
+	fpEndPtr = fpPtr + TotalProcs * FastPathLockShmemSizePerProc();
+
 	for (i = 0; i < TotalProcs; i++)
 	{
 		PGPROC	   *proc = &procs[i];
 
 		/* Common initialization for all PGPROCs, regardless of type. */
 
+		/* Point the PGPROC at its fast-path lock arrays */
+		proc->fpLockBits = (uint64 *) fpPtr;
+		fpPtr += MAXALIGN(FastPathLockGroupsPerBackend * sizeof(uint64));
+		proc->fpRelId = (Oid *) fpPtr;
+		fpPtr += MAXALIGN(FastPathLockSlotsPerBackend() * sizeof(Oid));
+		Assert(fpPtr <= fpEndPtr);
+
 		/*
 		 * Set up per-PGPROC semaphore, latch, and fpInfoLock.  Prepared xact
 		 * dummy PGPROCs don't need these though - they're never associated
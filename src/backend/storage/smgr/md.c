@@ -25,6 +25,7 @@
 #include <fcntl.h>
 #include <sys/file.h>
 
+#include "access/xlogparallel.h"
 #include "access/xlogutils.h"
 #include "commands/tablespace.h"
 #include "common/file_utils.h"
@@ -751,6 +752,46 @@ mdprefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	return true;
 }
 
+/*
+ * mdstartreadv() -- Start an asynchronous read of a block range into the
+ *				   memory of an I/O handle.
+ *
+ * Only blocks from a single segment file can be covered by one read, so the
+ * number of blocks actually requested is returned, which may be fewer than
+ * nblocks.  Returns 0 if the read couldn't be started; the caller should then
+ * read the blocks synchronously with mdreadv(), which will report any error.
+ */
+int
+mdstartreadv(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+			 int nblocks, struct PgAioHandle *ioh)
+{
+	off_t		seekpos;
+	MdfdVec    *v;
+	int			nblocks_this_segment;
+
+	if ((uint64) blocknum + nblocks > (uint64) MaxBlockNumber + 1)
+		return 0;
+
+	v = _mdfd_getseg(reln, forknum, blocknum, false, EXTENSION_RETURN_NULL);
+	if (v == NULL)
+		return 0;
+
+	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
+
+	Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+
+	nblocks_this_segment =
+		Min(nblocks,
+			RELSEG_SIZE - (blocknum % ((BlockNumber) RELSEG_SIZE)));
+
+	if (FileStartRead(ioh, v->mdfd_vfd, seekpos,
+					  (size_t) BLCKSZ * nblocks_this_segment,
+					  WAIT_EVENT_DATA_FILE_READ) < 0)
+		return 0;
+
+	return nblocks_this_segment;
+}
+
 /*
  * Convert an array of buffer address into an array of iovec objects, and
  * return the number that were required.  'iov' must have enough space for up
@@ -1470,6 +1511,10 @@ DropRelationFiles(RelFileLocator *delrels, int ndelrels, bool isRedo)
 	for (i = 0; i < ndelrels; i++)
 		smgrclose(srels[i]);
 	pfree(srels);
+
+	/* Parallel redo workers might still have the files open */
+	if (isRedo)
+		ParallelRedoReleaseFiles();
 }
 
 
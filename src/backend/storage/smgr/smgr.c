@@ -88,6 +88,9 @@ typedef struct f_smgr
 									BlockNumber blocknum, int nblocks, bool skipFsync);
 	bool		(*smgr_prefetch) (SMgrRelation reln, ForkNumber forknum,
 								  BlockNumber blocknum, int nblocks);
+	int			(*smgr_startreadv) (SMgrRelation reln, ForkNumber forknum,
+									BlockNumber blocknum, int nblocks,
+									struct PgAioHandle *ioh);
 	void		(*smgr_readv) (SMgrRelation reln, ForkNumber forknum,
 							   BlockNumber blocknum,
 							   void **buffers, BlockNumber nblocks);
@@ -117,6 +120,7 @@ static const f_smgr smgrsw[] = {
 		.smgr_extend = mdextend,
 		.smgr_zeroextend = mdzeroextend,
 		.smgr_prefetch = mdprefetch,
+		.smgr_startreadv = mdstartreadv,
 		.smgr_readv = mdreadv,
 		.smgr_writev = mdwritev,
 		.smgr_writeback = mdwriteback,
@@ -346,6 +350,20 @@ smgrdestroyall(void)
 	}
 }
 
+/*
+ * smgrresetnblocks() -- Forget the cached sizes of all forks of a relation.
+ *
+ * Sizes are only cached in recovery, where the startup process normally is
+ * the only one to change them.  Parallel redo workers extend relations too,
+ * so each process forgets the sizes when another one might have changed them.
+ */
+void
+smgrresetnblocks(SMgrRelation reln)
+{
+	for (ForkNumber forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+		reln->smgr_cached_nblocks[forknum] = InvalidBlockNumber;
+}
+
 /*
  * smgrreleaseall() -- Release resources used by all objects.
  */
@@ -588,6 +606,22 @@ smgrprefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	return smgrsw[reln->smgr_which].smgr_prefetch(reln, forknum, blocknum, nblocks);
 }
 
+/*
+ * smgrstartreadv() -- Start an asynchronous read of a block range into the
+ *					  memory of an I/O handle.
+ *
+ * Returns the number of blocks, starting at blocknum, that the read covers.
+ * This may be fewer than nblocks, or zero if the read couldn't be started at
+ * all, in which case the caller should use smgrreadv() instead.
+ */
+int
+smgrstartreadv(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+			   int nblocks, struct PgAioHandle *ioh)
+{
+	return smgrsw[reln->smgr_which].smgr_startreadv(reln, forknum, blocknum,
+													nblocks, ioh);
+}
+
 /*
  * smgrreadv() -- read a particular block range from a relation into the
  *				 supplied buffers.
@@ -26,6 +26,7 @@
 #include "libpq/pqsignal.h"
 #include "miscadmin.h"
 #include "postmaster/postmaster.h"
+#include "postmaster/sessionpool.h"
 #include "replication/walsender.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
@@ -40,7 +41,8 @@
 /* GUCs */
 bool		Trace_connection_negotiation = false;
 
-static void BackendInitialize(ClientSocket *client_sock, CAC_state cac);
+static void BackendInitialize(ClientSocket *client_sock, CAC_state cac,
+							  char *pooled_session, size_t pooled_session_len);
 static int	ProcessSSLStartup(Port *port);
 static int	ProcessStartupPacket(Port *port, bool ssl_done, bool gss_done);
 static void SendNegotiateProtocolVersion(List *unrecognized_protocol_options);
@@ -58,7 +60,8 @@ BackendMain(char *startup_data, size_t startup_data_len)
 {
 	BackendStartupData *bsdata = (BackendStartupData *) startup_data;
 
-	Assert(startup_data_len == sizeof(BackendStartupData));
+	Assert(startup_data_len ==
+		   offsetof(BackendStartupData, pooled_session) + bsdata->pooled_session_len);
 	Assert(MyClientSocket != NULL);
 
 #ifdef EXEC_BACKEND
@@ -88,7 +91,9 @@ BackendMain(char *startup_data, size_t startup_data_len)
 #endif
 
 	/* Perform additional initialization and collect startup packet */
-	BackendInitialize(MyClientSocket, bsdata->canAcceptConnections);
+	BackendInitialize(MyClientSocket, bsdata->canAcceptConnections,
+					  bsdata->pooled_session_len > 0 ? bsdata->pooled_session : NULL,
+					  bsdata->pooled_session_len);
 
 	/*
 	 * Create a per-backend PGPROC struct in shared memory.  We must do this
@@ -110,6 +115,9 @@ BackendMain(char *startup_data, size_t startup_data_len)
  * BackendInitialize -- initialize an interactive (postmaster-child)
  *				backend process, and collect the client's startup packet.
  *
+ * A backend started for a session of the session pool gets the session's
+ * startup information from pooled_session instead.
+ *
  * returns: nothing.  Will not return at all if there's any failure.
  *
  * Note: this code does not depend on having any access to shared memory.
@@ -119,7 +127,8 @@ BackendMain(char *startup_data, size_t startup_data_len)
  * but have not yet set up most of our local pointers to shmem structures.
  */
 static void
-BackendInitialize(ClientSocket *client_sock, CAC_state cac)
+BackendInitialize(ClientSocket *client_sock, CAC_state cac,
+				  char *pooled_session, size_t pooled_session_len)
 {
 	int			status;
 	int			ret;
@@ -200,8 +209,11 @@ BackendInitialize(ClientSocket *client_sock, CAC_state cac)
 	port->remote_host = pstrdup(remote_host);
 	port->remote_port = pstrdup(remote_port);
 
-	/* And now we can issue the Log_connections message, if wanted */
-	if (Log_connections)
+	/*
+	 * And now we can issue the Log_connections message, if wanted.  A pooled
+	 * session was logged when its client connected.
+	 */
+	if (Log_connections && pooled_session == NULL)
 	{
 		if (remote_port[0])
 			ereport(LOG,
@@ -252,15 +264,24 @@ BackendInitialize(ClientSocket *client_sock, CAC_state cac)
 	RegisterTimeout(STARTUP_PACKET_TIMEOUT, StartupPacketTimeoutHandler);
 	enable_timeout_after(STARTUP_PACKET_TIMEOUT, AuthenticationTimeout * 1000);
 
-	/* Handle direct SSL handshake */
-	status = ProcessSSLStartup(port);
+	if (pooled_session != NULL)
+	{
+		/* The session was established by another backend already */
+		SessionPoolAdoptSession(port, pooled_session, pooled_session_len);
+		status = STATUS_OK;
+	}
+	else
+	{
+		/* Handle direct SSL handshake */
+		status = ProcessSSLStartup(port);
 
-	/*
-	 * Receive the startup packet (which might turn out to be a cancel request
-	 * packet).
-	 */
-	if (status == STATUS_OK)
-		status = ProcessStartupPacket(port, false, false);
+		/*
+		 * Receive the startup packet (which might turn out to be a cancel
+		 * request packet).
+		 */
+		if (status == STATUS_OK)
+			status = ProcessStartupPacket(port, false, false);
+	}
 
 	/*
 	 * If we're going to reject the connection due to database state, say so
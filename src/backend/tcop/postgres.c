@@ -38,6 +38,7 @@
 #include "commands/async.h"
 #include "commands/event_trigger.h"
 #include "commands/prepare.h"
+#include "commands/sequence.h"
 #include "common/pg_prng.h"
 #include "jit/jit.h"
 #include "libpq/libpq.h"
@@ -56,6 +57,7 @@
 #include "postmaster/autovacuum.h"
 #include "postmaster/interrupt.h"
 #include "postmaster/postmaster.h"
+#include "postmaster/sessionpool.h"
 #include "replication/logicallauncher.h"
 #include "replication/logicalworker.h"
 #include "replication/slot.h"
@@ -2886,6 +2888,13 @@ drop_unnamed_stmt(void)
 	}
 }
 
+/* Is there an unnamed prepared statement? */
+bool
+UnnamedStatementExists(void)
+{
+	return unnamed_stmt_psrc != NULL;
+}
+
 
 /* --------------------------------
  *		signal handler routines used in PostgresMain()
@@ -4244,6 +4253,7 @@ PostgresMain(const char *dbname, const char *username)
 	volatile bool send_ready_for_query = true;
 	volatile bool idle_in_transaction_timeout_enabled = false;
 	volatile bool idle_session_timeout_enabled = false;
+	volatile bool session_ended = false;
 
 	Assert(dbname != NULL);
 	Assert(username != NULL);
@@ -4357,10 +4367,13 @@ PostgresMain(const char *dbname, const char *username)
 	if (am_walsender)
 		InitWalSender();
 
+	SessionPoolInitBackend();
+
 	/*
-	 * Send this backend's cancellation info to the frontend.
+	 * Send this backend's cancellation info to the frontend.  A session
+	 * taken over from the session pool has it already.
 	 */
-	if (whereToSendOutput == DestRemote)
+	if (whereToSendOutput == DestRemote && !SessionPoolAdopting)
 	{
 		StringInfoData buf;
 
@@ -4399,7 +4412,8 @@ PostgresMain(const char *dbname, const char *username)
 	MemoryContextSwitchTo(TopMemoryContext);
 
 	/* Fire any defined login event triggers, if appropriate */
-	EventTriggerOnLogin();
+	if (!SessionPoolAdopting)
+		EventTriggerOnLogin();
 
 	/*
 	 * POSTGRES main processing loop begins here
@@ -4550,6 +4564,7 @@ PostgresMain(const char *dbname, const char *username)
 	{
 		int			firstchar;
 		StringInfoData input_message;
+		bool		session_idle = false;
 
 		/*
 		 * At top of loop, reset extended-query-message flag, so that any
@@ -4681,8 +4696,16 @@ PostgresMain(const char *dbname, const char *username)
 			/* Report any recently-changed GUC options */
 			ReportChangedGUCOptions();
 
-			ReadyForQuery(whereToSendOutput);
+			/*
+			 * The client of a session taken over from the session pool isn't
+			 * expecting a ReadyForQuery; it got one from the last backend.
+			 */
+			if (SessionPoolAdopting)
+				SessionPoolAdopting = false;
+			else
+				ReadyForQuery(whereToSendOutput);
 			send_ready_for_query = false;
+			session_idle = !IsTransactionOrTransactionBlock();
 		}
 
 		/*
@@ -4693,6 +4716,25 @@ PostgresMain(const char *dbname, const char *username)
 		 */
 		DoingCommandRead = true;
 
+		/*
+		 * (2b) If the client has disconnected, or is idle outside of a
+		 * transaction, a pooled backend can go on to serve another session.
+		 */
+		if (session_ended)
+		{
+			session_ended = false;
+			SessionPoolEndSession();
+		}
+		else if (session_idle && SessionPoolCanReleaseSession())
+		{
+			if (idle_session_timeout_enabled)
+			{
+				disable_timeout(IDLE_SESSION_TIMEOUT, false);
+				idle_session_timeout_enabled = false;
+			}
+			SessionPoolReleaseSession();
+		}
+
 		/*
 		 * (3) read a command (loop blocks here)
 		 */
@@ -4986,6 +5028,21 @@ PostgresMain(const char *dbname, const char *username)
 				if (whereToSendOutput == DestRemote)
 					whereToSendOutput = DestNone;
 
+				/*
+				 * In a pooled backend, let the next iteration of the loop
+				 * wait for another session.  The unnamed prepared statement
+				 * and the sequence values, which would otherwise keep the
+				 * session pinned, are of no use without the client.
+				 */
+				drop_unnamed_stmt();
+				ResetSequenceCaches();
+				if (SessionPoolCanEndSession())
+				{
+					pgStatSessionEndCause = DISCONNECT_NORMAL;
+					session_ended = true;
+					break;
+				}
+
 				/*
 				 * NOTE: if you are tempted to add more code here, DON'T!
 				 * Whatever you had in mind to do should be set up as an
@@ -337,6 +337,7 @@ pgstat_bestart(void)
 			   sizeof(lbeentry.st_clientaddr));
 	else
 		MemSet(&lbeentry.st_clientaddr, 0, sizeof(lbeentry.st_clientaddr));
+	lbeentry.st_session_pid = MyProcPort ? MyProcPid : 0;
 
 #ifdef USE_SSL
 	if (MyProcPort && MyProcPort->ssl_in_use)
@@ -674,6 +675,36 @@ pgstat_report_appname(const char *appname)
 	PGSTAT_END_WRITE_ACTIVITY(beentry);
 }
 
+/*
+ * Report the client session that a pooled backend has switched to, or 0 if
+ * it has none.  The client address is taken from MyProcPort.
+ */
+void
+pgstat_report_client_session(int session_pid)
+{
+	volatile PgBackendStatus *beentry = MyBEEntry;
+
+	if (!beentry)
+		return;
+
+	PGSTAT_BEGIN_WRITE_ACTIVITY(beentry);
+
+	if (session_pid != 0)
+		memcpy(unvolatize(SockAddr *, &beentry->st_clientaddr), &MyProcPort->raddr,
+			   sizeof(SockAddr));
+	else
+		MemSet(unvolatize(SockAddr *, &beentry->st_clientaddr), 0,
+			   sizeof(SockAddr));
+	if (session_pid != 0 && MyProcPort->remote_hostname)
+		strlcpy((char *) beentry->st_clienthostname,
+				MyProcPort->remote_hostname, NAMEDATALEN);
+	else
+		beentry->st_clienthostname[0] = '\0';
+	beentry->st_session_pid = session_pid;
+
+	PGSTAT_END_WRITE_ACTIVITY(beentry);
+}
+
 /*
  * Report current transaction start timestamp as the specified value.
  * Zero means there is no active transaction.
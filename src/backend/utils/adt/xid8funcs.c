@@ -26,6 +26,7 @@
 
 #include "postgres.h"
 
+#include "access/csnlog.h"
 #include "access/transam.h"
 #include "access/xact.h"
 #include "funcapi.h"
@@ -372,6 +373,7 @@ pg_current_snapshot(PG_FUNCTION_ARGS)
 	pg_snapshot *snap;
 	uint32		nxip,
 				i;
+	TransactionId *xip;
 	Snapshot	cur;
 	FullTransactionId next_fxid = ReadNextFullTransactionId();
 
@@ -379,8 +381,20 @@ pg_current_snapshot(PG_FUNCTION_ARGS)
 	if (cur == NULL)
 		elog(ERROR, "no active snapshot set");
 
+	if (cur->snapshotCsn != InvalidCommitSeqNo)
+	{
+		int			nxids;
+
+		xip = GetCSNSnapshotRunningXids(cur, &nxids);
+		nxip = nxids;
+	}
+	else
+	{
+		xip = cur->xip;
+		nxip = cur->xcnt;
+	}
+
 	/* allocate */
-	nxip = cur->xcnt;
 	snap = palloc(PG_SNAPSHOT_SIZE(nxip));
 
 	/*
@@ -394,7 +408,7 @@ pg_current_snapshot(PG_FUNCTION_ARGS)
 	snap->nxip = nxip;
 	for (i = 0; i < nxip; i++)
 		snap->xip[i] =
-			FullTransactionIdFromAllowableAt(next_fxid, cur->xip[i]);
+			FullTransactionIdFromAllowableAt(next_fxid, xip[i]);
 
 	/*
 	 * We want them guaranteed to be in ascending order.  This also removes
@@ -39,6 +39,7 @@
 #include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/resowner.h"
+#include "utils/sharedcatcache.h"
 #include "utils/syscache.h"
 
 /*
@@ -94,6 +95,9 @@ static pg_noinline HeapTuple SearchCatCacheMiss(CatCache *cache,
 												Index hashIndex,
 												Datum v1, Datum v2,
 												Datum v3, Datum v4);
+static CatCTup *SearchCatCacheShared(CatCache *cache, int nkeys,
+									 uint32 hashValue, Index hashIndex,
+									 Datum *arguments);
 
 static uint32 CatalogCacheComputeHashValue(CatCache *cache, int nkeys,
 										   Datum v1, Datum v2, Datum v3, Datum v4);
@@ -689,6 +693,9 @@ CatCacheInvalidate(CatCache *cache, uint32 hashValue)
 				e->dead = true;
 		}
 	}
+
+	/* And any copies in the shared catalog cache */
+	SharedCatCacheInvalidate(cache->id, hashValue);
 }
 
 /* ----------------------------------------------------------------
@@ -814,6 +821,8 @@ ResetCatalogCachesExt(bool debug_discard)
 		ResetCatalogCache(cache, debug_discard);
 	}
 
+	SharedCatCacheInvalidateAll();
+
 	CACHE_elog(DEBUG2, "end of ResetCatalogCaches call");
 }
 
@@ -852,6 +861,9 @@ CatalogCacheFlushCatalog(Oid catId)
 		}
 	}
 
+	/* The shared catalog cache can't flush individual caches */
+	SharedCatCacheInvalidateAll();
+
 	CACHE_elog(DEBUG2, "end of CatalogCacheFlushCatalog call");
 }
 
@@ -1487,6 +1499,8 @@ SearchCatCacheMiss(CatCache *cache,
 	HeapTuple	ntp;
 	CatCTup    *ct;
 	bool		stale;
+	bool		use_shared;
+	SharedCatCacheLoad load;
 	Datum		arguments[CATCACHE_MAXKEYS];
 
 	/* Initialize local parameter array */
@@ -1495,6 +1509,25 @@ SearchCatCacheMiss(CatCache *cache,
 	arguments[2] = v3;
 	arguments[3] = v4;
 
+	/*
+	 * If another backend has already loaded the tuple into the shared
+	 * catalog cache, we can copy it from there instead of scanning the
+	 * catalog.
+	 */
+	use_shared = SharedCatCacheUsable(cache);
+	if (use_shared)
+	{
+		ct = SearchCatCacheShared(cache, nkeys, hashValue, hashIndex,
+								  arguments);
+		if (ct != NULL)
+		{
+			ResourceOwnerEnlarge(CurrentResourceOwner);
+			ct->refcount++;
+			ResourceOwnerRememberCatCacheRef(CurrentResourceOwner, &ct->tuple);
+			return &ct->tuple;
+		}
+	}
+
 	/*
 	 * Tuple was not found in cache, so we have to try to retrieve it directly
 	 * from the relation.  If found, we will add it to the cache; if not
@@ -1531,6 +1564,9 @@ SearchCatCacheMiss(CatCache *cache,
 		cur_skey[2].sk_argument = v3;
 		cur_skey[3].sk_argument = v4;
 
+		if (use_shared)
+			SharedCatCacheBeginLoad(cache, hashValue, &load);
+
 		scandesc = systable_beginscan(relation,
 									  cache->cc_indexoid,
 									  IndexScanOK(cache, cur_skey),
@@ -1551,6 +1587,9 @@ SearchCatCacheMiss(CatCache *cache,
 				stale = true;
 				break;
 			}
+			/* offer the (detoasted) tuple to other backends */
+			if (use_shared)
+				SharedCatCacheStore(cache, hashValue, &load, &ct->tuple);
 			/* immediately set the refcount to 1 */
 			ResourceOwnerEnlarge(CurrentResourceOwner);
 			ct->refcount++;
@@ -1609,6 +1648,50 @@ SearchCatCacheMiss(CatCache *cache,
 	return &ct->tuple;
 }
 
+/*
+ * Build a cache entry from a copy of the tuple in the shared catalog cache,
+ * if there is one.
+ *
+ * Returns NULL if the shared catalog cache has no valid copy, in which case
+ * the caller must scan the catalog.
+ */
+static CatCTup *
+SearchCatCacheShared(CatCache *cache, int nkeys, uint32 hashValue,
+					 Index hashIndex, Datum *arguments)
+{
+	HeapTuple	stp;
+	Datum		keys[CATCACHE_MAXKEYS];
+	CatCTup    *ct;
+
+	stp = SharedCatCacheLookup(cache, hashValue);
+	if (stp == NULL)
+		return NULL;
+
+	/* It might be a different tuple with the same hash value */
+	for (int i = 0; i < nkeys; i++)
+	{
+		bool		isnull;
+
+		keys[i] = heap_getattr(stp, cache->cc_keyno[i], cache->cc_tupdesc,
+							   &isnull);
+		Assert(!isnull);
+	}
+	if (!CatalogCacheCompareTuple(cache, nkeys, keys, arguments))
+	{
+		heap_freetuple(stp);
+		return NULL;
+	}
+
+	/* The tuple was detoasted before it was stored, so this can't recurse */
+	ct = CatalogCacheCreateEntry(cache, stp, NULL, hashValue, hashIndex);
+	heap_freetuple(stp);
+
+	CACHE_elog(DEBUG2, "SearchCatCache(%s): copied from shared cache",
+			   cache->cc_relname);
+
+	return ct;
+}
+
 /*
  *	ReleaseCatCache
  *
@@ -43,6 +43,10 @@
  * bare-bones; it's the caller's responsibility to build a new expression
  * if the old one gets invalidated.
  *
+ * If shared_plan_cache_size is set, generic plans of saved statements are
+ * also offered to, and looked up in, a cache shared by all backends; see
+ * sharedplancache.c.
+ *
  *
  * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -70,6 +74,7 @@
 #include "utils/memutils.h"
 #include "utils/resowner.h"
 #include "utils/rls.h"
+#include "utils/sharedplancache.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
 
@@ -910,6 +915,8 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	List	   *plist;
 	bool		snapshot_set;
 	bool		is_transient;
+	bool		use_shared_cache;
+	SharedPlanCacheProbe probe;
 	MemoryContext plan_context;
 	MemoryContext oldcxt = CurrentMemoryContext;
 	ListCell   *lc;
@@ -931,40 +938,84 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 		qlist = RevalidateCachedQuery(plansource, queryEnv);
 
 	/*
-	 * If we don't already have a copy of the querytree list that can be
-	 * scribbled on by the planner, make one.  For a one-shot plan, we assume
-	 * it's okay to scribble on the original query_list.
+	 * A generic plan of a saved statement may be available from the shared
+	 * plan cache.  Statements with parser hooks or a query environment are
+	 * left out, as their plans depend on more than the query text.
 	 */
-	if (qlist == NIL)
+	use_shared_cache = (shared_plan_cache_size > 0 &&
+						boundParams == NULL &&
+						plansource->is_saved &&
+						!plansource->is_oneshot &&
+						plansource->parserSetup == NULL &&
+						queryEnv == NULL &&
+						StmtPlanRequiresRevalidation(plansource));
+	plist = NIL;
+	if (use_shared_cache)
 	{
-		if (!plansource->is_oneshot)
-			qlist = copyObject(plansource->query_list);
-		else
-			qlist = plansource->query_list;
+		plist = SharedPlanCacheLookup(plansource, &probe);
+
+		/*
+		 * We hold locks on the query's relations, but not on the partitions
+		 * and inheritance children that appear only in the plan, which the
+		 * planner would have locked.  Lock all of the plan's relations, as
+		 * CheckCachedPlan does, and then make sure that neither the plan nor
+		 * the query tree have been invalidated meanwhile.
+		 */
+		if (plist != NIL)
+		{
+			AcquireExecutorLocks(plist, true);
+			if (!SharedPlanCacheRecheck(&probe) || !plansource->is_valid)
+			{
+				AcquireExecutorLocks(plist, false);
+				plist = NIL;
+				if (!plansource->is_valid)
+					qlist = RevalidateCachedQuery(plansource, queryEnv);
+			}
+		}
 	}
 
-	/*
-	 * If a snapshot is already set (the normal case), we can just use that
-	 * for planning.  But if it isn't, and we need one, install one.
-	 */
-	snapshot_set = false;
-	if (!ActiveSnapshotSet() &&
-		plansource->raw_parse_tree &&
-		analyze_requires_snapshot(plansource->raw_parse_tree))
+	if (plist == NIL)
 	{
-		PushActiveSnapshot(GetTransactionSnapshot());
-		snapshot_set = true;
-	}
+		/*
+		 * If we don't already have a copy of the querytree list that can be
+		 * scribbled on by the planner, make one.  For a one-shot plan, we
+		 * assume it's okay to scribble on the original query_list.
+		 */
+		if (qlist == NIL)
+		{
+			if (!plansource->is_oneshot)
+				qlist = copyObject(plansource->query_list);
+			else
+				qlist = plansource->query_list;
+		}
 
-	/*
-	 * Generate the plan.
-	 */
-	plist = pg_plan_queries(qlist, plansource->query_string,
-							plansource->cursor_options, boundParams);
+		/*
+		 * If a snapshot is already set (the normal case), we can just use
+		 * that for planning.  But if it isn't, and we need one, install one.
+		 */
+		snapshot_set = false;
+		if (!ActiveSnapshotSet() &&
+			plansource->raw_parse_tree &&
+			analyze_requires_snapshot(plansource->raw_parse_tree))
+		{
+			PushActiveSnapshot(GetTransactionSnapshot());
+			snapshot_set = true;
+		}
 
-	/* Release snapshot if we got one */
-	if (snapshot_set)
-		PopActiveSnapshot();
+		/*
+		 * Generate the plan.
+		 */
+		plist = pg_plan_queries(qlist, plansource->query_string,
+								plansource->cursor_options, boundParams);
+
+		/* Release snapshot if we got one */
+		if (snapshot_set)
+			PopActiveSnapshot();
+
+		/* Offer it to other backends */
+		if (use_shared_cache)
+			SharedPlanCacheStore(plansource, &probe, plist);
+	}
 
 	/*
 	 * Normally we make a dedicated memory context for the CachedPlan and its
@@ -2056,6 +2107,9 @@ PlanCacheRelCallback(Datum arg, Oid relid)
 			cexpr->is_valid = false;
 		}
 	}
+
+	/* And let other backends know, via the shared plan cache */
+	SharedPlanCacheInvalidateRel(relid);
 }
 
 /*
@@ -2166,6 +2220,9 @@ PlanCacheObjectCallback(Datum arg, int cacheid, uint32 hashvalue)
 			}
 		}
 	}
+
+	/* And let other backends know, via the shared plan cache */
+	SharedPlanCacheInvalidateObject(cacheid, hashvalue);
 }
 
 /*
@@ -2178,6 +2235,7 @@ static void
 PlanCacheSysCallback(Datum arg, int cacheid, uint32 hashvalue)
 {
 	ResetPlanCache();
+	SharedPlanCacheInvalidateAll();
 }
 
 /*
@@ -0,0 +1,547 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedcatcache.c
+ *	  Shared-memory tier below the backend-local catalog caches.
+ *
+ * Each backend builds its catalog caches (catcache.c) from scratch, so a
+ * new connection to a database with many objects spends a lot of time in
+ * catalog index scans before its caches are warm.  If shared_catcache_size
+ * is set, catalog tuples that a backend loads are also copied into a dshash
+ * table in a DSA area, and SearchCatCacheMiss() consults that table before
+ * scanning the catalog.  Only positive entries of single-tuple searches are
+ * shared; negative entries and list searches stay backend-local.
+ *
+ * The shared tier is kept consistent with the regular sinval machinery.  We
+ * keep an array of invalidation counters in shared memory.  Whenever a
+ * backend processes a catcache invalidation, it bumps the counter of the
+ * bucket that the message's cache id and hash value map to; resets and
+ * catalog-wide flushes bump a global counter.  Each shared entry records
+ * the counters as they were before the tuple was read, and is ignored (and
+ * removed) once either of them has moved.
+ *
+ * That makes a shared entry about as fresh as an entry in the backend's own
+ * cache would be: once a backend has processed the invalidation for a tuple,
+ * it bumped the counter itself, so it can't get an older version from the
+ * shared tier.  To make sure a tuple loaded after a counter moved is really
+ * the new version, the loading backend takes a fresh catalog snapshot after
+ * reading the counters.  A transaction that has modified the catalogs must
+ * see its own uncommitted changes, so backends with an assigned transaction
+ * id bypass the shared tier, as does logical decoding, which reads the
+ * catalogs with historic snapshots.
+ *
+ * Tuples are copied into backend-local catcache entries on use, so this
+ * saves catalog scans when a cache is warming up, not the memory used by
+ * the local caches.
+ *
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/cache/sharedcatcache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "access/xact.h"
+#include "common/hashfn.h"
+#include "funcapi.h"
+#include "lib/dshash.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/builtins.h"
+#include "utils/dsa.h"
+#include "utils/memutils.h"
+#include "utils/sharedcatcache.h"
+#include "utils/snapmgr.h"
+#include "utils/syscache.h"
+
+
+/* Number of invalidation counters that tuples are hashed into */
+#define SCC_INVAL_BUCKETS		4096
+
+/* Per-cache statistics */
+typedef struct SharedCatCacheStats
+{
+	Oid			reloid;			/* set on first use of the cache */
+	Oid			indexoid;
+	pg_atomic_uint64 hits;
+	pg_atomic_uint64 misses;
+} SharedCatCacheStats;
+
+typedef struct SharedCatCacheControl
+{
+	void	   *raw_dsa_area;	/* DSA area in plain shared memory */
+	dshash_table_handle hash_handle;	/* shared hash table of tuples */
+	pg_atomic_uint64 used_bytes;	/* size of all stored tuples */
+
+	SharedCatCacheStats stats[SysCacheSize];
+
+	/* bumped by resets and catalog-wide flushes */
+	pg_atomic_uint64 generation;
+	/* bumped by invalidations of tuples hashing to each bucket */
+	pg_atomic_uint64 bucket_generation[SCC_INVAL_BUCKETS];
+} SharedCatCacheControl;
+
+typedef struct SharedCatCacheKey
+{
+	Oid			dbid;			/* InvalidOid for shared catalogs */
+	int			cacheid;
+	uint32		hashvalue;
+} SharedCatCacheKey;
+
+/* A stored tuple; its data follows the struct, MAXALIGN'd */
+typedef struct SharedCatCacheTuple
+{
+	SharedCatCacheLoad load;	/* counters before the tuple was read */
+	ItemPointerData t_self;
+	Oid			t_tableOid;
+	uint32		t_len;
+} SharedCatCacheTuple;
+
+#define SharedCatCacheTupleData(stup) \
+	((HeapTupleHeader) ((char *) (stup) + MAXALIGN(sizeof(SharedCatCacheTuple))))
+
+/* Shared hash table entry */
+typedef struct SharedCatCacheEntry
+{
+	SharedCatCacheKey key;
+	dsa_pointer tuple;			/* SharedCatCacheTuple */
+	Size		size;			/* allocated size of tuple */
+} SharedCatCacheEntry;
+
+/* GUC variable */
+int			shared_catcache_size = 0;
+
+static SharedCatCacheControl *SharedCatCache = NULL;
+
+/* Backend-local attachment to the DSA area and the hash table */
+static dsa_area *scc_dsa = NULL;
+static dshash_table *scc_hash = NULL;
+
+static const dshash_parameters scc_hash_params = {
+	sizeof(SharedCatCacheKey),
+	sizeof(SharedCatCacheEntry),
+	dshash_memcmp,
+	dshash_memhash,
+	dshash_memcpy,
+	LWTRANCHE_SHARED_CATCACHE_HASH
+};
+
+static void scc_attach(void);
+static void scc_detach(int code, Datum arg);
+static void scc_make_key(CatCache *cache, uint32 hashValue,
+						 SharedCatCacheKey *key);
+static void scc_remove(SharedCatCacheKey *key, dsa_pointer stale);
+
+static inline uint32
+scc_bucket(int cacheid, uint32 hashValue)
+{
+	return hash_combine(hash_bytes_uint32((uint32) cacheid), hashValue) %
+		SCC_INVAL_BUCKETS;
+}
+
+
+/*
+ * The size of the DSA area created in the main shared memory segment.
+ */
+static Size
+scc_dsa_init_size(void)
+{
+	Size		sz;
+
+	sz = mul_size((Size) shared_catcache_size, 1024);
+	sz = Max(sz, dsa_minimum_size());
+	return MAXALIGN(sz);
+}
+
+/*
+ * Report shared-memory space needed by SharedCatCacheShmemInit.
+ */
+Size
+SharedCatCacheShmemSize(void)
+{
+	Size		sz;
+
+	if (shared_catcache_size == 0)
+		return 0;
+
+	sz = MAXALIGN(sizeof(SharedCatCacheControl));
+	sz = add_size(sz, scc_dsa_init_size());
+
+	return sz;
+}
+
+/*
+ * Initialize the shared catalog cache during startup.
+ */
+void
+SharedCatCacheShmemInit(void)
+{
+	bool		found;
+
+	if (shared_catcache_size == 0)
+		return;
+
+	SharedCatCache = (SharedCatCacheControl *)
+		ShmemInitStruct("Shared Catalog Cache", SharedCatCacheShmemSize(),
+						&found);
+
+	if (!IsUnderPostmaster)
+	{
+		dsa_area   *dsa;
+		dshash_table *dsh;
+		char	   *p = (char *) SharedCatCache;
+
+		Assert(!found);
+
+		p += MAXALIGN(sizeof(SharedCatCacheControl));
+		SharedCatCache->raw_dsa_area = p;
+		dsa = dsa_create_in_place(SharedCatCache->raw_dsa_area,
+								  scc_dsa_init_size(),
+								  LWTRANCHE_SHARED_CATCACHE_DSA, 0);
+		dsa_pin(dsa);
+
+		/* create the hash table in plain shared memory, see StatsShmemInit() */
+		dsa_set_size_limit(dsa, scc_dsa_init_size());
+		dsh = dshash_create(dsa, &scc_hash_params, NULL);
+		SharedCatCache->hash_handle = dshash_get_hash_table_handle(dsh);
+		dsa_set_size_limit(dsa, -1);
+
+		dshash_detach(dsh);
+		dsa_detach(dsa);
+
+		pg_atomic_init_u64(&SharedCatCache->used_bytes, 0);
+		for (int i = 0; i < SysCacheSize; i++)
+		{
+			SharedCatCache->stats[i].reloid = InvalidOid;
+			SharedCatCache->stats[i].indexoid = InvalidOid;
+			pg_atomic_init_u64(&SharedCatCache->stats[i].hits, 0);
+			pg_atomic_init_u64(&SharedCatCache->stats[i].misses, 0);
+		}
+		pg_atomic_init_u64(&SharedCatCache->generation, 0);
+		for (int i = 0; i < SCC_INVAL_BUCKETS; i++)
+			pg_atomic_init_u64(&SharedCatCache->bucket_generation[i], 0);
+	}
+	else
+		Assert(found);
+}
+
+/*
+ * Attach to the shared hash table, if not done already in this backend.
+ */
+static void
+scc_attach(void)
+{
+	MemoryContext oldcontext;
+
+	if (scc_hash != NULL)
+		return;
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	scc_dsa = dsa_attach_in_place(SharedCatCache->raw_dsa_area, NULL);
+	dsa_pin_mapping(scc_dsa);
+	scc_hash = dshash_attach(scc_dsa, &scc_hash_params,
+							 SharedCatCache->hash_handle, NULL);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	on_shmem_exit(scc_detach, 0);
+}
+
+/*
+ * Release our reference to the in-place DSA area at exit, as
+ * dsa_attach_in_place() without a segment doesn't arrange for that.
+ */
+static void
+scc_detach(int code, Datum arg)
+{
+	dsa_release_in_place(SharedCatCache->raw_dsa_area);
+}
+
+static void
+scc_make_key(CatCache *cache, uint32 hashValue, SharedCatCacheKey *key)
+{
+	memset(key, 0, sizeof(SharedCatCacheKey));
+	key->dbid = cache->cc_relisshared ? InvalidOid : MyDatabaseId;
+	key->cacheid = cache->id;
+	key->hashvalue = hashValue;
+}
+
+/*
+ * Remove a stale entry, unless someone else has replaced it already.
+ */
+static void
+scc_remove(SharedCatCacheKey *key, dsa_pointer stale)
+{
+	SharedCatCacheEntry *entry;
+
+	entry = dshash_find(scc_hash, key, true);
+	if (entry == NULL)
+		return;
+
+	if (entry->tuple == stale)
+	{
+		Size		size = entry->size;
+
+		dshash_delete_entry(scc_hash, entry);
+		dsa_free(scc_dsa, stale);
+		pg_atomic_sub_fetch_u64(&SharedCatCache->used_bytes, size);
+	}
+	else
+		dshash_release_lock(scc_hash, entry);
+}
+
+/*
+ * SharedCatCacheUsable
+ *		Can the current backend use the shared tier for this cache now?
+ */
+bool
+SharedCatCacheUsable(CatCache *cache)
+{
+	if (SharedCatCache == NULL)
+		return false;
+
+	if (IsBootstrapProcessingMode())
+		return false;
+
+	/* We must see our own uncommitted catalog changes */
+	if (TransactionIdIsValid(GetTopTransactionIdIfAny()))
+		return false;
+
+	/* Logical decoding reads the catalogs as of some point in the past */
+	if (HistoricSnapshotActive())
+		return false;
+
+	/* Nothing but shared catalogs can be read without a database */
+	if (!cache->cc_relisshared && !OidIsValid(MyDatabaseId))
+		return false;
+
+	return true;
+}
+
+/*
+ * SharedCatCacheLookup
+ *		Return a palloc'd copy of the tuple with the given hash value in the
+ *		cache, or NULL if there's no valid entry for it.
+ *
+ * Different tuples can have the same hash value, so the caller must check
+ * that the tuple's keys match the search keys.
+ */
+HeapTuple
+SharedCatCacheLookup(CatCache *cache, uint32 hashValue)
+{
+	SharedCatCacheStats *stats = &SharedCatCache->stats[cache->id];
+	SharedCatCacheKey key;
+	SharedCatCacheEntry *entry;
+	dsa_pointer stale = InvalidDsaPointer;
+	HeapTuple	result = NULL;
+
+	Assert(SharedCatCacheUsable(cache));
+
+	if (!OidIsValid(stats->reloid))
+	{
+		stats->indexoid = cache->cc_indexoid;
+		stats->reloid = cache->cc_reloid;
+	}
+
+	scc_attach();
+	scc_make_key(cache, hashValue, &key);
+
+	entry = dshash_find(scc_hash, &key, false);
+	if (entry != NULL)
+	{
+		SharedCatCacheTuple *stup = dsa_get_address(scc_dsa, entry->tuple);
+		uint32		bucket = scc_bucket(cache->id, hashValue);
+
+		if (pg_atomic_read_u64(&SharedCatCache->generation) ==
+			stup->load.global_generation &&
+			pg_atomic_read_u64(&SharedCatCache->bucket_generation[bucket]) ==
+			stup->load.generation)
+		{
+			result = (HeapTuple) palloc(HEAPTUPLESIZE + stup->t_len);
+			result->t_len = stup->t_len;
+			result->t_self = stup->t_self;
+			result->t_tableOid = stup->t_tableOid;
+			result->t_data = (HeapTupleHeader) ((char *) result + HEAPTUPLESIZE);
+			memcpy(result->t_data, SharedCatCacheTupleData(stup), stup->t_len);
+		}
+		else
+			stale = entry->tuple;
+		dshash_release_lock(scc_hash, entry);
+	}
+
+	if (DsaPointerIsValid(stale))
+		scc_remove(&key, stale);
+
+	if (result != NULL)
+		pg_atomic_fetch_add_u64(&stats->hits, 1);
+	else
+		pg_atomic_fetch_add_u64(&stats->misses, 1);
+
+	return result;
+}
+
+/*
+ * SharedCatCacheBeginLoad
+ *		Prepare for loading a tuple from the catalog and storing it with
+ *		SharedCatCacheStore().
+ *
+ * This must be called before the catalog is scanned.
+ */
+void
+SharedCatCacheBeginLoad(CatCache *cache, uint32 hashValue,
+						SharedCatCacheLoad *load)
+{
+	uint32		bucket = scc_bucket(cache->id, hashValue);
+
+	load->generation =
+		pg_atomic_read_u64(&SharedCatCache->bucket_generation[bucket]);
+	load->global_generation = pg_atomic_read_u64(&SharedCatCache->generation);
+
+	/*
+	 * Any change whose invalidation has already bumped these counters must be
+	 * visible to the scan, so don't use a catalog snapshot that might be older
+	 * than them.
+	 */
+	pg_read_barrier();
+	InvalidateCatalogSnapshot();
+}
+
+/*
+ * SharedCatCacheStore
+ *		Store a tuple loaded after SharedCatCacheBeginLoad() in the cache.
+ *
+ * The tuple must not have any out-of-line toasted fields.
+ */
+void
+SharedCatCacheStore(CatCache *cache, uint32 hashValue,
+					SharedCatCacheLoad *load, HeapTuple tuple)
+{
+	SharedCatCacheKey key;
+	SharedCatCacheEntry *entry;
+	SharedCatCacheTuple *stup;
+	dsa_pointer dp;
+	Size		size;
+	bool		found;
+
+	Assert(!HeapTupleHasExternal(tuple));
+
+	size = MAXALIGN(sizeof(SharedCatCacheTuple)) + tuple->t_len;
+
+	/* Give up if that would exceed shared_catcache_size */
+	if (pg_atomic_add_fetch_u64(&SharedCatCache->used_bytes, size) >
+		(uint64) shared_catcache_size * 1024)
+	{
+		pg_atomic_sub_fetch_u64(&SharedCatCache->used_bytes, size);
+		return;
+	}
+
+	dp = dsa_allocate_extended(scc_dsa, size, DSA_ALLOC_NO_OOM);
+	if (!DsaPointerIsValid(dp))
+	{
+		pg_atomic_sub_fetch_u64(&SharedCatCache->used_bytes, size);
+		return;
+	}
+
+	stup = dsa_get_address(scc_dsa, dp);
+	stup->load = *load;
+	stup->t_self = tuple->t_self;
+	stup->t_tableOid = tuple->t_tableOid;
+	stup->t_len = tuple->t_len;
+	memcpy(SharedCatCacheTupleData(stup), tuple->t_data, tuple->t_len);
+
+	/* Insert it, replacing any existing entry */
+	scc_make_key(cache, hashValue, &key);
+	entry = dshash_find_or_insert(scc_hash, &key, &found);
+	if (found)
+	{
+		dsa_pointer old_tuple = entry->tuple;
+		Size		old_size = entry->size;
+
+		entry->tuple = dp;
+		entry->size = size;
+		dshash_release_lock(scc_hash, entry);
+
+		dsa_free(scc_dsa, old_tuple);
+		pg_atomic_sub_fetch_u64(&SharedCatCache->used_bytes, old_size);
+	}
+	else
+	{
+		entry->tuple = dp;
+		entry->size = size;
+		dshash_release_lock(scc_hash, entry);
+	}
+}
+
+/*
+ * SharedCatCacheInvalidate
+ *		Note that shared copies of tuples with the given hash value in the
+ *		given cache are no longer valid.
+ *
+ * Called by every backend that processes the invalidation.
+ */
+void
+SharedCatCacheInvalidate(int cacheid, uint32 hashValue)
+{
+	if (SharedCatCache == NULL)
+		return;
+
+	pg_atomic_fetch_add_u64(&SharedCatCache->bucket_generation[scc_bucket(cacheid, hashValue)],
+							1);
+}
+
+/*
+ * SharedCatCacheInvalidateAll
+ *		Note that no shared tuple is valid anymore.
+ */
+void
+SharedCatCacheInvalidateAll(void)
+{
+	if (SharedCatCache == NULL)
+		return;
+
+	pg_atomic_fetch_add_u64(&SharedCatCache->generation, 1);
+}
+
+/*
+ * SQL SRF showing the shared catalog cache's hit and miss counts for each
+ * catalog cache that has been searched since server start.
+ */
+Datum
+pg_stat_get_shared_catcache(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_SHARED_CATCACHE_COLS	5
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+
+	InitMaterializedSRF(fcinfo, 0);
+
+	if (SharedCatCache == NULL)
+		return (Datum) 0;
+
+	for (int i = 0; i < SysCacheSize; i++)
+	{
+		SharedCatCacheStats *stats = &SharedCatCache->stats[i];
+		Datum		values[PG_STAT_GET_SHARED_CATCACHE_COLS];
+		bool		nulls[PG_STAT_GET_SHARED_CATCACHE_COLS] = {0};
+
+		if (!OidIsValid(stats->reloid))
+			continue;
+
+		values[0] = Int32GetDatum(i);
+		values[1] = ObjectIdGetDatum(stats->reloid);
+		values[2] = ObjectIdGetDatum(stats->indexoid);
+		values[3] = Int64GetDatum((int64) pg_atomic_read_u64(&stats->hits));
+		values[4] = Int64GetDatum((int64) pg_atomic_read_u64(&stats->misses));
+
+		tuplestore_putvalues(rsinfo->setResult, rsinfo->setDesc, values, nulls);
+	}
+
+	return (Datum) 0;
+}
@@ -0,0 +1,741 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedplancache.c
+ *	  Cross-backend cache of generic plans for saved statements.
+ *
+ * Every backend keeps its own CachedPlanSources and CachedPlans (see
+ * plancache.c), so when many sessions prepare the same statements, each of
+ * them plans each statement for itself.  The shared plan cache lets a backend
+ * that is about to build a generic plan adopt one that another backend has
+ * already built for the same statement in the same environment.
+ *
+ * Plans are stored in serialized form (nodeToString) in a dshash table in
+ * a DSA area.  The key consists of the query text plus everything else the
+ * plan can silently depend on: the database, the current role, the effective
+ * search_path, the parameter types, the cursor options, row_security, the
+ * planner-related GUC settings, and the settings that affect how parse
+ * analysis and constant folding interpret the query, such as TimeZone and
+ * DateStyle.  Only generic plans of saved statements are
+ * stored; one-shot plans, custom plans, plans of statements with parser
+ * hooks (such as PL/pgSQL queries), transient plans and plans that reference
+ * temporary tables never are.
+ *
+ * Invalidation reuses the dependency tracking of the local plan cache.
+ * Rather than having every backend search the shared table on every sinval
+ * event, we keep an array of invalidation counters in shared memory.  The
+ * plancache.c inval callbacks, which run in every backend that processes an
+ * event, bump the counter of the bucket that the invalidated relation or
+ * object hashes to (or a global counter for events that invalidate
+ * everything).  A stored plan records the counters of the buckets of all its
+ * dependencies, as they were before planning started; a backend adopting the
+ * plan compares them with the current values, and discards the entry if any
+ * of them moved.
+ *
+ * This is safe because the adopting backend has already locked the query's
+ * relations, and thereby processed all invalidations for changes committed
+ * before that, when it performs the check.  The plan can also use partitions
+ * and inheritance children that aren't in the query, which the planner would
+ * have locked; so plancache.c locks all the relations of an adopted plan and
+ * then checks the counters once more with SharedPlanCacheRecheck().
+ * Processing such an invalidation bumps the counter, so the check fails
+ * unless the plan was built after the change.  Like the local plan cache, we rely on locking for changes that
+ * must not be missed; bucket collisions merely cause unneeded replanning.
+ *
+ * The adopted plan is deserialized into backend-local memory and from then
+ * on is handled by plancache.c like any other generic plan, so this saves
+ * planning work, not the memory used by the local copy.
+ *
+ * Once shared_plan_cache_size is used up, new plans are not added until
+ * stale ones have been discarded.
+ *
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/cache/sharedplancache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "catalog/namespace.h"
+#include "catalog/pg_class.h"
+#include "common/hashfn.h"
+#include "lib/dshash.h"
+#include "miscadmin.h"
+#include "nodes/bitmapset.h"
+#include "nodes/plannodes.h"
+#include "port/atomics.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/dsa.h"
+#include "utils/guc_tables.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rls.h"
+#include "utils/sharedplancache.h"
+
+
+/* Number of invalidation counters that dependencies are hashed into */
+#define SPC_INVAL_BUCKETS		1024
+
+/* Index of the global counter in a snapshot of the counters */
+#define SPC_GLOBAL_GENERATION	SPC_INVAL_BUCKETS
+
+typedef struct SharedPlanCacheControl
+{
+	void	   *raw_dsa_area;	/* DSA area in plain shared memory */
+	dshash_table_handle hash_handle;	/* shared hash table of plans */
+	pg_atomic_uint64 used_bytes;	/* size of all stored plans */
+
+	/* bumped by invalidation events that affect all plans */
+	pg_atomic_uint64 generation;
+	/* bumped by invalidation events for objects hashing to each bucket */
+	pg_atomic_uint64 bucket_generation[SPC_INVAL_BUCKETS];
+} SharedPlanCacheControl;
+
+/* One dependency of a stored plan */
+typedef struct SharedPlanDep
+{
+	uint32		bucket;
+	uint64		generation;		/* bucket's counter before planning */
+} SharedPlanDep;
+
+/*
+ * A stored plan.  The query text and the serialized plan, each
+ * NUL-terminated, follow the dependency array.
+ */
+typedef struct SharedPlanData
+{
+	uint64		generation;		/* global counter before planning */
+	int			ndeps;
+	int			query_len;
+	int			plan_len;
+	SharedPlanDep deps[FLEXIBLE_ARRAY_MEMBER];
+} SharedPlanData;
+
+#define SharedPlanDataQuery(data) \
+	((char *) &(data)->deps[(data)->ndeps])
+#define SharedPlanDataPlan(data) \
+	(SharedPlanDataQuery(data) + (data)->query_len + 1)
+
+/* Shared hash table entry */
+typedef struct SharedPlanCacheEntry
+{
+	SharedPlanCacheKey key;
+	dsa_pointer data;			/* SharedPlanData */
+	Size		size;			/* allocated size of data */
+} SharedPlanCacheEntry;
+
+/* GUC variable */
+int			shared_plan_cache_size = 0;
+
+static SharedPlanCacheControl *SharedPlanCache = NULL;
+
+/* Backend-local attachment to the DSA area and the hash table */
+static dsa_area *spc_dsa = NULL;
+static dshash_table *spc_hash = NULL;
+
+static const dshash_parameters spc_hash_params = {
+	sizeof(SharedPlanCacheKey),
+	sizeof(SharedPlanCacheEntry),
+	dshash_memcmp,
+	dshash_memhash,
+	dshash_memcpy,
+	LWTRANCHE_SHARED_PLAN_CACHE_HASH
+};
+
+static void spc_attach(void);
+static void spc_detach(int code, Datum arg);
+static void spc_compute_key(CachedPlanSource *plansource,
+							SharedPlanCacheKey *key);
+static uint64 spc_settings_hash(void);
+static bool spc_plan_is_current(SharedPlanData *data);
+static uint64 *spc_read_generations(void);
+static void spc_remove(SharedPlanCacheKey *key, dsa_pointer stale);
+
+static inline uint32
+spc_rel_bucket(Oid relid)
+{
+	return hash_bytes_uint32(relid) % SPC_INVAL_BUCKETS;
+}
+
+static inline uint32
+spc_object_bucket(int cacheid, uint32 hashvalue)
+{
+	return hash_combine(hash_bytes_uint32((uint32) cacheid), hashvalue) %
+		SPC_INVAL_BUCKETS;
+}
+
+
+/*
+ * The size of the DSA area created in the main shared memory segment.  It
+ * can grow beyond that using DSM segments, but normally all plans fit.
+ */
+static Size
+spc_dsa_init_size(void)
+{
+	Size		sz;
+
+	sz = mul_size((Size) shared_plan_cache_size, 1024);
+	sz = Max(sz, dsa_minimum_size());
+	return MAXALIGN(sz);
+}
+
+/*
+ * Report shared-memory space needed by SharedPlanCacheShmemInit.
+ */
+Size
+SharedPlanCacheShmemSize(void)
+{
+	Size		sz;
+
+	if (shared_plan_cache_size == 0)
+		return 0;
+
+	sz = MAXALIGN(sizeof(SharedPlanCacheControl));
+	sz = add_size(sz, spc_dsa_init_size());
+
+	return sz;
+}
+
+/*
+ * Initialize the shared plan cache during startup.
+ */
+void
+SharedPlanCacheShmemInit(void)
+{
+	bool		found;
+
+	if (shared_plan_cache_size == 0)
+		return;
+
+	SharedPlanCache = (SharedPlanCacheControl *)
+		ShmemInitStruct("Shared Plan Cache", SharedPlanCacheShmemSize(),
+						&found);
+
+	if (!IsUnderPostmaster)
+	{
+		dsa_area   *dsa;
+		dshash_table *dsh;
+		char	   *p = (char *) SharedPlanCache;
+
+		Assert(!found);
+
+		p += MAXALIGN(sizeof(SharedPlanCacheControl));
+		SharedPlanCache->raw_dsa_area = p;
+		dsa = dsa_create_in_place(SharedPlanCache->raw_dsa_area,
+								  spc_dsa_init_size(),
+								  LWTRANCHE_SHARED_PLAN_CACHE_DSA, 0);
+		dsa_pin(dsa);
+
+		/*
+		 * Create the hash table while the area is limited to plain shared
+		 * memory, as in StatsShmemInit(); the postmaster can't use DSM
+		 * segments.
+		 */
+		dsa_set_size_limit(dsa, spc_dsa_init_size());
+		dsh = dshash_create(dsa, &spc_hash_params, NULL);
+		SharedPlanCache->hash_handle = dshash_get_hash_table_handle(dsh);
+		dsa_set_size_limit(dsa, -1);
+
+		dshash_detach(dsh);
+		dsa_detach(dsa);
+
+		pg_atomic_init_u64(&SharedPlanCache->used_bytes, 0);
+		pg_atomic_init_u64(&SharedPlanCache->generation, 0);
+		for (int i = 0; i < SPC_INVAL_BUCKETS; i++)
+			pg_atomic_init_u64(&SharedPlanCache->bucket_generation[i], 0);
+	}
+	else
+		Assert(found);
+}
+
+/*
+ * Attach to the shared hash table, if not done already in this backend.
+ */
+static void
+spc_attach(void)
+{
+	MemoryContext oldcontext;
+
+	if (spc_hash != NULL)
+		return;
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	spc_dsa = dsa_attach_in_place(SharedPlanCache->raw_dsa_area, NULL);
+	dsa_pin_mapping(spc_dsa);
+	spc_hash = dshash_attach(spc_dsa, &spc_hash_params,
+							 SharedPlanCache->hash_handle, NULL);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	on_shmem_exit(spc_detach, 0);
+}
+
+/*
+ * dsa_attach_in_place() without a segment doesn't arrange for the area's
+ * reference count to be decremented at exit, so do that ourselves.
+ */
+static void
+spc_detach(int code, Datum arg)
+{
+	dsa_release_in_place(SharedPlanCache->raw_dsa_area);
+}
+
+/*
+ * Compute the shared plan cache key for the plansource's generic plan in
+ * the current environment.
+ */
+static void
+spc_compute_key(CachedPlanSource *plansource, SharedPlanCacheKey *key)
+{
+	List	   *search_path;
+	ListCell   *lc;
+	uint64		h;
+
+	memset(key, 0, sizeof(SharedPlanCacheKey));
+	key->dbid = MyDatabaseId;
+	key->userid = GetUserId();
+	key->query_hash =
+		hash_bytes_extended((const unsigned char *) plansource->query_string,
+							strlen(plansource->query_string), 0);
+
+	h = hash_bytes_uint32_extended((uint32) plansource->cursor_options, 0);
+	h = hash_combine64(h, (uint64) row_security);
+	h = hash_combine64(h, (uint64) plansource->num_params);
+	if (plansource->num_params > 0)
+		h = hash_combine64(h,
+						   hash_bytes_extended((const unsigned char *) plansource->param_types,
+											   plansource->num_params * sizeof(Oid), 0));
+
+	/* the schemas that unqualified names resolved to, in order */
+	search_path = fetch_search_path(true);
+	h = hash_combine64(h, (uint64) list_length(search_path));
+	foreach(lc, search_path)
+		h = hash_combine64(h, (uint64) lfirst_oid(lc));
+	list_free(search_path);
+
+	h = hash_combine64(h, spc_settings_hash());
+
+	key->env_hash = h;
+}
+
+/*
+ * Settings outside the planner's GUC groups that change how the query text
+ * is analyzed, or the values of constants that are folded into the plan.
+ */
+static const char *const spc_parse_settings[] = {
+	"array_nulls",
+	"DateStyle",
+	"IntervalStyle",
+	"lc_monetary",
+	"standard_conforming_strings",
+	"TimeZone",
+	"transform_null_equals",
+	"xmloption",
+};
+
+/*
+ * Hash the values of all settings that can affect the plan: those of the
+ * planner's GUC groups, and spc_parse_settings.
+ */
+static uint64
+spc_settings_hash(void)
+{
+	struct config_generic **gucs;
+	int			ngucs;
+	uint64		result = 0;
+
+	/* this returns the variables sorted by name */
+	gucs = get_guc_variables(&ngucs);
+
+	for (int i = 0; i < ngucs; i++)
+	{
+		struct config_generic *conf = gucs[i];
+		char	   *value;
+
+		if (conf->group != QUERY_TUNING_METHOD &&
+			conf->group != QUERY_TUNING_COST &&
+			conf->group != QUERY_TUNING_GEQO &&
+			conf->group != QUERY_TUNING_OTHER &&
+			conf->group != RESOURCES_MEM)
+			continue;
+
+		value = ShowGUCOption(conf, false);
+		result = hash_combine64(result,
+								hash_bytes_extended((const unsigned char *) conf->name,
+													strlen(conf->name), 0));
+		result = hash_combine64(result,
+								hash_bytes_extended((const unsigned char *) value,
+													strlen(value), 0));
+		pfree(value);
+	}
+
+	pfree(gucs);
+
+	for (int i = 0; i < lengthof(spc_parse_settings); i++)
+	{
+		const char *value = GetConfigOption(spc_parse_settings[i], false,
+											false);
+
+		result = hash_combine64(result,
+								hash_bytes_extended((const unsigned char *) value,
+													strlen(value), 0));
+	}
+
+	return result;
+}
+
+/*
+ * Has none of a stored plan's dependencies been invalidated since it was
+ * built?
+ */
+static bool
+spc_plan_is_current(SharedPlanData *data)
+{
+	if (pg_atomic_read_u64(&SharedPlanCache->generation) != data->generation)
+		return false;
+
+	for (int i = 0; i < data->ndeps; i++)
+	{
+		SharedPlanDep *dep = &data->deps[i];
+
+		if (pg_atomic_read_u64(&SharedPlanCache->bucket_generation[dep->bucket]) !=
+			dep->generation)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Take a snapshot of all the invalidation counters.  The global counter is
+ * stored last, at SPC_GLOBAL_GENERATION.
+ */
+static uint64 *
+spc_read_generations(void)
+{
+	uint64	   *generations;
+
+	generations = palloc((SPC_INVAL_BUCKETS + 1) * sizeof(uint64));
+	for (int i = 0; i < SPC_INVAL_BUCKETS; i++)
+		generations[i] =
+			pg_atomic_read_u64(&SharedPlanCache->bucket_generation[i]);
+	generations[SPC_GLOBAL_GENERATION] =
+		pg_atomic_read_u64(&SharedPlanCache->generation);
+
+	/* make sure we don't read catalog data from before these counters */
+	pg_read_barrier();
+
+	return generations;
+}
+
+/*
+ * Remove a stale entry, unless someone else has replaced it already.
+ */
+static void
+spc_remove(SharedPlanCacheKey *key, dsa_pointer stale)
+{
+	SharedPlanCacheEntry *entry;
+
+	entry = dshash_find(spc_hash, key, true);
+	if (entry == NULL)
+		return;
+
+	if (entry->data == stale)
+	{
+		Size		size = entry->size;
+
+		dshash_delete_entry(spc_hash, entry);
+		dsa_free(spc_dsa, stale);
+		pg_atomic_sub_fetch_u64(&SharedPlanCache->used_bytes, size);
+	}
+	else
+		dshash_release_lock(spc_hash, entry);
+}
+
+/*
+ * SharedPlanCacheLookup: find a usable generic plan for the plansource.
+ *
+ * The caller must have revalidated the plansource's query tree, and so
+ * hold locks on the relations it uses.
+ *
+ * Returns a freshly deserialized list of PlannedStmts, in the caller's memory
+ * context, or NIL if there is none.  In the former case, the caller must lock
+ * the plan's relations and pass the probe to SharedPlanCacheRecheck() before
+ * using the plan.  In the latter case, the probe is filled in, and should be
+ * passed to SharedPlanCacheStore() once the caller has built the plan itself.
+ */
+List *
+SharedPlanCacheLookup(CachedPlanSource *plansource,
+					  SharedPlanCacheProbe *probe)
+{
+	SharedPlanCacheEntry *entry;
+	dsa_pointer stale = InvalidDsaPointer;
+	char	   *plan_string = NULL;
+
+	Assert(SharedPlanCache != NULL);
+
+	spc_attach();
+	spc_compute_key(plansource, &probe->key);
+	probe->generations = NULL;
+
+	probe->adopted = NULL;
+
+	entry = dshash_find(spc_hash, &probe->key, false);
+	if (entry != NULL)
+	{
+		SharedPlanData *data = dsa_get_address(spc_dsa, entry->data);
+
+		/* the key only has a hash of the query text, so check it */
+		if (strcmp(SharedPlanDataQuery(data), plansource->query_string) == 0)
+		{
+			if (spc_plan_is_current(data))
+			{
+				Size		deps_size;
+
+				plan_string = palloc(data->plan_len + 1);
+				memcpy(plan_string, SharedPlanDataPlan(data),
+					   data->plan_len + 1);
+
+				/* keep the dependencies for SharedPlanCacheRecheck() */
+				deps_size = offsetof(SharedPlanData, deps) +
+					data->ndeps * sizeof(SharedPlanDep);
+				probe->adopted = palloc(deps_size);
+				memcpy(probe->adopted, data, deps_size);
+			}
+			else
+				stale = entry->data;
+		}
+		dshash_release_lock(spc_hash, entry);
+	}
+
+	if (DsaPointerIsValid(stale))
+		spc_remove(&probe->key, stale);
+
+	if (plan_string != NULL)
+	{
+		List	   *stmt_list;
+
+		stmt_list = (List *) stringToNode(plan_string);
+		pfree(plan_string);
+
+		return stmt_list;
+	}
+
+	/* Remember the invalidation counters before the caller starts planning */
+	probe->generations = spc_read_generations();
+
+	return NIL;
+}
+
+/*
+ * SharedPlanCacheRecheck: check that a plan returned by
+ * SharedPlanCacheLookup() is still current.
+ *
+ * The caller must have locked all the relations used by the plan, which
+ * includes partitions and inheritance children that the query's own locks
+ * don't cover.  If the plan has become stale, the probe is prepared for
+ * SharedPlanCacheStore(), as if the lookup had failed.
+ */
+bool
+SharedPlanCacheRecheck(SharedPlanCacheProbe *probe)
+{
+	Assert(probe->adopted != NULL);
+
+	if (spc_plan_is_current(probe->adopted))
+		return true;
+
+	pfree(probe->adopted);
+	probe->adopted = NULL;
+	probe->generations = spc_read_generations();
+
+	return false;
+}
+
+/*
+ * SharedPlanCacheStore: add a generic plan built after an unsuccessful
+ * SharedPlanCacheLookup() to the shared plan cache, if it's suitable.
+ */
+void
+SharedPlanCacheStore(CachedPlanSource *plansource,
+					 SharedPlanCacheProbe *probe, List *stmt_list)
+{
+	Bitmapset  *buckets = NULL;
+	ListCell   *lc;
+	char	   *plan_string;
+	Size		query_len;
+	Size		plan_len;
+	Size		size;
+	dsa_pointer dp;
+	SharedPlanData *data;
+	SharedPlanCacheEntry *entry;
+	bool		found;
+	int			bucket;
+	int			i;
+
+	if (probe->generations == NULL)
+		return;
+
+	/* The query tree's dependencies are normally a subset, but be sure */
+	foreach(lc, plansource->relationOids)
+		buckets = bms_add_member(buckets, spc_rel_bucket(lfirst_oid(lc)));
+	foreach(lc, plansource->invalItems)
+	{
+		PlanInvalItem *item = (PlanInvalItem *) lfirst(lc);
+
+		buckets = bms_add_member(buckets,
+								 spc_object_bucket(item->cacheId,
+												   item->hashValue));
+	}
+
+	foreach(lc, stmt_list)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+		ListCell   *lc2;
+
+		/* Utility statements and transient plans are not shareable */
+		if (plannedstmt->commandType == CMD_UTILITY ||
+			plannedstmt->transientPlan)
+			return;
+
+		foreach(lc2, plannedstmt->relationOids)
+		{
+			Oid			relid = lfirst_oid(lc2);
+
+			/* Temporary tables are private to one backend */
+			if (get_rel_persistence(relid) == RELPERSISTENCE_TEMP)
+				return;
+
+			buckets = bms_add_member(buckets, spc_rel_bucket(relid));
+		}
+
+		foreach(lc2, plannedstmt->invalItems)
+		{
+			PlanInvalItem *item = (PlanInvalItem *) lfirst(lc2);
+
+			buckets = bms_add_member(buckets,
+									 spc_object_bucket(item->cacheId,
+													   item->hashValue));
+		}
+	}
+
+	plan_string = nodeToString(stmt_list);
+	query_len = strlen(plansource->query_string);
+	plan_len = strlen(plan_string);
+	size = offsetof(SharedPlanData, deps) +
+		bms_num_members(buckets) * sizeof(SharedPlanDep) +
+		query_len + 1 + plan_len + 1;
+
+	/* Give up if that would exceed shared_plan_cache_size */
+	if (pg_atomic_add_fetch_u64(&SharedPlanCache->used_bytes, size) >
+		(uint64) shared_plan_cache_size * 1024)
+	{
+		pg_atomic_sub_fetch_u64(&SharedPlanCache->used_bytes, size);
+		pfree(plan_string);
+		return;
+	}
+
+	dp = dsa_allocate_extended(spc_dsa, size, DSA_ALLOC_NO_OOM);
+	if (!DsaPointerIsValid(dp))
+	{
+		pg_atomic_sub_fetch_u64(&SharedPlanCache->used_bytes, size);
+		pfree(plan_string);
+		return;
+	}
+
+	data = dsa_get_address(spc_dsa, dp);
+	data->generation = probe->generations[SPC_GLOBAL_GENERATION];
+	data->ndeps = bms_num_members(buckets);
+	data->query_len = query_len;
+	data->plan_len = plan_len;
+	i = 0;
+	bucket = -1;
+	while ((bucket = bms_next_member(buckets, bucket)) >= 0)
+	{
+		data->deps[i].bucket = bucket;
+		data->deps[i].generation = probe->generations[bucket];
+		i++;
+	}
+	memcpy(SharedPlanDataQuery(data), plansource->query_string, query_len + 1);
+	memcpy(SharedPlanDataPlan(data), plan_string, plan_len + 1);
+	pfree(plan_string);
+
+	/* Insert it, replacing any existing entry */
+	entry = dshash_find_or_insert(spc_hash, &probe->key, &found);
+	if (found)
+	{
+		dsa_pointer old_data = entry->data;
+		Size		old_size = entry->size;
+
+		entry->data = dp;
+		entry->size = size;
+		dshash_release_lock(spc_hash, entry);
+
+		dsa_free(spc_dsa, old_data);
+		pg_atomic_sub_fetch_u64(&SharedPlanCache->used_bytes, old_size);
+	}
+	else
+	{
+		entry->data = dp;
+		entry->size = size;
+		dshash_release_lock(spc_hash, entry);
+	}
+
+	bms_free(buckets);
+}
+
+/*
+ * SharedPlanCacheInvalidateRel
+ *		Note that plans depending on the given relation, or on any relation
+ *		if relid == InvalidOid, are no longer valid.
+ *
+ * Called from the relcache inval callback of plancache.c.
+ */
+void
+SharedPlanCacheInvalidateRel(Oid relid)
+{
+	if (SharedPlanCache == NULL)
+		return;
+
+	if (relid == InvalidOid)
+		SharedPlanCacheInvalidateAll();
+	else
+		pg_atomic_fetch_add_u64(&SharedPlanCache->bucket_generation[spc_rel_bucket(relid)],
+								1);
+}
+
+/*
+ * SharedPlanCacheInvalidateObject
+ *		Likewise for a syscache object, or all objects of the cache if
+ *		hashvalue == 0.
+ */
+void
+SharedPlanCacheInvalidateObject(int cacheid, uint32 hashvalue)
+{
+	if (SharedPlanCache == NULL)
+		return;
+
+	if (hashvalue == 0)
+		SharedPlanCacheInvalidateAll();
+	else
+		pg_atomic_fetch_add_u64(&SharedPlanCache->bucket_generation[spc_object_bucket(cacheid, hashvalue)],
+								1);
+}
+
+/*
+ * SharedPlanCacheInvalidateAll
+ *		Note that no stored plan is valid anymore.
+ */
+void
+SharedPlanCacheInvalidateAll(void)
+{
+	if (SharedPlanCache == NULL)
+		return;
+
+	pg_atomic_fetch_add_u64(&SharedPlanCache->generation, 1);
+}
@@ -1998,6 +1998,26 @@ pg_timezone_abbrev_initialize(void)
 }
 
 
+/*
+ * Has any option been changed for the session, by SET or set_config()?
+ */
+bool
+GUCSessionSettingsExist(void)
+{
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &guc_nondef_list)
+	{
+		struct config_generic *gconf = dlist_container(struct config_generic,
+													   nondef_link, iter.cur);
+
+		if (gconf->source == PGC_S_SESSION)
+			return true;
+	}
+
+	return false;
+}
+
 /*
  * Reset all options to their saved default values (implements RESET ALL)
  */
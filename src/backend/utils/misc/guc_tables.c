@@ -27,11 +27,13 @@
 #endif
 
 #include "access/commit_ts.h"
+#include "access/csnlog.h"
 #include "access/gin.h"
 #include "access/slru.h"
 #include "access/toast_compression.h"
 #include "access/twophase.h"
 #include "access/xlog_internal.h"
+#include "access/xlogparallel.h"
 #include "access/xlogprefetcher.h"
 #include "access/xlogrecovery.h"
 #include "archive/archive_module.h"
@@ -43,8 +45,10 @@
 #include "commands/trigger.h"
 #include "commands/user.h"
 #include "commands/vacuum.h"
+#include "common/compression.h"
 #include "common/file_utils.h"
 #include "common/scram-common.h"
+#include "executor/execBatch.h"
 #include "jit/jit.h"
 #include "libpq/auth.h"
 #include "libpq/libpq.h"
@@ -62,6 +66,7 @@
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/bgwriter.h"
 #include "postmaster/postmaster.h"
+#include "postmaster/sessionpool.h"
 #include "postmaster/startup.h"
 #include "postmaster/syslogger.h"
 #include "postmaster/walsummarizer.h"
@@ -70,10 +75,12 @@
 #include "replication/slot.h"
 #include "replication/slotsync.h"
 #include "replication/syncrep.h"
+#include "storage/aio.h"
 #include "storage/bufmgr.h"
 #include "storage/large_object.h"
 #include "storage/pg_shmem.h"
 #include "storage/predicate.h"
+#include "storage/proc.h"
 #include "storage/standby.h"
 #include "tcop/tcopprot.h"
 #include "tsearch/ts_cache.h"
@@ -87,6 +94,8 @@
 #include "utils/pg_locale.h"
 #include "utils/plancache.h"
 #include "utils/ps_status.h"
+#include "utils/sharedcatcache.h"
+#include "utils/sharedplancache.h"
 #include "utils/xml.h"
 
 /* This value is normally passed in from the Makefile */
@@ -110,6 +119,7 @@ extern bool trace_syncscan;
 #ifdef DEBUG_BOUNDED_SORT
 extern bool optimize_bounded_sort;
 #endif
+extern bool optimize_radix_sort;
 
 /*
  * Options for enum values defined in this module.
@@ -378,6 +388,14 @@ static const struct config_enum_entry huge_pages_status_options[] = {
 	{NULL, 0, false}
 };
 
+static const struct config_enum_entry io_method_options[] = {
+	{"sync", IOMETHOD_SYNC, false},
+#ifdef USE_IOMETHOD_IO_URING
+	{"io_uring", IOMETHOD_IO_URING, false},
+#endif
+	{NULL, 0, false}
+};
+
 static const struct config_enum_entry recovery_prefetch_options[] = {
 	{"off", RECOVERY_PREFETCH_OFF, false},
 	{"on", RECOVERY_PREFETCH_ON, false},
@@ -426,6 +444,20 @@ static const struct config_enum_entry ssl_protocol_versions_info[] = {
 	{NULL, 0, false}
 };
 
+static const struct config_enum_entry logical_decoding_spill_compression_options[] = {
+#ifdef USE_LZ4
+	{"lz4", PG_COMPRESSION_LZ4, false},
+#endif
+#ifdef USE_ZSTD
+	{"zstd", PG_COMPRESSION_ZSTD, false},
+#endif
+	{"off", PG_COMPRESSION_NONE, false},
+	{"false", PG_COMPRESSION_NONE, true},
+	{"no", PG_COMPRESSION_NONE, true},
+	{"0", PG_COMPRESSION_NONE, true},
+	{NULL, 0, false}
+};
+
 static const struct config_enum_entry debug_logical_replication_streaming_options[] = {
 	{"buffered", DEBUG_LOGICAL_REP_STREAMING_BUFFERED, false},
 	{"immediate", DEBUG_LOGICAL_REP_STREAMING_IMMEDIATE, false},
@@ -950,6 +982,17 @@ struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_parallel_hashagg", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of parallel hash aggregation plans."),
+			gettext_noop("Allows the final hash aggregation step to run in parallel workers, "
+						 "each finalizing a disjoint subset of the groups."),
+			GUC_EXPLAIN
+		},
+		&enable_parallel_hashagg,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_partition_pruning", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables plan-time and execution-time partition pruning."),
@@ -1056,6 +1099,16 @@ struct config_bool ConfigureNamesBool[] =
 		false,
 		NULL, NULL, NULL
 	},
+	{
+		{"csn_snapshots", PGC_POSTMASTER, LOCK_MANAGEMENT,
+			gettext_noop("Takes MVCC snapshots using commit sequence numbers."),
+			gettext_noop("Snapshots then no longer need to scan the list of running transactions "
+						 "or acquire ProcArrayLock.")
+		},
+		&csn_snapshots,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"ssl", PGC_SIGHUP, CONN_AUTH_SSL,
 			gettext_noop("Enables SSL connections."),
@@ -1688,6 +1741,17 @@ struct config_bool ConfigureNamesBool[] =
 	},
 #endif
 
+	{
+		{"optimize_radix_sort", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Enable radix sorting of in-memory sorts on integer and abbreviated keys."),
+			NULL,
+			GUC_NOT_IN_SAMPLE
+		},
+		&optimize_radix_sort,
+		true,
+		NULL, NULL, NULL
+	},
+
 #ifdef WAL_DEBUG
 	{
 		{"wal_debug", PGC_SUSET, DEVELOPER_OPTIONS,
@@ -2080,6 +2144,15 @@ struct config_int ConfigureNamesInt[] =
 		8, 1, INT_MAX,
 		NULL, NULL, NULL
 	},
+	{
+		{"jit_deform_cache_size", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets the maximum number of JIT-compiled tuple deforming functions kept for reuse by later queries."),
+			gettext_noop("0 disables the cache.")
+		},
+		&jit_deform_cache_size,
+		256, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
 	{
 		{"join_collapse_limit", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Sets the FROM-list size beyond which JOIN "
@@ -2093,6 +2166,16 @@ struct config_int ConfigureNamesInt[] =
 		8, 1, INT_MAX,
 		NULL, NULL, NULL
 	},
+	{
+		{"executor_batch_size", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets the number of rows a sequential scan passes to an aggregate at a time."),
+			gettext_noop("Zero passes rows one at a time."),
+			GUC_EXPLAIN
+		},
+		&executor_batch_size,
+		1024, 0, 65536,
+		NULL, NULL, NULL
+	},
 	{
 		{"geqo_threshold", PGC_USERSET, QUERY_TUNING_GEQO,
 			gettext_noop("Sets the threshold of FROM items beyond which GEQO is used."),
@@ -2233,6 +2316,26 @@ struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"max_pooled_sessions", PGC_POSTMASTER, CONN_AUTH_SETTINGS,
+			gettext_noop("Sets the maximum number of idle client sessions kept without a backend."),
+			gettext_noop("Zero disables session pooling.")
+		},
+		&max_pooled_sessions,
+		0, 0, MAX_BACKENDS,
+		check_max_pooled_sessions, NULL, NULL
+	},
+
+	{
+		{"session_pool_size", PGC_SU_BACKEND, CONN_AUTH_SETTINGS,
+			gettext_noop("Sets the maximum number of backends serving pooled sessions of the same database and role."),
+			NULL
+		},
+		&session_pool_size,
+		10, 1, MAX_BACKENDS,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"min_dynamic_shared_memory", PGC_POSTMASTER, RESOURCES_MEM,
 			gettext_noop("Amount of dynamic shared memory reserved at startup."),
@@ -2244,6 +2347,28 @@ struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"shared_plan_cache_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the amount of memory used to share generic plans between sessions."),
+			gettext_noop("Zero disables the shared plan cache."),
+			GUC_UNIT_KB
+		},
+		&shared_plan_cache_size,
+		0, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"shared_catcache_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the amount of memory used to share catalog cache entries between sessions."),
+			gettext_noop("Zero disables the shared catalog cache."),
+			GUC_UNIT_KB
+		},
+		&shared_catcache_size,
+		0, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
 	/*
 	 * We sometimes multiply the number of shared buffers by two without
 	 * checking for overflow, so we mustn't allow more than INT_MAX / 2.
@@ -2259,6 +2384,16 @@ struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"clock_sweep_partitions", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of partitions the buffer replacement clock sweep is divided into."),
+			NULL
+		},
+		&clock_sweep_partitions,
+		1, 1, 128,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"vacuum_buffer_usage_limit", PGC_USERSET, RESOURCES_MEM,
 			gettext_noop("Sets the buffer pool size for VACUUM, ANALYZE, and autovacuum."),
@@ -2727,6 +2862,16 @@ struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"fast_path_locks_per_backend", PGC_POSTMASTER, LOCK_MANAGEMENT,
+			gettext_noop("Sets the number of relation locks each backend can hold without using the shared lock table."),
+			gettext_noop("The value is rounded up to a multiple of 16.")
+		},
+		&fast_path_locks_per_backend,
+		64, 16, FP_LOCK_GROUPS_PER_BACKEND_MAX * FP_LOCK_SLOTS_PER_GROUP,
+		NULL, assign_fast_path_locks_per_backend, NULL
+	},
+
 	{
 		{"max_pred_locks_per_transaction", PGC_POSTMASTER, LOCK_MANAGEMENT,
 			gettext_noop("Sets the maximum number of predicate locks per transaction."),
@@ -2795,6 +2940,16 @@ struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"recovery_parallel_workers", PGC_POSTMASTER, WAL_RECOVERY,
+			gettext_noop("Sets the number of worker processes that apply WAL records in parallel during recovery."),
+			gettext_noop("Zero applies all WAL records in the startup process.")
+		},
+		&recovery_parallel_workers,
+		0, 0, MAX_PARALLEL_WORKER_LIMIT,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"wal_decode_buffer_size", PGC_POSTMASTER, WAL_RECOVERY,
 			gettext_noop("Buffer size for reading ahead in the WAL during recovery."),
@@ -2889,6 +3044,16 @@ struct config_int ConfigureNamesInt[] =
 		check_wal_buffers, NULL, NULL
 	},
 
+	{
+		{"wal_insert_locks", PGC_POSTMASTER, WAL_SETTINGS,
+			gettext_noop("Sets the number of locks used for concurrent insertions into the WAL."),
+			NULL
+		},
+		&NumXLogInsertLocks,
+		8, 1, MAX_WAL_INSERT_LOCKS,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"wal_writer_delay", PGC_SIGHUP, WAL_SETTINGS,
 			gettext_noop("Time between WAL flushes performed in the WAL writer."),
@@ -3139,6 +3304,19 @@ struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"io_max_concurrency",
+			PGC_POSTMASTER,
+			RESOURCES_ASYNCHRONOUS,
+			gettext_noop("Maximum number of asynchronous I/Os that one process can have in progress."),
+			NULL
+		},
+		&io_max_concurrency,
+		DEFAULT_IO_MAX_CONCURRENCY,
+		1, 1024,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"backend_flush_after", PGC_USERSET, RESOURCES_ASYNCHRONOUS,
 			gettext_noop("Number of pages after which previously performed writes are flushed to disk."),
@@ -4981,6 +5159,16 @@ struct config_enum ConfigureNamesEnum[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"io_method", PGC_POSTMASTER, RESOURCES_ASYNCHRONOUS,
+			gettext_noop("Selects the method for performing asynchronous I/O."),
+			NULL
+		},
+		&io_method,
+		DEFAULT_IO_METHOD, io_method_options,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"shared_memory_type", PGC_POSTMASTER, RESOURCES_MEM,
 			gettext_noop("Selects the shared memory implementation used for the main shared memory region."),
@@ -4991,6 +5179,16 @@ struct config_enum ConfigureNamesEnum[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"logical_decoding_spill_compression", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Compresses the changes spilled to disk by logical decoding with specified method."),
+			NULL
+		},
+		&logical_decoding_spill_compression,
+		PG_COMPRESSION_NONE, logical_decoding_spill_compression_options,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"wal_sync_method", PGC_SIGHUP, WAL_SETTINGS,
 			gettext_noop("Selects the method used for forcing WAL updates to disk."),
@@ -1186,6 +1186,16 @@ ThereAreNoReadyPortals(void)
 	return true;
 }
 
+/*
+ * Are there no portals at all?  Outside a transaction, that means there are
+ * no holdable cursors.
+ */
+bool
+ThereAreNoPortals(void)
+{
+	return hash_get_num_entries(PortalHashTable) == 0;
+}
+
 /*
  * Hold all pinned portals.
  *
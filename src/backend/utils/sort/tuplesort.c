@@ -7,9 +7,9 @@
  * applied to different kinds of sortable objects.  Implementation of
  * the particular sorting variants is given in tuplesortvariants.c.
  * This module works efficiently for both small and large amounts
- * of data.  Small amounts are sorted in-memory using qsort().  Large
- * amounts are sorted using temporary files and a standard external sort
- * algorithm.
+ * of data.  Small amounts are sorted in-memory using qsort(), or a radix
+ * sort when the leading key maps to unsigned integers.  Large amounts are
+ * sorted using temporary files and a standard external sort algorithm.
  *
  * See Knuth, volume 3, for more than you want to know about external
  * sorting algorithms.  The algorithm we use is a balanced k-way merge.
@@ -128,6 +128,26 @@ bool		trace_sort = false;
 bool		optimize_bounded_sort = true;
 #endif
 
+bool		optimize_radix_sort = true;
+
+/*
+ * Sorts of at least RADIX_SORT_MIN_TUPLES tuples whose leading key has one of
+ * the specialized comparators below are radix sorted on datum1.  Partitions
+ * smaller than RADIX_SORT_QSORT_TUPLES are finished with the specialized
+ * qsort instead, which also breaks ties.
+ */
+#define RADIX_SORT_MIN_TUPLES		1024
+#define RADIX_SORT_QSORT_TUPLES		64
+
+/* How datum1 is turned into an unsigned radix sort key */
+typedef enum RadixSortKind
+{
+	RADIX_SORT_NONE,			/* no radix sort possible */
+	RADIX_SORT_UNSIGNED,		/* ssup_datum_unsigned_cmp */
+	RADIX_SORT_SIGNED,			/* ssup_datum_signed_cmp */
+	RADIX_SORT_INT32,			/* ssup_datum_int32_cmp */
+} RadixSortKind;
+
 
 /*
  * During merge, we use a pre-allocated set of fixed-size slots to hold
@@ -481,6 +501,12 @@ static void leader_takeover_tapes(Tuplesortstate *state);
 static void free_sort_tuple(Tuplesortstate *state, SortTuple *stup);
 static void tuplesort_free(Tuplesortstate *state);
 static void tuplesort_updatemax(Tuplesortstate *state);
+static RadixSortKind radix_sort_kind(Tuplesortstate *state);
+static void radix_sort_tuples(Tuplesortstate *state, RadixSortKind kind);
+static void radix_sort_level(SortTuple *tuples, size_t n, int level,
+							 Tuplesortstate *state, RadixSortKind kind);
+static void radix_sort_finish(SortTuple *tuples, size_t n,
+							  Tuplesortstate *state, RadixSortKind kind);
 
 /*
  * Specialized comparators that we can inline into specialized sorts.  The goal
@@ -2706,9 +2732,9 @@ sort_bounded_heap(Tuplesortstate *state)
 }
 
 /*
- * Sort all memtuples using specialized qsort() routines.
+ * Sort all memtuples using specialized qsort() or radix sort routines.
  *
- * Quicksort is used for small in-memory sorts, and external sort runs.
+ * This is used for in-memory sorts, and external sort runs.
  */
 static void
 tuplesort_sort_memtuples(Tuplesortstate *state)
@@ -2717,6 +2743,19 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 
 	if (state->memtupcount > 1)
 	{
+		/* Is the sort large enough, and datum1 suitable, for radix sort? */
+		if (optimize_radix_sort &&
+			state->memtupcount >= RADIX_SORT_MIN_TUPLES)
+		{
+			RadixSortKind kind = radix_sort_kind(state);
+
+			if (kind != RADIX_SORT_NONE)
+			{
+				radix_sort_tuples(state, kind);
+				return;
+			}
+		}
+
 		/*
 		 * Do we have the leading column's value or abbreviation in datum1,
 		 * and is there a specialization for its comparator?
@@ -2764,6 +2803,248 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 	}
 }
 
+/*
+ * Radix sort support
+ *
+ * When the leading key's comparator is one of the specialized datum
+ * comparators, datum1 orders like an unsigned integer once the sign bit of
+ * signed values is flipped, and all bits are inverted for descending sorts.
+ * We then MSD radix sort the memtuples on datum1 a byte at a time, in place
+ * (American flag sort), after moving the NULLs to the side of the array that
+ * the sort key wants them on.  Small partitions, and partitions whose keys
+ * are all equal, are finished with the specialized qsort, which also breaks
+ * ties on abbreviated keys and on the other sort keys.
+ */
+
+/*
+ * Which kind of radix sort key, if any, can be built from datum1?
+ */
+static RadixSortKind
+radix_sort_kind(Tuplesortstate *state)
+{
+	SortSupport ssup;
+
+	if (!state->base.haveDatum1 || state->base.sortKeys == NULL)
+		return RADIX_SORT_NONE;
+
+	ssup = &state->base.sortKeys[0];
+	if (ssup->comparator == ssup_datum_unsigned_cmp)
+		return RADIX_SORT_UNSIGNED;
+#if SIZEOF_DATUM >= 8
+	if (ssup->comparator == ssup_datum_signed_cmp)
+		return RADIX_SORT_SIGNED;
+#endif
+	if (ssup->comparator == ssup_datum_int32_cmp)
+		return RADIX_SORT_INT32;
+
+	return RADIX_SORT_NONE;
+}
+
+/*
+ * Number of significant bytes of a radix sort key.  Keys are left-aligned
+ * in a uint64, so these are always the leading bytes.
+ */
+static inline int
+radix_sort_key_bytes(RadixSortKind kind)
+{
+	if (kind == RADIX_SORT_INT32 || SIZEOF_DATUM < 8)
+		return 4;
+	return 8;
+}
+
+/*
+ * Map a non-NULL datum1 to an unsigned key that sorts in the same order.
+ */
+static pg_attribute_always_inline uint64
+radix_sort_key(Datum datum, SortSupport ssup, RadixSortKind kind)
+{
+	uint64		key;
+
+	switch (kind)
+	{
+		case RADIX_SORT_SIGNED:
+			key = (uint64) DatumGetInt64(datum) ^ (UINT64CONST(1) << 63);
+			break;
+		case RADIX_SORT_INT32:
+			key = (uint64) ((uint32) DatumGetInt32(datum) ^ 0x80000000) << 32;
+			break;
+		default:
+#if SIZEOF_DATUM >= 8
+			key = (uint64) datum;
+#else
+			key = (uint64) datum << 32;
+#endif
+			break;
+	}
+
+	if (ssup->ssup_reverse)
+		key = ~key;
+
+	return key;
+}
+
+/*
+ * Radix sort all memtuples.
+ */
+static void
+radix_sort_tuples(Tuplesortstate *state, RadixSortKind kind)
+{
+	SortSupport ssup = &state->base.sortKeys[0];
+	SortTuple  *tuples = state->memtuples;
+	size_t		n = state->memtupcount;
+	size_t		nnulls = 0;
+	SortTuple  *nulls;
+	SortTuple  *notnulls;
+
+	/* Move the NULLs to the front of the array. */
+	for (size_t i = 0; i < n; i++)
+	{
+		if (tuples[i].isnull1)
+		{
+			SortTuple	tmp = tuples[i];
+
+			tuples[i] = tuples[nnulls];
+			tuples[nnulls++] = tmp;
+		}
+	}
+
+	/* ... or to the back, if that's where they sort. */
+	if (nnulls > 0 && !ssup->ssup_nulls_first)
+	{
+		for (size_t i = 0; i < nnulls && i < n - nnulls; i++)
+		{
+			SortTuple	tmp = tuples[i];
+
+			tuples[i] = tuples[n - 1 - i];
+			tuples[n - 1 - i] = tmp;
+		}
+		notnulls = tuples;
+		nulls = tuples + n - nnulls;
+	}
+	else
+	{
+		nulls = tuples;
+		notnulls = tuples + nnulls;
+	}
+
+	/* NULLs are all equal, but may differ in the other keys. */
+	if (nnulls > 1 && state->base.onlyKey == NULL)
+		radix_sort_finish(nulls, nnulls, state, kind);
+
+	radix_sort_level(notnulls, n - nnulls, 0, state, kind);
+}
+
+/*
+ * Sort tuples whose radix sort keys share their first "level" bytes.
+ */
+static void
+radix_sort_level(SortTuple *tuples, size_t n, int level,
+				 Tuplesortstate *state, RadixSortKind kind)
+{
+	SortSupport ssup = &state->base.sortKeys[0];
+	int			nbytes = radix_sort_key_bytes(kind);
+	size_t		counts[256];
+	size_t		next[256];
+	size_t		end[256];
+	int			shift;
+	size_t		pos;
+
+	for (;;)
+	{
+		if (n < RADIX_SORT_QSORT_TUPLES)
+		{
+			radix_sort_finish(tuples, n, state, kind);
+			return;
+		}
+
+		/* Equal keys only need sorting on the other keys. */
+		if (level == nbytes)
+		{
+			if (state->base.onlyKey == NULL)
+				radix_sort_finish(tuples, n, state, kind);
+			return;
+		}
+
+		CHECK_FOR_INTERRUPTS();
+
+		shift = 56 - level * 8;
+		memset(counts, 0, sizeof(counts));
+		for (size_t i = 0; i < n; i++)
+			counts[(radix_sort_key(tuples[i].datum1, ssup, kind) >> shift) & 0xFF]++;
+
+		/* If all keys share this byte, there's nothing to move. */
+		if (counts[(radix_sort_key(tuples[0].datum1, ssup, kind) >> shift) & 0xFF] < n)
+			break;
+		level++;
+	}
+
+	pos = 0;
+	for (int b = 0; b < 256; b++)
+	{
+		next[b] = pos;
+		pos += counts[b];
+		end[b] = pos;
+	}
+
+	/* Swap each tuple into the next free position of its bucket. */
+	for (int b = 0; b < 256; b++)
+	{
+		while (next[b] < end[b])
+		{
+			SortTuple  *tuple = &tuples[next[b]];
+			int			c;
+
+			c = (radix_sort_key(tuple->datum1, ssup, kind) >> shift) & 0xFF;
+			if (c == b)
+				next[b]++;
+			else
+			{
+				SortTuple	tmp = *tuple;
+
+				*tuple = tuples[next[c]];
+				tuples[next[c]++] = tmp;
+			}
+		}
+	}
+
+	/* Recurse into the buckets. */
+	pos = 0;
+	for (int b = 0; b < 256; b++)
+	{
+		if (counts[b] > 1)
+			radix_sort_level(tuples + pos, counts[b], level + 1, state, kind);
+		pos += counts[b];
+	}
+}
+
+/*
+ * Sort a partition with the specialized qsort for the kind of radix sort key.
+ */
+static void
+radix_sort_finish(SortTuple *tuples, size_t n, Tuplesortstate *state,
+				  RadixSortKind kind)
+{
+	if (n < 2)
+		return;
+
+	switch (kind)
+	{
+		case RADIX_SORT_UNSIGNED:
+			qsort_tuple_unsigned(tuples, n, state);
+			break;
+#if SIZEOF_DATUM >= 8
+		case RADIX_SORT_SIGNED:
+			qsort_tuple_signed(tuples, n, state);
+			break;
+#endif
+		case RADIX_SORT_INT32:
+			qsort_tuple_int32(tuples, n, state);
+			break;
+		default:
+			elog(ERROR, "unexpected radix sort kind: %d", (int) kind);
+	}
+}
+
 /*
  * Insert a new tuple into an empty or existing heap, maintaining the
  * heap invariant.  Caller is responsible for ensuring there's room.
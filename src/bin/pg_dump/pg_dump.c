@@ -4787,6 +4787,8 @@ getSubscriptions(Archive *fout)
 	int			i_suboriginremotelsn;
 	int			i_subenabled;
 	int			i_subfailover;
+	int			i_subparallelapply;
+	bool		has_parallelapply = false;
 	int			i,
 				ntups;
 
@@ -4809,6 +4811,20 @@ getSubscriptions(Archive *fout)
 		return;
 	}
 
+	/*
+	 * subparallelapply is not present in every v17 server, so check for the
+	 * column rather than rely on the version.
+	 */
+	if (fout->remoteVersion >= 170000)
+	{
+		res = ExecuteSqlQueryForSingleRow(fout,
+										  "SELECT EXISTS (SELECT 1 FROM pg_catalog.pg_attribute\n"
+										  "  WHERE attrelid = 'pg_catalog.pg_subscription'::pg_catalog.regclass\n"
+										  "  AND attname = 'subparallelapply' AND NOT attisdropped)");
+		has_parallelapply = (strcmp(PQgetvalue(res, 0, 0), "t") == 0);
+		PQclear(res);
+	}
+
 	query = createPQExpBuffer();
 
 	/* Get the subscriptions in current database. */
@@ -4859,10 +4875,17 @@ getSubscriptions(Archive *fout)
 
 	if (fout->remoteVersion >= 170000)
 		appendPQExpBufferStr(query,
-							 " s.subfailover\n");
+							 " s.subfailover,\n");
 	else
 		appendPQExpBuffer(query,
-						  " false AS subfailover\n");
+						  " false AS subfailover,\n");
+
+	if (has_parallelapply)
+		appendPQExpBufferStr(query,
+							 " s.subparallelapply\n");
+	else
+		appendPQExpBufferStr(query,
+							 " false AS subparallelapply\n");
 
 	appendPQExpBufferStr(query,
 						 "FROM pg_subscription s\n");
@@ -4902,6 +4925,7 @@ getSubscriptions(Archive *fout)
 	i_suboriginremotelsn = PQfnumber(res, "suboriginremotelsn");
 	i_subenabled = PQfnumber(res, "subenabled");
 	i_subfailover = PQfnumber(res, "subfailover");
+	i_subparallelapply = PQfnumber(res, "subparallelapply");
 
 	subinfo = pg_malloc(ntups * sizeof(SubscriptionInfo));
 
@@ -4948,6 +4972,8 @@ getSubscriptions(Archive *fout)
 			pg_strdup(PQgetvalue(res, i, i_subenabled));
 		subinfo[i].subfailover =
 			pg_strdup(PQgetvalue(res, i, i_subfailover));
+		subinfo[i].subparallelapply =
+			pg_strdup(PQgetvalue(res, i, i_subparallelapply));
 
 		/* Decide whether we want to dump it */
 		selectDumpableObject(&(subinfo[i].dobj), fout);
@@ -5188,6 +5214,9 @@ dumpSubscription(Archive *fout, const SubscriptionInfo *subinfo)
 	if (strcmp(subinfo->subfailover, "t") == 0)
 		appendPQExpBufferStr(query, ", failover = true");
 
+	if (strcmp(subinfo->subparallelapply, "t") == 0)
+		appendPQExpBufferStr(query, ", parallel_apply = true");
+
 	if (strcmp(subinfo->subsynccommit, "off") != 0)
 		appendPQExpBuffer(query, ", synchronous_commit = %s", fmtId(subinfo->subsynccommit));
 
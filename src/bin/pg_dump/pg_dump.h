@@ -679,6 +679,7 @@ typedef struct _SubscriptionInfo
 	char	   *suborigin;
 	char	   *suboriginremotelsn;
 	char	   *subfailover;
+	char	   *subparallelapply;
 } SubscriptionInfo;
 
 /*
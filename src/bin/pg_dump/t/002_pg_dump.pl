@@ -2983,6 +2983,17 @@ my %tests = (
 		like => { %full_runs, section_post_data => 1, },
 	},
 
+	'CREATE SUBSCRIPTION sub4' => {
+		create_order => 50,
+		create_sql => 'CREATE SUBSCRIPTION sub4
+						 CONNECTION \'dbname=doesnotexist\' PUBLICATION pub1
+						 WITH (connect = false, parallel_apply = true);',
+		regexp => qr/^
+			\QCREATE SUBSCRIPTION sub4 CONNECTION 'dbname=doesnotexist' PUBLICATION pub1 WITH (connect = false, slot_name = 'sub4', parallel_apply = true);\E
+			/xm,
+		like => { %full_runs, section_post_data => 1, },
+	},
+
 	'ALTER PUBLICATION pub1 ADD TABLE test_table' => {
 		create_order => 51,
 		create_sql =>
@@ -6527,9 +6527,10 @@ describeSubscriptions(const char *pattern, bool verbose)
 	PQExpBufferData buf;
 	PGresult   *res;
 	printQueryOpt myopt = pset.popt;
+	bool		has_parallelapply = false;
 	static const bool translate_columns[] = {false, false, false, false,
 		false, false, false, false, false, false, false, false, false, false,
-	false};
+	false, false};
 
 	if (pset.sversion < 100000)
 	{
@@ -6541,6 +6542,21 @@ describeSubscriptions(const char *pattern, bool verbose)
 		return true;
 	}
 
+	/*
+	 * subparallelapply is not present in every v17 server, so check for the
+	 * column rather than rely on the version.
+	 */
+	if (verbose && pset.sversion >= 170000)
+	{
+		res = PSQLexec("SELECT 1 FROM pg_catalog.pg_attribute\n"
+					   "WHERE attrelid = 'pg_catalog.pg_subscription'::pg_catalog.regclass\n"
+					   "  AND attname = 'subparallelapply' AND NOT attisdropped;");
+		if (!res)
+			return false;
+		has_parallelapply = (PQntuples(res) > 0);
+		PQclear(res);
+	}
+
 	initPQExpBuffer(&buf);
 
 	printfPQExpBuffer(&buf,
@@ -6598,6 +6614,11 @@ describeSubscriptions(const char *pattern, bool verbose)
 							  ", subfailover AS \"%s\"\n",
 							  gettext_noop("Failover"));
 
+		if (has_parallelapply)
+			appendPQExpBuffer(&buf,
+							  ", subparallelapply AS \"%s\"\n",
+							  gettext_noop("Parallel apply"));
+
 		appendPQExpBuffer(&buf,
 						  ",  subsynccommit AS \"%s\"\n"
 						  ",  subconninfo AS \"%s\"\n",
@@ -194,6 +194,10 @@ typedef void (*ammarkpos_function) (IndexScanDesc scan);
 /* restore marked scan position */
 typedef void (*amrestrpos_function) (IndexScanDesc scan);
 
+/* report a TID that the scan will return later, for prefetching */
+typedef bool (*amgetprefetchtid_function) (IndexScanDesc scan,
+										   ItemPointer tid);
+
 /*
  * Callback function signatures - for parallel index scans.
  */
@@ -288,6 +292,7 @@ typedef struct IndexAmRoutine
 	amendscan_function amendscan;
 	ammarkpos_function ammarkpos;	/* can be NULL */
 	amrestrpos_function amrestrpos; /* can be NULL */
+	amgetprefetchtid_function amgetprefetchtid; /* can be NULL */
 
 	/* interface functions to support parallel index scans */
 	amestimateparallelscan_function amestimateparallelscan; /* can be NULL */
@@ -0,0 +1,45 @@
+/*
+ * csnlog.h
+ *
+ * Commit sequence number log, for csn_snapshots.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/access/csnlog.h
+ */
+#ifndef CSNLOG_H
+#define CSNLOG_H
+
+#include "access/transam.h"
+
+/*
+ * Special commit sequence numbers.  Real CSNs, assigned to transactions as
+ * they commit, start at FirstNormalCommitSeqNo.
+ */
+#define InvalidCommitSeqNo			((CommitSeqNo) 0)	/* not committed */
+#define FrozenCommitSeqNo			((CommitSeqNo) 1)	/* committed before startup */
+#define CommittingCommitSeqNo		((CommitSeqNo) 2)	/* commit in progress */
+#define FirstNormalCommitSeqNo		((CommitSeqNo) 3)
+
+/* GUC */
+extern PGDLLIMPORT bool csn_snapshots;
+
+extern void CSNLogSetCommitTree(TransactionId xid, int nsubxids,
+								TransactionId *subxids);
+extern bool CSNLogXidInSnapshot(TransactionId xid, CommitSeqNo snapshotCsn);
+
+extern bool CSNLogIsActive(void);
+extern CommitSeqNo CSNLogGetNextCSN(void);
+extern FullTransactionId CSNLogGetNextXid(void);
+extern void CSNLogSetNextXid(FullTransactionId nextXid);
+extern TransactionId CSNLogGetSnapshotXmin(bool refresh);
+
+extern Size CSNLogShmemSize(void);
+extern void CSNLogShmemInit(void);
+extern void StartupCSNLog(TransactionId oldestActiveXID);
+extern void CheckPointCSNLog(void);
+extern void ExtendCSNLog(TransactionId newestXact);
+extern void TruncateCSNLog(TransactionId oldestXact);
+
+#endif							/* CSNLOG_H */
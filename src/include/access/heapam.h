@@ -96,7 +96,8 @@ typedef struct HeapScanDescData
 	 * optimization. Bitmap scans needing no fields from the heap may skip
 	 * fetching an all visible block, instead using the number of tuples per
 	 * block reported by the bitmap to determine how many NULL-filled tuples
-	 * to return.
+	 * to return.  Skipped blocks are never handed out by the read stream, so
+	 * the NULL-filled tuples are returned once the stream is exhausted.
 	 */
 	Buffer		rs_vmbuffer;
 	int			rs_empty_tuples_pending;
@@ -117,6 +118,15 @@ typedef struct IndexFetchHeapData
 
 	Buffer		xs_cbuf;		/* current heap buffer in scan, if any */
 	/* NB: if xs_cbuf is not InvalidBuffer, we hold a pin on that buffer */
+
+	/*
+	 * Read stream fed by xs_base.prefetch_next, if the index AM supports it.
+	 * It's only started once the scan has moved on from its first heap
+	 * block, so that single-block lookups don't pay for it.
+	 */
+	ReadStream *xs_read_stream;
+	int			xs_nblocks;		/* heap blocks visited since last reset */
+	BlockNumber xs_prefetch_block;	/* last block handed to the stream */
 } IndexFetchHeapData;
 
 /* Result codes for HeapTupleSatisfiesVacuum */
@@ -401,6 +411,10 @@ extern void log_heap_prune_and_freeze(Relation relation, Buffer buffer,
 struct VacuumParams;
 extern void heap_vacuum_rel(Relation rel,
 							struct VacuumParams *params, BufferAccessStrategy bstrategy);
+struct ParallelVacuumState;
+extern void heap_vacuum_parallel_scan_worker(Relation rel,
+											 struct ParallelVacuumState *pvs,
+											 BufferAccessStrategy bstrategy);
 
 /* in heap/heapam_visibility.c */
 extern bool HeapTupleSatisfiesVisibility(HeapTuple htup, Snapshot snapshot,
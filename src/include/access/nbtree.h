@@ -1073,6 +1073,15 @@ typedef struct BTScanOpaqueData
 	 */
 	int			markItemIndex;	/* itemIndex, or -1 if not valid */
 
+	/*
+	 * State for btgetprefetchtid().  prefetchItem is the next currPos item
+	 * to report, valid only if prefetchValid is set.  It's invalidated
+	 * whenever currPos is repositioned, or the scan changes direction.
+	 */
+	bool		prefetchValid;
+	int			prefetchItem;
+	ScanDirection prefetchDir;	/* direction of the last btgettuple call */
+
 	/* keep these last in struct for efficiency */
 	BTScanPosData currPos;		/* current position data */
 	BTScanPosData markPos;		/* marked position, if any */
@@ -1179,6 +1188,7 @@ extern void btparallelrescan(IndexScanDesc scan);
 extern void btendscan(IndexScanDesc scan);
 extern void btmarkpos(IndexScanDesc scan);
 extern void btrestrpos(IndexScanDesc scan);
+extern bool btgetprefetchtid(IndexScanDesc scan, ItemPointer tid);
 extern IndexBulkDeleteResult *btbulkdelete(IndexVacuumInfo *info,
 										   IndexBulkDeleteResult *stats,
 										   IndexBulkDeleteCallback callback,
@@ -23,6 +23,8 @@
 
 
 struct ParallelTableScanDescData;
+struct TBMIterator;
+struct TBMSharedIterator;
 
 /*
  * Generic descriptor for table scans. This is the base-class for table scans,
@@ -48,6 +50,14 @@ typedef struct TableScanDescData
 
 	struct ParallelTableScanDescData *rs_parallel;	/* parallel scan
 													 * information */
+
+	/*
+	 * Iterators for bitmap table scans, set up by the executor after
+	 * table_beginscan_bm() and consumed by the table AM.  At most one of them
+	 * is set, depending on whether the scan is parallel.
+	 */
+	struct TBMIterator *rs_tbmiterator;
+	struct TBMSharedIterator *rs_shared_tbmiterator;
 } TableScanDescData;
 typedef struct TableScanDescData *TableScanDesc;
 
@@ -104,6 +114,15 @@ typedef struct ParallelBlockTableScanWorkerData *ParallelBlockTableScanWorker;
 typedef struct IndexFetchTableData
 {
 	Relation	rel;
+
+	/*
+	 * Optional callback that reports the TIDs the index scan is going to ask
+	 * for next, in order, so that the table AM can read ahead.  It returns
+	 * false when no further TIDs are known yet.  Set by the index AM layer
+	 * only; table AMs are free to ignore it.
+	 */
+	bool		(*prefetch_next) (void *arg, ItemPointer tid);
+	void	   *prefetch_arg;
 } IndexFetchTableData;
 
 /*
@@ -83,6 +83,8 @@ typedef struct TupleDescData
 	int32		tdtypmod;		/* typmod for tuple type */
 	int			tdrefcount;		/* reference count, or -1 if not counting */
 	TupleConstr *constr;		/* constraints, or NULL if none */
+	int			tdfixedprefix;	/* number of leading fixed-width attributes,
+								 * or -1 if not computed yet */
 	/* attrs[N] is the description of Attribute Number N+1 */
 	FormData_pg_attribute attrs[FLEXIBLE_ARRAY_MEMBER];
 }			TupleDescData;
@@ -125,6 +127,21 @@ extern void DecrTupleDescRefCount(TupleDesc tupdesc);
 			DecrTupleDescRefCount(tupdesc); \
 	} while (0)
 
+extern int	TupleDescComputeFixedPrefix(TupleDesc tupdesc);
+
+/*
+ * Return the number of leading attributes that have a fixed width.  Their
+ * attcacheoff is set, so in a tuple where none of them is null they can be
+ * fetched without walking the preceding attributes.
+ */
+static inline int
+TupleDescFixedPrefix(TupleDesc tupdesc)
+{
+	if (tupdesc->tdfixedprefix < 0)
+		return TupleDescComputeFixedPrefix(tupdesc);
+	return tupdesc->tdfixedprefix;
+}
+
 extern bool equalTupleDescs(TupleDesc tupdesc1, TupleDesc tupdesc2);
 extern bool equalRowTypes(TupleDesc tupdesc1, TupleDesc tupdesc2);
 extern uint32 hashRowType(TupleDesc desc);
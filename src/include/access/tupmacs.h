@@ -15,6 +15,7 @@
 #define TUPMACS_H
 
 #include "catalog/pg_type_d.h"	/* for TYPALIGN macros */
+#include "port/pg_bswap.h"
 
 
 /*
@@ -28,6 +29,42 @@ att_isnull(int ATT, const bits8 *BITS)
 	return !(BITS[ATT >> 3] & (1 << (ATT & 0x07)));
 }
 
+/*
+ * Expand the null bitmap entries for attributes start .. end-1 into the
+ * isnull array, one bool per attribute.  Whole bitmap bytes are expanded
+ * eight attributes at a time, by spreading the bits of the byte out over the
+ * bytes of a uint64.
+ */
+static inline void
+populate_isnull_array(const bits8 *BITS, int start, int end, bool *isnull)
+{
+	int			attnum = start;
+
+	for (; attnum < end && (attnum & 0x07) != 0; attnum++)
+		isnull[attnum] = att_isnull(attnum, BITS);
+
+	for (; attnum + 8 <= end; attnum += 8)
+	{
+		uint64		spread;
+
+		/* byte i gets bit i of the bitmap byte, in place */
+		spread = ((uint64) BITS[attnum >> 3] * UINT64CONST(0x0101010101010101)) &
+			UINT64CONST(0x8040201008040201);
+		/* turn each nonzero byte into 1 */
+		spread = ((spread + UINT64CONST(0x7F7F7F7F7F7F7F7F)) >> 7) &
+			UINT64CONST(0x0101010101010101);
+		/* a set bit means not null */
+		spread ^= UINT64CONST(0x0101010101010101);
+#ifdef WORDS_BIGENDIAN
+		spread = pg_bswap64(spread);
+#endif
+		memcpy(&isnull[attnum], &spread, sizeof(uint64));
+	}
+
+	for (; attnum < end; attnum++)
+		isnull[attnum] = att_isnull(attnum, BITS);
+}
+
 #ifndef FRONTEND
 /*
  * Given a Form_pg_attribute and a pointer into a tuple's data area,
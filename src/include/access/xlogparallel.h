@@ -0,0 +1,29 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogparallel.h
+ *		Declarations for applying WAL records in parallel during recovery.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *		src/include/access/xlogparallel.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef XLOGPARALLEL_H
+#define XLOGPARALLEL_H
+
+#include "access/xlogreader.h"
+
+/* GUCs */
+extern PGDLLIMPORT int recovery_parallel_workers;
+
+extern bool ParallelRedoDispatch(XLogReaderState *record);
+extern void ParallelRedoWaitForWorkers(void);
+extern void ParallelRedoReleaseFiles(void);
+extern void ParallelRedoShutdown(void);
+
+extern void ParallelRedoWorkerMain(Datum main_arg);
+
+#endif
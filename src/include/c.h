@@ -311,6 +311,18 @@
 #define unlikely(x) ((x) != 0)
 #endif
 
+/*
+ * Hint to the CPU that the memory at the given address will be read soon,
+ * so that the cache miss can overlap with other work.  This should only be
+ * used where the address is known well before the access, such as when
+ * processing a batch of probes into a large hash table.
+ */
+#if defined(__GNUC__) || defined(__INTEL_COMPILER)
+#define pg_prefetch_mem(a) __builtin_prefetch(a)
+#else
+#define pg_prefetch_mem(a) ((void) 0)
+#endif
+
 /*
  * CppAsString
  *		Convert the argument to a string, using the C preprocessor.
@@ -668,6 +680,8 @@ typedef uint32 CommandId;
 #define FirstCommandId	((CommandId) 0)
 #define InvalidCommandId	(~(CommandId)0)
 
+typedef uint64 CommitSeqNo;
+
 
 /* ----------------
  *		Variable-length datatypes all share the 'struct varlena' header.
@@ -14,6 +14,7 @@
 #ifndef COPY_H
 #define COPY_H
 
+#include "access/parallel.h"
 #include "nodes/execnodes.h"
 #include "nodes/parsenodes.h"
 #include "parser/parse_node.h"
@@ -60,6 +61,7 @@ typedef struct CopyFormatOptions
 	int			file_encoding;	/* file or remote side's character encoding,
 								 * -1 if not specified */
 	bool		binary;			/* binary format? */
+	bool		arrow;			/* Arrow format? (implies binary) */
 	bool		freeze;			/* freeze rows on loading? */
 	bool		csv_mode;		/* Comma Separated Value format? */
 	CopyHeaderChoice header_line;	/* header line? */
@@ -83,6 +85,7 @@ typedef struct CopyFormatOptions
 	bool		convert_selectively;	/* do selective binary conversion? */
 	CopyOnErrorChoice on_error; /* what to do when error happened */
 	CopyLogVerbosityChoice log_verbosity;	/* verbosity of logged messages */
+	int			nworkers;		/* number of parallel workers requested */
 	List	   *convert_select; /* list of column names (can be NIL) */
 } CopyFormatOptions;
 
@@ -111,6 +114,10 @@ extern char *CopyLimitPrintoutLength(const char *str);
 
 extern uint64 CopyFrom(CopyFromState cstate);
 
+extern uint64 ParallelCopyFrom(CopyFromState cstate, List *attnamelist,
+							   List *options);
+extern void ParallelCopyMain(dsm_segment *seg, shm_toc *toc);
+
 extern DestReceiver *CreateCopyDestReceiver(void);
 
 /*
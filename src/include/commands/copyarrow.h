@@ -0,0 +1,37 @@
+/*-------------------------------------------------------------------------
+ *
+ * copyarrow.h
+ *	  Arrow IPC format for COPY TO and COPY FROM.
+ *
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/commands/copyarrow.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef COPYARROW_H
+#define COPYARROW_H
+
+#include "commands/copy.h"
+#include "executor/tuptable.h"
+#include "lib/stringinfo.h"
+
+/* Private in commands/copyarrow.c */
+typedef struct ArrowWriteState ArrowWriteState;
+typedef struct ArrowReadState ArrowReadState;
+
+/* COPY TO */
+extern ArrowWriteState *ArrowWriteBegin(TupleDesc tupDesc, List *attnumlist,
+										FmgrInfo *out_functions);
+extern void ArrowWriteSchema(ArrowWriteState *state, StringInfo buf);
+extern bool ArrowWriteRow(ArrowWriteState *state, TupleTableSlot *slot);
+extern void ArrowWriteBatch(ArrowWriteState *state, StringInfo buf);
+extern void ArrowWriteEnd(ArrowWriteState *state, StringInfo buf);
+
+/* COPY FROM */
+extern void ArrowReadBegin(CopyFromState cstate);
+extern bool ArrowReadRow(CopyFromState cstate, Datum *values, bool *nulls);
+
+#endif							/* COPYARROW_H */
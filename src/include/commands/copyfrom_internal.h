@@ -178,9 +178,14 @@ typedef struct CopyFromStateData
 #define RAW_BUF_BYTES(cstate) ((cstate)->raw_buf_len - (cstate)->raw_buf_index)
 
 	uint64		bytes_processed;	/* number of bytes processed so far */
+
+	struct ArrowReadState *arrow_state;	/* state of Arrow format input */
 } CopyFromStateData;
 
 extern void ReceiveCopyBegin(CopyFromState cstate);
+extern int	CopyGetData(CopyFromState cstate, void *databuf,
+						int minread, int maxread);
+extern int	CopyReadBinaryData(CopyFromState cstate, char *dest, int nbytes);
 extern void ReceiveCopyBinaryHeader(CopyFromState cstate);
 
 #endif							/* COPYFROM_INTERNAL_H */
@@ -56,6 +56,7 @@ extern void DropPreparedStatement(const char *stmt_name, bool showError);
 extern TupleDesc FetchPreparedStatementResultDesc(PreparedStatement *stmt);
 extern List *FetchPreparedStatementTargetList(PreparedStatement *stmt);
 
+extern bool PreparedStatementsExist(void);
 extern void DropAllPreparedStatements(void);
 
 #endif							/* PREPARE_H */
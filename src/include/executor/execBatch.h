@@ -0,0 +1,96 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatch.h
+ *	  Support for processing tuples a batch at a time
+ *
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/executor/execBatch.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXECBATCH_H
+#define EXECBATCH_H
+
+#include "access/tupdesc.h"
+#include "fmgr.h"
+#include "nodes/pg_list.h"
+
+/* GUC */
+extern PGDLLIMPORT int executor_batch_size;
+
+/*
+ * Comparisons on integer-like types that are evaluated inline rather than by
+ * calling the operator's function.
+ */
+typedef enum BatchCmpType
+{
+	BATCH_CMP_NONE,				/* call the function */
+	BATCH_CMP_INT16,
+	BATCH_CMP_INT32,
+	BATCH_CMP_INT64,
+} BatchCmpType;
+
+typedef enum BatchCmpOp
+{
+	BATCH_CMP_LT,
+	BATCH_CMP_LE,
+	BATCH_CMP_EQ,
+	BATCH_CMP_NE,
+	BATCH_CMP_GE,
+	BATCH_CMP_GT,
+} BatchCmpOp;
+
+/*
+ * A simple "Var op Const" qual clause, evaluated over a whole batch.  For
+ * inline comparisons the operator is normalized so that the Var is on the
+ * left.
+ */
+typedef struct BatchQualClause
+{
+	int			col;			/* batch column the Var refers to */
+	BatchCmpType cmptype;
+	BatchCmpOp	cmpop;
+	Datum		constval;		/* the Const, for inline comparisons */
+	FunctionCallInfo fcinfo;	/* for other operators */
+	int			vararg;			/* argument position of the Var in fcinfo */
+} BatchQualClause;
+
+/*
+ * A batch of up to maxrows tuples, stored column-wise.
+ *
+ * Only pass-by-value columns are stored, so the values don't point into
+ * buffer pages or tuples that may go away while the batch is in use.  After
+ * the scan's qual has been applied, the rows that passed are listed in the
+ * selection vector.
+ */
+typedef struct TupleBatch
+{
+	int			maxrows;		/* capacity of each vector */
+	int			nrows;			/* number of rows in the vectors */
+
+	int			ncols;			/* number of columns stored */
+	AttrNumber *attnums;		/* table attribute number of each column */
+	AttrNumber	maxattnum;		/* highest attribute number stored */
+	Datum	  **values;			/* values[col][row] */
+	bool	  **isnull;			/* isnull[col][row] */
+
+	int			nselected;		/* number of rows that passed the qual */
+	int		   *selection;		/* their row numbers, in ascending order */
+
+	int			nclauses;		/* vectorized qual clauses, ANDed together */
+	BatchQualClause *clauses;
+
+	bool		done;			/* underlying scan is exhausted */
+} TupleBatch;
+
+extern TupleBatch *ExecBatchCreate(TupleDesc tupdesc, int maxrows);
+extern int	ExecBatchAddColumn(TupleBatch *batch, TupleDesc tupdesc,
+							   AttrNumber attnum);
+extern bool ExecBatchBuildQual(TupleBatch *batch, TupleDesc tupdesc,
+							   List *qual, Index scanrelid);
+extern void ExecBatchQual(TupleBatch *batch);
+
+#endif							/* EXECBATCH_H */
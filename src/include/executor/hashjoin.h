@@ -313,6 +313,14 @@ typedef struct HashJoinTableData
 		dsa_pointer_atomic *shared;
 	}			buckets;
 
+	/*
+	 * Once a batch of a private hash table is loaded, the bucket chains may
+	 * be replaced by an open-addressing table; see ExecHashTableBuildSlots.
+	 */
+	int			nslots;			/* # slots, or 0 if using bucket chains */
+	uint8	   *slot_tags;		/* fingerprints of the slots' hash values */
+	HashJoinTuple *slots;		/* tuple of each slot, or NULL */
+
 	bool		keepNulls;		/* true to store unmatchable NULL tuples */
 
 	bool		skewEnabled;	/* are we using skew optimization? */
@@ -18,6 +18,26 @@
 #include "nodes/execnodes.h"
 
 
+/*
+ * How a transition state is advanced over a batch of input rows.  Some
+ * common transition functions are open-coded; everything else calls the
+ * transition function for each row.
+ */
+typedef enum AggBatchTrans
+{
+	AGG_BATCH_CALL,				/* call the transition function */
+	AGG_BATCH_COUNT_STAR,		/* int8inc */
+	AGG_BATCH_COUNT,			/* int8inc_any */
+	AGG_BATCH_SUM_INT16,		/* int2_sum */
+	AGG_BATCH_SUM_INT32,		/* int4_sum */
+	AGG_BATCH_MIN_INT16,		/* int2smaller */
+	AGG_BATCH_MAX_INT16,		/* int2larger */
+	AGG_BATCH_MIN_INT32,		/* int4smaller */
+	AGG_BATCH_MAX_INT32,		/* int4larger */
+	AGG_BATCH_MIN_INT64,		/* int8smaller */
+	AGG_BATCH_MAX_INT64,		/* int8larger */
+} AggBatchTrans;
+
 /*
  * AggStatePerTransData - per aggregate state value information
  *
@@ -173,6 +193,13 @@ typedef struct AggStatePerTransData
 	FunctionCallInfo serialfn_fcinfo;
 
 	FunctionCallInfo deserialfn_fcinfo;
+
+	/*
+	 * When the input arrives in batches, how the transition state is
+	 * advanced, and the batch column holding the argument (-1 if none).
+	 */
+	AggBatchTrans batchtrans;
+	int			batchcol;
 }			AggStatePerTransData;
 
 /*
@@ -332,9 +359,10 @@ extern void hash_agg_set_limits(double hashentrysize, double input_groups,
 								int used_bits, Size *mem_limit,
 								uint64 *ngroups_limit, int *num_partitions);
 
-/* parallel instrumentation support */
+/* parallel hashing and instrumentation support */
 extern void ExecAggEstimate(AggState *node, ParallelContext *pcxt);
 extern void ExecAggInitializeDSM(AggState *node, ParallelContext *pcxt);
+extern void ExecAggReInitializeDSM(AggState *node, ParallelContext *pcxt);
 extern void ExecAggInitializeWorker(AggState *node, ParallelWorkerContext *pwcxt);
 extern void ExecAggRetrieveInstrumentation(AggState *node);
 
@@ -53,6 +53,9 @@ extern void ExecHashGetBucketAndBatch(HashJoinTable hashtable,
 									  uint32 hashvalue,
 									  int *bucketno,
 									  int *batchno);
+extern void ExecHashTableBuildSlots(HashJoinTable hashtable);
+extern void ExecHashPrefetchSlots(HashJoinTable hashtable, uint32 hashvalue);
+extern void ExecHashPrefetchTuple(HashJoinTable hashtable, uint32 hashvalue);
 extern bool ExecScanHashBucket(HashJoinState *hjstate, ExprContext *econtext);
 extern bool ExecParallelScanHashBucket(HashJoinState *hjstate, ExprContext *econtext);
 extern void ExecPrepHashTableForUnmatched(HashJoinState *hjstate);
@@ -1774,11 +1774,7 @@ typedef enum
 /* ----------------
  *	 ParallelBitmapHeapState information
  *		tbmiterator				iterator for scanning current pages
- *		prefetch_iterator		iterator for prefetching ahead of current page
- *		mutex					mutual exclusion for the prefetching variable
- *								and state
- *		prefetch_pages			# pages prefetch iterator is ahead of current
- *		prefetch_target			current target prefetch distance
+ *		mutex					mutual exclusion for the state
  *		state					current state of the TIDBitmap
  *		cv						conditional wait variable
  * ----------------
@@ -1786,10 +1782,7 @@ typedef enum
 typedef struct ParallelBitmapHeapState
 {
 	dsa_pointer tbmiterator;
-	dsa_pointer prefetch_iterator;
 	slock_t		mutex;
-	int			prefetch_pages;
-	int			prefetch_target;
 	SharedBitmapState state;
 	ConditionVariable cv;
 } ParallelBitmapHeapState;
@@ -1799,19 +1792,14 @@ typedef struct ParallelBitmapHeapState
  *
  *		bitmapqualorig	   execution state for bitmapqualorig expressions
  *		tbm				   bitmap obtained from child index scan(s)
- *		tbmiterator		   iterator for scanning current pages
- *		tbmres			   current-page data
- *		pvmbuffer		   buffer for visibility-map lookups of prefetched pages
  *		exact_pages		   total number of exact pages retrieved
  *		lossy_pages		   total number of lossy pages retrieved
- *		prefetch_iterator  iterator for prefetching ahead of current page
- *		prefetch_pages	   # pages prefetch iterator is ahead of current
- *		prefetch_target    current target prefetch distance
- *		prefetch_maximum   maximum value for prefetch_target
  *		initialized		   is node is ready to iterate
- *		shared_tbmiterator	   shared iterator
- *		shared_prefetch_iterator shared iterator for prefetching
+ *		recheck			   do current page's tuples need recheck
  *		pstate			   shared state for parallel bitmap scan
+ *
+ * The iterators over the bitmap live in the table scan descriptor, as the
+ * table AM reads ahead through them.
  * ----------------
  */
 typedef struct BitmapHeapScanState
@@ -1819,18 +1807,10 @@ typedef struct BitmapHeapScanState
 	ScanState	ss;				/* its first field is NodeTag */
 	ExprState  *bitmapqualorig;
 	TIDBitmap  *tbm;
-	TBMIterator *tbmiterator;
-	TBMIterateResult *tbmres;
-	Buffer		pvmbuffer;
-	long		exact_pages;
-	long		lossy_pages;
-	TBMIterator *prefetch_iterator;
-	int			prefetch_pages;
-	int			prefetch_target;
-	int			prefetch_maximum;
+	uint64		exact_pages;
+	uint64		lossy_pages;
 	bool		initialized;
-	TBMSharedIterator *shared_tbmiterator;
-	TBMSharedIterator *shared_prefetch_iterator;
+	bool		recheck;
 	ParallelBitmapHeapState *pstate;
 } BitmapHeapScanState;
 
@@ -2166,7 +2146,9 @@ typedef struct MergeJoinState
  *		hj_HashTable			hash table for the hashjoin
  *								(NULL if table not built yet)
  *		hj_CurHashValue			hash value for current outer tuple
- *		hj_CurBucketNo			regular bucket# for current outer tuple
+ *		hj_CurBucketNo			regular bucket# for current outer tuple, or
+ *								slot# of hj_CurTuple if the hash table
+ *								uses open addressing
  *		hj_CurSkewBucketNo		skew bucket# for current outer tuple
  *		hj_CurTuple				last inner tuple matched to current outer
  *								tuple, or NULL if starting search
@@ -2181,6 +2163,12 @@ typedef struct MergeJoinState
  *		hj_JoinState			current state of ExecHashJoin state machine
  *		hj_MatchedOuter			true if found a join match for current outer
  *		hj_OuterNotEmpty		true if outer relation known not empty
+ *		hj_OuterBufSlots		buffered outer tuples, whose probes have
+ *								been prefetched (NULL if never used)
+ *		hj_OuterBufHashValues	hash values of the buffered outer tuples
+ *		hj_OuterBufCount		number of buffered outer tuples
+ *		hj_OuterBufNext			index of next buffered outer tuple to return
+ *		hj_OuterBufDone			true if no more outer tuples in this batch
  * ----------------
  */
 
@@ -2208,6 +2196,11 @@ typedef struct HashJoinState
 	int			hj_JoinState;
 	bool		hj_MatchedOuter;
 	bool		hj_OuterNotEmpty;
+	TupleTableSlot **hj_OuterBufSlots;
+	uint32	   *hj_OuterBufHashValues;
+	int			hj_OuterBufCount;
+	int			hj_OuterBufNext;
+	bool		hj_OuterBufDone;
 } HashJoinState;
 
 
@@ -2536,6 +2529,13 @@ typedef struct AggState
 	AggStatePerGroup *all_pergroups;	/* array of first ->pergroups, than
 										 * ->hash_pergroup */
 	SharedAggInfo *shared_info; /* one entry per worker */
+	struct TupleBatch *batch;	/* input batch, if the outer SeqScan passes
+								 * tuples in batches */
+
+	/* these fields are used in a parallel-aware AGG_HASHED node: */
+	struct ParallelHashAggState *hash_pstate;	/* shared partitioning state */
+	struct SharedTuplestoreAccessor **hash_sts; /* accessor per partition */
+	bool		hash_shared_done;	/* no more shared partitions to claim? */
 } AggState;
 
 /* ----------------
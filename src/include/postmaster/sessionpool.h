@@ -0,0 +1,57 @@
+/*-------------------------------------------------------------------------
+ *
+ * sessionpool.h
+ *	  Multiplexing client sessions over a pool of backends.
+ *
+ * See sessionpool.c for comments.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/postmaster/sessionpool.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SESSIONPOOL_H
+#define SESSIONPOOL_H
+
+#include "libpq/libpq-be.h"
+#include "storage/latch.h"
+
+/* GUC parameters */
+extern PGDLLIMPORT int max_pooled_sessions;
+extern PGDLLIMPORT int session_pool_size;
+
+extern PGDLLIMPORT bool SessionPoolAdopting;
+
+extern Size SessionPoolShmemSize(void);
+extern void SessionPoolShmemInit(void);
+extern bool SessionPoolLookupCancel(int session_pid, int32 cancel_key,
+									pid_t *backend_pid);
+
+/* Functions called in the postmaster */
+extern void SessionPoolPostmasterInit(void);
+extern int	SessionPoolNumWaitEvents(void);
+extern void SessionPoolAddWaitEvents(WaitEventSet *set);
+extern void SessionPoolHandleEvent(WaitEvent *event);
+extern void SessionPoolSetOpen(bool open);
+extern bool SessionPoolDeferConnection(ClientSocket *client_sock);
+extern bool SessionPoolStartupPending(void);
+extern bool SessionPoolNextStartup(ClientSocket *client_sock, char **session,
+								   size_t *session_len);
+extern void SessionPoolStartupDone(void);
+extern void SessionPoolRetireIdleBackends(void);
+extern void SessionPoolPrepareBackend(void);
+extern void SessionPoolBackendForked(pid_t pid);
+extern void SessionPoolBackendExited(pid_t pid);
+extern void SessionPoolCloseAfterFork(void);
+
+/* Functions called in backends */
+extern void SessionPoolAdoptSession(Port *port, char *data, size_t len);
+extern void SessionPoolInitBackend(void);
+extern bool SessionPoolCanReleaseSession(void);
+extern void SessionPoolReleaseSession(void);
+extern bool SessionPoolCanEndSession(void);
+extern void SessionPoolEndSession(void);
+
+#endif							/* SESSIONPOOL_H */
@@ -20,6 +20,7 @@
 
 /* GUC variables */
 extern PGDLLIMPORT int logical_decoding_work_mem;
+extern PGDLLIMPORT int logical_decoding_spill_compression;
 extern PGDLLIMPORT int debug_logical_replication_streaming;
 
 /* possible values for debug_logical_replication_streaming */
@@ -625,6 +626,17 @@ struct ReorderBuffer
 	char	   *outbuf;
 	Size		outbufsize;
 
+	/*
+	 * Buffers for compressing changes spilled to disk: the changes of the
+	 * block being filled, and the compressed block.
+	 */
+	char	   *spillbuf;
+	Size		spillbufsize;
+	Size		spillbuflen;
+	char	   *compressbuf;
+	Size		compressbufsize;
+	int			spill_compression;	/* method used for the current spill */
+
 	/* memory accounting */
 	Size		size;
 
@@ -641,6 +653,8 @@ struct ReorderBuffer
 	int64		spillTxns;		/* number of transactions spilled to disk */
 	int64		spillCount;		/* spill-to-disk invocation counter */
 	int64		spillBytes;		/* amount of data spilled to disk */
+	int64		spillWrittenBytes;	/* amount of data written to disk, after
+									 * compression */
 
 	/* Statistics about transactions streamed to the decoding output plugin */
 	int64		streamTxns;		/* number of transactions streamed */
@@ -86,6 +86,15 @@ typedef struct LogicalRepWorker
 	/* Indicates whether apply can be performed in parallel. */
 	bool		parallel_apply;
 
+	/*
+	 * Remote end LSN of the last committed transaction that a parallel apply
+	 * worker of this leader apply worker has finished applying.  Committed
+	 * transactions are handed over to parallel apply workers in commit order
+	 * and finished in that order, so this only moves forward.  See
+	 * pa_dispatch_begin().
+	 */
+	pg_atomic_uint64 parallel_commit_lsn;
+
 	/* Stats. */
 	XLogRecPtr	last_lsn;
 	TimestampTz last_send_time;
@@ -168,6 +177,14 @@ typedef struct ParallelApplyWorkerShared
 	 */
 	XLogRecPtr	last_commit_end;
 
+	/*
+	 * For a committed transaction handed over by the leader apply worker, the
+	 * remote xid and end LSN of the transaction that must be committed before
+	 * this one, if any.
+	 */
+	TransactionId prev_xid;
+	XLogRecPtr	prev_end_lsn;
+
 	/*
 	 * After entering PARTIAL_SERIALIZE mode, the leader apply worker will
 	 * serialize changes to the file, and share the fileset with the parallel
@@ -214,6 +231,18 @@ typedef struct ParallelApplyWorkerInfo
 	 */
 	bool		in_use;
 
+	/*
+	 * Sequence number and remote end LSN of the committed transaction handed
+	 * over to the worker, or 0 and InvalidXLogRecPtr if the worker is applying
+	 * a streaming transaction.  The end LSN is only known once the COMMIT has
+	 * been sent.
+	 */
+	uint64		dispatch_seq;
+	XLogRecPtr	dispatch_end_lsn;
+
+	/* Versions of the relation descriptions sent to the worker */
+	HTAB	   *relversions;
+
 	ParallelApplyWorkerShared *shared;
 } ParallelApplyWorkerInfo;
 
@@ -325,6 +354,20 @@ extern void pa_decr_and_wait_stream_block(void);
 extern void pa_xact_finish(ParallelApplyWorkerInfo *winfo,
 						   XLogRecPtr remote_lsn);
 
+extern bool pa_dispatch_begin(LogicalRepBeginData *begin_data, StringInfo s);
+extern void pa_dispatch_change(LogicalRepMsgType action, StringInfo s);
+extern void pa_dispatch_commit(LogicalRepCommitData *commit_data,
+							   StringInfo s);
+extern bool pa_dispatching_xact(void);
+extern bool pa_have_dispatched_xacts(void);
+extern void pa_wait_for_dispatched_xacts(void);
+extern void pa_reap_dispatched_xacts(void);
+extern void pa_relation_changed(LogicalRepRelId relid);
+
+extern void pa_begin_dispatched_xact(void);
+extern void pa_wait_for_preceding_xact(void);
+extern void pa_finish_dispatched_xact(XLogRecPtr end_lsn);
+
 #define isParallelApplyWorker(worker) ((worker)->in_use && \
 									   (worker)->type == WORKERTYPE_PARALLEL_APPLY)
 #define isTablesyncWorker(worker) ((worker)->in_use && \
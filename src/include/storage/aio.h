@@ -0,0 +1,45 @@
+/*-------------------------------------------------------------------------
+ *
+ * aio.h
+ *	  Backend-local asynchronous I/O
+ *
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/storage/aio.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef AIO_H
+#define AIO_H
+
+/* Enum for io_method GUC */
+typedef enum IoMethod
+{
+	IOMETHOD_SYNC = 0,
+	IOMETHOD_IO_URING,
+} IoMethod;
+
+#ifdef HAVE_LINUX_IO_URING_H
+#define USE_IOMETHOD_IO_URING
+#endif
+
+#define DEFAULT_IO_METHOD IOMETHOD_SYNC
+#define DEFAULT_IO_MAX_CONCURRENCY 64
+
+struct PgAioHandle;
+typedef struct PgAioHandle PgAioHandle;
+
+/* GUCs */
+extern PGDLLIMPORT int io_method;
+extern PGDLLIMPORT int io_max_concurrency;
+
+extern PgAioHandle *pgaio_io_acquire(size_t nbytes);
+extern void *pgaio_io_get_buffer(PgAioHandle *ioh);
+extern bool pgaio_io_start_read(PgAioHandle *ioh, int fd, off_t offset,
+								size_t nbytes, uint32 wait_event_info);
+extern ssize_t pgaio_io_wait(PgAioHandle *ioh);
+extern void pgaio_io_release(PgAioHandle *ioh);
+
+#endif							/* AIO_H */
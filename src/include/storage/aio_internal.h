@@ -0,0 +1,83 @@
+/*-------------------------------------------------------------------------
+ *
+ * aio_internal.h
+ *	  Internal definitions shared by the asynchronous I/O implementations
+ *
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/storage/aio_internal.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef AIO_INTERNAL_H
+#define AIO_INTERNAL_H
+
+#include "storage/aio.h"
+#include "utils/resowner.h"
+
+typedef enum PgAioHandleState
+{
+	PGAIO_HS_IDLE = 0,			/* on the free list */
+	PGAIO_HS_ACQUIRED,			/* owned, but no I/O started yet */
+	PGAIO_HS_INFLIGHT,			/* submitted to the kernel */
+	PGAIO_HS_COMPLETED,			/* result available */
+} PgAioHandleState;
+
+struct PgAioHandle
+{
+	PgAioHandleState state;
+
+	/* position in the handle array, used to identify completions */
+	int			index;
+
+	/* resource owner the handle is registered with, while not idle */
+	ResourceOwner resowner;
+
+	/* backend-private memory the kernel reads into */
+	char	   *buffer;
+	size_t		buffer_size;
+
+	/* size of the transfer that has been requested */
+	size_t		nbytes;
+
+	/* wait event to report while waiting for completion */
+	uint32		wait_event_info;
+
+	/* number of bytes transferred, or -errno */
+	ssize_t		result;
+};
+
+/*
+ * Operations each I/O method has to provide.  Methods run entirely within
+ * one backend; nothing is shared with other processes.
+ */
+typedef struct IoMethodOps
+{
+	/*
+	 * Prepare the method for use in this backend, able to have up to
+	 * max_inflight I/Os in progress at once.  Returns false if the method
+	 * can't be used, in which case I/O falls back to being synchronous.
+	 */
+	bool		(*init_backend) (int max_inflight);
+
+	/* Submit a read into ioh->buffer.  Returns false on failure. */
+	bool		(*submit_read) (PgAioHandle *ioh, int fd, off_t offset);
+
+	/*
+	 * Wait until ioh has completed.  Completions of other handles that are
+	 * observed on the way are recorded with pgaio_io_complete().
+	 */
+	void		(*wait_one) (PgAioHandle *ioh);
+} IoMethodOps;
+
+extern PgAioHandle *pgaio_io_from_index(int index);
+extern void pgaio_io_complete(PgAioHandle *ioh, ssize_t result);
+extern void pgaio_method_failed(void);
+
+#ifdef USE_IOMETHOD_IO_URING
+extern PGDLLIMPORT const IoMethodOps pgaio_uring_ops;
+#endif
+
+#endif							/* AIO_INTERNAL_H */
@@ -429,6 +429,12 @@ extern bool StrategyRejectBuffer(BufferAccessStrategy strategy,
 
 extern int	StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc);
 extern void StrategyNotifyBgWriter(int bgwprocno);
+extern int	StrategyNumPartitions(void);
+extern void StrategyGetPartitionStats(int partno, int *first_buffer,
+									  int *num_buffers,
+									  uint32 *complete_passes,
+									  uint32 *next_victim_buffer,
+									  uint64 *buffer_allocs);
 
 extern Size StrategyShmemSize(void);
 extern void StrategyInitialize(bool init);
@@ -111,6 +111,8 @@ typedef struct BufferManagerRelation
 #define READ_BUFFERS_ZERO_ON_ERROR (1 << 0)
 /* Call smgrprefetch() if I/O necessary. */
 #define READ_BUFFERS_ISSUE_ADVICE (1 << 1)
+/* Start the read asynchronously if I/O necessary and io_method allows. */
+#define READ_BUFFERS_ASYNC (1 << 2)
 
 struct ReadBuffersOperation
 {
@@ -135,6 +137,8 @@ struct ReadBuffersOperation
 	int			flags;
 	int16		nblocks;
 	int16		io_buffers_len;
+	struct PgAioHandle *io_handle;	/* asynchronous read, if started */
+	int16		io_handle_nblocks;	/* number of blocks it covers */
 };
 
 typedef struct ReadBuffersOperation ReadBuffersOperation;
@@ -145,6 +149,9 @@ struct WritebackContext;
 /* forward declared, to avoid including smgr.h here */
 struct SMgrRelationData;
 
+/* forward declared, to avoid including aio.h here */
+struct PgAioHandle;
+
 /* in globals.c ... this duplicates miscadmin.h */
 extern PGDLLIMPORT int NBuffers;
 
@@ -173,6 +180,9 @@ extern PGDLLIMPORT int checkpoint_flush_after;
 extern PGDLLIMPORT int backend_flush_after;
 extern PGDLLIMPORT int bgwriter_flush_after;
 
+/* in freelist.c */
+extern PGDLLIMPORT int clock_sweep_partitions;
+
 /* in buf_init.c */
 extern PGDLLIMPORT char *BufferBlocks;
 
@@ -50,6 +50,9 @@
 
 typedef int File;
 
+/* forward declared, to avoid including aio.h here */
+struct PgAioHandle;
+
 
 #define IO_DIRECT_DATA			0x01
 #define IO_DIRECT_WAL			0x02
@@ -107,6 +110,7 @@ extern File PathNameOpenFilePerm(const char *fileName, int fileFlags, mode_t fil
 extern File OpenTemporaryFile(bool interXact);
 extern void FileClose(File file);
 extern int	FilePrefetch(File file, off_t offset, off_t amount, uint32 wait_event_info);
+extern int	FileStartRead(struct PgAioHandle *ioh, File file, off_t offset, size_t amount, uint32 wait_event_info);
 extern ssize_t FileReadV(File file, const struct iovec *iov, int iovcnt, off_t offset, uint32 wait_event_info);
 extern ssize_t FileWriteV(File file, const struct iovec *iov, int iovcnt, off_t offset, uint32 wait_event_info);
 extern int	FileSync(File file, uint32 wait_event_info);
@@ -73,6 +73,9 @@ typedef SMgrRelationData *SMgrRelation;
 #define SmgrIsTemp(smgr) \
 	RelFileLocatorBackendIsTemp((smgr)->smgr_rlocator)
 
+/* forward declared, to avoid including aio.h here */
+struct PgAioHandle;
+
 extern void smgrinit(void);
 extern SMgrRelation smgropen(RelFileLocator rlocator, ProcNumber backend);
 extern bool smgrexists(SMgrRelation reln, ForkNumber forknum);
@@ -81,6 +84,7 @@ extern void smgrunpin(SMgrRelation reln);
 extern void smgrclose(SMgrRelation reln);
 extern void smgrdestroyall(void);
 extern void smgrrelease(SMgrRelation reln);
+extern void smgrresetnblocks(SMgrRelation reln);
 extern void smgrreleaseall(void);
 extern void smgrreleaserellocator(RelFileLocatorBackend rlocator);
 extern void smgrcreate(SMgrRelation reln, ForkNumber forknum, bool isRedo);
@@ -92,6 +96,9 @@ extern void smgrzeroextend(SMgrRelation reln, ForkNumber forknum,
 						   BlockNumber blocknum, int nblocks, bool skipFsync);
 extern bool smgrprefetch(SMgrRelation reln, ForkNumber forknum,
 						 BlockNumber blocknum, int nblocks);
+extern int	smgrstartreadv(SMgrRelation reln, ForkNumber forknum,
+						   BlockNumber blocknum, int nblocks,
+						   struct PgAioHandle *ioh);
 extern void smgrreadv(SMgrRelation reln, ForkNumber forknum,
 					  BlockNumber blocknum,
 					  void **buffers, BlockNumber nblocks);
@@ -34,6 +34,10 @@ typedef enum CAC_state
 typedef struct BackendStartupData
 {
 	CAC_state	canAcceptConnections;
+
+	/* session to take over from the session pool; see sessionpool.c */
+	size_t		pooled_session_len;
+	char		pooled_session[FLEXIBLE_ARRAY_MEMBER];
 } BackendStartupData;
 
 extern void BackendMain(char *startup_data, size_t startup_data_len) pg_attribute_noreturn();
@@ -0,0 +1,47 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedcatcache.h
+ *	  Shared-memory tier below the backend-local catalog caches.
+ *
+ * See sharedcatcache.c for comments.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/utils/sharedcatcache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SHAREDCATCACHE_H
+#define SHAREDCATCACHE_H
+
+#include "access/htup.h"
+#include "utils/catcache.h"
+
+/* GUC parameter */
+extern PGDLLIMPORT int shared_catcache_size;
+
+/*
+ * Invalidation counters read before loading a tuple from the catalog, to be
+ * passed to SharedCatCacheStore().
+ */
+typedef struct SharedCatCacheLoad
+{
+	uint64		generation;		/* counter of the tuple's bucket */
+	uint64		global_generation;
+} SharedCatCacheLoad;
+
+extern Size SharedCatCacheShmemSize(void);
+extern void SharedCatCacheShmemInit(void);
+
+extern bool SharedCatCacheUsable(CatCache *cache);
+extern HeapTuple SharedCatCacheLookup(CatCache *cache, uint32 hashValue);
+extern void SharedCatCacheBeginLoad(CatCache *cache, uint32 hashValue,
+									SharedCatCacheLoad *load);
+extern void SharedCatCacheStore(CatCache *cache, uint32 hashValue,
+								SharedCatCacheLoad *load, HeapTuple tuple);
+
+extern void SharedCatCacheInvalidate(int cacheid, uint32 hashValue);
+extern void SharedCatCacheInvalidateAll(void);
+
+#endif							/* SHAREDCATCACHE_H */
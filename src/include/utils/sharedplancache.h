@@ -0,0 +1,63 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedplancache.h
+ *	  Cross-backend cache of generic plans for saved statements.
+ *
+ * See sharedplancache.c for comments.
+ *
+ * Portions Copyright (c) 1996-2024, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/utils/sharedplancache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SHAREDPLANCACHE_H
+#define SHAREDPLANCACHE_H
+
+#include "nodes/pg_list.h"
+#include "utils/plancache.h"
+
+/* GUC parameter */
+extern PGDLLIMPORT int shared_plan_cache_size;
+
+/*
+ * Key identifying a generic plan in the shared plan cache.  Besides the
+ * query text, it covers everything else that the plan can depend on without
+ * that being visible in the plan's dependency lists: the database, the role,
+ * the search_path, the parameter types and the planner settings.
+ */
+typedef struct SharedPlanCacheKey
+{
+	Oid			dbid;
+	Oid			userid;
+	uint64		query_hash;		/* hash of the query text */
+	uint64		env_hash;		/* hash of everything else */
+} SharedPlanCacheKey;
+
+/*
+ * State passed from SharedPlanCacheLookup() to SharedPlanCacheRecheck() when
+ * the lookup found a plan, or to SharedPlanCacheStore() when it didn't.
+ */
+typedef struct SharedPlanCacheProbe
+{
+	SharedPlanCacheKey key;
+	uint64	   *generations;	/* invalidation counters before planning */
+	struct SharedPlanData *adopted; /* dependencies of the plan found */
+} SharedPlanCacheProbe;
+
+extern Size SharedPlanCacheShmemSize(void);
+extern void SharedPlanCacheShmemInit(void);
+
+extern List *SharedPlanCacheLookup(CachedPlanSource *plansource,
+								   SharedPlanCacheProbe *probe);
+extern bool SharedPlanCacheRecheck(SharedPlanCacheProbe *probe);
+extern void SharedPlanCacheStore(CachedPlanSource *plansource,
+								 SharedPlanCacheProbe *probe,
+								 List *stmt_list);
+
+extern void SharedPlanCacheInvalidateRel(Oid relid);
+extern void SharedPlanCacheInvalidateObject(int cacheid, uint32 hashvalue);
+extern void SharedPlanCacheInvalidateAll(void);
+
+#endif							/* SHAREDPLANCACHE_H */
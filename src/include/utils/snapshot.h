@@ -181,6 +181,14 @@ typedef struct SnapshotData
 	int32		subxcnt;		/* # of xact ids in subxip[] */
 	bool		suboverflowed;	/* has the subxip array overflowed? */
 
+	/*
+	 * For MVCC snapshots taken with csn_snapshots, xip and subxip are empty.
+	 * Instead, XIDs between xmin and xmax are considered in progress unless
+	 * they committed with a commit sequence number smaller than this.
+	 * InvalidCommitSeqNo otherwise.
+	 */
+	CommitSeqNo snapshotCsn;
+
 	bool		takenDuringRecovery;	/* recovery-shaped snapshot? */
 	bool		copied;			/* false if it's a static snapshot */
 
@@ -0,0 +1,31 @@
+CREATE EXTENSION test_copy_parse;
+
+--
+-- Lines and fields longer than a vector, with special characters at
+-- varying offsets.  Tabs, newlines and backslashes in the values are
+-- shown as T, N and B.
+--
+CREATE TABLE copy_parse (id int, a text, b text);
+COPY copy_parse FROM STDIN;
+1	abcdefghijklmnopqrstuvwxyz0123456789abcd	abcdefghijklmnop
+2	abcdefghijklmno\tpqrstuvwxyz0123456789abcd	abcdefghijklmnop\\qrstuvwxyz0123456
+3	abcdefghijklmnop\nqrstuvwxyz0123456789abcd	\\abcdefghijklmnopqrst
+4	abcdefghijklmnopq\\rstuvwxyz01234\t56789abcdefghijklmn	abcdefghijklmnopqrstuvwxyz012345
+5	abcdefghijklmnopqrstuvwxyz0123456789abcdefghijk\nl	
+\.
+COPY copy_parse FROM STDIN (FORMAT csv);
+6,"abcdefghijklmno,pqrstuvwxyz0123456789abcd","abcdefghijklmnopqrstuvwxyz01234""56789abcd"
+7,"abcdefghijklmnop
+qrstuvwxyz0123456789abcd","abcdefghijklmnopq""""rstuvwxyz01234,56789abcd"
+8,abcdefghijklmnopqrstuvwxyz0123456789abcdefghijk\,abcdefghijklmnopqrstuvwxyz012345\6789abcd
+\.
+SELECT id, translate(a, E'\t\n\\', 'TNB') AS a,
+       translate(b, E'\t\n\\', 'TNB') AS b
+  FROM copy_parse ORDER BY id;
+
+-- The benchmark function just has to run.
+CREATE TABLE copy_parse_wide (c1 text, c2 text, c3 text, c4 text,
+                              c5 text, c6 text, c7 text, c8 text);
+SELECT test_copy_parse_bench('copy_parse_wide', 'text', 1000, 50) >= 0 AS ok;
+SELECT test_copy_parse_bench('copy_parse_wide', 'csv', 1000, 50) >= 0 AS ok;
+SELECT test_copy_parse_bench('copy_parse_wide', 'binary', 10, 10);
@@ -0,0 +1,9 @@
+/* src/test/modules/test_copy_parse/test_copy_parse--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_copy_parse" to load this file. \quit
+
+CREATE FUNCTION test_copy_parse_bench(rel regclass, format text,
+                                      nrows int4, width int4)
+RETURNS pg_catalog.float8 STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
@@ -0,0 +1,171 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_copy_parse.c
+ *		Micro-benchmark for parsing COPY FROM input.
+ *
+ * Copyright (c) 2024, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_copy_parse/test_copy_parse.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/table.h"
+#include "commands/copy.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "portability/instr_time.h"
+#include "utils/builtins.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(test_copy_parse_bench);
+
+/* State of the data source callback, which repeats one row */
+static StringInfoData bench_row;
+static int64 bench_rows_left;
+static int	bench_row_pos;
+
+static int
+bench_read_data(void *outbuf, int minread, int maxread)
+{
+	int			nbytes = 0;
+
+	while (nbytes < maxread && bench_rows_left > 0)
+	{
+		int			n = Min(maxread - nbytes, bench_row.len - bench_row_pos);
+
+		memcpy((char *) outbuf + nbytes, bench_row.data + bench_row_pos, n);
+		nbytes += n;
+		bench_row_pos += n;
+		if (bench_row_pos == bench_row.len)
+		{
+			bench_row_pos = 0;
+			bench_rows_left--;
+		}
+	}
+
+	return nbytes;
+}
+
+/*
+ * Build a row with one field of "width" bytes for each column of "rel".
+ * Some of the fields have characters that need escaping or quoting in the
+ * middle, as real data does.
+ */
+static void
+build_row(Relation rel, bool csv_mode, int width)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	int			nfields = 0;
+
+	resetStringInfo(&bench_row);
+	for (int i = 0; i < tupdesc->natts; i++)
+	{
+		int			special = nfields % 4 == 3 ? width / 2 : -1;
+
+		if (TupleDescAttr(tupdesc, i)->attisdropped)
+			continue;
+		if (nfields++ > 0)
+			appendStringInfoChar(&bench_row, csv_mode ? ',' : '\t');
+
+		if (csv_mode && special >= 0)
+			appendStringInfoChar(&bench_row, '"');
+		for (int j = 0; j < width; j++)
+		{
+			if (j != special)
+				appendStringInfoChar(&bench_row, 'a' + (i + j) % 26);
+			else if (csv_mode)
+				appendStringInfoString(&bench_row, ",\"\"");
+			else
+				appendStringInfoString(&bench_row, "\\t");
+		}
+		if (csv_mode && special >= 0)
+			appendStringInfoChar(&bench_row, '"');
+	}
+	appendStringInfoChar(&bench_row, '\n');
+}
+
+/*
+ * Parse "nrows" rows in the given format for "rel", each with fields of
+ * "width" bytes, without inserting them.  Returns the input parsed per
+ * second, in MB.
+ */
+Datum
+test_copy_parse_bench(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	char	   *format = text_to_cstring(PG_GETARG_TEXT_PP(1));
+	int32		nrows = PG_GETARG_INT32(2);
+	int32		width = PG_GETARG_INT32(3);
+	Relation	rel;
+	CopyFromState cstate;
+	MemoryContext row_cxt;
+	MemoryContext old_cxt;
+	Datum	   *values;
+	bool	   *nulls;
+	instr_time	start_time;
+	instr_time	end_time;
+	double		nbytes;
+	double		secs;
+
+	if (strcmp(format, "text") != 0 && strcmp(format, "csv") != 0)
+		elog(ERROR, "unsupported format \"%s\"", format);
+	if (nrows < 0 || width < 1)
+		elog(ERROR, "invalid number of rows or width");
+
+	rel = table_open(relid, AccessShareLock);
+
+	if (bench_row.data == NULL)
+	{
+		old_cxt = MemoryContextSwitchTo(TopMemoryContext);
+		initStringInfo(&bench_row);
+		MemoryContextSwitchTo(old_cxt);
+	}
+	build_row(rel, strcmp(format, "csv") == 0, width);
+	bench_rows_left = nrows;
+	bench_row_pos = 0;
+
+	cstate = BeginCopyFrom(NULL, rel, NULL, NULL, false, bench_read_data, NIL,
+						   list_make1(makeDefElem("format",
+												  (Node *) makeString(format),
+												  -1)));
+
+	values = palloc(RelationGetDescr(rel)->natts * sizeof(Datum));
+	nulls = palloc(RelationGetDescr(rel)->natts * sizeof(bool));
+	row_cxt = AllocSetContextCreate(CurrentMemoryContext,
+									"copy parse benchmark",
+									ALLOCSET_DEFAULT_SIZES);
+
+	INSTR_TIME_SET_CURRENT(start_time);
+	for (;;)
+	{
+		bool		found;
+
+		CHECK_FOR_INTERRUPTS();
+
+		MemoryContextReset(row_cxt);
+		old_cxt = MemoryContextSwitchTo(row_cxt);
+		found = NextCopyFrom(cstate, NULL, values, nulls);
+		MemoryContextSwitchTo(old_cxt);
+
+		if (!found)
+			break;
+	}
+	INSTR_TIME_SET_CURRENT(end_time);
+	INSTR_TIME_SUBTRACT(end_time, start_time);
+
+	EndCopyFrom(cstate);
+	MemoryContextDelete(row_cxt);
+	table_close(rel, AccessShareLock);
+
+	nbytes = (double) nrows * bench_row.len;
+	secs = INSTR_TIME_GET_DOUBLE(end_time);
+
+	PG_RETURN_FLOAT8(secs > 0 ? nbytes / secs / 1000000.0 : 0);
+}
@@ -0,0 +1,145 @@
+# Copyright (c) 2024, PostgreSQL Global Development Group
+
+# Test sharing generic plans of prepared statements between sessions.
+
+use strict;
+use warnings FATAL => 'all';
+
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $node = PostgreSQL::Test::Cluster->new('node');
+$node->init();
+$node->append_conf(
+	'postgresql.conf', qq(
+shared_plan_cache_size = 1MB
+plan_cache_mode = force_generic_plan
+));
+$node->start;
+
+$node->safe_psql(
+	'postgres', q(
+CREATE TABLE spc (a int, b int);
+INSERT INTO spc SELECT i, i * 10 FROM generate_series(1, 100) i;
+CREATE SCHEMA other;
+CREATE TABLE other.spc (a int, b text);
+INSERT INTO other.spc VALUES (1, 'other');
+CREATE TABLE spc_part (a int, b int) PARTITION BY RANGE (a);
+CREATE TABLE spc_part_1 PARTITION OF spc_part FOR VALUES FROM (1) TO (51);
+CREATE TABLE spc_part_2 PARTITION OF spc_part FOR VALUES FROM (51) TO (101);
+INSERT INTO spc_part SELECT i, i * 10 FROM generate_series(1, 100) i;
+-- The planner folds calls of this function, so it reports whether the
+-- query was planned in the session.
+CREATE FUNCTION planned() RETURNS int IMMUTABLE LANGUAGE plpgsql
+  AS $$BEGIN RAISE NOTICE 'planning'; RETURN 0; END$$;
+));
+
+# Run a query as a prepared statement in a new session, returning its result
+# and whether the session used a plan from the shared plan cache.  The query
+# should call planned().
+sub run_prepared
+{
+	my ($query, $setup) = @_;
+	my ($stdout, $stderr);
+
+	$setup //= '';
+	$node->psql(
+		'postgres', qq(
+$setup
+PREPARE q(int) AS $query;
+EXECUTE q(1);
+),
+		stdout => \$stdout,
+		stderr => \$stderr,
+		on_error_die => 1);
+
+	return ($stdout, $stderr =~ /planning/ ? 0 : 1);
+}
+
+my ($result, $used_shared);
+
+# The first session has to plan the query itself.
+($result, $used_shared) = run_prepared('SELECT * FROM spc WHERE a = $1 + planned()');
+is($result, '1|10', 'first session gets correct result');
+is($used_shared, 0, 'first session plans the query itself');
+
+# The next one can use its plan.
+($result, $used_shared) = run_prepared('SELECT * FROM spc WHERE a = $1 + planned()');
+is($result, '1|10', 'second session gets correct result');
+is($used_shared, 1, 'second session uses the shared plan');
+
+# Plans are not shared with a session that resolves names differently.
+($result, $used_shared) = run_prepared('SELECT * FROM spc WHERE a = $1 + planned()',
+	'SET search_path = other, public;');
+is($result, '1|other', 'session with other search_path gets its own table');
+is($used_shared, 0, 'session with other search_path plans the query itself');
+
+# Nor with a session that uses different planner settings.
+($result, $used_shared) = run_prepared('SELECT * FROM spc WHERE a = $1 + planned()',
+	'SET enable_seqscan = off;');
+is($result, '1|10', 'session with other settings gets correct result');
+is($used_shared, 0, 'session with other settings plans the query itself');
+
+# Nor with sessions that interpret the constants folded into the plan
+# differently.
+my $tz_query =
+  q{SELECT extract(epoch FROM '2024-01-01 00:00'::timestamptz)::int + $1 - 1 + planned()};
+($result, $used_shared) = run_prepared($tz_query, q{SET TimeZone = 'UTC';});
+is($result, '1704067200', 'session in UTC gets correct result');
+($result, $used_shared) = run_prepared($tz_query, q{SET TimeZone = 'UTC';});
+is($used_shared, 1, 'session in the same time zone uses the shared plan');
+($result, $used_shared) =
+  run_prepared($tz_query, q{SET TimeZone = 'Asia/Tokyo';});
+is($result, '1704034800', 'session in other time zone gets correct result');
+is($used_shared, 0, 'session in other time zone plans the query itself');
+
+my $date_query =
+  q{SELECT '01/02/2024'::date - '2024-01-01'::date + $1 - 1 + planned()};
+($result, $used_shared) =
+  run_prepared($date_query, q{SET DateStyle = 'ISO, MDY';});
+is($result, '1', 'session with MDY dates gets correct result');
+($result, $used_shared) =
+  run_prepared($date_query, q{SET DateStyle = 'ISO, DMY';});
+is($result, '31', 'session with DMY dates gets correct result');
+is($used_shared, 0, 'session with other DateStyle plans the query itself');
+
+# After DDL on the table, the stored plan must not be used anymore.
+$node->safe_psql('postgres',
+	'ALTER TABLE spc ADD COLUMN c int DEFAULT 7');
+($result, $used_shared) = run_prepared('SELECT * FROM spc WHERE a = $1 + planned()');
+is($result, '1|10|7', 'session after DDL sees the new column');
+is($used_shared, 0, 'session after DDL plans the query itself');
+
+($result, $used_shared) = run_prepared('SELECT * FROM spc WHERE a = $1 + planned()');
+is($result, '1|10|7', 'next session after DDL gets correct result');
+is($used_shared, 1, 'next session after DDL uses the new shared plan');
+
+# A plan on a partitioned table covers the partitions, which have to be
+# locked by the session that adopts it.
+my $part_query = 'SELECT * FROM spc_part WHERE a = $1 + planned()';
+($result, $used_shared) = run_prepared($part_query);
+is($result, '1|10', 'first session on partitioned table gets correct result');
+is($used_shared, 0, 'first session on partitioned table plans the query');
+
+($result, $used_shared) = run_prepared($part_query);
+is($result, '1|10', 'session adopting plan with partitions gets correct result');
+is($used_shared, 1, 'plan on partitioned table is shared');
+
+# DDL on a partition alone makes the stored plan stale, too.
+$node->safe_psql('postgres', 'CREATE INDEX ON spc_part_1 (a)');
+($result, $used_shared) = run_prepared($part_query);
+is($result, '1|10', 'session after DDL on partition gets correct result');
+is($used_shared, 0, 'session after DDL on partition plans the query itself');
+
+# Plans that reference temporary tables are never shared.
+($result, $used_shared) = run_prepared('SELECT * FROM tmp WHERE a = $1 + planned()',
+	'CREATE TEMP TABLE tmp AS SELECT 1 AS a;');
+is($result, '1', 'temporary table query gets correct result');
+($result, $used_shared) = run_prepared('SELECT * FROM tmp WHERE a = $1 + planned()',
+	'CREATE TEMP TABLE tmp AS SELECT 1 AS a;');
+is($used_shared, 0, 'plans on temporary tables are not shared');
+
+$node->stop;
+
+done_testing();
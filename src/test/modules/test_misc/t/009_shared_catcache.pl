@@ -0,0 +1,62 @@
+# Copyright (c) 2024, PostgreSQL Global Development Group
+
+# Test sharing catalog cache entries between sessions.
+
+use strict;
+use warnings FATAL => 'all';
+
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $node = PostgreSQL::Test::Cluster->new('node');
+$node->init();
+$node->append_conf('postgresql.conf', 'shared_catcache_size = 1MB');
+$node->start;
+
+$node->safe_psql(
+	'postgres', q(
+CREATE FUNCTION scc_f() RETURNS int LANGUAGE sql AS 'SELECT 1';
+));
+
+# Number of shared catalog cache hits for pg_proc lookups by OID.
+sub proc_hits
+{
+	return $node->safe_psql(
+		'postgres', q(
+SELECT coalesce(sum(hits), 0) FROM pg_stat_shared_catcache
+  WHERE relid = 'pg_proc'::regclass AND indexrelid = 'pg_proc_oid_index'::regclass;
+));
+}
+
+# The first session loads the function from the catalog, the next ones can
+# take it from the shared catalog cache.
+is($node->safe_psql('postgres', 'SELECT scc_f()'), '1', 'first session');
+my $hits = proc_hits();
+is($node->safe_psql('postgres', 'SELECT scc_f()'), '1', 'second session');
+cmp_ok(proc_hits(), '>', $hits, 'second session hits the shared cache');
+
+# After the function is changed, new sessions must see the new definition.
+$node->safe_psql('postgres',
+	q(CREATE OR REPLACE FUNCTION scc_f() RETURNS int LANGUAGE sql AS 'SELECT 2'));
+is($node->safe_psql('postgres', 'SELECT scc_f()'), '2',
+	'session after change sees the new definition');
+is($node->safe_psql('postgres', 'SELECT scc_f()'), '2',
+	'next session after change sees the new definition');
+
+# A transaction that changed the function sees its own change.
+is( $node->safe_psql(
+		'postgres', q(
+BEGIN;
+CREATE OR REPLACE FUNCTION scc_f() RETURNS int LANGUAGE sql AS 'SELECT 3';
+SELECT scc_f();
+ROLLBACK;
+)),
+	'3',
+	'transaction sees its own uncommitted change');
+is($node->safe_psql('postgres', 'SELECT scc_f()'), '2',
+	'rolled back change is not visible');
+
+$node->stop;
+
+done_testing();
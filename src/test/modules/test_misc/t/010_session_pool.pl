@@ -0,0 +1,95 @@
+# Copyright (c) 2024, PostgreSQL Global Development Group
+
+# Test multiplexing client sessions over pooled backends.
+
+use strict;
+use warnings FATAL => 'all';
+
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+use Time::HiRes qw(usleep);
+
+if ($windows_os)
+{
+	plan skip_all => 'session pooling is not supported on Windows';
+}
+
+my $node = PostgreSQL::Test::Cluster->new('node');
+$node->init();
+$node->append_conf(
+	'postgresql.conf', qq(
+max_pooled_sessions = 10
+session_pool_size = 1
+));
+$node->start;
+
+my $pid_query = 'SELECT pg_backend_pid()';
+
+# Wait for an idle session to be served by the given pooled backend.
+sub wait_for_backend
+{
+	my ($session, $pid) = @_;
+
+	foreach my $i (1 .. 10 * $PostgreSQL::Test::Utils::timeout_default)
+	{
+		return 1 if $session->query_safe($pid_query) eq $pid;
+		usleep(100_000);
+	}
+	return 0;
+}
+
+# The first session's backend joins the pool once the session is idle.
+my $session1 = $node->background_psql('postgres');
+my $pid1 = $session1->query_safe($pid_query);
+
+# The second session starts out with a backend of its own, but as the pool
+# has room for one backend only, that one exits when the session is idle, and
+# the first backend serves both sessions from then on.
+my $session2 = $node->background_psql('postgres');
+my $pid2 = $session2->query_safe($pid_query);
+isnt($pid2, $pid1, 'new session gets a backend of its own');
+
+ok(wait_for_backend($session2, $pid1), 'idle sessions share a backend');
+is($session1->query_safe($pid_query), $pid1,
+	'first session is still served by its backend');
+
+# The session still goes by the PID it was started with.
+is( $session2->query_safe(
+		'SELECT session_pid FROM pg_stat_activity WHERE pid = pg_backend_pid()'),
+	$pid2,
+	'pg_stat_activity shows the PID the client knows the session by');
+
+# A session with a temporary table keeps its backend, and the other session
+# gets a new one.
+$session2->query_safe('CREATE TEMP TABLE sp_tmp AS SELECT 42 AS a');
+isnt($session1->query_safe($pid_query),
+	$pid1, 'session gets a new backend when the pool backend is pinned');
+is($session2->query_safe($pid_query),
+	$pid1, 'pinned session keeps its backend');
+is($session2->query_safe('SELECT a FROM sp_tmp'),
+	'42', 'pinned session keeps its temporary table');
+
+# So does a session that has values for currval() and lastval().
+my $pid3 = $session1->query_safe($pid_query);
+my $session3 = $node->background_psql('postgres');
+ok(wait_for_backend($session3, $pid3), 'new session shares the pool backend');
+$session3->query_safe('CREATE SEQUENCE sp_seq');
+is($session3->query_safe("SELECT nextval('sp_seq')"), '1', 'nextval works');
+isnt($session1->query_safe($pid_query),
+	$pid3, 'sequence values pin the session to its backend');
+is( $session3->query_safe(
+		"SELECT currval('sp_seq'), lastval(), pg_backend_pid()"),
+	"1|1|$pid3",
+	'pinned session keeps its sequence values');
+
+$session1->quit;
+$session2->quit;
+$session3->quit;
+
+# New connections still work after pooled sessions have disconnected.
+is($node->safe_psql('postgres', 'SELECT 1'), '1', 'server accepts new sessions');
+
+$node->stop;
+
+done_testing();
@@ -0,0 +1,89 @@
+
+# Copyright (c) 2024, PostgreSQL Global Development Group
+
+# Exercise read streams with io_method = io_uring.
+
+use strict;
+use warnings FATAL => 'all';
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+if (!check_pg_config("#define HAVE_LINUX_IO_URING_H 1"))
+{
+	plan skip_all => 'io_uring is not supported by this build';
+}
+
+my $node = PostgreSQL::Test::Cluster->new('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq{
+io_method = io_uring
+shared_buffers = '256kB' # tiny to force I/O
+effective_io_concurrency = 16
+maintenance_io_concurrency = 16
+max_parallel_workers_per_gather = 2
+parallel_setup_cost = 0
+parallel_tuple_cost = 0
+min_parallel_table_scan_size = 0
+});
+$node->start;
+
+$node->safe_psql('postgres',
+	"CREATE TABLE t (i int, filler text) WITH (autovacuum_enabled = off);
+	 INSERT INTO t SELECT g, repeat('x', 100) FROM generate_series(1, 100000) g;
+	 VACUUM (FREEZE) t;");
+
+# Start with nothing cached, and check that the kernel lets us use io_uring
+# at all; a sandbox may not.
+$node->restart;
+my $log_offset = -s $node->logfile;
+$node->safe_psql('postgres', 'SELECT count(*) FROM t');
+if ($node->log_contains('falling back to synchronous I/O', $log_offset))
+{
+	plan skip_all => 'io_uring cannot be set up here';
+}
+
+is($node->safe_psql('postgres', 'SHOW io_method'),
+	'io_uring', 'io_method is io_uring');
+
+my $expected = '100000|5000050000|10000000';
+my $query = 'SELECT count(*), sum(i), sum(length(filler)) FROM t';
+
+$node->restart;
+is( $node->safe_psql(
+		'postgres', "SET max_parallel_workers_per_gather = 0; $query"),
+	$expected,
+	'sequential scan reads all blocks');
+
+$node->restart;
+is($node->safe_psql('postgres', $query),
+	$expected, 'parallel sequential scan reads all blocks');
+
+$node->restart;
+$node->safe_psql('postgres', 'ANALYZE t');
+is( $node->safe_psql(
+		'postgres', "SELECT reltuples FROM pg_class WHERE relname = 't'"),
+	'100000',
+	'ANALYZE samples all blocks');
+
+# A cursor left idle in the middle of a scan must not hold up other backends
+# reading the same blocks.
+$node->restart;
+my $session = $node->background_psql('postgres');
+$session->query_safe('BEGIN');
+$session->query_safe('DECLARE c CURSOR FOR SELECT i FROM t');
+is($session->query_safe('FETCH 1 FROM c'), '1', 'cursor returns first row');
+is($node->safe_psql('postgres', $query),
+	$expected, 'scan completes while another scan of the table is idle');
+is($session->query_safe('MOVE FORWARD 99998 IN c; FETCH 1 FROM c'),
+	'100000', 'idle scan completes');
+$session->query_safe('COMMIT');
+$session->quit;
+
+ok(!$node->log_contains('falling back to synchronous I/O', $log_offset),
+	'io_uring was used throughout');
+
+$node->stop;
+
+done_testing();
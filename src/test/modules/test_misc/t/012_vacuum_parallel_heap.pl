@@ -0,0 +1,65 @@
+
+# Copyright (c) 2024, PostgreSQL Global Development Group
+
+# Check that a parallel scan of the heap by VACUUM goes through several rounds
+# of index vacuuming when dead_items fills up, with the workers relaunched for
+# each round.
+
+use strict;
+use warnings FATAL => 'all';
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $node = PostgreSQL::Test::Cluster->new('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', qq{
+max_worker_processes = 8
+max_parallel_workers = 8
+max_parallel_maintenance_workers = 2
+});
+$node->start;
+
+# About 440 blocks, so 14 chunks for the participants to claim, with a third
+# of the tuples of each block dead.
+$node->safe_psql('postgres',
+	"CREATE TABLE t (a int) WITH (autovacuum_enabled = off);
+	 INSERT INTO t SELECT g FROM generate_series(1, 100000) g;
+	 CREATE INDEX t_a_idx ON t (a);
+	 DELETE FROM t WHERE a % 3 = 0;");
+
+# The smallest maintenance_work_mem is below the initial size of the shared
+# dead_items store, so it is full as soon as any participant adds to it.
+my ($stderr, $stdout);
+my $ret = $node->psql(
+	'postgres',
+	"SET maintenance_work_mem = '64kB';
+	 SET min_parallel_table_scan_size = 0;
+	 VACUUM (VERBOSE, PARALLEL 2) t;",
+	stdout => \$stdout,
+	stderr => \$stderr);
+is($ret, 0, 'VACUUM succeeded');
+
+my @launched =
+  ($stderr =~ /launched (\d+) parallel vacuum workers? for table scanning/g);
+cmp_ok(scalar(@launched), '>=', 2,
+	'workers were launched again after dead_items filled up');
+ok((grep { $_ > 0 } @launched), 'workers took part in the scan of the heap');
+
+like($stderr, qr/index scans: (\d+)/, 'VACUUM reported its index scans');
+my ($index_scans) = ($stderr =~ /index scans: (\d+)/);
+cmp_ok($index_scans, '>=', 2, 'indexes were vacuumed in several rounds');
+
+my ($removed) = ($stderr =~ /tuples: (\d+) removed/);
+is($removed, 33333, 'all dead tuples were removed');
+
+is( $node->safe_psql(
+		'postgres',
+		"SET enable_seqscan = off; SELECT count(*) FROM t WHERE a > 0"),
+	'66667',
+	'index matches the heap');
+
+$node->stop;
+
+done_testing();
@@ -0,0 +1,17 @@
+CREATE EXTENSION test_tuplesort;
+
+--
+-- All the logic is in the test_tuplesort_datum() function. It will throw
+-- an error if something fails.  Run it with both radix sort and quicksort.
+--
+SET optimize_radix_sort = on;
+SELECT test_tuplesort_datum(50000);
+
+SET optimize_radix_sort = off;
+SELECT test_tuplesort_datum(50000);
+
+RESET optimize_radix_sort;
+
+-- The benchmark function just has to run.
+SELECT test_tuplesort_bench('int8', 10000) >= 0 AS ok;
+SELECT test_tuplesort_bench('bool', 10);
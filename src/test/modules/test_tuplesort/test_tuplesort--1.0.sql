@@ -0,0 +1,12 @@
+/* src/test/modules/test_tuplesort/test_tuplesort--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_tuplesort" to load this file. \quit
+
+CREATE FUNCTION test_tuplesort_datum(nelements int4)
+RETURNS pg_catalog.void STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION test_tuplesort_bench(typ regtype, nelements int4)
+RETURNS pg_catalog.float8 STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
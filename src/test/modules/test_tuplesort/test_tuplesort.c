@@ -0,0 +1,247 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_tuplesort.c
+ *		Test in-memory sorting of datums by tuplesort.
+ *
+ * Copyright (c) 2024, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_tuplesort/test_tuplesort.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "catalog/pg_collation.h"
+#include "catalog/pg_type.h"
+#include "common/pg_prng.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "portability/instr_time.h"
+#include "utils/builtins.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/tuplesort.h"
+#include "utils/typcache.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(test_tuplesort_datum);
+PG_FUNCTION_INFO_V1(test_tuplesort_bench);
+
+/*
+ * A struct to define one sort, for use with the test_sort() function.
+ */
+typedef struct
+{
+	char	   *test_name;		/* short name of the test, for humans */
+	Oid			typid;			/* int4, int8 or text */
+	bool		descending;		/* sort in descending order? */
+	bool		nulls_first;	/* sort NULLs first? */
+	uint32		ndistinct;		/* number of distinct values, 0 for random */
+	int			null_every;		/* every n'th value is NULL, 0 for none */
+} test_spec;
+
+static const test_spec test_specs[] = {
+	{"int4 ascending", INT4OID, false, false, 0, 0},
+	{"int4 descending, nulls first", INT4OID, true, true, 0, 10},
+	{"int4 with duplicates", INT4OID, false, false, 100, 3},
+	{"int8 ascending, nulls first", INT8OID, false, true, 0, 7},
+	{"int8 descending", INT8OID, true, false, 0, 0},
+	{"int8 with duplicates", INT8OID, false, false, 1000, 0},
+	{"text ascending", TEXTOID, false, false, 0, 5},
+	{"text descending, nulls first", TEXTOID, true, true, 0, 5},
+	{"text with duplicates", TEXTOID, false, false, 50, 0},
+};
+
+/*
+ * Make a pseudo-random value of the given type.  Text values share a prefix
+ * shorter than an abbreviated key, so that the abbreviated keys differ, and
+ * thus get radix sorted, but often tie, which the full comparison resolves.
+ */
+static Datum
+make_value(pg_prng_state *prng, Oid typid, uint32 ndistinct)
+{
+	uint64		v = pg_prng_uint64(prng);
+
+	if (ndistinct > 0)
+		v %= ndistinct;
+
+	switch (typid)
+	{
+		case INT4OID:
+			return Int32GetDatum((int32) v);
+		case INT8OID:
+			return Int64GetDatum((int64) v);
+		case TEXTOID:
+			{
+				char		buf[64];
+
+				snprintf(buf, sizeof(buf), "abc%c%llu",
+						 'a' + (char) (v % 26),
+						 (unsigned long long) (v >> 8));
+				return CStringGetTextDatum(buf);
+			}
+		default:
+			elog(ERROR, "unsupported type %s", format_type_be(typid));
+	}
+	return (Datum) 0;			/* keep compiler quiet */
+}
+
+/*
+ * Sort "nelements" values according to "spec", and check that the output
+ * is in order and holds as many values and NULLs as the input.
+ */
+static void
+test_sort(const test_spec *spec, int nelements)
+{
+	MemoryContext test_cxt;
+	MemoryContext old_cxt;
+	TypeCacheEntry *typentry;
+	Oid			sortop;
+	Tuplesortstate *state;
+	pg_prng_state prng;
+	int			nnulls = 0;
+	int			nread = 0;
+	int			nnulls_read = 0;
+	bool		have_prev = false;
+	Datum		prev = (Datum) 0;
+	Datum		val;
+	bool		isnull;
+
+	elog(NOTICE, "testing tuplesort with %s", spec->test_name);
+
+	test_cxt = AllocSetContextCreate(CurrentMemoryContext,
+									 "tuplesort test",
+									 ALLOCSET_DEFAULT_SIZES);
+	old_cxt = MemoryContextSwitchTo(test_cxt);
+
+	typentry = lookup_type_cache(spec->typid,
+								 TYPECACHE_LT_OPR | TYPECACHE_GT_OPR |
+								 TYPECACHE_CMP_PROC_FINFO);
+	sortop = spec->descending ? typentry->gt_opr : typentry->lt_opr;
+
+	state = tuplesort_begin_datum(spec->typid, sortop, C_COLLATION_OID,
+								  spec->nulls_first, work_mem, NULL,
+								  TUPLESORT_NONE);
+
+	pg_prng_seed(&prng, 0x5EED);
+	for (int i = 0; i < nelements; i++)
+	{
+		if (spec->null_every > 0 && i % spec->null_every == 0)
+		{
+			tuplesort_putdatum(state, (Datum) 0, true);
+			nnulls++;
+		}
+		else
+			tuplesort_putdatum(state,
+							   make_value(&prng, spec->typid, spec->ndistinct),
+							   false);
+	}
+
+	tuplesort_performsort(state);
+
+	while (tuplesort_getdatum(state, true, true, &val, &isnull, NULL))
+	{
+		if (isnull)
+		{
+			if (!spec->nulls_first && nread - nnulls_read < nelements - nnulls)
+				elog(ERROR, "NULL returned before non-NULL values");
+			nnulls_read++;
+		}
+		else
+		{
+			if (spec->nulls_first && nnulls_read < nnulls)
+				elog(ERROR, "non-NULL value returned before NULLs");
+			if (have_prev)
+			{
+				int32		cmp;
+
+				cmp = DatumGetInt32(FunctionCall2Coll(&typentry->cmp_proc_finfo,
+													  C_COLLATION_OID,
+													  prev, val));
+				if (spec->descending ? cmp < 0 : cmp > 0)
+					elog(ERROR, "value %d returned out of order", nread);
+			}
+			prev = val;
+			have_prev = true;
+		}
+		nread++;
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	if (nread != nelements)
+		elog(ERROR, "tuplesort returned %d values, expected %d",
+			 nread, nelements);
+	if (nnulls_read != nnulls)
+		elog(ERROR, "tuplesort returned %d NULLs, expected %d",
+			 nnulls_read, nnulls);
+
+	tuplesort_end(state);
+
+	MemoryContextSwitchTo(old_cxt);
+	MemoryContextDelete(test_cxt);
+}
+
+/*
+ * SQL-callable entry point to perform all tests.
+ */
+Datum
+test_tuplesort_datum(PG_FUNCTION_ARGS)
+{
+	int			nelements = PG_GETARG_INT32(0);
+
+	if (nelements < 0)
+		elog(ERROR, "invalid number of elements: %d", nelements);
+
+	for (int i = 0; i < lengthof(test_specs); i++)
+		test_sort(&test_specs[i], nelements);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Sort "nelements" random values of the given type, and return the time
+ * spent in tuplesort_performsort(), in milliseconds.
+ */
+Datum
+test_tuplesort_bench(PG_FUNCTION_ARGS)
+{
+	Oid			typid = PG_GETARG_OID(0);
+	int			nelements = PG_GETARG_INT32(1);
+	MemoryContext test_cxt;
+	MemoryContext old_cxt;
+	TypeCacheEntry *typentry;
+	Tuplesortstate *state;
+	pg_prng_state prng;
+	instr_time	start_time;
+	instr_time	end_time;
+
+	if (typid != INT4OID && typid != INT8OID && typid != TEXTOID)
+		elog(ERROR, "unsupported type %s", format_type_be(typid));
+
+	test_cxt = AllocSetContextCreate(CurrentMemoryContext,
+									 "tuplesort benchmark",
+									 ALLOCSET_DEFAULT_SIZES);
+	old_cxt = MemoryContextSwitchTo(test_cxt);
+
+	typentry = lookup_type_cache(typid, TYPECACHE_LT_OPR);
+	state = tuplesort_begin_datum(typid, typentry->lt_opr, C_COLLATION_OID,
+								  false, work_mem, NULL, TUPLESORT_NONE);
+
+	pg_prng_seed(&prng, 0x5EED);
+	for (int i = 0; i < nelements; i++)
+		tuplesort_putdatum(state, make_value(&prng, typid, 0), false);
+
+	INSTR_TIME_SET_CURRENT(start_time);
+	tuplesort_performsort(state);
+	INSTR_TIME_SET_CURRENT(end_time);
+	INSTR_TIME_SUBTRACT(end_time, start_time);
+
+	tuplesort_end(state);
+
+	MemoryContextSwitchTo(old_cxt);
+	MemoryContextDelete(test_cxt);
+
+	PG_RETURN_FLOAT8(INSTR_TIME_GET_MILLISEC(end_time));
+}
@@ -0,0 +1,74 @@
+
+# Copyright (c) 2024, PostgreSQL Global Development Group
+
+# Test applying WAL with parallel redo workers on a standby.
+use strict;
+use warnings FATAL => 'all';
+
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $node_primary = PostgreSQL::Test::Cluster->new('primary');
+$node_primary->init(allows_streaming => 1);
+$node_primary->append_conf('postgresql.conf', 'autovacuum = off');
+$node_primary->start;
+
+$node_primary->safe_psql(
+	'postgres', qq{
+create table t1 (a int primary key, b text);
+create table t2 (a int primary key, b text);
+});
+
+$node_primary->backup('primary_backup');
+my $node_standby = PostgreSQL::Test::Cluster->new('standby');
+$node_standby->init_from_backup($node_primary, 'primary_backup',
+	has_streaming => 1);
+$node_standby->append_conf(
+	'postgresql.conf', qq{
+recovery_parallel_workers = 2
+max_worker_processes = 8
+});
+$node_standby->start;
+
+# A mix of records that the workers apply, and ones that the startup
+# process applies itself after waiting for the workers.
+$node_primary->safe_psql(
+	'postgres', qq{
+insert into t1 select g, 'row ' || g from generate_series(1, 10000) g;
+insert into t2 select g, 'row ' || g from generate_series(1, 10000) g;
+update t1 set b = b || ' updated' where a % 3 = 0;
+delete from t2 where a % 5 = 0;
+vacuum t1;
+update t1 set b = 'again' where a % 7 = 0;
+create table t3 as select * from t1 where a < 100;
+drop table t2;
+insert into t1 select g, 'more' from generate_series(10001, 20000) g;
+});
+$node_primary->wait_for_replay_catchup($node_standby);
+
+my $query =
+  "select count(*), sum(a), md5(string_agg(b, ',' order by a)) from t1";
+is( $node_standby->safe_psql('postgres', $query),
+	$node_primary->safe_psql('postgres', $query),
+	'heap contents match after parallel redo');
+
+is( $node_standby->safe_psql(
+		'postgres',
+		"set enable_seqscan = off; set enable_bitmapscan = off; "
+		  . "select count(*) from t1 where a between 1 and 20000"),
+	'20000',
+	'index contents match after parallel redo');
+
+is( $node_standby->safe_psql('postgres', 'select count(*) from t3'),
+	'99', 'table created during parallel redo is intact');
+
+# Promotion shuts down the workers after applying everything.
+$node_primary->safe_psql('postgres',
+	"insert into t1 select g, 'last' from generate_series(20001, 21000) g");
+$node_primary->wait_for_replay_catchup($node_standby);
+$node_standby->promote;
+is($node_standby->safe_psql('postgres', 'select count(*) from t1'),
+	'21000', 'all rows present after promotion');
+
+done_testing();
@@ -0,0 +1,143 @@
+# Copyright (c) 2024, PostgreSQL Global Development Group
+
+# Test MVCC snapshots taken with csn_snapshots, including across a restart
+# with a prepared transaction and after promotion of a standby.
+use strict;
+use warnings FATAL => 'all';
+
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $node_primary = PostgreSQL::Test::Cluster->new('primary');
+$node_primary->init(allows_streaming => 1);
+$node_primary->append_conf(
+	'postgresql.conf', qq{
+csn_snapshots = on
+max_prepared_transactions = 5
+});
+$node_primary->start;
+
+$node_primary->safe_psql('postgres',
+	"create table t (a int); insert into t select generate_series(1, 10)");
+
+# A repeatable read snapshot doesn't see later commits, including ones made
+# in subtransactions, but sees its own changes.
+my $rr = $node_primary->background_psql('postgres');
+$rr->query_safe(
+	"begin isolation level repeatable read; select count(*) from t");
+
+$node_primary->safe_psql(
+	'postgres', qq{
+begin;
+insert into t values (11);
+savepoint s1;
+insert into t values (12);
+savepoint s2;
+insert into t values (13);
+rollback to s2;
+commit;
+});
+
+is($rr->query_safe("select count(*) from t"),
+	'10', 'repeatable read snapshot does not see later commit');
+$rr->query_safe("insert into t values (100)");
+is($rr->query_safe("select count(*) from t"),
+	'11', 'repeatable read snapshot sees own insert');
+$rr->query_safe("commit");
+
+is($node_primary->safe_psql('postgres', 'select count(*) from t'),
+	'13', 'committed subtransactions are visible, aborted ones are not');
+
+# The snapshot lists the transactions that were running when it was taken.
+my $running = $node_primary->background_psql('postgres');
+my $running_xid = $running->query_safe(
+	"begin; select pg_current_xact_id()");
+is( $node_primary->safe_psql(
+		'postgres',
+		"select '$running_xid'::xid8 in (select pg_snapshot_xip(pg_current_snapshot()))"
+	),
+	't',
+	'pg_current_snapshot lists running transaction');
+$running->query_safe("commit");
+$running->quit;
+
+# Serializable transactions detect rw-conflicts with transactions that
+# committed after their snapshot was taken, preventing write skew.
+$node_primary->safe_psql(
+	'postgres', qq{
+create table doctors (name text primary key, on_call bool);
+insert into doctors values ('alice', true), ('bob', true);
+});
+my $s1 = $node_primary->background_psql('postgres');
+my $s2 = $node_primary->background_psql('postgres');
+$s1->query_safe(
+	"begin isolation level serializable; select count(*) from doctors where on_call"
+);
+$s2->query_safe("begin isolation level serializable; select 1");
+$s1->query_safe("update doctors set on_call = false where name = 'alice'");
+$s1->query_safe("commit");
+$s2->query("select count(*) from doctors where on_call");
+$s2->query("update doctors set on_call = false where name = 'bob'");
+$s2->query("commit");
+like(
+	$s2->{stderr},
+	qr/could not serialize access/,
+	'serializable transaction fails on write skew');
+is( $node_primary->safe_psql(
+		'postgres', 'select count(*) from doctors where on_call'),
+	'1',
+	'write skew was prevented');
+$s1->quit;
+$s2->quit;
+
+# Enough transactions to advance the snapshot xmin bound a few times.
+for my $i (1 .. 5)
+{
+	$node_primary->safe_psql('postgres',
+		"do \$\$ begin for i in 1..100 loop perform pg_current_xact_id(); commit; end loop; end \$\$"
+	);
+	$node_primary->safe_psql('postgres', "insert into t values (-$i)");
+}
+is($node_primary->safe_psql('postgres', 'select count(*) from t'),
+	'18', 'rows visible after xmin bound advances');
+
+# A prepared transaction survives a restart as in progress, and becomes
+# visible once committed.
+$node_primary->safe_psql(
+	'postgres', qq{
+begin;
+insert into t values (200);
+savepoint s1;
+insert into t values (201);
+prepare transaction 'p1';
+});
+$node_primary->restart;
+
+is($node_primary->safe_psql('postgres', 'select count(*) from t'),
+	'18', 'prepared transaction is invisible after restart');
+$node_primary->safe_psql('postgres', "commit prepared 'p1'");
+is($node_primary->safe_psql('postgres', 'select count(*) from t'),
+	'20', 'prepared transaction is visible once committed');
+
+# Standbys use regular snapshots until promoted.
+$node_primary->backup('primary_backup');
+my $node_standby = PostgreSQL::Test::Cluster->new('standby');
+$node_standby->init_from_backup($node_primary, 'primary_backup',
+	has_streaming => 1);
+$node_standby->start;
+
+$node_primary->safe_psql('postgres', "insert into t values (300)");
+$node_primary->wait_for_replay_catchup($node_standby);
+is($node_standby->safe_psql('postgres', 'select count(*) from t'),
+	'21', 'standby sees replayed rows');
+
+$node_standby->promote;
+$node_standby->safe_psql('postgres', "insert into t values (301)");
+is($node_standby->safe_psql('postgres', 'select count(*) from t'),
+	'22', 'promoted standby uses CSN snapshots');
+
+$node_primary->stop;
+$node_standby->stop;
+
+done_testing();
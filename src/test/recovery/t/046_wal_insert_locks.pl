@@ -0,0 +1,53 @@
+
+# Copyright (c) 2024, PostgreSQL Global Development Group
+
+# Checkpoints and WAL switches hold all WAL insertion locks at once.  Check
+# that they work with the maximum number of insertion locks, and that WAL
+# written with that many locks can be replayed.
+
+use strict;
+use warnings FATAL => 'all';
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $node = PostgreSQL::Test::Cluster->new('main');
+$node->init;
+$node->append_conf('postgresql.conf', 'wal_insert_locks = 128');
+$node->start;
+
+is($node->safe_psql('postgres', 'SHOW wal_insert_locks'),
+	'128', 'server runs with the maximum number of insertion locks');
+
+$node->safe_psql('postgres',
+	'CREATE TABLE t AS SELECT g AS i FROM generate_series(1, 1000) g');
+$node->safe_psql('postgres', 'CHECKPOINT');
+$node->safe_psql('postgres', 'SELECT pg_switch_wal()');
+$node->safe_psql('postgres',
+	'INSERT INTO t SELECT g FROM generate_series(1001, 2000) g');
+$node->safe_psql('postgres', 'CHECKPOINT');
+
+# Concurrent inserters spread over the locks while checkpoints run.
+$node->pgbench(
+	'--no-vacuum --client=8 --transactions=200',
+	0,
+	[qr{processed: 1600/1600}],
+	[qr{^$}],
+	'concurrent inserts',
+	{
+		'001_insert' => q{
+			INSERT INTO t SELECT g FROM generate_series(1, 10) g;
+			SELECT CASE WHEN random() < 0.02 THEN pg_switch_wal() END;
+		}
+	});
+$node->safe_psql('postgres', 'CHECKPOINT');
+
+$node->stop('immediate');
+$node->start;
+
+is($node->safe_psql('postgres', 'SELECT count(*) FROM t'),
+	'18000', 'all rows are recovered');
+
+$node->stop;
+
+done_testing();
@@ -0,0 +1,74 @@
+--
+-- Plain aggregates over a sequential scan, read in batches
+--
+
+CREATE TABLE batch_agg (i2 int2, i4 int4, i8 int8, f8 float8, d date, t text);
+INSERT INTO batch_agg
+  SELECT i % 100, i, i * 1000000000::int8, i / 4.0, '2000-01-01'::date + i, i::text
+  FROM generate_series(1, 5000) i;
+INSERT INTO batch_agg VALUES (NULL, NULL, NULL, NULL, NULL, NULL);
+INSERT INTO batch_agg VALUES (-7, -7, -7, -7, '1999-12-25', '-7');
+ANALYZE batch_agg;
+
+-- Compute the results with batching disabled, then compare
+SET executor_batch_size = 0;
+
+CREATE TEMP TABLE batch_agg_expected AS
+SELECT 1 AS q, count(*) AS n, count(i4) AS c, sum(i2) AS s2, sum(i4) AS s4,
+       sum(i8) AS s8, min(i2)::int8 AS min2, max(i2)::int8 AS max2,
+       min(i4)::int8 AS min4, max(i4)::int8 AS max4, min(i8) AS min8,
+       max(i8) AS max8, avg(i4) AS a4, max(f8) AS mf, min(d) AS md
+  FROM batch_agg
+UNION ALL
+SELECT 2, count(*), count(i4), sum(i2), sum(i4), sum(i8), min(i2), max(i2),
+       min(i4), max(i4), min(i8), max(i8), avg(i4), max(f8), min(d)
+  FROM batch_agg WHERE i4 > 100 AND i8 <= 4000000000000 AND i2 <> 5
+UNION ALL
+SELECT 3, count(*), count(i4), sum(i2), sum(i4), sum(i8), min(i2), max(i2),
+       min(i4), max(i4), min(i8), max(i8), avg(i4), max(f8), min(d)
+  FROM batch_agg WHERE 10 < i2 AND f8 < 1000.5 AND d >= '2000-06-01'
+UNION ALL
+SELECT 4, count(*), count(i4), sum(i2), sum(i4), sum(i8), min(i2), max(i2),
+       min(i4), max(i4), min(i8), max(i8), avg(i4), max(f8), min(d)
+  FROM batch_agg WHERE i4 > 1000000;
+
+RESET executor_batch_size;
+SET executor_batch_size = 7;	-- exercise partially filled batches
+
+SELECT count(*) FROM (
+SELECT 1 AS q, count(*) AS n, count(i4) AS c, sum(i2) AS s2, sum(i4) AS s4,
+       sum(i8) AS s8, min(i2)::int8 AS min2, max(i2)::int8 AS max2,
+       min(i4)::int8 AS min4, max(i4)::int8 AS max4, min(i8) AS min8,
+       max(i8) AS max8, avg(i4) AS a4, max(f8) AS mf, min(d) AS md
+  FROM batch_agg
+UNION ALL
+SELECT 2, count(*), count(i4), sum(i2), sum(i4), sum(i8), min(i2), max(i2),
+       min(i4), max(i4), min(i8), max(i8), avg(i4), max(f8), min(d)
+  FROM batch_agg WHERE i4 > 100 AND i8 <= 4000000000000 AND i2 <> 5
+UNION ALL
+SELECT 3, count(*), count(i4), sum(i2), sum(i4), sum(i8), min(i2), max(i2),
+       min(i4), max(i4), min(i8), max(i8), avg(i4), max(f8), min(d)
+  FROM batch_agg WHERE 10 < i2 AND f8 < 1000.5 AND d >= '2000-06-01'
+UNION ALL
+SELECT 4, count(*), count(i4), sum(i2), sum(i4), sum(i8), min(i2), max(i2),
+       min(i4), max(i4), min(i8), max(i8), avg(i4), max(f8), min(d)
+  FROM batch_agg WHERE i4 > 1000000
+EXCEPT ALL
+SELECT * FROM batch_agg_expected) s;
+
+RESET executor_batch_size;
+
+-- Some results that are easy to verify by hand
+SELECT count(*), count(i4), sum(i4), min(i4), max(i4) FROM batch_agg;
+SELECT count(*), sum(i2), min(d) - '2000-01-01', max(d) - '2000-01-01'
+  FROM batch_agg WHERE i4 <= 10;
+SELECT count(t), max(i8) FROM batch_agg WHERE i4 = 5000;
+SELECT count(*), sum(i4) FROM batch_agg WHERE i4 > 5000;
+
+-- Rescans, with and without a parameter in the scan's qual
+SELECT x, (SELECT count(*) FROM batch_agg WHERE i4 <= x)
+  FROM generate_series(0, 3) x;
+SELECT x, (SELECT count(*) + x FROM batch_agg WHERE i4 <= 3)
+  FROM generate_series(0, 1) x;
+
+DROP TABLE batch_agg;
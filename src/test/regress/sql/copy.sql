@@ -320,3 +320,65 @@ COPY parted_si(id, data) FROM :'filename';
 SELECT tableoid::regclass, id % 2 = 0 is_even, count(*) from parted_si GROUP BY 1, 2 ORDER BY 1;
 
 DROP TABLE parted_si;
+
+-- test Arrow format
+create temp table copy_arrow (
+    b bool, i2 int2, i4 int4, i8 int8, f4 float4, f8 float8,
+    d date, t time, ts timestamp, tstz timestamptz,
+    by bytea, tx text, vc varchar(10), n numeric, arr int[]);
+-- enough rows for more than one record batch, some before 1970
+insert into copy_arrow
+  select i % 3 = 0, i % 32000 - 16000, i * 1000 - 35000000,
+         (i - 35000)::int8 * 100000000000, i / 4.0, i / 3.0,
+         date '1960-01-01' + i, time '00:00:00.5' + i * interval '1 second',
+         timestamp '1960-01-01 12:34:56.789' + i * interval '1 hour',
+         timestamptz '2024-01-01 00:00:00+00' - i * interval '1 minute',
+         int4send(i), 'row ' || i, left(md5(i::text), 10), i / 7.0,
+         array[i, -i]
+  from generate_series(1, 70000) i;
+insert into copy_arrow values (null, null, null, null, null, null, null, null,
+  null, null, null, null, null, null, null);
+insert into copy_arrow values (false, 0, 0, 0, 0, 0, '1970-01-01', '24:00',
+  '1970-01-01', '1970-01-01 00:00:00+00', '', '', '', 0, '{}');
+\set filename :abs_builddir '/results/copy_arrow.arrow'
+copy copy_arrow to :'filename' (format arrow);
+-- an Arrow stream starts with a continuation marker
+select substr(pg_read_binary_file(:'filename'), 1, 4) as marker;
+create temp table copy_arrow2 (like copy_arrow);
+copy copy_arrow2 from :'filename' (format arrow);
+select count(*) from copy_arrow2;
+select count(*) from
+  ((select * from copy_arrow except all select * from copy_arrow2)
+   union all
+   (select * from copy_arrow2 except all select * from copy_arrow)) d;
+-- wrong number of fields
+create temp table copy_arrow_int (a int2);
+copy copy_arrow_int from :'filename' (format arrow);
+-- strings are loaded with the column's input function
+copy (select '42' as a) to :'filename' (format arrow);
+copy copy_arrow_int from :'filename' (format arrow);
+select * from copy_arrow_int;
+-- integers must fit into the column
+copy (select 40000 as a) to :'filename' (format arrow);
+copy copy_arrow_int from :'filename' (format arrow);
+copy (select 1.5::float8 as a) to :'filename' (format arrow);
+copy copy_arrow_int from :'filename' (format arrow);
+-- infinite values have no Arrow representation
+copy (select date 'infinity' as a) to :'filename' (format arrow);
+-- a record batch whose row count overflows the size of its buffers
+create temp table copy_arrow_bad (a int8);
+select lo_from_bytea(0, decode(
+  'ffffffff98000000140000000c001300100012000c0004000000000010000000'
+  '0000000000000000140000000400010008000a0008000400000000000c000000'
+  '0800000000000000010000001800000010001200040010001100080000000c00'
+  '0000000014000000100000002000000028000000010200000100000061000800'
+  '0900040008000000000000000e00000040000000010000000000000000000000'
+  'ffffffff88000000140000000c001300100012000c0004000000000010000000'
+  '080000000000000014000000040003000a00140004000c00100000000c000000'
+  '00000000000000200c0000002000000000000000010000000000000000000020'
+  '0000000000000000000000000200000000000000000000000000000000000000'
+  '000000000000000008000000000000002a00000000000000ffffffff00000000', 'hex')) as arrow_lo \gset
+select lo_export(:arrow_lo, :'filename');
+select lo_unlink(:arrow_lo);
+copy copy_arrow_bad from :'filename' (format arrow);
+drop table copy_arrow, copy_arrow2, copy_arrow_int, copy_arrow_bad;
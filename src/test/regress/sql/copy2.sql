@@ -68,6 +68,7 @@ COPY x from stdin (convert_selectively (a), convert_selectively (b));
 COPY x from stdin (encoding 'sql_ascii', encoding 'sql_ascii');
 COPY x from stdin (on_error ignore, on_error ignore);
 COPY x from stdin (log_verbosity default, log_verbosity verbose);
+COPY x from stdin (parallel 1, parallel 2);
 
 -- incorrect options
 COPY x from stdin (format BINARY, delimiter ',');
@@ -88,6 +89,13 @@ COPY x to stdout (format CSV, force_null(a));
 COPY x to stdout (format CSV, force_null *);
 COPY x to stdout (format BINARY, on_error unsupported);
 COPY x from stdin (log_verbosity unsupported);
+COPY x from stdin (format BINARY, parallel 2);
+COPY x to stdout (parallel 2);
+COPY x from stdin (parallel -1);
+COPY x from stdin (format ARROW, delimiter ',');
+COPY x to stdout (format ARROW, header);
+COPY x from stdin (format ARROW, on_error ignore);
+COPY x from stdin (format ARROW, parallel 2);
 
 -- too many columns in column list: should fail
 COPY x (a, b, c, d, e, d, c) from stdin;
@@ -682,3 +690,36 @@ truncate copy_default;
 
 -- DEFAULT cannot be used in COPY TO
 copy (select 1 as test) TO stdout with (default '\D');
+
+-- parallel COPY FROM; how many workers are used doesn't change the result
+create table copy_parallel (a int primary key, b text, c int default 42);
+copy copy_parallel (a, b) from stdin with (parallel 2);
+1	one
+2	two\
+and a half
+3	\N
+\.
+copy copy_parallel from stdin with (format csv, header, parallel 2);
+a,b,c
+4,"four
+lines",4
+5,five,5
+\.
+select * from copy_parallel order by a;
+-- a duplicate key in another chunk than the first row, which goes to another
+-- worker; which worker reports it varies, so hide the context
+\getenv abs_builddir PG_ABS_BUILDDIR
+\set filename :abs_builddir '/results/copy_parallel.data'
+truncate copy_parallel;
+copy (select case g when 1000 then 1 else g end, repeat('x', 100)
+      from generate_series(1, 2000) g) to :'filename';
+\set SHOW_CONTEXT never
+copy copy_parallel (a, b) from :'filename' with (parallel 2);
+-- errors in later chunks report the line number in the whole input
+copy (select case g when 1500 then 'x' else g::text end, repeat('x', 100)
+      from generate_series(1, 2000) g) to :'filename';
+copy copy_parallel (a, b) from :'filename'
+  with (parallel 2, on_error ignore, log_verbosity verbose);
+\set SHOW_CONTEXT errors
+select count(*), min(a), max(a), sum(c) from copy_parallel;
+drop table copy_parallel;
@@ -322,6 +322,26 @@ reset enable_material;
 
 reset enable_hashagg;
 
+-- test parallel hash aggregation
+set enable_parallel_hashagg = on;
+
+explain (costs off)
+   select hundred, count(*), sum(unique1) from tenk1 group by hundred;
+
+select count(*), sum(cnt), sum(total) from
+  (select hundred, count(*) as cnt, sum(unique1) as total
+   from tenk1 group by hundred) ss;
+
+-- make the participants spill while aggregating the shared partitions
+set work_mem = '64kB';
+
+select count(*), sum(cnt), sum(total) from
+  (select unique1 % 5000 as k, count(*) as cnt, sum(unique1) as total
+   from tenk1 group by k) ss;
+
+reset work_mem;
+reset enable_parallel_hashagg;
+
 -- check parallelized int8 aggregate (bug #14897)
 explain (costs off)
 select avg(unique1::int8) from tenk1;
@@ -195,6 +195,14 @@ ALTER SUBSCRIPTION regress_testsub SET (slot_name = NONE);
 
 \dRs+
 
+-- fail - parallel_apply must be boolean
+ALTER SUBSCRIPTION regress_testsub SET (parallel_apply = foo);
+
+ALTER SUBSCRIPTION regress_testsub SET (parallel_apply = true);
+SELECT subparallelapply FROM pg_subscription WHERE subname = 'regress_testsub';
+ALTER SUBSCRIPTION regress_testsub SET (parallel_apply = false);
+SELECT subparallelapply FROM pg_subscription WHERE subname = 'regress_testsub';
+
 -- fail - publication already exists
 ALTER SUBSCRIPTION regress_testsub ADD PUBLICATION testpub WITH (refresh = false);
 
@@ -60,6 +60,9 @@ select count(*) >= 0 as ok from pg_prepared_xacts;
 -- There will surely be at least one SLRU cache
 select count(*) > 0 as ok from pg_stat_slru;
 
+-- The shared catalog cache is disabled by default, but the view must work
+select count(*) >= 0 as ok from pg_stat_shared_catcache;
+
 -- There must be only one record
 select count(*) = 1 as ok from pg_stat_wal;
 
@@ -39,6 +39,26 @@ VACUUM (PARALLEL 4, INDEX_CLEANUP ON) parallel_vacuum_table;
 -- assertion failure with bug #17245 (in the absence of bugfix):
 INSERT INTO parallel_vacuum_table SELECT i FROM generate_series(1, 10000) i;
 
+-- Parallel scan of the heap, which any table qualifies for with
+-- min_parallel_table_scan_size set to 0.  With the smallest
+-- maintenance_work_mem, dead_items fills up after every chunk of blocks, so
+-- the participants have to stop for several rounds of index vacuuming
+-- before the scan of the heap is done:
+SET min_parallel_table_scan_size TO 0;
+SET maintenance_work_mem TO '64kB';
+CREATE TABLE parallel_vacuum_heap (a int) WITH (autovacuum_enabled = off);
+INSERT INTO parallel_vacuum_heap SELECT i FROM generate_series(1, 50000) i;
+CREATE INDEX parallel_vacuum_heap_idx ON parallel_vacuum_heap(a);
+DELETE FROM parallel_vacuum_heap WHERE a % 3 = 0;
+VACUUM (PARALLEL 2) parallel_vacuum_heap;
+SELECT count(*) FROM parallel_vacuum_heap;
+SET enable_seqscan TO off;
+SELECT count(*) FROM parallel_vacuum_heap WHERE a > 0;
+RESET enable_seqscan;
+RESET maintenance_work_mem;
+RESET min_parallel_table_scan_size;
+DROP TABLE parallel_vacuum_heap;
+
 RESET max_parallel_maintenance_workers;
 RESET min_parallel_index_scan_size;
 
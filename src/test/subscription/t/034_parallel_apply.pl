@@ -0,0 +1,113 @@
+
+# Copyright (c) 2024, PostgreSQL Global Development Group
+
+# Test applying committed transactions with parallel apply workers
+use strict;
+use warnings FATAL => 'all';
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+# Create publisher node
+my $node_publisher = PostgreSQL::Test::Cluster->new('publisher');
+$node_publisher->init(allows_streaming => 'logical');
+$node_publisher->start;
+
+# Create subscriber node
+my $node_subscriber = PostgreSQL::Test::Cluster->new('subscriber');
+$node_subscriber->init;
+$node_subscriber->append_conf('postgresql.conf',
+	"max_parallel_apply_workers_per_subscription = 4");
+$node_subscriber->start;
+
+# A table with a primary key, one with REPLICA IDENTITY FULL and one without
+# replica identity, which only gets inserts.
+my $ddl = q{
+	CREATE TABLE test_pk (a int PRIMARY KEY, b text);
+	CREATE TABLE test_full (a int, b text);
+	ALTER TABLE test_full REPLICA IDENTITY FULL;
+	CREATE TABLE test_nokey (a int, b text);
+};
+$node_publisher->safe_psql('postgres', $ddl);
+$node_subscriber->safe_psql('postgres', $ddl);
+
+my $publisher_connstr = $node_publisher->connstr . ' dbname=postgres';
+my $appname = 'tap_sub';
+
+$node_publisher->safe_psql('postgres',
+	"CREATE PUBLICATION tap_pub FOR TABLE test_pk, test_full, test_nokey");
+$node_subscriber->safe_psql('postgres',
+	"CREATE SUBSCRIPTION tap_sub CONNECTION '$publisher_connstr application_name=$appname' PUBLICATION tap_pub WITH (parallel_apply = true)"
+);
+
+$node_subscriber->wait_for_subscription_sync($node_publisher, $appname);
+
+# Queue up transactions while the subscription is disabled, so that they are
+# received together and can be applied in parallel.
+$node_subscriber->safe_psql('postgres', "ALTER SUBSCRIPTION tap_sub DISABLE");
+$node_subscriber->poll_query_until('postgres',
+	"SELECT count(*) = 0 FROM pg_stat_subscription WHERE subname = 'tap_sub' AND pid IS NOT NULL"
+) or die "Timed out while waiting for apply worker to stop";
+
+# Independent transactions, and transactions that change the rows inserted by
+# earlier ones.
+foreach my $i (1 .. 50)
+{
+	$node_publisher->safe_psql(
+		'postgres', qq{
+	BEGIN;
+	INSERT INTO test_pk SELECT g, md5(g::text) FROM generate_series($i * 100, $i * 100 + 99) g;
+	INSERT INTO test_full VALUES ($i, 'x');
+	INSERT INTO test_nokey VALUES ($i, 'x');
+	COMMIT;
+	UPDATE test_pk SET b = 'updated' WHERE a % 100 = $i % 7;
+	UPDATE test_full SET b = 'updated' WHERE a = $i;
+	DELETE FROM test_pk WHERE a = $i * 100 + 1;
+	UPDATE test_pk SET a = -a WHERE a = $i * 100 + 2;
+	});
+}
+
+$node_subscriber->safe_psql('postgres', "ALTER SUBSCRIPTION tap_sub ENABLE");
+$node_publisher->wait_for_catchup($appname);
+
+my $query = q{
+	SELECT (SELECT count(*) || '|' || md5(string_agg(a || b, ',' ORDER BY a)) FROM test_pk),
+		   (SELECT count(*) || '|' || md5(string_agg(a || b, ',' ORDER BY a)) FROM test_full),
+		   (SELECT count(*) FROM test_nokey)
+};
+
+is( $node_subscriber->safe_psql('postgres', $query),
+	$node_publisher->safe_psql('postgres', $query),
+	'dependent transactions are applied in parallel');
+
+ok( $node_subscriber->poll_query_until(
+		'postgres',
+		"SELECT count(*) > 0 FROM pg_stat_subscription WHERE subname = 'tap_sub' AND worker_type = 'parallel apply'"
+	),
+	'parallel apply workers were used');
+
+# TRUNCATE must wait for all the earlier transactions.
+$node_subscriber->safe_psql('postgres', "ALTER SUBSCRIPTION tap_sub DISABLE");
+$node_subscriber->poll_query_until('postgres',
+	"SELECT count(*) = 0 FROM pg_stat_subscription WHERE subname = 'tap_sub' AND pid IS NOT NULL"
+) or die "Timed out while waiting for apply worker to stop";
+
+$node_publisher->safe_psql(
+	'postgres', q{
+	UPDATE test_pk SET b = 'before truncate' WHERE a > 0;
+	TRUNCATE test_pk;
+	INSERT INTO test_pk VALUES (1, 'after truncate');
+	UPDATE test_full SET b = 'again';
+});
+
+$node_subscriber->safe_psql('postgres', "ALTER SUBSCRIPTION tap_sub ENABLE");
+$node_publisher->wait_for_catchup($appname);
+
+is( $node_subscriber->safe_psql('postgres', $query),
+	$node_publisher->safe_psql('postgres', $query),
+	'TRUNCATE is applied in order');
+
+$node_subscriber->stop;
+$node_publisher->stop;
+
+done_testing();